@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <gflags/gflags.h>
+#include <samples/default_flags.hpp>
 #include <iostream>
 
 static const char help_message[] = "Print a usage message.";
@@ -35,6 +36,9 @@ static const char no_show_message[] = "Optional. Disable showing of processed im
 static const char execution_time_message[] = "Optional. Time in seconds to execute program. "
                                              "Default is -1 (infinite time).";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
+static const char preprocess_threads_message[] = "Optional. Number of threads decoding and preprocessing images "
+                                                 "in parallel with inference. Default value is 4. "
+                                                 "0 preprocesses images in the main thread.";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(i, "", image_message);
@@ -53,6 +57,8 @@ DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_bool(no_show, false, no_show_message);
 DEFINE_int32(time, -1, execution_time_message);
 DEFINE_string(u, "", utilization_monitors_message);
+DEFINE_uint32(preprocess_threads, 4, preprocess_threads_message);
+DEFINE_PP_DEVICE_FLAG
 
 static void showUsage() {
     std::cout << std::endl;
@@ -77,4 +83,6 @@ static void showUsage() {
     std::cout << "    -no_show                  " << no_show_message << std::endl;
     std::cout << "    -time \"<integer>\"         " << execution_time_message << std::endl;
     std::cout << "    -u                        " << utilization_monitors_message << std::endl;
+    std::cout << "    -preprocess_threads \"<integer>\" " << preprocess_threads_message << std::endl;
+    std::cout << "    -pp_device                " << pp_device_message << std::endl;
 }
@@ -0,0 +1,29 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with the linear assignment problem solver shared by tracking demos
+ * @file assignment.hpp
+ */
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief Solves the linear assignment problem for a rectangular cost matrix with the shortest augmenting path
+ * algorithm of Jonker and Volgenant. It takes O(n * n * m) time for n = min(rows, cols) and m = max(rows, cols),
+ * the matrix is neither padded to a square nor rescanned for minimums.
+ * Without gating, min(rows, cols) pairs with the least total cost are assigned.
+ * With gating, the pairs costing more than maxCost are never assigned and an unassigned row costs maxCost, so fewer
+ * pairs may be assigned. That is, the total cost of the assigned pairs plus maxCost for every unassigned row is
+ * minimal.
+ * @param costMatrix CV_32F matrix of finite costs, costMatrix(row, col) is the cost of assigning col to row
+ * @param maxCost the greatest cost of an assigned pair, infinity disables gating
+ * @return the column assigned to each row, -1 for the unassigned rows
+ */
+std::vector<int> solveAssignment(const cv::Mat& costMatrix, float maxCost = std::numeric_limits<float>::infinity());
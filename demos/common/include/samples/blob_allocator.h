@@ -0,0 +1,35 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <inference_engine.hpp>
+
+// Allocator of input and output blobs set to infer requests by the demos. Buffers of 2 MB and more are backed by
+// reserved huge pages (hugetlbfs) on Linux when the system has free ones, and by buffers of FrameAllocator otherwise,
+// which are aligned to 2 MB and advised to be backed by transparent huge pages. Large tensors which the demos copy
+// frames into or read results from are walked with fewer TLB misses then.
+// Methods are not marked override, since IE versions differ in whether IAllocator requires Release
+class BlobAllocator : public InferenceEngine::IAllocator {
+public:
+    void* lock(void* handle, InferenceEngine::LockOp = InferenceEngine::LOCK_FOR_WRITE) noexcept;
+    void unlock(void*) noexcept {}
+    void* alloc(size_t size) noexcept;
+    bool free(void* handle) noexcept;
+    // Lifetime is controlled by shared pointer returned by getBlobAllocator
+    void Release() noexcept {}
+};
+
+std::shared_ptr<InferenceEngine::IAllocator> getBlobAllocator();
+
+// Replaces input and output blobs of 2 MB and more of the request with blobs of the same description allocated by
+// getBlobAllocator(). Should be called right after the request is created. Only the requests of the CPU device get
+// them, the other plugins may keep tensors in the device memory or in the buffers shared with the device.
+// A blob the plugin doesn't accept is kept as is. Set the OMZ_HUGE_PAGES environment variable to 0 to keep all
+// the blobs allocated by the plugin.
+void setHugePageBlobs(const InferenceEngine::ExecutableNetwork& execNetwork, InferenceEngine::InferRequest& request,
+                      const std::string& deviceName);
@@ -13,3 +13,46 @@ DEFINE_bool(loop, false, loop_message);
 static const char input_message[] = "Required. An input to process. The input must be a single image, a folder of "
     "images or anything that cv::VideoCapture can process.";
 static const char loop_message[] = "Optional. Enable reading the input in a loop.";
+
+#define DEFINE_BENCHMARK_FLAGS \
+DEFINE_uint32(limit, 0, limit_message); \
+DEFINE_string(report_perf, "", report_perf_message);
+
+static const char limit_message[] = "Optional. Number of frames to read from the input. With -loop a fixed number "
+    "of frames is processed, e.g. for benchmarking. Zero (default) means no limit.";
+static const char report_perf_message[] = "Optional. Print total performance metrics in a machine readable format "
+    "at the end. Only \"json\" is supported.";
+
+#define DEFINE_DUMP_FLAG \
+DEFINE_string(dump, "", dump_message);
+
+static const char dump_message[] = "Optional. Write inference results to the file as JSON lines, or as binary records "
+    "if the file has .bin extension. Results are written on a background thread, which is much faster than -r.";
+
+#define DEFINE_VIDEO_ENCODE_FLAG \
+DEFINE_string(encode, "sw", encode_message);
+
+static const char encode_message[] = "Optional. Encoding of the output video: sw (default), hw (any available "
+    "hardware acceleration), vaapi or onevpl. Frames are encoded on a separate thread and dropped if the encoder "
+    "can't keep up.";
+
+#define DEFINE_PP_DEVICE_FLAG \
+DEFINE_string(pp_device, "CPU", pp_device_message);
+
+static const char pp_device_message[] = "Optional. Device resizing images and splitting them into the network input: "
+    "CPU (default) or GPU. GPU runs it with OpenCL through OpenCV T-API, which frees the CPU when the integrated GPU "
+    "is idle, e.g. when inference runs on a VPU. Falls back to CPU if OpenCV has no OpenCL device.";
+
+#define DEFINE_MAP_WEIGHTS_FLAG \
+DEFINE_bool(map_weights, false, map_weights_message);
+
+static const char map_weights_message[] = "Optional. Map the .bin file of the model to memory instead of reading it. "
+    "Processes running the same model share one copy of its weights through the page cache.";
+
+#define DEFINE_MOTION_GATE_FLAG \
+DEFINE_double(motion_gate, 0, motion_gate_message);
+
+static const char motion_gate_message[] = "Optional. Skip inference of the frames of a static camera which don't "
+    "differ from the last inferred frame: a frame is inferred if the mean absolute difference of gray levels "
+    "(0-255) in any of its 32x18 blocks exceeds the threshold. A frame is inferred at least once a second anyway. "
+    "Zero (default) disables the gate.";
@@ -0,0 +1,33 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+
+#include <opencv2/core/mat.hpp>
+
+// Allocator of decoded frames. Buffers are continuous and aligned to 64 bytes, so wrapMat2Blob wraps them without
+// copying and the plugins read whole cache lines of them. Buffers of 2 MB and more are aligned to 2 MB and, on Linux,
+// backed by transparent huge pages, which saves TLB misses when a frame is resized or converted.
+// Set it to cv::Mat::allocator of an empty frame, the frame keeps it when it's released and created again
+class FrameAllocator : public cv::MatAllocator {
+public:
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 2)
+    using AccessFlag = cv::AccessFlag;
+#else
+    using AccessFlag = int;
+#endif
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, AccessFlag flags,
+                           cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* u, AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* u) const override;
+};
+
+cv::MatAllocator* getFrameAllocator();
+
+// Allocates a buffer aligned like the frames of FrameAllocator, throws std::bad_alloc on failure
+void* alignedAlloc(size_t size);
+void alignedFree(void* ptr);
@@ -0,0 +1,122 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file for frame timeline tracing across threads
+ * @file frame_tracer.hpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Records begin, end and flow events of frames into per-thread rings and writes them in Chrome trace event
+ * format, which can be opened by chrome://tracing or Perfetto UI. Flow events of the same frame and source are
+ * connected with arrows, so a frame can be followed through decoding, inference and rendering threads.
+ *
+ * Recording doesn't lock: every thread writes to its own ring, which is registered once under a mutex. A full ring
+ * overwrites its oldest events. The tracing is enabled if OMZ_FRAME_TRACE_FILE environment variable is set;
+ * OMZ_FRAME_TRACE_EVENTS sets the ring size (65536 events by default). The file is written at exit, so threads
+ * which record events must be joined by then.
+ *
+ * Use FRAME_TRACE_* macros, they are compiled out unless OMZ_FRAME_TRACE is defined (ENABLE_FRAME_TRACE CMake option).
+ */
+class FrameTracer {
+public:
+    enum class EventType : uint8_t {Begin, End, Flow};
+
+    static FrameTracer& instance();
+
+    bool isEnabled() const {return enabled;}
+
+    /**
+     * @param name must be a string literal or otherwise outlive the tracer
+     * @param frameId frame number for the given source, negative if the event doesn't belong to a single frame
+     * @param sourceId index of the input the frame came from, negative if unknown
+     */
+    void record(const char* name, EventType type, int64_t frameId, int64_t sourceId);
+
+    /// Names the track of the current thread
+    void setThreadName(const std::string& name);
+
+    void writeChromeTrace(std::ostream& out) const;
+
+    ~FrameTracer();
+    FrameTracer(const FrameTracer&) = delete;
+    FrameTracer& operator=(const FrameTracer&) = delete;
+
+    class ScopedEvent {
+    public:
+        ScopedEvent(const char* name, int64_t frameId, int64_t sourceId) :
+            name{name}, frameId{frameId}, sourceId{sourceId} {
+                instance().record(name, EventType::Begin, frameId, sourceId);
+            }
+        ~ScopedEvent() {
+            instance().record(name, EventType::End, frameId, sourceId);
+        }
+        ScopedEvent(const ScopedEvent&) = delete;
+        ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+    private:
+        const char* name;
+        const int64_t frameId;
+        const int64_t sourceId;
+    };
+
+private:
+    struct Event {
+        const char* name;
+        EventType type;
+        int64_t frameId;
+        int64_t sourceId;
+        int64_t timestamp; // in nanoseconds since the tracer creation
+    };
+
+    struct ThreadRing {
+        explicit ThreadRing(size_t size, int threadId) : events(size), recorded{0}, threadId{threadId} {}
+
+        std::vector<Event> events;
+        std::atomic<uint64_t> recorded; // only the owning thread writes it
+        const int threadId;
+        std::string threadName; // guarded by FrameTracer::mtx
+    };
+
+    FrameTracer();
+    ThreadRing& getThreadRing();
+
+    bool enabled;
+    std::string outputPath;
+    size_t ringSize;
+    int64_t creationTime;
+
+    mutable std::mutex mtx;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+};
+
+#ifdef OMZ_FRAME_TRACE
+#define FRAME_TRACE_CONCAT_IMPL(a, b) a##b
+#define FRAME_TRACE_CONCAT(a, b) FRAME_TRACE_CONCAT_IMPL(a, b)
+#define FRAME_TRACE_BEGIN(name, frameId, sourceId) \
+    FrameTracer::instance().record(name, FrameTracer::EventType::Begin, frameId, sourceId)
+#define FRAME_TRACE_END(name, frameId, sourceId) \
+    FrameTracer::instance().record(name, FrameTracer::EventType::End, frameId, sourceId)
+#define FRAME_TRACE_FLOW(frameId, sourceId) \
+    FrameTracer::instance().record("frame", FrameTracer::EventType::Flow, frameId, sourceId)
+#define FRAME_TRACE_SCOPE(name, frameId, sourceId) \
+    FrameTracer::ScopedEvent FRAME_TRACE_CONCAT(frameTraceScope, __LINE__)(name, frameId, sourceId)
+#define FRAME_TRACE_THREAD_NAME(name) FrameTracer::instance().setThreadName(name)
+#else
+#define FRAME_TRACE_BEGIN(name, frameId, sourceId) do {} while (false)
+#define FRAME_TRACE_END(name, frameId, sourceId) do {} while (false)
+#define FRAME_TRACE_FLOW(frameId, sourceId) do {} while (false)
+#define FRAME_TRACE_SCOPE(name, frameId, sourceId) do {} while (false)
+#define FRAME_TRACE_THREAD_NAME(name) do {} while (false)
+#endif
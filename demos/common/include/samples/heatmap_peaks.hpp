@@ -0,0 +1,33 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with peak search on heatmaps shared by pose estimation demos
+ * @file heatmap_peaks.hpp
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief Finds the pixels of the heatmap which are not less than threshold and greater than all their 4-connected
+ * neighbours inside the heatmap. A row is compared with the rows above and below and with itself shifted by a pixel
+ * using the SIMD instructions of the platform (OpenCV universal intrinsics: SSE, AVX2, NEON).
+ * @param heatMap CV_32FC1 heatmap
+ * @param threshold minimal value of a peak, must be greater than 0
+ * @param peaks the peaks are appended to it in row-major order
+ */
+void findHeatMapPeaks(const cv::Mat& heatMap, float threshold, std::vector<cv::Point>& peaks);
+
+/**
+ * @brief Keeps the points which are not closer than minDistance to any kept point before them. The kept points are
+ * bucketed into a grid with minDistance cells, so a point is compared with the kept points of 3x3 cells around it only.
+ * @param points points in the order of their priority
+ * @param minDistance minimal distance between kept points
+ * @return the flags of kept points
+ */
+std::vector<bool> suppressClosePoints(const std::vector<cv::Point2f>& points, float minDistance);
@@ -2,12 +2,27 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <opencv2/core/mat.hpp>
 #include <opencv2/videoio.hpp>
 
+enum class VideoDecodeMode {
+    Software,  // Default cv::VideoCapture backends, BGR frames
+    Hardware,  // Hardware accelerated (VA-API, oneVPL, D3D11) decoding if available, BGR frames
+    HardwareNV12  // Hardware accelerated decoding with GStreamer, NV12 frames (see wrapMatNV12ToBlob)
+};
+
 class ImagesCapture {
 public:
     const bool loop;
@@ -15,6 +30,14 @@ public:
     ImagesCapture(bool loop) : loop{loop} {}
     virtual double fps() const = 0;
     virtual cv::Mat read() = 0;
+    // Reads next image into img reusing its buffer if possible. Returns false if there are no more images
+    virtual bool readInto(cv::Mat &img) {
+        img = read();
+        return img.data != nullptr;
+    }
+    // Time the last frame returned by read() was captured if the capture knows it, e.g. when it was received from
+    // a live stream before read() was called. Default time point means it's unknown, read() time is used then
+    virtual std::chrono::steady_clock::time_point getLastFrameTime() const {return {};}
     virtual ~ImagesCapture() = default;
 };
 
@@ -26,7 +49,77 @@ public:
 // } catch (const std::out_of_range&) {
 //     return cv::VideoCapture(input);
 // }
+// Images from directories and video files are decoded ahead by a background thread into a ring of prefetchSize
+// frames (0 disables prefetching). Cameras are always read synchronously to get the most recent frame.
+// Live network streams (rtsp://, rtmp://, udp://, tcp://, srt://) are grabbed by a background thread all the time,
+// read() returns the most recent frame, so a slow consumer skips frames instead of lagging behind the stream.
+// They are reopened if they fail, loop and initialImageId don't apply to them.
+// If decodedCacheSize is not 0, up to decodedCacheSize bytes of decoded images from an image file or a directory
+// are kept in memory, so they aren't decoded again when looping. Cached images are returned without copying, so
+// returned frames must not be modified in place then (clone them before drawing).
+// decodeMode selects decoding of video files and streams. In HardwareNV12 mode frames are single channel
+// images of 3/2 of the frame height: rows of Y plane followed by rows of interleaved UV plane. Frames can be
+// passed to the network as is with wrapMatNV12ToBlob, skipping the conversion to BGR.
+// If decodeSizeHint isn't empty, images from an image file or a directory are decoded reduced by 2, 4 or 8 times
+// as long as they stay at least as large as the hint, e.g. the network input size. JPEG images are scaled while
+// decoding then, which is several times faster than decoding at full resolution and resizing afterwards.
+// Input synthetic:WxH[@fps] (e.g. synthetic:1920x1080@30) hands out frames of a small ring generated once, without
+// decoding or copying, so a pipeline is measured without the cost of reading its input. The frames are shared,
+// they must not be modified in place. It's endless regardless of loop, readLengthLimit still applies.
 std::unique_ptr<ImagesCapture> openImagesCapture(const std::string &input,
     bool loop, size_t initialImageId=0,  // Non camera options
     size_t readLengthLimit=std::numeric_limits<size_t>::max(),  // General option
-    cv::Size cameraResolution={1280, 720});
+    cv::Size cameraResolution={1280, 720},
+    size_t prefetchSize=4,
+    size_t decodedCacheSize=0,
+    VideoDecodeMode decodeMode=VideoDecodeMode::Software,
+    cv::Size decodeSizeHint={});
+
+// Parses synthetic:WxH[@fps] input. Returns false if the input isn't synthetic, throws if its size is malformed.
+// fps is 30 unless it's given
+bool parseSyntheticInput(const std::string &input, cv::Size &size, double &fps);
+
+// Generates count frames of random BGR noise of the given size for synthetic inputs. The noise doesn't compress or
+// repeat, so the frames aren't cheaper to process than real ones. Buffers come from getFrameAllocator(),
+// so they are wrapped into blobs without copying
+std::vector<cv::Mat> makeSyntheticFrames(cv::Size size, size_t count);
+
+// Reads several inputs, each of them on its own thread, so one AsyncPipeline serves all of them. Frames are returned
+// in turns of the inputs which have a frame decoded, so a slow or stalled input doesn't hold up the others.
+// Every input has one decoded frame ready at most, frames of files aren't skipped. read() returns an empty frame
+// when all inputs are over
+class MultiSourceCapture : public ImagesCapture {
+public:
+    explicit MultiSourceCapture(std::vector<std::unique_ptr<ImagesCapture>> &&captures);
+    ~MultiSourceCapture() override;
+
+    double fps() const override;
+    cv::Mat read() override;
+    std::chrono::steady_clock::time_point getLastFrameTime() const override {return lastFrameTime;}
+    // Returns the next frame and the index of its input in sourceId
+    cv::Mat readFrom(size_t &sourceId);
+    size_t getSourcesCount() const {return sources.size();}
+
+private:
+    struct Source {
+        std::unique_ptr<ImagesCapture> capture;
+        cv::Mat frame;
+        std::chrono::steady_clock::time_point frameTime;
+        bool isFinished = false;
+        std::thread thread;
+    };
+
+    void readLoop(Source &source);
+
+    std::vector<Source> sources;
+    size_t nextSourceId = 0;
+    std::chrono::steady_clock::time_point lastFrameTime;
+    bool isStopping = false;
+    std::exception_ptr readException;
+    std::mutex mtx;
+    std::condition_variable condVar;
+};
+
+// Opens every input of a comma separated list with openImagesCapture and reads them with MultiSourceCapture
+std::unique_ptr<MultiSourceCapture> openMultiSourceCapture(const std::string &inputs, bool loop,
+    size_t readLengthLimit=std::numeric_limits<size_t>::max());
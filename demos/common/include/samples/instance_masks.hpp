@@ -0,0 +1,61 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with rendering of instance segmentation masks
+ * @file instance_masks.hpp
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief An instance to render: its box in the image and its mask predicted by the network for the box
+ */
+struct InstanceMask {
+    /// Box of the instance, it should be inside the image
+    cv::Rect box;
+    /// CV_32FC1 mask probabilities of the box at network resolution (e.g. 28x28), it's stretched to the box
+    cv::Mat mask;
+    cv::Vec3b color;
+};
+
+/**
+ * @brief Blends the color of every instance with the image pixels covered by its mask. Resizing of the mask to the box
+ * (bilinear, as cv::resize with INTER_LINEAR), thresholding and blending are done in one pass over the box, so neither
+ * resized masks nor colored layers are allocated. Image rows are processed in parallel, every row applying the masks
+ * in order of instances, so overlapping instances are blended in the same order as if they were pasted one by one.
+ * @param image CV_8UC3 image to draw on
+ * @param instances instances to draw, the later ones are drawn on top of the earlier ones
+ * @param maskThreshold pixels with mask probability greater than the threshold belong to the instance
+ * @param alpha weight of the instance color, the image pixel gets 1 - alpha
+ */
+void blendInstanceMasks(cv::Mat& image, const std::vector<InstanceMask>& instances, float maskThreshold, float alpha);
+
+/**
+ * @brief Stretches the mask predicted by the network for the box to the box size (as blendInstanceMasks does),
+ * thresholds it and encodes it in run-length encoding: lengths of alternating runs of background and instance pixels
+ * of the box in row-major order, starting with background (so the first run may be 0). The runs sum up to box area.
+ * @param mask CV_32FC1 mask probabilities of the box at network resolution
+ * @param boxSize size of the box in the image
+ * @param maskThreshold pixels with mask probability greater than the threshold belong to the instance
+ * @param runs the runs are written to it reusing its buffer
+ */
+void encodeInstanceMask(const cv::Mat& mask, cv::Size boxSize, float maskThreshold, std::vector<uint32_t>& runs);
+
+/**
+ * @brief Blends the color with the image pixels of the run-length encoded mask (see encodeInstanceMask).
+ * Background runs are skipped without touching their pixels.
+ * @param image CV_8UC3 image to draw on
+ * @param box box of the mask, it should be inside the image
+ * @param runs run-length encoded mask of the box
+ * @param color color of the instance
+ * @param alpha weight of the instance color, the image pixel gets 1 - alpha
+ */
+void blendEncodedInstanceMask(cv::Mat& image, const cv::Rect& box, const std::vector<uint32_t>& runs,
+                              const cv::Vec3b& color, float alpha);
@@ -0,0 +1,59 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file for lock-free latency histogram
+ * @file latency_histogram.hpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Histogram of durations with log-linear buckets (HDR-style): every power of two range of microseconds
+ * is split into SUB_BUCKETS_COUNT equal buckets, so relative error of percentiles is below 1/SUB_BUCKETS_COUNT
+ * for any duration. Recording is lock-free and can be done from several threads at once.
+ */
+class LatencyHistogram {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(Duration duration);
+    void reset();
+
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns estimation of the given percentile
+     * @param percentile percentile in range [0, 100]
+     * @return duration in milliseconds, NaN if there's no recorded values
+     */
+    double getPercentile(double percentile) const;
+    /// @return mean duration in milliseconds, NaN if there's no recorded values
+    double getMean() const;
+    /// @return maximum duration in milliseconds, NaN if there's no recorded values
+    double getMax() const;
+
+private:
+    static const int SUB_BUCKETS_BITS = 4;
+    static const int SUB_BUCKETS_COUNT = 1 << SUB_BUCKETS_BITS;
+    // Durations up to 2^40 us (~12 days) are distinguished, longer ones get to the last bucket
+    static const int MAX_VALUE_BITS = 40;
+    static const int BUCKETS_COUNT = (MAX_VALUE_BITS - SUB_BUCKETS_BITS + 1) * SUB_BUCKETS_COUNT;
+
+    static int getBucketIndex(uint64_t valueUs);
+    static uint64_t getBucketLowerBound(int index);
+
+    std::atomic<uint64_t> buckets[BUCKETS_COUNT];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sumUs;
+    std::atomic<uint64_t> maxUs;
+};
@@ -0,0 +1,78 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with a helper reading and loading several networks concurrently
+ * @file model_loader.hpp
+ */
+
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ModelLoader
+ * @brief Runs every added task, e.g. Core::ReadNetwork() and Core::LoadNetwork() of one network, on its own thread,
+ *        so the startup of a demo with several networks takes about as long as the slowest of them.
+ *        InferenceEngine::Core can read and load networks from several threads, but it has to be configured
+ *        (SetConfig(), AddExtension()) before the tasks are added.
+ */
+class ModelLoader {
+public:
+    ModelLoader() = default;
+    ModelLoader(const ModelLoader&) = delete;
+    ModelLoader& operator=(const ModelLoader&) = delete;
+
+    /**
+     * @brief Waits for the tasks, as they may reference the objects of the caller. Their exceptions are ignored
+     */
+    ~ModelLoader() {
+        for (const auto& wait : waits) {
+            try {
+                wait();
+            } catch (...) {}
+        }
+    }
+
+    /**
+     * @brief Starts the task on a new thread
+     * @param task - callable object without arguments
+     * @return future of the result of the task
+     */
+    template <typename F>
+    std::shared_future<typename std::result_of<F()>::type> add(F&& task) {
+        auto future = std::async(std::launch::async, std::forward<F>(task)).share();
+        waits.emplace_back([future]() { future.get(); });
+        return future;
+    }
+
+    /**
+     * @brief Waits for all the tasks. If some of them failed, the exception of the first added one is rethrown
+     *        after the others are finished
+     */
+    void wait() {
+        std::exception_ptr exception;
+        for (const auto& wait : waits) {
+            try {
+                wait();
+            } catch (...) {
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+            }
+        }
+        waits.clear();
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+private:
+    std::vector<std::function<void()>> waits;
+};
@@ -0,0 +1,63 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <opencv2/core/mat.hpp>
+
+#include "samples/images_capture.h"
+
+// Detects changes of the frames of a static camera. A frame is compared with the last frame that passed the gate,
+// so slow changes accumulate until they pass it too. Frames are downscaled and converted to gray first, then the
+// absolute difference is averaged in every block of a grid. A block is changed if its mean difference is greater
+// than threshold (in gray levels, 0-255).
+class MotionGate {
+public:
+    MotionGate(double threshold, cv::Size gridSize = {32, 18}, int downscaledWidth = 320);
+
+    // Returns true if the frame has changed blocks, and makes it the reference for the next frames then.
+    // The first frame always passes.
+    bool update(const cv::Mat& frame);
+
+    // Bounding rectangle of the changed blocks of the last passed frame in its coordinates, the whole frame for the
+    // first one
+    cv::Rect getChangedRegion() const { return changedRegion; }
+
+private:
+    const double threshold;
+    const cv::Size gridSize;
+    const int downscaledWidth;
+    cv::Mat reference;
+    cv::Mat downscaled;
+    cv::Mat gray;
+    cv::Mat diff;
+    cv::Mat blocks;
+    cv::Rect changedRegion;
+};
+
+// Returns only the frames of the wrapped capture that pass MotionGate, so the inference of the frames without
+// changes is skipped. A frame is returned at least once a second of the input anyway (every 30 frames if its
+// frame rate is unknown), so the results and the window are updated even if nothing moves.
+class MotionGatedCapture : public ImagesCapture {
+public:
+    MotionGatedCapture(std::unique_ptr<ImagesCapture>&& capture, double threshold);
+
+    double fps() const override { return capture->fps(); }
+    cv::Mat read() override;
+    std::chrono::steady_clock::time_point getLastFrameTime() const override { return capture->getLastFrameTime(); }
+
+    size_t getSkippedCount() const { return skippedCount; }
+    // See MotionGate::getChangedRegion()
+    cv::Rect getChangedRegion() const { return gate.getChangedRegion(); }
+
+private:
+    std::unique_ptr<ImagesCapture> capture;
+    MotionGate gate;
+    const size_t maxSkipped;
+    size_t skippedInRow = 0;
+    size_t skippedCount = 0;
+};
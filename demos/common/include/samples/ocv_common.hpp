@@ -9,61 +9,250 @@
 
 #pragma once
 
+#include <atomic>
+#include <string>
+
 #include <opencv2/opencv.hpp>
+#include <opencv2/core/ocl.hpp>
 
 #include "samples/common.hpp"
+#include "samples/text_cache.hpp"
 
 /**
-* @brief Sets image data stored in cv::Mat object to a given Blob object.
+* @brief Resizes image to the size of the blob (if needed) and returns cv::Mat headers for every channel plane
+*        of batchIndex-th image inside of the blob. Resized image is kept in thread local buffer between calls,
+*        so it isn't allocated for every frame.
 * @param orig_image - given cv::Mat object with an image data.
-* @param blob - Blob object which to be filled by an image data.
+* @param resized_image - reference to be set to the resized image (or to orig_image if it has the blob's size).
+* @param blob_data - pointer to the mapped blob memory.
+* @param blobSize - dimensions of the blob in NCHW order.
+* @param depth - OpenCV depth of the blob elements.
 * @param batchIndex - batch index of an image inside of the blob.
+* @return channel planes pointing to the blob memory.
 */
-template <typename T>
-void matU8ToBlob(const cv::Mat& orig_image, InferenceEngine::Blob::Ptr& blob, int batchIndex = 0) {
-    InferenceEngine::SizeVector blobSize = blob->getTensorDesc().getDims();
+inline std::vector<cv::Mat> prepareBlobPlanes(const cv::Mat& orig_image, const cv::Mat*& resized_image, void* blob_data,
+                                              const InferenceEngine::SizeVector& blobSize, int depth, int batchIndex) {
     const size_t width = blobSize[3];
     const size_t height = blobSize[2];
     const size_t channels = blobSize[1];
     if (static_cast<size_t>(orig_image.channels()) != channels) {
         THROW_IE_EXCEPTION << "The number of channels for net input and image must match";
     }
-    InferenceEngine::LockedMemory<void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
-    T* blob_data = blobMapped.as<T*>();
+    if (orig_image.depth() != CV_8U) {
+        THROW_IE_EXCEPTION << "Only 8-bit images are supported";
+    }
 
-    cv::Mat resized_image(orig_image);
+    static thread_local cv::Mat resizeBuffer;
+    resized_image = &orig_image;
     if (static_cast<int>(width) != orig_image.size().width ||
             static_cast<int>(height) != orig_image.size().height) {
-        cv::resize(orig_image, resized_image, cv::Size(width, height));
+        cv::resize(orig_image, resizeBuffer, cv::Size(width, height));
+        resized_image = &resizeBuffer;
+    }
+
+    const size_t planeSize = width * height * CV_ELEM_SIZE1(depth);
+    uint8_t* batchData = static_cast<uint8_t*>(blob_data) + batchIndex * channels * planeSize;
+    std::vector<cv::Mat> planes;
+    planes.reserve(channels);
+    for (size_t c = 0; c < channels; c++) {
+        planes.emplace_back(static_cast<int>(height), static_cast<int>(width), CV_MAKETYPE(depth, 1), batchData + c * planeSize);
     }
+    return planes;
+}
 
-    int batchOffset = batchIndex * width * height * channels;
+inline std::atomic<bool>& preprocessingOnGpuFlag() {
+    static std::atomic<bool> isOnGpu{false};
+    return isOnGpu;
+}
 
-    if (channels == 1) {
-        for (size_t  h = 0; h < height; h++) {
-            for (size_t w = 0; w < width; w++) {
-                blob_data[batchOffset + h * width + w] = resized_image.at<uchar>(h, w);
-            }
+/**
+* @brief Selects the device resizing images and splitting them into channel planes in matU8ToBlob.
+*        "GPU" runs it with OpenCL through cv::UMat (OpenCV T-API), which frees the CPU when the integrated GPU
+*        is idle, e.g. when inference runs on a VPU. "CPU" (default) runs it with cv::Mat.
+* @param device - "CPU" or "GPU"
+* @return false if "GPU" is requested, but OpenCV has no OpenCL device, preprocessing stays on the CPU then
+*/
+inline bool setPreprocessingDevice(const std::string& device) {
+    if (device == "CPU") {
+        preprocessingOnGpuFlag() = false;
+        return true;
+    }
+    if (device != "GPU") {
+        THROW_IE_EXCEPTION << "Unknown preprocessing device: " << device;
+    }
+    cv::ocl::setUseOpenCL(true);
+    preprocessingOnGpuFlag() = cv::ocl::useOpenCL();
+    return preprocessingOnGpuFlag();
+}
+
+/**
+* @brief Resizes the image and splits it into the planes with OpenCL. The result planes are read from the device
+*        straight into the blob memory.
+*/
+inline void umatToBlobPlanes(const cv::Mat& orig_image, std::vector<cv::Mat>& planes) {
+    static thread_local cv::UMat resized;
+    static thread_local std::vector<cv::UMat> devicePlanes;
+    cv::UMat image = orig_image.getUMat(cv::ACCESS_READ);
+    const cv::Size size = planes.front().size();
+    const cv::UMat* src = &image;
+    if (image.size() != size) {
+        cv::resize(image, resized, size);
+        src = &resized;
+    }
+    cv::split(*src, devicePlanes);
+    for (size_t c = 0; c < planes.size(); c++) {
+        if (devicePlanes[c].type() == planes[c].type()) {
+            devicePlanes[c].copyTo(planes[c]);
+        } else {
+            devicePlanes[c].convertTo(planes[c], planes[c].type());
         }
-    } else if (channels == 3) {
+    }
+}
+
+/**
+* @brief Sets image data stored in cv::Mat object to a given Blob object.
+*        Interleaved image is split into channel planes directly in the blob memory with vectorized cv::split.
+*        Resize and split run with OpenCL if it's selected by setPreprocessingDevice().
+* @param orig_image - given cv::Mat object with an image data.
+* @param blob - Blob object which to be filled by an image data.
+* @param batchIndex - batch index of an image inside of the blob.
+*/
+template <typename T>
+void matU8ToBlob(const cv::Mat& orig_image, InferenceEngine::Blob::Ptr& blob, int batchIndex = 0) {
+    InferenceEngine::SizeVector blobSize = blob->getTensorDesc().getDims();
+    InferenceEngine::LockedMemory<void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
+    T* blob_data = blobMapped.as<T*>();
+
+    if (preprocessingOnGpuFlag()) {
+        const size_t channels = blobSize[1];
+        if (static_cast<size_t>(orig_image.channels()) != channels || orig_image.depth() != CV_8U) {
+            THROW_IE_EXCEPTION << "The image must be 8-bit with the number of channels of net input";
+        }
+        const size_t planeSize = blobSize[2] * blobSize[3] * sizeof(T);
+        uint8_t* batchData = reinterpret_cast<uint8_t*>(blob_data) + batchIndex * channels * planeSize;
+        std::vector<cv::Mat> planes;
         for (size_t c = 0; c < channels; c++) {
-            for (size_t  h = 0; h < height; h++) {
-                for (size_t w = 0; w < width; w++) {
-                    blob_data[batchOffset + c * width * height + h * width + w] =
-                            resized_image.at<cv::Vec3b>(h, w)[c];
-                }
-            }
+            planes.emplace_back(static_cast<int>(blobSize[2]), static_cast<int>(blobSize[3]),
+                                cv::DataType<T>::type, batchData + c * planeSize);
         }
+        umatToBlobPlanes(orig_image, planes);
+        return;
+    }
+
+    const cv::Mat* resized_image;
+    std::vector<cv::Mat> planes = prepareBlobPlanes(orig_image, resized_image, blob_data, blobSize,
+                                                    cv::DataType<T>::depth, batchIndex);
+    if (cv::DataType<T>::depth == CV_8U) {
+        cv::split(*resized_image, planes);
+    } else {
+        static thread_local std::vector<cv::Mat> u8Planes;
+        cv::split(*resized_image, u8Planes);
+        for (size_t c = 0; c < planes.size(); c++) {
+            u8Planes[c].convertTo(planes[c], planes[c].type());
+        }
+    }
+}
+
+/**
+* @brief Sets normalized image data stored in cv::Mat object to a given FP32 Blob object:
+*        every element of the blob is (pixel - mean[c]) * scale[c].
+* @param orig_image - given cv::Mat object with an image data.
+* @param blob - FP32 Blob object which to be filled by an image data.
+* @param mean - mean value of every channel.
+* @param scale - scale of every channel.
+* @param batchIndex - batch index of an image inside of the blob.
+*/
+inline void matU8ToBlobNormalized(const cv::Mat& orig_image, InferenceEngine::Blob::Ptr& blob,
+                                  const cv::Scalar& mean, const cv::Scalar& scale, int batchIndex = 0) {
+    if (blob->getTensorDesc().getPrecision() != InferenceEngine::Precision::FP32) {
+        THROW_IE_EXCEPTION << "Normalized image can be set only to FP32 blob";
+    }
+    InferenceEngine::SizeVector blobSize = blob->getTensorDesc().getDims();
+    InferenceEngine::LockedMemory<void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
+    float* blob_data = blobMapped.as<float*>();
+
+    const cv::Mat* resized_image;
+    std::vector<cv::Mat> planes = prepareBlobPlanes(orig_image, resized_image, blob_data, blobSize, CV_32F, batchIndex);
+    if (planes.size() > 4) {
+        THROW_IE_EXCEPTION << "Normalization supports up to 4 channels";
+    }
+    static thread_local std::vector<cv::Mat> u8Planes;
+    cv::split(*resized_image, u8Planes);
+    for (size_t c = 0; c < planes.size(); c++) {
+        u8Planes[c].convertTo(planes[c], CV_32F, scale[c], -mean[c] * scale[c]);
+    }
+}
+
+/**
+* @brief Returns the affine transform which scales the ROI to the size like cv::resize() does: pixel centers of the ROI
+*        and of the result are aligned.
+* @param roi - the region of an image.
+* @param size - the size of the result.
+* @return 2x3 CV_64F transform from the image coordinates to the coordinates of the result.
+*/
+inline cv::Mat resizeTransform(const cv::Rect& roi, const cv::Size& size) {
+    const double scaleX = static_cast<double>(size.width) / roi.width;
+    const double scaleY = static_cast<double>(size.height) / roi.height;
+    return (cv::Mat_<double>(2, 3) << scaleX, 0, (0.5 - roi.x) * scaleX - 0.5,
+                                      0, scaleY, (0.5 - roi.y) * scaleY - 0.5);
+}
+
+/**
+* @brief Warps image data stored in cv::Mat object straight to the size of the blob and splits it into the channel
+*        planes of batchIndex-th image inside of the blob. A rotated or scaled ROI isn't cropped and resized first,
+*        the only intermediate image is a thread local buffer of the blob size. A 3-channel image is converted to
+*        grayscale for a 1-channel blob.
+* @param image - given cv::Mat object with an image data.
+* @param transform - 2x3 affine transform from the image coordinates to the coordinates of the blob image.
+* @param blob_data - pointer to the mapped blob memory.
+* @param blobSize - dimensions of the blob in NCHW order.
+* @param batchIndex - batch index of an image inside of the blob.
+*/
+template <typename T>
+void warpAffineToBlobData(const cv::Mat& image, const cv::Mat& transform, T* blob_data,
+                          const InferenceEngine::SizeVector& blobSize, int batchIndex = 0) {
+    static thread_local cv::Mat warpBuffer;
+    static thread_local cv::Mat grayBuffer;
+    cv::warpAffine(image, warpBuffer, transform, cv::Size(static_cast<int>(blobSize[3]), static_cast<int>(blobSize[2])));
+    const cv::Mat* warped_image = &warpBuffer;
+    if (1 == blobSize[1] && 3 == warpBuffer.channels()) {
+        cv::cvtColor(warpBuffer, grayBuffer, cv::COLOR_BGR2GRAY);
+        warped_image = &grayBuffer;
+    }
+
+    const cv::Mat* resized_image;
+    std::vector<cv::Mat> planes = prepareBlobPlanes(*warped_image, resized_image, blob_data, blobSize,
+                                                    cv::DataType<T>::depth, batchIndex);
+    if (cv::DataType<T>::depth == CV_8U) {
+        cv::split(*resized_image, planes);
     } else {
-        THROW_IE_EXCEPTION << "Unsupported number of channels";
+        static thread_local std::vector<cv::Mat> u8Planes;
+        cv::split(*resized_image, u8Planes);
+        for (size_t c = 0; c < planes.size(); c++) {
+            u8Planes[c].convertTo(planes[c], planes[c].type());
+        }
     }
 }
 
+/**
+* @brief Warps image data stored in cv::Mat object to a given Blob object, see warpAffineToBlobData().
+* @param image - given cv::Mat object with an image data.
+* @param transform - 2x3 affine transform from the image coordinates to the coordinates of the blob image.
+* @param blob - Blob object which to be filled by an image data.
+* @param batchIndex - batch index of an image inside of the blob.
+*/
+template <typename T>
+void warpAffineToBlob(const cv::Mat& image, const cv::Mat& transform, InferenceEngine::Blob::Ptr& blob,
+                      int batchIndex = 0) {
+    InferenceEngine::LockedMemory<void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
+    warpAffineToBlobData(image, transform, blobMapped.as<T*>(), blob->getTensorDesc().getDims(), batchIndex);
+}
+
 /**
  * @brief Wraps data stored inside of a passed cv::Mat object by new Blob pointer.
  * @note: No memory allocation is happened. The blob just points to already existing
- *        cv::Mat data.
- * @param mat - given cv::Mat object with an image data.
+ *        cv::Mat data. Regions of larger images (not continuous cv::Mat) are wrapped with their row stride.
+ * @param mat - given 8-bit cv::Mat object with an image data.
  * @return resulting Blob pointer.
  */
 static UNUSED InferenceEngine::Blob::Ptr wrapMat2Blob(const cv::Mat &mat) {
@@ -74,23 +263,54 @@ static UNUSED InferenceEngine::Blob::Ptr wrapMat2Blob(const cv::Mat &mat) {
     size_t strideH = mat.step.buf[0];
     size_t strideW = mat.step.buf[1];
 
-    bool is_dense =
-            strideW == channels &&
-            strideH == channels * width;
-
-    if (!is_dense) THROW_IE_EXCEPTION
-                << "Doesn't support conversion from not dense cv::Mat";
+    if (mat.depth() != CV_8U || mat.dims != 2) THROW_IE_EXCEPTION
+            << "Doesn't support conversion from not 8-bit 2D cv::Mat";
 
     InferenceEngine::TensorDesc tDesc(InferenceEngine::Precision::U8,
                                       {1, channels, height, width},
                                       InferenceEngine::Layout::NHWC);
 
-    return InferenceEngine::make_shared_blob<uint8_t>(tDesc, mat.data);
+    if (strideW == channels && strideH == channels * width) {
+        return InferenceEngine::make_shared_blob<uint8_t>(tDesc, mat.data);
+    }
+
+    // Region of a larger image: rows are padded, so the blob gets the row stride of the image.
+    // Such blobs are read by the preprocessing of the plugin (e.g. auto-resize) rather than copied before it.
+    InferenceEngine::BlockingDesc blockingDesc({1, height, width, channels}, {0, 2, 3, 1}, 0, {0, 0, 0, 0},
+                                               {height * strideH, strideH, strideW, 1});
+    return InferenceEngine::make_shared_blob<uint8_t>(
+        InferenceEngine::TensorDesc(InferenceEngine::Precision::U8, {1, channels, height, width}, blockingDesc),
+        mat.data);
+}
+
+/**
+ * @brief Wraps NV12 image (single channel cv::Mat with Y plane rows followed by interleaved UV plane rows, as
+ *        returned by ImagesCapture with VideoDecodeMode::HardwareNV12) into NV12Blob without copying.
+ *        Input of the network should have ColorFormat::NV12 set in its preprocessing info.
+ * @param nv12 - image to wrap. It should stay alive while the blob is used.
+ * @return NV12Blob referencing image data
+ */
+static UNUSED InferenceEngine::Blob::Ptr wrapMatNV12ToBlob(const cv::Mat &nv12) {
+    if (nv12.type() != CV_8UC1 || nv12.rows % 3 != 0 || nv12.cols % 2 != 0 || !nv12.isContinuous())
+        THROW_IE_EXCEPTION << "Doesn't support conversion from not dense NV12 cv::Mat";
+
+    size_t height = nv12.rows * 2 / 3;
+    size_t width = nv12.cols;
+
+    InferenceEngine::TensorDesc yDesc(InferenceEngine::Precision::U8,
+                                      {1, 1, height, width},
+                                      InferenceEngine::Layout::NHWC);
+    InferenceEngine::TensorDesc uvDesc(InferenceEngine::Precision::U8,
+                                       {1, 2, height / 2, width / 2},
+                                       InferenceEngine::Layout::NHWC);
+    auto yBlob = InferenceEngine::make_shared_blob<uint8_t>(yDesc, nv12.data);
+    auto uvBlob = InferenceEngine::make_shared_blob<uint8_t>(uvDesc, nv12.data + height * width);
+    return InferenceEngine::make_shared_blob<InferenceEngine::NV12Blob>(yBlob, uvBlob);
 }
 
 /**
  * @brief Puts text message on the frame, highlights the text with a white border to make it distinguishable from
- *        the background.
+ *        the background. Rendered messages are cached by a TextCache of the calling thread.
  * @param frame - frame to put the text on.
  * @param message - text of the message.
  * @param position - bottom-left corner of the text string in the image.
@@ -106,6 +326,7 @@ inline void putHighlightedText(cv::Mat& frame,
                                double fontScale,
                                cv::Scalar color,
                                int thickness) {
-    cv::putText(frame, message, position, fontFace, fontScale, cv::Scalar(255, 255, 255), thickness + 1);
-    cv::putText(frame, message, position, fontFace, fontScale, color, thickness);
+    static thread_local TextCache textCache;
+    textCache.putText(frame, message, position, fontFace, fontScale, color, thickness, cv::Scalar(255, 255, 255),
+                      thickness + 1);
 }
@@ -10,10 +10,13 @@
 #pragma once
 
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <string>
 
+#include "samples/latency_histogram.hpp"
 #include "samples/ocv_common.hpp"
 
 class PerformanceMetrics {
@@ -29,7 +32,27 @@ public:
         double fps;
     };
 
+    /// Stages of frame processing which durations can be recorded separately
+    enum class Stage {
+        Decode,
+        CaptureWait,  ///< Captured frame waits for submission to the pipeline
+        Preprocess,
+        QueueWait,
+        Infer,
+        Postprocess,
+        Render,
+        EndToEnd  ///< From the capture of the frame to the display of its result, recorded by update()
+    };
+    static const int STAGES_COUNT = static_cast<int>(Stage::EndToEnd) + 1;
+
+    enum class ExportFormat {
+        Json,
+        Csv
+    };
+
     PerformanceMetrics(Duration timeWindow = std::chrono::seconds(1));
+    /// Updates the metrics with a frame which result is displayed now
+    /// @param lastRequestStartTime capture time of the frame, its latency is recorded as Stage::EndToEnd
     void update(TimePoint lastRequestStartTime,
                 cv::Mat& frame,
                 cv::Point position = {15, 30},
@@ -54,7 +77,36 @@ public:
     Metrics getTotal() const;
     void printTotal() const;
 
+    /// Records duration of the stage. This function is thread safe and lock-free,
+    /// so it can be called from inference completion callbacks.
+    void recordStage(Stage stage, Duration duration) { stagesHistograms[static_cast<int>(stage)].record(duration); }
+    /// Records duration of the stage started at startTime and finished now
+    void recordStage(Stage stage, TimePoint startTime) { recordStage(stage, Clock::now() - startTime); }
+
+    const LatencyHistogram& getStageHistogram(Stage stage) const { return stagesHistograms[static_cast<int>(stage)]; }
+    static const char* getStageName(Stage stage);
+
+    /// Writes count, mean, p50, p90, p99 and max duration of every recorded stage
+    /// @param out stream to write to
+    /// @param format output format. Csv format writes one line per stage prefixed with time since construction
+    void exportStages(std::ostream& out, ExportFormat format) const;
+
+    /// Enables periodic export of stages statistics from update() calls
+    /// @param fileName name of the file. Json file is rewritten with latest statistics,
+    /// lines are appended to Csv file (after header written when export is enabled).
+    /// @param format output format
+    /// @param period minimal time between exports
+    void enableStagesExport(const std::string& fileName, ExportFormat format,
+                            Duration period = std::chrono::seconds(1));
+
+    /// Prints total latency, FPS, number of frames and statistics of the stages to stdout as a single line,
+    /// so scripts can find it among the other output of a demo. Used for -report_perf of the demos.
+    /// @param format output format, only "json" is supported: {"perf_report": {...}}
+    void reportTotal(const std::string& format) const;
+
 private:
+    void writeStagesJson(std::ostream& stream) const;
+
     struct Statistic {
         Duration latency;
         Duration period;
@@ -79,4 +131,12 @@ private:
     Statistic totalStatistic;
     TimePoint lastUpdateTime;
     bool firstFrameProcessed;
+
+    LatencyHistogram stagesHistograms[STAGES_COUNT];
+    TimePoint creationTime;
+
+    std::string exportFileName;
+    ExportFormat exportFormat;
+    Duration exportPeriod;
+    TimePoint lastExportTime;
 };
@@ -0,0 +1,17 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <string>
+
+#include <inference_engine.hpp>
+
+// Reads the network as Core::ReadNetwork(modelPath) does. If mapWeights is true and the model is IR, its .bin file is
+// mapped to memory copy-on-write instead of being read to the heap, and the network refers to the mapped weights.
+// The pages of the mapping are the pages of the file in the page cache, so the processes reading the same model keep
+// one copy of the weights in memory, and a warm start doesn't read the file at all. The mapping lives as long as the
+// network or anything the IR reader built from the weights. Plugins which convert the weights to their own layout
+// while loading the network keep their converted copy anyway.
+InferenceEngine::CNNNetwork readNetwork(InferenceEngine::Core& core, const std::string& modelPath, bool mapWeights);
@@ -0,0 +1,92 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file for writing inference results of demos to a file in a machine readable format
+ * @file results_writer.hpp
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief Writes detected objects to a file as JSON lines or fixed layout binary records.
+ * Records are formatted into preallocated buffers, and a background thread writes the filled buffers to the file,
+ * so the calling threads don't wait for the file system. If the file can't keep up and all buffers are filled,
+ * writing blocks until a buffer is written. All functions except close() are thread safe.
+ *
+ * JSON lines format: one object per line, "id" and "confidence" are omitted if unknown, "text" if empty:
+ *   {"stream": 0, "frame": 12, "id": 3, "label": 1, "confidence": 0.8710, "box": [10, 20, 30, 40], "text": "white car"}
+ * Binary format: 8 bytes "OMZRES01" followed by records of native endianness:
+ *   uint32 stream, int64 frame, int32 id, int32 label, float32 confidence, float32 x, y, width, height,
+ *   uint16 text length, text bytes
+ */
+class ResultsWriter {
+public:
+    enum class Format {
+        Jsonl,
+        Binary
+    };
+
+    struct Record {
+        unsigned stream = 0;  // index of the input the frame is read from
+        int64_t frame = 0;
+        int id = -1;  // track id, -1 if the objects aren't tracked
+        int label = 0;
+        float confidence = -1.f;  // -1 if unknown
+        cv::Rect2f box;
+        std::string text;  // label name or recognized attributes
+    };
+
+    /**
+     * @param fileName file to write to, it's overwritten
+     * @param format format of the file
+     * @param bufferSize size of every buffer in bytes, a buffer is written to the file when it's filled
+     * @param buffersCount number of buffers, all but one of them can wait to be written
+     */
+    ResultsWriter(const std::string& fileName, Format format, size_t bufferSize = 1 << 20, size_t buffersCount = 4);
+    ~ResultsWriter();
+
+    ResultsWriter(const ResultsWriter&) = delete;
+    ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+    /// Binary format for .bin files, JSON lines otherwise
+    static Format formatFromFileName(const std::string& fileName);
+
+    void write(const Record& record);
+    /// Writes records of a frame together, so they aren't interleaved with records of other threads
+    void write(const std::vector<Record>& records);
+
+    /// Writes all written records to the file and closes it. Throws if writing to the file failed
+    void close();
+
+private:
+    void append(const Record& record);
+    /// Hands the current buffer to the flush thread and takes an empty one. Should be called with mtx locked
+    void submitBuffer(std::unique_lock<std::mutex>& lock);
+    void flushLoop();
+
+    const Format format;
+    const size_t bufferSize;
+    std::FILE* file;
+
+    std::mutex mtx;
+    std::condition_variable condVar;
+    std::string currentBuffer;
+    std::deque<std::string> filledBuffers;
+    std::vector<std::string> freeBuffers;
+    bool isStopping = false;
+    bool hasWriteError = false;
+    std::thread flushThread;
+};
@@ -0,0 +1,121 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with pool recycling memory of objects owned by std::shared_ptr
+ * @file shared_pool.hpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "samples/mpmc_queue.hpp"
+
+/**
+ * @class BlockPool
+ * @brief Recycles memory blocks of one size through a lock-free queue, so blocks can be taken and returned by any
+ *        threads. The size of the first allocation is pooled, other sizes and the blocks which don't fit
+ *        into the queue go to operator new and delete.
+ */
+class BlockPool {
+public:
+    /**
+     * @brief A constructor. Creates an empty pool
+     * @param capacity - maximal number of free blocks kept for reuse
+     */
+    explicit BlockPool(size_t capacity) : freeBlocks(capacity), blockSize(0) {}
+
+    ~BlockPool() {
+        void* block;
+        while (freeBlocks.tryPop(block)) {
+            ::operator delete(block);
+        }
+    }
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    void* allocate(size_t size) {
+        size_t pooledSize = 0;
+        blockSize.compare_exchange_strong(pooledSize, size);
+        void* block;
+        if ((pooledSize == 0 || pooledSize == size) && freeBlocks.tryPop(block)) {
+            return block;
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, size_t size) {
+        if (size != blockSize.load(std::memory_order_relaxed) || !freeBlocks.tryPush(block)) {
+            ::operator delete(block);
+        }
+    }
+
+private:
+    MpmcQueue<void*> freeBlocks;
+    std::atomic<size_t> blockSize;
+};
+
+/**
+ * @class PoolAllocator
+ * @brief Allocator taking memory from BlockPool. The pool lives while any memory allocated from it is in use
+ */
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<BlockPool> pool) : pool(std::move(pool)) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "operator new doesn't align T");
+        return static_cast<T*>(pool->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        pool->deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const { return pool == other.pool; }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const { return pool != other.pool; }
+
+    std::shared_ptr<BlockPool> pool;
+};
+
+/**
+ * @class SharedPool
+ * @brief Creates objects owned by std::shared_ptr in recycled memory. The object and its reference counts are
+ *        allocated as one block (like std::make_shared does), and the blocks of released objects are reused,
+ *        so creating an object per frame doesn't allocate heap memory once the pipeline is in steady state.
+ *        The objects are constructed in place and destroyed when their last reference is released, as usual.
+ *        The pool is thread safe and may be destroyed before the objects it created.
+ * @tparam T - type of the objects
+ */
+template <typename T>
+class SharedPool {
+public:
+    /**
+     * @brief A constructor. Creates an empty pool
+     * @param capacity - maximal number of free blocks kept for reuse, e.g. the number of frames in flight
+     */
+    explicit SharedPool(size_t capacity = 64) : pool(std::make_shared<BlockPool>(capacity)) {}
+
+    template <typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(PoolAllocator<T>(pool), std::forward<Args>(args)...);
+    }
+
+private:
+    std::shared_ptr<BlockPool> pool;
+};
@@ -1,4 +1,4 @@
-// Copyright (C) 2018-2019 Intel Corporation
+// Copyright (C) 2018-2020 Intel Corporation
 // SPDX-License-Identifier: Apache-2.0
 //
 
@@ -9,8 +9,32 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mpmc_queue.hpp"
+
+#define SLOG_LEVEL_INFO 0
+#define SLOG_LEVEL_WARNING 1
+#define SLOG_LEVEL_ERROR 2
+
+// The streams of the levels below SLOG_MIN_LEVEL don't print anything and their operators are compiled out.
+// The arguments of the operators are still evaluated
+#ifndef SLOG_MIN_LEVEL
+#define SLOG_MIN_LEVEL SLOG_LEVEL_INFO
+#endif
 
 namespace slog {
 
@@ -32,15 +56,287 @@ class LogStreamBoolAlpha { };
 static constexpr LogStreamBoolAlpha boolalpha;
 
 
+namespace detail {
+
+/**
+ * @class StringBuf
+ * @brief The StringBuf class is a stream buffer appending to a string. Unlike std::stringbuf, the string is
+ *        accessed in place and keeps its capacity when it's cleared, so composing a line doesn't allocate memory
+ *        once the buffer has grown to the usual line length
+ */
+class StringBuf : public std::streambuf {
+public:
+    std::string& str() { return buffer; }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            buffer.push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize count) override {
+        buffer.append(s, static_cast<size_t>(count));
+        return count;
+    }
+
+private:
+    std::string buffer;
+};
+
+/**
+ * @class AsyncWriter
+ * @brief The AsyncWriter class writes the lines of the log streams in a background thread.
+ *        Logging threads copy finished lines to preallocated slots, put the slots to a lock-free queue and never
+ *        wait for the console. The slots are reused, so their buffers are allocated only while they grow to the
+ *        usual line length. If there is no free slot, the line is dropped and the number of dropped lines is
+ *        reported later. Error lines are urgent: they are written with all the lines queued before them when the
+ *        logging thread returns.
+ *        A line repeated more than maxRepeats times within a second is written maxRepeats times, the number of
+ *        suppressed repetitions is written when the second ends.
+ */
+class AsyncWriter {
+public:
+    static constexpr size_t queueCapacity = 4096;
+    static constexpr size_t maxRepeats = 10;
+    static constexpr size_t maxTrackedLines = 4096;
+
+    static AsyncWriter& instance();
+
+    AsyncWriter() : slots(new Line[queueCapacity]), queue(queueCapacity), freeSlots(queueCapacity), dropped(0),
+            stopping(false) {
+        for (size_t i = 0; i < queueCapacity; ++i) {
+            freeSlots.tryPush(i);
+        }
+        thread = std::thread(&AsyncWriter::run, this);
+    }
+
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    void push(std::ostream* stream, const std::string& text, bool urgent) {
+        size_t slot;
+        if (freeSlots.tryPop(slot)) {
+            slots[slot].stream = stream;
+            slots[slot].text.assign(text);
+            // Never fails: the queue has a cell for every slot
+            queue.tryPush(slot);
+            if (urgent) {
+                flush();
+            } else if (queue.sizeApprox() > queue.capacity() / 2) {
+                wakeUp.notify_one();
+            }
+        } else if (urgent) {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            drain();
+            write(stream, text);
+            flushStreams();
+        } else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Writes the queued lines in the calling thread
+    void flush() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        drain();
+        flushStreams();
+    }
+
+private:
+    // Slots don't keep the buffers of longer lines, so rare long lines don't pin the memory
+    static constexpr size_t maxKeptLineCapacity = 1024;
+
+    struct Line {
+        std::ostream* stream = nullptr;
+        std::string text;
+    };
+
+    struct Repeats {
+        std::ostream* stream;
+        std::chrono::steady_clock::time_point start;
+        size_t count;
+        size_t suppressed;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> wakeLock(wakeMutex);
+        while (!stopping) {
+            wakeLock.unlock();
+            {
+                std::lock_guard<std::mutex> lock(writeMutex);
+                drain();
+                expireRepeats(std::chrono::steady_clock::now());
+                flushStreams();
+            }
+            wakeLock.lock();
+            wakeUp.wait_for(wakeLock, std::chrono::milliseconds(10), [this] { return stopping; });
+        }
+    }
+
+    void drain() {
+        size_t slot;
+        while (queue.tryPop(slot)) {
+            Line& line = slots[slot];
+            write(line.stream, line.text);
+            if (line.text.capacity() > maxKeptLineCapacity) {
+                std::string().swap(line.text);
+            }
+            freeSlots.tryPush(slot);
+        }
+        size_t droppedLines = dropped.exchange(0, std::memory_order_relaxed);
+        if (droppedLines) {
+            std::cout << "[ WARNING ] " << droppedLines << " log lines were dropped, the log queue was full\n";
+            touch(&std::cout);
+        }
+    }
+
+    void write(std::ostream* stream, const std::string& text) {
+        auto now = std::chrono::steady_clock::now();
+        auto it = repeats.find(text);
+        if (it == repeats.end()) {
+            if (repeats.size() < maxTrackedLines) {
+                repeats.emplace(text, Repeats{stream, now, 1, 0});
+            }
+        } else if (now - it->second.start >= std::chrono::seconds(1)) {
+            reportSuppressed(it->first, it->second);
+            it->second = Repeats{stream, now, 1, 0};
+        } else if (++it->second.count > maxRepeats) {
+            ++it->second.suppressed;
+            return;
+        }
+        (*stream) << text;
+        touch(stream);
+    }
+
+    void expireRepeats(std::chrono::steady_clock::time_point now) {
+        for (auto it = repeats.begin(); it != repeats.end();) {
+            if (now - it->second.start >= std::chrono::seconds(1)) {
+                reportSuppressed(it->first, it->second);
+                it = repeats.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void reportSuppressed(const std::string& text, const Repeats& lineRepeats) {
+        if (lineRepeats.suppressed) {
+            (*lineRepeats.stream) << text.substr(0, text.size() - 1)
+                << " (" << lineRepeats.suppressed << " more times)\n";
+            touch(lineRepeats.stream);
+        }
+    }
+
+    void touch(std::ostream* stream) {
+        for (std::ostream* written : writtenStreams) {
+            if (written == stream) {
+                return;
+            }
+        }
+        writtenStreams.push_back(stream);
+    }
+
+    void flushStreams() {
+        for (std::ostream* stream : writtenStreams) {
+            stream->flush();
+        }
+        writtenStreams.clear();
+    }
+
+    std::unique_ptr<Line[]> slots;
+    // Indices of the slots holding the lines to write, in the order they were logged
+    MpmcQueue<size_t> queue;
+    MpmcQueue<size_t> freeSlots;
+    std::atomic<size_t> dropped;
+
+    // Guards writing, so the lines are written in the order of the queue by the writer and the flushing threads
+    std::mutex writeMutex;
+    std::unordered_map<std::string, Repeats> repeats;
+    std::vector<std::ostream*> writtenStreams;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeUp;
+    bool stopping;
+
+    std::thread thread;
+};
+
+// The writer the streams use, nullptr if the lines are written synchronously
+inline std::atomic<AsyncWriter*>& activeWriter() {
+    static std::atomic<AsyncWriter*> writer(std::getenv("OMZ_SLOG_ASYNC") ? &AsyncWriter::instance() : nullptr);
+    return writer;
+}
+
+inline AsyncWriter& AsyncWriter::instance() {
+    static AsyncWriter writer;
+    return writer;
+}
+
+inline AsyncWriter::~AsyncWriter() {
+    // The lines logged from now on are written synchronously
+    activeWriter().store(nullptr, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    thread.join();
+    std::lock_guard<std::mutex> lock(writeMutex);
+    drain();
+    expireRepeats(std::chrono::steady_clock::time_point::max());
+    flushStreams();
+}
+
+}  // namespace detail
+
+/**
+ * @brief Makes the log streams write in the background thread, see detail::AsyncWriter.
+ *        Setting the OMZ_SLOG_ASYNC environment variable does the same for the whole run.
+ *        The queued lines are written at exit
+ */
+inline void enableAsync() {
+    detail::activeWriter().store(&detail::AsyncWriter::instance(), std::memory_order_release);
+}
+
+/**
+ * @brief Writes the lines queued by the background writer, if it's enabled
+ */
+inline void flush() {
+    if (detail::AsyncWriter* writer = detail::activeWriter().load(std::memory_order_acquire)) {
+        writer->flush();
+    }
+}
+
+
 /**
  * @class LogStream
- * @brief The LogStream class implements a stream for sample logging
+ * @brief The LogStream class implements a stream for sample logging.
+ *        With the background writer enabled, every thread composes its own line and the line is queued at slog::endl,
+ *        so the lines of different threads don't interleave. Stream manipulators then apply to the lines of
+ *        the calling thread only
+ * @tparam level - SLOG_LEVEL_* of the stream
  */
+template<int level>
 class LogStream {
     std::string _prefix;
     std::ostream* _log_stream;
     bool _new_line;
 
+    struct Line {
+        detail::StringBuf buffer;
+        std::ostream text{&buffer};
+        bool started = false;
+    };
+
+    static Line& threadLine() {
+        static thread_local Line line;
+        return line;
+    }
+
 public:
     /**
      * @brief A constructor. Creates a LogStream object
@@ -57,6 +353,19 @@ public:
      */
     template<class T>
     LogStream &operator<<(const T &arg) {
+        if (level < SLOG_MIN_LEVEL) {
+            return *this;
+        }
+        Line& line = threadLine();
+        if (line.started || detail::activeWriter().load(std::memory_order_acquire)) {
+            if (!line.started) {
+                line.text << "[ " << _prefix << " ] ";
+                line.started = true;
+            }
+            line.text << arg;
+            return *this;
+        }
+
         if (_new_line) {
             (*_log_stream) << "[ " << _prefix << " ] ";
             _new_line = false;
@@ -68,6 +377,25 @@ public:
 
     // Specializing for LogStreamEndLine to support slog::endl
     LogStream& operator<< (const LogStreamEndLine &/*arg*/) {
+        if (level < SLOG_MIN_LEVEL) {
+            return *this;
+        }
+        Line& line = threadLine();
+        detail::AsyncWriter* writer = detail::activeWriter().load(std::memory_order_acquire);
+        if (line.started || writer) {
+            line.text << '\n';
+            std::string& text = line.buffer.str();
+            if (writer) {
+                writer->push(_log_stream, text, level >= SLOG_LEVEL_ERROR);
+            } else {
+                // the writer has been destroyed at exit while the line was composed
+                (*_log_stream) << text << std::flush;
+            }
+            text.clear();
+            line.started = false;
+            return *this;
+        }
+
         _new_line = true;
 
         (*_log_stream) << std::endl;
@@ -76,14 +404,21 @@ public:
 
     // Specializing for LogStreamBoolAlpha to support slog::boolalpha
     LogStream& operator<< (const LogStreamBoolAlpha &/*arg*/) {
-        (*_log_stream) << std::boolalpha;
+        if (level < SLOG_MIN_LEVEL) {
+            return *this;
+        }
+        if (threadLine().started || detail::activeWriter().load(std::memory_order_acquire)) {
+            threadLine().text << std::boolalpha;
+        } else {
+            (*_log_stream) << std::boolalpha;
+        }
         return *this;
     }
 };
 
 
-static LogStream info("INFO", std::cout);
-static LogStream warn("WARNING", std::cout);
-static LogStream err("ERROR", std::cerr);
+static LogStream<SLOG_LEVEL_INFO> info("INFO", std::cout);
+static LogStream<SLOG_LEVEL_WARNING> warn("WARNING", std::cout);
+static LogStream<SLOG_LEVEL_ERROR> err("ERROR", std::cerr);
 
 }  // namespace slog
@@ -0,0 +1,100 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with a cache of rendered text
+ * @file text_cache.hpp
+ */
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+/**
+ * @class TextCache
+ * @brief Draws text like cv::putText, but every string is rasterized once into a mask which is kept in the cache,
+ *        later the string is drawn by setting the pixels of the mask, which is several times faster.
+ *        Hershey fonts are drawn as polylines glyph by glyph, that is slow with dozens of labels per frame,
+ *        while the labels (class names, confidences, metrics) mostly repeat from frame to frame.
+ *        The least recently used strings are evicted. The cache isn't thread safe, use one per rendering thread.
+ */
+class TextCache {
+public:
+    explicit TextCache(size_t capacity = 512) : capacity(capacity) {}
+
+    /**
+     * @brief Draws the text, the arguments are the same as of cv::putText with cv::LINE_8
+     * @param outlineColor - if thickness of the outline is positive, the text is drawn over the outline of this color
+     *        (see putHighlightedText)
+     */
+    void putText(cv::Mat& frame, const std::string& text, cv::Point org, int fontFace, double fontScale,
+                 const cv::Scalar& color, int thickness = 1, const cv::Scalar& outlineColor = cv::Scalar(),
+                 int outlineThickness = 0) {
+        if (outlineThickness > 0) {
+            draw(frame, getMask(text, fontFace, fontScale, outlineThickness), org, outlineColor);
+        }
+        draw(frame, getMask(text, fontFace, fontScale, thickness), org, color);
+    }
+
+private:
+    struct Mask {
+        cv::Mat mask;
+        cv::Point offset;  // of the top left corner of the mask from the origin of the text
+    };
+    using Key = std::tuple<std::string, int, double, int>;
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<std::string>()(std::get<0>(key)) ^ std::hash<double>()(std::get<2>(key))
+                ^ (static_cast<size_t>(std::get<1>(key)) << 8) ^ static_cast<size_t>(std::get<3>(key));
+        }
+    };
+    using LruList = std::list<std::pair<Key, Mask>>;
+
+    const Mask& getMask(const std::string& text, int fontFace, double fontScale, int thickness) {
+        Key key{text, fontFace, fontScale, thickness};
+        auto it = index.find(key);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->second;
+        }
+
+        int baseline = 0;
+        cv::Size size = cv::getTextSize(text, fontFace, fontScale, thickness, &baseline);
+        // Strokes are thicker than the glyph boxes, the margin keeps them inside of the mask
+        int margin = thickness + 1;
+        Mask mask;
+        mask.mask = cv::Mat::zeros(size.height + baseline + 2 * margin, size.width + 2 * margin, CV_8UC1);
+        mask.offset = {-margin, -size.height - margin};
+        cv::putText(mask.mask, text, {margin, size.height + margin}, fontFace, fontScale, cv::Scalar(255), thickness);
+
+        lru.emplace_front(key, std::move(mask));
+        index.emplace(key, lru.begin());
+        if (lru.size() > capacity) {
+            index.erase(lru.back().first);
+            lru.pop_back();
+        }
+        return lru.front().second;
+    }
+
+    static void draw(cv::Mat& frame, const Mask& mask, cv::Point org, const cv::Scalar& color) {
+        cv::Rect rect(org + mask.offset, mask.mask.size());
+        cv::Rect visible = rect & cv::Rect({}, frame.size());
+        if (visible.empty()) {
+            return;
+        }
+        frame(visible).setTo(color, mask.mask(visible - rect.tl()));
+    }
+
+    size_t capacity;
+    LruList lru;
+    std::unordered_map<Key, LruList::iterator, KeyHash> index;
+};
@@ -0,0 +1,55 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file with the split of CPU threads between inference and the application
+ * @file thread_budget.hpp
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @class ThreadBudget
+ * @brief Splits the CPU threads of the process between the inference plugin and the application. The CPU networks
+ *        of all the pipelines of the process are registered with the threads their config gives them, the rest
+ *        of the threads are left to the application: OpenCV parallel_for_ is limited to them, and the thread pools
+ *        of the demos can be sized by getAppThreads(). A network without CPU_THREADS_NUM takes all the threads,
+ *        the application isn't limited then, as there is nothing to leave to it. The budget isn't applied
+ *        if OMZ_THREAD_BUDGET environment variable is "0".
+ */
+class ThreadBudget {
+public:
+    /// @return the budget shared by the whole process
+    static ThreadBudget& global();
+
+    /**
+     * @brief A constructor
+     * @param totalThreads - threads of the CPU. 0 means std::thread::hardware_concurrency()
+     */
+    explicit ThreadBudget(unsigned totalThreads = 0);
+
+    /**
+     * @brief Registers a network inferred on the CPU
+     * @param config - ExecutableNetwork config of the network, only CPU_THREADS_NUM is read from it
+     */
+    void addCpuNetwork(const std::map<std::string, std::string>& config);
+
+    /// @return threads of the registered networks, at most all the threads of the CPU
+    unsigned getInferenceThreads() const;
+    /// @return threads left for the application, 0 if the application isn't limited, e.g. there are no CPU networks
+    unsigned getAppThreads() const;
+
+    /// Limits OpenCV parallel_for_ to the threads of the application
+    void applyToOpenCV() const;
+
+private:
+    mutable std::mutex mutex;
+    const unsigned totalThreads;
+    unsigned inferenceThreads;
+    const bool isEnabled;
+};
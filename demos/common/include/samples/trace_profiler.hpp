@@ -0,0 +1,110 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+/**
+ * @brief a header file for collection of per-layer performance counters and timeline spans
+ * @file trace_profiler.hpp
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <inference_engine.hpp>
+
+/**
+ * @brief Aggregates per-layer execution time of inferences over a sliding window and keeps a timeline of
+ * application spans (preprocessing, postprocessing, rendering etc.) together with inferences and their layers.
+ * The timeline is exported in Chrome trace event format, which can be opened by chrome://tracing or Perfetto UI.
+ * All functions are thread safe, so inferences can be added from completion callbacks.
+ */
+class TraceProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+    using PerfCounts = std::map<std::string, InferenceEngine::InferenceEngineProfileInfo>;
+
+    struct LayerStatistic {
+        std::string name;
+        std::string layerType;
+        std::string execType;
+        double meanRealTime; // in microseconds per inference
+        double meanCpuTime; // in microseconds per inference
+        double share; // part of the total real time of all layers
+    };
+
+    /**
+     * @param windowSize number of the last inferences layers statistics are computed over
+     * @param maxTraceEvents number of the last timeline events kept for export. Layers of every inference add
+     *        a separate event each, so this value should be also large enough for them
+     */
+    explicit TraceProfiler(size_t windowSize = 100, size_t maxTraceEvents = 100000);
+
+    /// Adds span of the current thread to the timeline
+    void addSpan(const std::string& name, TimePoint begin, TimePoint end);
+
+    /**
+     * @brief Adds inference performance counters to the statistics and the inference with its layers to the timeline.
+     *        Layers are placed one after another from the beginning of inference, as counters have durations only.
+     * @param requestKey identifies the timeline track of the inference, e.g. pointer to the infer request
+     * @param perfCounts result of InferRequest::GetPerformanceCounts()
+     * @param begin time inference was started
+     * @param end time inference was completed
+     */
+    void addInference(const void* requestKey, const PerfCounts& perfCounts, TimePoint begin, TimePoint end);
+
+    /// @return statistics of topN layers with the highest mean real time over the window
+    std::vector<LayerStatistic> getTopLayers(size_t topN) const;
+    void printTopLayers(std::ostream& out, size_t topN) const;
+
+    /// Writes timeline in Chrome trace event (JSON) format
+    void exportChromeTrace(std::ostream& out) const;
+
+private:
+    struct LayerInfo {
+        std::string name;
+        std::string layerType;
+        std::string execType;
+        long long realTimeSum;
+        long long cpuTimeSum;
+    };
+
+    struct LayerSample {
+        size_t layerId;
+        long long realTime;
+        long long cpuTime;
+    };
+
+    struct TraceEvent {
+        std::string name;
+        const char* category;
+        int trackId;
+        long long beginUs;
+        long long durationUs;
+    };
+
+    int getTrackId(const std::string& trackName);
+    void addTraceEvent(std::string name, const char* category, int trackId, TimePoint begin, long long durationUs);
+
+    const size_t windowSize;
+    const size_t maxTraceEvents;
+    const TimePoint creationTime;
+
+    mutable std::mutex mtx;
+    std::vector<LayerInfo> layers;
+    std::map<std::string, size_t> layerIds;
+    std::deque<std::vector<LayerSample>> window;
+    std::deque<TraceEvent> traceEvents;
+    std::vector<std::string> trackNames;
+    std::map<std::string, int> trackIds;
+    std::map<std::thread::id, int> threadTrackIds;
+    std::map<const void*, int> requestTrackIds;
+};
@@ -0,0 +1,60 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/videoio.hpp>
+
+enum class VideoEncodeMode {
+    Software,  // Default cv::VideoWriter backends
+    Hardware,  // Any hardware accelerated encoding available (VA-API, oneVPL, D3D11), software otherwise
+    VAAPI,  // VA-API encoding only
+    OneVPL  // oneVPL (Media SDK) encoding only
+};
+
+// Parses "sw", "hw", "vaapi" or "onevpl"
+VideoEncodeMode parseVideoEncodeMode(const std::string& mode);
+
+// Encodes frames on a dedicated thread, so the frame loop doesn't wait for the encoder. Frames are copied to
+// a bounded ring of preallocated buffers. If the encoder doesn't keep up and the ring is full, the new frame is
+// dropped instead of blocking. If target contains '!', it's a GStreamer pipeline starting with appsrc, which can
+// select a hardware encoder itself, e.g. "appsrc ! videoconvert ! vaapih264enc ! h264parse ! mp4mux ! filesink
+// location=out.mp4", and fourcc and mode are ignored.
+class AsyncVideoWriter {
+public:
+    AsyncVideoWriter(const std::string& target, int fourcc, double fps, cv::Size frameSize,
+        VideoEncodeMode mode = VideoEncodeMode::Software, size_t queueSize = 4);
+    ~AsyncVideoWriter();
+    AsyncVideoWriter(const AsyncVideoWriter&) = delete;
+    AsyncVideoWriter& operator=(const AsyncVideoWriter&) = delete;
+
+    // Queues a copy of the frame for encoding. Returns false if the frame is dropped because the queue is full
+    bool write(const cv::Mat& frame);
+    // Encodes the queued frames and closes the file
+    void close();
+
+    size_t getDroppedCount() const;
+
+private:
+    void encodeLoop();
+
+    cv::VideoWriter writer;
+    std::vector<cv::Mat> buffers;
+    std::deque<size_t> queuedBuffers;
+    std::vector<size_t> freeBuffers;
+    size_t droppedCount = 0;
+    bool isStopping = false;
+    mutable std::mutex mtx;
+    std::condition_variable condVar;
+    std::thread encodingThread;
+};
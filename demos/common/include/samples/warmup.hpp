@@ -0,0 +1,26 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <inference_engine.hpp>
+
+struct WarmupResult {
+    unsigned rounds = 0;
+    // Time of the last round, from starting all the requests till all of them completed
+    std::chrono::steady_clock::duration latency = std::chrono::steady_clock::duration::zero();
+    // True if the last round took about as long as the previous one
+    bool isSteady = false;
+};
+
+// Runs the requests before the first frame, so lazy allocations, kernel compilation and cold caches of the first
+// inferences don't fall on the frames and their metrics. Image (4D) inputs are filled with middle values of their
+// precisions, other inputs (e.g. image info set once after loading) are kept. All the requests are in flight at once,
+// as they are in a pipeline, and the rounds go on until a round takes within 10% of the previous one or maxRounds is
+// reached. The requests shouldn't have completion callbacks yet
+WarmupResult warmupRequests(const std::vector<InferenceEngine::InferRequest::Ptr>& requests,
+                            const InferenceEngine::ConstInputsDataMap& inputs, unsigned maxRounds);
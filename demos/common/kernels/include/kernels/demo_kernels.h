@@ -0,0 +1,42 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstdint>
+
+// SIMD kernels of the demos compiled for several instruction sets. The implementation is selected at the first call
+// by probing the CPU, so a portable binary runs the widest instructions the CPU supports.
+// The OMZ_DEMO_ISA environment variable (scalar, sse4.2, avx2, avx512 or neon) or setIsa() limit the selection,
+// e.g. to compare the implementations on one machine. The kernels don't allocate memory and are thread safe.
+namespace kernels {
+
+enum class Isa { Scalar, SSE42, AVX2, AVX512, NEON };
+
+const char* isaName(Isa isa);
+
+// The widest instruction set which is compiled in and supported by the CPU and the OS
+Isa detectIsa();
+
+// The instruction set of the kernels in use
+Isa activeIsa();
+
+// Switches the kernels to isa or, if it isn't available, to the widest available set below it. Returns the set in use
+Isa setIsa(Isa isa);
+
+// Writes the indices of values which are not less than threshold to indices in increasing order, returns their number.
+// indices must have room for size elements
+int collectAboveThreshold(const float* data, int size, float threshold, int* indices);
+
+// One step of argmax over channels: where values[i] > maxValues[i], sets maxValues[i] to values[i]
+// and classIds[i] to classId
+void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds);
+
+// Converts IEEE half precision values (FP16 blobs of the Inference Engine) to float. AVX2 and AVX-512 kernels use F16C
+void convertHalfToFloat(const uint16_t* src, int size, float* dst);
+
+// Converts one half precision value, e.g. of the few elements read from an FP16 blob
+float halfToFloat(uint16_t value);
+
+}  // namespace kernels
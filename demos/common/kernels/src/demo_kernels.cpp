@@ -0,0 +1,185 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "kernels/demo_kernels.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "kernels_impl.h"
+
+#ifdef OMZ_KERNELS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace kernels {
+namespace {
+
+struct KernelTable {
+    Isa isa;
+    int (*collectAboveThreshold)(const float*, int, float, int*);
+    void (*updateArgMax)(const float*, int, uint8_t, float*, uint8_t*);
+    void (*convertHalfToFloat)(const uint16_t*, int, float*);
+};
+
+#define KERNEL_TABLE(isaId, isa) {Isa::isaId, isa::collectAboveThreshold, isa::updateArgMax, isa::convertHalfToFloat}
+
+const KernelTable tables[] = {
+    KERNEL_TABLE(Scalar, scalar),
+#ifdef OMZ_KERNELS_X86
+    KERNEL_TABLE(SSE42, sse42),
+    KERNEL_TABLE(AVX2, avx2),
+    KERNEL_TABLE(AVX512, avx512),
+#endif
+#ifdef OMZ_KERNELS_NEON
+    KERNEL_TABLE(NEON, neon),
+#endif
+};
+
+#undef KERNEL_TABLE
+
+#ifdef OMZ_KERNELS_X86
+void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+    int intRegs[4];
+    __cpuidex(intRegs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<unsigned>(intRegs[i]);
+    }
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3])) {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    }
+#endif
+}
+
+// The register states the OS saves on context switches
+unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+Isa probeCpu() {
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+    cpuid(1, 0, regs);
+    const bool sse42 = (regs[2] >> 20) & 1;
+    const bool osxsave = (regs[2] >> 27) & 1;
+    const bool avx = (regs[2] >> 28) & 1;
+    const bool fma = (regs[2] >> 12) & 1;
+    const bool f16c = (regs[2] >> 29) & 1;
+    if (!sse42) {
+        return Isa::Scalar;
+    }
+    const unsigned long long xcr0 = osxsave ? xgetbv0() : 0;
+    // XMM and YMM states; opmask, upper ZMM and high ZMM states
+    const bool osAvx = (xcr0 & 0x6) == 0x6;
+    const bool osAvx512 = osAvx && (xcr0 & 0xE0) == 0xE0;
+    if (maxLeaf < 7 || !avx || !osAvx) {
+        return Isa::SSE42;
+    }
+    cpuid(7, 0, regs);
+    const bool avx2 = (regs[1] >> 5) & 1;
+    const bool avx512f = (regs[1] >> 16) & 1, avx512bw = (regs[1] >> 30) & 1, avx512vl = (regs[1] >> 31) & 1;
+    if (!avx2 || !fma || !f16c) {
+        return Isa::SSE42;
+    }
+    return osAvx512 && avx512f && avx512bw && avx512vl ? Isa::AVX512 : Isa::AVX2;
+}
+#elif defined(OMZ_KERNELS_NEON)
+// The NEON kernels are only compiled for the targets where NEON is mandatory
+Isa probeCpu() { return Isa::NEON; }
+#else
+Isa probeCpu() { return Isa::Scalar; }
+#endif
+
+// The table of isa or of the widest set below it which the CPU supports
+const KernelTable* findTable(Isa isa) {
+    const Isa detected = detectIsa();
+    const KernelTable* found = &tables[0];
+    for (const KernelTable& table : tables) {
+        const bool isSupported = detected == Isa::NEON ? table.isa == Isa::NEON : table.isa <= detected;
+        if (isSupported && table.isa <= isa) {
+            found = &table;
+        }
+    }
+    return found;
+}
+
+const KernelTable* initialTable() {
+    const char* isaVar = std::getenv("OMZ_DEMO_ISA");
+    if (isaVar) {
+        for (const KernelTable& table : tables) {
+            if (std::strcmp(isaVar, isaName(table.isa)) == 0) {
+                return findTable(table.isa);
+            }
+        }
+    }
+    return findTable(detectIsa());
+}
+
+std::atomic<const KernelTable*>& activeTable() {
+    static std::atomic<const KernelTable*> table(initialTable());
+    return table;
+}
+
+const KernelTable& kernelTable() {
+    return *activeTable().load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::SSE42: return "sse4.2";
+    case Isa::AVX2: return "avx2";
+    case Isa::AVX512: return "avx512";
+    case Isa::NEON: return "neon";
+    default: return "scalar";
+    }
+}
+
+Isa detectIsa() {
+    static const Isa detected = probeCpu();
+    return detected;
+}
+
+Isa activeIsa() {
+    return kernelTable().isa;
+}
+
+Isa setIsa(Isa isa) {
+    const KernelTable* table = findTable(isa);
+    activeTable().store(table, std::memory_order_relaxed);
+    return table->isa;
+}
+
+int collectAboveThreshold(const float* data, int size, float threshold, int* indices) {
+    return kernelTable().collectAboveThreshold(data, size, threshold, indices);
+}
+
+void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds) {
+    kernelTable().updateArgMax(values, size, classId, maxValues, classIds);
+}
+
+void convertHalfToFloat(const uint16_t* src, int size, float* dst) {
+    kernelTable().convertHalfToFloat(src, size, dst);
+}
+
+float halfToFloat(uint16_t value) {
+    return scalar::halfToFloat(value);
+}
+
+}  // namespace kernels
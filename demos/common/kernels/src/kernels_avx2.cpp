@@ -0,0 +1,70 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace kernels {
+namespace avx2 {
+
+int collectAboveThreshold(const float* data, int size, float threshold, int* indices) {
+    int count = 0;
+    int i = 0;
+    const __m256 thresholdVec = _mm256_set1_ps(threshold);
+    for (; i + 8 <= size; i += 8) {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + i), thresholdVec, _CMP_GE_OQ));
+        for (int k = 0; mask != 0; ++k, mask >>= 1) {
+            if (mask & 1)
+                indices[count++] = i + k;
+        }
+    }
+    for (; i < size; ++i) {
+        if (data[i] >= threshold)
+            indices[count++] = i;
+    }
+    _mm256_zeroupper();
+    return count;
+}
+
+void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds) {
+    int i = 0;
+    const __m128i classIdVec = _mm_set1_epi8(static_cast<char>(classId));
+    for (; i + 16 <= size; i += 16) {
+        const __m256 values0 = _mm256_loadu_ps(values + i), values1 = _mm256_loadu_ps(values + i + 8);
+        const __m256 max0 = _mm256_loadu_ps(maxValues + i), max1 = _mm256_loadu_ps(maxValues + i + 8);
+        const __m256 greater0 = _mm256_cmp_ps(values0, max0, _CMP_GT_OQ);
+        const __m256 greater1 = _mm256_cmp_ps(values1, max1, _CMP_GT_OQ);
+        _mm256_storeu_ps(maxValues + i, _mm256_blendv_ps(max0, values0, greater0));
+        _mm256_storeu_ps(maxValues + i + 8, _mm256_blendv_ps(max1, values1, greater1));
+        // 16 masks of 32 bits are narrowed to 16 masks of a byte. The packing works within 128-bit lanes,
+        // so the 64-bit quarters are put back in order before the second packing
+        const __m256i greaterWords = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(_mm256_castps_si256(greater0), _mm256_castps_si256(greater1)), 0xD8);
+        const __m128i greaterBytes = _mm_packs_epi16(_mm256_castsi256_si128(greaterWords),
+                                                     _mm256_extracti128_si256(greaterWords, 1));
+        const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(classIds + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(classIds + i), _mm_blendv_epi8(ids, classIdVec, greaterBytes));
+    }
+    for (; i < size; ++i) {
+        const bool isGreater = values[i] > maxValues[i];
+        maxValues[i] = isGreater ? values[i] : maxValues[i];
+        classIds[i] = isGreater ? classId : classIds[i];
+    }
+    _mm256_zeroupper();
+}
+
+void convertHalfToFloat(const uint16_t* src, int size, float* dst) {
+    int i = 0;
+    for (; i + 8 <= size; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+    }
+    for (; i < size; ++i) {
+        dst[i] = scalar::halfToFloat(src[i]);
+    }
+    _mm256_zeroupper();
+}
+
+}  // namespace avx2
+}  // namespace kernels
@@ -0,0 +1,66 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace kernels {
+namespace avx512 {
+
+int collectAboveThreshold(const float* data, int size, float threshold, int* indices) {
+    int count = 0;
+    int i = 0;
+    const __m512 thresholdVec = _mm512_set1_ps(threshold);
+    for (; i + 16 <= size; i += 16) {
+        unsigned mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(data + i), thresholdVec, _CMP_GE_OQ);
+        for (int k = 0; mask != 0; ++k, mask >>= 1) {
+            if (mask & 1)
+                indices[count++] = i + k;
+        }
+    }
+    if (i < size) {
+        const __mmask16 tail = static_cast<__mmask16>((1u << (size - i)) - 1);
+        unsigned mask = _mm512_mask_cmp_ps_mask(tail, _mm512_maskz_loadu_ps(tail, data + i), thresholdVec, _CMP_GE_OQ);
+        for (int k = 0; mask != 0; ++k, mask >>= 1) {
+            if (mask & 1)
+                indices[count++] = i + k;
+        }
+    }
+    _mm256_zeroupper();
+    return count;
+}
+
+void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds) {
+    const __m128i classIdVec = _mm_set1_epi8(static_cast<char>(classId));
+    for (int i = 0; i < size; i += 16) {
+        // the tail is processed with the lanes past size masked out
+        const __mmask16 lanes = size - i >= 16 ? 0xFFFF : static_cast<__mmask16>((1u << (size - i)) - 1);
+        const __m512 valuesVec = _mm512_maskz_loadu_ps(lanes, values + i);
+        const __mmask16 greater = _mm512_mask_cmp_ps_mask(lanes, valuesVec,
+                                                          _mm512_maskz_loadu_ps(lanes, maxValues + i), _CMP_GT_OQ);
+        _mm512_mask_storeu_ps(maxValues + i, greater, valuesVec);
+        _mm_mask_storeu_epi8(classIds + i, greater, classIdVec);
+    }
+    _mm256_zeroupper();
+}
+
+void convertHalfToFloat(const uint16_t* src, int size, float* dst) {
+    // _mm512_cvtph_ps is implemented in GCC as a masked conversion with an undefined source,
+    // which GCC 12 reports with -Wmaybe-uninitialized, the zero-masking form has no such source
+    int i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m256i half = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm512_storeu_ps(dst + i, _mm512_maskz_cvtph_ps(0xFFFF, half));
+    }
+    if (i < size) {
+        const __mmask16 tail = static_cast<__mmask16>((1u << (size - i)) - 1);
+        const __m256i half = _mm256_maskz_loadu_epi16(tail, src + i);
+        _mm512_mask_storeu_ps(dst + i, tail, _mm512_maskz_cvtph_ps(tail, half));
+    }
+    _mm256_zeroupper();
+}
+
+}  // namespace avx512
+}  // namespace kernels
@@ -0,0 +1,37 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstdint>
+
+// Every kernels_<isa>.cpp is compiled with the flags of its instruction set. They must not use inline functions
+// or templates of other headers (e.g. std::vector), the linker could pick the copy of such a function compiled
+// for a wider set than the CPU supports.
+#define DECLARE_KERNELS(isa)                                                                                           \
+    namespace isa {                                                                                                    \
+    int collectAboveThreshold(const float* data, int size, float threshold, int* indices);                            \
+    void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds);           \
+    void convertHalfToFloat(const uint16_t* src, int size, float* dst);                                              \
+    }
+
+namespace kernels {
+
+DECLARE_KERNELS(scalar)
+// Converts the tails of the vectorized loops
+namespace scalar {
+float halfToFloat(uint16_t value);
+}
+#ifdef OMZ_KERNELS_X86
+DECLARE_KERNELS(sse42)
+DECLARE_KERNELS(avx2)
+DECLARE_KERNELS(avx512)
+#endif
+#ifdef OMZ_KERNELS_NEON
+DECLARE_KERNELS(neon)
+#endif
+
+}  // namespace kernels
+
+#undef DECLARE_KERNELS
@@ -0,0 +1,63 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "kernels_impl.h"
+
+#include <arm_neon.h>
+
+namespace kernels {
+namespace neon {
+
+int collectAboveThreshold(const float* data, int size, float threshold, int* indices) {
+    int count = 0;
+    int i = 0;
+    const float32x4_t thresholdVec = vdupq_n_f32(threshold);
+    for (; i + 4 <= size; i += 4) {
+        uint32x4_t mask = vcgeq_f32(vld1q_f32(data + i), thresholdVec);
+        uint32x2_t halvesMask = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+        if (vget_lane_u32(vpmax_u32(halvesMask, halvesMask), 0)) {
+            for (int k = 0; k < 4; ++k) {
+                if (data[i + k] >= threshold)
+                    indices[count++] = i + k;
+            }
+        }
+    }
+    for (; i < size; ++i) {
+        if (data[i] >= threshold)
+            indices[count++] = i;
+    }
+    return count;
+}
+
+void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds) {
+    int i = 0;
+    const uint8x8_t classIdVec = vdup_n_u8(classId);
+    for (; i + 8 <= size; i += 8) {
+        const float32x4_t values0 = vld1q_f32(values + i), values1 = vld1q_f32(values + i + 4);
+        const float32x4_t max0 = vld1q_f32(maxValues + i), max1 = vld1q_f32(maxValues + i + 4);
+        const uint32x4_t greater0 = vcgtq_f32(values0, max0), greater1 = vcgtq_f32(values1, max1);
+        vst1q_f32(maxValues + i, vbslq_f32(greater0, values0, max0));
+        vst1q_f32(maxValues + i + 4, vbslq_f32(greater1, values1, max1));
+        const uint8x8_t greaterBytes = vmovn_u16(vcombine_u16(vmovn_u32(greater0), vmovn_u32(greater1)));
+        vst1_u8(classIds + i, vbsl_u8(greaterBytes, classIdVec, vld1_u8(classIds + i)));
+    }
+    for (; i < size; ++i) {
+        const bool isGreater = values[i] > maxValues[i];
+        maxValues[i] = isGreater ? values[i] : maxValues[i];
+        classIds[i] = isGreater ? classId : classIds[i];
+    }
+}
+
+void convertHalfToFloat(const uint16_t* src, int size, float* dst) {
+    int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+    for (; i < size; ++i) {
+        dst[i] = scalar::halfToFloat(src[i]);
+    }
+}
+
+}  // namespace neon
+}  // namespace kernels
@@ -0,0 +1,57 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "kernels_impl.h"
+
+#include <cstring>
+
+namespace kernels {
+namespace scalar {
+
+int collectAboveThreshold(const float* data, int size, float threshold, int* indices) {
+    int count = 0;
+    for (int i = 0; i < size; ++i) {
+        if (data[i] >= threshold)
+            indices[count++] = i;
+    }
+    return count;
+}
+
+void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds) {
+    for (int i = 0; i < size; ++i) {
+        const bool isGreater = values[i] > maxValues[i];
+        maxValues[i] = isGreater ? values[i] : maxValues[i];
+        classIds[i] = isGreater ? classId : classIds[i];
+    }
+}
+
+float halfToFloat(uint16_t value) {
+    // The exponent is rebiased from 15 to 127, the mantissa is widened from 10 to 23 bits
+    uint32_t bits = static_cast<uint32_t>(value & 0x7FFF) << 13;
+    const uint32_t exponent = bits & 0x0F800000;
+    bits += 0x38000000;
+    if (exponent == 0x0F800000) {  // Inf or NaN, NaNs are quieted as F16C does
+        bits += 0x38000000;
+        bits |= (value & 0x03FF) ? 0x00400000 : 0;
+    } else if (exponent == 0) {  // zero or subnormal, normalized by the FPU
+        bits += 0x00800000;
+        float normalized;
+        std::memcpy(&normalized, &bits, sizeof(normalized));
+        normalized -= 6.103515625e-05f;  // 2^-14
+        std::memcpy(&bits, &normalized, sizeof(bits));
+    }
+    bits |= static_cast<uint32_t>(value & 0x8000) << 16;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void convertHalfToFloat(const uint16_t* src, int size, float* dst) {
+    for (int i = 0; i < size; ++i) {
+        dst[i] = halfToFloat(src[i]);
+    }
+}
+
+}  // namespace scalar
+}  // namespace kernels
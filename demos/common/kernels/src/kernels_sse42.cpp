@@ -0,0 +1,80 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "kernels_impl.h"
+
+#include <nmmintrin.h>
+
+namespace kernels {
+namespace sse42 {
+
+int collectAboveThreshold(const float* data, int size, float threshold, int* indices) {
+    int count = 0;
+    int i = 0;
+    const __m128 thresholdVec = _mm_set1_ps(threshold);
+    for (; i + 4 <= size; i += 4) {
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(data + i), thresholdVec));
+        for (int k = 0; mask != 0; ++k, mask >>= 1) {
+            if (mask & 1)
+                indices[count++] = i + k;
+        }
+    }
+    for (; i < size; ++i) {
+        if (data[i] >= threshold)
+            indices[count++] = i;
+    }
+    return count;
+}
+
+void updateArgMax(const float* values, int size, uint8_t classId, float* maxValues, uint8_t* classIds) {
+    int i = 0;
+    const __m128i classIdVec = _mm_set1_epi8(static_cast<char>(classId));
+    for (; i + 8 <= size; i += 8) {
+        const __m128 values0 = _mm_loadu_ps(values + i), values1 = _mm_loadu_ps(values + i + 4);
+        const __m128 max0 = _mm_loadu_ps(maxValues + i), max1 = _mm_loadu_ps(maxValues + i + 4);
+        const __m128 greater0 = _mm_cmpgt_ps(values0, max0), greater1 = _mm_cmpgt_ps(values1, max1);
+        _mm_storeu_ps(maxValues + i, _mm_blendv_ps(max0, values0, greater0));
+        _mm_storeu_ps(maxValues + i + 4, _mm_blendv_ps(max1, values1, greater1));
+        // 8 masks of 32 bits are narrowed to 8 masks of a byte
+        const __m128i greaterWords = _mm_packs_epi32(_mm_castps_si128(greater0), _mm_castps_si128(greater1));
+        const __m128i greaterBytes = _mm_packs_epi16(greaterWords, greaterWords);
+        const __m128i ids = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(classIds + i));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(classIds + i), _mm_blendv_epi8(ids, classIdVec, greaterBytes));
+    }
+    for (; i < size; ++i) {
+        const bool isGreater = values[i] > maxValues[i];
+        maxValues[i] = isGreater ? values[i] : maxValues[i];
+        classIds[i] = isGreater ? classId : classIds[i];
+    }
+}
+
+// SSE4.2 CPUs may lack F16C, so the bits are converted as in scalar::halfToFloat()
+void convertHalfToFloat(const uint16_t* src, int size, float* dst) {
+    int i = 0;
+    const __m128i magnitudeMask = _mm_set1_epi32(0x7FFF), signMask = _mm_set1_epi32(0x8000);
+    const __m128i exponentMask = _mm_set1_epi32(0x0F800000), rebias = _mm_set1_epi32(0x38000000);
+    const __m128i subnormalBias = _mm_set1_epi32(0x00800000), maxInf = _mm_set1_epi32(0x7C00);
+    const __m128i quietBit = _mm_set1_epi32(0x00400000);
+    const __m128 minNormal = _mm_set1_ps(6.103515625e-05f);
+    for (; i + 4 <= size; i += 4) {
+        const __m128i half = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+        const __m128i halfMagnitude = _mm_and_si128(half, magnitudeMask);
+        __m128i bits = _mm_slli_epi32(halfMagnitude, 13);
+        const __m128i exponent = _mm_and_si128(bits, exponentMask);
+        bits = _mm_add_epi32(bits, rebias);
+        bits = _mm_add_epi32(bits, _mm_and_si128(_mm_cmpeq_epi32(exponent, exponentMask), rebias));
+        bits = _mm_or_si128(bits, _mm_and_si128(_mm_cmpgt_epi32(halfMagnitude, maxInf), quietBit));
+        const __m128 subnormal = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, subnormalBias)), minNormal);
+        const __m128 isSubnormal = _mm_castsi128_ps(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()));
+        const __m128 magnitude = _mm_blendv_ps(_mm_castsi128_ps(bits), subnormal, isSubnormal);
+        const __m128i sign = _mm_slli_epi32(_mm_and_si128(half, signMask), 16);
+        _mm_storeu_ps(dst + i, _mm_or_ps(magnitude, _mm_castsi128_ps(sign)));
+    }
+    for (; i < size; ++i) {
+        dst[i] = scalar::halfToFloat(src[i]);
+    }
+}
+
+}  // namespace sse42
+}  // namespace kernels
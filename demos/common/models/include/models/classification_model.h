@@ -0,0 +1,50 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#pragma once
+#include "models/model_base.h"
+#include "models/results_pool.h"
+#include "opencv2/core.hpp"
+
+class ClassificationModel : public ModelBase {
+public:
+    /// Constructor
+    /// @param modelFileName name of model to load
+    /// @param nTop - number of classes with the highest scores returned for every image
+    ClassificationModel(const std::string& modelFileName, size_t nTop);
+
+    virtual std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
+    /// Central square of the image is cropped and resized into batchIndex-th slot of the input blob.
+    /// inputData should be ImageInputData or ImageFileInputData.
+    virtual std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) override;
+    virtual std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+
+    virtual void recycleResult(std::unique_ptr<ResultBase>&& result) override { resultsPool.release(std::move(result)); }
+
+    /// Returns number of classes the network scores. It's valid after the network is loaded.
+    size_t getNumClasses() const { return numClasses; }
+
+protected:
+    virtual void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
+
+    size_t nTop;
+    size_t numClasses = 0;
+    /// If true, the outputs are the scores and the indices of nTop classes selected by the device
+    bool topClassesOnDevice = false;
+    /// Recycled results keep their topClasses buffers, so postprocessing doesn't allocate memory
+    ResultsPool<ClassificationResult> resultsPool;
+};
@@ -14,7 +14,10 @@
 // limitations under the License.
 */
 #pragma once
+#include <string>
+#include <vector>
 #include "models/model_base.h"
+#include "models/results_pool.h"
 #include "opencv2/core.hpp"
 
 class DetectionModel : public ModelBase {
@@ -30,11 +33,19 @@ public:
     DetectionModel(const std::string& modelFileName, float confidenceThreshold, bool useAutoResize, const std::vector<std::string>& labels);
 
     virtual std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
+    virtual std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) override;
+
+    virtual void recycleResult(std::unique_ptr<ResultBase>&& result) override { resultsPool.release(std::move(result)); }
 
     static std::vector<std::string> loadLabels(const std::string& labelFilename);
 
+    /// Returns the size of the network input, it's known after the network is loaded by the pipeline
+    cv::Size getInputSize() const { return cv::Size(static_cast<int>(netInputWidth), static_cast<int>(netInputHeight)); }
+
 protected:
+    /// Label of every class, postprocessing only reads it (see fillDefaultLabels)
     std::vector<std::string> labels;
+    ResultsPool<DetectionResult> resultsPool;
 
     size_t netInputHeight = 0;
     size_t netInputWidth = 0;
@@ -42,5 +53,16 @@ protected:
     bool useAutoResize;
     float confidenceThreshold;
 
-    std::string getLabelName(int labelID) { return (size_t)labelID < labels.size() ? labels[labelID] : std::string("Label #") + std::to_string(labelID); }
+    /// Appends default "Label #N" names for the classes without labels. Should be called from prepareInputsOutputs,
+    /// when the number of classes is known, as the labels are read by postprocessing running in several threads.
+    void fillDefaultLabels(size_t classesCount) {
+        while (labels.size() < classesCount) {
+            labels.push_back(std::string("Label #") + std::to_string(labels.size()));
+        }
+    }
+
+    /// Returns pointer to the label name owned by the model, or nullptr if labelID isn't a class of the model
+    const std::string* getLabelName(int labelID) const {
+        return labelID >= 0 && static_cast<size_t>(labelID) < labels.size() ? &labels[labelID] : nullptr;
+    }
 };
@@ -26,15 +26,21 @@ public:
     /// Otherwise, image will be preprocessed and resized using OpenCV routines.
     /// @param labels - array of labels for every class. If this array is empty or contains less elements
     /// than actual classes number, default "Label #N" will be shown for missing items.
+    /// @param useArraysResult - if true, postprocess returns DetectionArraysResult instead of DetectionResult
     ModelSSD(const std::string& modelFileName,
         float confidenceThreshold, bool useAutoResize,
-        const std::vector<std::string>& labels = std::vector<std::string>());
+        const std::vector<std::string>& labels = std::vector<std::string>(),
+        bool useArraysResult = false);
 
-    std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request);
+    std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) override;
     virtual std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
 
+    virtual void recycleResult(std::unique_ptr<ResultBase>&& result) override;
+
 protected:
     virtual void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
     size_t maxProposalCount = 0;
     size_t objectSize = 0;
+    bool useArraysResult;
+    ResultsPool<DetectionArraysResult> arraysResultsPool;
 };
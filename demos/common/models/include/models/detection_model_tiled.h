@@ -0,0 +1,83 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "detection_model.h"
+#include "nms.h"
+
+/// This is class detecting objects on overlapping tiles of the frame, so small objects of high resolution frames
+/// aren't lost when the frame is resized to the network input. All tiles of a frame are inferred as one batch
+/// of a request, the network is reshaped to the number of tiles. Detections of the tiles are moved to the frame
+/// coordinates and merged with NMS.
+class TiledDetectionModel : public ModelBase {
+public:
+    /// Constructor
+    /// @param model - model detecting objects on every tile. Its postprocess should return DetectionResult,
+    /// and it shouldn't use auto-resize, as the tiles are put to the slots of a batch.
+    /// @param grid - number of tile columns and rows
+    /// @param overlap - part of the tile size overlapped by the neighbouring tile
+    /// @param addFullFrame - if true, the whole frame is detected as one more tile. Objects cut by the border of
+    /// a tile are left for the neighbouring tile or the full frame then, so big objects aren't split.
+    /// @param iouThreshold - minimal intersection over union of the boxes of the same class detected
+    /// on different tiles to merge them
+    TiledDetectionModel(std::unique_ptr<DetectionModel>&& model, const cv::Size& grid, float overlap = 0.25f,
+        bool addFullFrame = true, float iouThreshold = 0.5f);
+
+    std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
+    std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+
+    void recycleResult(std::unique_ptr<ResultBase>&& result) override { resultsPool.release(std::move(result)); }
+    void onLoadCompleted(InferenceEngine::ExecutableNetwork* execNetwork, const std::vector<InferenceEngine::InferRequest::Ptr>& requests) override;
+
+    /// Returns rectangles of the tiles of the frame of the given size, the full frame goes first if it's added
+    std::vector<cv::Rect> getTiles(const cv::Size& frameSize) const;
+
+protected:
+    struct TiledModelData : public InternalImageModelData {
+        TiledModelData(int width, int height) : InternalImageModelData(width, height) {}
+
+        std::vector<cv::Rect> tiles;
+        /// Data returned by preprocessing of the wrapped model for every tile
+        std::vector<std::shared_ptr<InternalModelData>> tilesData;
+    };
+
+    /// Buffers of the merging. Every thread postprocessing frames at once uses its own buffers.
+    struct MergingBuffers {
+        MergingBuffers(const NonMaxSuppression& nms) : nms(nms) {}
+
+        std::vector<DetectedObject> objects;
+        NonMaxSuppression nms;
+    };
+
+    void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
+
+    std::unique_ptr<MergingBuffers> acquireBuffers();
+    void releaseBuffers(std::unique_ptr<MergingBuffers>&& buffers);
+
+    std::unique_ptr<DetectionModel> model;
+    cv::Size grid;
+    float overlap;
+    bool addFullFrame;
+    ResultsPool<DetectionResult> resultsPool;
+
+    /// Prototype of NMS objects of the merging buffers
+    NonMaxSuppression nms;
+    std::mutex buffersMtx;
+    std::vector<std::unique_ptr<MergingBuffers>> freeBuffers;
+};
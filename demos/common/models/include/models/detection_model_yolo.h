@@ -15,7 +15,10 @@
 */
 
 #pragma once
+#include <map>
+#include <mutex>
 #include "detection_model.h"
+#include "nms.h"
 
 namespace ngraph {
     namespace op {
@@ -56,17 +59,59 @@ public:
 
     std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
 
+    /// Reads parameters of the network needed for postprocessing: input size and RegionYolo parameters of the outputs.
+    /// Called by prepareInputsOutputs. Code inferring the network without AsyncPipeline (e.g. IEGraph of multi-channel
+    /// demos) calls it directly to use detectBatch.
+    void initPostprocessing(InferenceEngine::CNNNetwork& cnnNetwork);
+
+    /// Parses outputs of all images of the batch and filters detections of every image with NMS.
+    /// Images are processed in parallel. Model's state isn't changed, so it's safe to call it from several threads.
+    /// Label names aren't set.
+    /// @param outputs - output blobs of the request by output names
+    /// @param imageSize - size of the images, boxes are scaled to it
+    /// @param objects - detections of every image are written to it, it's resized to the batch size
+    void detectBatch(const std::map<std::string, InferenceEngine::Blob::Ptr>& outputs, const cv::Size& imageSize,
+        std::vector<std::vector<DetectedObject>>& objects);
+
+    /// Returns number of classes the network detects. It's valid after the network is loaded.
+    int getNumClasses() const { return regions.empty() ? 0 : regions.begin()->second.classes; }
+
 protected:
+    /// Buffers of the postprocessing. Every thread postprocessing images at once uses its own buffers.
+    struct ParsingBuffers {
+        ParsingBuffers(const NonMaxSuppression& nms) : nms(nms) {}
+
+        std::vector<int> candidates;
+        std::vector<float> convertedPlane;  // objectness plane of FP16 output converted to float
+        std::vector<DetectedObject> parsedObjects;
+        NonMaxSuppression nms;
+    };
+
     virtual void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
 
-    void parseYOLOV3Output(const std::string& output_name, const InferenceEngine::Blob::Ptr& blob,
+    /// Parses outputs of the batch item and writes detections left after NMS to objects
+    void detectBatchItem(const std::map<std::string, InferenceEngine::Blob::Ptr>& outputs, size_t batchIndex,
+        const cv::Size& imageSize, ParsingBuffers& buffers, std::vector<DetectedObject>& objects) const;
+
+    void parseYOLOV3Output(const std::string& output_name, const InferenceEngine::Blob::Ptr& blob, size_t batchIndex,
         const unsigned long resized_im_h, const unsigned long resized_im_w, const unsigned long original_im_h,
-        const unsigned long original_im_w, std::vector<DetectedObject>& objects);
+        const unsigned long original_im_w, std::vector<int>& candidates, std::vector<float>& convertedPlane,
+        std::vector<DetectedObject>& objects) const;
 
+    /// Puts indices of values which are not less than threshold to the list. Uses the SIMD kernels the CPU supports.
+    static void collectCandidates(const float* data, int size, float threshold, std::vector<int>& indices);
     static int calculateEntryIndex(int side, int lcoords, int lclasses, int location, int entry);
-    static double intersectionOverUnion(const DetectedObject& o1, const DetectedObject& o2);
+
+    std::unique_ptr<ParsingBuffers> acquireBuffers();
+    void releaseBuffers(std::unique_ptr<ParsingBuffers>&& buffers);
 
     std::map<std::string, Region> regions;
     double boxIOUThreshold;
     bool useAdvancedPostprocessing;
+    /// Prototype of NMS objects of the parsing buffers
+    NonMaxSuppression nms;
+
+    std::mutex buffersMtx;
+    /// Buffers released by finished postprocessing, so they aren't allocated for every frame
+    std::vector<std::unique_ptr<ParsingBuffers>> freeBuffers;
 };
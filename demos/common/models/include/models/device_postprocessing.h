@@ -0,0 +1,37 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <inference_engine.hpp>
+
+/// Outputs of the network ending with TopK appended by appendTopK
+struct TopKOutputs {
+    /// Name of the output with the k largest values, empty if they aren't kept
+    std::string valuesName;
+    /// Name of the I32 output with the indices of the k largest values
+    std::string indicesName;
+};
+
+/// Replaces the network with a copy whose only output passes through TopK (mode max, sorted by values) over axis,
+/// optionally after SoftMax over the same axis, so the device returns k elements of the axis instead of all of them.
+/// The network should have a single output and be reshaped to the final batch. Input and output settings of
+/// the network are lost, so they should be made after that.
+/// @param keepValues - if false, the network returns only the indices
+TopKOutputs appendTopK(InferenceEngine::CNNNetwork& cnnNetwork, size_t k, int64_t axis, bool applySoftmax,
+    bool keepValues);
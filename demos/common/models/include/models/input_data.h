@@ -15,11 +15,20 @@
 */
 
 #pragma once
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <opencv2/core.hpp>
 
 struct InputData {
     virtual ~InputData() {}
 
+    /// Creates copy of the object to be preprocessed asynchronously. Referenced data (like images) isn't copied,
+    /// so it shouldn't be modified until preprocessing is completed.
+    virtual std::shared_ptr<InputData> clone() const {
+        throw std::logic_error("This input data type doesn't support asynchronous preprocessing");
+    }
+
     template<class T> T& asRef() {
         return dynamic_cast<T&>(*this);
     }
@@ -36,4 +45,44 @@ struct ImageInputData : public InputData {
     ImageInputData(const cv::Mat& img) {
         inputImage = img;
     }
+
+    virtual std::shared_ptr<InputData> clone() const override {
+        return std::make_shared<ImageInputData>(inputImage);
+    }
+};
+
+/// Rotated region of an image, e.g. a line of text. Models taking it warp the region straight from the image
+/// into the input blob, so the region isn't cropped and rotated first.
+struct RotatedRoiInputData : public ImageInputData {
+    cv::RotatedRect roi;
+
+    RotatedRoiInputData() {}
+    RotatedRoiInputData(const cv::Mat& img, const cv::RotatedRect& roi) :
+        ImageInputData(img),
+        roi(roi) {
+    }
+
+    virtual std::shared_ptr<InputData> clone() const override {
+        return std::make_shared<RotatedRoiInputData>(inputImage, roi);
+    }
+};
+
+/// Image to be read from the file by the model's preprocessing. With CnnConfig::preprocessThreads
+/// images are decoded on preprocessing threads, straight before they are put to the input blob,
+/// so only images of the batches being filled are kept in memory.
+struct ImageFileInputData : public InputData {
+    std::string fileName;
+    /// If it isn't null, preprocessing stores the part of the decoded image the model processes here,
+    /// so the image can be shown with the result without decoding it again. The pointer is shared with clones.
+    std::shared_ptr<cv::Mat> decodedImage;
+
+    ImageFileInputData() {}
+    ImageFileInputData(const std::string& fileName, const std::shared_ptr<cv::Mat>& decodedImage = nullptr) :
+        fileName(fileName),
+        decodedImage(decodedImage) {
+    }
+
+    virtual std::shared_ptr<InputData> clone() const override {
+        return std::make_shared<ImageFileInputData>(fileName, decodedImage);
+    }
 };
@@ -0,0 +1,56 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include "models/model_base.h"
+#include "models/results_pool.h"
+#include "opencv2/core.hpp"
+
+/// Mask R-CNN networks created with TensorFlow Object Detection API: DetectionOutput layer gives boxes
+/// and masks layer gives a low resolution mask of every box for every class
+class InstanceSegmentationModel : public ModelBase {
+public:
+    /// Constructor
+    /// @param modelFileName name of model to load
+    /// @param detectionOutputName - name of the DetectionOutput layer (reshaped to 2D), it's added to network outputs
+    /// @param masksName - name of the masks layer
+    /// @param confidenceThreshold - objects with confidence not greater than this threshold are ignored
+    /// @param maskThreshold - mask pixels with probability greater than this threshold belong to the object
+    InstanceSegmentationModel(const std::string& modelFileName, const std::string& detectionOutputName,
+        const std::string& masksName, float confidenceThreshold, float maskThreshold = 0.5f);
+
+    virtual std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
+    virtual std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) override;
+    /// Returns InstanceSegmentationResult with boxes in frame coordinates and run-length encoded masks
+    virtual std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+
+    virtual void recycleResult(std::unique_ptr<ResultBase>&& result) override { resultsPool.release(std::move(result)); }
+
+protected:
+    virtual void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
+
+    std::string detectionOutputName;
+    std::string masksName;
+    float confidenceThreshold;
+    float maskThreshold;
+
+    size_t netInputHeight = 0;
+    size_t netInputWidth = 0;
+    /// Number of elements describing a box in detection output (batch, label, prob, x1, y1, x2, y2)
+    size_t boxDescriptionSize = 0;
+    /// Recycled results keep their objects with mask runs buffers, so postprocessing rarely allocates memory
+    ResultsPool<InstanceSegmentationResult> resultsPool;
+};
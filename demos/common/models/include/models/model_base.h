@@ -15,6 +15,7 @@
 */
 
 #pragma once
+#include <samples/shared_pool.hpp>
 #include "input_data.h"
 #include "results.h"
 
@@ -29,16 +30,42 @@ public:
     virtual void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) = 0;
     virtual std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) = 0;
     virtual std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) = 0;
-        virtual void onLoadCompleted(InferenceEngine::ExecutableNetwork* execNetwork, const std::vector<InferenceEngine::InferRequest::Ptr>& requests) {
+
+    /// Takes back result returned by postprocess, so the model can reuse it for next frames.
+    /// Default implementation just destroys the result.
+    virtual void recycleResult(std::unique_ptr<ResultBase>&& result) { result.reset(); }
+
+    /// Preprocesses input data into batchIndex-th slot of request's input blob(s).
+    /// Models supporting batched inference should override it and process InferenceResult::batchIndex in postprocess.
+    /// Default implementation supports only batchIndex equal to 0.
+    virtual std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
+        if (batchIndex != 0)
+            throw std::logic_error("The model doesn't support batched inference");
+        return preprocess(inputData, request);
+    }
+
+    virtual void onLoadCompleted(InferenceEngine::ExecutableNetwork* execNetwork, const std::vector<InferenceEngine::InferRequest::Ptr>& requests) {
         this->execNetwork = execNetwork; }
     const std::vector<std::string>& getOutputsNames() const { return outputsNames; }
     const std::vector<std::string>& getInputsNames() const { return inputsNames; }
 
     std::string getModelFileName() { return modelFileName; }
 
+    /// Lets the models which can postprocess FP16 outputs request them in FP16, so the devices inferring in FP16
+    /// (GPU, MYRIAD) don't convert the outputs to FP32. Should be called before prepareInputsOutputs.
+    void allowFp16Outputs(bool allow) { fp16OutputsAllowed = allow; }
+
+    /// Lets the models append their first postprocessing steps (see appendTopK) to the network, so the device
+    /// returns compact outputs. Should be called before prepareInputsOutputs.
+    void enableDevicePostprocessing(bool enable) { devicePostprocessing = enable; }
+
 protected:
     std::vector<std::string> inputsNames;
     std::vector<std::string> outputsNames;
     InferenceEngine::ExecutableNetwork* execNetwork;
     std::string modelFileName;
+    bool fp16OutputsAllowed = false;
+    bool devicePostprocessing = false;
+    /// Preprocessing creates InternalImageModelData of the frames from it, reusing the memory of released ones
+    SharedPool<InternalImageModelData> internalImageDataPool;
 };
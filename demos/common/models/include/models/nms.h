@@ -0,0 +1,98 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/// This is class performing non-maximum suppression of boxes
+/// Boxes are stored in structure-of-arrays form. Every class is processed separately (if perClass is true),
+/// and overlapping boxes are searched in a uniform grid of cells sized by the average box,
+/// so suppression takes near-linear time instead of comparing every pair of boxes.
+/// Object keeps its buffers between calls, so it's reasonable to reuse it for every frame.
+class NonMaxSuppression {
+public:
+    enum class Method {
+        /// Box is removed if it overlaps already kept box with higher score (classic greedy NMS)
+        Greedy,
+        /// Box is removed if it overlaps any box with higher score, even removed one
+        Strict,
+        /// Scores of overlapping boxes are multiplied by exp(-IOU^2 / sigma)
+        SoftGaussian,
+        /// Scores of boxes overlapping more than IOU threshold are multiplied by (1 - IOU)
+        SoftLinear
+    };
+
+    /// Constructor
+    /// @param method - suppression algorithm
+    /// @param iouThreshold - minimal intersection over union for the box to be suppressed (not used by SoftGaussian)
+    /// @param perClass - if true, only boxes of the same class suppress each other
+    /// @param scoreThreshold - boxes with (updated) score lower than this value are removed
+    /// @param topK - if non-zero, only topK highest scored boxes of every class are considered
+    /// @param sigma - parameter of SoftGaussian method
+    NonMaxSuppression(Method method, float iouThreshold, bool perClass = true,
+        float scoreThreshold = 0.f, size_t topK = 0, float sigma = 0.5f);
+
+    /// Removes all added boxes
+    void clear();
+    void reserve(size_t count);
+
+    /// Adds box to be processed
+    /// @returns index of the added box
+    size_t add(const cv::Rect2f& box, float score, int classId = 0);
+
+    size_t size() const { return scores.size(); }
+
+    /// Performs suppression of added boxes
+    /// @returns indices of boxes left, sorted by descending score
+    const std::vector<size_t>& apply();
+
+    /// Returns score of the box. For soft methods it's updated score after apply() is called.
+    float getScore(size_t idx) const { return scores[idx]; }
+
+    static float intersectionOverUnion(const cv::Rect2f& box1, const cv::Rect2f& box2);
+
+protected:
+    void applyToBucket(size_t begin, size_t end);
+    void buildGrid(size_t begin, size_t end);
+    void putToGrid(size_t idx);
+    template <typename Visitor> bool visitNeighbours(size_t idx, Visitor visitor);
+    float iou(size_t idx1, size_t idx2) const;
+    float decayedScore(float score, float overlap) const;
+
+    Method method;
+    float iouThreshold;
+    bool perClass;
+    float scoreThreshold;
+    size_t topK;
+    float sigma;
+
+    std::vector<float> x1, y1, x2, y2, areas, scores;
+    std::vector<int> classIds;
+
+    std::vector<size_t> order;
+    std::vector<size_t> kept;
+    std::vector<uint8_t> removed;
+
+    // Grid of the currently processed bucket
+    float gridX = 0, gridY = 0, cellWidth = 1, cellHeight = 1;
+    int gridCols = 1, gridRows = 1;
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<uint32_t> visitStamps;
+    uint32_t currentStamp = 0;
+};
@@ -17,7 +17,10 @@
 #pragma once
 #include <opencv2/core.hpp>
 #include <inference_engine.hpp>
+#include <chrono>
 #include <map>
+#include <string>
+#include <vector>
 //#include "metadata.h"
 #include "internal_model_data.h"
 
@@ -42,6 +45,13 @@ struct ResultBase {
 struct InferenceResult : public ResultBase {
     std::shared_ptr<InternalModelData> internalModelData;
     std::map<std::string, InferenceEngine::MemoryBlob::Ptr> outputsData;
+    /// Lease on the infer request which owns outputsData blobs (if they weren't copied).
+    /// Request is returned to the pool as soon as this pointer is reset.
+    InferenceEngine::InferRequest::Ptr requestLease;
+    /// Index of the frame inside of the batch. outputsData blobs contain data of the whole batch.
+    size_t batchIndex = 0;
+    /// Time when inference of the request was completed
+    std::chrono::steady_clock::time_point completionTime;
 
     /// Returns pointer to first output blob
     /// This function is a useful addition to direct access to outputs list as many models have only one output
@@ -59,14 +69,84 @@ struct InferenceResult : public ResultBase {
 
 struct DetectedObject : public cv::Rect2f {
     unsigned int labelID;
-    std::string label;
+    /// Name of the label. It's owned by the model and stays valid while the model exists.
+    /// It's null if the model has no name for labelID or the name isn't set (see DetectionArraysResult::toObjects).
+    const std::string* label = nullptr;
     float confidence;
+
+    /// @returns name of the label, or default "Label #N" name if it isn't set
+    std::string getLabelName() const { return label ? *label : std::string("Label #") + std::to_string(labelID); }
 };
 
 struct DetectionResult : public ResultBase {
     std::vector<DetectedObject> objects;
 };
 
+/// Detections stored as parallel arrays: i-th elements of the arrays describe i-th object.
+/// Consumers interested in some of the fields (e.g. trackers and ROI classifiers taking boxes only)
+/// read contiguous arrays, and nothing is copied per object. Labels are referenced by ID only.
+struct DetectionArraysResult : public ResultBase {
+    std::vector<cv::Rect2f> boxes;
+    std::vector<float> confidences;
+    std::vector<unsigned int> labelIDs;
+
+    size_t size() const { return boxes.size(); }
+
+    void clear() {
+        boxes.clear();
+        confidences.clear();
+        labelIDs.clear();
+    }
+
+    /// Converts detections to objects for consumers of DetectionResult. Label names aren't set.
+    /// @param objects - the objects are written to it reusing its buffer
+    void toObjects(std::vector<DetectedObject>& objects) const {
+        objects.resize(size());
+        for (size_t i = 0; i < size(); i++) {
+            static_cast<cv::Rect2f&>(objects[i]) = boxes[i];
+            objects[i].labelID = labelIDs[i];
+            objects[i].label = nullptr;
+            objects[i].confidence = confidences[i];
+        }
+    }
+};
+
+struct ClassificationResult : public ResultBase {
+    struct Class {
+        unsigned int id;
+        float score;
+    };
+
+    /// Classes with the highest scores in descending order of score
+    std::vector<Class> topClasses;
+};
+
+struct TextDetectionResult : public ResultBase {
+    /// Boxes of text in the frame coordinates
+    std::vector<cv::RotatedRect> boxes;
+};
+
+struct TextRecognitionResult : public ResultBase {
+    std::string text;
+    /// Probability of the decoded sequence of symbols
+    double confidence = 0;
+};
+
 struct SegmentationResult : public ResultBase {
+    /// Class index of every pixel (CV_8UC1) in network output resolution.
+    /// It isn't resized to the frame size, so renderers can scale it on the fly with nearest-neighbour interpolation.
     cv::Mat mask;
 };
+
+struct SegmentedObject : public DetectedObject {
+    /// Box of the mask: the object's rectangle rounded to whole pixels of the frame
+    cv::Rect maskBox;
+    /// Mask of maskBox in run-length encoding: lengths of alternating runs of background and object pixels
+    /// in row-major order, starting with background. See encodeInstanceMask from samples/instance_masks.hpp.
+    /// It's much smaller than a dense mask and is rendered by blendEncodedInstanceMask without decoding.
+    std::vector<uint32_t> maskRuns;
+};
+
+struct InstanceSegmentationResult : public ResultBase {
+    std::vector<SegmentedObject> objects;
+};
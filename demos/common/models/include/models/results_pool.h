@@ -0,0 +1,64 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <vector>
+#include "results.h"
+
+/// This is class keeping released result objects of type T for reuse,
+/// so their buffers (vectors of objects, masks, etc.) are not allocated again for every frame.
+template <class T>
+class ResultsPool {
+public:
+    /// @param maxSize - maximum number of objects kept in the pool. Extra released objects are destroyed.
+    ResultsPool(size_t maxSize = 16) : maxSize(maxSize) {}
+
+    /// Returns previously released object (with all its buffers) or new one if pool is empty
+    std::unique_ptr<T> acquire() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (freeResults.empty()) {
+            return std::unique_ptr<T>(new T);
+        }
+        std::unique_ptr<T> result = std::move(freeResults.back());
+        freeResults.pop_back();
+        return result;
+    }
+
+    /// Puts object back to the pool. Objects of types other than T are destroyed.
+    void release(std::unique_ptr<ResultBase>&& result) {
+        if (!result || typeid(*result) != typeid(T)) {
+            result.reset();
+            return;
+        }
+        std::unique_ptr<T> typedResult(static_cast<T*>(result.release()));
+        // Metadata may hold the whole frame, it shouldn't be kept alive by the pool
+        typedResult->metaData.reset();
+        typedResult->frameId = -1;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (freeResults.size() < maxSize) {
+            freeResults.push_back(std::move(typedResult));
+        }
+    }
+
+protected:
+    std::mutex mtx;
+    std::vector<std::unique_ptr<T>> freeResults;
+    size_t maxSize;
+};
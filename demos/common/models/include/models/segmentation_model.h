@@ -15,6 +15,7 @@
 */
 
 #include "model_base.h"
+#include "results_pool.h"
 #include "opencv2/core.hpp"
 
 #pragma once
@@ -26,6 +27,7 @@ public:
 
     virtual std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
     virtual std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult);
+    virtual void recycleResult(std::unique_ptr<ResultBase>&& result) override { resultsPool.release(std::move(result)); }
 
 protected:
     virtual void prepareInputsOutputs(InferenceEngine::CNNNetwork & cnnNetwork) override;
@@ -33,4 +35,8 @@ protected:
     int outHeight = 0;
     int outWidth = 0;
     int outChannels = 0;
+    /// True if the model performs ArgMax itself and its output is read as I32 class indices
+    bool isArgMaxOutputI32 = false;
+
+    ResultsPool<SegmentationResult> resultsPool;
 };
@@ -0,0 +1,55 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <string>
+#include "models/model_base.h"
+#include "models/results_pool.h"
+
+/// This is class for text detection models returning TextDetectionResult: PixelLink models finding text rotated
+/// at any angle (text-detection-0003, text-detection-0004) and models finding horizontal text boxes
+/// (horizontal-text-detection-0001). The kind of the model is recognized by its outputs.
+class TextDetectionModel : public ModelBase {
+public:
+    /// Constructor
+    /// @param modelFileName name of model to load
+    /// @param inputSize - size the network input is reshaped to. Empty size keeps the input size of the model.
+    /// @param clsConfThreshold - PixelLink pixels with classification confidence below it aren't text
+    /// @param linkConfThreshold - PixelLink pixels with linkage confidence below it aren't linked
+    /// @param maxBoxes - maximum number of the boxes returned, the largest ones are kept. Negative means no limit.
+    TextDetectionModel(const std::string& modelFileName, const cv::Size& inputSize, float clsConfThreshold,
+        float linkConfThreshold, int maxBoxes = -1);
+
+    /// Resizes the whole image of ImageInputData to the network input
+    std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
+    std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+
+    void recycleResult(std::unique_ptr<ResultBase>&& result) override { resultsPool.release(std::move(result)); }
+
+protected:
+    void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
+
+    cv::Size inputSize;
+    float clsConfThreshold;
+    float linkConfThreshold;
+    int maxBoxes;
+    /// PixelLink outputs: pixel classification and linkage to 8 neighbours
+    std::string clsOutputName;
+    std::string linkOutputName;
+    /// Output of horizontal boxes, it's used if the model isn't PixelLink
+    std::string boxesOutputName;
+    ResultsPool<TextDetectionResult> resultsPool;
+};
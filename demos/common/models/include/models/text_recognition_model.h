@@ -0,0 +1,57 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include "models/model_base.h"
+#include "models/results_pool.h"
+
+/// This is class for text recognition models with CTC output of sequence x batch x symbols shape
+/// (text-recognition-0012, handwritten-score-recognition-0001). Postprocess returns TextRecognitionResult.
+/// Several regions are recognized as one batch if the pipeline's batch size is greater than 1.
+class TextRecognitionModel : public ModelBase {
+public:
+    /// Constructor
+    /// @param modelFileName name of model to load
+    /// @param alphabet - symbols of the network output classes, the last one is the blank symbol of CTC
+    /// @param bandwidth - bandwidth of CTC beam search decoder. 0 means that greedy decoder is used.
+    TextRecognitionModel(const std::string& modelFileName, const std::string& alphabet, int bandwidth = 0);
+
+    std::shared_ptr<InternalModelData> preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) override;
+    /// Region of RotatedRoiInputData is warped straight into batchIndex-th slot of the input blob,
+    /// the whole image is resized for ImageInputData
+    std::shared_ptr<InternalModelData> preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) override;
+    std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+
+    void recycleResult(std::unique_ptr<ResultBase>&& result) override { resultsPool.release(std::move(result)); }
+
+    /// Returns corners of the rectangle in clockwise order starting with the top left corner of its text.
+    /// The text is read from the first corner to the second one.
+    static std::vector<cv::Point2f> orderedCorners(const cv::RotatedRect& rect);
+
+protected:
+    void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
+
+    std::string alphabet;
+    int bandwidth;
+    cv::Size inputSize;
+    size_t sequenceLength = 0;
+    size_t batchSize = 0;
+    /// If true, the outputs are the most probable symbols of the greedy decoding and their probabilities
+    bool symbolsOnDevice = false;
+    ResultsPool<TextRecognitionResult> resultsPool;
+};
@@ -0,0 +1,201 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#include "models/classification_model.h"
+#include "models/device_postprocessing.h"
+#include <algorithm>
+#include <samples/ocv_common.hpp>
+#include <samples/slog.hpp>
+
+using namespace InferenceEngine;
+
+namespace {
+using Class = ClassificationResult::Class;
+
+// Scores are checked against the weakest of the top classes by chunks of this size
+const size_t SCORES_CHUNK_SIZE = 16;
+
+/// Selects nTop classes with the highest scores in a single pass over scores, keeping them in a min-heap.
+/// The result is written to topClasses reusing its buffer.
+void selectTopClasses(const float* scores, size_t numScores, size_t nTop, std::vector<Class>& topClasses) {
+    // Front of the heap is the weakest of the classes selected so far
+    auto isBetter = [](const Class& l, const Class& r) { return l.score > r.score; };
+
+    topClasses.clear();
+    nTop = std::min(nTop, numScores);
+    if (nTop == 0) {
+        return;
+    }
+    for (size_t i = 0; i < nTop; i++) {
+        topClasses.push_back({static_cast<unsigned int>(i), scores[i]});
+    }
+    std::make_heap(topClasses.begin(), topClasses.end(), isBetter);
+
+    for (size_t chunkBegin = nTop; chunkBegin < numScores; chunkBegin += SCORES_CHUNK_SIZE) {
+        const size_t chunkEnd = std::min(chunkBegin + SCORES_CHUNK_SIZE, numScores);
+        // Most chunks don't contain any score beating the weakest selected class.
+        // This branchless check is vectorized by compiler, so such chunks are skipped fast
+        const float threshold = topClasses.front().score;
+        bool hasCandidates = false;
+        for (size_t i = chunkBegin; i < chunkEnd; i++) {
+            hasCandidates |= scores[i] > threshold;
+        }
+        if (!hasCandidates) {
+            continue;
+        }
+
+        for (size_t i = chunkBegin; i < chunkEnd; i++) {
+            if (scores[i] > topClasses.front().score) {
+                std::pop_heap(topClasses.begin(), topClasses.end(), isBetter);
+                topClasses.back() = {static_cast<unsigned int>(i), scores[i]};
+                std::push_heap(topClasses.begin(), topClasses.end(), isBetter);
+            }
+        }
+    }
+
+    // Sorting heap by isBetter puts classes in descending order of score
+    std::sort_heap(topClasses.begin(), topClasses.end(), isBetter);
+}
+}
+
+ClassificationModel::ClassificationModel(const std::string& modelFileName, size_t nTop) :
+    ModelBase(modelFileName),
+    nTop(nTop) {
+    if (nTop == 0) {
+        throw std::invalid_argument("Number of top classes must be greater than 0");
+    }
+}
+
+void ClassificationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
+    // The device selects the top classes, so it returns nTop scores and class indices of every image
+    TopKOutputs topKOutputs;
+    if (devicePostprocessing && cnnNetwork.getOutputsInfo().size() == 1) {
+        const SizeVector& scoresDims = cnnNetwork.getOutputsInfo().begin()->second->getTensorDesc().getDims();
+        if (scoresDims.size() == 2 || (scoresDims.size() == 4 && scoresDims[2] == 1 && scoresDims[3] == 1)) {
+            numClasses = scoresDims[1];
+            topKOutputs = appendTopK(cnnNetwork, std::min(nTop, numClasses), 1, false, true);
+        }
+    }
+
+    // --------------------------- Configure input & output ---------------------------------------------
+    // --------------------------- Prepare input blobs -----------------------------------------------------
+    InputsDataMap inputInfo(cnnNetwork.getInputsInfo());
+    if (inputInfo.size() != 1) {
+        throw std::logic_error("The network should have only one input.");
+    }
+    inputsNames.push_back(inputInfo.begin()->first);
+
+    const SizeVector& inputShape = inputInfo.begin()->second->getTensorDesc().getDims();
+    if (inputShape.size() != 4) {
+        throw std::logic_error("Model input has incorrect number of dimensions. Must be 4.");
+    }
+    if (inputShape[1] != 3) {
+        throw std::logic_error("Model input has incorrect number of color channels."
+                               " Expected 3, got " + std::to_string(inputShape[1]) + ".");
+    }
+    if (inputShape[2] != inputShape[3]) {
+        throw std::logic_error("Model input has incorrect image shape. Must be NxN square."
+                               " Got " + std::to_string(inputShape[2]) +
+                               "x" + std::to_string(inputShape[3]) + ".");
+    }
+
+    inputInfo.begin()->second->setLayout(Layout::NCHW);
+    inputInfo.begin()->second->setPrecision(Precision::U8);
+
+    // --------------------------- Prepare output blobs -----------------------------------------------------
+    const OutputsDataMap& outputsInfo = cnnNetwork.getOutputsInfo();
+    topClassesOnDevice = !topKOutputs.indicesName.empty();
+    if (topClassesOnDevice) {
+        outputsNames.push_back(topKOutputs.valuesName);
+        outputsNames.push_back(topKOutputs.indicesName);
+        outputsInfo.at(topKOutputs.valuesName)->setPrecision(Precision::FP32);
+        return;
+    }
+    if (outputsInfo.size() != 1) {
+        throw std::logic_error("The network should have only one output.");
+    }
+    outputsNames.push_back(outputsInfo.begin()->first);
+
+    Data& data = *outputsInfo.begin()->second;
+    const SizeVector& outputDims = data.getTensorDesc().getDims();
+    if (outputDims.size() != 2 && outputDims.size() != 4) {
+        throw std::logic_error("Incorrect number of dimensions in model output layer. Must be 2 or 4.");
+    }
+    if (outputDims.size() == 4 && (outputDims[2] != 1 || outputDims[3] != 1)) {
+        throw std::logic_error("Incorrect shape of model output layer. Must be BatchSize x NumberOfClasses.");
+    }
+    numClasses = outputDims[1];
+    data.setPrecision(Precision::FP32);
+}
+
+std::shared_ptr<InternalModelData> ClassificationModel::preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) {
+    return preprocessBatchItem(inputData, request, 0);
+}
+
+std::shared_ptr<InternalModelData> ClassificationModel::preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
+    cv::Mat img;
+    auto imageFileData = dynamic_cast<const ImageFileInputData*>(&inputData);
+    if (imageFileData) {
+        img = cv::imread(imageFileData->fileName);
+        if (img.empty()) {
+            throw std::runtime_error("Can't read image " + imageFileData->fileName);
+        }
+    }
+    else {
+        img = inputData.asRef<ImageInputData>().inputImage;
+    }
+
+    // Cropping the square before resizing gives the same picture as resizing the shorter side first,
+    // but only the cropped pixels are resized
+    const int side = std::min(img.cols, img.rows);
+    cv::Mat croppedImg = img(cv::Rect((img.cols - side) / 2, (img.rows - side) / 2, side, side));
+    if (imageFileData && imageFileData->decodedImage) {
+        *imageFileData->decodedImage = croppedImg;
+    }
+
+    Blob::Ptr inputBlob = request->GetBlob(inputsNames[0]);
+    matU8ToBlob<uint8_t>(croppedImg, inputBlob, static_cast<int>(batchIndex));
+
+    return internalImageDataPool.make(img.cols, img.rows);
+}
+
+std::unique_ptr<ResultBase> ClassificationModel::postprocess(InferenceResult& infResult) {
+    auto retVal = resultsPool.acquire();
+    ClassificationResult* result = retVal.get();
+    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+
+    if (topClassesOnDevice) {
+        // The top classes of every image of the batch are already sorted by score
+        const size_t k = std::min(nTop, numClasses);
+        LockedMemory<const void> scoresMapped = infResult.outputsData[outputsNames[0]]->rmap();
+        LockedMemory<const void> idsMapped = infResult.outputsData[outputsNames[1]]->rmap();
+        const float* scores = scoresMapped.as<const float*>() + infResult.batchIndex * k;
+        const int32_t* ids = idsMapped.as<const int32_t*>() + infResult.batchIndex * k;
+        result->topClasses.clear();
+        for (size_t i = 0; i < k; i++) {
+            result->topClasses.push_back({static_cast<unsigned int>(ids[i]), scores[i]});
+        }
+        return std::unique_ptr<ResultBase>(retVal.release());
+    }
+
+    LockedMemory<const void> outputMapped = infResult.getFirstOutputBlob()->rmap();
+    // Output of batched request contains scores for all images of the batch
+    const float* scores = outputMapped.as<const float*>() + infResult.batchIndex * numClasses;
+    selectTopClasses(scores, numClasses, nTop, result->topClasses);
+
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
@@ -22,25 +22,32 @@ using namespace InferenceEngine;
 
 DetectionModel::DetectionModel(const std::string& modelFileName, float confidenceThreshold, bool useAutoResize, const std::vector<std::string>& labels) :
     ModelBase(modelFileName),
-    labels(labels),
+    labels(labels.begin(), labels.end()),
     useAutoResize(useAutoResize),
     confidenceThreshold(confidenceThreshold) {
 }
 
 std::shared_ptr<InternalModelData> DetectionModel::preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) {
+    return preprocessBatchItem(inputData, request, 0);
+}
+
+std::shared_ptr<InternalModelData> DetectionModel::preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
     auto& img = inputData.asRef<ImageInputData>().inputImage;
 
     if (useAutoResize) {
+        if (batchIndex != 0) {
+            throw std::logic_error("Batched inference isn't supported together with auto-resize");
+        }
         /* Just set input blob containing read image. Resize and layout conversionx will be done automatically */
         request->SetBlob(inputsNames[0], wrapMat2Blob(img));
     }
     else {
         /* Resize and copy data from the image to the input blob */
         Blob::Ptr frameBlob = request->GetBlob(inputsNames[0]);
-        matU8ToBlob<uint8_t>(img, frameBlob);
+        matU8ToBlob<uint8_t>(img, frameBlob, static_cast<int>(batchIndex));
     }
 
-    return std::shared_ptr<InternalModelData>(new InternalImageModelData(img.cols, img.rows));
+    return internalImageDataPool.make(img.cols, img.rows);
 }
 
 std::vector<std::string> DetectionModel::loadLabels(const std::string& labelFilename) {
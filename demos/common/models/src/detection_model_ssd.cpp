@@ -15,66 +15,102 @@
 */
 
 #include "models/detection_model_ssd.h"
+#include <algorithm>
 #include <samples/slog.hpp>
 #include <samples/common.hpp>
 #include <ngraph/ngraph.hpp>
 
 using namespace InferenceEngine;
 
+namespace {
+/// Calls onDetection(detection) for the detections of the batch item with confidence greater than the threshold.
+/// DetectionOutput puts detections of all images first, so the walk stops at the first one with negative image ID.
+template <class OnDetection>
+void forEachDetection(const float* detections, size_t maxProposalCount, size_t objectSize,
+                      size_t batchIndex, float confidenceThreshold, OnDetection onDetection) {
+    const float* detectionsEnd = detections + maxProposalCount * objectSize;
+    for (const float* detection = detections; detection != detectionsEnd && detection[0] >= 0; detection += objectSize) {
+        // Output of batched request contains detections for all images of the batch
+        if (static_cast<size_t>(detection[0]) == batchIndex && detection[2] > confidenceThreshold) {
+            onDetection(detection);
+        }
+    }
+}
+}
+
 ModelSSD::ModelSSD(const std::string& modelFileName,
     float confidenceThreshold, bool useAutoResize,
-    const std::vector<std::string>& labels) :
-    DetectionModel(modelFileName, confidenceThreshold, useAutoResize, labels) {
+    const std::vector<std::string>& labels, bool useArraysResult) :
+    DetectionModel(modelFileName, confidenceThreshold, useAutoResize, labels),
+    useArraysResult(useArraysResult) {
 }
 
-std::shared_ptr<InternalModelData> ModelSSD::preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) {
+std::shared_ptr<InternalModelData> ModelSSD::preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
     if (inputsNames.size() > 1) {
         auto blob = request->GetBlob(inputsNames[1]);
+        // Image info is [height, width] followed by the scales (3 or 6 values), the image is resized already
+        const size_t infoSize = blob->getTensorDesc().getDims()[1];
         LockedMemory<void> blobMapped = as<MemoryBlob>(blob)->wmap();
-        auto data = blobMapped.as<float*>();
+        auto data = blobMapped.as<float*>() + batchIndex * infoSize;
         data[0] = static_cast<float>(netInputHeight);
         data[1] = static_cast<float>(netInputWidth);
-        data[2] = 1;
+        std::fill(data + 2, data + infoSize, 1.0f);
     }
 
-    return DetectionModel::preprocess(inputData, request);
+    return DetectionModel::preprocessBatchItem(inputData, request, batchIndex);
 }
 
-    std::unique_ptr<ResultBase> ModelSSD::postprocess(InferenceResult& infResult) {
+std::unique_ptr<ResultBase> ModelSSD::postprocess(InferenceResult& infResult) {
     LockedMemory<const void> outputMapped = infResult.getFirstOutputBlob()->rmap();
     const float *detections = outputMapped.as<float*>();
 
-    DetectionResult* result = new DetectionResult;
-    auto retVal = std::unique_ptr<ResultBase>(result);
-
-    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
-
     const auto& internalData = infResult.internalModelData->asRef<InternalImageModelData>();
+    const float imgWidth = static_cast<float>(internalData.inputImgWidth);
+    const float imgHeight = static_cast<float>(internalData.inputImgHeight);
+    auto getBox = [&](const float* detection) {
+        const float x = detection[3] * imgWidth;
+        const float y = detection[4] * imgHeight;
+        return cv::Rect2f(x, y, detection[5] * imgWidth - x, detection[6] * imgHeight - y);
+    };
+
+    if (useArraysResult) {
+        auto retVal = arraysResultsPool.acquire();
+        DetectionArraysResult* result = retVal.get();
+        *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+        result->clear();
+        forEachDetection(detections, maxProposalCount, objectSize, infResult.batchIndex, confidenceThreshold,
+            [&](const float* detection) {
+                result->boxes.push_back(getBox(detection));
+                result->confidences.push_back(detection[2]);
+                result->labelIDs.push_back(static_cast<unsigned int>(detection[1]));
+            });
+        return std::unique_ptr<ResultBase>(retVal.release());
+    }
 
-    for (size_t i = 0; i < maxProposalCount; i++) {
-        float image_id = detections[i * objectSize + 0];
-        if (image_id < 0) {
-            break;
-        }
-
-        float confidence = detections[i * objectSize + 2];
-        if (confidence > confidenceThreshold) {
+    auto retVal = resultsPool.acquire();
+    DetectionResult* result = retVal.get();
+    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+    result->objects.clear();
+    forEachDetection(detections, maxProposalCount, objectSize, infResult.batchIndex, confidenceThreshold,
+        [&](const float* detection) {
             DetectedObject desc;
-
-            desc.confidence = confidence;
-            desc.labelID = static_cast<int>(detections[i * objectSize + 1]);
+            static_cast<cv::Rect2f&>(desc) = getBox(detection);
+            desc.confidence = detection[2];
+            desc.labelID = static_cast<int>(detection[1]);
             desc.label = getLabelName(desc.labelID);
-            desc.x = detections[i * objectSize + 3] * internalData.inputImgWidth;
-            desc.y = detections[i * objectSize + 4] * internalData.inputImgHeight;
-            desc.width = detections[i * objectSize + 5] * internalData.inputImgWidth - desc.x;
-            desc.height = detections[i * objectSize + 6] * internalData.inputImgHeight - desc.y;
-
-            /** Filtering out objects with confidence < confidence_threshold probability **/
             result->objects.push_back(desc);
-        }
-    }
+        });
 
-    return retVal;
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
+
+void ModelSSD::recycleResult(std::unique_ptr<ResultBase>&& result) {
+    if (dynamic_cast<DetectionArraysResult*>(result.get())) {
+        arraysResultsPool.release(std::move(result));
+    }
+    else {
+        DetectionModel::recycleResult(std::move(result));
+    }
 }
 
 void ModelSSD::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
@@ -154,6 +190,7 @@ void ModelSSD::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
             throw std::logic_error("The number of labels is different from numbers of model classes");
         }
     }
+    fillDefaultLabels(static_cast<size_t>(std::max(num_classes, 0)));
 
     const SizeVector outputDims = output->getTensorDesc().getDims();
 
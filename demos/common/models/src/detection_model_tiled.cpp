@@ -0,0 +1,167 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "models/detection_model_tiled.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <samples/slog.hpp>
+
+namespace {
+/// Returns offsets of count segments of the given length covering [0, size) with the same steps
+std::vector<int> tileOffsets(int size, int length, int count) {
+    std::vector<int> offsets(count, 0);
+    for (int i = 1; i < count; i++) {
+        offsets[i] = static_cast<int>(std::lround(static_cast<double>(size - length) * i / (count - 1)));
+    }
+    return offsets;
+}
+}
+
+TiledDetectionModel::TiledDetectionModel(std::unique_ptr<DetectionModel>&& model, const cv::Size& grid,
+    float overlap, bool addFullFrame, float iouThreshold) :
+    ModelBase(model->getModelFileName()),
+    model(std::move(model)),
+    grid(grid),
+    overlap(overlap),
+    addFullFrame(addFullFrame),
+    nms(NonMaxSuppression::Method::Greedy, iouThreshold) {
+    if (grid.width <= 0 || grid.height <= 0) {
+        throw std::invalid_argument("The number of tile columns and rows should be positive");
+    }
+    if (overlap < 0.f || overlap >= 1.f) {
+        throw std::invalid_argument("Tile overlap should be in [0, 1)");
+    }
+}
+
+void TiledDetectionModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
+    // Every request infers the tiles of one frame, AsyncPipeline has reshaped the network to its batch already
+    const size_t tilesCount = grid.area() + (addFullFrame ? 1 : 0);
+    slog::info << "Batch size is forced to " << tilesCount << " (number of tiles)." << slog::endl;
+    auto shapes = cnnNetwork.getInputShapes();
+    for (auto& shape : shapes) {
+        shape.second[0] = tilesCount;
+    }
+    cnnNetwork.reshape(shapes);
+
+    model->prepareInputsOutputs(cnnNetwork);
+    inputsNames = model->getInputsNames();
+    outputsNames = model->getOutputsNames();
+}
+
+void TiledDetectionModel::onLoadCompleted(InferenceEngine::ExecutableNetwork* execNetwork,
+    const std::vector<InferenceEngine::InferRequest::Ptr>& requests) {
+    ModelBase::onLoadCompleted(execNetwork, requests);
+    model->onLoadCompleted(execNetwork, requests);
+}
+
+std::vector<cv::Rect> TiledDetectionModel::getTiles(const cv::Size& frameSize) const {
+    std::vector<cv::Rect> tiles;
+    if (addFullFrame) {
+        tiles.emplace_back(cv::Point(), frameSize);
+    }
+
+    // Tiles of the same size cover the frame, every tile overlaps the next one by overlap of its size
+    const int tileWidth = std::min(frameSize.width,
+        static_cast<int>(std::ceil(frameSize.width / (grid.width - (grid.width - 1) * overlap))));
+    const int tileHeight = std::min(frameSize.height,
+        static_cast<int>(std::ceil(frameSize.height / (grid.height - (grid.height - 1) * overlap))));
+    const std::vector<int> xs = tileOffsets(frameSize.width, tileWidth, grid.width);
+    const std::vector<int> ys = tileOffsets(frameSize.height, tileHeight, grid.height);
+    for (int y : ys) {
+        for (int x : xs) {
+            tiles.emplace_back(x, y, tileWidth, tileHeight);
+        }
+    }
+    return tiles;
+}
+
+std::shared_ptr<InternalModelData> TiledDetectionModel::preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) {
+    const cv::Mat& img = inputData.asRef<ImageInputData>().inputImage;
+    auto data = std::make_shared<TiledModelData>(img.cols, img.rows);
+    data->tiles = getTiles(img.size());
+    data->tilesData.reserve(data->tiles.size());
+    for (size_t i = 0; i < data->tiles.size(); i++) {
+        // The tile shares the data of the frame, it's resized straight to its slot of the input blob
+        data->tilesData.push_back(model->preprocessBatchItem(ImageInputData(img(data->tiles[i])), request, i));
+    }
+    return data;
+}
+
+std::unique_ptr<ResultBase> TiledDetectionModel::postprocess(InferenceResult& infResult) {
+    auto retVal = resultsPool.acquire();
+    DetectionResult* result = retVal.get();
+    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+
+    // The wrapped model takes the batch index and its own data of the tile from the inference result
+    const std::shared_ptr<InternalModelData> frameData = infResult.internalModelData;
+    const auto& data = frameData->asRef<TiledModelData>();
+    const cv::Rect frameRect(0, 0, data.inputImgWidth, data.inputImgHeight);
+
+    std::unique_ptr<MergingBuffers> buffers = acquireBuffers();
+    std::vector<DetectedObject>& objects = buffers->objects;
+    NonMaxSuppression& merging = buffers->nms;
+    objects.clear();
+    merging.clear();
+    for (size_t i = 0; i < data.tiles.size(); i++) {
+        const cv::Rect& tile = data.tiles[i];
+        const bool isFullFrame = tile == frameRect;
+        infResult.batchIndex = i;
+        infResult.internalModelData = data.tilesData[i];
+        std::unique_ptr<ResultBase> tileResult = model->postprocess(infResult);
+        for (DetectedObject obj : tileResult->asRef<DetectionResult>().objects) {
+            // An object touching the inner border of the tile is likely cut by it. It's detected entirely by the
+            // neighbouring tile if it's smaller than the overlap, and by the full frame otherwise
+            if (addFullFrame && !isFullFrame
+                && ((obj.x <= 0.5f && tile.x > 0) || (obj.y <= 0.5f && tile.y > 0)
+                    || (obj.br().x >= tile.width - 0.5f && tile.br().x < frameRect.width)
+                    || (obj.br().y >= tile.height - 0.5f && tile.br().y < frameRect.height))) {
+                continue;
+            }
+            obj.x += tile.x;
+            obj.y += tile.y;
+            merging.add(obj, obj.confidence, obj.labelID);
+            objects.push_back(obj);
+        }
+        model->recycleResult(std::move(tileResult));
+    }
+    infResult.batchIndex = 0;
+    infResult.internalModelData = frameData;
+
+    result->objects.clear();
+    for (size_t idx : merging.apply()) {
+        result->objects.push_back(objects[idx]);
+    }
+    releaseBuffers(std::move(buffers));
+
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
+
+std::unique_ptr<TiledDetectionModel::MergingBuffers> TiledDetectionModel::acquireBuffers() {
+    std::lock_guard<std::mutex> lock(buffersMtx);
+    if (freeBuffers.empty()) {
+        return std::unique_ptr<MergingBuffers>(new MergingBuffers(nms));
+    }
+    std::unique_ptr<MergingBuffers> buffers = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return buffers;
+}
+
+void TiledDetectionModel::releaseBuffers(std::unique_ptr<MergingBuffers>&& buffers) {
+    std::lock_guard<std::mutex> lock(buffersMtx);
+    freeBuffers.push_back(std::move(buffers));
+}
@@ -18,6 +18,7 @@
 #include <samples/slog.hpp>
 #include <samples/common.hpp>
 #include <ngraph/ngraph.hpp>
+#include <kernels/demo_kernels.h>
 
 using namespace InferenceEngine;
 
@@ -25,7 +26,9 @@ ModelYolo3::ModelYolo3(const std::string& modelFileName, float confidenceThresho
     bool useAdvancedPostprocessing, float boxIOUThreshold, const std::vector<std::string>& labels) :
     DetectionModel(modelFileName, confidenceThreshold, useAutoResize, labels),
     boxIOUThreshold(boxIOUThreshold),
-    useAdvancedPostprocessing(useAdvancedPostprocessing) {
+    useAdvancedPostprocessing(useAdvancedPostprocessing),
+    nms(useAdvancedPostprocessing ? NonMaxSuppression::Method::Strict : NonMaxSuppression::Method::Greedy,
+        boxIOUThreshold, useAdvancedPostprocessing) {
 }
 
 void ModelYolo3::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
@@ -48,20 +51,27 @@ void ModelYolo3::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
         input->getInputData()->setLayout(Layout::NCHW);
     }
 
-    //--- Reading image input parameters
-    const TensorDesc& inputDesc = inputInfo.begin()->second->getTensorDesc();
-    netInputHeight = getTensorHeight(inputDesc);
-    netInputWidth = getTensorWidth(inputDesc);
-
     // --------------------------- Prepare output blobs -----------------------------------------------------
     slog::info << "Checking that the outputs are as the demo expects" << slog::endl;
     OutputsDataMap outputInfo(cnnNetwork.getOutputsInfo());
     for (auto& output : outputInfo) {
-        output.second->setPrecision(Precision::FP32);
+        output.second->setPrecision(fp16OutputsAllowed ? Precision::FP16 : Precision::FP32);
         output.second->setLayout(Layout::NCHW);
         outputsNames.push_back(output.first);
     }
 
+    initPostprocessing(cnnNetwork);
+}
+
+void ModelYolo3::initPostprocessing(InferenceEngine::CNNNetwork& cnnNetwork) {
+    //--- Reading image input parameters
+    const TensorDesc& inputDesc = cnnNetwork.getInputsInfo().begin()->second->getTensorDesc();
+    netInputHeight = getTensorHeight(inputDesc);
+    netInputWidth = getTensorWidth(inputDesc);
+
+    OutputsDataMap outputInfo(cnnNetwork.getOutputsInfo());
+    regions.clear();
+
     if (auto ngraphFunction = (cnnNetwork).getFunction()) {
         for (const auto op : ngraphFunction->get_ops()) {
             auto outputLayer = outputInfo.find(op->get_friendly_name());
@@ -84,60 +94,88 @@ void ModelYolo3::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
         throw std::runtime_error(std::string("The number of labels (") + std::to_string(labels.size()) +
             ") is different from numbers of model classes (" + std::to_string(regions.begin()->second.classes) + ")");
     }
+    fillDefaultLabels(static_cast<size_t>(regions.begin()->second.classes));
 }
 
 std::unique_ptr<ResultBase> ModelYolo3::postprocess(InferenceResult & infResult) {
-    DetectionResult* result = new DetectionResult;
+    auto retVal = resultsPool.acquire();
+    DetectionResult* result = retVal.get();
 
     *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
-    std::vector<DetectedObject> objects;
 
-    // Parsing outputs
     const auto& internalData = infResult.internalModelData->asRef<InternalImageModelData>();
+    std::map<std::string, Blob::Ptr> outputs(infResult.outputsData.begin(), infResult.outputsData.end());
+    std::unique_ptr<ParsingBuffers> buffers = acquireBuffers();
+    detectBatchItem(outputs, infResult.batchIndex, cv::Size(internalData.inputImgWidth, internalData.inputImgHeight),
+        *buffers, result->objects);
+    releaseBuffers(std::move(buffers));
 
-    for (auto& output : infResult.outputsData) {
-        this->parseYOLOV3Output(output.first, output.second, netInputHeight, netInputWidth,
-            internalData.inputImgHeight, internalData.inputImgWidth, objects);
-    }
-
-    if (useAdvancedPostprocessing) {
-        // Advanced postprocessing
-        // Checking IOU threshold conformance
-        // For every i-th object we're finding all objects it intersects with, and comparing confidence
-        // If i-th object has greater confidence than all others, we include it into result
-        for (const auto& obj1 : objects) {
-            bool isGoodResult = true;
-            for (const auto& obj2 : objects) {
-                if (obj1.labelID == obj2.labelID && obj1.confidence < obj2.confidence && intersectionOverUnion(obj1, obj2) >= boxIOUThreshold) { // if obj1 is the same as obj2, condition expression will evaluate to false anyway
-                    isGoodResult = false;
-                    break;
-                }
-            }
-            if (isGoodResult) {
-                result->objects.push_back(obj1);
-            }
-        }
-    } else {
-        // Classic postprocessing
-        std::sort(objects.begin(), objects.end(), [](const DetectedObject& x, const DetectedObject& y) { return x.confidence > y.confidence; });
-        for (size_t i = 0; i < objects.size(); ++i) {
-            if (objects[i].confidence == 0)
-                continue;
-            for (size_t j = i + 1; j < objects.size(); ++j)
-                if (intersectionOverUnion(objects[i], objects[j]) >= boxIOUThreshold)
-                    objects[j].confidence = 0;
-            result->objects.push_back(objects[i]);
+    for (auto& obj : result->objects) {
+        obj.label = getLabelName(obj.labelID);
+    }
+
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
+
+void ModelYolo3::detectBatch(const std::map<std::string, InferenceEngine::Blob::Ptr>& outputs,
+    const cv::Size& imageSize, std::vector<std::vector<DetectedObject>>& objects) {
+    if (outputs.empty()) {
+        throw std::invalid_argument("No outputs to parse");
+    }
+    const int batchSize = static_cast<int>(outputs.begin()->second->getTensorDesc().getDims()[0]);
+    objects.resize(batchSize);
+    cv::parallel_for_(cv::Range(0, batchSize), [&](const cv::Range& range) {
+        std::unique_ptr<ParsingBuffers> buffers = acquireBuffers();
+        for (int i = range.start; i < range.end; i++) {
+            detectBatchItem(outputs, i, imageSize, *buffers, objects[i]);
         }
+        releaseBuffers(std::move(buffers));
+    });
+}
+
+void ModelYolo3::detectBatchItem(const std::map<std::string, InferenceEngine::Blob::Ptr>& outputs, size_t batchIndex,
+    const cv::Size& imageSize, ParsingBuffers& buffers, std::vector<DetectedObject>& objects) const {
+    std::vector<DetectedObject>& parsedObjects = buffers.parsedObjects;
+    parsedObjects.clear();
+    for (auto& output : outputs) {
+        parseYOLOV3Output(output.first, output.second, batchIndex, netInputHeight, netInputWidth,
+            imageSize.height, imageSize.width, buffers.candidates, buffers.convertedPlane, parsedObjects);
     }
 
-    return std::unique_ptr<ResultBase>(result);
+    // Advanced postprocessing removes object if there's an object of the same class with greater confidence
+    // intersecting it enough. Classic one is a greedy class-agnostic suppression.
+    NonMaxSuppression& nms = buffers.nms;
+    nms.clear();
+    nms.reserve(parsedObjects.size());
+    for (const auto& obj : parsedObjects) {
+        nms.add(obj, obj.confidence, obj.labelID);
+    }
+    objects.clear();
+    for (size_t idx : nms.apply()) {
+        objects.push_back(parsedObjects[idx]);
+    }
+}
+
+std::unique_ptr<ModelYolo3::ParsingBuffers> ModelYolo3::acquireBuffers() {
+    std::lock_guard<std::mutex> lock(buffersMtx);
+    if (freeBuffers.empty()) {
+        return std::unique_ptr<ParsingBuffers>(new ParsingBuffers(nms));
+    }
+    std::unique_ptr<ParsingBuffers> buffers = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return buffers;
+}
+
+void ModelYolo3::releaseBuffers(std::unique_ptr<ParsingBuffers>&& buffers) {
+    std::lock_guard<std::mutex> lock(buffersMtx);
+    freeBuffers.push_back(std::move(buffers));
 }
 
 void ModelYolo3::parseYOLOV3Output(const std::string& output_name,
-    const InferenceEngine::Blob::Ptr& blob, const unsigned long resized_im_h,
+    const InferenceEngine::Blob::Ptr& blob, size_t batchIndex, const unsigned long resized_im_h,
     const unsigned long resized_im_w, const unsigned long original_im_h,
     const unsigned long original_im_w,
-    std::vector<DetectedObject>& objects) {
+    std::vector<int>& candidates, std::vector<float>& convertedPlane, std::vector<DetectedObject>& objects) const {
 
     const int out_blob_h = static_cast<int>(blob->getTensorDesc().getDims()[2]);
     const int out_blob_w = static_cast<int>(blob->getTensorDesc().getDims()[3]);
@@ -156,63 +194,81 @@ void ModelYolo3::parseYOLOV3Output(const std::string& output_name,
 
     auto side = out_blob_h;
     auto side_square = side * side;
-    const float* output_blob = blob->buffer().as<PrecisionTrait<Precision::FP32>::value_type*>();
+    const size_t batchItemSize = blob->getTensorDesc().getDims()[1] * side_square;
+    // Only the objectness planes of FP16 outputs are converted as a whole, the rest is read for the candidates
+    const bool isFp16 = blob->getTensorDesc().getPrecision() == Precision::FP16;
+    const float* output_blob = isFp16 ? nullptr
+        : blob->buffer().as<PrecisionTrait<Precision::FP32>::value_type*>() + batchIndex * batchItemSize;
+    const uint16_t* half_output_blob = isFp16 ? blob->buffer().as<const uint16_t*>() + batchIndex * batchItemSize
+        : nullptr;
+    auto readValue = [&](int index) {
+        return isFp16 ? kernels::halfToFloat(half_output_blob[index]) : output_blob[index];
+    };
+
+    const float widthScale = static_cast<float>(original_im_w) / resized_im_w;
+    const float heightScale = static_cast<float>(original_im_h) / resized_im_h;
 
     // --------------------------- Parsing YOLO Region output -------------------------------------
-    for (int i = 0; i < side_square; ++i) {
-        int row = i / side;
-        int col = i % side;
-        for (int n = 0; n < region.num; ++n) {
-            //--- Getting region data from blob
-            int obj_index = calculateEntryIndex(side, region.coords, region.classes, n * side * side + i, region.coords);
-            int box_index = calculateEntryIndex(side, region.coords, region.classes, n * side * side + i, 0);
-            float scale = output_blob[obj_index];
-
-            //--- Preliminary check for confidence threshold conformance
-            if (scale >= confidenceThreshold){
-                //--- Calculating scaled region's coordinates
-                double x = (col + output_blob[box_index + 0 * side_square]) / side * original_im_w;
-                double y = (row + output_blob[box_index + 1 * side_square]) / side * original_im_h;
-                double height = std::exp(output_blob[box_index + 3 * side_square]) * region.anchors[2 * n + 1] * original_im_h / resized_im_h;
-                double width = std::exp(output_blob[box_index + 2 * side_square]) * region.anchors[2 * n] * original_im_w / resized_im_w;
-
-                DetectedObject obj;
-                obj.x = (float)(x-width/2);
-                obj.y = (float)(y-height/2);
-                obj.width = (float)(width);
-                obj.height = (float)(height);
-
-                for (int j = 0; j < region.classes; ++j) {
-                    int class_index = calculateEntryIndex(side, region.coords, region.classes, n * side_square + i, region.coords + 1 + j);
-                    float prob = scale * output_blob[class_index];
-
-                    //--- Checking confidence threshold conformance and adding region to the list
-                    if (prob >= confidenceThreshold) {
-                        obj.confidence = prob;
-                        obj.labelID = j;
-                        obj.label = getLabelName(obj.labelID);
-                        objects.push_back(obj);
-                    }
+    for (int n = 0; n < region.num; ++n) {
+        // Every entry of the anchor is stored as contiguous plane of side * side values
+        const int anchorOffset = calculateEntryIndex(side, region.coords, region.classes, n * side_square, 0);
+        const int objectnessOffset = anchorOffset + region.coords * side_square;
+        const float* objectnessData = output_blob + objectnessOffset;
+        if (isFp16) {
+            convertedPlane.resize(side_square);
+            kernels::convertHalfToFloat(half_output_blob + objectnessOffset, side_square, convertedPlane.data());
+            objectnessData = convertedPlane.data();
+        }
+
+        //--- Preliminary check for confidence threshold conformance of the whole objectness plane
+        candidates.clear();
+        collectCandidates(objectnessData, side_square, confidenceThreshold, candidates);
+
+        for (int i : candidates) {
+            int row = i / side;
+            int col = i % side;
+            float scale = objectnessData[i];
+
+            //--- Calculating scaled region's coordinates
+            float x = (col + readValue(anchorOffset + i + 0 * side_square)) / side * original_im_w;
+            float y = (row + readValue(anchorOffset + i + 1 * side_square)) / side * original_im_h;
+            float height = std::exp(readValue(anchorOffset + i + 3 * side_square)) * region.anchors[2 * n + 1] * heightScale;
+            float width = std::exp(readValue(anchorOffset + i + 2 * side_square)) * region.anchors[2 * n] * widthScale;
+
+            DetectedObject obj;
+            obj.x = x - width / 2;
+            obj.y = y - height / 2;
+            obj.width = width;
+            obj.height = height;
+
+            const int classesOffset = anchorOffset + (region.coords + 1) * side_square + i;
+            for (int j = 0; j < region.classes; ++j) {
+                float prob = scale * readValue(classesOffset + j * side_square);
+
+                //--- Checking confidence threshold conformance and adding region to the list.
+                //--- Label names are assigned after filtering, only for objects left in the result
+                if (prob >= confidenceThreshold) {
+                    obj.confidence = prob;
+                    obj.labelID = j;
+                    objects.push_back(obj);
                 }
             }
         }
     }
 }
 
+void ModelYolo3::collectCandidates(const float* data, int size, float threshold, std::vector<int>& indices) {
+    const size_t offset = indices.size();
+    indices.resize(offset + size);
+    indices.resize(offset + kernels::collectAboveThreshold(data, size, threshold, indices.data() + offset));
+}
+
 int ModelYolo3::calculateEntryIndex(int side, int lcoords, int lclasses, int location, int entry) {
     int n = location / (side * side);
     int loc = location % (side * side);
     return n * side * side * (lcoords + lclasses + 1) + entry * side * side + loc;
 }
 
-double ModelYolo3::intersectionOverUnion(const DetectedObject& o1, const DetectedObject& o2) {
-    double overlappingWidth = fmin(o1.x + o1.width, o2.x + o2.width) - fmax(o1.x, o2.x);
-    double overlappingHeight = fmin(o1.y + o1.height, o2.y + o2.height) - fmax(o1.y, o2.y);
-    double intersectionArea = (overlappingWidth < 0 || overlappingHeight < 0) ? 0 : overlappingHeight * overlappingWidth;
-    double unionArea = o1.width * o1.height + o2.width * o2.height - intersectionArea;
-    return intersectionArea / unionArea;
-}
-
 ModelYolo3::Region::Region(const std::shared_ptr<ngraph::op::RegionYolo>& regionYolo) {
     coords = regionYolo->get_num_coords();
     classes = regionYolo->get_num_classes();
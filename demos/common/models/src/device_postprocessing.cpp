@@ -0,0 +1,66 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "models/device_postprocessing.h"
+#include <ngraph/ngraph.hpp>
+#include <ngraph/opsets/opset3.hpp>
+
+using namespace InferenceEngine;
+
+TopKOutputs appendTopK(CNNNetwork& cnnNetwork, size_t k, int64_t axis, bool applySoftmax, bool keepValues) {
+    std::shared_ptr<ngraph::Function> function = cnnNetwork.getFunction();
+    if (!function) {
+        throw std::runtime_error("Can't get ngraph::Function. Make sure the provided model is in IR version 10 or greater.");
+    }
+    if (function->get_results().size() != 1) {
+        throw std::logic_error("Postprocessing can be appended only to the network with one output");
+    }
+
+    // The function is shared with the original network, so its copy is changed
+    std::shared_ptr<ngraph::Function> copy = ngraph::clone_function(*function);
+    ngraph::Output<ngraph::Node> scores = copy->get_results()[0]->input_value(0);
+    const std::string scoresName = scores.get_node()->get_friendly_name();
+    if (axis < 0) {
+        axis += static_cast<int64_t>(scores.get_partial_shape().rank().get_length());
+    }
+    if (applySoftmax) {
+        scores = std::make_shared<ngraph::opset3::Softmax>(scores, static_cast<size_t>(axis));
+    }
+    auto topK = std::make_shared<ngraph::opset3::TopK>(scores,
+        ngraph::opset3::Constant::create(ngraph::element::i64, ngraph::Shape{}, {static_cast<int64_t>(k)}), axis,
+        ngraph::opset3::TopK::Mode::MAX, ngraph::opset3::TopK::SortType::SORT_VALUES, ngraph::element::i32);
+    topK->set_friendly_name(scoresName + "/top_k");
+
+    ngraph::ResultVector results;
+    if (keepValues) {
+        results.push_back(std::make_shared<ngraph::opset3::Result>(topK->output(0)));
+    }
+    results.push_back(std::make_shared<ngraph::opset3::Result>(topK->output(1)));
+    cnnNetwork = CNNNetwork(std::make_shared<ngraph::Function>(results, copy->get_parameters(),
+        copy->get_friendly_name()));
+
+    // Output names are given by the Inference Engine, the indices are told by their precision
+    TopKOutputs outputs;
+    for (const auto& output : cnnNetwork.getOutputsInfo()) {
+        if (output.second->getPrecision() == Precision::I32) {
+            outputs.indicesName = output.first;
+        }
+        else {
+            outputs.valuesName = output.first;
+        }
+    }
+    return outputs;
+}
@@ -0,0 +1,185 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "models/instance_segmentation_model.h"
+#include <algorithm>
+#include <samples/instance_masks.hpp>
+#include <samples/ocv_common.hpp>
+#include <samples/slog.hpp>
+
+using namespace InferenceEngine;
+
+InstanceSegmentationModel::InstanceSegmentationModel(const std::string& modelFileName,
+    const std::string& detectionOutputName, const std::string& masksName,
+    float confidenceThreshold, float maskThreshold) :
+    ModelBase(modelFileName),
+    detectionOutputName(detectionOutputName),
+    masksName(masksName),
+    confidenceThreshold(confidenceThreshold),
+    maskThreshold(maskThreshold) {
+}
+
+void InstanceSegmentationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
+    // --------------------------- Configure input & output -------------------------------------------------
+    // --------------------------- Prepare input blobs ------------------------------------------------------
+    slog::info << "Checking that the inputs are as the demo expects" << slog::endl;
+    InputsDataMap inputInfo(cnnNetwork.getInputsInfo());
+    inputsNames.resize(1);
+    for (const auto& inputInfoItem : inputInfo) {
+        const TensorDesc& inputDesc = inputInfoItem.second->getTensorDesc();
+        if (inputDesc.getDims().size() == 4) {  // 1st input contains images
+            inputsNames[0] = inputInfoItem.first;
+            inputInfoItem.second->setPrecision(Precision::U8);
+            inputInfoItem.second->getInputData()->setLayout(Layout::NCHW);
+            netInputHeight = getTensorHeight(inputDesc);
+            netInputWidth = getTensorWidth(inputDesc);
+        }
+        else if (inputDesc.getDims().size() == 2) {  // 2nd input contains image info
+            inputsNames.resize(2);
+            inputsNames[1] = inputInfoItem.first;
+            inputInfoItem.second->setPrecision(Precision::FP32);
+        }
+        else {
+            throw std::logic_error("Unsupported " + std::to_string(inputDesc.getDims().size()) + "D "
+                "input layer '" + inputInfoItem.first + "'. Only 2D and 4D input layers are supported");
+        }
+    }
+    if (inputsNames[0].empty()) {
+        throw std::logic_error("The network should have 4D image input");
+    }
+
+    // --------------------------- Prepare output blobs -----------------------------------------------------
+    slog::info << "Checking that the outputs are as the demo expects" << slog::endl;
+    // DetectionOutput layer isn't an output of the network, it's added to get detected boxes and their probabilities
+    cnnNetwork.addOutput(detectionOutputName, 0);
+    OutputsDataMap outputInfo(cnnNetwork.getOutputsInfo());
+    auto detectionOutput = outputInfo.find(detectionOutputName);
+    auto masksOutput = outputInfo.find(masksName);
+    if (detectionOutput == outputInfo.end() || masksOutput == outputInfo.end()) {
+        throw std::logic_error("The network should have '" + detectionOutputName + "' and '" + masksName + "' outputs");
+    }
+
+    const SizeVector& detectionDims = detectionOutput->second->getTensorDesc().getDims();
+    if (detectionDims.size() != 2) {
+        throw std::logic_error("Detection output should be 2D");
+    }
+    boxDescriptionSize = detectionDims.back();
+    if (boxDescriptionSize < 7) {
+        throw std::logic_error("Detection output should have at least 7 elements per box");
+    }
+    if (masksOutput->second->getTensorDesc().getDims().size() != 4) {
+        throw std::logic_error("Masks output should be 4D");
+    }
+
+    outputsNames.push_back(detectionOutputName);
+    outputsNames.push_back(masksName);
+    for (const auto& outputName : outputsNames) {
+        outputInfo[outputName]->setPrecision(Precision::FP32);
+    }
+}
+
+std::shared_ptr<InternalModelData> InstanceSegmentationModel::preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) {
+    return preprocessBatchItem(inputData, request, 0);
+}
+
+std::shared_ptr<InternalModelData> InstanceSegmentationModel::preprocessBatchItem(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
+    auto& img = inputData.asRef<ImageInputData>().inputImage;
+
+    Blob::Ptr frameBlob = request->GetBlob(inputsNames[0]);
+    matU8ToBlob<uint8_t>(img, frameBlob, static_cast<int>(batchIndex));
+
+    if (inputsNames.size() > 1) {
+        auto blob = request->GetBlob(inputsNames[1]);
+        // Image info is [height, width] of the network input followed by the scale, the image is resized already
+        const size_t infoSize = blob->getTensorDesc().getDims()[1];
+        LockedMemory<void> blobMapped = as<MemoryBlob>(blob)->wmap();
+        auto data = blobMapped.as<float*>() + batchIndex * infoSize;
+        data[0] = static_cast<float>(netInputHeight);
+        data[1] = static_cast<float>(netInputWidth);
+        std::fill(data + 2, data + infoSize, 1.0f);
+    }
+
+    return internalImageDataPool.make(img.cols, img.rows);
+}
+
+std::unique_ptr<ResultBase> InstanceSegmentationModel::postprocess(InferenceResult& infResult) {
+    auto retVal = resultsPool.acquire();
+    InstanceSegmentationResult* result = retVal.get();
+    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+
+    const auto& internalData = infResult.internalModelData->asRef<InternalImageModelData>();
+    const float imgWidth = static_cast<float>(internalData.inputImgWidth);
+    const float imgHeight = static_cast<float>(internalData.inputImgHeight);
+
+    const MemoryBlob::Ptr& detectionBlob = infResult.outputsData[detectionOutputName];
+    LockedMemory<const void> detectionMapped = detectionBlob->rmap();
+    const float* detections = detectionMapped.as<const float*>();
+    const size_t maxProposalCount = detectionBlob->getTensorDesc().getDims()[0];
+
+    const MemoryBlob::Ptr& masksBlob = infResult.outputsData[masksName];
+    LockedMemory<const void> masksMapped = masksBlob->rmap();
+    const float* masks = masksMapped.as<const float*>();
+    const TensorDesc& masksDesc = masksBlob->getTensorDesc();
+    const size_t numMaskClasses = getTensorChannels(masksDesc);
+    const int maskHeight = static_cast<int>(getTensorHeight(masksDesc));
+    const int maskWidth = static_cast<int>(getTensorWidth(masksDesc));
+    const size_t maskSize = static_cast<size_t>(maskHeight) * maskWidth;
+
+    // Objects are overwritten in place, so their mask runs buffers are reused
+    size_t numObjects = 0;
+    for (size_t box = 0; box < maxProposalCount; box++) {
+        const float* boxInfo = detections + box * boxDescriptionSize;
+        const int batch = static_cast<int>(boxInfo[0]);
+        if (batch < 0) {
+            break;
+        }
+        // Output of batched request contains detections for all images of the batch
+        const float confidence = boxInfo[2];
+        if (static_cast<size_t>(batch) != infResult.batchIndex || confidence <= confidenceThreshold) {
+            continue;
+        }
+        const float x1 = std::min(std::max(0.0f, boxInfo[3] * imgWidth), imgWidth);
+        const float y1 = std::min(std::max(0.0f, boxInfo[4] * imgHeight), imgHeight);
+        const float x2 = std::min(std::max(0.0f, boxInfo[5] * imgWidth), imgWidth);
+        const float y2 = std::min(std::max(0.0f, boxInfo[6] * imgHeight), imgHeight);
+        const cv::Rect maskBox(static_cast<int>(x1), static_cast<int>(y1),
+            static_cast<int>(x2 - x1), static_cast<int>(y2 - y1));
+        const auto labelID = static_cast<size_t>(boxInfo[1] + 1e-6f);
+        // Masks don't have the background class
+        if (maskBox.area() <= 0 || labelID == 0 || labelID > numMaskClasses) {
+            continue;
+        }
+
+        if (numObjects == result->objects.size()) {
+            result->objects.emplace_back();
+        }
+        SegmentedObject& object = result->objects[numObjects++];
+        object.x = x1;
+        object.y = y1;
+        object.width = x2 - x1;
+        object.height = y2 - y1;
+        object.labelID = static_cast<unsigned int>(labelID);
+        object.label = nullptr;
+        object.confidence = confidence;
+        object.maskBox = maskBox;
+        const cv::Mat mask(maskHeight, maskWidth, CV_32FC1,
+            const_cast<float*>(masks + (box * numMaskClasses + labelID - 1) * maskSize));
+        encodeInstanceMask(mask, maskBox.size(), maskThreshold, object.maskRuns);
+    }
+    result->objects.resize(numObjects);
+
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
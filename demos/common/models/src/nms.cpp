@@ -0,0 +1,265 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "models/nms.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+namespace {
+// Bigger grids don't reduce number of comparisons noticeably, but cost more to fill
+const int MAX_GRID_SIDE = 64;
+}
+
+NonMaxSuppression::NonMaxSuppression(Method method, float iouThreshold, bool perClass,
+    float scoreThreshold, size_t topK, float sigma) :
+    method(method),
+    iouThreshold(iouThreshold),
+    perClass(perClass),
+    scoreThreshold(scoreThreshold),
+    topK(topK),
+    sigma(sigma) {
+}
+
+void NonMaxSuppression::clear() {
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+    areas.clear();
+    scores.clear();
+    classIds.clear();
+}
+
+void NonMaxSuppression::reserve(size_t count) {
+    x1.reserve(count);
+    y1.reserve(count);
+    x2.reserve(count);
+    y2.reserve(count);
+    areas.reserve(count);
+    scores.reserve(count);
+    classIds.reserve(count);
+}
+
+size_t NonMaxSuppression::add(const cv::Rect2f& box, float score, int classId) {
+    x1.push_back(box.x);
+    y1.push_back(box.y);
+    x2.push_back(box.x + box.width);
+    y2.push_back(box.y + box.height);
+    areas.push_back(box.width * box.height);
+    scores.push_back(score);
+    classIds.push_back(perClass ? classId : 0);
+    return scores.size() - 1;
+}
+
+float NonMaxSuppression::intersectionOverUnion(const cv::Rect2f& box1, const cv::Rect2f& box2) {
+    float overlappingWidth = std::min(box1.x + box1.width, box2.x + box2.width) - std::max(box1.x, box2.x);
+    float overlappingHeight = std::min(box1.y + box1.height, box2.y + box2.height) - std::max(box1.y, box2.y);
+    float intersectionArea = (overlappingWidth < 0 || overlappingHeight < 0) ? 0 : overlappingHeight * overlappingWidth;
+    float unionArea = box1.area() + box2.area() - intersectionArea;
+    return unionArea > 0 ? intersectionArea / unionArea : 0;
+}
+
+float NonMaxSuppression::iou(size_t idx1, size_t idx2) const {
+    float overlappingWidth = std::min(x2[idx1], x2[idx2]) - std::max(x1[idx1], x1[idx2]);
+    float overlappingHeight = std::min(y2[idx1], y2[idx2]) - std::max(y1[idx1], y1[idx2]);
+    if (overlappingWidth <= 0 || overlappingHeight <= 0) {
+        return 0;
+    }
+    float intersectionArea = overlappingWidth * overlappingHeight;
+    float unionArea = areas[idx1] + areas[idx2] - intersectionArea;
+    return unionArea > 0 ? intersectionArea / unionArea : 0;
+}
+
+float NonMaxSuppression::decayedScore(float score, float overlap) const {
+    if (method == Method::SoftGaussian) {
+        return score * std::exp(-overlap * overlap / sigma);
+    }
+    return overlap >= iouThreshold ? score * (1 - overlap) : score;
+}
+
+const std::vector<size_t>& NonMaxSuppression::apply() {
+    kept.clear();
+    const size_t count = scores.size();
+    order.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    // Boxes of the same class form contiguous buckets sorted by descending score
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return classIds[a] != classIds[b] ? classIds[a] < classIds[b] : scores[a] > scores[b];
+    });
+    removed.assign(count, 0);
+    if (visitStamps.size() < count) {
+        visitStamps.resize(count, 0);
+    }
+
+    for (size_t begin = 0; begin < count;) {
+        size_t end = begin + 1;
+        while (end < count && classIds[order[end]] == classIds[order[begin]]) {
+            end++;
+        }
+        applyToBucket(begin, topK ? std::min(end, begin + topK) : end);
+        begin = end;
+    }
+
+    std::stable_sort(kept.begin(), kept.end(), [this](size_t a, size_t b) { return scores[a] > scores[b]; });
+    return kept;
+}
+
+void NonMaxSuppression::buildGrid(size_t begin, size_t end) {
+    float minX = x1[order[begin]], minY = y1[order[begin]];
+    float maxX = x2[order[begin]], maxY = y2[order[begin]];
+    float sumWidth = 0, sumHeight = 0;
+    for (size_t i = begin; i < end; i++) {
+        size_t idx = order[i];
+        minX = std::min(minX, x1[idx]);
+        minY = std::min(minY, y1[idx]);
+        maxX = std::max(maxX, x2[idx]);
+        maxY = std::max(maxY, y2[idx]);
+        sumWidth += x2[idx] - x1[idx];
+        sumHeight += y2[idx] - y1[idx];
+    }
+
+    // Cells are as big as an average box, so every box covers a few cells only
+    const float count = static_cast<float>(end - begin);
+    const float avgSide = std::max(std::max(sumWidth, sumHeight) / count, 1e-6f);
+    gridX = minX;
+    gridY = minY;
+    gridCols = std::max(1, std::min(MAX_GRID_SIDE, static_cast<int>(std::ceil((maxX - minX) / avgSide))));
+    gridRows = std::max(1, std::min(MAX_GRID_SIDE, static_cast<int>(std::ceil((maxY - minY) / avgSide))));
+    cellWidth = std::max((maxX - minX) / gridCols, 1e-6f);
+    cellHeight = std::max((maxY - minY) / gridRows, 1e-6f);
+
+    const size_t cellsCount = static_cast<size_t>(gridCols * gridRows);
+    if (cells.size() < cellsCount) {
+        cells.resize(cellsCount);
+    }
+    for (size_t i = 0; i < cellsCount; i++) {
+        cells[i].clear();
+    }
+}
+
+template <typename Visitor>
+bool NonMaxSuppression::visitNeighbours(size_t idx, Visitor visitor) {
+    // Boxes intersect only if they cover at least one common cell. Stamps prevent visiting the same box twice.
+    currentStamp++;
+    if (currentStamp == 0) {
+        std::fill(visitStamps.begin(), visitStamps.end(), 0);
+        currentStamp = 1;
+    }
+
+    const int col1 = std::max(0, std::min(gridCols - 1, static_cast<int>((x1[idx] - gridX) / cellWidth)));
+    const int col2 = std::max(0, std::min(gridCols - 1, static_cast<int>((x2[idx] - gridX) / cellWidth)));
+    const int row1 = std::max(0, std::min(gridRows - 1, static_cast<int>((y1[idx] - gridY) / cellHeight)));
+    const int row2 = std::max(0, std::min(gridRows - 1, static_cast<int>((y2[idx] - gridY) / cellHeight)));
+    for (int row = row1; row <= row2; row++) {
+        for (int col = col1; col <= col2; col++) {
+            for (uint32_t neighbour : cells[row * gridCols + col]) {
+                if (visitStamps[neighbour] != currentStamp) {
+                    visitStamps[neighbour] = currentStamp;
+                    if (!visitor(static_cast<size_t>(neighbour))) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void NonMaxSuppression::putToGrid(size_t idx) {
+    const int col1 = std::max(0, std::min(gridCols - 1, static_cast<int>((x1[idx] - gridX) / cellWidth)));
+    const int col2 = std::max(0, std::min(gridCols - 1, static_cast<int>((x2[idx] - gridX) / cellWidth)));
+    const int row1 = std::max(0, std::min(gridRows - 1, static_cast<int>((y1[idx] - gridY) / cellHeight)));
+    const int row2 = std::max(0, std::min(gridRows - 1, static_cast<int>((y2[idx] - gridY) / cellHeight)));
+    for (int row = row1; row <= row2; row++) {
+        for (int col = col1; col <= col2; col++) {
+            cells[row * gridCols + col].push_back(static_cast<uint32_t>(idx));
+        }
+    }
+}
+
+void NonMaxSuppression::applyToBucket(size_t begin, size_t end) {
+    if (iouThreshold <= 0 && method != Method::SoftGaussian) {
+        // Any pair of boxes overlaps enough, only the best box of the bucket can be left
+        if (scores[order[begin]] >= scoreThreshold) {
+            kept.push_back(order[begin]);
+        }
+        return;
+    }
+
+    buildGrid(begin, end);
+
+    if (method == Method::Greedy || method == Method::Strict) {
+        for (size_t i = begin; i < end; i++) {
+            const size_t idx = order[i];
+            if (scores[idx] < scoreThreshold) {
+                break;
+            }
+            // Only boxes with higher or equal score are in the grid at this moment
+            const float score = scores[idx];
+            const bool isStrict = method == Method::Strict;
+            bool isSuppressed = !visitNeighbours(idx, [&](size_t neighbour) {
+                return (isStrict && scores[neighbour] <= score) || iou(idx, neighbour) < iouThreshold;
+            });
+            if (!isSuppressed) {
+                kept.push_back(idx);
+            }
+            if (!isSuppressed || isStrict) {
+                putToGrid(idx);
+            }
+        }
+        return;
+    }
+
+    // Soft methods: select the best box, decay scores of its neighbours, repeat.
+    // Scores only decrease, so outdated heap entries are detected by comparison with the current score.
+    typedef std::pair<float, size_t> ScoreEntry;
+    std::priority_queue<ScoreEntry> heap;
+    for (size_t i = begin; i < end; i++) {
+        putToGrid(order[i]);
+        heap.push(ScoreEntry(scores[order[i]], order[i]));
+    }
+    while (!heap.empty()) {
+        ScoreEntry entry = heap.top();
+        heap.pop();
+        const size_t idx = entry.second;
+        if (removed[idx] || entry.first != scores[idx]) {
+            continue;
+        }
+        if (entry.first < scoreThreshold) {
+            break;
+        }
+
+        removed[idx] = 1;
+        kept.push_back(idx);
+        visitNeighbours(idx, [&](size_t neighbour) {
+            if (!removed[neighbour]) {
+                float overlap = iou(idx, neighbour);
+                if (overlap > 0) {
+                    float newScore = decayedScore(scores[neighbour], overlap);
+                    if (newScore != scores[neighbour]) {
+                        scores[neighbour] = newScore;
+                        heap.push(ScoreEntry(newScore, neighbour));
+                    }
+                }
+            }
+            return true;
+        });
+    }
+}
@@ -15,10 +15,29 @@
 */
 
 #include "models/segmentation_model.h"
+#include "models/device_postprocessing.h"
 #include "samples/ocv_common.hpp"
+#include <kernels/demo_kernels.h>
+#include <algorithm>
+#include <vector>
 
 using namespace InferenceEngine;
 
+namespace {
+template <typename T>
+void copyClassIndices(const T* classes, cv::Mat& mask) {
+    cv::parallel_for_(cv::Range(0, mask.rows), [&](const cv::Range& range) {
+        for (int rowId = range.start; rowId < range.end; ++rowId) {
+            const T* rowClasses = classes + static_cast<size_t>(rowId) * mask.cols;
+            uint8_t* maskRow = mask.ptr<uint8_t>(rowId);
+            for (int colId = 0; colId < mask.cols; ++colId) {
+                maskRow[colId] = static_cast<uint8_t>(rowClasses[colId]);
+            }
+        }
+    });
+}
+}
+
 void SegmentationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
     // --------------------------- Configure input & output ---------------------------------------------
     // --------------------------- Prepare input blobs -----------------------------------------------------
@@ -32,6 +51,14 @@ void SegmentationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNet
     inSizeVector[0] = 1;  // set batch size to 1
     cnnNetwork.reshape(inputShapes);
 
+    if (devicePostprocessing && cnnNetwork.getOutputsInfo().size() == 1) {
+        // The device computes the argmax over the class heatmaps and returns I32 class map
+        const SizeVector& scoresDims = cnnNetwork.getOutputsInfo().begin()->second->getTensorDesc().getDims();
+        if (scoresDims.size() == 4 && scoresDims[1] >= 2) {
+            appendTopK(cnnNetwork, 1, 1, false, false);
+        }
+    }
+
     InputInfo& inputInfo = *cnnNetwork.getInputsInfo().begin()->second;
     inputInfo.getPreProcess().setResizeAlgorithm(ResizeAlgorithm::RESIZE_BILINEAR);
     inputInfo.setLayout(Layout::NHWC);
@@ -43,10 +70,6 @@ void SegmentationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNet
 
     outputsNames.push_back(outputsDataMap.begin()->first);
     Data& data = *outputsDataMap.begin()->second;
-    // if the model performs ArgMax, its output type can be I32 but for models that return heatmaps for each
-    // class the output is usually FP32. Reset the precision to avoid handling different types with switch in
-    // postprocessing
-    data.setPrecision(Precision::FP32);
     const SizeVector& outSizeVector = data.getTensorDesc().getDims();
     switch (outSizeVector.size()) {
     case 3:
@@ -63,6 +86,14 @@ void SegmentationModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNet
         throw std::runtime_error("Unexpected output blob shape. Only 4D and 3D output blobs are"
             "supported.");
     }
+
+    // if the model performs ArgMax, its output type can be I32 and it's read as is. For models that return heatmaps
+    // for each class the output is usually FP32, other precisions are converted to FP32 to avoid handling different
+    // types with switch in postprocessing. Heatmaps can be FP16 if it's allowed, they are converted a row at a time
+    isArgMaxOutputI32 = outChannels < 2 && data.getPrecision() == Precision::I32;
+    if (!isArgMaxOutputI32) {
+        data.setPrecision(fp16OutputsAllowed && outChannels >= 2 ? Precision::FP16 : Precision::FP32);
+    }
 }
 
 std::shared_ptr<InternalModelData> SegmentationModel::preprocess(const InputData& inputData, InferenceEngine::InferRequest::Ptr& request) {
@@ -70,40 +101,62 @@ std::shared_ptr<InternalModelData> SegmentationModel::preprocess(const InputData
     auto& img = imgData.inputImage;
 
     request->SetBlob(inputsNames[0], wrapMat2Blob(img));
-    return std::shared_ptr<InternalModelData>(new InternalImageModelData(img.cols, img.rows));
+    return internalImageDataPool.make(img.cols, img.rows);
 }
 
 std::unique_ptr<ResultBase> SegmentationModel::postprocess(InferenceResult& infResult) {
-    SegmentationResult* result = new SegmentationResult;
+    auto retVal = resultsPool.acquire();
+    SegmentationResult* result = retVal.get();
     *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
 
-    const auto& inputImgSize = infResult.internalModelData->asRef<InternalImageModelData>();
-
     LockedMemory<const void> outMapped = infResult.getFirstOutputBlob()->rmap();
-    const float * const predictions = outMapped.as<float*>();
 
-    result->mask = cv::Mat(outHeight, outWidth, CV_8UC1);
-    for (int rowId = 0; rowId < outHeight; ++rowId) {
-        for (int colId = 0; colId < outWidth; ++colId) {
-            std::size_t classId = 0;
-            if (outChannels < 2) {  // assume the output is already ArgMax'ed
-                classId = static_cast<std::size_t>(predictions[rowId * outWidth + colId]);
+    // Recycled result's mask buffer is reused, as network output size doesn't change
+    cv::Mat& netMask = result->mask;
+    netMask.create(outHeight, outWidth, CV_8UC1);
+    if (isArgMaxOutputI32) {
+        copyClassIndices(outMapped.as<const int32_t*>(), netMask);
+    }
+    else if (outChannels < 2) {  // assume the output is already ArgMax'ed
+        copyClassIndices(outMapped.as<const float*>(), netMask);
+    }
+    else if (infResult.getFirstOutputBlob()->getTensorDesc().getPrecision() == Precision::FP16) {
+        const uint16_t* const predictions = outMapped.as<const uint16_t*>();
+        const size_t planeSize = static_cast<size_t>(outHeight) * outWidth;
+        cv::parallel_for_(cv::Range(0, outHeight), [&](const cv::Range& range) {
+            std::vector<float> maxProbs(outWidth), channelProbs(outWidth);
+            for (int rowId = range.start; rowId < range.end; ++rowId) {
+                const uint16_t* rowPredictions = predictions + static_cast<size_t>(rowId) * outWidth;
+                uint8_t* maskRow = netMask.ptr<uint8_t>(rowId);
+                kernels::convertHalfToFloat(rowPredictions, outWidth, maxProbs.data());
+                std::fill(maskRow, maskRow + outWidth, 0);
+                for (int chId = 1; chId < outChannels; ++chId) {
+                    kernels::convertHalfToFloat(rowPredictions + chId * planeSize, outWidth, channelProbs.data());
+                    kernels::updateArgMax(channelProbs.data(), outWidth, static_cast<uint8_t>(chId), maxProbs.data(),
+                        maskRow);
+                }
             }
-            else {
-                float maxProb = -1.0f;
-                for (int chId = 0; chId < outChannels; ++chId) {
-                    float prob = predictions[chId * outHeight * outWidth + rowId * outWidth + colId];
-                    if (prob > maxProb) {
-                        classId = chId;
-                        maxProb = prob;
-                    }
+        });
+    }
+    else {
+        const float* const predictions = outMapped.as<const float*>();
+        const size_t planeSize = static_cast<size_t>(outHeight) * outWidth;
+        // Channels are traversed in the outer loop, so every pass reads contiguous row of a plane
+        // with the SIMD kernel the CPU supports
+        cv::parallel_for_(cv::Range(0, outHeight), [&](const cv::Range& range) {
+            std::vector<float> maxProbs(outWidth);
+            for (int rowId = range.start; rowId < range.end; ++rowId) {
+                const float* rowPredictions = predictions + static_cast<size_t>(rowId) * outWidth;
+                uint8_t* maskRow = netMask.ptr<uint8_t>(rowId);
+                std::copy(rowPredictions, rowPredictions + outWidth, maxProbs.begin());
+                std::fill(maskRow, maskRow + outWidth, 0);
+                for (int chId = 1; chId < outChannels; ++chId) {
+                    const float* channelRow = rowPredictions + chId * planeSize;
+                    kernels::updateArgMax(channelRow, outWidth, static_cast<uint8_t>(chId), maxProbs.data(), maskRow);
                 }
             }
-
-            result->mask.at<uint8_t>(rowId, colId) = classId;
-        }
+        });
     }
-    cv::resize(result->mask, result->mask, cv::Size(inputImgSize.inputImgWidth, inputImgSize.inputImgHeight),0,0,cv::INTER_NEAREST);
 
-    return std::unique_ptr<ResultBase>(result);
+    return std::unique_ptr<ResultBase>(retVal.release());
 }
@@ -0,0 +1,344 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "models/text_detection_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+#include <samples/ocv_common.hpp>
+
+using namespace InferenceEngine;
+
+namespace {
+// Two-class softmax over every pair of channels (2k, 2k + 1) of an NCHW blob thresholded into a pixel-major mask:
+// mask[pixel * pairs + k] is whether the probability of the second class is at least threshold. The probability is
+// the sigmoid of the difference of the logits, so the blob is read once without copying and transposing it
+void positiveClassMask(const float* data, size_t pairs, size_t plane_size, float threshold,
+                       std::vector<uchar>* mask) {
+    mask->resize(pairs * plane_size);
+    for (size_t k = 0; k < pairs; k++) {
+        const float* negative = data + 2 * k * plane_size;
+        const float* positive = negative + plane_size;
+        uchar* pair_mask = mask->data() + k;
+        for (size_t i = 0; i < plane_size; i++) {
+            pair_mask[i * pairs] = 1.0f / (1.0f + std::exp(negative[i] - positive[i])) >= threshold;
+        }
+    }
+}
+
+// For every column (row) of a mask of src_size pixels resized to dst_size pixels with INTER_NEAREST, the range
+// [first, last] of the resized columns (rows) it's copied to. The range is empty (first > last) if it's skipped
+std::vector<cv::Vec2i> nearestResizeRanges(int src_size, int dst_size) {
+    std::vector<cv::Vec2i> ranges(src_size, cv::Vec2i(dst_size, -1));
+    const double scale = 1.0 / (static_cast<double>(dst_size) / src_size);
+    for (int dst = 0; dst < dst_size; dst++) {
+        cv::Vec2i &range = ranges[std::min(cvFloor(dst * scale), src_size - 1)];
+        range[0] = std::min(range[0], dst);
+        range[1] = std::max(range[1], dst);
+    }
+    return ranges;
+}
+
+std::vector<cv::RotatedRect> maskToBoxes(const cv::Mat &mask, float min_area, float min_height,
+                                         const cv::Size &image_size) {
+    // The boxes are found on the mask of the network resolution instead of resizing it to the image and
+    // searching contours of every label there. A box is the minimal rectangle of the label pixels of the resized
+    // mask, so it's enough to take the corners of the resized pixels the horizontal runs of the label start and
+    // end with: all the other resized pixels lie inside the convex hull of these corners
+    const std::vector<cv::Vec2i> x_ranges = nearestResizeRanges(mask.cols, image_size.width);
+    const std::vector<cv::Vec2i> y_ranges = nearestResizeRanges(mask.rows, image_size.height);
+    std::vector<std::vector<cv::Point>> label_points;
+    for (int y = 0; y < mask.rows; y++) {
+        const cv::Vec2i &y_range = y_ranges[y];
+        if (y_range[0] > y_range[1])
+            continue;
+        const int *row = mask.ptr<int>(y);
+        for (int x = 0; x < mask.cols;) {
+            const int label = row[x];
+            int run_end = x + 1;
+            while (run_end < mask.cols && row[run_end] == label)
+                run_end++;
+            if (label > 0) {
+                int first = x;
+                int last = run_end - 1;
+                while (first <= last && x_ranges[first][0] > x_ranges[first][1])
+                    first++;
+                while (last >= first && x_ranges[last][0] > x_ranges[last][1])
+                    last--;
+                if (first <= last) {
+                    if (label_points.size() < static_cast<size_t>(label))
+                        label_points.resize(label);
+                    std::vector<cv::Point> &points = label_points[label - 1];
+                    points.emplace_back(x_ranges[first][0], y_range[0]);
+                    points.emplace_back(x_ranges[first][0], y_range[1]);
+                    points.emplace_back(x_ranges[last][1], y_range[0]);
+                    points.emplace_back(x_ranges[last][1], y_range[1]);
+                }
+            }
+            x = run_end;
+        }
+    }
+
+    std::vector<cv::RotatedRect> bboxes;
+    for (const auto &points : label_points) {
+        if (points.empty())
+            continue;
+        cv::RotatedRect r = cv::minAreaRect(points);
+        if (std::min(r.size.width, r.size.height) < min_height)
+            continue;
+        if (r.size.area() < min_area)
+            continue;
+        bboxes.emplace_back(r);
+    }
+
+    return bboxes;
+}
+
+std::vector<cv::RotatedRect> coordToBoxes(const float* coords,
+                                          size_t coords_size,
+                                          float min_area, float min_height,
+                                          const cv::Size &input_shape,
+                                          const cv::Size &image_size) {
+    std::vector<cv::RotatedRect> bboxes;
+    int num_boxes = coords_size / 5;
+    float x_scale = image_size.width / float(input_shape.width);
+    float y_scale = image_size.height / float(input_shape.height);
+
+    for (int i = 0; i < num_boxes; i++) {
+        const float *prediction = &coords[i * 5];
+        float confidence = prediction[4];
+        if (confidence < std::numeric_limits<float>::epsilon()) break;
+        // predictions are sorted the way that all insignificant boxes are
+        // grouped together
+        cv::Point2f center = cv::Point2f((prediction[0] + prediction[2]) / 2 * x_scale,
+                                         (prediction[1] + prediction[3]) / 2 * y_scale);
+        cv::Size2f size = cv::Size2f((prediction[2] - prediction[0]) * x_scale,
+                                     (prediction[3] - prediction[1]) * y_scale);
+        cv::RotatedRect rect = cv::RotatedRect(center, size, 0);
+
+        if (rect.size.area() < min_area) continue;
+        bboxes.push_back(rect);
+    }
+    return bboxes;
+}
+
+// Pixels are joined into groups in flat arrays indexed by pixel: a pixel is its own parent if it's a root of a group,
+// rank bounds the height of the tree of a root
+int findRoot(int point, std::vector<int> *parents) {
+    int root = point;
+    while ((*parents)[root] != root) {
+        root = (*parents)[root];
+    }
+    // Path compression: the pixels on the way are attached to the root directly
+    while ((*parents)[point] != root) {
+        int parent = (*parents)[point];
+        (*parents)[point] = root;
+        point = parent;
+    }
+    return root;
+}
+
+void join(int p1, int p2, std::vector<int> *parents, std::vector<uchar> *ranks) {
+    int root1 = findRoot(p1, parents);
+    int root2 = findRoot(p2, parents);
+    if (root1 == root2) {
+        return;
+    }
+    // Union by rank: the lower tree is attached to the higher one
+    if ((*ranks)[root1] < (*ranks)[root2]) {
+        std::swap(root1, root2);
+    }
+    (*parents)[root2] = root1;
+    if ((*ranks)[root1] == (*ranks)[root2]) {
+        (*ranks)[root1]++;
+    }
+}
+
+cv::Mat get_all(const std::vector<cv::Point> &points, int w, int h,
+                std::vector<int> *parents) {
+    // Groups are labeled in order of their first pixels like before, whichever pixel is the root
+    std::vector<int> root_labels(parents->size(), 0);
+    int labels_number = 0;
+
+    cv::Mat mask(h, w, CV_32S, cv::Scalar(0));
+    for (const auto &point : points) {
+        int &label = root_labels[findRoot(point.x + point.y * w, parents)];
+        if (label == 0) {
+            label = ++labels_number;
+        }
+        mask.at<int>(point.x + point.y * w) = label;
+    }
+
+    return mask;
+}
+
+cv::Mat decodeImageByJoin(const std::vector<uchar> &pixel_mask, const std::vector<uchar> &link_mask,
+                          int h, int w, size_t neighbours) {
+    std::vector<int> parents(h * w);
+    std::vector<uchar> ranks(h * w, 0);
+    std::vector<cv::Point> points;
+    for (size_t i = 0; i < pixel_mask.size(); i++) {
+        parents[i] = static_cast<int>(i);
+        if (pixel_mask[i]) {
+            points.emplace_back(i % w, i / w);
+        }
+    }
+
+    for (const auto &point : points) {
+        size_t neighbour = 0;
+        for (int ny = point.y - 1; ny <= point.y + 1; ny++) {
+            for (int nx = point.x - 1; nx <= point.x + 1; nx++) {
+                if (nx == point.x && ny == point.y) continue;
+                if (nx >= 0 && nx < w && ny >= 0 && ny < h) {
+                    uchar pixel_value = pixel_mask[size_t(ny) * size_t(w) + size_t(nx)];
+                    uchar link_value = link_mask[
+                        (size_t(point.y) * size_t(w) + size_t(point.x)) * neighbours + neighbour];
+                    if (pixel_value && link_value) {
+                        join(point.x + point.y * w, nx + ny * w, &parents, &ranks);
+                    }
+                }
+                neighbour++;
+            }
+        }
+    }
+
+    return get_all(points, w, h, &parents);
+}
+}  // namespace
+
+TextDetectionModel::TextDetectionModel(const std::string& modelFileName, const cv::Size& inputSize,
+    float clsConfThreshold, float linkConfThreshold, int maxBoxes) :
+    ModelBase(modelFileName),
+    inputSize(inputSize),
+    clsConfThreshold(clsConfThreshold),
+    linkConfThreshold(linkConfThreshold),
+    maxBoxes(maxBoxes) {
+}
+
+void TextDetectionModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
+    // --------------------------- Configure input & output ---------------------------------------------
+    // --------------------------- Prepare input blobs -----------------------------------------------------
+    InputsDataMap inputInfo(cnnNetwork.getInputsInfo());
+    if (inputInfo.size() != 1) {
+        throw std::logic_error("The network should have only one input");
+    }
+    inputsNames.push_back(inputInfo.begin()->first);
+
+    SizeVector inputDims = inputInfo.begin()->second->getTensorDesc().getDims();
+    if (inputDims.size() != 4 || inputDims[1] != 3) {
+        throw std::logic_error("The network input should be a 3-channel image");
+    }
+    if (inputSize != cv::Size()) {
+        inputDims[2] = static_cast<size_t>(inputSize.height);
+        inputDims[3] = static_cast<size_t>(inputSize.width);
+        cnnNetwork.reshape({{inputsNames[0], inputDims}});
+    }
+    inputSize = cv::Size(static_cast<int>(inputDims[3]), static_cast<int>(inputDims[2]));
+
+    InputInfo::Ptr input = cnnNetwork.getInputsInfo().begin()->second;
+    input->setLayout(Layout::NCHW);
+    input->setPrecision(Precision::U8);
+
+    // --------------------------- Prepare output blobs -----------------------------------------------------
+    for (const auto& output : cnnNetwork.getOutputsInfo()) {
+        output.second->setPrecision(Precision::FP32);
+        const SizeVector& outputDims = output.second->getTensorDesc().getDims();
+        if (outputDims.size() < 2) {
+            continue;
+        }
+        if (outputDims[1] == 2) {
+            clsOutputName = output.first;
+        }
+        else if (outputDims[1] == 16) {
+            linkOutputName = output.first;
+        }
+        else if (outputDims[1] == 5) {
+            boxesOutputName = output.first;
+        }
+    }
+
+    if (!clsOutputName.empty() && !linkOutputName.empty()) {
+        outputsNames = {clsOutputName, linkOutputName};
+        boxesOutputName.clear();
+    }
+    else if (!boxesOutputName.empty()) {
+        outputsNames = {boxesOutputName};
+        clsOutputName.clear();
+        linkOutputName.clear();
+    }
+    else {
+        throw std::logic_error("Failed to determine output blob names");
+    }
+}
+
+std::shared_ptr<InternalModelData> TextDetectionModel::preprocess(const InputData& inputData,
+    InferenceEngine::InferRequest::Ptr& request) {
+    const cv::Mat& img = inputData.asRef<ImageInputData>().inputImage;
+    Blob::Ptr inputBlob = request->GetBlob(inputsNames[0]);
+    matU8ToBlob<uint8_t>(img, inputBlob);
+    return internalImageDataPool.make(img.cols, img.rows);
+}
+
+std::unique_ptr<ResultBase> TextDetectionModel::postprocess(InferenceResult& infResult) {
+    const int kMinArea = 300;
+    const int kMinHeight = 10;
+
+    auto retVal = resultsPool.acquire();
+    TextDetectionResult* result = retVal.get();
+    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+
+    const auto& imgData = infResult.internalModelData->asRef<InternalImageModelData>();
+    const cv::Size imageSize(imgData.inputImgWidth, imgData.inputImgHeight);
+
+    if (!clsOutputName.empty()) {
+        // PostProcessing for PixelLink Text Detection model
+        const MemoryBlob::Ptr& clsBlob = infResult.outputsData.at(clsOutputName);
+        const MemoryBlob::Ptr& linkBlob = infResult.outputsData.at(linkOutputName);
+        auto cls_shape = clsBlob->getTensorDesc().getDims();
+        auto link_shape = linkBlob->getTensorDesc().getDims();
+        const int h = static_cast<int>(cls_shape[2]);
+        const int w = static_cast<int>(cls_shape[3]);
+        if (link_shape[2] != cls_shape[2] || link_shape[3] != cls_shape[3])
+            throw std::runtime_error("Pixel and link outputs must have the same size");
+        const size_t plane_size = size_t(h) * size_t(w);
+        const size_t neighbours = link_shape[1] / 2;
+
+        LockedMemory<const void> clsOutputMapped = clsBlob->rmap();
+        std::vector<uchar> pixel_mask;
+        positiveClassMask(clsOutputMapped.as<const float *>(), 1, plane_size, clsConfThreshold, &pixel_mask);
+
+        LockedMemory<const void> linkOutputMapped = linkBlob->rmap();
+        std::vector<uchar> link_mask;
+        positiveClassMask(linkOutputMapped.as<const float *>(), neighbours, plane_size, linkConfThreshold,
+                          &link_mask);
+
+        cv::Mat mask = decodeImageByJoin(pixel_mask, link_mask, h, w, neighbours);
+        result->boxes = maskToBoxes(mask, static_cast<float>(kMinArea), static_cast<float>(kMinHeight), imageSize);
+    } else {
+        // PostProcessing for Horizontal Text Detection model
+        const MemoryBlob::Ptr& boxesBlob = infResult.outputsData.at(boxesOutputName);
+        auto boxes_shape = boxesBlob->getTensorDesc().getDims();
+        size_t boxes_data_size = boxes_shape[0] * boxes_shape[1];
+        LockedMemory<const void> boxesOutputMapped = boxesBlob->rmap();
+        result->boxes = coordToBoxes(boxesOutputMapped.as<const float *>(), boxes_data_size,
+                                     static_cast<float>(kMinArea), static_cast<float>(kMinHeight),
+                                     inputSize, imageSize);
+    }
+
+    if (maxBoxes >= 0 && static_cast<int>(result->boxes.size()) > maxBoxes) {
+        std::partial_sort(result->boxes.begin(), result->boxes.begin() + maxBoxes, result->boxes.end(),
+            [](const cv::RotatedRect& a, const cv::RotatedRect& b) {
+                return a.size.area() > b.size.area();
+            });
+        result->boxes.resize(static_cast<size_t>(maxBoxes));
+    }
+
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
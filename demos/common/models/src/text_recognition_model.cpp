@@ -0,0 +1,402 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "models/text_recognition_model.h"
+#include "models/device_postprocessing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/hal.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <samples/ocv_common.hpp>
+
+using namespace InferenceEngine;
+
+namespace  {
+    // Writes exp(score - max score) of every class to exps and returns their sum, so the softmax probability
+    // of a class is its exp divided by the sum. argmax is the first class with the max score.
+    // The max search and the sum are vectorized, the exponents are computed by vectorized cv::hal::exp32f()
+    float expShiftedScores(const float* scores, int num_classes, float* exps, int* argmax) {
+        float max_val = scores[0];
+        int i = 0;
+#if CV_SIMD
+        const int lanes = cv::v_float32::nlanes;
+        if (num_classes >= lanes) {
+            cv::v_float32 max_vals = cv::vx_load(scores);
+            for (i = lanes; i + lanes <= num_classes; i += lanes) {
+                max_vals = cv::v_max(max_vals, cv::vx_load(scores + i));
+            }
+            max_val = cv::v_reduce_max(max_vals);
+        }
+#endif
+        for (; i < num_classes; i++) {
+            max_val = std::max(max_val, scores[i]);
+        }
+        *argmax = static_cast<int>(std::find(scores, scores + num_classes, max_val) - scores);
+
+        i = 0;
+#if CV_SIMD
+        const cv::v_float32 shift = cv::vx_setall_f32(max_val);
+        for (; i + lanes <= num_classes; i += lanes) {
+            cv::v_store(exps + i, cv::vx_load(scores + i) - shift);
+        }
+#endif
+        for (; i < num_classes; i++) {
+            exps[i] = scores[i] - max_val;
+        }
+        cv::hal::exp32f(exps, exps, num_classes);
+
+        float sum = 0.f;
+        i = 0;
+#if CV_SIMD
+        cv::v_float32 sums = cv::vx_setzero_f32();
+        for (; i + lanes <= num_classes; i += lanes) {
+            sums += cv::vx_load(exps + i);
+        }
+        sum = cv::v_reduce_sum(sums);
+#endif
+        for (; i < num_classes; i++) {
+            sum += exps[i];
+        }
+        return sum;
+    }
+
+    // Beam search keeps the prefixes in a tree, so a prefix is its node id and two beams are merged by comparing ids
+    struct PrefixNode {
+        int parent;  //!< -1 for the empty prefix
+        int symbol;  //!< The last char of the prefix
+    };
+
+    struct BeamElement {
+        int node;                    //!< The id of the prefix node, -1 for an extension which isn't in the tree yet
+        int parent;                  //!< The node which is extended by symbol if it isn't in the tree yet
+        int symbol;
+        float prob_blank;            //!< The probability that the last char in CTC sequence
+                                     //!< for the beam element is the special blank char
+        float prob_not_blank;        //!< The probability that the last char in CTC sequence
+                                     //!< for the beam element is NOT the special blank char
+
+        float prob() const {         //!< The probability of the beam element.
+            return prob_blank + prob_not_blank;
+        }
+    };
+
+    // The buffers are reused by the calls in the same thread, so decoding doesn't allocate after the first sequences
+    struct BeamSearchBuffers {
+        std::vector<PrefixNode> nodes;
+        std::vector<BeamElement> curr;
+        std::vector<BeamElement> last;
+        std::vector<int> beam_of_node;   //!< The index of the beam of last with the prefix, -1 if none
+        std::vector<int> extension_ids;  //!< The elements of curr which extend a beam of last by a char, -1 if none
+        std::vector<float> prob;
+    };
+
+// The decoders read the output blob in place: the scores of step t are data + t * stride, so a batch item is
+// decoded without copying its interleaved sequence out. The text is written to the string of the pooled result,
+// so its memory is reused
+// Appends the symbol unless it's the pad or repeats the previous symbol without a pad between them
+void appendCTCSymbol(char symbol, char pad_symbol, bool& prev_pad, std::string& res) {
+    if (symbol != pad_symbol) {
+        if (res.empty() || prev_pad || symbol != res.back()) {
+            prev_pad = false;
+            res += symbol;
+        }
+    } else {
+        prev_pad = true;
+    }
+}
+
+void CTCGreedyDecoder(const float* data, size_t sequence_length, size_t stride, const std::string& alphabet,
+                      char pad_symbol, std::string& res, double *conf) {
+    const int num_classes = static_cast<int>(alphabet.length());
+    static thread_local std::vector<float> exps;
+    exps.resize(num_classes);
+
+    res.clear();
+    bool prev_pad = false;
+    *conf = 1;
+    for (size_t t = 0; t < sequence_length; t++) {
+        int argmax;
+        const float sum = expShiftedScores(data + t * stride, num_classes, exps.data(), &argmax);
+        // The max score gives exp(0) = 1
+        (*conf) /= sum;
+
+        appendCTCSymbol(alphabet[argmax], pad_symbol, prev_pad, res);
+    }
+}
+
+// Greedy decoding of the most probable symbols and their probabilities selected by the device
+void CTCGreedyDecoder(const int32_t* symbols, const float* probs, size_t sequence_length, size_t stride,
+                      const std::string& alphabet, char pad_symbol, std::string& res, double *conf) {
+    res.clear();
+    bool prev_pad = false;
+    *conf = 1;
+    for (size_t t = 0; t < sequence_length; t++) {
+        (*conf) *= probs[t * stride];
+        appendCTCSymbol(alphabet[symbols[t * stride]], pad_symbol, prev_pad, res);
+    }
+}
+
+void CTCBeamSearchDecoder(const float* data, size_t sequence_length, size_t stride, const std::string& alphabet,
+                          char pad_symbol, std::string& res, double *conf, int bandwidth) {
+    const int num_classes = static_cast<int>(alphabet.length());
+    const int blank = num_classes - 1;
+
+    static thread_local BeamSearchBuffers buffers;
+    std::vector<PrefixNode> &nodes = buffers.nodes;
+    std::vector<BeamElement> &curr = buffers.curr;
+    std::vector<BeamElement> &last = buffers.last;
+    std::vector<int> &beam_of_node = buffers.beam_of_node;
+    std::vector<int> &extension_ids = buffers.extension_ids;
+    std::vector<float> &prob = buffers.prob;
+    nodes.clear();
+    beam_of_node.clear();
+    last.clear();
+    prob.resize(num_classes);
+
+    nodes.push_back(PrefixNode{-1, -1});
+    last.push_back(BeamElement{0, -1, -1, 1.f, 0.f});
+
+    for (size_t t = 0; t < sequence_length; t++) {
+        int argmax;
+        const float sum = expShiftedScores(data + t * stride, num_classes, prob.data(), &argmax);
+        for (int i = 0; i < num_classes; i++) {
+            prob[i] /= sum;
+        }
+
+        // The beams of last have different prefixes, so the ones which aren't extended go to curr without merging
+        curr.clear();
+        for (const auto& candidate : last) {
+            const int n = nodes[candidate.node].symbol;
+            const float prob_not_blank = n >= 0 ? candidate.prob_not_blank * prob[n] : 0.f;
+            curr.push_back(BeamElement{candidate.node, -1, -1, candidate.prob() * prob[blank], prob_not_blank});
+        }
+
+        // An extension of one beam can be the prefix of another one only if the other beam's parent is in last
+        beam_of_node.resize(nodes.size(), -1);
+        for (size_t b = 0; b < last.size(); b++) {
+            beam_of_node[last[b].node] = static_cast<int>(b);
+        }
+        extension_ids.assign(last.size() * blank, -1);
+        for (size_t b = 0; b < last.size(); b++) {
+            const PrefixNode &node = nodes[last[b].node];
+            if (node.parent >= 0 && beam_of_node[node.parent] >= 0) {
+                extension_ids[beam_of_node[node.parent] * blank + node.symbol] = static_cast<int>(b);
+            }
+        }
+        for (const auto& candidate : last) {
+            beam_of_node[candidate.node] = -1;
+        }
+
+        for (size_t b = 0; b < last.size(); b++) {
+            const BeamElement &candidate = last[b];
+            const int n = nodes[candidate.node].symbol;
+            for (int i = 0; i < blank; i++) {
+                const float prob_not_blank = prob[i] * (n == i ? candidate.prob_blank : candidate.prob());
+                const int extension_id = extension_ids[b * blank + i];
+                if (extension_id >= 0) {
+                    curr[extension_id].prob_not_blank += prob_not_blank;
+                } else {
+                    curr.push_back(BeamElement{-1, candidate.node, i, 0.f, prob_not_blank});
+                }
+            }
+        }
+
+        // Only the best beams are ordered, the rest of them are dropped
+        const size_t num_to_copy = std::min(static_cast<size_t>(bandwidth), curr.size());
+        std::partial_sort(curr.begin(), curr.begin() + num_to_copy, curr.end(),
+                          [](const BeamElement &a, const BeamElement &b) -> bool {
+            return a.prob() > b.prob();
+        });
+
+        last.clear();
+        for (size_t b = 0; b < num_to_copy; b++) {
+            BeamElement element = curr[b];
+            if (element.node < 0) {
+                element.node = static_cast<int>(nodes.size());
+                nodes.push_back(PrefixNode{element.parent, element.symbol});
+            }
+            last.push_back(element);
+        }
+    }
+
+    *conf = last[0].prob();
+    res.clear();
+    for (int node = last[0].node; nodes[node].parent >= 0; node = nodes[node].parent) {
+        res += alphabet[nodes[node].symbol];
+    }
+    std::reverse(res.begin(), res.end());
+}
+
+// Returns the index of the corner of the rectangle the text starts from: the upper one of the two leftmost corners
+int topLeftPointIdx(const cv::Point2f (&points)[4]) {
+    cv::Point2f most_left(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    cv::Point2f almost_most_left(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+
+    int most_left_idx = -1;
+    int almost_most_left_idx = -1;
+
+    for (int i = 0; i < 4; i++) {
+        if (most_left.x > points[i].x) {
+            if (most_left.x < std::numeric_limits<float>::max()) {
+                almost_most_left = most_left;
+                almost_most_left_idx = most_left_idx;
+            }
+            most_left = points[i];
+            most_left_idx = i;
+        }
+        if (almost_most_left.x > points[i].x && points[i] != most_left) {
+            almost_most_left = points[i];
+            almost_most_left_idx = i;
+        }
+    }
+
+    if (almost_most_left.y < most_left.y) {
+        most_left_idx = almost_most_left_idx;
+    }
+    return most_left_idx;
+}
+}  // namespace
+
+TextRecognitionModel::TextRecognitionModel(const std::string& modelFileName, const std::string& alphabet,
+    int bandwidth) :
+    ModelBase(modelFileName),
+    alphabet(alphabet),
+    bandwidth(bandwidth) {
+    if (alphabet.size() < 2) {
+        throw std::invalid_argument("The alphabet should contain at least one symbol and the blank symbol");
+    }
+}
+
+void TextRecognitionModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
+    // The greedy decoder needs only the most probable symbol of every step and its probability, the device
+    // selects them after the softmax. The beam search needs all the probabilities
+    const OutputsDataMap& scoresInfo = cnnNetwork.getOutputsInfo();
+    if (scoresInfo.size() != 1) {
+        throw std::logic_error("The network should have only one output");
+    }
+    const SizeVector outputDims = scoresInfo.begin()->second->getTensorDesc().getDims();
+    TopKOutputs topKOutputs;
+    if (devicePostprocessing && bandwidth == 0 && outputDims.size() == 3) {
+        topKOutputs = appendTopK(cnnNetwork, 1, 2, true, true);
+    }
+    symbolsOnDevice = !topKOutputs.indicesName.empty();
+
+    // --------------------------- Configure input & output ---------------------------------------------
+    // --------------------------- Prepare input blobs -----------------------------------------------------
+    InputsDataMap inputInfo(cnnNetwork.getInputsInfo());
+    if (inputInfo.size() != 1) {
+        throw std::logic_error("The network should have only one input");
+    }
+    inputsNames.push_back(inputInfo.begin()->first);
+
+    const SizeVector& inputDims = inputInfo.begin()->second->getTensorDesc().getDims();
+    if (inputDims.size() != 4 || (inputDims[1] != 1 && inputDims[1] != 3)) {
+        throw std::logic_error("The network input should be a 1 or 3-channel image");
+    }
+    inputSize = cv::Size(static_cast<int>(inputDims[3]), static_cast<int>(inputDims[2]));
+    inputInfo.begin()->second->setLayout(Layout::NCHW);
+    inputInfo.begin()->second->setPrecision(Precision::U8);
+
+    // --------------------------- Prepare output blobs -----------------------------------------------------
+    const OutputsDataMap& outputsInfo = cnnNetwork.getOutputsInfo();
+    if (symbolsOnDevice) {
+        outputsNames.push_back(topKOutputs.valuesName);
+        outputsNames.push_back(topKOutputs.indicesName);
+    }
+    else {
+        outputsNames.push_back(outputsInfo.begin()->first);
+    }
+    outputsInfo.at(outputsNames[0])->setPrecision(Precision::FP32);
+    if (outputDims.size() != 3) {
+        throw std::logic_error("The text recognition model output should have 3 dimensions");
+    }
+    if (outputDims[2] != alphabet.size()) {
+        throw std::logic_error("The text recognition model does not correspond to alphabet");
+    }
+    if (outputDims[1] != inputDims[0]) {
+        throw std::logic_error("The text recognition model output must have the batch as its second dimension");
+    }
+    sequenceLength = outputDims[0];
+    batchSize = outputDims[1];
+}
+
+std::vector<cv::Point2f> TextRecognitionModel::orderedCorners(const cv::RotatedRect& rect) {
+    cv::Point2f vertices[4];
+    rect.points(vertices);
+    const int first = topLeftPointIdx(vertices);
+
+    std::vector<cv::Point2f> corners(4);
+    for (int i = 0; i < 4; i++) {
+        corners[i] = vertices[(first + i) % 4];
+    }
+    return corners;
+}
+
+std::shared_ptr<InternalModelData> TextRecognitionModel::preprocess(const InputData& inputData,
+    InferenceEngine::InferRequest::Ptr& request) {
+    return preprocessBatchItem(inputData, request, 0);
+}
+
+std::shared_ptr<InternalModelData> TextRecognitionModel::preprocessBatchItem(const InputData& inputData,
+    InferenceEngine::InferRequest::Ptr& request, size_t batchIndex) {
+    const cv::Mat& img = inputData.asRef<ImageInputData>().inputImage;
+    cv::Mat transform;
+    auto roiData = dynamic_cast<const RotatedRoiInputData*>(&inputData);
+    if (roiData) {
+        const std::vector<cv::Point2f> corners = orderedCorners(roiData->roi);
+        const std::vector<cv::Point2f> from{corners[0], corners[1], corners[2]};
+        const std::vector<cv::Point2f> to{cv::Point2f(0.0f, 0.0f),
+            cv::Point2f(static_cast<float>(inputSize.width - 1), 0.0f),
+            cv::Point2f(static_cast<float>(inputSize.width - 1), static_cast<float>(inputSize.height - 1))};
+        transform = cv::getAffineTransform(from, to);
+    }
+    else {
+        transform = resizeTransform(cv::Rect(0, 0, img.cols, img.rows), inputSize);
+    }
+
+    Blob::Ptr inputBlob = request->GetBlob(inputsNames[0]);
+    warpAffineToBlob<uint8_t>(img, transform, inputBlob, static_cast<int>(batchIndex));
+
+    return internalImageDataPool.make(img.cols, img.rows);
+}
+
+std::unique_ptr<ResultBase> TextRecognitionModel::postprocess(InferenceResult& infResult) {
+    auto retVal = resultsPool.acquire();
+    TextRecognitionResult* result = retVal.get();
+    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+
+    if (symbolsOnDevice) {
+        // The outputs are sequence x batch x 1
+        LockedMemory<const void> probsMapped = infResult.outputsData[outputsNames[0]]->rmap();
+        LockedMemory<const void> symbolsMapped = infResult.outputsData[outputsNames[1]]->rmap();
+        CTCGreedyDecoder(symbolsMapped.as<const int32_t*>() + infResult.batchIndex,
+            probsMapped.as<const float*>() + infResult.batchIndex, sequenceLength, batchSize, alphabet, alphabet.back(),
+            result->text, &result->confidence);
+        return std::unique_ptr<ResultBase>(retVal.release());
+    }
+
+    // The output is sequence x batch x classes, the sequences of the batch items are interleaved
+    LockedMemory<const void> outputMapped = infResult.getFirstOutputBlob()->rmap();
+    const size_t numClasses = alphabet.size();
+    const float* sequence = outputMapped.as<const float*>() + infResult.batchIndex * numClasses;
+    const size_t stride = batchSize * numClasses;
+
+    if (bandwidth == 0) {
+        CTCGreedyDecoder(sequence, sequenceLength, stride, alphabet, alphabet.back(), result->text, &result->confidence);
+    }
+    else {
+        CTCBeamSearchDecoder(sequence, sequenceLength, stride, alphabet, alphabet.back(), result->text,
+                             &result->confidence, bandwidth);
+    }
+
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
@@ -15,6 +15,7 @@ public:
     void setHistorySize(std::size_t size);
     std::size_t getHistorySize() const;
     void collectData();
+    void addSample(const std::vector<double>& cpuLoad); // adds sample collected elsewhere, e.g. by SystemSampler
     std::deque<std::vector<double>> getLastHistory() const;
     std::vector<double> getMeanCpuLoad() const;
 
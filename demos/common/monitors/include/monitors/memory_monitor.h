@@ -14,6 +14,8 @@ public:
     void setHistorySize(std::size_t size);
     std::size_t getHistorySize() const;
     void collectData();
+    // adds sample collected elsewhere, e.g. by SystemSampler. All values are in GiB
+    void addSample(double memTotal, double usedMem, double usedSwap);
     std::deque<std::pair<double, double>> getLastHistory() const;
     double getMeanMem() const; // in GiB
     double getMeanSwap() const;
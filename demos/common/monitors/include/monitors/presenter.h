@@ -6,6 +6,7 @@
 
 #include <chrono>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <set>
 
@@ -13,6 +14,7 @@
 
 #include "cpu_monitor.h"
 #include "memory_monitor.h"
+#include "system_sampler.h"
 
 enum class MonitorType{CpuAverage, DistributionCpu, Memory};
 
@@ -35,10 +37,18 @@ public:
     const cv::Size graphSize;
     const int graphPadding;
 private:
-    std::chrono::steady_clock::time_point prevTimeStamp;
+    void renderOverlay(int frameWidth);
+
+    std::unique_ptr<SystemSampler> sampler; // started when a monitor is enabled for the first time
+    std::shared_ptr<const SystemSnapshot> lastSnapshot;
     std::size_t historySize;
     CpuMonitor cpuMonitor;
     bool distributionCpuEnabled;
     MemoryMonitor memoryMonitor;
     std::ostringstream strStream;
+    bool isOverlayOutdated; // monitors or their data have changed since the overlay was rendered
+    int overlayFrameWidth; // the graphs are centered and the ones which don't fit are skipped, so it depends on it
+    cv::Point overlayPos;
+    cv::Mat overlayPremultiplied; // BGR colors multiplied by alpha
+    cv::Mat overlayInvAlpha; // 255 - alpha for every channel
 };
@@ -0,0 +1,58 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ThreadCpuTime {
+    long id;
+    std::string name; // may be empty if the system doesn't provide names
+    double cpuTime; // user and kernel time in seconds since the thread started
+};
+
+struct SystemSnapshot {
+    std::chrono::steady_clock::time_point timeStamp;
+    std::vector<double> coresLoad; // in [0, 1] for every core, empty if it isn't measured yet
+    double memTotal, usedMem, usedSwap; // in GiB
+    double processRss; // resident set size of the current process in GiB
+    std::vector<ThreadCpuTime> threadsCpuTime; // threads of the current process, if their collection is enabled
+};
+
+// Samples system state in a background thread, so callers only take the latest snapshot without reading and
+// parsing system files. Snapshots are immutable and published atomically, a new one is created every period.
+class SystemSampler {
+public:
+    explicit SystemSampler(std::chrono::milliseconds period = std::chrono::milliseconds{1000},
+        bool collectThreadsCpuTime = false);
+    ~SystemSampler();
+    SystemSampler(const SystemSampler&) = delete;
+    SystemSampler& operator=(const SystemSampler&) = delete;
+
+    // Returns the latest snapshot or nullptr if the first one isn't ready yet. The same pointer is returned until
+    // the next snapshot is published, so the caller can compare pointers to find out if there's a new sample.
+    // Rethrows the exception if sampling has failed.
+    std::shared_ptr<const SystemSnapshot> getSnapshot() const;
+
+private:
+    void samplingLoop();
+
+    const std::chrono::milliseconds period;
+    const bool collectThreadsCpuTime;
+    std::shared_ptr<const SystemSnapshot> snapshot; // accessed with std::atomic_load and std::atomic_store only
+    std::exception_ptr samplingException;
+    std::atomic<bool> hasFailed;
+    bool isStopping;
+    std::mutex mtx;
+    std::condition_variable stopCondVar;
+    std::thread samplingThread;
+};
@@ -173,15 +173,17 @@ void CpuMonitor::setHistorySize(std::size_t size) {
 }
 
 void CpuMonitor::collectData() {
-    std::vector<double> cpuLoad = performanceCounter->getCpuLoad();
+    addSample(performanceCounter->getCpuLoad());
+}
 
+void CpuMonitor::addSample(const std::vector<double>& cpuLoad) {
     if (!cpuLoad.empty()) {
         for (std::size_t i = 0; i < cpuLoad.size(); ++i) {
             cpuLoadSum[i] += cpuLoad[i];
         }
         ++samplesNumber;
 
-        cpuLoadHistory.push_back(std::move(cpuLoad));
+        cpuLoadHistory.push_back(cpuLoad);
         if (cpuLoadHistory.size() > historySize) {
             cpuLoadHistory.pop_front();
         }
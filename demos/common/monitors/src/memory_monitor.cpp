@@ -167,14 +167,18 @@ void MemoryMonitor::setHistorySize(std::size_t size) {
 
 void MemoryMonitor::collectData() {
     MemState memState = performanceCounter->getMemState();
-    maxMemTotal = std::max(maxMemTotal, memState.memTotal);
-    memSum += memState.usedMem;
-    swapSum += memState.usedSwap;
+    addSample(memState.memTotal, memState.usedMem, memState.usedSwap);
+}
+
+void MemoryMonitor::addSample(double memTotal, double usedMem, double usedSwap) {
+    maxMemTotal = std::max(maxMemTotal, memTotal);
+    memSum += usedMem;
+    swapSum += usedSwap;
     ++samplesNumber;
-    maxMem = std::max(maxMem, memState.usedMem);
-    maxSwap = std::max(maxSwap, memState.usedSwap);
+    maxMem = std::max(maxMem, usedMem);
+    maxSwap = std::max(maxSwap, usedSwap);
 
-    memSwapUsageHistory.emplace_back(memState.usedMem, memState.usedSwap);
+    memSwapUsageHistory.emplace_back(usedMem, usedSwap);
     if (memSwapUsageHistory.size() > historySize) {
         memSwapUsageHistory.pop_front();
     }
@@ -6,6 +6,7 @@
 #include <chrono>
 #include <iomanip>
 #include <numeric>
+#include <vector>
 
 #include "monitors/presenter.h"
 
@@ -38,7 +39,9 @@ Presenter::Presenter(std::set<MonitorType> enabledMonitors,
             graphPadding{std::max(1, static_cast<int>(graphSize.width * 0.05))},
             historySize{historySize},
             distributionCpuEnabled{false},
-            strStream{std::ios_base::app} {
+            strStream{std::ios_base::app},
+            isOverlayOutdated{true},
+            overlayFrameWidth{0} {
     for (MonitorType monitor : enabledMonitors) {
         addRemoveMonitor(monitor);
     }
@@ -55,6 +58,7 @@ void Presenter::addRemoveMonitor(MonitorType monitor) {
         // add round up to and an extra element if don't reach graph edge
         updatedHistorySize = (graphSize.width + sampleStep - 1) / sampleStep + 1;
     }
+    isOverlayOutdated = true;
     switch(monitor) {
         case MonitorType::CpuAverage: {
             if (cpuMonitor.getHistorySize() > 1 && distributionCpuEnabled) {
@@ -92,6 +96,7 @@ void Presenter::addRemoveMonitor(MonitorType monitor) {
 void Presenter::handleKey(int key) {
     key = std::toupper(key);
     if ('H' == key) {
+        isOverlayOutdated = true;
         if (0 == cpuMonitor.getHistorySize() && memoryMonitor.getHistorySize() <= 1) {
             addRemoveMonitor(MonitorType::CpuAverage);
             addRemoveMonitor(MonitorType::DistributionCpu);
@@ -110,26 +115,54 @@ void Presenter::handleKey(int key) {
 }
 
 void Presenter::drawGraphs(cv::Mat& frame) {
-    const std::chrono::steady_clock::time_point curTimeStamp = std::chrono::steady_clock::now();
-    if (curTimeStamp - prevTimeStamp >= std::chrono::milliseconds{1000}) {
-        prevTimeStamp = curTimeStamp;
-        if (0 != cpuMonitor.getHistorySize()) {
-            cpuMonitor.collectData();
+    // System data is read by the sampler thread, the render loop only takes new snapshots
+    if (0 != cpuMonitor.getHistorySize() || memoryMonitor.getHistorySize() > 1) {
+        if (!sampler) {
+            sampler.reset(new SystemSampler{std::chrono::milliseconds{1000}});
         }
-        if (memoryMonitor.getHistorySize() > 1) {
-            memoryMonitor.collectData();
+        std::shared_ptr<const SystemSnapshot> snapshot = sampler->getSnapshot();
+        if (snapshot && snapshot != lastSnapshot) {
+            lastSnapshot = snapshot;
+            if (0 != cpuMonitor.getHistorySize()) {
+                cpuMonitor.addSample(snapshot->coresLoad);
+            }
+            if (memoryMonitor.getHistorySize() > 1) {
+                memoryMonitor.addSample(snapshot->memTotal, snapshot->usedMem, snapshot->usedSwap);
+            }
+            isOverlayOutdated = true;
         }
     }
 
+    // The graphs are rendered only when they change, every frame just gets the cached overlay blended
+    if (isOverlayOutdated || frame.cols != overlayFrameWidth) {
+        renderOverlay(frame.cols);
+    }
+    cv::Rect intersection = cv::Rect{overlayPos, overlayPremultiplied.size()} & cv::Rect{0, 0, frame.cols, frame.rows};
+    if (!intersection.area()) {
+        return;
+    }
+    cv::Mat graphs = frame(intersection);
+    cv::Rect overlayRoi = intersection - overlayPos;
+    cv::multiply(graphs, overlayInvAlpha(overlayRoi), graphs, 1.0 / 255);
+    cv::add(graphs, overlayPremultiplied(overlayRoi), graphs);
+}
+
+void Presenter::renderOverlay(int frameWidth) {
+    isOverlayOutdated = false;
+    overlayFrameWidth = frameWidth;
+
     int numberOfEnabledMonitors = (cpuMonitor.getHistorySize() > 1) + distributionCpuEnabled
         + (memoryMonitor.getHistorySize() > 1);
     int panelWidth = graphSize.width * numberOfEnabledMonitors
         + std::max(0, numberOfEnabledMonitors - 1) * graphPadding;
-    while (panelWidth > frame.cols) {
+    while (panelWidth > frameWidth) {
         panelWidth = std::max(0, panelWidth - graphSize.width - graphPadding);
         --numberOfEnabledMonitors; // can't draw all monitors
     }
-    int graphPos = std::max(0, (frame.cols - 1 - panelWidth) / 2);
+    overlayPos = {std::max(0, (frameWidth - 1 - panelWidth) / 2), yPos};
+    // Both alpha and colors are opaque for the graphs' lines and text, the background of graphs is half transparent
+    cv::Mat overlay(graphSize.height, std::max(0, panelWidth), CV_8UC4, cv::Scalar::all(0));
+    int graphPos = 0;
     int textGraphSplittingLine = graphSize.height / 5;
     int graphRectHeight = graphSize.height - textGraphSplittingLine;
     int sampleStep = 1;
@@ -141,12 +174,8 @@ void Presenter::drawGraphs(cv::Mat& frame) {
 
     if (cpuMonitor.getHistorySize() > 1 && possibleHistorySize > 1 && --numberOfEnabledMonitors >= 0) {
         std::deque<std::vector<double>> lastHistory = cpuMonitor.getLastHistory();
-        cv::Rect intersection = cv::Rect{cv::Point(graphPos, yPos), graphSize} & cv::Rect{0, 0, frame.cols, frame.rows};
-        if (!intersection.area()) {
-            return;
-        }
-        cv::Mat graph = frame(intersection);
-        graph = graph / 2 + cv::Scalar{127, 127, 127};
+        cv::Mat graph = overlay(cv::Rect{cv::Point{graphPos, 0}, graphSize});
+        graph = cv::Scalar{255, 255, 255, 128};
 
         int lineXPos = graph.cols - 1;
         std::vector<cv::Point> averageLoad(lastHistory.size());
@@ -157,11 +186,11 @@ void Presenter::drawGraphs(cv::Mat& frame) {
             lineXPos -= sampleStep;
         }
 
-        cv::polylines(graph, averageLoad, false, {255, 0, 0}, 2);
-        cv::rectangle(frame, cv::Rect{
-                cv::Point{graphPos, yPos + textGraphSplittingLine},
+        cv::polylines(graph, averageLoad, false, {255, 0, 0, 255}, 2);
+        cv::rectangle(overlay, cv::Rect{
+                cv::Point{graphPos, textGraphSplittingLine},
                 cv::Size{graphSize.width, graphSize.height - textGraphSplittingLine}
-            }, {0, 0, 0});
+            }, {0, 0, 0, 255});
         strStream.str("CPU");
         if (!lastHistory.empty()) {
             strStream << ": " << std::fixed << std::setprecision(1)
@@ -179,19 +208,15 @@ void Presenter::drawGraphs(cv::Mat& frame) {
             cv::Point{(graphSize.width - textWidth) / 2, textGraphSplittingLine - 1},
             cv::FONT_HERSHEY_SIMPLEX,
             textGraphSplittingLine * 0.04,
-            {70, 0, 0},
+            {70, 0, 0, 255},
             1);
         graphPos += graphSize.width + graphPadding;
     }
 
     if (distributionCpuEnabled && --numberOfEnabledMonitors >= 0) {
         std::deque<std::vector<double>> lastHistory = cpuMonitor.getLastHistory();
-        cv::Rect intersection = cv::Rect{cv::Point(graphPos, yPos), graphSize} & cv::Rect{0, 0, frame.cols, frame.rows};
-        if (!intersection.area()) {
-            return;
-        }
-        cv::Mat graph = frame(intersection);
-        graph = graph / 2 + cv::Scalar{127, 127, 127};
+        cv::Mat graph = overlay(cv::Rect{cv::Point{graphPos, 0}, graphSize});
+        graph = cv::Scalar{255, 255, 255, 128};
 
         if (!lastHistory.empty()) {
             int rectXPos = 0;
@@ -201,17 +226,17 @@ void Presenter::drawGraphs(cv::Mat& frame) {
                 sum += coreLoad;
                 int height = static_cast<int>(graphRectHeight * coreLoad);
                 cv::Rect pillar{cv::Point{rectXPos, graph.rows - height}, cv::Size{step, height}};
-                cv::rectangle(graph, pillar, {255, 0, 0}, cv::FILLED);
-                cv::rectangle(graph, pillar, {0, 0, 0});
+                cv::rectangle(graph, pillar, {255, 0, 0, 255}, cv::FILLED);
+                cv::rectangle(graph, pillar, {0, 0, 0, 255});
                 rectXPos += step;
             }
             sum /= lastHistory.back().size();
             int yLine = graph.rows - static_cast<int>(graphRectHeight * sum);
-            cv::line(graph, cv::Point{0, yLine}, cv::Point{graph.cols, yLine}, {0, 255, 0}, 2);
+            cv::line(graph, cv::Point{0, yLine}, cv::Point{graph.cols, yLine}, {0, 255, 0, 255}, 2);
         }
-        cv::Rect border{cv::Point{graphPos, yPos + textGraphSplittingLine},
+        cv::Rect border{cv::Point{graphPos, textGraphSplittingLine},
             cv::Size{graphSize.width, graphSize.height - textGraphSplittingLine}};
-        cv::rectangle(frame, border, {0, 0, 0});
+        cv::rectangle(overlay, border, {0, 0, 0, 255});
         strStream.str("Core load");
         if (!lastHistory.empty()) {
             strStream << ": " << std::fixed << std::setprecision(1)
@@ -229,28 +254,24 @@ void Presenter::drawGraphs(cv::Mat& frame) {
             cv::Point{(graphSize.width - textWidth) / 2, textGraphSplittingLine - 1},
             cv::FONT_HERSHEY_SIMPLEX,
             textGraphSplittingLine * 0.04,
-            {0, 70, 0});
+            {0, 70, 0, 255});
         graphPos += graphSize.width + graphPadding;
     }
 
     if (memoryMonitor.getHistorySize() > 1 && possibleHistorySize > 1 && --numberOfEnabledMonitors >= 0) {
         std::deque<std::pair<double, double>> lastHistory = memoryMonitor.getLastHistory();
-        cv::Rect intersection = cv::Rect{cv::Point(graphPos, yPos), graphSize} & cv::Rect{0, 0, frame.cols, frame.rows};
-        if (!intersection.area()) {
-            return;
-        }
-        cv::Mat graph = frame(intersection);
-        graph = graph / 2 + cv::Scalar{127, 127, 127};
+        cv::Mat graph = overlay(cv::Rect{cv::Point{graphPos, 0}, graphSize});
+        graph = cv::Scalar{255, 255, 255, 128};
         int histxPos = graph.cols - 1;
         double range = std::min(memoryMonitor.getMaxMemTotal() + memoryMonitor.getMaxSwap(),
             (memoryMonitor.getMaxMem() + memoryMonitor.getMaxSwap()) * 1.2);
         if (lastHistory.size() > 1) {
             for (auto memUsageIt = lastHistory.rbegin(); memUsageIt != lastHistory.rend() - 1; ++memUsageIt) {
                 constexpr double SWAP_THRESHOLD = 10.0 / 1024; // 10 MiB
-                cv::Vec3b color =
+                cv::Scalar color =
                     (memoryMonitor.getMemTotal() * 0.95 > memUsageIt->first) || (memUsageIt->second < SWAP_THRESHOLD) ?
-                        cv::Vec3b{0, 255, 255} :
-                        cv::Vec3b{0, 0, 255};
+                        cv::Scalar{0, 255, 255, 255} :
+                        cv::Scalar{0, 0, 255, 255};
                 cv::Point right{histxPos,
                     graph.rows - static_cast<int>(graphRectHeight * (memUsageIt->first + memUsageIt->second) / range)};
                 cv::Point left{histxPos - sampleStep,
@@ -261,9 +282,9 @@ void Presenter::drawGraphs(cv::Mat& frame) {
             }
         }
 
-        cv::Rect border{cv::Point{graphPos, yPos + textGraphSplittingLine},
+        cv::Rect border{cv::Point{graphPos, textGraphSplittingLine},
             cv::Size{graphSize.width, graphSize.height - textGraphSplittingLine}};
-        cv::rectangle(frame, {border}, {0, 0, 0});
+        cv::rectangle(overlay, {border}, {0, 0, 0, 255});
         if (lastHistory.empty()) {
             strStream.str("Memory");
         } else {
@@ -282,8 +303,22 @@ void Presenter::drawGraphs(cv::Mat& frame) {
             cv::Point{(graphSize.width - textWidth) / 2, textGraphSplittingLine - 1},
             cv::FONT_HERSHEY_SIMPLEX,
             textGraphSplittingLine * 0.04,
-            {0, 35, 35});
+            {0, 35, 35, 255});
+    }
+
+    if (overlay.empty()) {
+        overlayPremultiplied.release();
+        overlayInvAlpha.release();
+        return;
     }
+    // Blending is frame * (255 - alpha) / 255 + color * alpha / 255, so the overlay is kept in the form which needs
+    // a multiplication and an addition only. OpenCV vectorizes both of them.
+    cv::Mat alpha, alpha3, color;
+    cv::extractChannel(overlay, alpha, 3);
+    cv::merge(std::vector<cv::Mat>{alpha, alpha, alpha}, alpha3);
+    cv::cvtColor(overlay, color, cv::COLOR_BGRA2BGR);
+    cv::multiply(color, alpha3, overlayPremultiplied, 1.0 / 255);
+    cv::subtract(cv::Scalar::all(255), alpha3, overlayInvAlpha);
 }
 
 std::string Presenter::reportMeans() const {
@@ -0,0 +1,189 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "monitors/system_sampler.h"
+
+#include <deque>
+#include <stdexcept>
+#include <utility>
+
+#include "monitors/cpu_monitor.h"
+#include "monitors/memory_monitor.h"
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+
+namespace {
+double getProcessRss() {
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters))) {
+        throw std::runtime_error("GetProcessMemoryInfo() failed");
+    }
+    return static_cast<double>(memoryCounters.WorkingSetSize) / (1024 * 1024 * 1024);
+}
+
+std::vector<ThreadCpuTime> getThreadsCpuTime() {
+    std::vector<ThreadCpuTime> threadsCpuTime;
+    HANDLE threadsSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (INVALID_HANDLE_VALUE == threadsSnapshot) {
+        throw std::runtime_error("CreateToolhelp32Snapshot() failed");
+    }
+    const DWORD processId = GetCurrentProcessId();
+    THREADENTRY32 threadEntry;
+    threadEntry.dwSize = sizeof(threadEntry);
+    for (BOOL isFound = Thread32First(threadsSnapshot, &threadEntry); isFound;
+            isFound = Thread32Next(threadsSnapshot, &threadEntry)) {
+        if (threadEntry.th32OwnerProcessID != processId) {
+            continue;
+        }
+        HANDLE thread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, threadEntry.th32ThreadID);
+        if (NULL == thread) {
+            continue; // the thread has finished already
+        }
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (GetThreadTimes(thread, &creationTime, &exitTime, &kernelTime, &userTime)) {
+            auto toSeconds = [](const FILETIME& time) {
+                return static_cast<double>((static_cast<unsigned long long>(time.dwHighDateTime) << 32)
+                    + time.dwLowDateTime) / 1e7; // FILETIME is in 100 ns units
+            };
+            threadsCpuTime.push_back({static_cast<long>(threadEntry.th32ThreadID), "",
+                toSeconds(kernelTime) + toSeconds(userTime)});
+        }
+        CloseHandle(thread);
+    }
+    CloseHandle(threadsSnapshot);
+    return threadsCpuTime;
+}
+}
+
+#elif __linux__
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+const long clockTicks = sysconf(_SC_CLK_TCK);
+const long pageSize = sysconf(_SC_PAGESIZE);
+
+double getProcessRss() {
+    std::ifstream statm("/proc/self/statm");
+    unsigned long size = 0, resident = 0;
+    if (!(statm >> size >> resident)) {
+        throw std::runtime_error("Can't read /proc/self/statm");
+    }
+    return static_cast<double>(resident) * pageSize / (1024 * 1024 * 1024);
+}
+
+std::vector<ThreadCpuTime> getThreadsCpuTime() {
+    std::vector<ThreadCpuTime> threadsCpuTime;
+    DIR *tasks = opendir("/proc/self/task");
+    if (!tasks) {
+        throw std::runtime_error("Can't open /proc/self/task");
+    }
+    while (struct dirent *ent = readdir(tasks)) {
+        char *end;
+        long threadId = std::strtol(ent->d_name, &end, 10);
+        if (end == ent->d_name || *end != '\0') {
+            continue; // "." and ".."
+        }
+        std::ifstream statFile(std::string{"/proc/self/task/"} + ent->d_name + "/stat");
+        std::string stat;
+        if (!std::getline(statFile, stat)) {
+            continue; // the thread has finished already
+        }
+        // The name is in parentheses and may contain spaces and parentheses itself
+        std::string::size_type nameBegin = stat.find('('), nameEnd = stat.rfind(')');
+        if (std::string::npos == nameBegin || std::string::npos == nameEnd || nameEnd < nameBegin) {
+            continue;
+        }
+        std::istringstream fields{stat.substr(nameEnd + 1)};
+        std::string field;
+        // Fields after the name start from the 3rd one (state), utime and stime are 14th and 15th
+        for (int i = 3; i < 14 && fields >> field; ++i) {}
+        unsigned long utime = 0, stime = 0;
+        if (fields >> utime >> stime) {
+            threadsCpuTime.push_back({threadId, stat.substr(nameBegin + 1, nameEnd - nameBegin - 1),
+                static_cast<double>(utime + stime) / clockTicks});
+        }
+    }
+    closedir(tasks);
+    return threadsCpuTime;
+}
+}
+
+#else
+// not implemented
+namespace {
+double getProcessRss() {return 0.0;}
+
+std::vector<ThreadCpuTime> getThreadsCpuTime() {return {};}
+}
+#endif
+
+SystemSampler::SystemSampler(std::chrono::milliseconds period, bool collectThreadsCpuTime) :
+    period{period},
+    collectThreadsCpuTime{collectThreadsCpuTime},
+    hasFailed{false},
+    isStopping{false} {
+        samplingThread = std::thread(&SystemSampler::samplingLoop, this);
+    }
+
+SystemSampler::~SystemSampler() {
+    {
+        std::lock_guard<std::mutex> lock{mtx};
+        isStopping = true;
+    }
+    stopCondVar.notify_one();
+    samplingThread.join();
+}
+
+std::shared_ptr<const SystemSnapshot> SystemSampler::getSnapshot() const {
+    if (hasFailed.load(std::memory_order_acquire)) {
+        std::rethrow_exception(samplingException);
+    }
+    return std::atomic_load(&snapshot);
+}
+
+void SystemSampler::samplingLoop() {
+    try {
+        // The monitors are created in this thread, so it does all the reading and parsing of system data
+        CpuMonitor cpuMonitor;
+        cpuMonitor.setHistorySize(1);
+        MemoryMonitor memoryMonitor;
+        memoryMonitor.setHistorySize(1);
+
+        std::unique_lock<std::mutex> lock{mtx};
+        while (!stopCondVar.wait_for(lock, period, [this] {return isStopping;})) {
+            lock.unlock();
+            std::shared_ptr<SystemSnapshot> newSnapshot = std::make_shared<SystemSnapshot>();
+            cpuMonitor.collectData();
+            memoryMonitor.collectData();
+            std::deque<std::vector<double>> cpuHistory = cpuMonitor.getLastHistory();
+            if (!cpuHistory.empty()) {
+                newSnapshot->coresLoad = std::move(cpuHistory.back());
+            }
+            std::pair<double, double> memSwapUsage = memoryMonitor.getLastHistory().back();
+            newSnapshot->memTotal = memoryMonitor.getMemTotal();
+            newSnapshot->usedMem = memSwapUsage.first;
+            newSnapshot->usedSwap = memSwapUsage.second;
+            newSnapshot->processRss = getProcessRss();
+            if (collectThreadsCpuTime) {
+                newSnapshot->threadsCpuTime = getThreadsCpuTime();
+            }
+            newSnapshot->timeStamp = std::chrono::steady_clock::now();
+            std::atomic_store(&snapshot, std::shared_ptr<const SystemSnapshot>{std::move(newSnapshot)});
+            lock.lock();
+        }
+    } catch (...) {
+        samplingException = std::current_exception();
+        hasFailed.store(true, std::memory_order_release);
+    }
+}
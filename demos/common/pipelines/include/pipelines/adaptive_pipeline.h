@@ -0,0 +1,91 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include "pipelines/switching_pipeline.h"
+
+/// This is class choosing between the latency and the throughput configurations by the load of the last window.
+/// The load is measured by the queue depth (frames in flight, counted at every submission) and by the arrival rate.
+/// Latency mode is left when the queue is full on average, i.e. the frames arrive faster than its requests
+/// complete them, and its completion rate at that moment is remembered as its capacity. Throughput mode is left
+/// when the frames arrive slower than 3/4 of that capacity, so the modes don't flip on small changes of the load.
+class LoadModeSelector {
+public:
+    enum class Mode { Latency, Throughput };
+
+    /// @param latencyRequests - number of requests of the latency configuration
+    /// @param window - duration of the window the load is averaged over
+    LoadModeSelector(size_t latencyRequests, std::chrono::steady_clock::duration window);
+
+    /// Records a submission, which makes depth frames in flight
+    /// @returns the mode the frame should be submitted in
+    Mode onSubmit(size_t depth, std::chrono::steady_clock::time_point now);
+    /// Records a result taken from the pipeline
+    void onResult() { windowResults++; }
+
+    Mode getMode() const { return mode; }
+    /// @returns the number of mode switches so far
+    size_t getSwitchesCount() const { return switchesCount; }
+
+private:
+    size_t latencyRequests;
+    std::chrono::steady_clock::duration window;
+    Mode mode = Mode::Latency;
+    size_t switchesCount = 0;
+    /// Frames per second the latency mode completed when it was saturated, 0 until then
+    double latencyCapacity = 0;
+
+    std::chrono::steady_clock::time_point windowStart;
+    bool isWindowStarted = false;
+    size_t windowSubmissions = 0;
+    size_t windowResults = 0;
+    size_t windowDepthSum = 0;
+};
+
+/// This is class keeping the model compiled both for minimum latency and for throughput (e.g. with
+/// ConfigFactory::getMinLatencyConfig and ConfigFactory::getUserConfig) and submitting the frames to one
+/// of them, as LoadModeSelector decides. The configurations shouldn't batch frames or reorder results
+/// (see SwitchingPipeline), the constructor throws std::invalid_argument before loading the model otherwise.
+class AdaptivePipeline : public SwitchingPipeline {
+public:
+    /// Creates the model of each of the pipelines
+    using ModelFactory = std::function<std::unique_ptr<ModelBase>()>;
+
+    /// Loads the model with both configurations
+    /// @param modelFactory - function creating a model instance for every pipeline
+    /// @param latencyConfig - configuration of the latency mode, the pipeline starts in it
+    /// @param throughputConfig - configuration of the throughput mode
+    /// @param engine - reference to InferenceEngine::Core instance to use
+    /// @param window - duration of the window the load is averaged over
+    AdaptivePipeline(const ModelFactory& modelFactory, const CnnConfig& latencyConfig,
+        const CnnConfig& throughputConfig, InferenceEngine::Core& engine,
+        std::chrono::steady_clock::duration window = std::chrono::seconds(2));
+
+    LoadModeSelector::Mode getMode() const { return selector.getMode(); }
+    size_t getSwitchesCount() const { return selector.getSwitchesCount(); }
+
+protected:
+    size_t selectPipeline(size_t framesInFlight, std::chrono::steady_clock::time_point now) override;
+    void onResult(size_t pipelineIndex, std::chrono::steady_clock::duration latency) override;
+    const char* pipelineName(size_t pipelineIndex) const override;
+
+    LoadModeSelector selector;
+};
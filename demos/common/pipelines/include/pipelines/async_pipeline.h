@@ -15,15 +15,28 @@
 */
 
 #pragma once
+#include <chrono>
+#include <functional>
+#include <future>
 #include <string>
 #include <deque>
+#include <vector>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
 #include <condition_variable>
 #include "pipelines/config_factory.h"
-#include "pipelines/requests_pool.h"
+#include "pipelines/device_scheduler.h"
+#include "pipelines/requests_autotuner.h"
 #include "models/results.h"
 #include "models/model_base.h"
 
+class PerformanceMetrics;
+class TraceProfiler;
+class OutputsRecorder;
+
 /// This is base class for asynchronous pipeline
 /// Derived classes should add functions for data submission and output processing
 class AsyncPipeline {
@@ -38,15 +51,17 @@ public:
 
     /// Waits until either output data becomes available or pipeline allows to submit more input data.
     /// Function will treat results as ready only if next sequential result (frame) is ready.
+    /// Incomplete batch (if any) doesn't end the wait, it's sent for inference when CnnConfig::maxBatchWaitTime
+    /// passes since its first item was submitted and the wait continues.
     void waitForData();
 
     /// @returns true if there's available infer requests in the pool
     /// and next frame can be submitted for processing, false otherwise.
-    bool isReadyToProcess() { return requestsPool->isIdleRequestAvailable(); }
+    bool isReadyToProcess() { return pendingBatch || requestsPool->isIdleRequestAvailable(); }
 
     /// Waits for all currently submitted requests to be completed.
-    ///
-    void waitForTotalCompletion() { if (requestsPool) requestsPool->waitForTotalCompletion(); }
+    /// Incomplete batch (if any) is sent for inference first.
+    void waitForTotalCompletion();
 
     /// Submits data to the network for inference
     /// @param inputData - input data to be submitted
@@ -54,30 +69,221 @@ public:
     /// Might be null. This pointer will be passed through pipeline and put to the final result structure.
     /// @returns -1 if image cannot be scheduled for processing (there's no free InferRequest available).
     /// Otherwise returns unique sequential frame ID for this particular request. Same frame ID will be written in the response structure.
+    /// If CnnConfig::maxBatchSize is greater than 1, data is put to the next free slot of the current batch.
+    /// Batch is sent for inference when it's full or when CnnConfig::maxBatchWaitTime passes since its first item was submitted.
     virtual int64_t submitData(const InputData& inputData, const std::shared_ptr<MetaData>& metaData);
 
+    /// Submits several items to the network for inference as a single batch
+    /// @param inputData - input data items to be submitted. Number of items shouldn't exceed CnnConfig::maxBatchSize
+    /// @param metaData - metadata for every input item. Might be empty.
+    /// @returns -1 if batch cannot be scheduled for processing (there's no free InferRequest available).
+    /// Otherwise returns frame ID of the first item, other items get consecutive frame IDs.
+    virtual int64_t submitBatch(const std::vector<std::reference_wrapper<const InputData>>& inputData,
+        const std::vector<std::shared_ptr<MetaData>>& metaData);
+
+    /// Sends incomplete batch (if any) for inference without waiting for more items
+    void flushPendingBatch();
+
+    /// @returns true if incomplete batch is waiting for more items
+    bool hasPendingBatch() const { return static_cast<bool>(pendingBatch); }
+
+    /// @returns time when the incomplete batch should be sent for inference (see CnnConfig::maxBatchWaitTime),
+    /// meaningful only if hasPendingBatch returns true
+    std::chrono::steady_clock::time_point getPendingBatchDeadline() const { return pendingBatchDeadline; }
+
+    /// Function receiving the result of submit(), or the exception which stopped the pipeline (result is null then)
+    using ResultContinuation = std::function<void(std::unique_ptr<ResultBase>&& result, const std::exception_ptr& error)>;
+
+    /// Submits data to the network, waiting for a free infer request if there's none, so the caller is held back
+    /// by the pipeline instead of polling isReadyToProcess. The continuation is called with the result from
+    /// the dispatcher thread, which is started by the first call and takes the results as soon as they are ready,
+    /// so stages can be chained by submitting to the next pipeline from the continuation (but not to this one,
+    /// it may wait for the dispatcher then). The continuation should be lightweight, the results are dispatched
+    /// one by one, in the order getResult returns them. submit rethrows the exception which stopped the pipeline.
+    /// This API shouldn't be mixed with submitData and getResult. An incomplete batch (if CnnConfig::maxBatchSize
+    /// is greater than 1) is sent by flushPendingBatch or waitForSubmittedResults.
+    /// Like submitData, it should be called by one thread at a time (which may be the dispatcher of another pipeline),
+    /// as frame IDs and the pending batch belong to the submitting thread. Concurrent calls throw std::logic_error.
+    /// @param inputData - input data to be submitted
+    /// @param metaData - shared pointer to metadata container, might be null
+    /// @param continuation - function to call with the result
+    /// @returns frame ID of the data
+    int64_t submit(const InputData& inputData, const std::shared_ptr<MetaData>& metaData,
+        const ResultContinuation& continuation);
+
+    /// Same as submit with continuation, but the result is delivered through the returned future
+    std::future<std::unique_ptr<ResultBase>> submit(const InputData& inputData,
+        const std::shared_ptr<MetaData>& metaData);
+
+    /// Sends incomplete batch (if any) and waits until the continuations of all the submitted data are called
+    void waitForSubmittedResults();
+
+    /// @returns number of infer requests of the pipeline
+    size_t getRequestsCount() const { return requestsPool->getRequestsCount(); }
+
+    /// @returns maximum number of items inferred by one request, see CnnConfig::maxBatchSize
+    unsigned int getMaxBatchSize() const { return maxBatchSize; }
+
+    /// @returns true if results are always returned in submission order,
+    /// see CnnConfig::unorderedResults and CnnConfig::maxReorderBufferSize
+    bool isSubmissionOrderKept() const { return !unorderedResults && maxReorderBufferSize == 0; }
+
+    /// Sets function to be called from completion callback every time inference of a request is completed.
+    /// It allows to wait for several pipelines at once. Should be set before any data is submitted.
+    /// @param listener - function to call. It's called from IE threads, so it should be thread safe and lightweight.
+    void setCompletionListener(const std::function<void()>& listener) { completionListener = listener; }
+
+    /// Sets metrics object to record durations of preprocess, infer, queue wait and postprocess stages to.
+    /// Queue wait is the time inference result waits to be taken by getResult.
+    /// @param metrics - pointer to metrics object, it should outlive the pipeline. Null disables recording.
+    void setPerformanceMetrics(PerformanceMetrics* metrics) { performanceMetrics = metrics; }
+
+    /// Sets profiler to add performance counters of every inference and spans of preprocess and postprocess stages to.
+    /// Performance counters should be enabled in CnnConfig (see ConfigFactory flags_pc parameter).
+    /// Should be set before any data is submitted.
+    /// @param profiler - pointer to profiler object, it should outlive the pipeline. Null disables profiling.
+    void setTraceProfiler(TraceProfiler* profiler) { traceProfiler = profiler; }
+
+    /// Sets recorder to write outputs of every frame to before it's postprocessed, so postprocessing can be
+    /// replayed without inference (see RecordedOutputs). Should be set before any data is submitted.
+    /// @param recorder - pointer to recorder object, it should outlive the pipeline. Null disables recording.
+    void setOutputsRecorder(OutputsRecorder* recorder) { outputsRecorder = recorder; }
+
+    /// Rethrows exception happened in completion callback (if any). This function doesn't block.
+    void rethrowCallbackException();
+
     /// Gets available data from the queue
-    /// Function will treat results as ready only if next sequential result (frame) is ready.
+    /// Function will treat results as ready only if next sequential result (frame) is ready,
+    /// unless CnnConfig::unorderedResults is set or reorder buffer is full (see CnnConfig::maxReorderBufferSize).
     virtual std::unique_ptr<ResultBase> getResult();
 
+    /// Returns result received from getResult back to the model, so its buffers are reused for next frames.
+    /// Calling this function is optional, results which aren't released are just destroyed.
+    /// Result (including data referenced by it, like masks) shouldn't be used after the call.
+    void releaseResult(std::unique_ptr<ResultBase>&& result) { if (result) model->recycleResult(std::move(result)); }
+
 protected:
     /// Returns processed result, if available
     /// Function will treat results as ready only if next sequential result (frame) is ready.
     /// @returns InferenceResult with processed information or empty InferenceResult (with negative frameID) if there's no any results yet.
     virtual InferenceResult getInferenceResult();
 
-    std::unique_ptr<RequestsPool> requestsPool;
-    std::unordered_map<int64_t, InferenceResult> completedInferenceResults;
+    struct BatchItem {
+        int64_t frameId;
+        std::shared_ptr<MetaData> metaData;
+        std::shared_ptr<InternalModelData> internalModelData;
+    };
+
+    struct PendingBatch {
+        InferenceEngine::InferRequest::Ptr request;
+        /// Sized to maxBatchSize in advance, so preprocessing threads can fill items while new ones are added
+        std::vector<BatchItem> items;
+        size_t size = 0;
+        /// Number of preprocessing tasks not completed yet, plus one while the batch is being collected.
+        /// Whoever decrements it to zero starts inference.
+        std::atomic<size_t> remainingTasks{1};
+        std::atomic<bool> hasFailed{false};
+    };
+
+    struct PreprocessTask {
+        std::shared_ptr<InputData> inputData;
+        std::shared_ptr<PendingBatch> batch;
+        size_t batchIndex;
+    };
+
+    /// Preprocesses data into the next slot of the pending batch (or queues it for background preprocessing),
+    /// taking new idle request if there's no pending batch
+    /// @returns -1 if there's no free InferRequest available, frame ID otherwise
+    int64_t addToPendingBatch(const InputData& inputData, const std::shared_ptr<MetaData>& metaData);
 
-    InferenceEngine::ExecutableNetwork execNetwork;
+    void preprocessBatchItem(const InputData& inputData, PendingBatch& batch, size_t batchIndex);
+    /// Marks one task of the batch completed and starts inference if it was the last one
+    void completeBatchTask(const std::shared_ptr<PendingBatch>& batch);
+    void startBatch(const std::shared_ptr<PendingBatch>& batch);
+    void inferBatch(const std::shared_ptr<PendingBatch>& pendingBatch);
+    void onBatchStarted();
+    void preprocessWorkerLoop();
+    void postprocessWorkerLoop();
+    /// Postprocesses the result and releases its outputs
+    std::unique_ptr<ResultBase> postprocessResult(InferenceResult& infResult);
+    /// Stores the first exception happened in background threads to be rethrown by waitForData
+    void setCallbackException(const std::exception_ptr& exception);
+    void stopPreprocessWorkers();
+    void stopPostprocessWorkers();
+    void dispatcherLoop();
+    void stopDispatcher();
+
+    /// Returns true if getInferenceResult (or getResult with postprocessing workers) can return some result.
+    /// Should be called with mtx locked.
+    bool isResultAvailable() const;
+    template<typename Results>
+    bool isNextResultReady(const Results& results) const;
+    /// Returns the result to be returned next or end() if it isn't ready. Should be called with mtx locked.
+    template<typename Results>
+    typename Results::iterator findNextResult(Results& results) const;
+    /// Adds completed (or postprocessed) result to be returned in order. Should be called with mtx locked.
+    template<typename Results, typename Result>
+    void addCompletedResult(Results& results, int64_t frameId, Result&& result);
+    /// Updates the order of results after the result was taken. Should be called with mtx locked.
+    void onResultTaken(int64_t frameId);
+
+    std::unique_ptr<DeviceScheduler> requestsPool;
+    /// Limits the number of requests in use while tuning it, null unless CnnConfig::autotuneRequests is set
+    std::unique_ptr<RequestsAutotuner> requestsAutotuner;
+    std::unordered_map<int64_t, InferenceResult> completedInferenceResults;
+    /// Results postprocessed by postprocessing workers, they are used instead of completedInferenceResults then
+    std::unordered_map<int64_t, std::unique_ptr<ResultBase>> postprocessedResults;
 
     std::mutex mtx;
     std::condition_variable condVar;
 
+    /// Frame ID of the next submitted data. Belongs to the submitting thread, so it isn't protected by mtx.
     int64_t inputFrameId = 0;
+    /// Set while submit runs, so calls from several threads at once are detected
+    std::atomic<bool> isSubmitting{false};
+    /// Frame ID of the next result in submission order. Protected by mtx.
     int64_t outputFrameId = 0;
+    /// Number of completed results with frame ID less than outputFrameId (their successors were returned already)
+    size_t lateResultsCount = 0;
+    bool unorderedResults;
+    size_t maxReorderBufferSize;
 
     std::exception_ptr callbackException = nullptr;
+    std::function<void()> completionListener;
+    PerformanceMetrics* performanceMetrics = nullptr;
+    TraceProfiler* traceProfiler = nullptr;
+    OutputsRecorder* outputsRecorder = nullptr;
+
+    bool zeroCopyOutputs;
+
+    unsigned int maxBatchSize;
+    std::chrono::steady_clock::duration maxBatchWaitTime;
+    std::shared_ptr<PendingBatch> pendingBatch;
+    std::chrono::steady_clock::time_point pendingBatchDeadline;
+
+    std::vector<std::thread> preprocessWorkers;
+    std::deque<PreprocessTask> preprocessTasks;
+    size_t maxPreprocessTasks = 0;
+    /// Number of batches taken from the pool but not started yet (waiting for background preprocessing)
+    size_t notStartedBatches = 0;
+    bool isStopping = false;
+    std::mutex preprocessMtx;
+    std::condition_variable preprocessCondVar;
+
+    std::vector<std::thread> postprocessWorkers;
+    std::deque<InferenceResult> postprocessTasks;
+    /// Number of frames being inferred or postprocessed by workers
+    size_t activePostprocessTasks = 0;
+    bool isPostprocessStopping = false;
+    std::mutex postprocessMtx;
+    std::condition_variable postprocessCondVar;
+
+    std::thread dispatcher;
+    /// Continuations of the data passed to submit by frame ID, protected by mtx
+    std::unordered_map<int64_t, ResultContinuation> continuations;
+    bool isDispatcherStopping = false;
+    /// Notified when a continuation is called, protected by mtx
+    std::condition_variable continuationsCondVar;
 
     std::unique_ptr<ModelBase> model;
 };
@@ -0,0 +1,91 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include "pipelines/switching_pipeline.h"
+
+/// This is class deciding when to move the frames from the full model to the cheaper one by the latency
+/// of the last window. The full model is left when the mean latency of the results (from submission till
+/// the result is taken) exceeds the limit, and its completion rate at that moment is remembered as its capacity.
+/// The full model is returned to when the frames arrive slower than 3/4 of that capacity.
+class LatencyLimitSelector {
+public:
+    /// @param latencyLimit - maximum mean latency of the full model
+    /// @param window - duration of the window the latency and the load are averaged over
+    LatencyLimitSelector(std::chrono::steady_clock::duration latencyLimit,
+                         std::chrono::steady_clock::duration window);
+
+    /// Records a submission
+    /// @returns true if the frame should be submitted to the cheaper model
+    bool onSubmit(std::chrono::steady_clock::time_point now);
+    /// Records a result taken from the pipeline with its latency
+    void onResult(std::chrono::steady_clock::duration latency);
+
+    bool isDegraded() const { return degraded; }
+    /// @returns the number of switches between the models so far
+    size_t getSwitchesCount() const { return switchesCount; }
+
+private:
+    std::chrono::steady_clock::duration latencyLimit;
+    std::chrono::steady_clock::duration window;
+    bool degraded = false;
+    size_t switchesCount = 0;
+    /// Frames per second the full model completed when it exceeded the limit
+    double fullCapacity = 0;
+
+    std::chrono::steady_clock::time_point windowStart;
+    bool isWindowStarted = false;
+    size_t windowSubmissions = 0;
+    size_t windowResults = 0;
+    std::chrono::steady_clock::duration windowLatencySum = std::chrono::steady_clock::duration::zero();
+};
+
+/// This is class holding two models of the same task, e.g. full and lightweight detectors or one detector
+/// with two input resolutions, and moving the frames to the cheaper model when the full one can't keep up
+/// with the latency limit, see LatencyLimitSelector. Both models should produce results of the same type
+/// with the same labels, so the code processing them doesn't depend on the model which ran.
+class CascadePipeline : public SwitchingPipeline {
+public:
+    enum ModelIndex { Full, Light };
+
+    /// Loads both models
+    /// @param fullModel - model used while the latency limit is kept
+    /// @param lightModel - cheaper model used under overload
+    /// @param cnnConfig - configuration of both pipelines, it's better to keep the number of
+    /// requests small for the latency to react to the load quickly. It shouldn't batch frames or reorder results
+    /// (see SwitchingPipeline), std::invalid_argument is thrown before the models are loaded otherwise
+    /// @param engine - reference to InferenceEngine::Core instance to use
+    /// @param latencyLimit - maximum mean latency of the full model
+    /// @param window - duration of the window the latency and the load are averaged over
+    CascadePipeline(std::unique_ptr<ModelBase>&& fullModel, std::unique_ptr<ModelBase>&& lightModel,
+        const CnnConfig& cnnConfig, InferenceEngine::Core& engine,
+        std::chrono::steady_clock::duration latencyLimit,
+        std::chrono::steady_clock::duration window = std::chrono::seconds(2));
+
+    bool isDegraded() const { return selector.isDegraded(); }
+    size_t getSwitchesCount() const { return selector.getSwitchesCount(); }
+
+protected:
+    size_t selectPipeline(size_t framesInFlight, std::chrono::steady_clock::time_point now) override;
+    void onResult(size_t pipelineIndex, std::chrono::steady_clock::duration latency) override;
+    const char* pipelineName(size_t pipelineIndex) const override;
+
+    LatencyLimitSelector selector;
+};
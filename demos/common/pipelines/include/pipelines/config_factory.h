@@ -15,16 +15,71 @@
 */
 
 #pragma once
+#include <chrono>
 #include <map>
 #include <string>
+#include <vector>
 #include "gflags/gflags.h"
 
+class NetworkRegistry;
+
 struct CnnConfig {
     std::string devices;
+    /// Devices to balance the load between (set if device string is BALANCE:<device1>,<device2>,...).
+    /// If it isn't empty, network is loaded to every device separately instead of loading it to the devices string.
+    std::vector<std::string> balancedDevices;
     std::string cpuExtensionsPath;
     std::string clKernelsConfigPath;
+    /// Number of infer requests of every device. 0 means the optimal number reported by the device.
     unsigned int maxAsyncRequests;
     std::map<std::string, std::string> execNetworkConfig;
+    /// Directory to cache compiled networks in (see NetworkCache). Empty string disables caching.
+    /// ConfigFactory takes it from OMZ_NETWORK_CACHE_DIR environment variable.
+    std::string cacheDir;
+    /// If true, the .bin file of the model is mapped to memory and shared with other processes (see readNetwork)
+    bool mapWeights = false;
+    /// Registry to share loaded networks with other pipelines of the process (see NetworkRegistry).
+    /// It should outlive the pipeline. nullptr means the pipeline loads its own networks.
+    NetworkRegistry* networkRegistry = nullptr;
+    /// If true, the number of requests in flight is tuned on the first frames (see RequestsAutotuner):
+    /// the pipeline creates maxAsyncRequests requests of every device and keeps the best number of them in use.
+    /// The decision is cached in cacheDir, if it's set, for the model, devices and execNetworkConfig.
+    bool autotuneRequests = false;
+    /// Number of frames inferred with every candidate number of requests while tuning
+    unsigned int autotuneFrames = 100;
+    /// Maximum mean inference latency of the tuned number of requests. 0 means no limit.
+    std::chrono::milliseconds latencyLimit = std::chrono::milliseconds(0);
+    /// Maximum number of rounds of every request inferring synthetic inputs after loading (see warmupRequests).
+    /// They end earlier when the inference time settles, and they aren't recorded to metrics. 0 disables warmup.
+    unsigned int warmupRounds = 3;
+    /// If true, inference results reference output blobs of the infer request instead of copying them.
+    /// The request is returned to the pool only after result is postprocessed.
+    bool zeroCopyOutputs = false;
+    /// If true, the models which can postprocess FP16 outputs get them in FP16 (see ModelBase::allowFp16Outputs).
+    /// ConfigFactory sets it if all the devices infer in FP16 (GPU, MYRIAD, HDDL), so they don't convert the outputs.
+    bool fp16Outputs = false;
+    /// If true, the models append their first postprocessing steps to the network (see
+    /// ModelBase::enableDevicePostprocessing). ConfigFactory takes it from OMZ_DEVICE_POSTPROCESSING environment variable.
+    bool devicePostprocessing = false;
+    /// Maximum number of frames packed into one infer request. Model's batch is reshaped to this value.
+    unsigned int maxBatchSize = 1;
+    /// Maximum time to wait for the batch to be filled before sending incomplete batch for inference
+    std::chrono::milliseconds maxBatchWaitTime = std::chrono::milliseconds(0);
+    /// Number of threads preprocessing input data in background, so preprocessing overlaps with inference.
+    /// 0 means data is preprocessed by the thread submitting it. InputData should implement clone() to be
+    /// preprocessed in background, and model's preprocessing should be safe to run for different requests at once.
+    unsigned int preprocessThreads = 0;
+    /// Number of threads postprocessing inference results as soon as they are completed, so postprocessing of
+    /// several frames runs in parallel and overlaps with inference. 0 means results are postprocessed by getResult.
+    /// Model's postprocessing should be safe to run for different results at once. Outputs aren't copied then
+    /// (as with zeroCopyOutputs), so the number of frames waiting for postprocessing is limited by the requests.
+    unsigned int postprocessThreads = 0;
+    /// If true, results are returned in order of completion instead of order of submission
+    bool unorderedResults = false;
+    /// Maximum number of completed results kept to restore submission order. When it's reached, result with
+    /// the smallest frame ID is returned even if some previous frames aren't completed yet (they will be returned
+    /// later, as soon as they are completed). 0 means no limit.
+    size_t maxReorderBufferSize = 0;
 };
 
 class ConfigFactory {
@@ -35,6 +90,16 @@ public:
     static CnnConfig getMinLatencyConfig(const std::string& flags_d, const std::string& flags_l,
         const std::string& flags_c, bool flags_pc, uint32_t flags_nireq);
 
+    /// Splits CPU threads between several networks of one process, so their threads don't oversubscribe the cores.
+    /// Every network gets at least one thread, the rest are split in proportion to the loads. The plugin pins
+    /// threads of every network starting from the same cores, so the networks' threads aren't pinned.
+    /// @param loads - relative load of every network, e.g. the number of its inferences per frame
+    /// @param reservedThreads - threads left for the application, e.g. for cv::setNumThreads()
+    /// @param totalThreads - threads of the CPU. 0 means std::thread::hardware_concurrency()
+    /// @returns ExecutableNetwork config of every network with CPU_THREADS_NUM, CPU_THROUGHPUT_STREAMS and CPU_BIND_THREAD
+    static std::vector<std::map<std::string, std::string>> planCpuNetworks(const std::vector<float>& loads,
+        unsigned reservedThreads, unsigned totalThreads = 0);
+
 protected:
     static CnnConfig getCommonConfig(const std::string& flags_d, const std::string& flags_l,
         const std::string& flags_c, bool flags_pc, uint32_t flags_nireq);
@@ -0,0 +1,110 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <inference_engine.hpp>
+#include "pipelines/network_cache.h"
+#include "pipelines/network_registry.h"
+#include "pipelines/requests_pool.h"
+
+/// This is class distributing infer requests between several devices.
+/// Every device has its own ExecutableNetwork and RequestsPool. Idle request is taken from the device
+/// with the lowest expected latency, which is estimated from measured inference time and device's queue length.
+/// Unlike MULTI plugin with its static priorities, it keeps all devices loaded when one of them is saturated.
+/// With single device it works as a plain RequestsPool.
+class DeviceScheduler {
+public:
+    /// Loads network to every device and creates requests pools
+    /// @param engine - reference to InferenceEngine::Core instance to use
+    /// @param cnnNetwork - network to load
+    /// @param devices - list of devices to load network to
+    /// @param config - configuration for ExecutableNetwork. Every device gets only keys it supports.
+    /// @param requestsPerDevice - number of infer requests created for every device.
+    /// 0 means the optimal number reported by every device (OPTIMAL_NUMBER_OF_INFER_REQUESTS metric).
+    /// @param networkCache - cache of compiled networks to import networks from. Might be null.
+    /// @param modelFileName - name of the file network was read from, used as a key for networkCache and networkRegistry
+    /// @param networkRegistry - registry to share the loaded networks with other pipelines. Might be null.
+    DeviceScheduler(InferenceEngine::Core& engine, InferenceEngine::CNNNetwork& cnnNetwork,
+        const std::vector<std::string>& devices, const std::map<std::string, std::string>& config,
+        unsigned int requestsPerDevice, NetworkCache* networkCache = nullptr, const std::string& modelFileName = "",
+        NetworkRegistry* networkRegistry = nullptr);
+
+    /// Returns idle request of the device which is expected to complete it first. This function is thread safe.
+    /// @returns pointer to request with idle state or nullptr if all requests are in use.
+    InferenceEngine::InferRequest::Ptr getIdleRequest();
+
+    /// Returns request to the idle state in its device's pool. This function is thread safe.
+    void setRequestIdle(const InferenceEngine::InferRequest::Ptr& request);
+
+    /// Creates lease on the request, see RequestsPool::leaseRequest
+    InferenceEngine::InferRequest::Ptr leaseRequest(const InferenceEngine::InferRequest::Ptr& request);
+
+    /// Updates inference time estimation of the request's device. This function is thread safe.
+    /// @param request - completed request
+    /// @param duration - time passed from the start of inference till its completion
+    void recordInferenceTime(const InferenceEngine::InferRequest::Ptr& request, std::chrono::steady_clock::duration duration);
+
+    /// Returns true if there's at least one idle request on any device. This function is thread safe.
+    bool isIdleRequestAvailable();
+
+    /// Limits the number of requests in use of all devices, getIdleRequest returns nullptr when it's reached.
+    /// 0 means no limit. This function is thread safe, though requests taken at once by several threads
+    /// might exceed the limit.
+    void setRequestsLimit(size_t limit) { requestsLimit = limit; }
+
+    /// Returns number of requests of all devices
+    size_t getRequestsCount() const;
+
+    /// Waits for completion of every non-idle request of every device
+    void waitForTotalCompletion();
+
+    /// Returns list of all infer requests of all devices
+    std::vector<InferenceEngine::InferRequest::Ptr> getInferRequestsList();
+
+    /// Returns ExecutableNetwork of the first device
+    InferenceEngine::ExecutableNetwork& getExecNetwork() { return devices.front()->execNetwork; }
+
+    /// Returns name of the device the request belongs to
+    const std::string& getDeviceName(const InferenceEngine::InferRequest::Ptr& request) const;
+
+protected:
+    struct Device {
+        std::string name;
+        InferenceEngine::ExecutableNetwork execNetwork;
+        std::unique_ptr<RequestsPool> requestsPool;
+        unsigned int requestsCount = 0;
+        /// Exponential moving average of inference time in nanoseconds, 0 until the first measurement
+        std::atomic<int64_t> avgInferenceTimeNs;
+
+        Device() : avgInferenceTimeNs(0) {}
+    };
+
+    Device& getDevice(const InferenceEngine::InferRequest::Ptr& request) const;
+    bool isRequestsLimitReached() const;
+
+    std::vector<std::unique_ptr<Device>> devices;
+    // Filled in constructor and never modified after that, so it's safe to read it without synchronization
+    std::unordered_map<const InferenceEngine::InferRequest*, size_t> requestsDevices;
+    std::atomic<size_t> requestsLimit{0};
+};
@@ -16,6 +16,7 @@
 
 #pragma once
 #include <samples/ocv_common.hpp>
+#include <samples/shared_pool.hpp>
 
 struct MetaData {
     virtual ~MetaData() {}
@@ -32,12 +33,23 @@ struct MetaData {
 struct ImageMetaData : public MetaData {
     cv::Mat img;
     std::chrono::steady_clock::time_point timeStamp;
+    /// Index of the input the image comes from if the pipeline serves several inputs
+    size_t sourceId = 0;
 
     ImageMetaData() {
     }
 
-    ImageMetaData(cv::Mat img, std::chrono::steady_clock::time_point timeStamp):
+    ImageMetaData(cv::Mat img, std::chrono::steady_clock::time_point timeStamp, size_t sourceId = 0):
         img(img),
-        timeStamp(timeStamp) {
+        timeStamp(timeStamp),
+        sourceId(sourceId) {
     }
 };
+
+/// Creates ImageMetaData in the memory of the released metadata of previous frames (see SharedPool),
+/// so submitting a frame doesn't allocate it once the pipeline is in steady state. This function is thread safe.
+inline std::shared_ptr<ImageMetaData> makeImageMetaData(const cv::Mat& img,
+    std::chrono::steady_clock::time_point timeStamp, size_t sourceId = 0) {
+    static SharedPool<ImageMetaData> pool(256);
+    return pool.make(img, timeStamp, sourceId);
+}
@@ -0,0 +1,59 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <inference_engine.hpp>
+
+/// This is class caching compiled networks on disk to reduce start up time.
+/// Network is exported with ExecutableNetwork::Export after loading and imported next time it's requested
+/// for the same model files, device, configuration and inputs/outputs settings.
+/// Devices which don't support export (e.g. CPU) just load network as usual.
+class NetworkCache {
+public:
+    /// @param cacheDir - existing directory to store compiled networks in
+    NetworkCache(const std::string& cacheDir) : cacheDir(cacheDir) {}
+
+    /// Imports compiled network from the cache or loads it to the device and puts to the cache
+    /// @param engine - reference to InferenceEngine::Core instance to use
+    /// @param cnnNetwork - network with inputs and outputs already configured
+    /// @param modelFileName - name of .xml file the network was read from. Its .bin file is hashed too.
+    /// @param device - device to load network to
+    /// @param config - configuration for ExecutableNetwork
+    InferenceEngine::ExecutableNetwork loadNetwork(InferenceEngine::Core& engine, InferenceEngine::CNNNetwork& cnnNetwork,
+        const std::string& modelFileName, const std::string& device, const std::map<std::string, std::string>& config);
+
+    /// Returns the name of the file in the cache directory for data of the compiled network, e.g. the network itself
+    /// @param extension - extension of the file telling the kind of the data, e.g. ".blob"
+    std::string getCacheFileName(InferenceEngine::Core& engine, InferenceEngine::CNNNetwork& cnnNetwork,
+        const std::string& modelFileName, const std::string& device, const std::map<std::string, std::string>& config,
+        const std::string& extension);
+
+    /// Returns a string describing everything affecting the compiled network except the model files:
+    /// plugin version, device, config, and shapes, precisions and layouts set for inputs and outputs
+    static std::string getNetworkKey(InferenceEngine::Core& engine, InferenceEngine::CNNNetwork& cnnNetwork,
+        const std::string& device, const std::map<std::string, std::string>& config);
+
+protected:
+    /// Hashes contents of the model files, result is memorized as models are hashed once per every device
+    uint64_t getModelHash(const std::string& modelFileName);
+
+    std::string cacheDir;
+    std::map<std::string, uint64_t> modelsHashes;
+};
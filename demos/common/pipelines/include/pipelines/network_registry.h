@@ -0,0 +1,49 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <inference_engine.hpp>
+
+/// Shares ExecutableNetworks between the pipelines of one process. Pipelines loading the same model file with
+/// the same device, config and inputs and outputs get one ExecutableNetwork, so its weights and its device streams
+/// aren't duplicated, while every pipeline still creates its own infer requests.
+/// Networks stay loaded until the registry is destroyed, so it should outlive the pipelines using it.
+class NetworkRegistry {
+public:
+    using LoadFunc = std::function<InferenceEngine::ExecutableNetwork()>;
+
+    /// Returns the registered network or calls load to get it. Different networks are loaded concurrently,
+    /// callers requesting the network being loaded wait for it. This function is thread safe.
+    /// @param engine - reference to InferenceEngine::Core instance to use
+    /// @param cnnNetwork - network with inputs and outputs already configured
+    /// @param modelFileName - name of .xml file the network was read from
+    /// @param device - device to load network to
+    /// @param config - configuration for ExecutableNetwork
+    /// @param load - function loading the network if it isn't registered yet
+    InferenceEngine::ExecutableNetwork getNetwork(InferenceEngine::Core& engine, InferenceEngine::CNNNetwork& cnnNetwork,
+        const std::string& modelFileName, const std::string& device, const std::map<std::string, std::string>& config,
+        const LoadFunc& load);
+
+protected:
+    std::mutex mtx;
+    std::map<std::string, std::shared_future<InferenceEngine::ExecutableNetwork>> networks;
+};
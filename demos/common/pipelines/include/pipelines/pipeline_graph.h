@@ -0,0 +1,154 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "pipelines/async_pipeline.h"
+#include "pipelines/metadata.h"
+
+/// Metadata attached to every ROI submitted to non-root node of the graph
+struct RoiMetaData : public MetaData {
+    /// Frame ID of the root node result this ROI originates from
+    int64_t rootFrameId = -1;
+    /// Index of the parent result in GraphResult::nodesResults of the parent node, -1 if parent is the root node
+    int parentIndex = -1;
+    /// ROI rectangle in coordinates of the root frame
+    cv::Rect roi;
+    /// Index of the ROI in the list the ROI extractor returned for the parent result
+    int roiIndex = -1;
+};
+
+/// Joined results of all graph nodes for one frame submitted to the root node
+struct GraphResult : public ResultBase {
+    std::unique_ptr<ResultBase> rootResult;
+    /// Results of non-root nodes in the order their ROIs were produced. metaData of every result is RoiMetaData.
+    std::map<std::string, std::vector<std::unique_ptr<ResultBase>>> nodesResults;
+};
+
+/// This is class for asynchronous processing of a frame by a graph of models.
+/// Root node infers whole frames, every other node infers ROIs extracted from its parent node's results.
+/// Every node owns its own AsyncPipeline (with its own requests pool), so all stages run concurrently:
+/// second-stage models process ROIs of frame N while the root model processes frame N+1.
+/// All functions should be called from the same thread.
+class PipelineGraph {
+public:
+    /// Function extracting ROIs (in root frame coordinates) from parent node result
+    using RoiExtractor = std::function<std::vector<cv::Rect>(const ResultBase& parentResult)>;
+    /// Function extracting rotated ROIs (in root frame coordinates) from parent node result, e.g. lines of text
+    using RotatedRoiExtractor = std::function<std::vector<cv::RotatedRect>(const ResultBase& parentResult)>;
+
+    /// Creates graph consisting of the root node only
+    /// @param rootModel - model inferring whole frames
+    /// @param cnnConfig - fine tuning configuration for the root model
+    /// @param engine - reference to InferenceEngine::Core instance to use
+    /// @param maxFramesInFlight - maximum number of frames submitted to the graph and not yet received with getResult
+    PipelineGraph(std::unique_ptr<ModelBase>&& rootModel, const CnnConfig& cnnConfig, InferenceEngine::Core& engine,
+        size_t maxFramesInFlight = 16);
+    virtual ~PipelineGraph();
+
+    /// Adds node inferring ROIs produced by the parent node
+    /// @param name - unique name of the node. Results of the node are put to GraphResult::nodesResults under this name
+    /// @param model - model to infer ROIs with
+    /// @param cnnConfig - fine tuning configuration for the model
+    /// @param engine - reference to InferenceEngine::Core instance to use
+    /// @param parentName - name of the parent node. Empty name means the root node.
+    /// @param roiExtractor - function extracting ROIs from parent's result
+    void addNode(const std::string& name, std::unique_ptr<ModelBase>&& model, const CnnConfig& cnnConfig,
+        InferenceEngine::Core& engine, const std::string& parentName, const RoiExtractor& roiExtractor);
+
+    /// Adds node inferring rotated ROIs produced by the parent node. The model of the node gets the whole root frame
+    /// as RotatedRoiInputData, so it warps the ROI straight to its input. RoiMetaData::roi is the bounding rectangle.
+    /// See addNode for the parameters.
+    void addRotatedRoiNode(const std::string& name, std::unique_ptr<ModelBase>&& model, const CnnConfig& cnnConfig,
+        InferenceEngine::Core& engine, const std::string& parentName, const RotatedRoiExtractor& roiExtractor);
+
+    /// Creates ROI extractor returning boxes of DetectionResult objects with confidence not less than threshold
+    static RoiExtractor detectionsExtractor(float confidenceThreshold = 0.f);
+
+    /// @returns true if next frame can be submitted to the root node
+    bool isReadyToProcess();
+
+    /// Submits frame to the root node
+    /// @param inputData - input data to be submitted. Should be ImageInputData.
+    /// @param metaData - metadata, should be ImageMetaData, as ROIs are cropped from its image.
+    /// @returns -1 if frame cannot be scheduled for processing, frame ID otherwise
+    int64_t submitData(const ImageInputData& inputData, const std::shared_ptr<ImageMetaData>& metaData);
+
+    /// Waits until either joined result becomes available or the graph allows to submit more frames
+    void waitForData();
+
+    /// Returns joined result for the next sequential frame if all nodes completed processing it
+    /// @returns GraphResult or nullptr if there's no ready result yet
+    std::unique_ptr<GraphResult> getResult();
+
+    /// Returns results of all nodes back to their models for reuse. See AsyncPipeline::releaseResult.
+    void releaseResult(std::unique_ptr<GraphResult>&& result);
+
+    /// Waits until all submitted frames are processed by all nodes
+    void waitForTotalCompletion();
+
+    /// Sets recorder of the outputs of the node, see AsyncPipeline::setOutputsRecorder
+    /// @param name - name of the node, empty name means the root node
+    /// @param recorder - pointer to recorder object, it should outlive the graph. Null disables recording.
+    void setOutputsRecorder(const std::string& name, OutputsRecorder* recorder);
+
+protected:
+    struct PendingRoi {
+        /// ImageInputData of the cropped ROI or RotatedRoiInputData of the whole frame
+        std::shared_ptr<InputData> inputData;
+        std::shared_ptr<RoiMetaData> metaData;
+    };
+
+    struct Node {
+        std::string name;
+        std::unique_ptr<AsyncPipeline> pipeline;
+        /// One of the extractors is set
+        RoiExtractor roiExtractor;
+        RotatedRoiExtractor rotatedRoiExtractor;
+        std::vector<size_t> children;
+        std::deque<PendingRoi> pendingRois;
+    };
+
+    struct FrameEntry {
+        cv::Mat frame;
+        std::unique_ptr<GraphResult> result;
+        size_t pendingRoisCount = 0;
+    };
+
+    Node& createNode(const std::string& name, std::unique_ptr<ModelBase>&& model, const CnnConfig& cnnConfig,
+        InferenceEngine::Core& engine, const std::string& parentName);
+    /// Collects available results from all nodes, fans out ROIs to child nodes and submits pending ROIs
+    void pump();
+    void fanOut(size_t nodeIdx, int parentIndex, const ResultBase& parentResult, int64_t rootFrameId, FrameEntry& entry);
+    bool isResultReady() const;
+    void onCompletion();
+
+    std::vector<Node> nodes;
+    std::map<int64_t, FrameEntry> frames;
+    size_t framesInFlight = 0;
+    size_t maxFramesInFlight;
+
+    std::mutex mtx;
+    std::condition_variable condVar;
+    uint64_t completionsCounter = 0;
+};
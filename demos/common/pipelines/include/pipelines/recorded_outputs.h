@@ -0,0 +1,75 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "models/results.h"
+
+/// This is class writing outputs of inferred frames to a file, so postprocessing of the model can be profiled later
+/// on the recorded outputs, without inference (see RecordedOutputs).
+/// Every frame is a record of its frame ID, index in the batch, size of the input image (InternalImageModelData)
+/// and all output blobs of its request. The records and the blobs in them are aligned to 64 bytes, so the blobs
+/// of the memory mapped file are used in place. Models keeping other data in InternalModelData can't be replayed.
+/// Recording is thread safe, the frames are written in the order they are postprocessed.
+class OutputsRecorder {
+public:
+    /// @param fileName - name of the file to write, existing file is overwritten
+    explicit OutputsRecorder(const std::string& fileName);
+
+    /// Writes the outputs of the frame
+    /// @param infResult - result of the inference, before it's postprocessed
+    /// @param batchSize - batch size the network was reshaped to, replay reshapes the network the same way
+    void record(const InferenceResult& infResult, size_t batchSize);
+
+private:
+    std::mutex mtx;
+    std::ofstream file;
+    std::vector<char> buffer;
+};
+
+/// This is class reading outputs written by OutputsRecorder. The file is memory mapped (or read at once where
+/// mapping isn't supported) and output blobs of the results refer to its memory, nothing is copied per frame.
+class RecordedOutputs {
+public:
+    explicit RecordedOutputs(const std::string& fileName);
+    ~RecordedOutputs();
+    RecordedOutputs(const RecordedOutputs&) = delete;
+    RecordedOutputs& operator=(const RecordedOutputs&) = delete;
+
+    /// @returns number of recorded frames
+    size_t size() const { return records.size(); }
+
+    /// @returns batch size the network was reshaped to while recording
+    size_t getBatchSize() const { return batchSize; }
+
+    /// Returns the outputs of the recorded frame as they came to the postprocessing.
+    /// metaData isn't recorded and is null. The blobs stay valid while this object exists.
+    InferenceResult getResult(size_t index) const;
+
+private:
+    char* data = nullptr;
+    size_t dataSize = 0;
+    bool isMapped = false;
+    /// Used if the file isn't mapped
+    std::vector<uint64_t> fileContent;
+    /// Offsets of the records in data
+    std::vector<size_t> records;
+    size_t batchSize = 0;
+};
@@ -0,0 +1,78 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// This is class choosing the number of requests in flight of the pipeline on its first frames.
+/// Every candidate number (1, 2, 4, ... and the number of requests of the pipeline) is used for a window of frames,
+/// and the one with the highest throughput, whose mean latency fits the latency limit, is kept.
+/// The decision is stored to a file, so next runs with the same model, device and config skip tuning.
+class RequestsAutotuner {
+public:
+    /// @param maxRequests - number of requests of the pipeline
+    /// @param framesPerCandidate - number of inferred frames measured for every candidate
+    /// @param latencyLimit - maximum mean latency of inference. Zero means no limit.
+    /// If no candidate fits it, the one with the lowest latency is taken.
+    /// @param cacheFileName - file to read the decision from and to write it to. Empty string disables caching.
+    RequestsAutotuner(size_t maxRequests, size_t framesPerCandidate, std::chrono::milliseconds latencyLimit,
+        const std::string& cacheFileName);
+
+    /// Returns the number of requests to be used in flight now
+    size_t getRequestsLimit() const;
+
+    /// Returns true until the decision is made
+    bool isTuning() const;
+
+    /// Records completed inference. This function is thread safe.
+    /// @param framesCount - number of frames inferred by the request
+    /// @param latency - time of inference of the request
+    /// @param completionTime - time of completion of the request
+    /// @returns the number of requests to be used in flight from now on
+    size_t recordCompletion(size_t framesCount, std::chrono::steady_clock::duration latency,
+        std::chrono::steady_clock::time_point completionTime);
+
+protected:
+    struct Candidate {
+        size_t requestsCount;
+        double fps = 0;
+        double latencyMs = 0;
+    };
+
+    void chooseBest();
+
+    size_t framesPerCandidate;
+    std::chrono::milliseconds latencyLimit;
+    std::string cacheFileName;
+
+    mutable std::mutex mtx;
+    std::vector<Candidate> candidates;
+    size_t currentCandidate = 0;
+    size_t requestsLimit;
+    bool isTuningDone = false;
+
+    /// Measurements of the current candidate. Its window starts with the first completion,
+    /// which is counted in latency but not in throughput.
+    size_t windowFrames = 0;
+    size_t windowCompletions = 0;
+    std::chrono::steady_clock::duration windowLatency{0};
+    std::chrono::steady_clock::time_point windowStart;
+};
@@ -16,18 +16,24 @@
 
 #pragma once
 
-#include <map>
 #include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <opencv2/core.hpp>
 #include <inference_engine.hpp>
-#include <map>
+#include <samples/mpmc_queue.hpp>
 
 
 /// This is class storing requests pool for asynchronous pipeline
-///
+/// Idle requests are kept in lock-free queue of indices, so acquiring and releasing of request takes O(1)
+/// and doesn't contend with completion callbacks of other requests
 class RequestsPool {
 public:
-    RequestsPool(InferenceEngine::ExecutableNetwork& execNetwork, unsigned int size);
+    /// @param deviceName - device the network is loaded to, the blobs of CPU requests are put on huge pages
+    /// (see setHugePageBlobs)
+    RequestsPool(InferenceEngine::ExecutableNetwork& execNetwork, unsigned int size, const std::string& deviceName);
 
     /// Returns idle request from the pool. Returned request is automatically marked as In Use (this status will be reset after request processing completion)
     /// This function is thread safe as long as request is used only until setRequestIdle call
@@ -39,12 +45,19 @@ public:
     /// @param request - request to be returned to idle state
     void setRequestIdle(const InferenceEngine::InferRequest::Ptr& request);
 
+    /// Creates lease on the request which is currently in use. Request will be returned to idle state
+    /// when the last copy of the returned pointer is destroyed, so it shouldn't be used after that.
+    /// The pool should outlive all leases created by this function.
+    /// @param request - request to be leased
+    /// @returns pointer to the same request which sets it idle upon destruction
+    InferenceEngine::InferRequest::Ptr leaseRequest(const InferenceEngine::InferRequest::Ptr& request);
+
     /// Returns number of requests in use. This function is thread safe.
     /// @returns number of requests in use
     size_t getInUseRequestsCount();
 
-    /// Returns number of requests in use. This function is thread safe.
-    /// @returns number of requests in use
+    /// Returns true if there's at least one idle request in the pool. This function is thread safe.
+    /// @returns true if idle request is available
     bool isIdleRequestAvailable();
 
     /// Waits for completion of every non-idle requests in pool.
@@ -57,7 +70,10 @@ public:
     std::vector<InferenceEngine::InferRequest::Ptr> getInferRequestsList();
 
 private:
-    std::map<InferenceEngine::InferRequest::Ptr, bool> requests;
-    size_t numRequestsInUse;
-    std::mutex mtx;
+    std::vector<InferenceEngine::InferRequest::Ptr> requests;
+    // Filled in constructor and never modified after that, so it's safe to read it without synchronization
+    std::unordered_map<const InferenceEngine::InferRequest*, size_t> requestsIndices;
+    std::unique_ptr<std::atomic<bool>[]> requestsInUse;
+    MpmcQueue<size_t> idleRequestsIndices;
+    std::atomic<size_t> numRequestsInUse;
 };
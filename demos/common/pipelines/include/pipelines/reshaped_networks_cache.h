@@ -0,0 +1,89 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <inference_engine.hpp>
+#include <opencv2/core.hpp>
+
+/// This is class keeping the network loaded for several input sizes, so inputs of varying size are inferred
+/// at their own resolution without reloading the network for every size change.
+/// Input sizes are rounded up to canonical sizes (multiples of the size step), so close sizes share a network and
+/// the input is padded to the canonical size. Networks are loaded in background threads when they are prefetched,
+/// the least recently used one is unloaded when there are more of them than the capacity.
+class ReshapedNetworksCache {
+public:
+    /// Returns shapes of network inputs for the canonical input size
+    using ShapesFunction = std::function<InferenceEngine::ICNNNetwork::InputShapes(const cv::Size& size)>;
+
+    /// @param engine - reference to InferenceEngine::Core instance to use. It should outlive the cache.
+    /// @param cnnNetwork - network with inputs and outputs already configured. The cache reshapes it.
+    /// @param getShapes - function returning input shapes for the canonical size
+    /// @param device - device to load network to
+    /// @param config - configuration for ExecutableNetwork
+    /// @param capacity - maximum number of loaded networks
+    /// @param sizeStep - sizes are rounded up to multiples of this value
+    ReshapedNetworksCache(InferenceEngine::Core& engine, const InferenceEngine::CNNNetwork& cnnNetwork,
+        const ShapesFunction& getShapes, const std::string& device,
+        const std::map<std::string, std::string>& config, size_t capacity, int sizeStep);
+    virtual ~ReshapedNetworksCache();
+
+    /// @returns the size the input should be padded to: size rounded up to multiples of size step
+    cv::Size getCanonicalSize(const cv::Size& size) const;
+
+    /// Starts loading the network for the canonical size in background if it isn't loaded yet
+    void prefetch(const cv::Size& canonicalSize);
+
+    /// Returns the network for the canonical size, waiting for it to be loaded if needed.
+    /// Rethrows exception happened during loading.
+    std::shared_ptr<InferenceEngine::ExecutableNetwork> get(const cv::Size& canonicalSize);
+
+protected:
+    using NetworkFuture = std::shared_future<std::shared_ptr<InferenceEngine::ExecutableNetwork>>;
+    struct Entry {
+        NetworkFuture network;
+        uint64_t lastUse;
+    };
+    using Key = std::pair<int, int>;
+
+    /// Returns entry for the size starting loading if needed. Should be called with mtx locked.
+    Entry& getEntry(const cv::Size& canonicalSize);
+    std::shared_ptr<InferenceEngine::ExecutableNetwork> load(const cv::Size& canonicalSize);
+    /// Unloads least recently used networks which are loaded already. Should be called with mtx locked.
+    void evict();
+
+    InferenceEngine::Core& engine;
+    InferenceEngine::CNNNetwork cnnNetwork;
+    ShapesFunction getShapes;
+    std::string device;
+    std::map<std::string, std::string> config;
+    size_t capacity;
+    int sizeStep;
+
+    std::mutex mtx;
+    /// CNNNetwork is reshaped and compiled by one thread at a time
+    std::mutex loadMtx;
+    std::map<Key, Entry> entries;
+    uint64_t usesCounter = 0;
+};
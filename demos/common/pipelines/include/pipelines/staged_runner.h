@@ -0,0 +1,145 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "pipelines/async_pipeline.h"
+#include "pipelines/metadata.h"
+
+class ImagesCapture;
+class PerformanceMetrics;
+class TraceProfiler;
+
+/// This is class running capture, inference and rendering of a demo as three concurrent stages:
+/// capture thread reads frames into a bounded queue, pipeline thread submits them to AsyncPipeline
+/// and moves results to another bounded queue, and the thread calling run() renders them.
+/// So neither decoding nor rendering delays submission of the next frame to the device.
+class StagedRunner {
+public:
+    /// What a stage does when the queue it writes to is full
+    enum class DropPolicy {
+        Block,  // Wait until the next stage takes an item, so every frame is processed
+        DropOldest  // Discard the oldest queued item, so the newest frames are processed (live cameras).
+                    // With queue size 1 only the latest frame is kept
+    };
+
+    struct Config {
+        size_t captureQueueSize = 2;
+        DropPolicy capturePolicy = DropPolicy::Block;
+        size_t renderQueueSize = 2;
+        DropPolicy renderPolicy = DropPolicy::Block;
+        /// Captured frames which waited longer than this since their capture started are discarded instead of
+        /// being submitted, so the latency of live inputs stays bounded under overload. 0 means no limit.
+        std::chrono::milliseconds maxFrameAge = std::chrono::milliseconds(0);
+    };
+
+    /// Function returning the next frame, empty frame means the input is over. Called from the capture thread.
+    using CaptureFunction = std::function<cv::Mat()>;
+    /// Function returning the next frame and the index of its input, e.g. MultiSourceCapture::readFrom.
+    /// The index is passed to the result in ImageMetaData::sourceId.
+    using SourceCaptureFunction = std::function<cv::Mat(size_t& sourceId)>;
+    /// Function rendering the result, called from the thread calling run().
+    /// Result's metaData is ImageMetaData with the captured frame. Returns false to stop processing.
+    using RenderFunction = std::function<bool(const ResultBase& result)>;
+
+    /// @param pipeline - pipeline to submit frames to. It should outlive the runner.
+    /// The runner sets its completion listener, so pipeline's listener shouldn't be used by anyone else.
+    /// @param config - sizes of queues between stages and frame drop policies
+    StagedRunner(AsyncPipeline& pipeline, const Config& config);
+    virtual ~StagedRunner();
+
+    /// Sets metrics object to record decode stage durations to. See AsyncPipeline::setPerformanceMetrics.
+    void setPerformanceMetrics(PerformanceMetrics* metrics) { performanceMetrics = metrics; }
+
+    /// Sets profiler to add decode spans to. See AsyncPipeline::setTraceProfiler.
+    void setTraceProfiler(TraceProfiler* profiler) { traceProfiler = profiler; }
+
+    /// Processes frames until capture function returns an empty frame and all results are rendered,
+    /// or until render function returns false. Rendering is done on the calling thread,
+    /// as some platforms allow GUI functions (cv::imshow, cv::waitKey) on the main thread only.
+    /// Exceptions thrown in any stage are rethrown from this function after all stages are stopped.
+    /// Should be called once.
+    /// @param capture - function returning frames. Throws if the very first frame is empty.
+    /// @param render - function rendering results
+    void run(const CaptureFunction& capture, const RenderFunction& render);
+    /// Same as above for the frames of several inputs
+    void run(const SourceCaptureFunction& capture, const RenderFunction& render);
+    /// Same as above for the frames read from the capture. ImageMetaData::timeStamp is the capture time
+    /// of the frame if the capture knows it (ImagesCapture::getLastFrameTime()), e.g. for live streams,
+    /// and the input index of MultiSourceCapture is passed in ImageMetaData::sourceId.
+    void run(ImagesCapture& capture, const RenderFunction& render);
+
+    /// @returns number of captured frames discarded before submission because of DropPolicy::DropOldest
+    /// or Config::maxFrameAge
+    size_t getDroppedCapturedCount() const { return droppedCapturedCount; }
+    /// @returns number of results discarded before rendering because of DropPolicy::DropOldest
+    size_t getDroppedResultsCount() const { return droppedResultsCount; }
+
+protected:
+    struct CapturedFrame {
+        cv::Mat frame;
+        /// Capture time of the frame, the frame age and the end-to-end latency are counted from it
+        std::chrono::steady_clock::time_point startTime;
+        std::chrono::steady_clock::time_point queuedTime;
+        size_t sourceId;
+    };
+
+    /// Returns the next frame, sets the index of its input and its capture time if it's known
+    using TimedCaptureFunction = std::function<cv::Mat(size_t& sourceId,
+        std::chrono::steady_clock::time_point& captureTime)>;
+
+    void runStages(const TimedCaptureFunction& capture, const RenderFunction& render);
+    void captureLoop(const TimedCaptureFunction& capture);
+    void pipelineLoop();
+    void renderLoop(const RenderFunction& render);
+    /// Submits captured frames while the pipeline has free requests
+    void submitFrames();
+    /// Moves all available results of the pipeline to the render queue
+    void forwardResults();
+    void pushResult(std::unique_ptr<ResultBase>&& result);
+    void onCompletion();
+    /// Stores the first exception happened in any stage and stops the others. Should be called with mtx locked.
+    void setException(const std::exception_ptr& exception);
+    void stop();
+
+    AsyncPipeline& pipeline;
+    Config config;
+    PerformanceMetrics* performanceMetrics = nullptr;
+    TraceProfiler* traceProfiler = nullptr;
+
+    std::thread captureThread;
+    std::thread pipelineThread;
+
+    std::mutex mtx;
+    std::condition_variable condVar;
+    std::deque<CapturedFrame> capturedFrames;
+    std::deque<std::unique_ptr<ResultBase>> results;
+    bool isCaptureFinished = false;
+    bool isPipelineFinished = false;
+    bool isStopping = false;
+    std::exception_ptr stageException = nullptr;
+    uint64_t completionsCounter = 0;
+    size_t droppedCapturedCount = 0;
+    size_t droppedResultsCount = 0;
+};
@@ -0,0 +1,115 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "pipelines/async_pipeline.h"
+
+/// This is base class for pipelines submitting every frame to one of two AsyncPipelines, which one is chosen
+/// by the derived class. After a switch the frames in flight of the previous pipeline are still completed
+/// and returned, the results are returned in submission order with frame IDs of this class.
+/// It has the polling interface of AsyncPipeline. The pipelines shouldn't batch frames and should keep results
+/// in submission order: the results are taken from them in submission order, so a frame waiting in an incomplete
+/// batch or a result returned ahead of its predecessors would block the results of both pipelines.
+/// All functions should be called from the same thread.
+class SwitchingPipeline {
+public:
+    virtual ~SwitchingPipeline();
+
+    /// @returns true if next frame can be submitted to the current pipeline
+    bool isReadyToProcess() { return pipelines[activePipeline]->isReadyToProcess(); }
+
+    /// Submits data to the pipeline chosen for it, see AsyncPipeline::submitData
+    /// @returns -1 if the data cannot be scheduled for processing, frame ID otherwise
+    int64_t submitData(const InputData& inputData, const std::shared_ptr<MetaData>& metaData);
+
+    /// Waits until either the next result becomes available or more data can be submitted
+    void waitForData();
+
+    /// @returns result of the next submitted frame or nullptr if it isn't ready yet
+    std::unique_ptr<ResultBase> getResult();
+
+    /// Returns the result back to the model of the pipeline which produced it, see AsyncPipeline::releaseResult.
+    /// Results released much later than they were taken are just destroyed.
+    void releaseResult(std::unique_ptr<ResultBase>&& result);
+
+    /// Waits for all the submitted frames of both pipelines to be completed
+    void waitForTotalCompletion();
+
+    /// Sets metrics object to both pipelines, see AsyncPipeline::setPerformanceMetrics
+    void setPerformanceMetrics(PerformanceMetrics* metrics);
+
+    /// @returns index of the pipeline the next frame is submitted to
+    size_t getActivePipeline() const { return activePipeline; }
+
+protected:
+    SwitchingPipeline() = default;
+
+    /// Takes ownership of both pipelines and starts with the first one, should be called by the constructor
+    /// of the derived class. Throws std::invalid_argument if a pipeline batches frames or reorders results.
+    void setPipelines(std::unique_ptr<AsyncPipeline>&& first, std::unique_ptr<AsyncPipeline>&& second);
+
+    /// Throws std::invalid_argument if the pipeline created with the configuration can't be switched,
+    /// so the derived classes can check their configurations before the networks are loaded
+    static void checkConfig(const CnnConfig& cnnConfig);
+
+    /// Chooses the pipeline for the next frame
+    /// @param framesInFlight - number of frames submitted and not returned yet, including the next one
+    /// @param now - submission time of the next frame
+    /// @returns index of the pipeline
+    virtual size_t selectPipeline(size_t framesInFlight, std::chrono::steady_clock::time_point now) = 0;
+
+    /// Is called for every result returned in submission order
+    /// @param pipelineIndex - index of the pipeline which produced the result
+    /// @param latency - time from the submission of the frame till its result is taken
+    virtual void onResult(size_t /*pipelineIndex*/, std::chrono::steady_clock::duration /*latency*/) {}
+
+    /// Returns human readable name of the pipeline for the log
+    virtual const char* pipelineName(size_t pipelineIndex) const = 0;
+
+    std::unique_ptr<AsyncPipeline> pipelines[2];
+
+private:
+    struct SubmittedFrame {
+        size_t pipelineIndex;
+        int64_t frameId;
+        std::chrono::steady_clock::time_point submitTime;
+    };
+
+    /// Takes the result of the oldest submitted frame from its pipeline if it's ready
+    bool fetchNextResult();
+    void onCompletion();
+
+    size_t activePipeline = 0;
+    /// Frames submitted and not returned yet, in submission order
+    std::deque<SubmittedFrame> submittedFrames;
+    /// Last frames returned, to release their results to the models which produced them
+    std::deque<SubmittedFrame> returnedFrames;
+    std::unique_ptr<ResultBase> nextResult;
+    int64_t inputFrameId = 0;
+
+    std::mutex mtx;
+    std::condition_variable condVar;
+    /// Number of completions of both pipelines, protected by mtx
+    uint64_t completionsCount = 0;
+};
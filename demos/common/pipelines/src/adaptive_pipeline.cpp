@@ -0,0 +1,80 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/adaptive_pipeline.h"
+#include <utility>
+#include <samples/slog.hpp>
+
+LoadModeSelector::LoadModeSelector(size_t latencyRequests, std::chrono::steady_clock::duration window) :
+    latencyRequests(latencyRequests), window(window) {}
+
+LoadModeSelector::Mode LoadModeSelector::onSubmit(size_t depth, std::chrono::steady_clock::time_point now) {
+    if (!isWindowStarted) {
+        windowStart = now;
+        isWindowStarted = true;
+    }
+    windowSubmissions++;
+    windowDepthSum += depth;
+
+    const double seconds = std::chrono::duration<double>(now - windowStart).count();
+    if (now - windowStart < window || seconds <= 0)
+        return mode;
+
+    const double meanDepth = static_cast<double>(windowDepthSum) / windowSubmissions;
+    const double arrivalRate = windowSubmissions / seconds;
+    if (mode == Mode::Latency && meanDepth >= latencyRequests) {
+        latencyCapacity = windowResults / seconds;
+        mode = Mode::Throughput;
+        switchesCount++;
+    }
+    else if (mode == Mode::Throughput && arrivalRate < 0.75 * latencyCapacity) {
+        mode = Mode::Latency;
+        switchesCount++;
+    }
+
+    windowStart = now;
+    windowSubmissions = 0;
+    windowResults = 0;
+    windowDepthSum = 0;
+    return mode;
+}
+
+AdaptivePipeline::AdaptivePipeline(const ModelFactory& modelFactory, const CnnConfig& latencyConfig,
+    const CnnConfig& throughputConfig, InferenceEngine::Core& engine, std::chrono::steady_clock::duration window) :
+    selector(1, window) {
+    checkConfig(latencyConfig);
+    checkConfig(throughputConfig);
+    slog::info << "Loading the latency configuration" << slog::endl;
+    std::unique_ptr<AsyncPipeline> latencyPipeline(new AsyncPipeline(modelFactory(), latencyConfig, engine));
+    slog::info << "Loading the throughput configuration" << slog::endl;
+    std::unique_ptr<AsyncPipeline> throughputPipeline(new AsyncPipeline(modelFactory(), throughputConfig, engine));
+    selector = LoadModeSelector(latencyPipeline->getRequestsCount(), window);
+    // Pipelines are indexed by LoadModeSelector::Mode
+    setPipelines(std::move(latencyPipeline), std::move(throughputPipeline));
+}
+
+size_t AdaptivePipeline::selectPipeline(size_t framesInFlight, std::chrono::steady_clock::time_point now) {
+    return static_cast<size_t>(selector.onSubmit(framesInFlight, now));
+}
+
+void AdaptivePipeline::onResult(size_t /*pipelineIndex*/, std::chrono::steady_clock::duration /*latency*/) {
+    selector.onResult();
+}
+
+const char* AdaptivePipeline::pipelineName(size_t pipelineIndex) const {
+    return pipelineIndex == static_cast<size_t>(LoadModeSelector::Mode::Latency) ?
+        "latency configuration" : "throughput configuration";
+}
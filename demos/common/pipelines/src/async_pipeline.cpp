@@ -15,20 +15,106 @@
 */
 
 #include "pipelines/async_pipeline.h"
+#include <algorithm>
 #include <cldnn/cldnn_config.hpp>
 #include <samples/common.hpp>
+#include <samples/frame_tracer.hpp>
+#include <samples/performance_metrics.hpp>
+#include <samples/read_network.hpp>
 #include <samples/slog.hpp>
+#include <samples/thread_budget.hpp>
+#include <samples/trace_profiler.hpp>
+#include <samples/warmup.hpp>
+#include "pipelines/recorded_outputs.h"
 
 using namespace InferenceEngine;
 
+namespace {
+// Frames of a single stream are traced as source 0
+template<typename BatchItems>
+void traceBatchFlows(const BatchItems& batch) {
+#ifdef OMZ_FRAME_TRACE
+    for (const auto& item : batch)
+        FRAME_TRACE_FLOW(item.frameId, 0);
+#else
+    (void)batch;
+#endif
+}
+
+template<typename T>
+MemoryBlob::Ptr copyBlob(const Blob::Ptr& blob) {
+    return std::make_shared<TBlob<T>>(*as<TBlob<T>>(blob));
+}
+
+// Outputs keep the precision the model has requested, e.g. FP16 isn't converted
+MemoryBlob::Ptr copyOutput(const Blob::Ptr& blob) {
+    switch (blob->getTensorDesc().getPrecision()) {
+    case Precision::FP32:
+        return copyBlob<float>(blob);
+    case Precision::FP16:
+    case Precision::I16:
+        return copyBlob<int16_t>(blob);
+    case Precision::I32:
+        return copyBlob<int32_t>(blob);
+    case Precision::U8:
+        return copyBlob<uint8_t>(blob);
+    default:
+        throw std::runtime_error(std::string("Output has unsupported precision ") +
+            blob->getTensorDesc().getPrecision().name());
+    }
+}
+}
+
+template<typename Results>
+bool AsyncPipeline::isNextResultReady(const Results& results) const {
+    if (results.empty())
+        return false;
+    if (unorderedResults || lateResultsCount > 0)
+        return true;
+    if (maxReorderBufferSize && results.size() >= maxReorderBufferSize)
+        return true;
+    return results.find(outputFrameId) != results.end();
+}
+
+template<typename Results>
+typename Results::iterator AsyncPipeline::findNextResult(Results& results) const {
+    auto it = results.find(outputFrameId);
+    if (it == results.end() && isNextResultReady(results)) {
+        // Late results go first, otherwise the oldest completed result is taken
+        it = std::min_element(results.begin(), results.end(),
+            [](const typename Results::value_type& a, const typename Results::value_type& b) {
+                return a.first < b.first;
+            });
+    }
+    return it;
+}
+
+template<typename Results, typename Result>
+void AsyncPipeline::addCompletedResult(Results& results, int64_t frameId, Result&& result) {
+    if (frameId < outputFrameId)
+        lateResultsCount++;
+    results.emplace(frameId, std::forward<Result>(result));
+}
+
 AsyncPipeline::AsyncPipeline(std::unique_ptr<ModelBase>&& modelInstance, const CnnConfig& cnnConfig, InferenceEngine::Core& engine) :
+    zeroCopyOutputs(cnnConfig.zeroCopyOutputs),
+    maxBatchSize(std::max(cnnConfig.maxBatchSize, 1u)),
+    maxBatchWaitTime(cnnConfig.maxBatchWaitTime),
+    unorderedResults(cnnConfig.unorderedResults),
+    maxReorderBufferSize(cnnConfig.maxReorderBufferSize),
     model(std::move(modelInstance)) {
 
     // --------------------------- 1. Load inference engine ------------------------------------------------
     slog::info << "Loading Inference Engine" << slog::endl;
 
+    // With load balancing every device gets its own copy of the network, otherwise device string goes to IE as is
+    std::vector<std::string> devices = cnnConfig.balancedDevices;
+    if (devices.empty())
+        devices.push_back(cnnConfig.devices);
+
     slog::info << "Device info: " << slog::endl;
-    slog::info<< printable(engine.GetVersions(cnnConfig.devices));
+    for (const auto& device : devices)
+        slog::info<< printable(engine.GetVersions(device));
 
     /** Load extensions for the plugin **/
     if (!cnnConfig.cpuExtensionsPath.empty()) {
@@ -44,75 +130,549 @@ AsyncPipeline::AsyncPipeline(std::unique_ptr<ModelBase>&& modelInstance, const C
     // --------------------------- 2. Read IR Generated by ModelOptimizer (.xml and .bin files) ------------
     slog::info << "Loading network files" << slog::endl;
     /** Read network model **/
-    InferenceEngine::CNNNetwork cnnNetwork = engine.ReadNetwork(model->getModelFileName());
-    /** Set batch size to 1 **/
-    slog::info << "Batch size is forced to 1." << slog::endl;
+    InferenceEngine::CNNNetwork cnnNetwork = readNetwork(engine, model->getModelFileName(), cnnConfig.mapWeights);
+    /** Set batch size **/
+    slog::info << "Batch size is forced to " << maxBatchSize << "." << slog::endl;
 
     auto shapes = cnnNetwork.getInputShapes();
     for (auto& shape : shapes) {
-        shape.second[0] = 1;
+        shape.second[0] = maxBatchSize;
     }
     cnnNetwork.reshape(shapes);
 
     // -------------------------- Reading all outputs names and customizing I/O blobs (in inherited classes)
+    model->allowFp16Outputs(cnnConfig.fp16Outputs);
+    model->enableDevicePostprocessing(cnnConfig.devicePostprocessing);
     model->prepareInputsOutputs(cnnNetwork);
 
-    // --------------------------- 4. Loading model to the device ------------------------------------------
-    slog::info << "Loading model to the device" << slog::endl;
-    execNetwork = engine.LoadNetwork(cnnNetwork, cnnConfig.devices, cnnConfig.execNetworkConfig);
+    // --------------------------- 4. Loading model to the devices and creating infer requests -------------
+    std::unique_ptr<NetworkCache> networkCache;
+    if (!cnnConfig.cacheDir.empty())
+        networkCache.reset(new NetworkCache(cnnConfig.cacheDir));
+    requestsPool.reset(new DeviceScheduler(engine, cnnNetwork, devices, cnnConfig.execNetworkConfig,
+        cnnConfig.maxAsyncRequests, networkCache.get(), model->getModelFileName(), cnnConfig.networkRegistry));
+    // The postprocessing runs on the CPU threads the networks of the process leave
+    for (const auto& device : devices) {
+        if (device.find("CPU") != std::string::npos)
+            ThreadBudget::global().addCpuNetwork(cnnConfig.execNetworkConfig);
+    }
+    ThreadBudget::global().applyToOpenCV();
+    if (cnnConfig.autotuneRequests) {
+        std::string autotuneFileName;
+        if (networkCache) {
+            autotuneFileName = networkCache->getCacheFileName(engine, cnnNetwork, model->getModelFileName(),
+                cnnConfig.devices, cnnConfig.execNetworkConfig, ".requests");
+        }
+        requestsAutotuner.reset(new RequestsAutotuner(requestsPool->getRequestsCount(), cnnConfig.autotuneFrames,
+            cnnConfig.latencyLimit, autotuneFileName));
+        requestsPool->setRequestsLimit(requestsAutotuner->getRequestsLimit());
+    }
+
+    // --------------------------- 5. Call onLoadCompleted to complete initialization of model -------------
+    model->onLoadCompleted(&requestsPool->getExecNetwork(), requestsPool->getInferRequestsList());
+
+    // --------------------------- 6. Warm up the requests before the first frame --------------------------
+    if (cnnConfig.warmupRounds > 0) {
+        WarmupResult warmup = warmupRequests(requestsPool->getInferRequestsList(),
+            requestsPool->getExecNetwork().GetInputsInfo(), cnnConfig.warmupRounds);
+        slog::info << "Warmed up in " << warmup.rounds << " rounds, the last one took "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(warmup.latency).count() << " ms"
+            << (warmup.isSteady ? "" : ", inference time hasn't settled yet") << slog::endl;
+    }
 
-    // --------------------------- 5. Create infer requests ------------------------------------------------
-    requestsPool.reset(new RequestsPool(execNetwork, cnnConfig.maxAsyncRequests));
+    // --------------------------- 7. Start background preprocessing ---------------------------------------
+    if (cnnConfig.preprocessThreads > 0) {
+        // Every task occupies a slot of some request, so queue never grows bigger than this
+        maxPreprocessTasks = requestsPool->getInferRequestsList().size() * maxBatchSize;
+        for (unsigned int i = 0; i < cnnConfig.preprocessThreads; i++)
+            preprocessWorkers.emplace_back(&AsyncPipeline::preprocessWorkerLoop, this);
+    }
 
-    // --------------------------- 6. Call onLoadCompleted to complete initialization of model -------------
-    model->onLoadCompleted(&execNetwork, requestsPool->getInferRequestsList());
+    // --------------------------- 8. Start background postprocessing --------------------------------------
+    for (unsigned int i = 0; i < cnnConfig.postprocessThreads; i++)
+        postprocessWorkers.emplace_back(&AsyncPipeline::postprocessWorkerLoop, this);
 }
 
 AsyncPipeline::~AsyncPipeline() {
     waitForTotalCompletion();
+    stopDispatcher();
+    stopPreprocessWorkers();
+    stopPostprocessWorkers();
+}
+
+void AsyncPipeline::waitForTotalCompletion() {
+    flushPendingBatch();
+    {
+        // Requests of batches which are still being preprocessed aren't started yet, so they can't be waited for
+        std::unique_lock<std::mutex> lock(preprocessMtx);
+        preprocessCondVar.wait(lock, [&] { return notStartedBatches == 0; });
+    }
+    if (requestsPool)
+        requestsPool->waitForTotalCompletion();
+    std::unique_lock<std::mutex> lock(postprocessMtx);
+    postprocessCondVar.wait(lock, [&] { return activePostprocessTasks == 0; });
+}
+
+void AsyncPipeline::stopPreprocessWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(preprocessMtx);
+        isStopping = true;
+    }
+    preprocessCondVar.notify_all();
+    for (auto& worker : preprocessWorkers)
+        worker.join();
+    preprocessWorkers.clear();
+}
+
+void AsyncPipeline::preprocessWorkerLoop() {
+    for (;;) {
+        PreprocessTask task;
+        {
+            std::unique_lock<std::mutex> lock(preprocessMtx);
+            preprocessCondVar.wait(lock, [&] { return isStopping || !preprocessTasks.empty(); });
+            if (preprocessTasks.empty())
+                return;
+            task = std::move(preprocessTasks.front());
+            preprocessTasks.pop_front();
+        }
+        preprocessCondVar.notify_all();
+
+        try {
+            preprocessBatchItem(*task.inputData, *task.batch, task.batchIndex);
+        }
+        catch (...) {
+            // Batch is not inferred then, its request is returned to the pool
+            task.batch->hasFailed = true;
+            setCallbackException(std::current_exception());
+        }
+        task.inputData.reset();
+
+        try {
+            completeBatchTask(task.batch);
+        }
+        catch (...) {
+            setCallbackException(std::current_exception());
+        }
+    }
+}
+
+void AsyncPipeline::stopPostprocessWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(postprocessMtx);
+        isPostprocessStopping = true;
+    }
+    postprocessCondVar.notify_all();
+    for (auto& worker : postprocessWorkers)
+        worker.join();
+    postprocessWorkers.clear();
+}
+
+void AsyncPipeline::postprocessWorkerLoop() {
+    for (;;) {
+        InferenceResult infResult;
+        {
+            std::unique_lock<std::mutex> lock(postprocessMtx);
+            postprocessCondVar.wait(lock, [&] { return isPostprocessStopping || !postprocessTasks.empty(); });
+            if (postprocessTasks.empty())
+                return;
+            infResult = std::move(postprocessTasks.front());
+            postprocessTasks.pop_front();
+        }
+
+        try {
+            auto result = postprocessResult(infResult);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                const int64_t frameId = result->frameId;
+                addCompletedResult(postprocessedResults, frameId, std::move(result));
+            }
+            condVar.notify_all();
+            if (completionListener)
+                completionListener();
+        }
+        catch (...) {
+            setCallbackException(std::current_exception());
+        }
+        infResult = InferenceResult();
+
+        {
+            std::lock_guard<std::mutex> lock(postprocessMtx);
+            activePostprocessTasks--;
+        }
+        postprocessCondVar.notify_all();
+    }
+}
+
+void AsyncPipeline::setCallbackException(const std::exception_ptr& exception) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!callbackException)
+            callbackException = exception;
+    }
+    condVar.notify_all();
+    if (completionListener)
+        completionListener();
 }
 
 void AsyncPipeline::waitForData() {
-    std::unique_lock<std::mutex> lock(mtx);
+    if (pendingBatch && std::chrono::steady_clock::now() >= pendingBatchDeadline) {
+        flushPendingBatch();
+    }
 
-    condVar.wait(lock, [&] {return callbackException != nullptr ||
+    auto isDataAvailable = [&] {return callbackException != nullptr ||
         requestsPool->isIdleRequestAvailable() ||
-        completedInferenceResults.find(outputFrameId) != completedInferenceResults.end();
-    });
+        isResultAvailable();
+    };
+
+    std::unique_lock<std::mutex> lock(mtx);
+    // Incomplete batch is waited for only till its deadline, then it's sent for inference and the wait continues
+    while (pendingBatch && !condVar.wait_until(lock, pendingBatchDeadline, isDataAvailable)) {
+        // Completion callbacks of the started request take the lock
+        lock.unlock();
+        flushPendingBatch();
+        lock.lock();
+    }
+    condVar.wait(lock, isDataAvailable);
 
     if (callbackException)
         std::rethrow_exception(callbackException);
 }
 
 int64_t AsyncPipeline::submitData(const InputData& inputData, const std::shared_ptr<MetaData>& metaData){
+    auto frameID = addToPendingBatch(inputData, metaData);
+    if (frameID < 0)
+        return -1;
+
+    if (pendingBatch->size >= maxBatchSize || std::chrono::steady_clock::now() >= pendingBatchDeadline) {
+        flushPendingBatch();
+    }
+    return frameID;
+}
+
+int64_t AsyncPipeline::addToPendingBatch(const InputData& inputData, const std::shared_ptr<MetaData>& metaData) {
+    if (!pendingBatch) {
+        auto request = requestsPool->getIdleRequest();
+        if (!request)
+            return -1;
+        pendingBatch = std::make_shared<PendingBatch>();
+        pendingBatch->request = request;
+        pendingBatch->items.resize(maxBatchSize);
+        pendingBatchDeadline = std::chrono::steady_clock::now() + maxBatchWaitTime;
+        std::lock_guard<std::mutex> lock(preprocessMtx);
+        notStartedBatches++;
+    }
+
     auto frameID = inputFrameId;
+    size_t batchIndex = pendingBatch->size;
+
+    BatchItem& item = pendingBatch->items[batchIndex];
+    item.frameId = frameID;
+    item.metaData = metaData;
+
+    if (preprocessWorkers.empty()) {
+        // Slot stays free if preprocessing fails, so the batch can still be used for next data
+        preprocessBatchItem(inputData, *pendingBatch, batchIndex);
+        pendingBatch->size++;
+    }
+    else {
+        PreprocessTask task;
+        task.inputData = inputData.clone();
+        task.batch = pendingBatch;
+        task.batchIndex = batchIndex;
+        pendingBatch->size++;
+        pendingBatch->remainingTasks++;
+        {
+            std::unique_lock<std::mutex> lock(preprocessMtx);
+            preprocessCondVar.wait(lock, [&] { return preprocessTasks.size() < maxPreprocessTasks; });
+            preprocessTasks.push_back(std::move(task));
+        }
+        preprocessCondVar.notify_all();
+    }
+
+    inputFrameId++;
+    if (inputFrameId < 0)
+        inputFrameId = 0;
+
+    return frameID;
+}
+
+void AsyncPipeline::preprocessBatchItem(const InputData& inputData, PendingBatch& batch, size_t batchIndex) {
+    FRAME_TRACE_SCOPE("Preprocess", batch.items[batchIndex].frameId, 0);
+    FRAME_TRACE_FLOW(batch.items[batchIndex].frameId, 0);
+    auto preprocessStartTime = std::chrono::steady_clock::now();
+    batch.items[batchIndex].internalModelData = model->preprocessBatchItem(inputData, batch.request, batchIndex);
+    if (performanceMetrics)
+        performanceMetrics->recordStage(PerformanceMetrics::Stage::Preprocess, preprocessStartTime);
+    if (traceProfiler)
+        traceProfiler->addSpan("Preprocess", preprocessStartTime, std::chrono::steady_clock::now());
+}
 
-    auto request = requestsPool->getIdleRequest();
-    if (!request)
+int64_t AsyncPipeline::submitBatch(const std::vector<std::reference_wrapper<const InputData>>& inputData,
+    const std::vector<std::shared_ptr<MetaData>>& metaData) {
+    if (inputData.empty() || inputData.size() > maxBatchSize) {
+        throw std::invalid_argument("Number of submitted items should be in range [1, " + std::to_string(maxBatchSize) + "]");
+    }
+    if (!metaData.empty() && metaData.size() != inputData.size()) {
+        throw std::invalid_argument("Number of metadata items should be equal to number of input items");
+    }
+
+    // Batch should go to a single request, so previously collected items are sent separately
+    flushPendingBatch();
+    if (!requestsPool->isIdleRequestAvailable())
         return -1;
 
-    auto internalModelData = model->preprocess(inputData, request);
+    int64_t firstFrameID = -1;
+    for (size_t i = 0; i < inputData.size(); i++) {
+        auto frameID = addToPendingBatch(inputData[i], metaData.empty() ? std::shared_ptr<MetaData>() : metaData[i]);
+        if (i == 0)
+            firstFrameID = frameID;
+    }
+    flushPendingBatch();
+
+    return firstFrameID;
+}
 
+int64_t AsyncPipeline::submit(const InputData& inputData, const std::shared_ptr<MetaData>& metaData,
+    const ResultContinuation& continuation) {
+    if (isSubmitting.exchange(true, std::memory_order_acquire))
+        throw std::logic_error("AsyncPipeline::submit shouldn't be called from several threads at once");
+    struct SubmittingGuard {
+        std::atomic<bool>& flag;
+        ~SubmittingGuard() { flag.store(false, std::memory_order_release); }
+    } submittingGuard{isSubmitting};
+
+    // The continuation is registered first, as the result may be ready before submitData returns
+    const int64_t frameId = inputFrameId;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (callbackException)
+            std::rethrow_exception(callbackException);
+        continuations[frameId] = continuation;
+        if (!dispatcher.joinable())
+            dispatcher = std::thread(&AsyncPipeline::dispatcherLoop, this);
+    }
+    try {
+        while (submitData(inputData, metaData) < 0) {
+            std::unique_lock<std::mutex> lock(mtx);
+            condVar.wait(lock, [&] {
+                return callbackException != nullptr || requestsPool->isIdleRequestAvailable();
+            });
+            if (callbackException)
+                std::rethrow_exception(callbackException);
+        }
+    }
+    catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            continuations.erase(frameId);
+        }
+        continuationsCondVar.notify_all();
+        throw;
+    }
+    return frameId;
+}
+
+std::future<std::unique_ptr<ResultBase>> AsyncPipeline::submit(const InputData& inputData,
+    const std::shared_ptr<MetaData>& metaData) {
+    auto promise = std::make_shared<std::promise<std::unique_ptr<ResultBase>>>();
+    auto future = promise->get_future();
+    submit(inputData, metaData, [promise](std::unique_ptr<ResultBase>&& result, const std::exception_ptr& error) {
+        if (error)
+            promise->set_exception(error);
+        else
+            promise->set_value(std::move(result));
+    });
+    return future;
+}
+
+void AsyncPipeline::waitForSubmittedResults() {
+    flushPendingBatch();
+    std::unique_lock<std::mutex> lock(mtx);
+    continuationsCondVar.wait(lock, [&] { return continuations.empty(); });
+    if (callbackException)
+        std::rethrow_exception(callbackException);
+}
+
+void AsyncPipeline::dispatcherLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            condVar.wait(lock, [&] {
+                return callbackException != nullptr || isResultAvailable()
+                    || (isDispatcherStopping && continuations.empty());
+            });
+            if (callbackException) {
+                // The pipeline has stopped, the data waiting for results get the exception instead
+                auto failedContinuations = std::move(continuations);
+                continuations.clear();
+                const std::exception_ptr error = callbackException;
+                lock.unlock();
+                for (auto& continuation : failedContinuations) {
+                    try {
+                        continuation.second(std::unique_ptr<ResultBase>(), error);
+                    }
+                    catch (...) {}
+                }
+                continuationsCondVar.notify_all();
+                return;
+            }
+            if (!isResultAvailable())
+                return;
+        }
+
+        int64_t frameId = -1;
+        try {
+            std::unique_ptr<ResultBase> result = getResult();
+            if (!result)
+                continue;
+            frameId = result->frameId;
+            ResultContinuation continuation;
+            {
+                // The entry is kept while the continuation runs, so waitForSubmittedResults waits for it
+                std::lock_guard<std::mutex> lock(mtx);
+                auto it = continuations.find(frameId);
+                if (it != continuations.end())
+                    continuation = it->second;
+            }
+            if (continuation)
+                continuation(std::move(result), nullptr);
+        }
+        catch (...) {
+            setCallbackException(std::current_exception());
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            continuations.erase(frameId);
+        }
+        // The result may have held its request (see CnnConfig::zeroCopyOutputs), so submit may go on now
+        condVar.notify_all();
+        continuationsCondVar.notify_all();
+    }
+}
+
+void AsyncPipeline::stopDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        isDispatcherStopping = true;
+    }
+    condVar.notify_all();
+    if (dispatcher.joinable())
+        dispatcher.join();
+}
+
+void AsyncPipeline::flushPendingBatch() {
+    if (!pendingBatch)
+        return;
+
+    auto batch = std::move(pendingBatch);
+    pendingBatch.reset();
+    completeBatchTask(batch);
+}
+
+void AsyncPipeline::completeBatchTask(const std::shared_ptr<PendingBatch>& batch) {
+    if (--batch->remainingTasks == 0)
+        startBatch(batch);
+}
+
+void AsyncPipeline::startBatch(const std::shared_ptr<PendingBatch>& batch) {
+    try {
+        if (batch->hasFailed || batch->size == 0) {
+            requestsPool->setRequestIdle(batch->request);
+        }
+        else {
+            inferBatch(batch);
+        }
+    }
+    catch (...) {
+        onBatchStarted();
+        throw;
+    }
+    onBatchStarted();
+}
+
+void AsyncPipeline::onBatchStarted() {
+    {
+        std::lock_guard<std::mutex> lock(preprocessMtx);
+        notStartedBatches--;
+    }
+    preprocessCondVar.notify_all();
+}
+
+void AsyncPipeline::inferBatch(const std::shared_ptr<PendingBatch>& pendingBatch) {
+    auto request = pendingBatch->request;
+    auto batch = std::make_shared<std::vector<BatchItem>>(std::move(pendingBatch->items));
+    batch->resize(pendingBatch->size);
+
+    auto inferStartTime = std::chrono::steady_clock::now();
     request->SetCompletionCallback([this,
-        frameID,
         request,
-        internalModelData,
-        metaData] {
+        batch,
+        inferStartTime] {
+            FRAME_TRACE_SCOPE("Infer callback", -1, -1);
+            traceBatchFlows(*batch);
+            auto completionTime = std::chrono::steady_clock::now();
+            requestsPool->recordInferenceTime(request, completionTime - inferStartTime);
+            if (requestsAutotuner) {
+                requestsPool->setRequestsLimit(requestsAutotuner->recordCompletion(batch->size(),
+                    completionTime - inferStartTime, completionTime));
+            }
+            if (performanceMetrics)
+                performanceMetrics->recordStage(PerformanceMetrics::Stage::Infer, completionTime - inferStartTime);
+            if (traceProfiler) {
+                // Counters are taken before the request is returned to the pool and reused
+                try {
+                    traceProfiler->addInference(request.get(), request->GetPerformanceCounts(),
+                        inferStartTime, completionTime);
+                }
+                catch (...) {
+                    setCallbackException(std::current_exception());
+                }
+            }
+            size_t queuedResults = 0;
             {
                 std::lock_guard<std::mutex> lock(mtx);
 
                 try {
-                    InferenceResult result;
-
-                    result.frameId = frameID;
-                    result.metaData = std::move(metaData);
-                    result.internalModelData = std::move(internalModelData);
-
-                    for (const auto& outName : model->getOutputsNames())
-                        result.outputsData.emplace(outName, std::make_shared<TBlob<float>>(*as<TBlob<float>>(request->GetBlob(outName))));
+                    std::map<std::string, InferenceEngine::MemoryBlob::Ptr> outputsData;
+                    InferRequest::Ptr lease;
+                    if (zeroCopyOutputs || !postprocessWorkers.empty()) {
+                        // Outputs stay in request's blobs, request is kept busy until every frame of the batch is postprocessed.
+                        // With postprocessing workers it also limits the number of frames waiting for them
+                        for (const auto& outName : model->getOutputsNames())
+                            outputsData.emplace(outName, as<MemoryBlob>(request->GetBlob(outName)));
+                        lease = this->requestsPool->leaseRequest(request);
+                    }
+                    else {
+                        for (const auto& outName : model->getOutputsNames())
+                            outputsData.emplace(outName, copyOutput(request->GetBlob(outName)));
+                        this->requestsPool->setRequestIdle(request);
+                    }
 
-                    completedInferenceResults.emplace(frameID, result);
-                    this->requestsPool->setRequestIdle(request);
+                    // Every frame of the batch gets its own result referencing the same output blobs
+                    for (size_t i = 0; i < batch->size(); i++) {
+                        InferenceResult result;
+
+                        result.frameId = (*batch)[i].frameId;
+                        result.metaData = std::move((*batch)[i].metaData);
+                        result.internalModelData = std::move((*batch)[i].internalModelData);
+                        result.batchIndex = i;
+                        result.outputsData = outputsData;
+                        result.requestLease = lease;
+                        result.completionTime = completionTime;
+
+                        if (!postprocessWorkers.empty()) {
+                            {
+                                std::lock_guard<std::mutex> postprocessLock(postprocessMtx);
+                                postprocessTasks.push_back(std::move(result));
+                            }
+                            postprocessCondVar.notify_all();
+                            queuedResults++;
+                        }
+                        else {
+                            const int64_t frameId = result.frameId;
+                            addCompletedResult(completedInferenceResults, frameId, std::move(result));
+                        }
+                    }
                 }
                 catch (...) {
                     if (!this->callbackException) {
@@ -120,48 +680,116 @@ int64_t AsyncPipeline::submitData(const InputData& inputData, const std::shared_
                     }
                 }
             }
-            condVar.notify_one();
+            if (!postprocessWorkers.empty() && queuedResults < batch->size()) {
+                // Results which failed to be queued won't be postprocessed
+                {
+                    std::lock_guard<std::mutex> postprocessLock(postprocessMtx);
+                    activePostprocessTasks -= batch->size() - queuedResults;
+                }
+                postprocessCondVar.notify_all();
+            }
+            condVar.notify_all();
+            if (completionListener)
+                completionListener();
     });
 
-    inputFrameId++;
-    if (inputFrameId < 0)
-        inputFrameId = 0;
+    FRAME_TRACE_SCOPE("Start infer", -1, -1);
+    traceBatchFlows(*batch);
+    if (!postprocessWorkers.empty()) {
+        // Frames are counted from the start of inference, so waitForTotalCompletion doesn't miss the frames
+        // between the completion of their request and queueing for postprocessing
+        std::lock_guard<std::mutex> lock(postprocessMtx);
+        activePostprocessTasks += batch->size();
+    }
+    try {
+        request->StartAsync();
+    }
+    catch (...) {
+        if (!postprocessWorkers.empty()) {
+            std::lock_guard<std::mutex> lock(postprocessMtx);
+            activePostprocessTasks -= batch->size();
+        }
+        throw;
+    }
+}
 
-    request->StartAsync();
-    return frameID;
+void AsyncPipeline::rethrowCallbackException() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (callbackException)
+        std::rethrow_exception(callbackException);
 }
 
 std::unique_ptr<ResultBase> AsyncPipeline::getResult() {
+    if (!postprocessWorkers.empty()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = findNextResult(postprocessedResults);
+        if (it == postprocessedResults.end())
+            return std::unique_ptr<ResultBase>();
+        auto result = std::move(it->second);
+        postprocessedResults.erase(it);
+        onResultTaken(result->frameId);
+        return result;
+    }
+
     auto infResult = AsyncPipeline::getInferenceResult();
     if (infResult.IsEmpty()) {
         return std::unique_ptr<ResultBase>();
     }
+    return postprocessResult(infResult);
+}
+
+std::unique_ptr<ResultBase> AsyncPipeline::postprocessResult(InferenceResult& infResult) {
+    FRAME_TRACE_SCOPE("Postprocess", infResult.frameId, 0);
+    FRAME_TRACE_FLOW(infResult.frameId, 0);
+    auto postprocessStartTime = std::chrono::steady_clock::now();
+    if (performanceMetrics)
+        performanceMetrics->recordStage(PerformanceMetrics::Stage::QueueWait, postprocessStartTime - infResult.completionTime);
 
+    if (outputsRecorder)
+        outputsRecorder->record(infResult, maxBatchSize);
     auto result = model->postprocess(infResult);
     *result = static_cast<ResultBase&>(infResult);
 
+    if (performanceMetrics)
+        performanceMetrics->recordStage(PerformanceMetrics::Stage::Postprocess, postprocessStartTime);
+    if (traceProfiler)
+        traceProfiler->addSpan("Postprocess", postprocessStartTime, std::chrono::steady_clock::now());
+
+    // Outputs are not needed anymore, so leased request (if any) can be returned to the pool
+    infResult.outputsData.clear();
+    infResult.requestLease.reset();
+
     return result;
 }
 
+bool AsyncPipeline::isResultAvailable() const {
+    return postprocessWorkers.empty() ? isNextResultReady(completedInferenceResults)
+        : isNextResultReady(postprocessedResults);
+}
+
 InferenceResult AsyncPipeline::getInferenceResult() {
     InferenceResult retVal;
-    {
-        std::lock_guard<std::mutex> lock(mtx);
+    std::lock_guard<std::mutex> lock(mtx);
 
-        const auto& it = completedInferenceResults.find(outputFrameId);
+    auto it = findNextResult(completedInferenceResults);
+    if (it == completedInferenceResults.end())
+        return retVal;
 
-        if (it != completedInferenceResults.end()) {
-            retVal = std::move(it->second);
-            completedInferenceResults.erase(it);
-        }
-    }
+    retVal = std::move(it->second);
+    completedInferenceResults.erase(it);
+    onResultTaken(retVal.frameId);
 
-    if(!retVal.IsEmpty()) {
-        outputFrameId = retVal.frameId;
+    return retVal;
+}
+
+void AsyncPipeline::onResultTaken(int64_t frameId) {
+    if (frameId < outputFrameId) {
+        lateResultsCount--;
+    }
+    else {
+        outputFrameId = frameId;
         outputFrameId++;
         if (outputFrameId < 0)
             outputFrameId = 0;
     }
-
-    return retVal;
 }
@@ -0,0 +1,78 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/cascade_pipeline.h"
+#include <utility>
+
+LatencyLimitSelector::LatencyLimitSelector(std::chrono::steady_clock::duration latencyLimit,
+                                           std::chrono::steady_clock::duration window) :
+    latencyLimit(latencyLimit), window(window) {}
+
+void LatencyLimitSelector::onResult(std::chrono::steady_clock::duration latency) {
+    windowResults++;
+    windowLatencySum += latency;
+}
+
+bool LatencyLimitSelector::onSubmit(std::chrono::steady_clock::time_point now) {
+    if (!isWindowStarted) {
+        windowStart = now;
+        isWindowStarted = true;
+    }
+    windowSubmissions++;
+
+    const double seconds = std::chrono::duration<double>(now - windowStart).count();
+    if (now - windowStart < window || seconds <= 0)
+        return degraded;
+
+    const double arrivalRate = windowSubmissions / seconds;
+    if (!degraded && windowResults > 0 && windowLatencySum / windowResults > latencyLimit) {
+        fullCapacity = windowResults / seconds;
+        degraded = true;
+        switchesCount++;
+    }
+    else if (degraded && arrivalRate < 0.75 * fullCapacity) {
+        degraded = false;
+        switchesCount++;
+    }
+
+    windowStart = now;
+    windowSubmissions = 0;
+    windowResults = 0;
+    windowLatencySum = std::chrono::steady_clock::duration::zero();
+    return degraded;
+}
+
+CascadePipeline::CascadePipeline(std::unique_ptr<ModelBase>&& fullModel, std::unique_ptr<ModelBase>&& lightModel,
+    const CnnConfig& cnnConfig, InferenceEngine::Core& engine,
+    std::chrono::steady_clock::duration latencyLimit, std::chrono::steady_clock::duration window) :
+    selector(latencyLimit, window) {
+    checkConfig(cnnConfig);
+    std::unique_ptr<AsyncPipeline> fullPipeline(new AsyncPipeline(std::move(fullModel), cnnConfig, engine));
+    std::unique_ptr<AsyncPipeline> lightPipeline(new AsyncPipeline(std::move(lightModel), cnnConfig, engine));
+    setPipelines(std::move(fullPipeline), std::move(lightPipeline));
+}
+
+size_t CascadePipeline::selectPipeline(size_t /*framesInFlight*/, std::chrono::steady_clock::time_point now) {
+    return selector.onSubmit(now) ? Light : Full;
+}
+
+void CascadePipeline::onResult(size_t /*pipelineIndex*/, std::chrono::steady_clock::duration latency) {
+    selector.onResult(latency);
+}
+
+const char* CascadePipeline::pipelineName(size_t pipelineIndex) const {
+    return pipelineIndex == Full ? "full model" : "light model";
+}
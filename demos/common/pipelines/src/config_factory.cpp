@@ -16,7 +16,12 @@
 
 #include "pipelines/config_factory.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
 #include <set>
+#include <thread>
 
 #include <samples/args_helper.hpp>
 #include <samples/common.hpp>
@@ -34,13 +39,15 @@ CnnConfig ConfigFactory::getUserConfig(const std::string& flags_d, const std::st
         devices.insert(device);
     }
     std::map<std::string, unsigned> deviceNstreams = parseValuePerDevice(devices, flags_nstreams);
+    // Devices share the host either inside MULTI plugin or with separate networks balanced by the pipeline
+    bool isMultiDevice = flags_d.find("MULTI") != std::string::npos || !config.balancedDevices.empty();
     for (auto& device : devices) {
         if (device == "CPU") {  // CPU supports a few special performance-oriented keys
             // limit threading for CPU portion of inference
             if (flags_nthreads != 0)
                 config.execNetworkConfig.emplace(CONFIG_KEY(CPU_THREADS_NUM), std::to_string(flags_nthreads));
 
-            if (flags_d.find("MULTI") != std::string::npos
+            if (isMultiDevice
                 && devices.find("GPU") != devices.end()) {
                 config.execNetworkConfig.emplace(CONFIG_KEY(CPU_BIND_THREAD), CONFIG_VALUE(NO));
             }
@@ -59,7 +66,7 @@ CnnConfig ConfigFactory::getUserConfig(const std::string& flags_d, const std::st
                 (deviceNstreams.count(device) > 0 ? std::to_string(deviceNstreams.at(device))
                     : CONFIG_VALUE(GPU_THROUGHPUT_AUTO)));
 
-            if (flags_d.find("MULTI") != std::string::npos
+            if (isMultiDevice
                 && devices.find("CPU") != devices.end()) {
                 // multi-device execution with the CPU + GPU performs best with GPU throttling hint,
                 // which releases another CPU thread (that is otherwise used by the GPU driver for active polling)
@@ -89,6 +96,45 @@ CnnConfig ConfigFactory::getMinLatencyConfig(const std::string& flags_d, const s
     return config;
 }
 
+std::vector<std::map<std::string, std::string>> ConfigFactory::planCpuNetworks(const std::vector<float>& loads,
+    unsigned reservedThreads, unsigned totalThreads)
+{
+    if (totalThreads == 0)
+        totalThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    const unsigned networksCount = static_cast<unsigned>(loads.size());
+    // Oversubscription can't be avoided if there are more networks than free threads
+    const unsigned availableThreads = totalThreads > reservedThreads + networksCount
+        ? totalThreads - reservedThreads : networksCount;
+
+    std::vector<unsigned> threads(networksCount, 1);
+    const float loadsSum = std::accumulate(loads.begin(), loads.end(), 0.0f);
+    if (networksCount > 0 && loadsSum > 0) {
+        // Largest remainder method: whole parts of the shares first, the rest of threads go to the largest remainders
+        const unsigned spareThreads = availableThreads - networksCount;
+        std::vector<std::pair<float, size_t>> remainders;
+        unsigned distributed = 0;
+        for (size_t i = 0; i < networksCount; i++) {
+            float share = spareThreads * std::max(loads[i], 0.0f) / loadsSum;
+            unsigned wholeShare = static_cast<unsigned>(share);
+            threads[i] += wholeShare;
+            distributed += wholeShare;
+            remainders.emplace_back(share - wholeShare, i);
+        }
+        std::sort(remainders.begin(), remainders.end(), std::greater<std::pair<float, size_t>>());
+        for (size_t i = 0; distributed < spareThreads && i < remainders.size(); i++, distributed++)
+            threads[remainders[i].second]++;
+    }
+
+    std::vector<std::map<std::string, std::string>> configs(networksCount);
+    for (size_t i = 0; i < networksCount; i++) {
+        configs[i].emplace(CONFIG_KEY(CPU_THREADS_NUM), std::to_string(threads[i]));
+        // About 4 threads per stream, as CPU_THROUGHPUT_AUTO chooses for the whole CPU
+        configs[i].emplace(CONFIG_KEY(CPU_THROUGHPUT_STREAMS), std::to_string((threads[i] + 3) / 4));
+        configs[i].emplace(CONFIG_KEY(CPU_BIND_THREAD), CONFIG_VALUE(NO));
+    }
+    return configs;
+}
+
 CnnConfig ConfigFactory::getCommonConfig(const std::string& flags_d, const std::string& flags_l,
     const std::string& flags_c, bool flags_pc, uint32_t flags_nireq)
 {
@@ -96,8 +142,16 @@ CnnConfig ConfigFactory::getCommonConfig(const std::string& flags_d, const std::
 
     if (!flags_d.empty()) {
         config.devices = flags_d;
+        if (flags_d.find("BALANCE:") == 0) {
+            config.balancedDevices = parseDevices(flags_d);
+        }
     }
 
+    const std::vector<std::string> devices = parseDevices(flags_d);
+    config.fp16Outputs = !devices.empty() && std::all_of(devices.begin(), devices.end(), [](const std::string& device) {
+        return device.find("GPU") == 0 || device.find("MYRIAD") == 0 || device.find("HDDL") == 0;
+    });
+
     if (!flags_l.empty()) {
         config.cpuExtensionsPath = flags_l;
     }
@@ -106,11 +160,16 @@ CnnConfig ConfigFactory::getCommonConfig(const std::string& flags_d, const std::
         config.clKernelsConfigPath = flags_c;
     }
 
-    if (flags_nireq == 0) {
-        throw std::runtime_error("The value of -nireq must be greater than 0");
-    }
+    // 0 requests means the optimal number reported by the device
     config.maxAsyncRequests = flags_nireq;
 
+    const char* cacheDir = std::getenv("OMZ_NETWORK_CACHE_DIR");
+    if (cacheDir) {
+        config.cacheDir = cacheDir;
+    }
+    const char* devicePostprocessing = std::getenv("OMZ_DEVICE_POSTPROCESSING");
+    config.devicePostprocessing = devicePostprocessing && std::string(devicePostprocessing) != "0";
+
     /** Per layer metrics **/
     if (flags_pc) {
         config.execNetworkConfig.emplace(CONFIG_KEY(PERF_COUNT), PluginConfigParams::YES);
@@ -0,0 +1,182 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/device_scheduler.h"
+#include <algorithm>
+#include <samples/slog.hpp>
+
+using namespace InferenceEngine;
+
+namespace {
+// Weight of the new measurement in the moving average of inference time
+const double INFERENCE_TIME_SMOOTHING = 0.1;
+}
+
+DeviceScheduler::DeviceScheduler(Core& engine, CNNNetwork& cnnNetwork, const std::vector<std::string>& devicesNames,
+    const std::map<std::string, std::string>& config, unsigned int requestsPerDevice,
+    NetworkCache* networkCache, const std::string& modelFileName, NetworkRegistry* networkRegistry) {
+    if (devicesNames.empty()) {
+        throw std::invalid_argument("List of devices is empty");
+    }
+
+    for (const auto& deviceName : devicesNames) {
+        std::map<std::string, std::string> deviceConfig = config;
+        if (devicesNames.size() > 1) {
+            // Config is common for all devices, so keys which aren't supported by the device are skipped
+            std::vector<std::string> supportedKeys = engine.GetMetric(deviceName, METRIC_KEY(SUPPORTED_CONFIG_KEYS));
+            for (auto it = deviceConfig.begin(); it != deviceConfig.end();) {
+                if (std::find(supportedKeys.begin(), supportedKeys.end(), it->first) == supportedKeys.end())
+                    it = deviceConfig.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        slog::info << "Loading model to the " << deviceName << " device" << slog::endl;
+        std::unique_ptr<Device> device(new Device);
+        device->name = deviceName;
+        auto load = [&]() {
+            return networkCache
+                ? networkCache->loadNetwork(engine, cnnNetwork, modelFileName, deviceName, deviceConfig)
+                : engine.LoadNetwork(cnnNetwork, deviceName, deviceConfig);
+        };
+        // Requests are created for every scheduler, so a shared network gets its own pool here
+        device->execNetwork = networkRegistry
+            ? networkRegistry->getNetwork(engine, cnnNetwork, modelFileName, deviceName, deviceConfig, load)
+            : load();
+        unsigned int requestsCount = requestsPerDevice;
+        if (requestsCount == 0) {
+            try {
+                requestsCount = device->execNetwork.GetMetric(METRIC_KEY(OPTIMAL_NUMBER_OF_INFER_REQUESTS)).as<unsigned int>();
+            }
+            catch (const details::InferenceEngineException& ex) {
+                THROW_IE_EXCEPTION << "Can't query optimal number of infer requests of the " << deviceName
+                    << " device, specify it explicitly. Error: " << ex.what();
+            }
+            slog::info << "Optimal number of infer requests for the " << deviceName << " device is "
+                << requestsCount << slog::endl;
+        }
+        device->requestsPool.reset(new RequestsPool(device->execNetwork, requestsCount, deviceName));
+        device->requestsCount = requestsCount;
+        for (const auto& request : device->requestsPool->getInferRequestsList()) {
+            requestsDevices.emplace(request.get(), devices.size());
+        }
+        devices.push_back(std::move(device));
+    }
+}
+
+DeviceScheduler::Device& DeviceScheduler::getDevice(const InferRequest::Ptr& request) const {
+    return *devices[requestsDevices.at(request.get())];
+}
+
+const std::string& DeviceScheduler::getDeviceName(const InferRequest::Ptr& request) const {
+    return getDevice(request).name;
+}
+
+bool DeviceScheduler::isRequestsLimitReached() const {
+    const size_t limit = requestsLimit.load(std::memory_order_relaxed);
+    if (limit == 0)
+        return false;
+    size_t inUseCount = 0;
+    for (const auto& device : devices) {
+        inUseCount += device->requestsPool->getInUseRequestsCount();
+    }
+    return inUseCount >= limit;
+}
+
+size_t DeviceScheduler::getRequestsCount() const {
+    size_t count = 0;
+    for (const auto& device : devices) {
+        count += device->requestsCount;
+    }
+    return count;
+}
+
+InferRequest::Ptr DeviceScheduler::getIdleRequest() {
+    if (isRequestsLimitReached()) {
+        return InferRequest::Ptr();
+    }
+    if (devices.size() == 1) {
+        return devices.front()->requestsPool->getIdleRequest();
+    }
+
+    // Expected latency of new request grows with the device's inference time and with the share of its
+    // requests already in flight. Devices without measurements yet are tried first.
+    std::vector<std::pair<double, size_t>> candidates;
+    candidates.reserve(devices.size());
+    for (size_t i = 0; i < devices.size(); i++) {
+        Device& device = *devices[i];
+        if (!device.requestsPool->isIdleRequestAvailable())
+            continue;
+        double avgTime = static_cast<double>(device.avgInferenceTimeNs.load(std::memory_order_relaxed));
+        double queueLength = static_cast<double>(device.requestsPool->getInUseRequestsCount() + 1);
+        candidates.emplace_back(avgTime * queueLength / device.requestsCount, i);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // Request may be taken by other thread between the check and getIdleRequest, so next device is tried then
+    for (const auto& candidate : candidates) {
+        InferRequest::Ptr request = devices[candidate.second]->requestsPool->getIdleRequest();
+        if (request)
+            return request;
+    }
+    return InferRequest::Ptr();
+}
+
+void DeviceScheduler::setRequestIdle(const InferRequest::Ptr& request) {
+    getDevice(request).requestsPool->setRequestIdle(request);
+}
+
+InferRequest::Ptr DeviceScheduler::leaseRequest(const InferRequest::Ptr& request) {
+    return getDevice(request).requestsPool->leaseRequest(request);
+}
+
+void DeviceScheduler::recordInferenceTime(const InferRequest::Ptr& request, std::chrono::steady_clock::duration duration) {
+    Device& device = getDevice(request);
+    int64_t measuredNs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    int64_t currentNs = device.avgInferenceTimeNs.load(std::memory_order_relaxed);
+    int64_t updatedNs;
+    do {
+        updatedNs = currentNs == 0 ? measuredNs
+            : static_cast<int64_t>(currentNs + INFERENCE_TIME_SMOOTHING * (measuredNs - currentNs));
+        updatedNs = std::max<int64_t>(updatedNs, 1);
+    } while (!device.avgInferenceTimeNs.compare_exchange_weak(currentNs, updatedNs, std::memory_order_relaxed));
+}
+
+bool DeviceScheduler::isIdleRequestAvailable() {
+    if (isRequestsLimitReached())
+        return false;
+    for (const auto& device : devices) {
+        if (device->requestsPool->isIdleRequestAvailable())
+            return true;
+    }
+    return false;
+}
+
+void DeviceScheduler::waitForTotalCompletion() {
+    for (const auto& device : devices) {
+        device->requestsPool->waitForTotalCompletion();
+    }
+}
+
+std::vector<InferRequest::Ptr> DeviceScheduler::getInferRequestsList() {
+    std::vector<InferRequest::Ptr> requests;
+    for (const auto& device : devices) {
+        auto deviceRequests = device->requestsPool->getInferRequestsList();
+        requests.insert(requests.end(), deviceRequests.begin(), deviceRequests.end());
+    }
+    return requests;
+}
@@ -0,0 +1,133 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/network_cache.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <samples/slog.hpp>
+
+using namespace InferenceEngine;
+
+namespace {
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t hashBytes(const char* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hashFile(const std::string& fileName, uint64_t hash) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Can't open file " + fileName + " for hashing");
+    }
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hash = hashBytes(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+    return hash;
+}
+}
+
+uint64_t NetworkCache::getModelHash(const std::string& modelFileName) {
+    auto it = modelsHashes.find(modelFileName);
+    if (it != modelsHashes.end()) {
+        return it->second;
+    }
+
+    uint64_t hash = hashFile(modelFileName, FNV_OFFSET_BASIS);
+    std::string binFileName = modelFileName.substr(0, modelFileName.rfind('.')) + ".bin";
+    if (std::ifstream(binFileName)) {
+        hash = hashFile(binFileName, hash);
+    }
+    modelsHashes.emplace(modelFileName, hash);
+    return hash;
+}
+
+std::string NetworkCache::getNetworkKey(Core& engine, CNNNetwork& cnnNetwork, const std::string& device,
+    const std::map<std::string, std::string>& config) {
+    std::ostringstream key;
+    for (const auto& version : engine.GetVersions(device)) {
+        key << version.first << ' ' << version.second.buildNumber << ';';
+    }
+    key << device << ';';
+    for (const auto& item : config) {
+        key << item.first << '=' << item.second << ';';
+    }
+    for (const auto& input : cnnNetwork.getInputsInfo()) {
+        key << input.first << ':' << input.second->getPrecision() << ':' << input.second->getLayout();
+        for (size_t dim : input.second->getTensorDesc().getDims()) {
+            key << ',' << dim;
+        }
+        key << ':' << input.second->getPreProcess().getResizeAlgorithm() << ';';
+    }
+    for (const auto& output : cnnNetwork.getOutputsInfo()) {
+        key << output.first << ':' << output.second->getPrecision() << ':' << output.second->getLayout() << ';';
+    }
+    return key.str();
+}
+
+std::string NetworkCache::getCacheFileName(Core& engine, CNNNetwork& cnnNetwork, const std::string& modelFileName,
+    const std::string& device, const std::map<std::string, std::string>& config, const std::string& extension) {
+    // Everything affecting compiled network is put to the key, the model files are hashed separately
+    const std::string keyString = getNetworkKey(engine, cnnNetwork, device, config);
+    uint64_t hash = hashBytes(keyString.data(), keyString.size(), getModelHash(modelFileName));
+
+    std::ostringstream fileName;
+    fileName << cacheDir << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << extension;
+    return fileName.str();
+}
+
+ExecutableNetwork NetworkCache::loadNetwork(Core& engine, CNNNetwork& cnnNetwork, const std::string& modelFileName,
+    const std::string& device, const std::map<std::string, std::string>& config) {
+    const std::string blobFileName = getCacheFileName(engine, cnnNetwork, modelFileName, device, config, ".blob");
+
+    if (std::ifstream(blobFileName)) {
+        try {
+            ExecutableNetwork execNetwork = engine.ImportNetwork(blobFileName, device, config);
+            slog::info << "Compiled network is imported from " << blobFileName << slog::endl;
+            return execNetwork;
+        }
+        catch (const std::exception& error) {
+            // Broken or outdated blob is just replaced
+            slog::warn << "Can't import compiled network from " << blobFileName << ": " << error.what() << slog::endl;
+        }
+    }
+
+    ExecutableNetwork execNetwork = engine.LoadNetwork(cnnNetwork, device, config);
+    try {
+        // Network is written to temporary file first, so other processes never import partially written blob
+        const std::string tmpFileName = blobFileName + ".tmp";
+        execNetwork.Export(tmpFileName);
+        std::remove(blobFileName.c_str());
+        if (std::rename(tmpFileName.c_str(), blobFileName.c_str()) != 0) {
+            std::remove(tmpFileName.c_str());
+            throw std::runtime_error("can't rename " + tmpFileName);
+        }
+        slog::info << "Compiled network is exported to " << blobFileName << slog::endl;
+    }
+    catch (const std::exception& error) {
+        slog::info << "Compiled network isn't cached for " << device << " device: " << error.what() << slog::endl;
+    }
+    return execNetwork;
+}
@@ -0,0 +1,59 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/network_registry.h"
+#include "pipelines/network_cache.h"
+#include <samples/slog.hpp>
+
+using namespace InferenceEngine;
+
+ExecutableNetwork NetworkRegistry::getNetwork(Core& engine, CNNNetwork& cnnNetwork, const std::string& modelFileName,
+    const std::string& device, const std::map<std::string, std::string>& config, const LoadFunc& load) {
+    const std::string key = modelFileName + ';' + NetworkCache::getNetworkKey(engine, cnnNetwork, device, config);
+
+    std::promise<ExecutableNetwork> promise;
+    std::shared_future<ExecutableNetwork> future;
+    bool isLoading = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = networks.find(key);
+        if (it == networks.end()) {
+            future = promise.get_future().share();
+            networks.emplace(key, future);
+            isLoading = true;
+        } else {
+            future = it->second;
+        }
+    }
+
+    if (!isLoading) {
+        slog::info << "Loaded network is shared for the " << device << " device" << slog::endl;
+        return future.get();
+    }
+
+    try {
+        promise.set_value(load());
+    }
+    catch (...) {
+        // Failed network isn't kept, so the next caller tries to load it again
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            networks.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+    }
+    return future.get();
+}
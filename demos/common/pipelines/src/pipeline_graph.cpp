@@ -0,0 +1,290 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/pipeline_graph.h"
+#include <algorithm>
+#include <utility>
+#include <samples/slog.hpp>
+
+PipelineGraph::PipelineGraph(std::unique_ptr<ModelBase>&& rootModel, const CnnConfig& cnnConfig,
+    InferenceEngine::Core& engine, size_t maxFramesInFlight) :
+    maxFramesInFlight(maxFramesInFlight) {
+    Node root;
+    root.pipeline.reset(new AsyncPipeline(std::move(rootModel), cnnConfig, engine));
+    root.pipeline->setCompletionListener([this] { onCompletion(); });
+    nodes.push_back(std::move(root));
+}
+
+PipelineGraph::~PipelineGraph() {
+    for (auto& node : nodes) {
+        node.pipeline->waitForTotalCompletion();
+    }
+}
+
+void PipelineGraph::addNode(const std::string& name, std::unique_ptr<ModelBase>&& model, const CnnConfig& cnnConfig,
+    InferenceEngine::Core& engine, const std::string& parentName, const RoiExtractor& roiExtractor) {
+    createNode(name, std::move(model), cnnConfig, engine, parentName).roiExtractor = roiExtractor;
+}
+
+void PipelineGraph::addRotatedRoiNode(const std::string& name, std::unique_ptr<ModelBase>&& model,
+    const CnnConfig& cnnConfig, InferenceEngine::Core& engine, const std::string& parentName,
+    const RotatedRoiExtractor& roiExtractor) {
+    createNode(name, std::move(model), cnnConfig, engine, parentName).rotatedRoiExtractor = roiExtractor;
+}
+
+PipelineGraph::Node& PipelineGraph::createNode(const std::string& name, std::unique_ptr<ModelBase>&& model,
+    const CnnConfig& cnnConfig, InferenceEngine::Core& engine, const std::string& parentName) {
+    if (name.empty()) {
+        throw std::invalid_argument("Name of the graph node can't be empty");
+    }
+
+    size_t parentIdx = nodes.size();
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].name == name) {
+            throw std::invalid_argument("Graph node " + name + " already exists");
+        }
+        if (nodes[i].name == parentName) {
+            parentIdx = i;
+        }
+    }
+    if (parentIdx == nodes.size()) {
+        throw std::invalid_argument("Can't find parent node " + parentName + " for graph node " + name);
+    }
+
+    slog::info << "Adding graph node " << name << slog::endl;
+    Node node;
+    node.name = name;
+    node.pipeline.reset(new AsyncPipeline(std::move(model), cnnConfig, engine));
+    node.pipeline->setCompletionListener([this] { onCompletion(); });
+    nodes.push_back(std::move(node));
+    nodes[parentIdx].children.push_back(nodes.size() - 1);
+    return nodes.back();
+}
+
+PipelineGraph::RoiExtractor PipelineGraph::detectionsExtractor(float confidenceThreshold) {
+    return [confidenceThreshold](const ResultBase& parentResult) {
+        std::vector<cv::Rect> rois;
+        const auto& detections = parentResult.asRef<DetectionResult>();
+        cv::Point offset;
+        // Boxes of non-root nodes are relative to their own ROI
+        if (auto roiMetaData = std::dynamic_pointer_cast<RoiMetaData>(parentResult.metaData)) {
+            offset = roiMetaData->roi.tl();
+        }
+        for (const auto& obj : detections.objects) {
+            if (obj.confidence >= confidenceThreshold) {
+                rois.push_back(cv::Rect(obj) + offset);
+            }
+        }
+        return rois;
+    };
+}
+
+bool PipelineGraph::isReadyToProcess() {
+    return framesInFlight < maxFramesInFlight && nodes[0].pipeline->isReadyToProcess();
+}
+
+int64_t PipelineGraph::submitData(const ImageInputData& inputData, const std::shared_ptr<ImageMetaData>& metaData) {
+    if (framesInFlight >= maxFramesInFlight) {
+        return -1;
+    }
+    auto frameID = nodes[0].pipeline->submitData(inputData, metaData);
+    if (frameID >= 0) {
+        framesInFlight++;
+    }
+    return frameID;
+}
+
+void PipelineGraph::onCompletion() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        completionsCounter++;
+    }
+    condVar.notify_one();
+}
+
+void PipelineGraph::fanOut(size_t nodeIdx, int parentIndex, const ResultBase& parentResult, int64_t rootFrameId,
+    FrameEntry& entry) {
+    const cv::Rect frameRect(0, 0, entry.frame.cols, entry.frame.rows);
+    auto addPendingRoi = [&](Node& child, int roiIndex, const cv::Rect& roi, std::shared_ptr<InputData>&& inputData) {
+        PendingRoi pendingRoi;
+        pendingRoi.inputData = std::move(inputData);
+        pendingRoi.metaData = std::make_shared<RoiMetaData>();
+        pendingRoi.metaData->rootFrameId = rootFrameId;
+        pendingRoi.metaData->parentIndex = parentIndex;
+        pendingRoi.metaData->roi = roi;
+        pendingRoi.metaData->roiIndex = roiIndex;
+        child.pendingRois.push_back(std::move(pendingRoi));
+        entry.pendingRoisCount++;
+    };
+
+    for (size_t childIdx : nodes[nodeIdx].children) {
+        Node& child = nodes[childIdx];
+        if (child.rotatedRoiExtractor) {
+            const std::vector<cv::RotatedRect> rotatedRects = child.rotatedRoiExtractor(parentResult);
+            for (size_t i = 0; i < rotatedRects.size(); i++) {
+                cv::Rect roi = rotatedRects[i].boundingRect() & frameRect;
+                if (roi.area() == 0) {
+                    continue;
+                }
+                addPendingRoi(child, static_cast<int>(i), roi,
+                    std::make_shared<RotatedRoiInputData>(entry.frame, rotatedRects[i]));
+            }
+            continue;
+        }
+        const std::vector<cv::Rect> rects = child.roiExtractor(parentResult);
+        for (size_t i = 0; i < rects.size(); i++) {
+            cv::Rect roi = rects[i] & frameRect;
+            if (roi.area() == 0) {
+                continue;
+            }
+            addPendingRoi(child, static_cast<int>(i), roi, std::make_shared<ImageInputData>(entry.frame(roi)));
+        }
+    }
+}
+
+void PipelineGraph::pump() {
+    for (auto& node : nodes) {
+        node.pipeline->rethrowCallbackException();
+    }
+
+    // Root node: every new result starts a frame entry and produces ROIs for root's children
+    Node& root = nodes[0];
+    while (std::unique_ptr<ResultBase> result = root.pipeline->getResult()) {
+        auto frameID = result->frameId;
+        FrameEntry& entry = frames[frameID];
+        entry.frame = result->metaData->asRef<ImageMetaData>().img;
+        entry.result.reset(new GraphResult);
+        entry.result->frameId = frameID;
+        entry.result->metaData = result->metaData;
+        entry.result->rootResult = std::move(result);
+        fanOut(0, -1, *entry.result->rootResult, frameID, entry);
+    }
+
+    // Other nodes: results are attached to their frame entries and may produce ROIs for deeper nodes.
+    // Nodes are stored in topological order (parent is always added before child), so one pass is enough
+    // to propagate results as deep as they are ready.
+    for (size_t nodeIdx = 1; nodeIdx < nodes.size(); nodeIdx++) {
+        Node& node = nodes[nodeIdx];
+        while (std::unique_ptr<ResultBase> result = node.pipeline->getResult()) {
+            const auto& roiMetaData = result->metaData->asRef<RoiMetaData>();
+            auto it = frames.find(roiMetaData.rootFrameId);
+            if (it == frames.end()) {
+                throw std::logic_error("Graph node " + node.name + " returned result for unknown frame");
+            }
+            FrameEntry& entry = it->second;
+            auto& nodeResults = entry.result->nodesResults[node.name];
+            nodeResults.push_back(std::move(result));
+            fanOut(nodeIdx, static_cast<int>(nodeResults.size() - 1), *nodeResults.back(), roiMetaData.rootFrameId, entry);
+            entry.pendingRoisCount--;
+        }
+
+        // Pending ROIs are packed into batches of the node's requests. An incomplete batch is sent at once
+        // instead of waiting for ROIs of the next frames.
+        while (!node.pendingRois.empty() && node.pipeline->isReadyToProcess()) {
+            const size_t batchSize = std::min<size_t>(node.pipeline->getMaxBatchSize(), node.pendingRois.size());
+            std::vector<std::reference_wrapper<const InputData>> batchData;
+            std::vector<std::shared_ptr<MetaData>> batchMetaData;
+            for (size_t i = 0; i < batchSize; i++) {
+                batchData.push_back(*node.pendingRois[i].inputData);
+                batchMetaData.push_back(node.pendingRois[i].metaData);
+            }
+            if (node.pipeline->submitBatch(batchData, batchMetaData) < 0) {
+                break;
+            }
+            node.pendingRois.erase(node.pendingRois.begin(), node.pendingRois.begin() + batchSize);
+        }
+    }
+}
+
+bool PipelineGraph::isResultReady() const {
+    return !frames.empty() && frames.begin()->second.pendingRoisCount == 0;
+}
+
+void PipelineGraph::waitForData() {
+    for (;;) {
+        uint64_t seenCompletions;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            seenCompletions = completionsCounter;
+        }
+
+        pump();
+        if (isResultReady() || isReadyToProcess()) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        condVar.wait(lock, [&] { return completionsCounter != seenCompletions; });
+    }
+}
+
+std::unique_ptr<GraphResult> PipelineGraph::getResult() {
+    pump();
+    if (!isResultReady()) {
+        return std::unique_ptr<GraphResult>();
+    }
+
+    auto result = std::move(frames.begin()->second.result);
+    frames.erase(frames.begin());
+    framesInFlight--;
+    return result;
+}
+
+void PipelineGraph::releaseResult(std::unique_ptr<GraphResult>&& result) {
+    if (!result) {
+        return;
+    }
+    nodes[0].pipeline->releaseResult(std::move(result->rootResult));
+    for (size_t nodeIdx = 1; nodeIdx < nodes.size(); nodeIdx++) {
+        auto it = result->nodesResults.find(nodes[nodeIdx].name);
+        if (it != result->nodesResults.end()) {
+            for (auto& nodeResult : it->second) {
+                nodes[nodeIdx].pipeline->releaseResult(std::move(nodeResult));
+            }
+        }
+    }
+    result.reset();
+}
+
+void PipelineGraph::setOutputsRecorder(const std::string& name, OutputsRecorder* recorder) {
+    for (auto& node : nodes) {
+        if (node.name == name) {
+            node.pipeline->setOutputsRecorder(recorder);
+            return;
+        }
+    }
+    throw std::invalid_argument("Can't find graph node " + name);
+}
+
+void PipelineGraph::waitForTotalCompletion() {
+    for (;;) {
+        for (auto& node : nodes) {
+            node.pipeline->waitForTotalCompletion();
+        }
+        pump();
+
+        bool hasPendingWork = false;
+        for (const auto& node : nodes) {
+            hasPendingWork = hasPendingWork || !node.pendingRois.empty();
+        }
+        for (const auto& frame : frames) {
+            hasPendingWork = hasPendingWork || frame.second.pendingRoisCount != 0;
+        }
+        if (!hasPendingWork) {
+            break;
+        }
+    }
+}
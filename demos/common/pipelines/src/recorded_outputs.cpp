@@ -0,0 +1,278 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/recorded_outputs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "models/internal_model_data.h"
+
+using namespace InferenceEngine;
+
+namespace {
+const char FILE_MAGIC[8] = {'O', 'M', 'Z', 'O', 'U', 'T', 'S', '\0'};
+const uint32_t FILE_VERSION = 1;
+const size_t ALIGNMENT = 64;
+const size_t MAX_DIMS = 8;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint8_t padding[48];
+};
+
+/// Record is RecordHeader, OutputHeader of every output, names of the outputs and data of the outputs
+/// at aligned offsets from the start of the record. Size of the record is aligned too.
+struct RecordHeader {
+    uint64_t size;
+    int64_t frameId;
+    uint64_t batchIndex;
+    uint64_t batchSize;
+    /// -1 if there's no InternalImageModelData
+    int32_t inputImgWidth;
+    int32_t inputImgHeight;
+    uint32_t outputsCount;
+    uint32_t reserved;
+};
+
+struct OutputHeader {
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    uint64_t nameOffset;
+    uint32_t nameSize;
+    uint32_t precision;
+    uint32_t layout;
+    uint32_t dimsCount;
+    uint64_t dims[MAX_DIMS];
+};
+
+static_assert(sizeof(FileHeader) == ALIGNMENT, "File header should keep records aligned");
+
+size_t align(size_t size) {
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+MemoryBlob::Ptr wrapData(const TensorDesc& desc, char* data) {
+    switch (desc.getPrecision()) {
+    case Precision::FP32:
+        return make_shared_blob<float>(desc, reinterpret_cast<float*>(data));
+    case Precision::FP16:
+    case Precision::I16:
+        return make_shared_blob<int16_t>(desc, reinterpret_cast<int16_t*>(data));
+    case Precision::U16:
+        return make_shared_blob<uint16_t>(desc, reinterpret_cast<uint16_t*>(data));
+    case Precision::I32:
+        return make_shared_blob<int32_t>(desc, reinterpret_cast<int32_t*>(data));
+    case Precision::I64:
+        return make_shared_blob<int64_t>(desc, reinterpret_cast<int64_t*>(data));
+    case Precision::I8:
+        return make_shared_blob<int8_t>(desc, reinterpret_cast<int8_t*>(data));
+    case Precision::U8:
+    case Precision::BOOL:
+        return make_shared_blob<uint8_t>(desc, reinterpret_cast<uint8_t*>(data));
+    default:
+        throw std::runtime_error(std::string("Recorded output has unsupported precision ") + desc.getPrecision().name());
+    }
+}
+}  // namespace
+
+OutputsRecorder::OutputsRecorder(const std::string& fileName) :
+    file(fileName, std::ios::binary) {
+    if (!file) {
+        throw std::runtime_error("Can't open " + fileName + " for writing");
+    }
+    FileHeader header = {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void OutputsRecorder::record(const InferenceResult& infResult, size_t batchSize) {
+    std::lock_guard<std::mutex> lock(mtx);
+    const size_t outputsCount = infResult.outputsData.size();
+    size_t namesOffset = sizeof(RecordHeader) + outputsCount * sizeof(OutputHeader);
+    size_t namesSize = 0;
+    for (const auto& output : infResult.outputsData) {
+        namesSize += output.first.size();
+    }
+    size_t dataOffset = align(namesOffset + namesSize);
+    size_t recordSize = dataOffset;
+    for (const auto& output : infResult.outputsData) {
+        recordSize = align(recordSize + output.second->byteSize());
+    }
+    buffer.assign(recordSize, 0);
+
+    RecordHeader& header = *reinterpret_cast<RecordHeader*>(buffer.data());
+    header.size = recordSize;
+    header.frameId = infResult.frameId;
+    header.batchIndex = infResult.batchIndex;
+    header.batchSize = batchSize;
+    auto imageData = dynamic_cast<const InternalImageModelData*>(infResult.internalModelData.get());
+    header.inputImgWidth = imageData ? imageData->inputImgWidth : -1;
+    header.inputImgHeight = imageData ? imageData->inputImgHeight : -1;
+    header.outputsCount = static_cast<uint32_t>(outputsCount);
+
+    size_t i = 0;
+    for (const auto& output : infResult.outputsData) {
+        const TensorDesc& desc = output.second->getTensorDesc();
+        if (desc.getDims().size() > MAX_DIMS) {
+            throw std::logic_error("Output " + output.first + " has too many dimensions to be recorded");
+        }
+        OutputHeader& outputHeader = reinterpret_cast<OutputHeader*>(buffer.data() + sizeof(RecordHeader))[i++];
+        outputHeader.dataOffset = dataOffset;
+        outputHeader.dataSize = output.second->byteSize();
+        outputHeader.nameOffset = namesOffset;
+        outputHeader.nameSize = static_cast<uint32_t>(output.first.size());
+        outputHeader.precision = static_cast<uint32_t>(desc.getPrecision());
+        outputHeader.layout = static_cast<uint32_t>(desc.getLayout());
+        outputHeader.dimsCount = static_cast<uint32_t>(desc.getDims().size());
+        std::copy(desc.getDims().begin(), desc.getDims().end(), outputHeader.dims);
+
+        std::memcpy(buffer.data() + namesOffset, output.first.data(), output.first.size());
+        namesOffset += output.first.size();
+        LockedMemory<const void> outputMapped = output.second->rmap();
+        std::memcpy(buffer.data() + dataOffset, outputMapped.as<const char*>(), outputHeader.dataSize);
+        dataOffset = align(dataOffset + outputHeader.dataSize);
+    }
+
+    file.write(buffer.data(), buffer.size());
+    if (!file) {
+        throw std::runtime_error("Can't write recorded outputs");
+    }
+}
+
+RecordedOutputs::RecordedOutputs(const std::string& fileName) {
+#ifndef _WIN32
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            // Private writable mapping, so the blobs can be mapped for writing without changing the file
+            void* mapped = mmap(nullptr, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<char*>(mapped);
+                dataSize = static_cast<size_t>(fileStat.st_size);
+                isMapped = true;
+            }
+        }
+        close(fd);
+    }
+#endif
+    if (!isMapped) {
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Can't open " + fileName);
+        }
+        dataSize = static_cast<size_t>(file.tellg());
+        // uint64_t elements keep the blobs aligned enough for any precision
+        fileContent.resize(dataSize / sizeof(uint64_t) + 1);
+        data = reinterpret_cast<char*>(fileContent.data());
+        file.seekg(0);
+        if (!file.read(data, dataSize)) {
+            throw std::runtime_error("Can't read " + fileName);
+        }
+    }
+
+    try {
+        const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+        if (dataSize < sizeof(FileHeader) || std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error(fileName + " isn't a file of recorded outputs");
+        }
+        if (header->version != FILE_VERSION) {
+            throw std::runtime_error(fileName + " has unsupported version of recorded outputs");
+        }
+
+        // The records are checked once, so getResult doesn't need to
+        const std::string brokenFile = fileName + " is truncated or broken";
+        for (size_t offset = sizeof(FileHeader); offset < dataSize;) {
+            const RecordHeader& record = *reinterpret_cast<const RecordHeader*>(data + offset);
+            if (dataSize - offset < sizeof(RecordHeader) || record.size > dataSize - offset
+                    || record.size % ALIGNMENT != 0
+                    || record.outputsCount > (record.size - sizeof(RecordHeader)) / sizeof(OutputHeader)) {
+                throw std::runtime_error(brokenFile);
+            }
+            const OutputHeader* outputs = reinterpret_cast<const OutputHeader*>(data + offset + sizeof(RecordHeader));
+            for (size_t i = 0; i < record.outputsCount; i++) {
+                const OutputHeader& output = outputs[i];
+                if (output.dataOffset % ALIGNMENT != 0 || output.dataOffset > record.size
+                        || output.dataSize > record.size - output.dataOffset
+                        || output.nameOffset > record.size || output.nameSize > record.size - output.nameOffset
+                        || output.dimsCount > MAX_DIMS) {
+                    throw std::runtime_error(brokenFile);
+                }
+            }
+            if (records.empty()) {
+                batchSize = static_cast<size_t>(record.batchSize);
+            }
+            records.push_back(offset);
+            offset += static_cast<size_t>(record.size);
+        }
+    } catch (...) {
+#ifndef _WIN32
+        if (isMapped) {
+            munmap(data, dataSize);
+        }
+#endif
+        throw;
+    }
+}
+
+RecordedOutputs::~RecordedOutputs() {
+#ifndef _WIN32
+    if (isMapped) {
+        munmap(data, dataSize);
+    }
+#endif
+}
+
+InferenceResult RecordedOutputs::getResult(size_t index) const {
+    char* recordData = data + records.at(index);
+    const RecordHeader& record = *reinterpret_cast<const RecordHeader*>(recordData);
+    const OutputHeader* outputs = reinterpret_cast<const OutputHeader*>(recordData + sizeof(RecordHeader));
+
+    InferenceResult result;
+    result.frameId = record.frameId;
+    result.batchIndex = static_cast<size_t>(record.batchIndex);
+    result.completionTime = std::chrono::steady_clock::now();
+    if (record.inputImgWidth >= 0) {
+        result.internalModelData = std::make_shared<InternalImageModelData>(record.inputImgWidth,
+            record.inputImgHeight);
+    }
+    for (size_t i = 0; i < record.outputsCount; i++) {
+        const OutputHeader& output = outputs[i];
+        SizeVector dims(output.dims, output.dims + output.dimsCount);
+        TensorDesc desc(static_cast<Precision::ePrecision>(output.precision), dims,
+            static_cast<Layout>(output.layout));
+        std::string name(recordData + output.nameOffset, output.nameSize);
+        MemoryBlob::Ptr blob = wrapData(desc, recordData + output.dataOffset);
+        if (blob->byteSize() != output.dataSize) {
+            throw std::runtime_error("Size of recorded output " + name + " doesn't match its dimensions");
+        }
+        result.outputsData.emplace(name, blob);
+    }
+    return result;
+}
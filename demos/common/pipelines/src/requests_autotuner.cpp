@@ -0,0 +1,120 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/requests_autotuner.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <samples/slog.hpp>
+
+RequestsAutotuner::RequestsAutotuner(size_t maxRequests, size_t framesPerCandidate,
+    std::chrono::milliseconds latencyLimit, const std::string& cacheFileName) :
+    framesPerCandidate(std::max<size_t>(framesPerCandidate, 1)),
+    latencyLimit(latencyLimit),
+    cacheFileName(cacheFileName),
+    requestsLimit(std::max<size_t>(maxRequests, 1)) {
+    if (!cacheFileName.empty()) {
+        std::ifstream cacheFile(cacheFileName);
+        size_t cachedLimit = 0;
+        if (cacheFile >> cachedLimit && cachedLimit > 0 && cachedLimit <= requestsLimit) {
+            requestsLimit = cachedLimit;
+            isTuningDone = true;
+            slog::info << "Number of requests in flight is taken from " << cacheFileName << ": "
+                << requestsLimit << slog::endl;
+            return;
+        }
+    }
+
+    for (size_t count = 1; count < requestsLimit; count *= 2) {
+        candidates.push_back({count});
+    }
+    candidates.push_back({requestsLimit});
+    requestsLimit = candidates.front().requestsCount;
+    isTuningDone = candidates.size() == 1;
+}
+
+size_t RequestsAutotuner::getRequestsLimit() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return requestsLimit;
+}
+
+bool RequestsAutotuner::isTuning() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return !isTuningDone;
+}
+
+size_t RequestsAutotuner::recordCompletion(size_t framesCount, std::chrono::steady_clock::duration latency,
+    std::chrono::steady_clock::time_point completionTime) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (isTuningDone)
+        return requestsLimit;
+
+    if (windowCompletions++ == 0)
+        windowStart = completionTime;
+    else
+        windowFrames += framesCount;
+    windowLatency += latency;
+    if (windowFrames < framesPerCandidate)
+        return requestsLimit;
+
+    Candidate& candidate = candidates[currentCandidate];
+    candidate.fps = windowFrames / std::chrono::duration<double>(completionTime - windowStart).count();
+    candidate.latencyMs = std::chrono::duration<double, std::milli>(windowLatency).count() / windowCompletions;
+    slog::info << "Autotuning: " << candidate.requestsCount << " requests in flight give " << candidate.fps
+        << " FPS with " << candidate.latencyMs << " ms latency" << slog::endl;
+
+    windowFrames = 0;
+    windowCompletions = 0;
+    windowLatency = std::chrono::steady_clock::duration::zero();
+    if (++currentCandidate < candidates.size())
+        requestsLimit = candidates[currentCandidate].requestsCount;
+    else
+        chooseBest();
+    return requestsLimit;
+}
+
+void RequestsAutotuner::chooseBest() {
+    const double limitMs = static_cast<double>(latencyLimit.count());
+    auto best = candidates.end();
+    for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+        if (limitMs > 0 && it->latencyMs > limitMs)
+            continue;
+        if (best == candidates.end() || it->fps > best->fps)
+            best = it;
+    }
+    if (best == candidates.end()) {
+        best = std::min_element(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.latencyMs < b.latencyMs; });
+        slog::warn << "Autotuning: no number of requests fits " << limitMs << " ms latency" << slog::endl;
+    }
+    requestsLimit = best->requestsCount;
+    isTuningDone = true;
+    slog::info << "Autotuning: " << requestsLimit << " requests in flight are used" << slog::endl;
+
+    if (!cacheFileName.empty()) {
+        // Written to temporary file first, so other processes never read partially written decision
+        const std::string tmpFileName = cacheFileName + ".tmp";
+        std::ofstream tmpFile(tmpFileName);
+        tmpFile << requestsLimit << '\n';
+        tmpFile.close();
+        const bool isWritten = !tmpFile.fail();
+        std::remove(cacheFileName.c_str());
+        if (!isWritten || std::rename(tmpFileName.c_str(), cacheFileName.c_str()) != 0) {
+            std::remove(tmpFileName.c_str());
+            slog::warn << "Autotuning decision isn't cached to " << cacheFileName << slog::endl;
+        }
+    }
+}
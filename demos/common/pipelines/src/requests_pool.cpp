@@ -15,61 +15,67 @@
 */
 
 #include "pipelines/requests_pool.h"
+#include <samples/blob_allocator.h>
 
-RequestsPool::RequestsPool(InferenceEngine::ExecutableNetwork& execNetwork, unsigned int size) :
+RequestsPool::RequestsPool(InferenceEngine::ExecutableNetwork& execNetwork, unsigned int size,
+                           const std::string& deviceName) :
+    requestsInUse(new std::atomic<bool>[size]),
+    idleRequestsIndices(size),
     numRequestsInUse(0) {
+    requests.reserve(size);
     for (unsigned int infReqId = 0; infReqId < size; ++infReqId) {
-        requests.emplace(execNetwork.CreateInferRequestPtr(), false);
+        requests.push_back(execNetwork.CreateInferRequestPtr());
+        setHugePageBlobs(execNetwork, *requests.back(), deviceName);
+        requestsIndices.emplace(requests.back().get(), infReqId);
+        requestsInUse[infReqId] = false;
+        idleRequestsIndices.tryPush(infReqId);
     }
 }
 
 InferenceEngine::InferRequest::Ptr RequestsPool::getIdleRequest() {
-    std::lock_guard<std::mutex> lock(mtx);
-
-    const auto& it = std::find_if(requests.begin(), requests.end(), [](std::pair<const InferenceEngine::InferRequest::Ptr, bool>& x) {return !x.second; });
-    if (it == requests.end()) {
+    size_t idx;
+    if (!idleRequestsIndices.tryPop(idx)) {
         return InferenceEngine::InferRequest::Ptr();
     }
-    else {
-        it->second = true;
-        numRequestsInUse++;
-        return it->first;
-    }
+
+    requestsInUse[idx] = true;
+    numRequestsInUse++;
+    return requests[idx];
 }
 
 void RequestsPool::setRequestIdle(const InferenceEngine::InferRequest::Ptr& request) {
-    std::lock_guard<std::mutex> lock(mtx);
-    this->requests.at(request) = false;
+    size_t idx = requestsIndices.at(request.get());
+    requestsInUse[idx] = false;
+    // Queue capacity is not less than number of requests, so push can't fail here.
+    // Counter is decremented after push, so isIdleRequestAvailable never reports request which can't be popped yet
+    idleRequestsIndices.tryPush(idx);
     numRequestsInUse--;
 }
 
+InferenceEngine::InferRequest::Ptr RequestsPool::leaseRequest(const InferenceEngine::InferRequest::Ptr& request) {
+    return InferenceEngine::InferRequest::Ptr(request.get(), [this, request](InferenceEngine::InferRequest*) {
+        setRequestIdle(request);
+    });
+}
+
 size_t RequestsPool::getInUseRequestsCount() {
-    std::lock_guard<std::mutex> lock(mtx);
     return numRequestsInUse;
 }
 
 bool RequestsPool::isIdleRequestAvailable() {
-    std::lock_guard<std::mutex> lock(mtx);
     return numRequestsInUse < requests.size();
 }
 
 void RequestsPool::waitForTotalCompletion() {
-    // Do not synchronize here to avoid deadlock (despite synchronization in other functions)
     // Request status will be changed to idle in callback,
-    // upon completion of request we're waiting for. Synchronization is applied there
-    for (auto& pair : requests) {
-        if (pair.second) {
-            pair.first->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
+    // upon completion of request we're waiting for
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requestsInUse[i]) {
+            requests[i]->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
         }
     }
 }
 
 std::vector<InferenceEngine::InferRequest::Ptr> RequestsPool::getInferRequestsList() {
-    std::lock_guard<std::mutex> lock(mtx);
-    std::vector<InferenceEngine::InferRequest::Ptr> retVal;
-    retVal.reserve(requests.size());
-    for (auto& pair : requests) {
-        retVal.push_back(pair.first);
-    }
-    return retVal;
+    return requests;
 }
@@ -0,0 +1,102 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/reshaped_networks_cache.h"
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+#include <samples/slog.hpp>
+
+using namespace InferenceEngine;
+
+ReshapedNetworksCache::ReshapedNetworksCache(Core& engine, const CNNNetwork& cnnNetwork,
+    const ShapesFunction& getShapes, const std::string& device,
+    const std::map<std::string, std::string>& config, size_t capacity, int sizeStep) :
+    engine(engine),
+    cnnNetwork(cnnNetwork),
+    getShapes(getShapes),
+    device(device),
+    config(config),
+    capacity(capacity),
+    sizeStep(sizeStep) {
+    if (capacity == 0 || sizeStep <= 0) {
+        throw std::invalid_argument("Capacity and size step of ReshapedNetworksCache must be greater than 0");
+    }
+}
+
+ReshapedNetworksCache::~ReshapedNetworksCache() {
+    // Background loading references the cache, so it has to be finished
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto& entry : entries) {
+        entry.second.network.wait();
+    }
+}
+
+cv::Size ReshapedNetworksCache::getCanonicalSize(const cv::Size& size) const {
+    return cv::Size((size.width + sizeStep - 1) / sizeStep * sizeStep, (size.height + sizeStep - 1) / sizeStep * sizeStep);
+}
+
+std::shared_ptr<ExecutableNetwork> ReshapedNetworksCache::load(const cv::Size& canonicalSize) {
+    std::lock_guard<std::mutex> lock(loadMtx);
+    slog::info << "Loading network for " << canonicalSize.width << "x" << canonicalSize.height << " input" << slog::endl;
+    cnnNetwork.reshape(getShapes(canonicalSize));
+    return std::make_shared<ExecutableNetwork>(engine.LoadNetwork(cnnNetwork, device, config));
+}
+
+ReshapedNetworksCache::Entry& ReshapedNetworksCache::getEntry(const cv::Size& canonicalSize) {
+    const Key key(canonicalSize.width, canonicalSize.height);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        NetworkFuture network = std::async(std::launch::async, &ReshapedNetworksCache::load, this, canonicalSize).share();
+        it = entries.emplace(key, Entry{network, 0}).first;
+    }
+    it->second.lastUse = ++usesCounter;
+    evict();
+    return it->second;
+}
+
+void ReshapedNetworksCache::evict() {
+    while (entries.size() > capacity) {
+        auto leastRecent = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            // Networks being loaded aren't unloaded, as their loading can't be cancelled
+            bool isLoaded = it->second.network.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            if (isLoaded && it->second.lastUse != usesCounter
+                && (leastRecent == entries.end() || it->second.lastUse < leastRecent->second.lastUse)) {
+                leastRecent = it;
+            }
+        }
+        if (leastRecent == entries.end()) {
+            return;
+        }
+        // Users of the network keep it alive until they release it
+        entries.erase(leastRecent);
+    }
+}
+
+void ReshapedNetworksCache::prefetch(const cv::Size& canonicalSize) {
+    std::lock_guard<std::mutex> lock(mtx);
+    getEntry(canonicalSize);
+}
+
+std::shared_ptr<ExecutableNetwork> ReshapedNetworksCache::get(const cv::Size& canonicalSize) {
+    NetworkFuture network;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        network = getEntry(canonicalSize).network;
+    }
+    return network.get();
+}
@@ -0,0 +1,298 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/staged_runner.h"
+#include <stdexcept>
+#include <samples/frame_tracer.hpp>
+#include <samples/images_capture.h>
+#include <samples/performance_metrics.hpp>
+#include <samples/trace_profiler.hpp>
+
+StagedRunner::StagedRunner(AsyncPipeline& pipeline, const Config& config) :
+    pipeline(pipeline),
+    config(config) {
+    if (config.captureQueueSize == 0 || config.renderQueueSize == 0) {
+        throw std::invalid_argument("StagedRunner queue sizes must be greater than 0");
+    }
+    pipeline.setCompletionListener([this] { onCompletion(); });
+}
+
+StagedRunner::~StagedRunner() {
+    stop();
+    pipeline.setCompletionListener(nullptr);
+}
+
+void StagedRunner::run(const CaptureFunction& capture, const RenderFunction& render) {
+    runStages([capture](size_t&, std::chrono::steady_clock::time_point&) {
+        return capture();
+    }, render);
+}
+
+void StagedRunner::run(const SourceCaptureFunction& capture, const RenderFunction& render) {
+    runStages([capture](size_t& sourceId, std::chrono::steady_clock::time_point&) {
+        return capture(sourceId);
+    }, render);
+}
+
+void StagedRunner::run(ImagesCapture& capture, const RenderFunction& render) {
+    MultiSourceCapture* multiCapture = dynamic_cast<MultiSourceCapture*>(&capture);
+    runStages([&capture, multiCapture](size_t& sourceId, std::chrono::steady_clock::time_point& captureTime) {
+        cv::Mat frame = multiCapture ? multiCapture->readFrom(sourceId) : capture.read();
+        captureTime = capture.getLastFrameTime();
+        return frame;
+    }, render);
+}
+
+void StagedRunner::runStages(const TimedCaptureFunction& capture, const RenderFunction& render) {
+    captureThread = std::thread(&StagedRunner::captureLoop, this, capture);
+    pipelineThread = std::thread(&StagedRunner::pipelineLoop, this);
+    try {
+        renderLoop(render);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(mtx);
+        setException(std::current_exception());
+    }
+    stop();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    if (stageException) {
+        std::rethrow_exception(stageException);
+    }
+}
+
+void StagedRunner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        isStopping = true;
+    }
+    condVar.notify_all();
+    if (captureThread.joinable())
+        captureThread.join();
+    if (pipelineThread.joinable())
+        pipelineThread.join();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    while (!results.empty()) {
+        pipeline.releaseResult(std::move(results.front()));
+        results.pop_front();
+    }
+    capturedFrames.clear();
+}
+
+void StagedRunner::setException(const std::exception_ptr& exception) {
+    if (!stageException)
+        stageException = exception;
+    isStopping = true;
+    condVar.notify_all();
+}
+
+void StagedRunner::onCompletion() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        completionsCounter++;
+    }
+    condVar.notify_all();
+}
+
+void StagedRunner::captureLoop(const TimedCaptureFunction& capture) {
+    FRAME_TRACE_THREAD_NAME("Capture");
+    try {
+        bool isFirstFrame = true;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                if (config.capturePolicy == DropPolicy::Block) {
+                    condVar.wait(lock, [&] { return isStopping || capturedFrames.size() < config.captureQueueSize; });
+                }
+                if (isStopping)
+                    return;
+            }
+
+            auto startTime = std::chrono::steady_clock::now();
+            cv::Mat frame;
+            size_t sourceId = 0;
+            std::chrono::steady_clock::time_point captureTime;
+            {
+                FRAME_TRACE_SCOPE("Decode", -1, -1);
+                frame = capture(sourceId, captureTime);
+            }
+            if (captureTime == std::chrono::steady_clock::time_point{}) {
+                captureTime = startTime;
+            }
+            if (performanceMetrics)
+                performanceMetrics->recordStage(PerformanceMetrics::Stage::Decode, startTime);
+            if (traceProfiler)
+                traceProfiler->addSpan("Decode", startTime, std::chrono::steady_clock::now());
+            if (frame.empty() && isFirstFrame) {
+                throw std::logic_error("Can't read an image from the input");
+            }
+            isFirstFrame = false;
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (frame.empty()) {
+                    // Input stream is over
+                    isCaptureFinished = true;
+                }
+                else {
+                    if (capturedFrames.size() >= config.captureQueueSize) {
+                        capturedFrames.pop_front();
+                        droppedCapturedCount++;
+                    }
+                    capturedFrames.push_back({frame, captureTime, std::chrono::steady_clock::now(), sourceId});
+                }
+            }
+            condVar.notify_all();
+            if (frame.empty())
+                return;
+        }
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(mtx);
+        setException(std::current_exception());
+    }
+}
+
+void StagedRunner::submitFrames() {
+    while (pipeline.isReadyToProcess()) {
+        CapturedFrame captured;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (config.maxFrameAge.count() > 0) {
+                // Stale frames are dropped before they take a request and get preprocessed
+                auto now = std::chrono::steady_clock::now();
+                while (!capturedFrames.empty() && now - capturedFrames.front().startTime > config.maxFrameAge) {
+                    capturedFrames.pop_front();
+                    droppedCapturedCount++;
+                }
+            }
+            if (isStopping || capturedFrames.empty())
+                return;
+            captured = std::move(capturedFrames.front());
+            capturedFrames.pop_front();
+        }
+        condVar.notify_all();
+
+        if (performanceMetrics)
+            performanceMetrics->recordStage(PerformanceMetrics::Stage::CaptureWait, captured.queuedTime);
+        pipeline.submitData(ImageInputData(captured.frame),
+            makeImageMetaData(captured.frame, captured.startTime, captured.sourceId));
+    }
+}
+
+void StagedRunner::pushResult(std::unique_ptr<ResultBase>&& result) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (config.renderPolicy == DropPolicy::Block) {
+        condVar.wait(lock, [&] { return isStopping || results.size() < config.renderQueueSize; });
+    }
+    if (isStopping) {
+        pipeline.releaseResult(std::move(result));
+        return;
+    }
+    if (results.size() >= config.renderQueueSize) {
+        pipeline.releaseResult(std::move(results.front()));
+        results.pop_front();
+        droppedResultsCount++;
+    }
+    results.push_back(std::move(result));
+    lock.unlock();
+    condVar.notify_all();
+}
+
+void StagedRunner::forwardResults() {
+    while (std::unique_ptr<ResultBase> result = pipeline.getResult()) {
+        pushResult(std::move(result));
+    }
+}
+
+void StagedRunner::pipelineLoop() {
+    FRAME_TRACE_THREAD_NAME("Pipeline");
+    try {
+        uint64_t seenCompletions = 0;
+        for (;;) {
+            pipeline.rethrowCallbackException();
+            submitFrames();
+            forwardResults();
+
+            bool hasFrames;
+            bool isBatchDue = false;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                if (isStopping || (isCaptureFinished && capturedFrames.empty()))
+                    break;
+                hasFrames = !capturedFrames.empty();
+                if (!hasFrames) {
+                    // Waiting for a new frame, inference completion or the deadline of the incomplete batch
+                    auto isWakeUpNeeded = [&] {
+                        return isStopping || isCaptureFinished || !capturedFrames.empty()
+                            || completionsCounter != seenCompletions; };
+                    if (pipeline.hasPendingBatch())
+                        isBatchDue = !condVar.wait_until(lock, pipeline.getPendingBatchDeadline(), isWakeUpNeeded);
+                    else
+                        condVar.wait(lock, isWakeUpNeeded);
+                }
+                seenCompletions = completionsCounter;
+            }
+
+            // The batch is sent outside of the lock, since its completion callback takes it
+            if (isBatchDue) {
+                pipeline.flushPendingBatch();
+            }
+            // There are frames, but no free requests: waitForData returns as soon as a request or a result is
+            // available, and sends the incomplete batch for inference if its deadline passes first
+            else if (hasFrames && !pipeline.isReadyToProcess()) {
+                pipeline.waitForData();
+            }
+        }
+
+        //// ------------ Waiting for completion of data processing and rendering the rest of results ---------
+        pipeline.waitForTotalCompletion();
+        pipeline.rethrowCallbackException();
+        forwardResults();
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(mtx);
+        setException(std::current_exception());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        isPipelineFinished = true;
+    }
+    condVar.notify_all();
+}
+
+void StagedRunner::renderLoop(const RenderFunction& render) {
+    for (;;) {
+        std::unique_ptr<ResultBase> result;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            condVar.wait(lock, [&] { return stageException || !results.empty() || isPipelineFinished; });
+            if (stageException || results.empty())
+                return;
+            result = std::move(results.front());
+            results.pop_front();
+        }
+        condVar.notify_all();
+
+        bool keepRunning = render(*result);
+        pipeline.releaseResult(std::move(result));
+        if (!keepRunning) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,136 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "pipelines/switching_pipeline.h"
+#include <stdexcept>
+#include <utility>
+#include <samples/slog.hpp>
+
+namespace {
+// Results are usually released right after they are used, so only a few last frames are remembered
+const size_t maxReturnedFrames = 16;
+}
+
+void SwitchingPipeline::checkConfig(const CnnConfig& cnnConfig) {
+    if (cnnConfig.maxBatchSize > 1)
+        throw std::invalid_argument("Switched pipelines can't batch frames");
+    if (cnnConfig.unorderedResults || cnnConfig.maxReorderBufferSize != 0)
+        throw std::invalid_argument("Switched pipelines should return results in submission order");
+}
+
+void SwitchingPipeline::setPipelines(std::unique_ptr<AsyncPipeline>&& first, std::unique_ptr<AsyncPipeline>&& second) {
+    for (const auto& pipeline : {first.get(), second.get()}) {
+        if (pipeline->getMaxBatchSize() > 1)
+            throw std::invalid_argument("Switched pipelines can't batch frames");
+        if (!pipeline->isSubmissionOrderKept())
+            throw std::invalid_argument("Switched pipelines should return results in submission order");
+    }
+    pipelines[0] = std::move(first);
+    pipelines[1] = std::move(second);
+    for (auto& pipeline : pipelines)
+        pipeline->setCompletionListener([this] { onCompletion(); });
+}
+
+SwitchingPipeline::~SwitchingPipeline() {
+    waitForTotalCompletion();
+}
+
+void SwitchingPipeline::onCompletion() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        completionsCount++;
+    }
+    condVar.notify_all();
+}
+
+int64_t SwitchingPipeline::submitData(const InputData& inputData, const std::shared_ptr<MetaData>& metaData) {
+    const auto now = std::chrono::steady_clock::now();
+    const size_t selected = selectPipeline(submittedFrames.size() + 1, now);
+    if (selected != activePipeline) {
+        // The frames in flight of the previous pipeline are still completed and returned first
+        slog::info << "Switching to the " << pipelineName(selected) << ", "
+            << submittedFrames.size() << " frames in flight" << slog::endl;
+        activePipeline = selected;
+    }
+
+    if (pipelines[activePipeline]->submitData(inputData, metaData) < 0)
+        return -1;
+    const int64_t frameId = inputFrameId++;
+    submittedFrames.push_back({activePipeline, frameId, now});
+    return frameId;
+}
+
+bool SwitchingPipeline::fetchNextResult() {
+    if (!nextResult && !submittedFrames.empty()) {
+        const SubmittedFrame& frame = submittedFrames.front();
+        nextResult = pipelines[frame.pipelineIndex]->getResult();
+        if (nextResult) {
+            nextResult->frameId = frame.frameId;
+            onResult(frame.pipelineIndex, std::chrono::steady_clock::now() - frame.submitTime);
+            returnedFrames.push_back(frame);
+            if (returnedFrames.size() > maxReturnedFrames)
+                returnedFrames.pop_front();
+            submittedFrames.pop_front();
+        }
+    }
+    return static_cast<bool>(nextResult);
+}
+
+void SwitchingPipeline::waitForData() {
+    for (;;) {
+        uint64_t seenCompletions;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            seenCompletions = completionsCount;
+        }
+        for (auto& pipeline : pipelines)
+            pipeline->rethrowCallbackException();
+        if (isReadyToProcess() || fetchNextResult())
+            return;
+        std::unique_lock<std::mutex> lock(mtx);
+        condVar.wait(lock, [&] { return completionsCount != seenCompletions; });
+    }
+}
+
+std::unique_ptr<ResultBase> SwitchingPipeline::getResult() {
+    fetchNextResult();
+    return std::move(nextResult);
+}
+
+void SwitchingPipeline::releaseResult(std::unique_ptr<ResultBase>&& result) {
+    if (!result)
+        return;
+    for (auto it = returnedFrames.begin(); it != returnedFrames.end(); ++it) {
+        if (it->frameId == result->frameId) {
+            pipelines[it->pipelineIndex]->releaseResult(std::move(result));
+            returnedFrames.erase(it);
+            return;
+        }
+    }
+    result.reset();
+}
+
+void SwitchingPipeline::waitForTotalCompletion() {
+    for (auto& pipeline : pipelines) {
+        if (pipeline)
+            pipeline->waitForTotalCompletion();
+    }
+}
+
+void SwitchingPipeline::setPerformanceMetrics(PerformanceMetrics* metrics) {
+    for (auto& pipeline : pipelines)
+        pipeline->setPerformanceMetrics(metrics);
+}
@@ -23,7 +23,7 @@
 void readInputFilesArguments(std::vector<std::string>& files, const std::string& arg) {
     struct stat sb;
     if (stat(arg.c_str(), &sb) != 0) {
-        if (arg.compare(0, 5, "rtsp:") != 0) {
+        if (arg.compare(0, 5, "rtsp:") != 0 && arg.compare(0, 10, "synthetic:") != 0) {
             slog::warn << "File " << arg << " cannot be opened!" << slog::endl;
             return;
         }
@@ -90,7 +90,7 @@ std::vector<std::string> parseDevices(const std::string& device_string) {
     const std::string::size_type colon_position = device_string.find(":");
     if (colon_position != std::string::npos) {
         std::string device_type = device_string.substr(0, colon_position);
-        if (device_type == "HETERO" || device_type == "MULTI") {
+        if (device_type == "HETERO" || device_type == "MULTI" || device_type == "BALANCE") {
             std::string comma_separated_devices = device_string.substr(colon_position + 1);
             std::vector<std::string> devices = split(comma_separated_devices, ',');
             for (auto& device : devices)
@@ -0,0 +1,106 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/assignment.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+std::vector<int> solveAssignment(const cv::Mat& costMatrix, float maxCost) {
+    CV_Assert(CV_32FC1 == costMatrix.type() && cv::checkRange(costMatrix) && !std::isnan(maxCost));
+    // The rows are assigned one by one, so there should be fewer rows than columns. Both gated and ungated optimal
+    // assignments stay optimal for the transposed matrix
+    const bool transposed = costMatrix.rows > costMatrix.cols;
+    cv::Mat costs = costMatrix;
+    if (transposed) {
+        cv::transpose(costMatrix, costs);
+    }
+    const int rows = costs.rows;
+    const int realCols = costs.cols;
+    // With gating, every row has its own dummy column of maxCost, which it takes if it stays unassigned.
+    // Then every row can be assigned, and leaving a row unassigned is better than taking a pair costing more
+    const bool gated = maxCost != std::numeric_limits<float>::infinity();
+    const int cols = gated ? realCols + rows : realCols;
+
+    // Rows and columns are numbered from 1, and column 0 holds the row being assigned. rowPotential and colPotential
+    // are the dual variables, the reduced cost of a pair cost - rowPotential[row] - colPotential[col] is
+    // non-negative, and it is 0 for the assigned pairs
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> rowPotential(rows + 1, 0.0), colPotential(cols + 1, 0.0);
+    std::vector<int> colRow(cols + 1, 0);  // the row assigned to a column, 0 if none
+    std::vector<int> prevCol(cols + 1, 0);  // the previous column in the shortest augmenting path
+    std::vector<double> minReducedCost(cols + 1);
+    std::vector<char> isColReached(cols + 1);
+    for (int row = 1; row <= rows; row++) {
+        // Dijkstra's search of the shortest path from the new row to a free column, it alternates unassigned
+        // and assigned pairs
+        colRow[0] = row;
+        int col = 0;
+        std::fill(minReducedCost.begin(), minReducedCost.end(), infinity);
+        std::fill(isColReached.begin(), isColReached.end(), 0);
+        do {
+            isColReached[col] = 1;
+            const int pathRow = colRow[col];
+            const float* rowCosts = costs.ptr<float>(pathRow - 1);
+            double delta = infinity;
+            int nextCol = 0;
+            for (int j = 1; j <= cols; j++) {
+                if (isColReached[j]) {
+                    continue;
+                }
+                // The gated pairs and the dummy columns of other rows are not arcs
+                double cost = infinity;
+                if (j <= realCols) {
+                    if (rowCosts[j - 1] <= maxCost) {
+                        cost = rowCosts[j - 1];
+                    }
+                } else if (j - realCols == pathRow) {
+                    cost = maxCost;
+                }
+                if (cost != infinity) {
+                    const double reducedCost = cost - rowPotential[pathRow] - colPotential[j];
+                    if (reducedCost < minReducedCost[j]) {
+                        minReducedCost[j] = reducedCost;
+                        prevCol[j] = col;
+                    }
+                }
+                if (minReducedCost[j] < delta) {
+                    delta = minReducedCost[j];
+                    nextCol = j;
+                }
+            }
+            // A free column is always reachable: a dummy one with gating, or else any of the spare columns
+            CV_Assert(nextCol != 0);
+            for (int j = 0; j <= cols; j++) {
+                if (isColReached[j]) {
+                    rowPotential[colRow[j]] += delta;
+                    colPotential[j] -= delta;
+                } else {
+                    minReducedCost[j] -= delta;
+                }
+            }
+            col = nextCol;
+        } while (colRow[col] != 0);
+        // Flip the pairs along the path
+        do {
+            const int pathCol = prevCol[col];
+            colRow[col] = colRow[pathCol];
+            col = pathCol;
+        } while (col != 0);
+    }
+
+    std::vector<int> assignment(costMatrix.rows, -1);
+    for (int col = 1; col <= realCols; col++) {
+        if (colRow[col] != 0) {
+            if (transposed) {
+                assignment[col - 1] = colRow[col] - 1;
+            } else {
+                assignment[colRow[col] - 1] = col - 1;
+            }
+        }
+    }
+    return assignment;
+}
@@ -0,0 +1,134 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/blob_allocator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include "samples/frame_allocator.h"
+
+namespace {
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Handle returned by BlobAllocator::alloc
+struct Allocation {
+    void* data;
+    size_t mappedSize;  // 0 for buffers of alignedAlloc
+};
+
+void* mapHugePages(size_t size) {
+#if !defined(_WIN32) && defined(MAP_HUGETLB)
+    // Fails right away if there are not enough reserved huge pages
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return ptr != MAP_FAILED ? ptr : nullptr;
+#else
+    (void)size;
+    return nullptr;
+#endif
+}
+
+InferenceEngine::MemoryBlob::Ptr makeBlob(const InferenceEngine::TensorDesc& desc) {
+    using namespace InferenceEngine;
+    switch (desc.getPrecision()) {
+    case Precision::FP32:
+        return make_shared_blob<float>(desc, getBlobAllocator());
+    case Precision::FP16:
+    case Precision::I16:
+        return make_shared_blob<int16_t>(desc, getBlobAllocator());
+    case Precision::U16:
+        return make_shared_blob<uint16_t>(desc, getBlobAllocator());
+    case Precision::I32:
+        return make_shared_blob<int32_t>(desc, getBlobAllocator());
+    case Precision::I64:
+        return make_shared_blob<int64_t>(desc, getBlobAllocator());
+    case Precision::I8:
+        return make_shared_blob<int8_t>(desc, getBlobAllocator());
+    case Precision::U8:
+    case Precision::BOOL:
+        return make_shared_blob<uint8_t>(desc, getBlobAllocator());
+    default:
+        return nullptr;
+    }
+}
+}
+
+void* BlobAllocator::lock(void* handle, InferenceEngine::LockOp) noexcept {
+    return handle ? static_cast<Allocation*>(handle)->data : nullptr;
+}
+
+void* BlobAllocator::alloc(size_t size) noexcept {
+    Allocation* allocation = new (std::nothrow) Allocation{nullptr, 0};
+    if (!allocation) return nullptr;
+    if (size >= HUGE_PAGE_SIZE) {
+        const size_t mappedSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        allocation->data = mapHugePages(mappedSize);
+        if (allocation->data) {
+            allocation->mappedSize = mappedSize;
+            return allocation;
+        }
+    }
+    try {
+        allocation->data = alignedAlloc(size);
+    } catch (const std::bad_alloc&) {
+        delete allocation;
+        return nullptr;
+    }
+    return allocation;
+}
+
+bool BlobAllocator::free(void* handle) noexcept {
+    if (!handle) return false;
+    Allocation* allocation = static_cast<Allocation*>(handle);
+#ifndef _WIN32
+    if (allocation->mappedSize) {
+        munmap(allocation->data, allocation->mappedSize);
+    } else {
+        alignedFree(allocation->data);
+    }
+#else
+    alignedFree(allocation->data);
+#endif
+    delete allocation;
+    return true;
+}
+
+std::shared_ptr<InferenceEngine::IAllocator> getBlobAllocator() {
+    static std::shared_ptr<InferenceEngine::IAllocator> allocator = std::make_shared<BlobAllocator>();
+    return allocator;
+}
+
+void setHugePageBlobs(const InferenceEngine::ExecutableNetwork& execNetwork, InferenceEngine::InferRequest& request,
+                      const std::string& deviceName) {
+    // GPU blobs may be remote and MYRIAD and HDDL ones are bound to the device. HETERO and MULTI are skipped as well,
+    // as they pass the blobs to such plugins
+    if (deviceName != "CPU") return;
+    const char* hugePagesVar = std::getenv("OMZ_HUGE_PAGES");
+    if (hugePagesVar && std::strcmp(hugePagesVar, "0") == 0) return;
+
+    std::vector<std::string> names;
+    for (const auto& input : execNetwork.GetInputsInfo()) names.push_back(input.first);
+    for (const auto& output : execNetwork.GetOutputsInfo()) names.push_back(output.first);
+    for (const std::string& name : names) {
+        InferenceEngine::MemoryBlob::Ptr blob = InferenceEngine::as<InferenceEngine::MemoryBlob>(request.GetBlob(name));
+        if (!blob || blob->byteSize() < HUGE_PAGE_SIZE) continue;
+        InferenceEngine::MemoryBlob::Ptr hugePageBlob = makeBlob(blob->getTensorDesc());
+        if (!hugePageBlob) continue;  // The plugin's blob is kept for other precisions
+        hugePageBlob->allocate();
+        if (!hugePageBlob->rmap().as<const void*>()) continue;
+        try {
+            request.SetBlob(name, hugePageBlob);
+        } catch (const std::exception&) {
+            // The request keeps the plugin's blob
+        }
+    }
+}
@@ -0,0 +1,88 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/frame_allocator.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace {
+constexpr size_t CACHE_LINE_SIZE = 64;
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+}
+
+void* alignedAlloc(size_t size) {
+    size_t alignment = size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : CACHE_LINE_SIZE;
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(size, alignment);
+    if (!ptr) throw std::bad_alloc{};
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) throw std::bad_alloc{};
+#ifdef MADV_HUGEPAGE
+    if (alignment == HUGE_PAGE_SIZE) {
+        madvise(ptr, size / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE, MADV_HUGEPAGE);  // Just a hint, failures are harmless
+    }
+#endif
+#endif
+    return ptr;
+}
+
+void alignedFree(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+cv::UMatData* FrameAllocator::allocate(int dims, const int* sizes, int type, void* data, size_t* step, AccessFlag,
+                                       cv::UMatUsageFlags) const {
+    // Steps are computed like cv::Mat does for its own buffers, so the allocated frame is continuous
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = data ? static_cast<uchar*>(data) : static_cast<uchar*>(alignedAlloc(total));
+    u->size = total;
+    if (data) {
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+    }
+    return u;
+}
+
+bool FrameAllocator::allocate(cv::UMatData* u, AccessFlag, cv::UMatUsageFlags) const {
+    return u != nullptr;
+}
+
+void FrameAllocator::deallocate(cv::UMatData* u) const {
+    if (!u) return;
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+        alignedFree(u->origdata);
+        u->origdata = nullptr;
+    }
+    delete u;
+}
+
+cv::MatAllocator* getFrameAllocator() {
+    static FrameAllocator allocator;
+    return &allocator;
+}
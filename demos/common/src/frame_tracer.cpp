@@ -0,0 +1,172 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/frame_tracer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <utility>
+
+namespace {
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string escapeJson(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (char c : str) {
+        if ('"' == c || '\\' == c) {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void writeTimestamp(std::ostream& out, int64_t timestampNs) {
+    // Chrome trace timestamps are in microseconds, keep the fractional part to order close events
+    char ts[32];
+    std::snprintf(ts, sizeof(ts), "%lld.%03lld", static_cast<long long>(timestampNs / 1000),
+        static_cast<long long>(timestampNs % 1000));
+    out << ts;
+}
+}
+
+FrameTracer& FrameTracer::instance() {
+    static FrameTracer tracer;
+    return tracer;
+}
+
+FrameTracer::FrameTracer() : enabled{false}, ringSize{65536}, creationTime{nowNs()} {
+    if (const char* path = std::getenv("OMZ_FRAME_TRACE_FILE")) {
+        outputPath = path;
+        enabled = !outputPath.empty();
+    }
+    if (const char* size = std::getenv("OMZ_FRAME_TRACE_EVENTS")) {
+        long long parsedSize = std::atoll(size);
+        if (parsedSize > 0) {
+            ringSize = static_cast<size_t>(parsedSize);
+        }
+    }
+}
+
+FrameTracer::~FrameTracer() {
+    if (!enabled) {
+        return;
+    }
+    std::ofstream out(outputPath);
+    if (out) {
+        writeChromeTrace(out);
+    }
+    if (!out) {
+        std::cerr << "[ WARNING ] Failed to write frame trace to " << outputPath << std::endl;
+    }
+}
+
+FrameTracer::ThreadRing& FrameTracer::getThreadRing() {
+    // The tracer keeps the ring after the thread has finished, so its events are written too
+    static thread_local std::shared_ptr<ThreadRing> ring;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(mtx);
+        ring = std::make_shared<ThreadRing>(ringSize, static_cast<int>(rings.size()));
+        rings.push_back(ring);
+    }
+    return *ring;
+}
+
+void FrameTracer::record(const char* name, EventType type, int64_t frameId, int64_t sourceId) {
+    if (!enabled) {
+        return;
+    }
+    ThreadRing& ring = getThreadRing();
+    uint64_t recorded = ring.recorded.load(std::memory_order_relaxed);
+    ring.events[recorded % ring.events.size()] = {name, type, frameId, sourceId, nowNs() - creationTime};
+    ring.recorded.store(recorded + 1, std::memory_order_release);
+}
+
+void FrameTracer::setThreadName(const std::string& name) {
+    if (!enabled) {
+        return;
+    }
+    ThreadRing& ring = getThreadRing();
+    std::lock_guard<std::mutex> lock(mtx);
+    ring.threadName = name;
+}
+
+void FrameTracer::writeChromeTrace(std::ostream& out) const {
+    struct FlowPoint {
+        int64_t timestamp;
+        int threadId;
+    };
+    std::map<std::pair<int64_t, int64_t>, std::vector<FlowPoint>> flows; // by source and frame
+
+    std::lock_guard<std::mutex> lock(mtx);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool isFirst = true;
+    for (const std::shared_ptr<ThreadRing>& ring : rings) {
+        std::string threadName = ring->threadName.empty()
+            ? "Thread #" + std::to_string(ring->threadId) : ring->threadName;
+        out << (isFirst ? "" : ",") << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << ring->threadId << ", \"args\": {\"name\": \"" << escapeJson(threadName) << "\"}}";
+        isFirst = false;
+
+        const uint64_t recorded = ring->recorded.load(std::memory_order_acquire);
+        const uint64_t size = ring->events.size();
+        // An End without its Begin (overwritten in the ring) is dropped by the viewers
+        for (uint64_t i = recorded > size ? recorded - size : 0; i < recorded; ++i) {
+            const Event& event = ring->events[i % size];
+            if (EventType::Flow == event.type) {
+                if (event.frameId >= 0) {
+                    flows[{event.sourceId, event.frameId}].push_back({event.timestamp, ring->threadId});
+                }
+                continue;
+            }
+            out << ",\n{\"name\": \"" << escapeJson(event.name) << "\", \"cat\": \"frame\", \"ph\": \""
+                << (EventType::Begin == event.type ? "B" : "E") << "\", \"pid\": 1, \"tid\": " << ring->threadId
+                << ", \"ts\": ";
+            writeTimestamp(out, event.timestamp);
+            if (EventType::Begin == event.type) {
+                out << ", \"args\": {\"frame\": " << event.frameId << ", \"source\": " << event.sourceId << "}";
+            }
+            out << "}";
+        }
+    }
+
+    // Every flow is bound to the slices enclosing its points, the first point starts it and the last one finishes it
+    unsigned flowId = 0;
+    for (auto& flow : flows) {
+        std::vector<FlowPoint>& points = flow.second;
+        if (points.size() < 2) {
+            continue;
+        }
+        std::stable_sort(points.begin(), points.end(), [](const FlowPoint& l, const FlowPoint& r) {
+            return l.timestamp < r.timestamp;
+        });
+        for (size_t i = 0; i < points.size(); ++i) {
+            const char* phase = 0 == i ? "s" : points.size() - 1 == i ? "f" : "t";
+            out << ",\n{\"name\": \"frame\", \"cat\": \"frame\", \"ph\": \"" << phase << "\", \"bp\": \"e\", \"id\": "
+                << flowId << ", \"pid\": 1, \"tid\": " << points[i].threadId << ", \"ts\": ";
+            writeTimestamp(out, points[i].timestamp);
+            if (0 == i) {
+                out << ", \"args\": {\"frame\": " << flow.first.second << ", \"source\": " << flow.first.first << "}";
+            }
+            out << "}";
+        }
+        ++flowId;
+    }
+    out << "\n]}" << std::endl;
+}
@@ -0,0 +1,104 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/heatmap_peaks.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace {
+// As the threshold is positive, a pixel which isn't less than it is greater than a neighbour below the threshold, so
+// thresholding the neighbours isn't needed. Missing neighbours of the border rows are the lowest float
+bool isPeak(const float* row, const float* rowAbove, const float* rowBelow, int x, int cols, float threshold) {
+    const float value = row[x];
+    return value >= threshold
+        && (0 == x || value > row[x - 1])
+        && (cols - 1 == x || value > row[x + 1])
+        && value > rowAbove[x]
+        && value > rowBelow[x];
+}
+}  // namespace
+
+void findHeatMapPeaks(const cv::Mat& heatMap, float threshold, std::vector<cv::Point>& peaks) {
+    CV_Assert(CV_32FC1 == heatMap.type() && threshold > 0);
+    const int cols = heatMap.cols;
+    const std::vector<float> missingRow(cols, std::numeric_limits<float>::lowest());
+    for (int y = 0; y < heatMap.rows; y++) {
+        const float* row = heatMap.ptr<float>(y);
+        const float* rowAbove = y > 0 ? heatMap.ptr<float>(y - 1) : missingRow.data();
+        const float* rowBelow = y < heatMap.rows - 1 ? heatMap.ptr<float>(y + 1) : missingRow.data();
+        if (cols > 0 && isPeak(row, rowAbove, rowBelow, 0, cols, threshold)) {
+            peaks.emplace_back(0, y);
+        }
+        // The first and the last pixels have a single horizontal neighbour, they are checked separately
+        int x = 1;
+#if CV_SIMD
+        const int lanes = cv::v_float32::nlanes;
+        const cv::v_float32 thresholds = cv::vx_setall_f32(threshold);
+        for (; x + lanes < cols; x += lanes) {
+            const cv::v_float32 values = cv::vx_load(row + x);
+            const cv::v_float32 isPeakMask = (values >= thresholds)
+                & (values > cv::vx_load(row + x - 1))
+                & (values > cv::vx_load(row + x + 1))
+                & (values > cv::vx_load(rowAbove + x))
+                & (values > cv::vx_load(rowBelow + x));
+            // Peaks are rare, most of the vectors don't have any
+            int laneMask = cv::v_signmask(isPeakMask);
+            for (int lane = 0; laneMask; lane++, laneMask >>= 1) {
+                if (laneMask & 1) {
+                    peaks.emplace_back(x + lane, y);
+                }
+            }
+        }
+#endif
+        for (; x < cols; x++) {
+            if (isPeak(row, rowAbove, rowBelow, x, cols, threshold)) {
+                peaks.emplace_back(x, y);
+            }
+        }
+    }
+}
+
+std::vector<bool> suppressClosePoints(const std::vector<cv::Point2f>& points, float minDistance) {
+    std::vector<bool> isKept(points.size(), true);
+    if (points.empty() || !(minDistance > 0)) {
+        return isKept;
+    }
+    float minX = points[0].x, minY = points[0].y, maxX = points[0].x, maxY = points[0].y;
+    for (const cv::Point2f& point : points) {
+        minX = std::min(minX, point.x);
+        minY = std::min(minY, point.y);
+        maxX = std::max(maxX, point.x);
+        maxY = std::max(maxY, point.y);
+    }
+    const int gridCols = static_cast<int>((maxX - minX) / minDistance) + 1;
+    const int gridRows = static_cast<int>((maxY - minY) / minDistance) + 1;
+    // Every cell is a list of the kept points in it: the latest point and the links to the previous ones
+    std::vector<int> cellHeads(static_cast<size_t>(gridCols) * gridRows, -1);
+    std::vector<int> nextInCell(points.size(), -1);
+    const float minDistanceSquared = minDistance * minDistance;
+    for (size_t i = 0; i < points.size(); i++) {
+        const int cellX = std::min(static_cast<int>((points[i].x - minX) / minDistance), gridCols - 1);
+        const int cellY = std::min(static_cast<int>((points[i].y - minY) / minDistance), gridRows - 1);
+        for (int y = std::max(cellY - 1, 0); isKept[i] && y <= std::min(cellY + 1, gridRows - 1); y++) {
+            for (int x = std::max(cellX - 1, 0); isKept[i] && x <= std::min(cellX + 1, gridCols - 1); x++) {
+                for (int j = cellHeads[y * gridCols + x]; j >= 0; j = nextInCell[j]) {
+                    const cv::Point2f diff = points[i] - points[j];
+                    if (diff.x * diff.x + diff.y * diff.y < minDistanceSquared) {
+                        isKept[i] = false;
+                        break;
+                    }
+                }
+            }
+        }
+        if (isKept[i]) {
+            int& cellHead = cellHeads[cellY * gridCols + cellX];
+            nextInCell[i] = cellHead;
+            cellHead = static_cast<int>(i);
+        }
+    }
+    return isKept;
+}
@@ -3,6 +3,7 @@
 //
 
 #include "samples/images_capture.h"
+#include "samples/frame_allocator.h"
 
 #ifdef _WIN32
 #include "w_dirent.hpp"
@@ -12,45 +13,131 @@
 
 #include <opencv2/imgcodecs.hpp>
 
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 class InvalidInput {};
 
+namespace {
+// Reads the image reduced by 2, 4 or 8 times if it stays at least as large as sizeHint, JPEG images are scaled
+// while decoding then, which skips most of the decoding work. Image size isn't known before decoding, so the
+// factor is taken from the previous image and updated by every image decoded at full resolution. An image
+// which turns out smaller than sizeHint is decoded again at full resolution
+cv::Mat imreadForSize(const std::string &fileName, cv::Size sizeHint, int &reduceFactor) {
+    if (sizeHint.area() == 0) return cv::imread(fileName);
+    if (reduceFactor > 1) {
+        int flags = reduceFactor == 8 ? cv::IMREAD_REDUCED_COLOR_8
+            : reduceFactor == 4 ? cv::IMREAD_REDUCED_COLOR_4 : cv::IMREAD_REDUCED_COLOR_2;
+        cv::Mat img = cv::imread(fileName, flags);
+        if (img.data && img.cols >= sizeHint.width && img.rows >= sizeHint.height) return img;
+    }
+    cv::Mat img = cv::imread(fileName);
+    if (img.data) {
+        reduceFactor = 1;
+        while (reduceFactor < 8 && img.cols / (reduceFactor * 2) >= sizeHint.width
+                && img.rows / (reduceFactor * 2) >= sizeHint.height) {
+            reduceFactor *= 2;
+        }
+    }
+    return img;
+}
+}  // namespace
+
 class ImreadWrapper : public ImagesCapture {
     cv::Mat img;
     bool canRead;
+    const bool isShared;  // The image is handed out without copying
 
 public:
-    ImreadWrapper(const std::string &input, bool loop) : ImagesCapture{loop}, canRead{true} {
-        img = cv::imread(input);
+    ImreadWrapper(const std::string &input, bool loop, bool isShared, cv::Size decodeSizeHint)
+            : ImagesCapture{loop}, canRead{true}, isShared{isShared} {
+        int reduceFactor = 1;
+        img = imreadForSize(input, decodeSizeHint, reduceFactor);
         if(!img.data) throw InvalidInput{};
+        if (reduceFactor > 1) {
+            img = imreadForSize(input, decodeSizeHint, reduceFactor);  // The image is kept, keep it small too
+        }
     }
 
     double fps() const override {return 1.0;}
 
     cv::Mat read() override {
-        if (loop) return img.clone();
+        if (loop) return isShared ? img : img.clone();
         if (canRead) {
             canRead = false;
-            return img.clone();
+            return isShared ? img : img.clone();
         }
         return cv::Mat{};
     }
 };
 
+class SyntheticCapture : public ImagesCapture {
+    static constexpr size_t RING_SIZE = 8;  // more than frames in flight, so frames don't stay in caches between reads
+
+    std::vector<cv::Mat> frames;
+    const double captureFps;
+    const size_t readLengthLimit;
+    size_t framesRead;
+
+public:
+    SyntheticCapture(cv::Size size, double fps, size_t readLengthLimit)
+            : ImagesCapture{true}, frames{makeSyntheticFrames(size, RING_SIZE)}, captureFps{fps},
+            readLengthLimit{readLengthLimit}, framesRead{0} {}
+
+    double fps() const override {return captureFps;}
+
+    cv::Mat read() override {
+        if (framesRead == readLengthLimit) return cv::Mat{};
+        return frames[framesRead++ % frames.size()];
+    }
+};
+
 class DirReader : public ImagesCapture {
     std::vector<std::string> names;
     size_t fileId;
     size_t nextImgId;
-    const size_t initialImageId;
+    size_t firstFileId;  // Index of the first image to read (and to restart from if looping)
     const size_t readLengthLimit;
     const std::string input;
+    const cv::Size decodeSizeHint;
+    int reduceFactor;
+    // Images are pinned in the cache in reading order until it's full. Unlike LRU it keeps the cache useful when
+    // looping over a directory which doesn't fit: LRU would evict every image just before it's needed again.
+    std::vector<cv::Mat> decodedImages;
+    std::vector<bool> isUnreadable;
+    size_t cacheBytesLeft;
+
+    cv::Mat readImage(size_t id) {
+        if (decodedImages.empty()) return imreadForSize(input + '/' + names[id], decodeSizeHint, reduceFactor);
+        if (decodedImages[id].data) return decodedImages[id];
+        if (isUnreadable[id]) return cv::Mat{};
+        cv::Mat img = imreadForSize(input + '/' + names[id], decodeSizeHint, reduceFactor);
+        if (!img.data) {
+            isUnreadable[id] = true;
+        } else if (img.total() * img.elemSize() <= cacheBytesLeft) {
+            cacheBytesLeft -= img.total() * img.elemSize();
+            decodedImages[id] = img;
+        }
+        return img;
+    }
 
 public:
-    DirReader(const std::string &input, bool loop, size_t initialImageId, size_t readLengthLimit) : ImagesCapture{loop},
-            fileId{0}, nextImgId{0}, initialImageId{initialImageId}, readLengthLimit{readLengthLimit}, input{input} {
+    DirReader(const std::string &input, bool loop, size_t initialImageId, size_t readLengthLimit,
+                size_t decodedCacheSize, cv::Size decodeSizeHint)
+            : ImagesCapture{loop}, fileId{0}, nextImgId{0}, firstFileId{0}, readLengthLimit{readLengthLimit},
+            input{input}, decodeSizeHint{decodeSizeHint}, reduceFactor{1}, cacheBytesLeft{decodedCacheSize} {
         DIR *dir = opendir(input.c_str());
         if (!dir) throw InvalidInput{};
         while (struct dirent *ent = readdir(dir))
@@ -59,12 +146,20 @@ public:
         closedir(dir);
         if (names.empty()) throw InvalidInput{};
         sort(names.begin(), names.end());
-        size_t readImgs = 0;
+        if (decodedCacheSize != 0) {
+            decodedImages.resize(names.size());
+            isUnreadable.resize(names.size(), false);
+        }
+        // Images before initialImageId are skipped checking their headers only, without decoding
+        size_t skippedImgs = 0;
+        while (fileId < names.size() && skippedImgs < initialImageId) {
+            if (cv::haveImageReader(input + '/' + names[fileId])) ++skippedImgs;
+            ++fileId;
+        }
         while (fileId < names.size()) {
-            cv::Mat img = cv::imread(input + '/' + names[fileId]);
-            if (img.data) {
-                ++readImgs;
-                if (readImgs - 1 >= initialImageId) return;
+            if (readImage(fileId).data) {
+                firstFileId = fileId;
+                return;
             }
             ++fileId;
         }
@@ -75,7 +170,7 @@ public:
 
     cv::Mat read() override {
         while (fileId < names.size() && nextImgId < readLengthLimit) {
-            cv::Mat img = cv::imread(input + '/' + names[fileId]);
+            cv::Mat img = readImage(fileId);
             ++fileId;
             if (img.data) {
                 ++nextImgId;
@@ -83,17 +178,13 @@ public:
             }
         }
         if (loop) {
-            fileId = 0;
-            size_t readImgs = 0;
+            fileId = firstFileId;
             while (fileId < names.size()) {
-                cv::Mat img = cv::imread(input + '/' + names[fileId]);
+                cv::Mat img = readImage(fileId);
                 ++fileId;
                 if (img.data) {
-                    ++readImgs;
-                    if (readImgs - 1 >= initialImageId) {
-                        nextImgId = 1;
-                        return img;
-                    }
+                    nextImgId = 1;
+                    return img;
                 }
             }
         }
@@ -102,75 +193,487 @@ public:
 };
 
 class VideoCapWrapper : public ImagesCapture {
-    cv::VideoCapture cap;
+    std::unique_ptr<cv::VideoCapture> cap;
+    // Another capture of a looped file, positioned at initialImageId in background for the next loop
+    std::unique_ptr<cv::VideoCapture> spareCap;
+    std::future<bool> spareReady;
+    bool isCameraInput;
     size_t nextImgId;
     const double initialImageId;
     size_t readLengthLimit;
+    const std::string input;
+    const VideoDecodeMode decodeMode;
+
+    bool openFile(cv::VideoCapture &capture) {
+        switch (decodeMode) {
+        case VideoDecodeMode::Hardware:
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 \
+        || (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)))
+            // Backend falls back to software decoding itself if there's no acceleration for the stream
+            return capture.open(input, cv::CAP_ANY, {cv::CAP_PROP_HW_ACCELERATION, cv::VIDEO_ACCELERATION_ANY});
+#else
+            throw std::runtime_error{"Hardware accelerated decoding requires OpenCV 4.5.2 or later"};
+#endif
+        case VideoDecodeMode::HardwareNV12: {
+            // decodebin selects VA-API or oneVPL (MSDK) decoder if GStreamer plugins for them are installed.
+            // videoconvert does nothing if the decoder produces NV12 already.
+            std::string source = input.find("://") != std::string::npos ? "uridecodebin uri=" + input
+                : "filesrc location=\"" + input + "\" ! decodebin";
+            return capture.open(source + " ! videoconvert ! video/x-raw,format=NV12 ! appsink sync=false",
+                cv::CAP_GSTREAMER);
+        }
+        default:
+            return capture.open(input);
+        }
+    }
+
+    bool rewind(cv::VideoCapture &capture) {
+        if (capture.set(cv::CAP_PROP_POS_FRAMES, initialImageId)) return true;
+        // GStreamer pipelines may not support seeking, they are reopened then
+        if (decodeMode != VideoDecodeMode::HardwareNV12 || !openFile(capture)) return false;
+        for (size_t i = 0; i < static_cast<size_t>(initialImageId); ++i) {
+            if (!capture.grab()) return false;
+        }
+        return true;
+    }
+
+    void prepareSpare() {
+        spareReady = std::async(std::launch::async, [this] {
+            return (spareCap->isOpened() || openFile(*spareCap)) && rewind(*spareCap);
+        });
+    }
+
+    // Seeking decodes the file from the previous keyframe or even from the beginning with many containers,
+    // which stalls every loop for up to seconds. The spare capture is switched to instead, it's usually
+    // positioned by then, and the finished capture becomes the spare one for the next loop
+    bool restart() {
+        if (spareReady.valid() && spareReady.get()) {
+            std::swap(cap, spareCap);
+            prepareSpare();
+            return true;
+        }
+        return rewind(*cap);
+    }
 
 public:
     VideoCapWrapper(const std::string &input, bool loop, size_t initialImageId, size_t readLengthLimit,
-                cv::Size cameraResolution)
-            : ImagesCapture{loop}, nextImgId{0}, initialImageId{static_cast<double>(initialImageId)} {
+                cv::Size cameraResolution, VideoDecodeMode decodeMode)
+            : ImagesCapture{loop}, cap{new cv::VideoCapture}, isCameraInput{false}, nextImgId{0},
+            initialImageId{static_cast<double>(initialImageId)}, input{input}, decodeMode{decodeMode} {
 
         try {
-            if (cap.open(std::stoi(input))) {
+            if (cap->open(std::stoi(input))) {
+                isCameraInput = true;
                 this->readLengthLimit = loop ? std::numeric_limits<size_t>::max() : readLengthLimit;
-                cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
-                cap.set(cv::CAP_PROP_FRAME_WIDTH, cameraResolution.width);
-                cap.set(cv::CAP_PROP_FRAME_HEIGHT, cameraResolution.height);
-                cap.set(cv::CAP_PROP_AUTOFOCUS, true);
-                cap.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
+                cap->set(cv::CAP_PROP_BUFFERSIZE, 1);
+                cap->set(cv::CAP_PROP_FRAME_WIDTH, cameraResolution.width);
+                cap->set(cv::CAP_PROP_FRAME_HEIGHT, cameraResolution.height);
+                cap->set(cv::CAP_PROP_AUTOFOCUS, true);
+                cap->set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
                 return;
             }
         }
         catch (const std::invalid_argument&) {} // If stoi conversion failed, let's try another way to open capture device
         catch (const std::out_of_range&) {}
 
-        if (cap.open(input)) {
+        if (openFile(*cap)) {
             this->readLengthLimit = readLengthLimit;
-            if (!cap.set(cv::CAP_PROP_POS_FRAMES, this->initialImageId))
+            if (!rewind(*cap))
                 throw std::runtime_error{"Can't set the frame to begin with"};
+            if (loop) {
+                spareCap.reset(new cv::VideoCapture);
+                prepareSpare();
+            }
             return;
         }
+        if (decodeMode == VideoDecodeMode::HardwareNV12 && cap->open(input))
+            throw std::runtime_error{"Can't decode " + input + " to NV12 with GStreamer"};
 
         throw InvalidInput{};
     }
 
-    double fps() const override {return cap.get(cv::CAP_PROP_FPS);}
+    ~VideoCapWrapper() override {
+        if (spareReady.valid()) spareReady.wait();  // The spare capture is positioned using the members
+    }
+
+    double fps() const override {return cap->get(cv::CAP_PROP_FPS);}
+
+    bool isCamera() const {return isCameraInput;}
 
     cv::Mat read() override {
+        cv::Mat img;
+        readInto(img);
+        return img;
+    }
+
+    bool readInto(cv::Mat &img) override {
+        if (!img.allocator) {
+            img.allocator = getFrameAllocator();  // Backends copying the frame to img keep it continuous and aligned
+        }
         if (nextImgId >= readLengthLimit) {
-            if (loop && cap.set(cv::CAP_PROP_POS_FRAMES, initialImageId)) {
+            if (loop && restart()) {
                 nextImgId = 1;
-                cv::Mat img;
-                cap.read(img);
-                return img;
+                return cap->read(img);
             }
-            return cv::Mat{};
+            img.release();
+            return false;
         }
-        cv::Mat img;
-        if (!cap.read(img) && loop && cap.set(cv::CAP_PROP_POS_FRAMES, initialImageId)) {
+        if (!cap->read(img) && loop && restart()) {
             nextImgId = 1;
-            cap.read(img);
+            cap->read(img);
         } else {
             ++nextImgId;
         }
+        return img.data != nullptr;
+    }
+};
+
+// Decodes images of the source capture in a background thread into a ring of frames. Frame buffer is reused
+// for next images only after the caller releases the frame returned by read(), otherwise new buffer is allocated.
+class PrefetchingCapture : public ImagesCapture {
+    std::unique_ptr<ImagesCapture> source;
+    const double sourceFps;
+    std::vector<cv::Mat> ring;
+    size_t head;
+    size_t count;
+    bool isSourceFinished;
+    bool isStopping;
+    std::exception_ptr decodeException;
+    std::mutex mtx;
+    std::condition_variable condVar;
+    std::thread decodeThread;
+
+    void decodeLoop() {
+        try {
+            for (;;) {
+                size_t slotId;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    condVar.wait(lock, [&] {return isStopping || count < ring.size();});
+                    if (isStopping) return;
+                    slotId = (head + count) % ring.size();
+                }
+                cv::Mat &slot = ring[slotId];
+                if (slot.u && CV_XADD(&slot.u->refcount, 0) > 1) {
+                    slot.release();  // Previous frame in this slot is still used by the caller
+                }
+                bool isRead = source->readInto(slot);
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (isRead) {
+                        ++count;
+                    } else {
+                        isSourceFinished = true;
+                    }
+                }
+                condVar.notify_all();
+                if (!isRead) return;
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                decodeException = std::current_exception();
+                isSourceFinished = true;
+            }
+            condVar.notify_all();
+        }
+    }
+
+public:
+    PrefetchingCapture(std::unique_ptr<ImagesCapture> &&source, size_t prefetchSize) : ImagesCapture{source->loop},
+            source{std::move(source)}, sourceFps{this->source->fps()}, ring(prefetchSize), head{0}, count{0},
+            isSourceFinished{false}, isStopping{false} {
+        decodeThread = std::thread(&PrefetchingCapture::decodeLoop, this);
+    }
+
+    ~PrefetchingCapture() override {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            isStopping = true;
+        }
+        condVar.notify_all();
+        decodeThread.join();
+    }
+
+    double fps() const override {return sourceFps;}
+
+    cv::Mat read() override {
+        cv::Mat img;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            condVar.wait(lock, [&] {return count > 0 || isSourceFinished;});
+            if (count == 0) {
+                if (decodeException) std::rethrow_exception(decodeException);
+                return cv::Mat{};
+            }
+            img = ring[head];
+            head = (head + 1) % ring.size();
+            --count;
+        }
+        condVar.notify_all();
         return img;
     }
 };
 
+// Live network streams are grabbed by a background thread all the time and only the most recent frame is kept.
+// Reading them synchronously lets the buffers of the backend fill up whenever inference is slower than the stream,
+// so the results lag further and further behind. A failed stream is reopened by the thread, read() waits for
+// the first frame after the reconnection meanwhile
+class LatestFrameCapture : public ImagesCapture {
+    const std::function<std::unique_ptr<ImagesCapture>()> openStream;
+    const double streamFps;
+    const size_t readLengthLimit;
+    size_t readCount;
+    cv::Mat latest;
+    std::chrono::steady_clock::time_point latestTime;
+    std::chrono::steady_clock::time_point lastFrameTime;  // of the frame returned by read()
+    bool isFresh;  // latest wasn't returned yet
+    bool isStopping;
+    std::mutex mtx;
+    std::condition_variable condVar;
+    std::thread grabThread;
+
+    void grabLoop(std::unique_ptr<ImagesCapture> stream) {
+        cv::Mat frame;
+        for (;;) {
+            if (!stream) {
+                try {
+                    stream = openStream();
+                } catch (...) {}
+                if (!stream) {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    if (condVar.wait_for(lock, std::chrono::seconds(1), [&] {return isStopping;})) return;
+                    continue;
+                }
+            }
+            if (frame.u && CV_XADD(&frame.u->refcount, 0) > 1) {
+                frame.release();  // It's the frame returned before, still used by the caller
+            }
+            if (!stream->readInto(frame)) {
+                stream.reset();
+                continue;
+            }
+            auto frameTime = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (isStopping) return;
+                std::swap(latest, frame);
+                latestTime = frameTime;
+                isFresh = true;
+            }
+            condVar.notify_all();
+        }
+    }
+
+public:
+    // stream is the first opened stream, openStream reopens it
+    LatestFrameCapture(std::unique_ptr<ImagesCapture> &&stream,
+            std::function<std::unique_ptr<ImagesCapture>()> openStream, size_t readLengthLimit)
+            : ImagesCapture{false}, openStream{std::move(openStream)}, streamFps{stream->fps()},
+            readLengthLimit{readLengthLimit}, readCount{0}, isFresh{false}, isStopping{false} {
+        grabThread = std::thread(&LatestFrameCapture::grabLoop, this, std::move(stream));
+    }
+
+    ~LatestFrameCapture() override {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            isStopping = true;
+        }
+        condVar.notify_all();
+        grabThread.join();
+    }
+
+    double fps() const override {return streamFps;}
+
+    cv::Mat read() override {
+        if (readCount >= readLengthLimit) return cv::Mat{};
+        std::unique_lock<std::mutex> lock(mtx);
+        condVar.wait(lock, [&] {return isFresh;});
+        isFresh = false;
+        ++readCount;
+        lastFrameTime = latestTime;
+        return latest;
+    }
+
+    std::chrono::steady_clock::time_point getLastFrameTime() const override {return lastFrameTime;}
+};
+
+bool isLiveStream(const std::string &input) {
+    for (const char *scheme : {"rtsp://", "rtsps://", "rtmp://", "udp://", "tcp://", "srt://"}) {
+        if (input.compare(0, strlen(scheme), scheme) == 0) return true;
+    }
+    return false;
+}
+
+bool parseSyntheticInput(const std::string &input, cv::Size &size, double &fps) {
+    const std::string prefix = "synthetic:";
+    if (input.compare(0, prefix.size(), prefix) != 0) return false;
+    int width = 0, height = 0;
+    char separator = '\0';
+    fps = 30.0;
+    std::istringstream stream{input.substr(prefix.size())};
+    if (!(stream >> width) || stream.get() != 'x' || !(stream >> height) || width <= 0 || height <= 0
+            || (stream.get(separator) && (separator != '@' || !(stream >> fps) || fps <= 0 || stream.peek() != EOF))) {
+        throw std::runtime_error{"Synthetic input should be synthetic:WxH[@fps], got " + input};
+    }
+    size = {width, height};
+    return true;
+}
+
+std::vector<cv::Mat> makeSyntheticFrames(cv::Size size, size_t count) {
+    std::vector<cv::Mat> frames(count);
+    cv::RNG rng{0x5eed};  // the same frames every run
+    for (cv::Mat &frame : frames) {
+        frame.allocator = getFrameAllocator();
+        frame.create(size, CV_8UC3);
+        rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+    }
+    return frames;
+}
+
 std::unique_ptr<ImagesCapture> openImagesCapture(const std::string &input, bool loop, size_t initialImageId,
-        size_t readLengthLimit, cv::Size cameraResolution) {
+        size_t readLengthLimit, cv::Size cameraResolution, size_t prefetchSize, size_t decodedCacheSize,
+        VideoDecodeMode decodeMode, cv::Size decodeSizeHint) {
     if (readLengthLimit == 0) throw std::runtime_error{"Read length limit must be positive"};
+    cv::Size syntheticSize;
+    double syntheticFps;
+    if (parseSyntheticInput(input, syntheticSize, syntheticFps)) {
+        return std::unique_ptr<ImagesCapture>(new SyntheticCapture{syntheticSize, syntheticFps, readLengthLimit});
+    }
     try {
-        return std::unique_ptr<ImagesCapture>(new ImreadWrapper{input, loop});
+        return std::unique_ptr<ImagesCapture>(new ImreadWrapper{input, loop, decodedCacheSize != 0,
+            decodeSizeHint});
     } catch (const InvalidInput &) {}
     try {
-        return std::unique_ptr<ImagesCapture>(new DirReader{input, loop, initialImageId, readLengthLimit});
+        std::unique_ptr<ImagesCapture> reader{new DirReader{input, loop, initialImageId, readLengthLimit,
+            decodedCacheSize, decodeSizeHint}};
+        if (prefetchSize == 0) return reader;
+        return std::unique_ptr<ImagesCapture>(new PrefetchingCapture{std::move(reader), prefetchSize});
     } catch (const InvalidInput &) {}
+    if (isLiveStream(input)) {
+        auto openStream = [input, cameraResolution, decodeMode] {
+            return std::unique_ptr<ImagesCapture>(new VideoCapWrapper{input, false, 0,
+                std::numeric_limits<size_t>::max(), cameraResolution, decodeMode});
+        };
+        try {
+            return std::unique_ptr<ImagesCapture>(new LatestFrameCapture{openStream(), openStream, readLengthLimit});
+        } catch (const InvalidInput &) {}
+        throw std::runtime_error{"Can't read " + input};
+    }
     try {
-        return std::unique_ptr<ImagesCapture>(new VideoCapWrapper{input, loop, initialImageId, readLengthLimit,
-            cameraResolution});
+        std::unique_ptr<VideoCapWrapper> videoCap{new VideoCapWrapper{input, loop, initialImageId, readLengthLimit,
+            cameraResolution, decodeMode}};
+        if (prefetchSize == 0 || videoCap->isCamera()) return std::unique_ptr<ImagesCapture>(videoCap.release());
+        return std::unique_ptr<ImagesCapture>(new PrefetchingCapture{std::unique_ptr<ImagesCapture>(videoCap.release()),
+            prefetchSize});
     } catch (const InvalidInput &) {}
     throw std::runtime_error{"Can't read " + input};
 }
+
+MultiSourceCapture::MultiSourceCapture(std::vector<std::unique_ptr<ImagesCapture>> &&captures) :
+        ImagesCapture{false}, sources(captures.size()) {
+    if (captures.empty()) throw std::invalid_argument{"MultiSourceCapture needs at least one input"};
+    for (size_t i = 0; i < captures.size(); ++i) {
+        sources[i].capture = std::move(captures[i]);
+    }
+    // Threads are started when the vector won't be reallocated anymore
+    for (Source &source : sources) {
+        source.thread = std::thread(&MultiSourceCapture::readLoop, this, std::ref(source));
+    }
+}
+
+MultiSourceCapture::~MultiSourceCapture() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        isStopping = true;
+    }
+    condVar.notify_all();
+    for (Source &source : sources) {
+        source.thread.join();
+    }
+}
+
+void MultiSourceCapture::readLoop(Source &source) {
+    try {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                condVar.wait(lock, [&] {return isStopping || !source.frame.data;});
+                if (isStopping) return;
+            }
+            auto readTime = std::chrono::steady_clock::now();
+            cv::Mat frame = source.capture->read();
+            auto frameTime = source.capture->getLastFrameTime();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (frame.data) {
+                    source.frame = frame;
+                    source.frameTime = frameTime != std::chrono::steady_clock::time_point{} ? frameTime : readTime;
+                } else {
+                    source.isFinished = true;
+                }
+            }
+            condVar.notify_all();
+            if (!frame.data) return;
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!readException) readException = std::current_exception();
+            source.isFinished = true;
+        }
+        condVar.notify_all();
+    }
+}
+
+double MultiSourceCapture::fps() const {
+    return sources.front().capture->fps();
+}
+
+cv::Mat MultiSourceCapture::read() {
+    size_t sourceId;
+    return readFrom(sourceId);
+}
+
+cv::Mat MultiSourceCapture::readFrom(size_t &sourceId) {
+    cv::Mat frame;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        bool isOver = false;
+        condVar.wait(lock, [&] {
+            if (readException) return true;
+            isOver = true;
+            for (size_t i = 0; i < sources.size(); ++i) {
+                size_t id = (nextSourceId + i) % sources.size();
+                if (sources[id].frame.data) {
+                    sourceId = id;
+                    isOver = false;
+                    return true;
+                }
+                isOver = isOver && sources[id].isFinished;
+            }
+            return isOver;
+        });
+        if (readException) std::rethrow_exception(readException);
+        if (isOver) return cv::Mat{};
+        frame = sources[sourceId].frame;
+        lastFrameTime = sources[sourceId].frameTime;
+        sources[sourceId].frame.release();
+        nextSourceId = (sourceId + 1) % sources.size();
+    }
+    condVar.notify_all();
+    return frame;
+}
+
+std::unique_ptr<MultiSourceCapture> openMultiSourceCapture(const std::string &inputs, bool loop,
+        size_t readLengthLimit) {
+    std::vector<std::unique_ptr<ImagesCapture>> captures;
+    size_t begin = 0;
+    for (;;) {
+        size_t end = inputs.find(',', begin);
+        captures.push_back(openImagesCapture(inputs.substr(begin, end - begin), loop, 0, readLengthLimit));
+        if (end == std::string::npos) break;
+        begin = end + 1;
+    }
+    return std::unique_ptr<MultiSourceCapture>(new MultiSourceCapture{std::move(captures)});
+}
@@ -0,0 +1,173 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/instance_masks.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Source samples of the destination pixels when stretching srcSize pixels to dstSize ones: a pixel is interpolated
+// between the source pixels first and second with the weight of the second one. Matches cv::resize INTER_LINEAR
+struct LinearSamples {
+    std::vector<int> first;
+    std::vector<int> second;
+    std::vector<float> weights;
+};
+
+LinearSamples getLinearSamples(int srcSize, int dstSize) {
+    LinearSamples samples;
+    samples.first.resize(dstSize);
+    samples.second.resize(dstSize);
+    samples.weights.resize(dstSize);
+    const float scale = static_cast<float>(srcSize) / dstSize;
+    for (int i = 0; i < dstSize; i++) {
+        const float position = (i + 0.5f) * scale - 0.5f;
+        int first = static_cast<int>(std::floor(position));
+        float weight = position - first;
+        if (first < 0) {
+            first = 0;
+            weight = 0;
+        }
+        if (first >= srcSize - 1) {
+            first = srcSize - 1;
+            weight = 0;
+        }
+        samples.first[i] = first;
+        samples.second[i] = std::min(first + 1, srcSize - 1);
+        samples.weights[i] = weight;
+    }
+    return samples;
+}
+
+// Mask probability of the pixel x of the box row interpolated between mask rows row0 and row1
+inline float sampleMask(const float* row0, const float* row1, float rowWeight, const LinearSamples& cols, int x) {
+    const int col0 = cols.first[x];
+    const int col1 = cols.second[x];
+    const float top = row0[col0] + (row0[col1] - row0[col0]) * cols.weights[x];
+    const float bottom = row1[col0] + (row1[col1] - row1[col0]) * cols.weights[x];
+    return top + (bottom - top) * rowWeight;
+}
+
+struct InstanceSamples {
+    LinearSamples rows;
+    LinearSamples cols;
+    float weightedColor[3];
+};
+}  // namespace
+
+void blendInstanceMasks(cv::Mat& image, const std::vector<InstanceMask>& instances, float maskThreshold, float alpha) {
+    CV_Assert(CV_8UC3 == image.type());
+    if (instances.empty()) {
+        return;
+    }
+    std::vector<InstanceSamples> samples(instances.size());
+    int minY = image.rows, maxY = 0;
+    for (size_t i = 0; i < instances.size(); i++) {
+        const InstanceMask& instance = instances[i];
+        CV_Assert(CV_32FC1 == instance.mask.type() && !instance.mask.empty());
+        CV_Assert((instance.box & cv::Rect(0, 0, image.cols, image.rows)) == instance.box);
+        samples[i].rows = getLinearSamples(instance.mask.rows, instance.box.height);
+        samples[i].cols = getLinearSamples(instance.mask.cols, instance.box.width);
+        for (int c = 0; c < 3; c++) {
+            samples[i].weightedColor[c] = instance.color[c] * alpha;
+        }
+        minY = std::min(minY, instance.box.y);
+        maxY = std::max(maxY, instance.box.y + instance.box.height);
+    }
+
+    const float imageWeight = 1.f - alpha;
+    cv::parallel_for_(cv::Range(minY, std::max(minY, maxY)), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            cv::Vec3b* imageRow = image.ptr<cv::Vec3b>(y);
+            for (size_t i = 0; i < instances.size(); i++) {
+                const cv::Rect& box = instances[i].box;
+                if (y < box.y || y >= box.y + box.height) {
+                    continue;
+                }
+                const InstanceSamples& instanceSamples = samples[i];
+                const int boxRow = y - box.y;
+                const float* maskRow0 = instances[i].mask.ptr<float>(instanceSamples.rows.first[boxRow]);
+                const float* maskRow1 = instances[i].mask.ptr<float>(instanceSamples.rows.second[boxRow]);
+                const float rowWeight = instanceSamples.rows.weights[boxRow];
+                const LinearSamples& cols = instanceSamples.cols;
+                cv::Vec3b* pixels = imageRow + box.x;
+                for (int x = 0; x < box.width; x++) {
+                    if (sampleMask(maskRow0, maskRow1, rowWeight, cols, x) > maskThreshold) {
+                        for (int c = 0; c < 3; c++) {
+                            pixels[x][c] = cv::saturate_cast<uchar>(
+                                instanceSamples.weightedColor[c] + pixels[x][c] * imageWeight);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+void encodeInstanceMask(const cv::Mat& mask, cv::Size boxSize, float maskThreshold, std::vector<uint32_t>& runs) {
+    CV_Assert(CV_32FC1 == mask.type() && !mask.empty());
+    runs.clear();
+    if (boxSize.area() <= 0) {
+        return;
+    }
+    const LinearSamples rows = getLinearSamples(mask.rows, boxSize.height);
+    const LinearSamples cols = getLinearSamples(mask.cols, boxSize.width);
+    bool isInstanceRun = false;
+    uint32_t runLength = 0;
+    for (int y = 0; y < boxSize.height; y++) {
+        const float* maskRow0 = mask.ptr<float>(rows.first[y]);
+        const float* maskRow1 = mask.ptr<float>(rows.second[y]);
+        for (int x = 0; x < boxSize.width; x++) {
+            const bool isInstance = sampleMask(maskRow0, maskRow1, rows.weights[y], cols, x) > maskThreshold;
+            if (isInstance != isInstanceRun) {
+                runs.push_back(runLength);
+                isInstanceRun = isInstance;
+                runLength = 0;
+            }
+            runLength++;
+        }
+    }
+    runs.push_back(runLength);
+}
+
+void blendEncodedInstanceMask(cv::Mat& image, const cv::Rect& box, const std::vector<uint32_t>& runs,
+                              const cv::Vec3b& color, float alpha) {
+    CV_Assert(CV_8UC3 == image.type());
+    CV_Assert((box & cv::Rect(0, 0, image.cols, image.rows)) == box);
+    float weightedColor[3];
+    for (int c = 0; c < 3; c++) {
+        weightedColor[c] = color[c] * alpha;
+    }
+    const float imageWeight = 1.f - alpha;
+    int x = 0, y = 0;
+    for (size_t i = 0; i < runs.size(); i++) {
+        uint32_t runLength = runs[i];
+        if (i % 2 == 0) {
+            // Background run: only the position is advanced
+            x += static_cast<int>(runLength % box.width);
+            y += static_cast<int>(runLength / box.width);
+            if (x >= box.width) {
+                x -= box.width;
+                y++;
+            }
+            continue;
+        }
+        while (runLength > 0 && y < box.height) {
+            const int length = std::min(static_cast<int>(runLength), box.width - x);
+            cv::Vec3b* pixels = image.ptr<cv::Vec3b>(box.y + y) + box.x + x;
+            for (int j = 0; j < length; j++) {
+                for (int c = 0; c < 3; c++) {
+                    pixels[j][c] = cv::saturate_cast<uchar>(weightedColor[c] + pixels[j][c] * imageWeight);
+                }
+            }
+            runLength -= length;
+            x += length;
+            if (x == box.width) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sumUs.store(0, std::memory_order_relaxed);
+    maxUs.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::getBucketIndex(uint64_t valueUs) {
+    if (valueUs < SUB_BUCKETS_COUNT) {
+        return static_cast<int>(valueUs);
+    }
+    // shift is chosen so (valueUs >> shift) is in range [SUB_BUCKETS_COUNT, 2 * SUB_BUCKETS_COUNT)
+    int shift = 0;
+    while ((valueUs >> (shift + SUB_BUCKETS_BITS + 1)) != 0) {
+        shift++;
+    }
+    int index = (shift + 1) * SUB_BUCKETS_COUNT + static_cast<int>((valueUs >> shift) - SUB_BUCKETS_COUNT);
+    return std::min(index, BUCKETS_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::getBucketLowerBound(int index) {
+    if (index < SUB_BUCKETS_COUNT) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / SUB_BUCKETS_COUNT - 1;
+    return static_cast<uint64_t>(index % SUB_BUCKETS_COUNT + SUB_BUCKETS_COUNT) << shift;
+}
+
+void LatencyHistogram::record(Duration duration) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    uint64_t valueUs = us > 0 ? static_cast<uint64_t>(us) : 0;
+
+    buckets[getBucketIndex(valueUs)].fetch_add(1, std::memory_order_relaxed);
+    sumUs.fetch_add(valueUs, std::memory_order_relaxed);
+    uint64_t currentMax = maxUs.load(std::memory_order_relaxed);
+    while (valueUs > currentMax && !maxUs.compare_exchange_weak(currentMax, valueUs, std::memory_order_relaxed)) {}
+    // count is incremented last, so readers never see more values counted than recorded in buckets
+    count.fetch_add(1, std::memory_order_release);
+}
+
+double LatencyHistogram::getPercentile(double percentile) const {
+    uint64_t total = count.load(std::memory_order_acquire);
+    if (total == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::max(0.0, std::min(percentile, 100.0)) / 100 * total));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t accumulated = 0;
+    for (int i = 0; i < BUCKETS_COUNT; i++) {
+        accumulated += buckets[i].load(std::memory_order_relaxed);
+        if (accumulated >= rank) {
+            // Middle of the bucket is reported, but not more than actual maximum
+            double lower = static_cast<double>(getBucketLowerBound(i));
+            double upper = i + 1 < BUCKETS_COUNT ? static_cast<double>(getBucketLowerBound(i + 1)) : lower;
+            return std::min((lower + upper) / 2, static_cast<double>(maxUs.load(std::memory_order_relaxed))) / 1000;
+        }
+    }
+    return getMax();
+}
+
+double LatencyHistogram::getMean() const {
+    uint64_t total = count.load(std::memory_order_acquire);
+    return total != 0 ? static_cast<double>(sumUs.load(std::memory_order_relaxed)) / total / 1000
+                      : std::numeric_limits<double>::quiet_NaN();
+}
+
+double LatencyHistogram::getMax() const {
+    return count.load(std::memory_order_acquire) != 0
+           ? static_cast<double>(maxUs.load(std::memory_order_relaxed)) / 1000
+           : std::numeric_limits<double>::quiet_NaN();
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/motion_gate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <opencv2/imgproc.hpp>
+
+MotionGate::MotionGate(double threshold, cv::Size gridSize, int downscaledWidth)
+    : threshold{threshold}, gridSize{gridSize}, downscaledWidth{downscaledWidth} {}
+
+bool MotionGate::update(const cv::Mat& frame) {
+    // INTER_AREA averages the pixels, so the sensor noise is suppressed too
+    const double scale = std::min(1.0, static_cast<double>(downscaledWidth) / frame.cols);
+    cv::resize(frame, downscaled, cv::Size(), scale, scale, cv::INTER_AREA);
+    if (downscaled.channels() == 3) {
+        cv::cvtColor(downscaled, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        downscaled.copyTo(gray);
+    }
+
+    const cv::Rect frameRect{cv::Point(), frame.size()};
+    if (reference.size() != gray.size()) {
+        std::swap(reference, gray);
+        changedRegion = frameRect;
+        return true;
+    }
+
+    // Both are vectorized by OpenCV, the blocks are averaged by the second resize
+    cv::absdiff(gray, reference, diff);
+    cv::resize(diff, blocks, gridSize, 0, 0, cv::INTER_AREA);
+    cv::Rect changedBlocks;
+    for (int y = 0; y < blocks.rows; y++) {
+        const uchar* row = blocks.ptr<uchar>(y);
+        for (int x = 0; x < blocks.cols; x++) {
+            if (row[x] > threshold) {
+                changedBlocks |= cv::Rect(x, y, 1, 1);
+            }
+        }
+    }
+    if (changedBlocks.empty()) {
+        return false;
+    }
+
+    std::swap(reference, gray);
+    const double blockWidth = static_cast<double>(frame.cols) / gridSize.width;
+    const double blockHeight = static_cast<double>(frame.rows) / gridSize.height;
+    changedRegion = cv::Rect(
+        cv::Point(static_cast<int>(changedBlocks.x * blockWidth), static_cast<int>(changedBlocks.y * blockHeight)),
+        cv::Point(static_cast<int>(std::ceil(changedBlocks.br().x * blockWidth)),
+                  static_cast<int>(std::ceil(changedBlocks.br().y * blockHeight)))) & frameRect;
+    return true;
+}
+
+MotionGatedCapture::MotionGatedCapture(std::unique_ptr<ImagesCapture>&& capture, double threshold)
+    : ImagesCapture{capture->loop}, capture{std::move(capture)}, gate{threshold},
+      maxSkipped{this->capture->fps() > 0 ? static_cast<size_t>(std::lround(this->capture->fps())) : 30} {}
+
+cv::Mat MotionGatedCapture::read() {
+    for (;;) {
+        cv::Mat frame = capture->read();
+        if (!frame.data || gate.update(frame) || skippedInRow >= maxSkipped) {
+            skippedInRow = 0;
+            return frame;
+        }
+        skippedInRow++;
+        skippedCount++;
+    }
+}
@@ -5,11 +5,15 @@
 #include "samples/performance_metrics.hpp"
 
 #include <limits>
+#include <stdexcept>
 
 // timeWindow defines the length of the timespan over which the 'current fps' value is calculated
 PerformanceMetrics::PerformanceMetrics(Duration timeWindow)
     : timeWindowSize(timeWindow)
     , firstFrameProcessed(false)
+    , creationTime(Clock::now())
+    , exportFormat(ExportFormat::Csv)
+    , exportPeriod(Duration::zero())
 {}
 
 void PerformanceMetrics::update(TimePoint lastRequestStartTime,
@@ -24,6 +28,7 @@ void PerformanceMetrics::update(TimePoint lastRequestStartTime,
 
 void PerformanceMetrics::update(TimePoint lastRequestStartTime) {
     TimePoint currentTime = Clock::now();
+    recordStage(Stage::EndToEnd, currentTime - lastRequestStartTime);
 
     if (!firstFrameProcessed) {
         lastUpdateTime = currentTime;
@@ -42,6 +47,12 @@ void PerformanceMetrics::update(TimePoint lastRequestStartTime) {
 
         lastUpdateTime = currentTime;
     }
+
+    if (!exportFileName.empty() && currentTime - lastExportTime >= exportPeriod) {
+        std::ofstream out(exportFileName, exportFormat == ExportFormat::Csv ? std::ios::app : std::ios::trunc);
+        exportStages(out, exportFormat);
+        lastExportTime = currentTime;
+    }
 }
 
 void PerformanceMetrics::paintMetrics(cv::Mat & frame, cv::Point position, double fontScale, cv::Scalar color, int thickness) const{
@@ -98,5 +109,101 @@ void PerformanceMetrics::printTotal() const {
 
     std::ostringstream out;
     out << "Latency: " << std::fixed << std::setprecision(1) << metrics.latency << " ms\nFPS: " << metrics.fps << '\n';
+    for (int i = 0; i < STAGES_COUNT; i++) {
+        const LatencyHistogram& histogram = stagesHistograms[i];
+        if (histogram.getCount() != 0) {
+            out << getStageName(static_cast<Stage>(i)) << ": p50 " << histogram.getPercentile(50)
+                << " ms, p90 " << histogram.getPercentile(90) << " ms, p99 " << histogram.getPercentile(99)
+                << " ms, max " << histogram.getMax() << " ms\n";
+        }
+    }
     std::cout << out.str();
 }
+
+const char* PerformanceMetrics::getStageName(Stage stage) {
+    switch (stage) {
+    case Stage::Decode: return "decode";
+    case Stage::CaptureWait: return "capture_wait";
+    case Stage::Preprocess: return "preprocess";
+    case Stage::QueueWait: return "queue_wait";
+    case Stage::Infer: return "infer";
+    case Stage::Postprocess: return "postprocess";
+    case Stage::Render: return "render";
+    case Stage::EndToEnd: return "end_to_end";
+    }
+    return "unknown";
+}
+
+void PerformanceMetrics::exportStages(std::ostream& out, ExportFormat format) const {
+    const double timestamp = std::chrono::duration_cast<Sec>(Clock::now() - creationTime).count();
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(3);
+    if (format == ExportFormat::Json) {
+        stream << "{\"time_s\": " << timestamp << ", \"stages\": {";
+    }
+
+    if (format == ExportFormat::Json) {
+        writeStagesJson(stream);
+        stream << "}}\n";
+    } else {
+        for (int i = 0; i < STAGES_COUNT; i++) {
+            const LatencyHistogram& histogram = stagesHistograms[i];
+            if (histogram.getCount() == 0) {
+                continue;
+            }
+            stream << timestamp << ',' << getStageName(static_cast<Stage>(i)) << ',' << histogram.getCount() << ','
+                   << histogram.getMean() << ',' << histogram.getPercentile(50) << ','
+                   << histogram.getPercentile(90) << ',' << histogram.getPercentile(99) << ','
+                   << histogram.getMax() << '\n';
+        }
+    }
+    out << stream.str();
+    out.flush();
+}
+
+void PerformanceMetrics::writeStagesJson(std::ostream& stream) const {
+    bool isFirst = true;
+    for (int i = 0; i < STAGES_COUNT; i++) {
+        const LatencyHistogram& histogram = stagesHistograms[i];
+        if (histogram.getCount() == 0) {
+            continue;
+        }
+        stream << (isFirst ? "" : ", ") << '"' << getStageName(static_cast<Stage>(i))
+               << "\": {\"count\": " << histogram.getCount()
+               << ", \"mean_ms\": " << histogram.getMean()
+               << ", \"p50_ms\": " << histogram.getPercentile(50)
+               << ", \"p90_ms\": " << histogram.getPercentile(90)
+               << ", \"p99_ms\": " << histogram.getPercentile(99)
+               << ", \"max_ms\": " << histogram.getMax() << '}';
+        isFirst = false;
+    }
+}
+
+void PerformanceMetrics::reportTotal(const std::string& format) const {
+    if (format != "json") {
+        throw std::invalid_argument("Unsupported performance report format: " + format);
+    }
+    Metrics metrics = getTotal();
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"perf_report\": {\"frames\": " << totalStatistic.frameCount
+           << ", \"latency_ms\": " << metrics.latency << ", \"fps\": " << metrics.fps << ", \"stages\": {";
+    writeStagesJson(stream);
+    stream << "}}}\n";
+    std::cout << stream.str();
+    std::cout.flush();
+}
+
+void PerformanceMetrics::enableStagesExport(const std::string& fileName, ExportFormat format, Duration period) {
+    std::ofstream out(fileName, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Can't open file " + fileName + " for stages statistics export");
+    }
+    if (format == ExportFormat::Csv) {
+        out << "time_s,stage,count,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n";
+    }
+    exportFileName = fileName;
+    exportFormat = format;
+    exportPeriod = period;
+    lastExportTime = Clock::now();
+}
@@ -0,0 +1,117 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/read_network.hpp"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// Private mapping of a whole file. Written pages are copied, so the weights can be changed by the reader if it needs
+// to without touching the file, while the pages which aren't written are shared with the other processes
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& fileName) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Can't open " + fileName);
+        }
+        LARGE_INTEGER fileSize;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        }
+        CloseHandle(file);
+        if (!mapping) {
+            throw std::runtime_error("Can't map " + fileName);
+        }
+        data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(mapping);  // the view keeps the mapping
+        if (!data) {
+            throw std::runtime_error("Can't map " + fileName);
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Can't open " + fileName);
+        }
+        struct stat fileStat;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            mapped = mmap(nullptr, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);  // the mapping keeps the file
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Can't map " + fileName);
+        }
+        data = mapped;
+        size = static_cast<size_t>(fileStat.st_size);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap(data, size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    void* data;
+    size_t size;
+};
+
+// The blob owns the mapping, so it's unmapped when the last reference to the weights is released
+class MappedWeightsBlob : public InferenceEngine::TBlob<uint8_t> {
+public:
+    explicit MappedWeightsBlob(std::unique_ptr<MappedFile> file) :
+        InferenceEngine::TBlob<uint8_t>(
+            InferenceEngine::TensorDesc(InferenceEngine::Precision::U8, {file->size}, InferenceEngine::Layout::C),
+            static_cast<uint8_t*>(file->data), file->size),
+        file(std::move(file)) {}
+
+private:
+    std::unique_ptr<MappedFile> file;
+};
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+}  // namespace
+
+InferenceEngine::CNNNetwork readNetwork(InferenceEngine::Core& core, const std::string& modelPath, bool mapWeights) {
+    if (!mapWeights || !endsWith(modelPath, ".xml")) {
+        return core.ReadNetwork(modelPath);
+    }
+    std::ifstream xmlFile(modelPath);
+    if (!xmlFile) {
+        throw std::runtime_error("Can't open " + modelPath);
+    }
+    std::stringstream xml;
+    xml << xmlFile.rdbuf();
+    const std::string binPath = modelPath.substr(0, modelPath.size() - 4) + ".bin";
+    InferenceEngine::Blob::CPtr weights = std::make_shared<MappedWeightsBlob>(
+        std::unique_ptr<MappedFile>(new MappedFile(binPath)));
+    return core.ReadNetwork(xml.str(), weights);
+}
@@ -0,0 +1,187 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/results_writer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+const char BINARY_MAGIC[] = "OMZRES01";
+
+void appendJsonString(std::string& out, const std::string& str) {
+    out += '"';
+    for (char c : str) {
+        if ('"' == c || '\\' == c) {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+            out += code;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+template <typename T>
+void appendBinary(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+}
+
+ResultsWriter::ResultsWriter(const std::string& fileName, Format format, size_t bufferSize, size_t buffersCount)
+    : format(format)
+    , bufferSize(std::max(bufferSize, size_t{1}))
+    , file(std::fopen(fileName.c_str(), "wb")) {
+    if (!file) {
+        throw std::runtime_error("Can't open results file " + fileName);
+    }
+    if (Format::Binary == format) {
+        std::fwrite(BINARY_MAGIC, 1, sizeof(BINARY_MAGIC) - 1, file);
+    }
+
+    // Records are appended while the buffer is smaller than bufferSize, so the last one may exceed it a bit
+    const size_t capacity = this->bufferSize + 512;
+    currentBuffer.reserve(capacity);
+    freeBuffers.resize(std::max(buffersCount, size_t{2}) - 1);
+    for (std::string& buffer : freeBuffers) {
+        buffer.reserve(capacity);
+    }
+    flushThread = std::thread(&ResultsWriter::flushLoop, this);
+}
+
+ResultsWriter::~ResultsWriter() {
+    try {
+        close();
+    } catch (...) {}  // a destructor mustn't throw, call close() explicitly to know if the file is complete
+}
+
+ResultsWriter::Format ResultsWriter::formatFromFileName(const std::string& fileName) {
+    const std::string binaryExtension = ".bin";
+    if (fileName.size() >= binaryExtension.size()
+            && 0 == fileName.compare(fileName.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension)) {
+        return Format::Binary;
+    }
+    return Format::Jsonl;
+}
+
+void ResultsWriter::write(const Record& record) {
+    std::unique_lock<std::mutex> lock(mtx);
+    append(record);
+    if (currentBuffer.size() >= bufferSize) {
+        submitBuffer(lock);
+    }
+}
+
+void ResultsWriter::write(const std::vector<Record>& records) {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (const Record& record : records) {
+        append(record);
+        if (currentBuffer.size() >= bufferSize) {
+            submitBuffer(lock);
+        }
+    }
+}
+
+void ResultsWriter::append(const Record& record) {
+    if (Format::Binary == format) {
+        appendBinary<uint32_t>(currentBuffer, record.stream);
+        appendBinary<int64_t>(currentBuffer, record.frame);
+        appendBinary<int32_t>(currentBuffer, record.id);
+        appendBinary<int32_t>(currentBuffer, record.label);
+        appendBinary<float>(currentBuffer, record.confidence);
+        appendBinary<float>(currentBuffer, record.box.x);
+        appendBinary<float>(currentBuffer, record.box.y);
+        appendBinary<float>(currentBuffer, record.box.width);
+        appendBinary<float>(currentBuffer, record.box.height);
+        const size_t textLength = std::min(record.text.size(), size_t{std::numeric_limits<uint16_t>::max()});
+        appendBinary<uint16_t>(currentBuffer, static_cast<uint16_t>(textLength));
+        currentBuffer.append(record.text, 0, textLength);
+        return;
+    }
+
+    char line[256];
+    int length = std::snprintf(line, sizeof(line), "{\"stream\": %u, \"frame\": %lld",
+        record.stream, static_cast<long long>(record.frame));
+    currentBuffer.append(line, length);
+    if (record.id >= 0) {
+        length = std::snprintf(line, sizeof(line), ", \"id\": %d", record.id);
+        currentBuffer.append(line, length);
+    }
+    length = std::snprintf(line, sizeof(line), ", \"label\": %d", record.label);
+    currentBuffer.append(line, length);
+    if (record.confidence >= 0) {
+        length = std::snprintf(line, sizeof(line), ", \"confidence\": %.4f", record.confidence);
+        currentBuffer.append(line, length);
+    }
+    length = std::snprintf(line, sizeof(line), ", \"box\": [%.6g, %.6g, %.6g, %.6g]",
+        record.box.x, record.box.y, record.box.width, record.box.height);
+    currentBuffer.append(line, length);
+    if (!record.text.empty()) {
+        currentBuffer += ", \"text\": ";
+        appendJsonString(currentBuffer, record.text);
+    }
+    currentBuffer += "}\n";
+}
+
+void ResultsWriter::submitBuffer(std::unique_lock<std::mutex>& lock) {
+    condVar.wait(lock, [&] { return !freeBuffers.empty() || hasWriteError; });
+    if (hasWriteError) {
+        // Nothing is written anymore, so the buffer is reused and the records are lost, close() reports the error
+        currentBuffer.clear();
+        return;
+    }
+    filledBuffers.push_back(std::move(currentBuffer));
+    currentBuffer = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    condVar.notify_all();
+}
+
+void ResultsWriter::flushLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        condVar.wait(lock, [&] { return !filledBuffers.empty() || isStopping; });
+        if (filledBuffers.empty()) {
+            return;
+        }
+        std::string buffer = std::move(filledBuffers.front());
+        filledBuffers.pop_front();
+
+        lock.unlock();
+        const bool isWritten = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        buffer.clear();
+        lock.lock();
+
+        hasWriteError = hasWriteError || !isWritten;
+        freeBuffers.push_back(std::move(buffer));
+        condVar.notify_all();
+    }
+}
+
+void ResultsWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file) {
+            return;
+        }
+        if (!currentBuffer.empty()) {
+            filledBuffers.push_back(std::move(currentBuffer));
+            currentBuffer.clear();
+        }
+        isStopping = true;
+    }
+    condVar.notify_all();
+    flushThread.join();
+
+    const bool isClosed = 0 == std::fclose(file);
+    file = nullptr;
+    if (hasWriteError || !isClosed) {
+        throw std::runtime_error("Failed to write results file");
+    }
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/thread_budget.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <opencv2/core.hpp>
+
+#include "samples/slog.hpp"
+
+namespace {
+const char CPU_THREADS_NUM_KEY[] = "CPU_THREADS_NUM";
+}  // namespace
+
+ThreadBudget& ThreadBudget::global() {
+    static ThreadBudget budget;
+    return budget;
+}
+
+ThreadBudget::ThreadBudget(unsigned totalThreads) :
+        totalThreads(totalThreads != 0 ? totalThreads : std::max(std::thread::hardware_concurrency(), 1u)),
+        inferenceThreads(0),
+        isEnabled(!std::getenv("OMZ_THREAD_BUDGET") || std::strcmp(std::getenv("OMZ_THREAD_BUDGET"), "0") != 0) {}
+
+void ThreadBudget::addCpuNetwork(const std::map<std::string, std::string>& config) {
+    auto it = config.find(CPU_THREADS_NUM_KEY);
+    // 0 lets the plugin take all the threads
+    const unsigned threads = it != config.end() ? static_cast<unsigned>(std::strtoul(it->second.c_str(), nullptr, 10))
+        : 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    inferenceThreads = threads == 0 ? totalThreads : std::min(inferenceThreads + threads, totalThreads);
+}
+
+unsigned ThreadBudget::getInferenceThreads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return inferenceThreads;
+}
+
+unsigned ThreadBudget::getAppThreads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return isEnabled && inferenceThreads != 0 && inferenceThreads < totalThreads ? totalThreads - inferenceThreads : 0;
+}
+
+void ThreadBudget::applyToOpenCV() const {
+    const unsigned appThreads = getAppThreads();
+    if (appThreads != 0) {
+        cv::setNumThreads(static_cast<int>(appThreads));
+        slog::info << "Inference takes " << getInferenceThreads() << " CPU threads, OpenCV takes " << appThreads
+            << slog::endl;
+    }
+}
@@ -0,0 +1,179 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/trace_profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <utility>
+
+namespace {
+std::string escapeJson(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (char c : str) {
+        if ('"' == c || '\\' == c) {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+long long toUs(TraceProfiler::Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+}
+
+TraceProfiler::TraceProfiler(size_t windowSize, size_t maxTraceEvents)
+    : windowSize(std::max(windowSize, size_t{1}))
+    , maxTraceEvents(maxTraceEvents)
+    , creationTime(Clock::now())
+{}
+
+int TraceProfiler::getTrackId(const std::string& trackName) {
+    auto iter = trackIds.find(trackName);
+    if (iter != trackIds.end()) {
+        return iter->second;
+    }
+    int trackId = static_cast<int>(trackNames.size());
+    trackNames.push_back(trackName);
+    trackIds.emplace(trackName, trackId);
+    return trackId;
+}
+
+void TraceProfiler::addTraceEvent(std::string name, const char* category, int trackId, TimePoint begin,
+                                  long long durationUs) {
+    if (0 == maxTraceEvents) {
+        return;
+    }
+    if (traceEvents.size() == maxTraceEvents) {
+        traceEvents.pop_front();
+    }
+    traceEvents.push_back({std::move(name), category, trackId, toUs(begin - creationTime), durationUs});
+}
+
+void TraceProfiler::addSpan(const std::string& name, TimePoint begin, TimePoint end) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto iter = threadTrackIds.find(std::this_thread::get_id());
+    if (iter == threadTrackIds.end()) {
+        int trackId = getTrackId("Thread #" + std::to_string(threadTrackIds.size()));
+        iter = threadTrackIds.emplace(std::this_thread::get_id(), trackId).first;
+    }
+    addTraceEvent(name, "stage", iter->second, begin, toUs(end - begin));
+}
+
+void TraceProfiler::addInference(const void* requestKey, const PerfCounts& perfCounts, TimePoint begin,
+                                 TimePoint end) {
+    using ProfileInfo = InferenceEngine::InferenceEngineProfileInfo;
+    std::vector<std::pair<std::string, ProfileInfo>> executed;
+    for (const auto& counter : perfCounts) {
+        if (ProfileInfo::EXECUTED == counter.second.status) {
+            executed.push_back(counter);
+        }
+    }
+    std::stable_sort(executed.begin(), executed.end(), [](const std::pair<std::string, ProfileInfo>& l,
+                                                          const std::pair<std::string, ProfileInfo>& r) {
+        return l.second.execution_index < r.second.execution_index;
+    });
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto iter = requestTrackIds.find(requestKey);
+    if (iter == requestTrackIds.end()) {
+        int trackId = getTrackId("Infer request #" + std::to_string(requestTrackIds.size()));
+        iter = requestTrackIds.emplace(requestKey, trackId).first;
+    }
+    const int trackId = iter->second;
+    addTraceEvent("Infer", "infer", trackId, begin, toUs(end - begin));
+
+    std::vector<LayerSample> samples;
+    samples.reserve(executed.size());
+    TimePoint layerBegin = begin;
+    for (const auto& counter : executed) {
+        auto idIter = layerIds.find(counter.first);
+        if (idIter == layerIds.end()) {
+            idIter = layerIds.emplace(counter.first, layers.size()).first;
+            layers.push_back({counter.first, counter.second.layer_type, counter.second.exec_type, 0, 0});
+        }
+        samples.push_back({idIter->second, counter.second.realTime_uSec, counter.second.cpu_uSec});
+        layers[idIter->second].realTimeSum += counter.second.realTime_uSec;
+        layers[idIter->second].cpuTimeSum += counter.second.cpu_uSec;
+
+        if (counter.second.realTime_uSec > 0) {
+            addTraceEvent(counter.first, "layer", trackId, layerBegin, counter.second.realTime_uSec);
+            layerBegin += std::chrono::microseconds(counter.second.realTime_uSec);
+        }
+    }
+
+    window.push_back(std::move(samples));
+    if (window.size() > windowSize) {
+        for (const LayerSample& sample : window.front()) {
+            layers[sample.layerId].realTimeSum -= sample.realTime;
+            layers[sample.layerId].cpuTimeSum -= sample.cpuTime;
+        }
+        window.pop_front();
+    }
+}
+
+std::vector<TraceProfiler::LayerStatistic> TraceProfiler::getTopLayers(size_t topN) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<const LayerInfo*> sorted;
+    long long totalRealTime = 0;
+    for (const LayerInfo& layer : layers) {
+        sorted.push_back(&layer);
+        totalRealTime += layer.realTimeSum;
+    }
+    topN = std::min(topN, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + topN, sorted.end(),
+        [](const LayerInfo* l, const LayerInfo* r) { return l->realTimeSum > r->realTimeSum; });
+
+    std::vector<LayerStatistic> statistics;
+    const double inferencesCount = static_cast<double>(std::max(window.size(), size_t{1}));
+    for (size_t i = 0; i < topN; ++i) {
+        const LayerInfo& layer = *sorted[i];
+        statistics.push_back({layer.name, layer.layerType, layer.execType,
+                              layer.realTimeSum / inferencesCount, layer.cpuTimeSum / inferencesCount,
+                              totalRealTime > 0 ? static_cast<double>(layer.realTimeSum) / totalRealTime : 0.0});
+    }
+    return statistics;
+}
+
+void TraceProfiler::printTopLayers(std::ostream& out, size_t topN) const {
+    std::vector<LayerStatistic> statistics = getTopLayers(topN);
+    out << "Top " << statistics.size() << " layers by mean real time per inference:" << std::endl;
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const LayerStatistic& layer : statistics) {
+        out << std::setw(8) << std::right << layer.share * 100 << "%  "
+            << std::setw(12) << layer.meanRealTime << " us  "
+            << std::setw(12) << layer.meanCpuTime << " us cpu  "
+            << layer.name << " (" << layer.layerType << ", " << layer.execType << ")" << std::endl;
+    }
+    out.flags(flags);
+}
+
+void TraceProfiler::exportChromeTrace(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool isFirst = true;
+    for (size_t trackId = 0; trackId < trackNames.size(); ++trackId) {
+        out << (isFirst ? "" : ",") << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << trackId << ", \"args\": {\"name\": \"" << escapeJson(trackNames[trackId]) << "\"}}";
+        isFirst = false;
+    }
+    for (const TraceEvent& event : traceEvents) {
+        out << (isFirst ? "" : ",") << "\n{\"name\": \"" << escapeJson(event.name) << "\", \"cat\": \""
+            << event.category << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.trackId
+            << ", \"ts\": " << event.beginUs << ", \"dur\": " << event.durationUs << "}";
+        isFirst = false;
+    }
+    out << "\n]}" << std::endl;
+}
@@ -0,0 +1,118 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/video_writer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+bool openHardwareWriter(cv::VideoWriter& writer, const std::string& target, int fourcc, double fps,
+                        cv::Size frameSize, VideoEncodeMode mode) {
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 \
+        || (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)))
+    int acceleration = cv::VIDEO_ACCELERATION_ANY;
+    if (VideoEncodeMode::VAAPI == mode) {
+        acceleration = cv::VIDEO_ACCELERATION_VAAPI;
+    } else if (VideoEncodeMode::OneVPL == mode) {
+        acceleration = cv::VIDEO_ACCELERATION_MFX;
+    }
+    return writer.open(target, cv::CAP_ANY, fourcc, fps, frameSize,
+        {cv::VIDEOWRITER_PROP_HW_ACCELERATION, acceleration});
+#else
+    throw std::runtime_error{"Hardware accelerated encoding requires OpenCV 4.5.2 or later"};
+#endif
+}
+}
+
+VideoEncodeMode parseVideoEncodeMode(const std::string& mode) {
+    if ("sw" == mode) return VideoEncodeMode::Software;
+    if ("hw" == mode) return VideoEncodeMode::Hardware;
+    if ("vaapi" == mode) return VideoEncodeMode::VAAPI;
+    if ("onevpl" == mode) return VideoEncodeMode::OneVPL;
+    throw std::invalid_argument{"Unknown video encoding mode: " + mode};
+}
+
+AsyncVideoWriter::AsyncVideoWriter(const std::string& target, int fourcc, double fps, cv::Size frameSize,
+        VideoEncodeMode mode, size_t queueSize) {
+    bool isOpened;
+    if (target.find('!') != std::string::npos) {
+        isOpened = writer.open(target, cv::CAP_GSTREAMER, 0, fps, frameSize);
+    } else if (VideoEncodeMode::Software == mode) {
+        isOpened = writer.open(target, fourcc, fps, frameSize);
+    } else {
+        isOpened = openHardwareWriter(writer, target, fourcc, fps, frameSize, mode);
+    }
+    if (!isOpened) {
+        throw std::runtime_error{"Can't open video writer for " + target};
+    }
+
+    buffers.resize(std::max(queueSize, size_t{1}));
+    for (size_t i = 0; i < buffers.size(); i++) {
+        freeBuffers.push_back(i);
+    }
+    encodingThread = std::thread(&AsyncVideoWriter::encodeLoop, this);
+}
+
+AsyncVideoWriter::~AsyncVideoWriter() {
+    close();
+}
+
+bool AsyncVideoWriter::write(const cv::Mat& frame) {
+    size_t bufferId;
+    {
+        std::lock_guard<std::mutex> lock{mtx};
+        if (freeBuffers.empty() || isStopping) {
+            droppedCount++;
+            return false;
+        }
+        bufferId = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+    // The buffer is owned by the caller until it's queued, copyTo reuses its memory after the first frames
+    frame.copyTo(buffers[bufferId]);
+    {
+        std::lock_guard<std::mutex> lock{mtx};
+        queuedBuffers.push_back(bufferId);
+    }
+    condVar.notify_one();
+    return true;
+}
+
+void AsyncVideoWriter::encodeLoop() {
+    for (;;) {
+        size_t bufferId;
+        {
+            std::unique_lock<std::mutex> lock{mtx};
+            condVar.wait(lock, [&] { return isStopping || !queuedBuffers.empty(); });
+            if (queuedBuffers.empty()) {
+                return;
+            }
+            bufferId = queuedBuffers.front();
+            queuedBuffers.pop_front();
+        }
+        writer.write(buffers[bufferId]);
+        {
+            std::lock_guard<std::mutex> lock{mtx};
+            freeBuffers.push_back(bufferId);
+        }
+    }
+}
+
+void AsyncVideoWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock{mtx};
+        isStopping = true;
+    }
+    condVar.notify_one();
+    if (encodingThread.joinable()) {
+        encodingThread.join();
+    }
+    writer.release();
+}
+
+size_t AsyncVideoWriter::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock{mtx};
+    return droppedCount;
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "samples/warmup.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+void fillImageInput(const InferenceEngine::Blob::Ptr& blob) {
+    if (blob->getTensorDesc().getDims().size() != 4) {
+        return;
+    }
+    InferenceEngine::MemoryBlob::Ptr memoryBlob = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob);
+    if (!memoryBlob) {
+        return;
+    }
+    InferenceEngine::LockedMemory<void> mapped = memoryBlob->wmap();
+    const size_t size = blob->size();
+    switch (blob->getTensorDesc().getPrecision()) {
+    case InferenceEngine::Precision::U8:
+        std::fill_n(mapped.as<uint8_t*>(), size, uint8_t(128));
+        break;
+    case InferenceEngine::Precision::FP32:
+        std::fill_n(mapped.as<float*>(), size, 0.5f);
+        break;
+    case InferenceEngine::Precision::FP16:
+        std::fill_n(mapped.as<int16_t*>(), size, int16_t(0x3800));  // 0.5
+        break;
+    default:
+        std::memset(mapped.as<void*>(), 0, memoryBlob->byteSize());
+    }
+}
+}  // namespace
+
+WarmupResult warmupRequests(const std::vector<InferenceEngine::InferRequest::Ptr>& requests,
+                            const InferenceEngine::ConstInputsDataMap& inputs, unsigned maxRounds) {
+    WarmupResult result;
+    if (requests.empty() || maxRounds == 0) {
+        return result;
+    }
+    for (const InferenceEngine::InferRequest::Ptr& request : requests) {
+        for (const auto& input : inputs) {
+            fillImageInput(request->GetBlob(input.first));
+        }
+    }
+    while (result.rounds < maxRounds && !result.isSteady) {
+        auto start = std::chrono::steady_clock::now();
+        for (const InferenceEngine::InferRequest::Ptr& request : requests) {
+            request->StartAsync();
+        }
+        for (const InferenceEngine::InferRequest::Ptr& request : requests) {
+            request->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
+        }
+        auto latency = std::chrono::steady_clock::now() - start;
+        result.isSteady = result.rounds > 0
+            && std::abs((latency - result.latency).count()) * 10 <= result.latency.count();
+        result.latency = latency;
+        result.rounds++;
+    }
+    return result;
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+
+///
+/// \brief Returns the center of the rectangle.
+///
+inline cv::Point Center(const cv::Rect &rect) {
+    return cv::Point(static_cast<int>(rect.x + rect.width * 0.5),
+                     static_cast<int>(rect.y + rect.height * 0.5));
+}
+
+///
+/// \brief Checks if the value is in the closed range [range[0], range[1]].
+///
+inline bool IsInRange(float val, const cv::Vec2f &range) {
+    return range[0] <= val && val <= range[1];
+}
+
+///
+/// \brief Returns the shape affinity of the track and detection boxes, it is
+/// 1 for the boxes of the same size.
+/// \param weight Shape affinity weight.
+///
+inline float ShapeAffinity(float weight, const cv::Rect &trk, const cv::Rect &det) {
+    float w_dist = static_cast<float>(std::abs(trk.width - det.width)) / static_cast<float>(trk.width + det.width);
+    float h_dist = static_cast<float>(std::abs(trk.height - det.height)) / static_cast<float>(trk.height + det.height);
+    return std::exp(-weight * (w_dist + h_dist));
+}
+
+///
+/// \brief Returns the motion affinity of the track and detection boxes, it is
+/// 1 for the boxes at the same position.
+/// \param weight Motion affinity weight.
+///
+inline float MotionAffinity(float weight, const cv::Rect &trk, const cv::Rect &det) {
+    float x_dist = static_cast<float>(trk.x - det.x) * (trk.x - det.x) /
+        (det.width * det.width);
+    float y_dist = static_cast<float>(trk.y - det.y) * (trk.y - det.y) /
+        (det.height * det.height);
+    return std::exp(-weight * (x_dist + y_dist));
+}
+
+///
+/// \brief Keeps the detections which are confident enough and have the
+/// expected shape.
+/// \param detections Detected objects, they have rect and confidence.
+/// \param min_det_conf Min confidence of detection.
+/// \param aspect_ratios_range Bounding box aspect ratios (height / width) range.
+/// \param heights_range Bounding box heights range.
+/// \return Filtered detections.
+///
+template <typename Objects>
+Objects FilterDetections(const Objects &detections, float min_det_conf,
+                         const cv::Vec2f &aspect_ratios_range,
+                         const cv::Vec2f &heights_range) {
+    Objects filtered_detections;
+    for (const auto &det : detections) {
+        float aspect_ratio = static_cast<float>(det.rect.height) / det.rect.width;
+        if (det.confidence > min_det_conf &&
+            IsInRange(aspect_ratio, aspect_ratios_range) &&
+            IsInRange(static_cast<float>(det.rect.height), heights_range)) {
+            filtered_detections.push_back(det);
+        }
+    }
+    return filtered_detections;
+}
@@ -1,23 +1,28 @@
-// Copyright (C) 2018-2019 Intel Corporation
+// Copyright (C) 2018-2020 Intel Corporation
 // SPDX-License-Identifier: Apache-2.0
 //
 
 #pragma once
 
-#include "core.hpp"
-
 #include <memory>
 #include <vector>
 
+#include <opencv2/core/core.hpp>
 
 ///
 /// \brief The KuhnMunkres class
 ///
-/// Solves the assignment problem.
+/// Solves the assignment problem. The optimal matching is found by
+/// solveAssignment() from the common library.
 ///
 class KuhnMunkres {
 public:
-    KuhnMunkres();
+    ///
+    /// \brief Initializes the class for assignment problem solving.
+    /// \param[in] greedy If a faster greedy matching algorithm should be used.
+    /// It gives every row its minimal dissimilarity column unless an earlier row
+    /// has taken it.
+    explicit KuhnMunkres(bool greedy = false);
 
     ///
     /// \brief Solves the assignment problem for given dissimilarity matrix.
@@ -31,23 +36,6 @@ public:
     std::vector<size_t> Solve(const cv::Mat &dissimilarity_matrix);
 
 private:
-    static constexpr int kStar = 1;
-    static constexpr int kPrime = 2;
-
-    cv::Mat dm_;
-    cv::Mat marked_;
-    std::vector<cv::Point> points_;
-
-    std::vector<int> is_row_visited_;
-    std::vector<int> is_col_visited_;
-
-    int n_;
-
-    void TrySimpleCase();
-    bool CheckIfOptimumIsFound();
-    cv::Point FindUncoveredMinValPos();
-    void UpdateDissimilarityMatrix(float val);
-    int FindInRow(int row, int what);
-    int FindInCol(int col, int what);
-    void Run();
+    class Impl;
+    std::shared_ptr<Impl> impl_;  ///< Class implementation.
 };
@@ -0,0 +1,83 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+///
+/// \brief The TrackBase struct describes tracks. The trackers either use it
+/// as is or add their data to it.
+/// \tparam ObjectT Type of detected objects, it has rect and object_id.
+/// \tparam ObjectsT Sequence of detected objects.
+///
+template <typename ObjectT, typename ObjectsT = std::vector<ObjectT>>
+struct TrackBase {
+    using Object = ObjectT;
+    using Objects = ObjectsT;
+
+    ///
+    /// \brief Track constructor.
+    /// \param objs Detected objects sequence.
+    ///
+    explicit TrackBase(const Objects &objs) : objects(objs), lost(0), length(1) {
+        CV_Assert(!objs.empty());
+        first_object = objs[0];
+    }
+
+    ///
+    /// \brief empty returns if track does not contain objects.
+    /// \return true if track does not contain objects.
+    ///
+    bool empty() const { return objects.empty(); }
+
+    ///
+    /// \brief size returns number of detected objects in a track.
+    /// \return number of detected objects in a track.
+    ///
+    size_t size() const { return objects.size(); }
+
+    ///
+    /// \brief operator [] return const reference to detected object with
+    ///        specified index.
+    /// \param i Index of object.
+    /// \return const reference to detected object with specified index.
+    ///
+    const Object &operator[](size_t i) const { return objects[i]; }
+
+    ///
+    /// \brief operator [] return non-const reference to detected object with
+    ///        specified index.
+    /// \param i Index of object.
+    /// \return non-const reference to detected object with specified index.
+    ///
+    Object &operator[](size_t i) { return objects[i]; }
+
+    ///
+    /// \brief back returns const reference to last object in track.
+    /// \return const reference to last object in track.
+    ///
+    const Object &back() const {
+        CV_Assert(!empty());
+        return objects.back();
+    }
+
+    ///
+    /// \brief back returns non-const reference to last object in track.
+    /// \return non-const reference to last object in track.
+    ///
+    Object &back() {
+        CV_Assert(!empty());
+        return objects.back();
+    }
+
+    Objects objects;  ///< Detected objects;
+    size_t lost;      ///< How many frames ago track has been lost.
+
+    Object first_object;  ///< First object in track.
+    size_t length;  ///< Length of a track including number of objects that were
+                    /// removed from track in order to avoid memory usage growth.
+};
@@ -0,0 +1,251 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <algorithm>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include <opencv2/core/core.hpp>
+
+#include "tracker_core/affinity.h"
+#include "tracker_core/track.h"
+
+///
+/// \brief Solves the assignment problem between the tracks and the detections.
+/// The pairs with affinity (1 - dissimilarity) not greater than affinity_thr
+/// are never matched, so they don't take the places of the other pairs.
+/// \param[in] track_ids Tracks in the order of the dissimilarity matrix rows.
+/// \param[in] dissimilarity CV_32F dissimilarity matrix, its columns are the
+/// detections.
+/// \param[in] affinity_thr Affinity threshold of the matched pairs.
+/// \param[out] unmatched_tracks Tracks without a detection.
+/// \param[out] unmatched_detections All detections, the caller erases the
+/// matched ones it accepts.
+/// \param[out] matches Set of (track id, detection index, affinity).
+///
+void SolveTrackAssignment(const std::set<size_t> &track_ids, const cv::Mat &dissimilarity,
+                          float affinity_thr, std::set<size_t> *unmatched_tracks,
+                          std::set<size_t> *unmatched_detections,
+                          std::set<std::tuple<size_t, size_t, float>> *matches);
+
+///
+/// \brief The TrackerCore class stores tracks and does the bookkeeping which
+/// is the same for all trackers: track IDs, lost and forgotten tracks and the
+/// assignment of detections to tracks.
+///
+/// The trackers keep their own matching logic. The distance between objects
+/// is a template parameter of the methods looping over all the pairs, so it is
+/// inlined there.
+/// \tparam TrackT Track type derived from TrackBase or TrackBase itself.
+///
+template <typename TrackT>
+class TrackerCore {
+public:
+    using Track = TrackT;
+    using Object = typename Track::Object;
+    using Objects = typename Track::Objects;
+
+    ///
+    /// \brief Constructor.
+    /// \param forget_delay Forget about track if the last bounding box in track
+    /// was detected more than specified number of frames ago.
+    /// \param max_num_objects_in_track The number of objects in track is
+    /// restricted by this parameter. If it is negative or zero, the max number
+    /// of objects in track is not restricted.
+    ///
+    TrackerCore(size_t forget_delay, int max_num_objects_in_track)
+        : forget_delay_(forget_delay),
+        max_num_objects_in_track_(max_num_objects_in_track),
+        tracks_counter_(0) {}
+
+    ///
+    /// \brief tracks Returns all tracks including forgotten (lost too many frames
+    /// ago).
+    /// \return Set of tracks {id, track}.
+    ///
+    const std::unordered_map<size_t, Track> &tracks() const { return tracks_; }
+
+    ///
+    /// \brief Returns the track with specified ID.
+    ///
+    const Track &track(size_t id) const { return tracks_.at(id); }
+    Track &track(size_t id) { return tracks_.at(id); }
+
+    ///
+    /// \brief Returns indexes of active tracks only.
+    ///
+    const std::set<size_t> &active_track_ids() const { return active_track_ids_; }
+
+    ///
+    /// \brief IsTrackForgotten returns true if track is forgotten.
+    ///
+    bool IsTrackForgotten(const Track &track) const { return track.lost > forget_delay_; }
+    bool IsTrackForgotten(size_t id) const { return IsTrackForgotten(tracks_.at(id)); }
+
+    ///
+    /// \brief Starts a new active track with the detection.
+    /// \param detection The first object of the track, it gets the track ID.
+    /// \param args The rest of the Track constructor parameters.
+    /// \return ID of the new track.
+    ///
+    template <typename... Args>
+    size_t AddTrack(const Object &detection, Args&&... args) {
+        auto detection_with_id = detection;
+        detection_with_id.object_id = static_cast<int>(tracks_counter_);
+        tracks_.emplace(tracks_counter_, Track(Objects{detection_with_id}, std::forward<Args>(args)...));
+        active_track_ids_.insert(tracks_counter_);
+        return tracks_counter_++;
+    }
+
+    ///
+    /// \brief Appends the detection to the track which is not forgotten. The
+    /// oldest objects are removed if the track is too long.
+    /// \return The track to update the tracker's data.
+    ///
+    Track &AppendToTrack(size_t id, const Object &detection) {
+        CV_Assert(!IsTrackForgotten(id));
+
+        auto detection_with_id = detection;
+        detection_with_id.object_id = static_cast<int>(id);
+
+        auto &track = tracks_.at(id);
+        track.objects.push_back(detection_with_id);
+        track.lost = 0;
+        track.length++;
+
+        if (max_num_objects_in_track_ > 0) {
+            while (track.size() > static_cast<size_t>(max_num_objects_in_track_)) {
+                track.objects.erase(track.objects.begin());
+            }
+        }
+        return track;
+    }
+
+    ///
+    /// \brief Forgets the track if the center of its box is out of the frame.
+    /// \param frame_size Frame size, nothing is forgotten if it's empty.
+    /// \param track_rect Functor returning the box of the track.
+    /// \return true if the track is forgotten or doesn't exist.
+    ///
+    template <typename TrackRect>
+    bool ForgetTrackIfBBoxIsOutOfFrame(size_t id, const cv::Size &frame_size, TrackRect track_rect) {
+        auto it = tracks_.find(id);
+        if (it == tracks_.end()) return true;
+        auto c = Center(track_rect(it->second));
+        if (!frame_size.empty() &&
+            (c.x < 0 || c.y < 0 || c.x > frame_size.width ||
+             c.y > frame_size.height)) {
+            it->second.lost = forget_delay_ + 1;
+            active_track_ids_.erase(id);
+            return true;
+        }
+        return false;
+    }
+
+    ///
+    /// \brief Deactivates the track if it was lost more than forget_delay frames
+    /// ago.
+    /// \return true if the track is forgotten or doesn't exist.
+    ///
+    bool ForgetTrackIfItWasLostTooManyFramesAgo(size_t id) {
+        auto it = tracks_.find(id);
+        if (it == tracks_.end()) return true;
+        if (IsTrackForgotten(it->second)) {
+            active_track_ids_.erase(id);
+            return true;
+        }
+        return false;
+    }
+
+    ///
+    /// \brief DropForgottenTracks Removes tracks from memory that were lost too
+    /// many frames ago. The IDs start from 0 again when they grow too large.
+    ///
+    void DropForgottenTracks() {
+        std::set<size_t> new_active_tracks;
+
+        size_t max_id = 0;
+        if (!active_track_ids_.empty())
+            max_id = *std::max_element(active_track_ids_.begin(), active_track_ids_.end());
+
+        const size_t kMaxTrackID = 10000;
+        bool reassign_id = max_id > kMaxTrackID;
+
+        if (reassign_id) {
+            std::unordered_map<size_t, Track> new_tracks;
+            size_t counter = 0;
+            for (auto &pair : tracks_) {
+                if (!IsTrackForgotten(pair.second)) {
+                    new_tracks.emplace(counter, std::move(pair.second));
+                    new_active_tracks.emplace(counter);
+                    counter++;
+                }
+            }
+            tracks_.swap(new_tracks);
+            tracks_counter_ = counter;
+        } else {
+            // The remaining tracks are neither copied nor moved
+            for (auto it = tracks_.begin(); it != tracks_.end();) {
+                if (IsTrackForgotten(it->second)) {
+                    it = tracks_.erase(it);
+                } else {
+                    new_active_tracks.emplace(it->first);
+                    ++it;
+                }
+            }
+        }
+        active_track_ids_.swap(new_active_tracks);
+    }
+
+    ///
+    /// \brief Removes all tracks.
+    ///
+    void Reset() {
+        active_track_ids_.clear();
+        tracks_.clear();
+        tracks_counter_ = 0;
+    }
+
+    ///
+    /// \brief Computes the dissimilarity matrix of the last objects of the
+    /// tracks and the detections.
+    /// \param[in] track_ids Tracks in the order of the matrix rows.
+    /// \param[in] detections Detections in the order of the matrix columns.
+    /// \param[in] distance Functor returning the dissimilarity of a track object
+    /// and a detection.
+    /// \param[out] dissimilarity_matrix CV_32F dissimilarity matrix.
+    ///
+    template <typename Distance>
+    void ComputeDissimilarityMatrix(const std::set<size_t> &track_ids, const Objects &detections,
+                                    Distance distance, cv::Mat *dissimilarity_matrix) const {
+        dissimilarity_matrix->create(static_cast<int>(track_ids.size()),
+                                     static_cast<int>(detections.size()), CV_32F);
+        int i = 0;
+        for (auto id : track_ids) {
+            const auto &last_det = tracks_.at(id).back();
+            auto ptr = dissimilarity_matrix->ptr<float>(i);
+            for (size_t j = 0; j < detections.size(); j++) {
+                ptr[j] = distance(last_det, detections[j]);
+            }
+            i++;
+        }
+    }
+
+private:
+    size_t forget_delay_;
+    int max_num_objects_in_track_;
+
+    // Indexes of active tracks.
+    std::set<size_t> active_track_ids_;
+
+    // All tracks.
+    std::unordered_map<size_t, Track> tracks_;
+
+    // Number of all current tracks.
+    size_t tracks_counter_;
+};
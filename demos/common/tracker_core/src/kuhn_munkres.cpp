@@ -0,0 +1,66 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "tracker_core/kuhn_munkres.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <samples/assignment.hpp>
+
+class KuhnMunkres::Impl {
+public:
+    explicit Impl(bool greedy) : greedy_(greedy) {}
+
+    std::vector<size_t> Solve(const cv::Mat &dissimilarity_matrix) {
+        std::vector<size_t> results(dissimilarity_matrix.rows, -1);
+        if (!greedy_) {
+            auto assignment = solveAssignment(dissimilarity_matrix);
+            for (int i = 0; i < dissimilarity_matrix.rows; i++) {
+                if (assignment[i] >= 0) {
+                    results[i] = assignment[i];
+                }
+            }
+            return results;
+        }
+
+        double min_val;
+        cv::minMaxLoc(dissimilarity_matrix, &min_val);
+        CV_Assert(min_val >= 0);
+
+        int n = std::max(dissimilarity_matrix.rows, dissimilarity_matrix.cols);
+        cv::Mat dm(n, n, CV_32F, cv::Scalar(0));
+        dissimilarity_matrix.copyTo(dm(
+                                        cv::Rect(0, 0, dissimilarity_matrix.cols, dissimilarity_matrix.rows)));
+
+        // Every row takes the first unused column with its minimal dissimilarity
+        auto is_col_visited = std::vector<int>(n, 0);
+        for (int row = 0; row < dissimilarity_matrix.rows; row++) {
+            auto ptr = dm.ptr<float>(row);
+            auto row_min_val = *std::min_element(ptr, ptr + n);
+            for (int col = 0; col < dissimilarity_matrix.cols; col++) {
+                if (ptr[col] == row_min_val && !is_col_visited[col]) {
+                    results[row] = col;
+                    is_col_visited[col] = 1;
+                    break;
+                }
+            }
+        }
+        return results;
+    }
+
+private:
+    bool greedy_;
+};
+
+KuhnMunkres::KuhnMunkres(bool greedy) : impl_(std::make_shared<Impl>(greedy)) {}
+
+std::vector<size_t> KuhnMunkres::Solve(const cv::Mat &dissimilarity_matrix) {
+    CV_Assert(impl_ != nullptr);
+    CV_Assert(!dissimilarity_matrix.empty());
+    CV_Assert(dissimilarity_matrix.type() == CV_32F);
+
+    return impl_->Solve(dissimilarity_matrix);
+}
@@ -0,0 +1,41 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "tracker_core/tracker_core.h"
+
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <samples/assignment.hpp>
+
+void SolveTrackAssignment(const std::set<size_t> &track_ids, const cv::Mat &dissimilarity,
+                          float affinity_thr, std::set<size_t> *unmatched_tracks,
+                          std::set<size_t> *unmatched_detections,
+                          std::set<std::tuple<size_t, size_t, float>> *matches) {
+    CV_Assert(unmatched_tracks);
+    CV_Assert(unmatched_detections);
+    CV_Assert(matches);
+    CV_Assert(!track_ids.empty());
+    CV_Assert(dissimilarity.rows == static_cast<int>(track_ids.size()) && dissimilarity.cols > 0);
+    unmatched_tracks->clear();
+    unmatched_detections->clear();
+    matches->clear();
+
+    auto res = solveAssignment(dissimilarity, 1.0f - affinity_thr);
+
+    for (int i = 0; i < dissimilarity.cols; i++) {
+        unmatched_detections->insert(i);
+    }
+
+    size_t i = 0;
+    for (auto id : track_ids) {
+        if (res[i] >= 0) {
+            matches->emplace(id, res[i], 1 - dissimilarity.at<float>(static_cast<int>(i), res[i]));
+        } else {
+            unmatched_tracks->insert(id);
+        }
+        i++;
+    }
+}
@@ -40,6 +40,9 @@ static const char raw_output_message[] = "Optional. Output Inference results as
 static const char no_show_processed_video[] = "Optional. No show processed video.";
 static const char input_resizable_message[] = "Optional. Enables resizable input with support of ROI crop & auto resize.";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
+static const char ninfer_request_message[] = "Optional. Number of infer requests for each of the Person Attributes Recognition "
+                                             "and Person Reidentification networks. This number of persons of a frame is inferred in parallel. "
+                                             "The default value is 4.";
 static const char person_label_message[] = "Optional. The integer index of the objects' category corresponding to persons "
                                            "(as it is returned from the detection network, may vary from one network to another). "
                                            "The default value is 1.";
@@ -62,6 +65,8 @@ DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_bool(auto_resize, false, input_resizable_message);
 DEFINE_string(u, "", utilization_monitors_message);
 DEFINE_int32(person_label, 1, person_label_message);
+DEFINE_uint32(nireq, 4, ninfer_request_message);
+DEFINE_MOTION_GATE_FLAG
 
 
 /**
@@ -92,4 +97,6 @@ static void showUsage() {
     std::cout << "    -auto_resize                 " << input_resizable_message << std::endl;
     std::cout << "    -u                           " << utilization_monitors_message << std::endl;
     std::cout << "    -person_label                " << person_label_message << std::endl;
+    std::cout << "    -nireq                       " << ninfer_request_message << std::endl;
+    std::cout << "    -motion_gate                 " << motion_gate_message << std::endl;
 }
@@ -20,11 +20,14 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <utility>
 
 #include <inference_engine.hpp>
 
 #include <monitors/presenter.h>
 #include <samples/images_capture.h>
+#include <samples/model_loader.hpp>
+#include <samples/motion_gate.h>
 #include <samples/slog.hpp>
 #include <samples/ocv_common.hpp>
 #include "crossroad_camera_demo.hpp"
@@ -51,6 +54,10 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
         throw std::logic_error("Parameter -m is not set");
     }
 
+    if (FLAGS_nireq == 0) {
+        throw std::logic_error("Parameter -nireq can not be zero");
+    }
+
     return true;
 }
 
@@ -58,7 +65,7 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
 
 struct BaseDetection {
     ExecutableNetwork net;
-    InferRequest request;
+    std::vector<InferRequest> requests;  // the persons of a frame are inferred in parallel by different requests
     std::string & commandLineFlag;
     std::string topoName;
     Blob::Ptr inputBlob;
@@ -73,38 +80,40 @@ struct BaseDetection {
     }
     virtual CNNNetwork read(const Core& ie)  = 0;
 
-    virtual void setRoiBlob(const Blob::Ptr &roiBlob) {
+    InferRequest& request(size_t requestId = 0) {
+        while (requests.size() <= requestId)
+            requests.push_back(net.CreateInferRequest());
+        return requests[requestId];
+    }
+
+    virtual void setRoiBlob(const Blob::Ptr &roiBlob, size_t requestId = 0) {
         if (!enabled())
             return;
-        if (!request)
-            request = net.CreateInferRequest();
 
-        request.SetBlob(inputName, roiBlob);
+        request(requestId).SetBlob(inputName, roiBlob);
     }
 
-    virtual void enqueue(const cv::Mat &person) {
+    virtual void enqueue(const cv::Mat &person, size_t requestId = 0) {
         if (!enabled())
             return;
-        if (!request)
-            request = net.CreateInferRequest();
 
         if (FLAGS_auto_resize) {
             inputBlob = wrapMat2Blob(person);
-            request.SetBlob(inputName, inputBlob);
+            request(requestId).SetBlob(inputName, inputBlob);
         } else {
-            inputBlob = request.GetBlob(inputName);
+            inputBlob = request(requestId).GetBlob(inputName);
             matU8ToBlob<uint8_t>(person, inputBlob);
         }
     }
 
-    virtual void submitRequest() {
-        if (!enabled() || !request) return;
-        request.StartAsync();
+    virtual void submitRequest(size_t requestId = 0) {
+        if (!enabled() || requests.size() <= requestId) return;
+        requests[requestId].StartAsync();
     }
 
-    virtual void wait() {
-        if (!enabled()|| !request) return;
-        request.Wait(IInferRequest::WaitMode::RESULT_READY);
+    virtual void wait(size_t requestId = 0) {
+        if (!enabled() || requests.size() <= requestId) return;
+        requests[requestId].Wait(IInferRequest::WaitMode::RESULT_READY);
     }
     mutable bool enablingChecked = false;
     mutable bool _enabled = false;
@@ -121,7 +130,8 @@ struct BaseDetection {
     }
 
     void printPerformanceCounts(std::string fullDeviceName) const {
-        ::printPerformanceCounts(request, std::cout, fullDeviceName);
+        if (!requests.empty())
+            ::printPerformanceCounts(requests.front(), std::cout, fullDeviceName);
     }
 };
 
@@ -140,22 +150,22 @@ struct PersonDetection : BaseDetection{
 
     std::vector<Result> results;
 
-    void submitRequest() override {
+    void submitRequest(size_t requestId = 0) override {
         resultsFetched = false;
         results.clear();
-        BaseDetection::submitRequest();
+        BaseDetection::submitRequest(requestId);
     }
 
-    void setRoiBlob(const Blob::Ptr &frameBlob) override {
+    void setRoiBlob(const Blob::Ptr &frameBlob, size_t requestId = 0) override {
         height = static_cast<float>(frameBlob->getTensorDesc().getDims()[2]);
         width = static_cast<float>(frameBlob->getTensorDesc().getDims()[3]);
-        BaseDetection::setRoiBlob(frameBlob);
+        BaseDetection::setRoiBlob(frameBlob, requestId);
     }
 
-    void enqueue(const cv::Mat &frame) override {
+    void enqueue(const cv::Mat &frame, size_t requestId = 0) override {
         height = static_cast<float>(frame.rows);
         width = static_cast<float>(frame.cols);
-        BaseDetection::enqueue(frame);
+        BaseDetection::enqueue(frame, requestId);
     }
 
     PersonDetection() : BaseDetection(FLAGS_m, "Person Detection"), maxProposalCount(0), objectSize(0) {}
@@ -216,7 +226,7 @@ struct PersonDetection : BaseDetection{
         results.clear();
         if (resultsFetched) return;
         resultsFetched = true;
-        LockedMemory<const void> outputMapped = as<MemoryBlob>(request.GetBlob(outputName))->rmap();
+        LockedMemory<const void> outputMapped = as<MemoryBlob>(request().GetBlob(outputName))->rmap();
         const float *detections = outputMapped.as<float *>();
         // pretty much regular SSD post-processing
         for (int i = 0; i < maxProposalCount; i++) {
@@ -291,7 +301,7 @@ struct PersonAttribsDetection : BaseDetection {
         return centers.at<cv::Vec3b>(freqArgmax);
     }
 
-    AttributesAndColorPoints GetPersonAttributes() {
+    AttributesAndColorPoints GetPersonAttributes(size_t requestId = 0) {
         static const char *const attributeStringsFor7Attributes[] = {
                 "is male", "has_bag", "has hat", "has longsleeves", "has longpants", "has longhair", "has coat_jacket"
         };
@@ -299,7 +309,7 @@ struct PersonAttribsDetection : BaseDetection {
                 "is male", "has_bag", "has_backpack" , "has hat", "has longsleeves", "has longpants", "has longhair", "has coat_jacket"
         };
 
-        Blob::Ptr attribsBlob = request.GetBlob(outputNameForAttributes);
+        Blob::Ptr attribsBlob = request(requestId).GetBlob(outputNameForAttributes);
         size_t numOfAttrChannels = attribsBlob->getTensorDesc().getDims().at(1);
 
         const char *const *attributeStrings;
@@ -326,8 +336,8 @@ struct PersonAttribsDetection : BaseDetection {
         }
 
         if (hasTopBottomColor) {
-            Blob::Ptr topColorPointBlob = request.GetBlob(outputNameForTopColorPoint);
-            Blob::Ptr bottomColorPointBlob = request.GetBlob(outputNameForBottomColorPoint);
+            Blob::Ptr topColorPointBlob = request(requestId).GetBlob(outputNameForTopColorPoint);
+            Blob::Ptr bottomColorPointBlob = request(requestId).GetBlob(outputNameForBottomColorPoint);
 
             size_t numOfTCPointChannels = topColorPointBlob->getTensorDesc().getDims().at(1);
             size_t numOfBCPointChannels = bottomColorPointBlob->getTensorDesc().getDims().at(1);
@@ -409,32 +419,49 @@ struct PersonAttribsDetection : BaseDetection {
 };
 
 struct PersonReIdentification : BaseDetection {
-    std::vector<std::vector<float>> globalReIdVec;  // contains vectors characterising all detected persons
+    cv::Mat globalReIdMat;  // contains unit vectors characterising all detected persons, one per row
 
     PersonReIdentification() : BaseDetection(FLAGS_m_reid, "Person Reidentification Retail") {}
 
     unsigned long int findMatchingPerson(const std::vector<float> &newReIdVec) {
-        auto size = globalReIdVec.size();
+        cv::Mat newReIdRow = cv::Mat(newReIdVec, true).reshape(1, 1);
+        const double norm = cv::norm(newReIdRow);
+        if (norm == 0) {
+            throw std::logic_error("cosine similarity is not defined whenever one or both "
+                                   "input vectors are zero-vectors.");
+        }
+        newReIdRow /= norm;
+        if (!globalReIdMat.empty() && globalReIdMat.cols != newReIdRow.cols) {
+            throw std::logic_error("cosine similarity can't be called for the vectors of different lengths: "
+                                   "vecA size = " + std::to_string(newReIdRow.cols) +
+                                   "vecB size = " + std::to_string(globalReIdMat.cols));
+        }
+        auto size = globalReIdMat.rows;
 
-        /* assigned REID is index of the matched vector from the globalReIdVec */
-        for (size_t i = 0; i < size; ++i) {
-            float cosSim = cosineSimilarity(newReIdVec, globalReIdVec[i]);
-            if (FLAGS_r) {
-                std::cout << "cosineSimilarity: " << cosSim << std::endl;
-            }
-            if (cosSim > FLAGS_t_reid) {
-                /* We substitute previous person's vector by a new one characterising
-                 * last person's position */
-                globalReIdVec[i] = newReIdVec;
-                return i;
+        if (size > 0) {
+            /* The vectors are normalized, so one matrix product gives the cosine similarities with all the persons */
+            cv::Mat cosSims = globalReIdMat * newReIdRow.t();
+
+            /* assigned REID is index of the matched vector from the globalReIdMat */
+            for (int i = 0; i < size; ++i) {
+                float cosSim = cosSims.at<float>(i);
+                if (FLAGS_r) {
+                    std::cout << "cosineSimilarity: " << cosSim << std::endl;
+                }
+                if (cosSim > FLAGS_t_reid) {
+                    /* We substitute previous person's vector by a new one characterising
+                     * last person's position */
+                    newReIdRow.copyTo(globalReIdMat.row(i));
+                    return i;
+                }
             }
         }
-        globalReIdVec.push_back(newReIdVec);
+        globalReIdMat.push_back(newReIdRow);
         return size;
     }
 
-    std::vector<float> getReidVec() {
-        Blob::Ptr attribsBlob = request.GetBlob(outputName);
+    std::vector<float> getReidVec(size_t requestId = 0) {
+        Blob::Ptr attribsBlob = request(requestId).GetBlob(outputName);
 
         auto numOfChannels = attribsBlob->getTensorDesc().getDims().at(1);
         LockedMemory<const void> attribsBlobMapped = as<MemoryBlob>(attribsBlob)->rmap();
@@ -442,30 +469,6 @@ struct PersonReIdentification : BaseDetection {
         return std::vector<float>(outputValues, outputValues + numOfChannels);
     }
 
-    template <typename T>
-    float cosineSimilarity(const std::vector<T> &vecA, const std::vector<T> &vecB) {
-        if (vecA.size() != vecB.size()) {
-            throw std::logic_error("cosine similarity can't be called for the vectors of different lengths: "
-                                   "vecA size = " + std::to_string(vecA.size()) +
-                                   "vecB size = " + std::to_string(vecB.size()));
-        }
-
-        T mul, denomA, denomB, A, B;
-        mul = denomA = denomB = A = B = 0;
-        for (size_t i = 0; i < vecA.size(); ++i) {
-            A = vecA[i];
-            B = vecB[i];
-            mul += A * B;
-            denomA += A * A;
-            denomB += B * B;
-        }
-        if (denomA == 0 || denomB == 0) {
-            throw std::logic_error("cosine similarity is not defined whenever one or both "
-                                   "input vectors are zero-vectors.");
-        }
-        return mul / (sqrt(denomA) * sqrt(denomB));
-    }
-
     CNNNetwork read(const Core& ie) override {
         slog::info << "Loading network files for Person Reidentification" << slog::endl;
         /** Read network model **/
@@ -528,6 +531,11 @@ int main(int argc, char *argv[]) {
         }
 
         std::unique_ptr<ImagesCapture> cap = openImagesCapture(FLAGS_i, FLAGS_loop);
+        MotionGatedCapture* gatedCap = nullptr;
+        if (FLAGS_motion_gate > 0) {
+            gatedCap = new MotionGatedCapture(std::move(cap), FLAGS_motion_gate);
+            cap.reset(gatedCap);
+        }
         // -----------------------------------------------------------------------------------------------------
 
         // --------------------------- 1. Load inference engine -------------------------------------
@@ -582,16 +590,18 @@ int main(int argc, char *argv[]) {
         // -----------------------------------------------------------------------------------------------------
 
         // --------------------------- 2. Read IR models and load them to devices ------------------------------
-        Load(personDetection).into(ie, FLAGS_d);
-        Load(personAttribs).into(ie, FLAGS_d_pa);
-        Load(personReId).into(ie, FLAGS_d_reid);
+        // The networks are read and loaded concurrently
+        ModelLoader modelLoader;
+        modelLoader.add([&]() { Load(personDetection).into(ie, FLAGS_d); });
+        modelLoader.add([&]() { Load(personAttribs).into(ie, FLAGS_d_pa); });
+        modelLoader.add([&]() { Load(personReId).into(ie, FLAGS_d_reid); });
+        modelLoader.wait();
         // -----------------------------------------------------------------------------------------------------
 
         // --------------------------- 3. Do inference ---------------------------------------------------------
         Blob::Ptr frameBlob;  // Blob to be used to keep processed frame data
         ROI cropRoi;  // cropped image coordinates
         Blob::Ptr roiBlob;  // This blob contains data from cropped image (vehicle or license plate)
-        cv::Mat person;  // Mat object containing person data cropped by openCV
 
         /** Start inference & calc performance **/
         typedef std::chrono::duration<double, std::ratio<1, 1000>> ms;
@@ -633,40 +643,60 @@ int main(int argc, char *argv[]) {
             // --------------------------- Process the results down to the pipeline ----------------------------
             ms personAttribsNetworkTime(0), personReIdNetworktime(0);
             int personAttribsInferred = 0,  personReIdInferred = 0;
+            std::vector<PersonDetection::Result> persons;
             for (auto && result : personDetection.results) {
                 if (result.label == FLAGS_person_label) {  // person
+                    persons.push_back(result);
+                }
+            }
+            std::vector<PersonAttribsDetection::AttributesAndColorPoints> personsAttrAndColor(persons.size());
+            std::vector<std::string> personsReid(persons.size());
+            // The persons are inferred in groups of FLAGS_nireq, each person of a group by its own requests.
+            // Frame is drawn on only after all the persons are inferred
+            for (size_t groupBegin = 0; groupBegin < persons.size(); groupBegin += FLAGS_nireq) {
+                const size_t groupSize = std::min<size_t>(FLAGS_nireq, persons.size() - groupBegin);
+                std::vector<cv::Mat> personImages(groupSize);  // Mat objects containing person data cropped by openCV
+                for (size_t j = 0; j < groupSize; j++) {
+                    const cv::Rect& location = persons[groupBegin + j].location;
+                    personImages[j] = frame(location & cv::Rect(0, 0, frame.cols, frame.rows));
                     if (FLAGS_auto_resize) {
-                        cropRoi.posX = (result.location.x < 0) ? 0 : result.location.x;
-                        cropRoi.posY = (result.location.y < 0) ? 0 : result.location.y;
-                        cropRoi.sizeX = std::min((size_t) result.location.width, frame.cols - cropRoi.posX);
-                        cropRoi.sizeY = std::min((size_t) result.location.height, frame.rows - cropRoi.posY);
+                        cropRoi.posX = (location.x < 0) ? 0 : location.x;
+                        cropRoi.posY = (location.y < 0) ? 0 : location.y;
+                        cropRoi.sizeX = std::min((size_t) location.width, frame.cols - cropRoi.posX);
+                        cropRoi.sizeY = std::min((size_t) location.height, frame.rows - cropRoi.posY);
                         roiBlob = make_shared_blob(frameBlob, cropRoi);
+                        personAttribs.setRoiBlob(roiBlob, j);
+                        personReId.setRoiBlob(roiBlob, j);
                     } else {
-                        // To crop ROI manually and allocate required memory (cv::Mat) again
-                        auto clippedRect = result.location & cv::Rect(0, 0, frame.cols, frame.rows);
-                        person = frame(clippedRect);
+                        personAttribs.enqueue(personImages[j], j);
+                        personReId.enqueue(personImages[j], j);
                     }
+                }
 
-                    PersonAttribsDetection::AttributesAndColorPoints resPersAttrAndColor;
-                    if (personAttribs.enabled()) {
-                        // --------------------------- Run Person Attributes Recognition -----------------------
-                        if (FLAGS_auto_resize) {
-                            personAttribs.setRoiBlob(roiBlob);
-                        } else {
-                            personAttribs.enqueue(person);
-                        }
+                // --------------------------- Run Person Attributes Recognition and Reidentification ----------
+                auto groupT0 = std::chrono::high_resolution_clock::now();
+                for (size_t j = 0; j < groupSize; j++) {
+                    personAttribs.submitRequest(j);
+                    personReId.submitRequest(j);
+                }
+                for (size_t j = 0; j < groupSize; j++) {
+                    personAttribs.wait(j);
+                }
+                personAttribsNetworkTime += std::chrono::duration_cast<ms>(std::chrono::high_resolution_clock::now() - groupT0);
+                for (size_t j = 0; j < groupSize; j++) {
+                    personReId.wait(j);
+                }
+                personReIdNetworktime += std::chrono::duration_cast<ms>(std::chrono::high_resolution_clock::now() - groupT0);
 
-                        t0 = std::chrono::high_resolution_clock::now();
-                        personAttribs.submitRequest();
-                        personAttribs.wait();
-                        t1 = std::chrono::high_resolution_clock::now();
-                        personAttribsNetworkTime += std::chrono::duration_cast<ms>(t1 - t0);
+                // --------------------------- Process outputs ---------------------------------------------
+                for (size_t j = 0; j < groupSize; j++) {
+                    if (personAttribs.enabled()) {
                         personAttribsInferred++;
-                        // --------------------------- Process outputs -----------------------------------------
-
-                        resPersAttrAndColor = personAttribs.GetPersonAttributes();
+                        PersonAttribsDetection::AttributesAndColorPoints& resPersAttrAndColor = personsAttrAndColor[groupBegin + j];
+                        resPersAttrAndColor = personAttribs.GetPersonAttributes(j);
 
                         if (shouldHandleTopBottomColors) {
+                            const cv::Mat& person = personImages[j];
                             cv::Point top_color_p;
                             cv::Point bottom_color_p;
 
@@ -702,88 +732,79 @@ int main(int argc, char *argv[]) {
                         }
                     }
 
-                    std::string resPersReid = "";
                     if (personReId.enabled()) {
-                        // --------------------------- Run Person Reidentification -----------------------------
-                        if (FLAGS_auto_resize) {
-                            personReId.setRoiBlob(roiBlob);
-                        } else {
-                            personReId.enqueue(person);
-                        }
-
-                        t0 = std::chrono::high_resolution_clock::now();
-                        personReId.submitRequest();
-                        personReId.wait();
-                        t1 = std::chrono::high_resolution_clock::now();
-
-                        personReIdNetworktime += std::chrono::duration_cast<ms>(t1 - t0);
                         personReIdInferred++;
-
-                        auto reIdVector = personReId.getReidVec();
+                        auto reIdVector = personReId.getReidVec(j);
 
                         /* Check cosine similarity with all previously detected persons.
                            If it's new person it is added to the global Reid vector and
                            new global ID is assigned to the person. Otherwise, ID of
                            matched person is assigned to it. */
                         auto foundId = personReId.findMatchingPerson(reIdVector);
-                        resPersReid = "REID: " + std::to_string(foundId);
+                        personsReid[groupBegin + j] = "REID: " + std::to_string(foundId);
                     }
+                }
+            }
 
-                    // --------------------------- Process outputs -----------------------------------------
-                    if (!resPersAttrAndColor.attributes_strings.empty()) {
-                        cv::Rect image_area(0, 0, frame.cols, frame.rows);
-                        cv::Rect tc_label(result.location.x + result.location.width, result.location.y,
-                                          result.location.width / 4, result.location.height / 2);
-                        cv::Rect bc_label(result.location.x + result.location.width, result.location.y + result.location.height / 2,
-                                            result.location.width / 4, result.location.height / 2);
-
-                        if (shouldHandleTopBottomColors) {
-                            frame(tc_label & image_area) = resPersAttrAndColor.top_color;
-                            frame(bc_label & image_area) = resPersAttrAndColor.bottom_color;
-                        }
+            for (size_t i = 0; i < persons.size(); i++) {
+                const PersonDetection::Result& result = persons[i];
+                const PersonAttribsDetection::AttributesAndColorPoints& resPersAttrAndColor = personsAttrAndColor[i];
+                const std::string& resPersReid = personsReid[i];
+
+                // --------------------------- Process outputs -----------------------------------------
+                if (!resPersAttrAndColor.attributes_strings.empty()) {
+                    cv::Rect image_area(0, 0, frame.cols, frame.rows);
+                    cv::Rect tc_label(result.location.x + result.location.width, result.location.y,
+                                      result.location.width / 4, result.location.height / 2);
+                    cv::Rect bc_label(result.location.x + result.location.width, result.location.y + result.location.height / 2,
+                                        result.location.width / 4, result.location.height / 2);
+
+                    if (shouldHandleTopBottomColors) {
+                        frame(tc_label & image_area) = resPersAttrAndColor.top_color;
+                        frame(bc_label & image_area) = resPersAttrAndColor.bottom_color;
+                    }
 
-                        for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i) {
-                            cv::Scalar color;
-                            if (resPersAttrAndColor.attributes_indicators[i]) {
-                                color = cv::Scalar(0, 255, 0);
-                            } else {
-                                color = cv::Scalar(0, 0, 255);
-                            }
-                            cv::putText(frame,
-                                    resPersAttrAndColor.attributes_strings[i],
-                                    cv::Point2f(static_cast<float>(result.location.x + 5 * result.location.width / 4),
-                                                static_cast<float>(result.location.y + 15 + 15 * i)),
-                                    cv::FONT_HERSHEY_COMPLEX_SMALL,
-                                    0.5,
-                                    color);
+                    for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i) {
+                        cv::Scalar color;
+                        if (resPersAttrAndColor.attributes_indicators[i]) {
+                            color = cv::Scalar(0, 255, 0);
+                        } else {
+                            color = cv::Scalar(0, 0, 255);
                         }
+                        cv::putText(frame,
+                                resPersAttrAndColor.attributes_strings[i],
+                                cv::Point2f(static_cast<float>(result.location.x + 5 * result.location.width / 4),
+                                            static_cast<float>(result.location.y + 15 + 15 * i)),
+                                cv::FONT_HERSHEY_COMPLEX_SMALL,
+                                0.5,
+                                color);
+                    }
 
-                        if (FLAGS_r) {
-                            std::string output_attribute_string;
-                            for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i)
-                                if (resPersAttrAndColor.attributes_indicators[i])
-                                    output_attribute_string += resPersAttrAndColor.attributes_strings[i] + ",";
-                            std::cout << "Person Attributes results: " << output_attribute_string << std::endl;
-                            if (shouldHandleTopBottomColors) {
-                                std::cout << "Person top color: " << resPersAttrAndColor.top_color << std::endl;
-                                std::cout << "Person bottom color: " << resPersAttrAndColor.bottom_color << std::endl;
-                            }
+                    if (FLAGS_r) {
+                        std::string output_attribute_string;
+                        for (size_t i = 0; i < resPersAttrAndColor.attributes_strings.size(); ++i)
+                            if (resPersAttrAndColor.attributes_indicators[i])
+                                output_attribute_string += resPersAttrAndColor.attributes_strings[i] + ",";
+                        std::cout << "Person Attributes results: " << output_attribute_string << std::endl;
+                        if (shouldHandleTopBottomColors) {
+                            std::cout << "Person top color: " << resPersAttrAndColor.top_color << std::endl;
+                            std::cout << "Person bottom color: " << resPersAttrAndColor.bottom_color << std::endl;
                         }
                     }
-                    if (!resPersReid.empty()) {
-                        cv::putText(frame,
-                                    resPersReid,
-                                    cv::Point2f(static_cast<float>(result.location.x), static_cast<float>(result.location.y + 30)),
-                                    cv::FONT_HERSHEY_COMPLEX_SMALL,
-                                    0.6,
-                                    cv::Scalar(255, 255, 255));
-
-                        if (FLAGS_r) {
-                            std::cout << "Person Reidentification results:" << resPersReid << std::endl;
-                        }
+                }
+                if (!resPersReid.empty()) {
+                    cv::putText(frame,
+                                resPersReid,
+                                cv::Point2f(static_cast<float>(result.location.x), static_cast<float>(result.location.y + 30)),
+                                cv::FONT_HERSHEY_COMPLEX_SMALL,
+                                0.6,
+                                cv::Scalar(255, 255, 255));
+
+                    if (FLAGS_r) {
+                        std::cout << "Person Reidentification results:" << resPersReid << std::endl;
                     }
-                    cv::rectangle(frame, result.location, cv::Scalar(0, 255, 0), 1);
                 }
+                cv::rectangle(frame, result.location, cv::Scalar(0, 255, 0), 1);
             }
 
             presenter.drawGraphs(frame);
@@ -835,6 +856,9 @@ int main(int argc, char *argv[]) {
         auto total_t1 = std::chrono::high_resolution_clock::now();
         ms total = std::chrono::duration_cast<ms>(total_t1 - total_t0);
         slog::info << "Total Inference time: " << total.count() << slog::endl;
+        if (gatedCap) {
+            slog::info << "Frames skipped by the motion gate: " << gatedCap->getSkippedCount() << slog::endl;
+        }
 
         /** Show performance results **/
         if (FLAGS_pc) {
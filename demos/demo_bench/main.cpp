@@ -0,0 +1,515 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/**
+* \brief The entry point for the demo_bench application, measuring performance of demo models in AsyncPipeline
+* \file demo_bench/main.cpp
+* \example demo_bench/main.cpp
+*/
+
+#include <cctype>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include <samples/args_helper.hpp>
+#include <samples/common.hpp>
+#include <samples/images_capture.h>
+#include <samples/latency_histogram.hpp>
+#include <samples/performance_metrics.hpp>
+#include <samples/slog.hpp>
+
+#include "pipelines/async_pipeline.h"
+#include "pipelines/config_factory.h"
+#include "pipelines/metadata.h"
+#include "pipelines/network_registry.h"
+#include "pipelines/recorded_outputs.h"
+#include "models/detection_model_ssd.h"
+#include "models/detection_model_yolo.h"
+#include "models/segmentation_model.h"
+
+static const char help_message[] = "Print a usage message.";
+static const char at_message[] = "Required. Architecture type: ssd, yolo or segmentation";
+static const char input_message[] = "Optional. Path to a video file, an image or a folder with images. "
+"Frames are read into memory before measurements. If it's not set, random frames of -size are used.";
+static const char model_message[] = "Required. Path to an .xml file with a trained model.";
+static const char target_device_message[] = "Optional. Specify the target device to infer on "
+"(the list of available devices is shown below). Default value is CPU.";
+static const char custom_cldnn_message[] = "Required for GPU custom kernels. "
+"Absolute path to the .xml file with the kernel descriptions.";
+static const char custom_cpu_library_message[] = "Required for CPU custom layers. "
+"Absolute path to a shared library with the kernel implementations.";
+static const char input_resizable_message[] = "Optional. Enables resizable input (SSD and YOLO only).";
+static const char num_inf_req_message[] = "Optional. Comma separated numbers of infer requests to try.";
+static const char num_threads_message[] = "Optional. Comma separated numbers of threads to try (0 is default).";
+static const char num_streams_message[] = "Optional. Semicolon separated values of -nstreams option of the demos "
+"to try, for example \"1;2;CPU:4,GPU:2\". Empty value means default number of streams.";
+static const char batch_message[] = "Optional. Comma separated batch sizes to try.";
+static const char preprocess_threads_message[] = "Optional. Number of threads preprocessing input frames "
+"in background.";
+static const char size_message[] = "Optional. Size of random frames in <width>x<height> format.";
+static const char frames_message[] = "Optional. Maximum number of frames read from the input.";
+static const char time_message[] = "Optional. Duration of measurement for every configuration in seconds.";
+static const char warmup_message[] = "Optional. Number of frames processed before measurement in every "
+"configuration. They include loading of the network to the device caches and the first inference.";
+static const char replay_message[] = "Optional. Path to the file of outputs recorded by -record_outputs of "
+"the demos. Postprocessing of the model is measured on them for -t seconds, the network is only read, "
+"it isn't loaded to any device.";
+static const char submit_api_message[] = "Optional. How frames are submitted to the pipeline: \"poll\" (default) "
+"waits for free requests with waitForData and takes results with getResult, \"continuation\" and \"future\" submit "
+"the frames with AsyncPipeline::submit, which waits for a free request itself, and get the results in a continuation "
+"or through futures.";
+static const char output_message[] = "Optional. Path to the JSON report file. Report is printed to "
+"the standard output if it isn't set.";
+
+DEFINE_bool(h, false, help_message);
+DEFINE_string(at, "", at_message);
+DEFINE_string(i, "", input_message);
+DEFINE_string(m, "", model_message);
+DEFINE_string(d, "CPU", target_device_message);
+DEFINE_string(c, "", custom_cldnn_message);
+DEFINE_string(l, "", custom_cpu_library_message);
+DEFINE_bool(auto_resize, false, input_resizable_message);
+DEFINE_string(nireq, "2", num_inf_req_message);
+DEFINE_string(nthreads, "0", num_threads_message);
+DEFINE_string(nstreams, "", num_streams_message);
+DEFINE_string(b, "1", batch_message);
+DEFINE_uint32(preprocess_threads, 0, preprocess_threads_message);
+DEFINE_string(size, "1280x720", size_message);
+DEFINE_uint32(frames, 100, frames_message);
+DEFINE_double(t, 10, time_message);
+DEFINE_uint32(warmup, 10, warmup_message);
+DEFINE_string(replay, "", replay_message);
+DEFINE_string(submit_api, "poll", submit_api_message);
+DEFINE_string(o, "", output_message);
+
+/**
+* \brief This function shows a help message
+*/
+static void showUsage() {
+    std::cout << std::endl;
+    std::cout << "demo_bench [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "    -h                          " << help_message << std::endl;
+    std::cout << "    -at \"<type>\"                " << at_message << std::endl;
+    std::cout << "    -i \"<path>\"                 " << input_message << std::endl;
+    std::cout << "    -m \"<path>\"                 " << model_message << std::endl;
+    std::cout << "      -l \"<absolute_path>\"      " << custom_cpu_library_message << std::endl;
+    std::cout << "          Or" << std::endl;
+    std::cout << "      -c \"<absolute_path>\"      " << custom_cldnn_message << std::endl;
+    std::cout << "    -d \"<device>\"               " << target_device_message << std::endl;
+    std::cout << "    -auto_resize                " << input_resizable_message << std::endl;
+    std::cout << "    -nireq \"<list>\"             " << num_inf_req_message << std::endl;
+    std::cout << "    -nthreads \"<list>\"          " << num_threads_message << std::endl;
+    std::cout << "    -nstreams \"<list>\"          " << num_streams_message << std::endl;
+    std::cout << "    -b \"<list>\"                 " << batch_message << std::endl;
+    std::cout << "    -preprocess_threads         " << preprocess_threads_message << std::endl;
+    std::cout << "    -size \"<WxH>\"               " << size_message << std::endl;
+    std::cout << "    -frames \"<integer>\"         " << frames_message << std::endl;
+    std::cout << "    -t \"<seconds>\"              " << time_message << std::endl;
+    std::cout << "    -warmup \"<integer>\"         " << warmup_message << std::endl;
+    std::cout << "    -replay \"<path>\"            " << replay_message << std::endl;
+    std::cout << "    -submit_api \"<api>\"         " << submit_api_message << std::endl;
+    std::cout << "    -o \"<path>\"                 " << output_message << std::endl;
+}
+
+bool ParseAndCheckCommandLine(int argc, char *argv[]) {
+    // ---------------------------Parsing and validation of input args--------------------------------------
+    gflags::ParseCommandLineNonHelpFlags(&argc, &argv, true);
+    if (FLAGS_h) {
+        showUsage();
+        showAvailableDevices();
+        return false;
+    }
+    slog::info << "Parsing input parameters" << slog::endl;
+
+    if (FLAGS_m.empty()) {
+        throw std::logic_error("Parameter -m is not set");
+    }
+
+    if (FLAGS_at.empty()) {
+        throw std::logic_error("Parameter -at is not set");
+    }
+
+    if (FLAGS_t <= 0) {
+        throw std::logic_error("Parameter -t must be positive");
+    }
+
+    if (FLAGS_submit_api != "poll" && FLAGS_submit_api != "continuation" && FLAGS_submit_api != "future") {
+        throw std::logic_error("Parameter -submit_api must be poll, continuation or future");
+    }
+
+    return true;
+}
+
+namespace {
+struct BenchConfig {
+    uint32_t nireq;
+    std::string nstreams;
+    uint32_t nthreads;
+    uint32_t batch;
+};
+
+struct BenchResult {
+    size_t framesCount;
+    double fps;
+    /// End to end latency of frames (from submission to getting the result) in milliseconds
+    double latencyMean, latencyP50, latencyP90, latencyP99, latencyMax;
+    std::string stagesJson;
+};
+
+std::vector<uint32_t> parseNumbers(const std::string& list, const char* flagName) {
+    std::vector<uint32_t> numbers;
+    for (const std::string& item : split(list, ',')) {
+        try {
+            numbers.push_back(static_cast<uint32_t>(std::stoul(item)));
+        } catch (const std::logic_error&) {
+            throw std::invalid_argument(std::string("Can't parse the value \"") + item + "\" of -" + flagName);
+        }
+    }
+    if (numbers.empty()) {
+        throw std::invalid_argument(std::string("Parameter -") + flagName + " is empty");
+    }
+    return numbers;
+}
+
+std::vector<cv::Mat> readFrames() {
+    std::vector<cv::Mat> frames;
+    if (FLAGS_i.empty()) {
+        std::vector<std::string> sizes = split(FLAGS_size, 'x');
+        if (sizes.size() != 2) {
+            throw std::invalid_argument("Can't parse the value of -size: " + FLAGS_size);
+        }
+        cv::Mat frame(std::stoi(sizes[1]), std::stoi(sizes[0]), CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+        frames.push_back(frame);
+        return frames;
+    }
+
+    std::unique_ptr<ImagesCapture> cap = openImagesCapture(FLAGS_i, false, 0, FLAGS_frames);
+    for (cv::Mat frame = cap->read(); frame.data; frame = cap->read()) {
+        frames.push_back(frame);
+    }
+    if (frames.empty()) {
+        throw std::logic_error("Can't read an image from the input");
+    }
+    return frames;
+}
+
+std::unique_ptr<ModelBase> createModel() {
+    if (FLAGS_at == "ssd") {
+        return std::unique_ptr<ModelBase>(new ModelSSD(FLAGS_m, 0.5f, FLAGS_auto_resize));
+    }
+    if (FLAGS_at == "yolo") {
+        return std::unique_ptr<ModelBase>(new ModelYolo3(FLAGS_m, 0.5f, FLAGS_auto_resize, false, 0.4f));
+    }
+    if (FLAGS_at == "segmentation") {
+        return std::unique_ptr<ModelBase>(new SegmentationModel(FLAGS_m));
+    }
+    throw std::invalid_argument("No model type or invalid model type (-at) provided: " + FLAGS_at);
+}
+
+BenchResult runConfig(const BenchConfig& benchConfig, const std::vector<cv::Mat>& frames,
+                      InferenceEngine::Core& core, NetworkRegistry& networkRegistry) {
+    CnnConfig cnnConfig = ConfigFactory::getUserConfig(FLAGS_d, FLAGS_l, FLAGS_c, false,
+        benchConfig.nireq, benchConfig.nstreams, benchConfig.nthreads);
+    cnnConfig.maxBatchSize = benchConfig.batch;
+    cnnConfig.preprocessThreads = FLAGS_preprocess_threads;
+    cnnConfig.networkRegistry = &networkRegistry;
+    AsyncPipeline pipeline(createModel(), cnnConfig, core);
+
+    size_t nextFrame = 0;
+    size_t submittedCount = 0;
+    size_t completedCount = 0;
+    PerformanceMetrics metrics;
+    LatencyHistogram latencies;
+    bool isMeasuring = false;
+
+    auto recordResult = [&](const ResultBase& result) {
+        if (isMeasuring) {
+            latencies.record(std::chrono::steady_clock::now() - result.metaData->asRef<ImageMetaData>().timeStamp);
+        }
+        ++completedCount;
+    };
+
+    auto processResults = [&]() {
+        while (std::unique_ptr<ResultBase> result = pipeline.getResult()) {
+            recordResult(*result);
+            pipeline.releaseResult(std::move(result));
+        }
+    };
+
+    auto nextInput = [&]() -> const cv::Mat& {
+        const cv::Mat& frame = frames[nextFrame];
+        nextFrame = (nextFrame + 1) % frames.size();
+        ++submittedCount;
+        return frame;
+    };
+
+    // Continuations are called from the dispatcher thread of the pipeline
+    std::mutex resultsMutex;
+    auto continuation = [&](std::unique_ptr<ResultBase>&& result, const std::exception_ptr&) {
+        // The error is rethrown by submit or waitForSubmittedResults
+        if (!result)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            recordResult(*result);
+        }
+        pipeline.releaseResult(std::move(result));
+    };
+    std::deque<std::future<std::unique_ptr<ResultBase>>> futures;
+
+    auto runFor = [&](const std::function<bool()>& shouldSubmit) {
+        if (FLAGS_submit_api == "continuation") {
+            while (shouldSubmit()) {
+                const cv::Mat& frame = nextInput();
+                pipeline.submit(ImageInputData(frame), makeImageMetaData(frame, std::chrono::steady_clock::now()),
+                    continuation);
+            }
+            pipeline.waitForSubmittedResults();
+        }
+        else if (FLAGS_submit_api == "future") {
+            while (shouldSubmit()) {
+                const cv::Mat& frame = nextInput();
+                futures.push_back(pipeline.submit(ImageInputData(frame),
+                    makeImageMetaData(frame, std::chrono::steady_clock::now())));
+                while (!futures.empty()
+                       && futures.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    recordResult(*futures.front().get());
+                    futures.pop_front();
+                }
+            }
+            pipeline.waitForSubmittedResults();
+            for (auto& future : futures) {
+                recordResult(*future.get());
+            }
+            futures.clear();
+        }
+        else {
+            while (shouldSubmit()) {
+                if (pipeline.isReadyToProcess()) {
+                    const cv::Mat& frame = nextInput();
+                    pipeline.submitData(ImageInputData(frame),
+                        makeImageMetaData(frame, std::chrono::steady_clock::now()));
+                }
+                pipeline.waitForData();
+                processResults();
+            }
+            pipeline.waitForTotalCompletion();
+            processResults();
+        }
+    };
+
+    // Warm up without metrics, so the first slow inferences don't affect the results
+    runFor([&]() { return submittedCount < FLAGS_warmup; });
+
+    // There are no requests in flight now, so it's safe to attach metrics to the pipeline
+    pipeline.setPerformanceMetrics(&metrics);
+    isMeasuring = true;
+    completedCount = 0;
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto endTime = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(FLAGS_t));
+    runFor([&]() { return std::chrono::steady_clock::now() < endTime; });
+    const double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    pipeline.setPerformanceMetrics(nullptr);
+    if (completedCount == 0) {
+        throw std::runtime_error("No frames were processed in -t seconds");
+    }
+
+    BenchResult result;
+    result.framesCount = completedCount;
+    result.fps = completedCount / elapsedSeconds;
+    result.latencyMean = latencies.getMean();
+    result.latencyP50 = latencies.getPercentile(50);
+    result.latencyP90 = latencies.getPercentile(90);
+    result.latencyP99 = latencies.getPercentile(99);
+    result.latencyMax = latencies.getMax();
+    std::ostringstream stages;
+    metrics.exportStages(stages, PerformanceMetrics::ExportFormat::Json);
+    result.stagesJson = stages.str();
+    while (!result.stagesJson.empty() && isspace(static_cast<unsigned char>(result.stagesJson.back()))) {
+        result.stagesJson.pop_back();
+    }
+    return result;
+}
+
+std::string escapeJson(const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+/// Postprocesses the recorded outputs for -t seconds, one frame after another, so the report has
+/// the throughput and the latencies of postprocessing alone
+std::string runReplay(InferenceEngine::Core& core) {
+    RecordedOutputs recordedOutputs(FLAGS_replay);
+    if (recordedOutputs.size() == 0) {
+        throw std::runtime_error("No frames are recorded in " + FLAGS_replay);
+    }
+
+    // The model is prepared as AsyncPipeline does it, but the network isn't loaded
+    std::unique_ptr<ModelBase> model = createModel();
+    InferenceEngine::CNNNetwork cnnNetwork = core.ReadNetwork(FLAGS_m);
+    auto shapes = cnnNetwork.getInputShapes();
+    for (auto& shape : shapes) {
+        shape.second[0] = recordedOutputs.getBatchSize();
+    }
+    cnnNetwork.reshape(shapes);
+    model->prepareInputsOutputs(cnnNetwork);
+
+    std::vector<InferenceResult> frames;
+    for (size_t i = 0; i < recordedOutputs.size(); ++i) {
+        frames.push_back(recordedOutputs.getResult(i));
+    }
+    size_t nextFrame = 0;
+    auto postprocessNext = [&]() {
+        model->recycleResult(model->postprocess(frames[nextFrame]));
+        nextFrame = (nextFrame + 1) % frames.size();
+    };
+
+    for (uint32_t i = 0; i < FLAGS_warmup; ++i) {
+        postprocessNext();
+    }
+    LatencyHistogram latencies;
+    size_t framesCount = 0;
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto endTime = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(FLAGS_t));
+    auto frameStartTime = startTime;
+    while (frameStartTime < endTime) {
+        postprocessNext();
+        const auto frameEndTime = std::chrono::steady_clock::now();
+        latencies.record(frameEndTime - frameStartTime);
+        frameStartTime = frameEndTime;
+        ++framesCount;
+    }
+    const double elapsedSeconds = std::chrono::duration<double>(frameStartTime - startTime).count();
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3);
+    report << "{\"model\": \"" << escapeJson(FLAGS_m) << "\", \"architecture\": \"" << escapeJson(FLAGS_at)
+           << "\", \"replay\": \"" << escapeJson(FLAGS_replay) << "\", \"recorded_frames\": " << frames.size()
+           << ", \"frames\": " << framesCount << ", \"fps\": " << framesCount / elapsedSeconds
+           << ", \"latency_ms\": {\"mean\": " << latencies.getMean() << ", \"p50\": " << latencies.getPercentile(50)
+           << ", \"p90\": " << latencies.getPercentile(90) << ", \"p99\": " << latencies.getPercentile(99)
+           << ", \"max\": " << latencies.getMax() << "}}" << std::endl;
+    return report.str();
+}
+
+void writeReport(const std::string& report) {
+    if (FLAGS_o.empty()) {
+        std::cout << report;
+    } else {
+        std::ofstream out(FLAGS_o);
+        if (!out) {
+            throw std::runtime_error("Can't open " + FLAGS_o + " for writing");
+        }
+        out << report;
+    }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    try {
+        slog::info << "InferenceEngine: " << printable(*InferenceEngine::GetInferenceEngineVersion()) << slog::endl;
+
+        // ------------------------------ Parsing and validation of input args ---------------------------------
+        if (!ParseAndCheckCommandLine(argc, argv)) {
+            return 0;
+        }
+
+        if (!FLAGS_replay.empty()) {
+            slog::info << "Replaying " << FLAGS_replay << slog::endl;
+            InferenceEngine::Core core;
+            writeReport(runReplay(core));
+            slog::info << slog::endl << "The execution has completed successfully" << slog::endl;
+            return 0;
+        }
+
+        std::vector<BenchConfig> benchConfigs;
+        for (uint32_t nireq : parseNumbers(FLAGS_nireq, "nireq")) {
+            for (const std::string& nstreams : FLAGS_nstreams.empty() ? std::vector<std::string>{""}
+                                                                      : split(FLAGS_nstreams, ';')) {
+                for (uint32_t nthreads : parseNumbers(FLAGS_nthreads, "nthreads")) {
+                    for (uint32_t batch : parseNumbers(FLAGS_b, "b")) {
+                        benchConfigs.push_back({nireq, nstreams, nthreads, batch});
+                    }
+                }
+            }
+        }
+
+        //------------------------------- Preparing Input ------------------------------------------------------
+        slog::info << "Reading input" << slog::endl;
+        std::vector<cv::Mat> frames = readFrames();
+
+        //------------------------------- Running configurations -----------------------------------------------
+        InferenceEngine::Core core;
+        // Configurations differing in -nireq only reuse the loaded network
+        NetworkRegistry networkRegistry;
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(3);
+        report << "{\"model\": \"" << escapeJson(FLAGS_m) << "\", \"architecture\": \"" << escapeJson(FLAGS_at)
+               << "\", \"device\": \"" << escapeJson(FLAGS_d) << "\", \"input_frames\": " << frames.size()
+               << ", \"runs\": [";
+        for (size_t i = 0; i < benchConfigs.size(); ++i) {
+            const BenchConfig& benchConfig = benchConfigs[i];
+            slog::info << "Running nireq=" << benchConfig.nireq << " nstreams=\"" << benchConfig.nstreams
+                       << "\" nthreads=" << benchConfig.nthreads << " batch=" << benchConfig.batch << slog::endl;
+            BenchResult result = runConfig(benchConfig, frames, core, networkRegistry);
+            slog::info << "\tFPS: " << result.fps << slog::endl;
+
+            report << (i ? ", " : "") << "{\"nireq\": " << benchConfig.nireq
+                   << ", \"nstreams\": \"" << escapeJson(benchConfig.nstreams)
+                   << "\", \"nthreads\": " << benchConfig.nthreads << ", \"batch\": " << benchConfig.batch
+                   << ", \"frames\": " << result.framesCount << ", \"fps\": " << result.fps
+                   << ", \"latency_ms\": {\"mean\": " << result.latencyMean << ", \"p50\": " << result.latencyP50
+                   << ", \"p90\": " << result.latencyP90 << ", \"p99\": " << result.latencyP99
+                   << ", \"max\": " << result.latencyMax << "}, \"metrics\": " << result.stagesJson << "}";
+        }
+        report << "]}" << std::endl;
+
+        //// --------------------------- Report metrics -------------------------------------------------------
+        writeReport(report.str());
+    }
+    catch (const std::exception& error) {
+        slog::err << "[ ERROR ] " << error.what() << slog::endl;
+        return 1;
+    }
+    catch (...) {
+        slog::err << "[ ERROR ] Unknown/internal exception happened." << slog::endl;
+        return 1;
+    }
+
+    slog::info << slog::endl << "The execution has completed successfully" << slog::endl;
+    return 0;
+}
@@ -39,6 +39,9 @@ static const char target_device_message_es[] = "Optional. Target device for Open
 static const char performance_counter_message[] = "Optional. Enable per-layer performance report.";
 static const char thresh_output_message[] = "Optional. Probability threshold for Face Detector. The default value is 0.5.";
 static const char raw_output_message[] = "Optional. Output inference results as raw values.";
+static const char motion_threshold_message[] = "Optional. Keep head pose and gaze of a face until its bounding box or "
+                                               "eye landmarks move by more than this fraction of the face width since they were "
+                                               "estimated. The default value 0 estimates them on every frame.";
 static const char fd_reshape_message[] = "Optional. Reshape Face Detector network so that its input resolution has the same aspect ratio as the input frame.";
 static const char no_show_processed_video[] = "Optional. Do not show processed video.";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
@@ -56,6 +59,7 @@ DEFINE_string(d_hp, "CPU", target_device_message_hp);
 DEFINE_string(d_lm, "CPU", target_device_message_lm);
 DEFINE_string(d_es, "CPU", target_device_message_es);
 DEFINE_bool(fd_reshape, false, fd_reshape_message);
+DEFINE_double(motion_thr, 0, motion_threshold_message);
 DEFINE_bool(pc, false, performance_counter_message);
 DEFINE_bool(r, false, raw_output_message);
 DEFINE_double(t, 0.5, thresh_output_message);
@@ -86,6 +90,7 @@ static void showUsage() {
     std::cout << "    -d_lm \"<device>\"         " << target_device_message_lm << std::endl;
     std::cout << "    -d_es \"<device>\"         " << target_device_message_es << std::endl;
     std::cout << "    -fd_reshape              " << fd_reshape_message << std::endl;
+    std::cout << "    -motion_thr              " << motion_threshold_message << std::endl;
     std::cout << "    -no_show                 " << no_show_processed_video << std::endl;
     std::cout << "    -pc                      " << performance_counter_message << std::endl;
     std::cout << "    -r                       " << raw_output_message << std::endl;
@@ -4,13 +4,26 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include "face_inference_results.hpp"
 
 namespace gaze_estimation {
 class BaseEstimator {
 public:
-    void virtual estimate(const cv::Mat& image,
-                          FaceInferenceResults& outputResults) = 0;
+    // Starts the inference on one face, the faces started on different requestIds are inferred in parallel.
+    // The results of the estimators it depends on must be ready
+    void virtual startEstimation(const cv::Mat& image,
+                                 FaceInferenceResults& outputResults,
+                                 size_t requestId) = 0;
+    // Waits for the inference of startEstimation() with the same requestId and writes its results
+    void virtual finishEstimation(FaceInferenceResults& outputResults,
+                                  size_t requestId) = 0;
+    void estimate(const cv::Mat& image,
+                  FaceInferenceResults& outputResults) {
+        startEstimation(image, outputResults, 0);
+        finishEstimation(outputResults, 0);
+    }
     void virtual printPerformanceCounts() const = 0;
     virtual ~BaseEstimator() = default;
 };
@@ -18,15 +18,19 @@ public:
     EyeStateEstimator(InferenceEngine::Core& ie,
                       const std::string& modelPath,
                       const std::string& deviceName);
-    void estimate(const cv::Mat& image, FaceInferenceResults& outputResults) override;
+    void startEstimation(const cv::Mat& image,
+                         FaceInferenceResults& outputResults,
+                         size_t requestId) override;
+    void finishEstimation(FaceInferenceResults& outputResults,
+                          size_t requestId) override;
     void printPerformanceCounts() const override;
     ~EyeStateEstimator() override;
 
 private:
     cv::Rect createEyeBoundingBox(const cv::Point2i& p1, const cv::Point2i& p2, float scale = 1.8) const;
-    void rotateImageAroundCenter(const cv::Mat& srcImage, cv::Mat& dstImage, float angle) const;
 
     IEWrapper ieWrapper;
     std::string inputBlobName, outputBlobName;
+    cv::Size inputSize;
 };
 }  // namespace gaze_estimation
@@ -19,8 +19,11 @@ public:
                   const std::string& modelPath,
                   const std::string& deviceName,
                   bool doRollAlign = true);
-    void estimate(const cv::Mat& image,
-                  FaceInferenceResults& outputResults) override;
+    void startEstimation(const cv::Mat& image,
+                         FaceInferenceResults& outputResults,
+                         size_t requestId) override;
+    void finishEstimation(FaceInferenceResults& outputResults,
+                          size_t requestId) override;
     void printPerformanceCounts() const override;
     ~GazeEstimator() override;
 
@@ -28,7 +31,6 @@ private:
     IEWrapper ieWrapper;
     std::string outputBlobName;
     bool rollAlign;
-
-    void rotateImageAroundCenter(const cv::Mat& srcImage, cv::Mat& dstImage, float angle) const;
+    cv::Size leftEyeInputSize, rightEyeInputSize;
 };
 }  // namespace gaze_estimation
@@ -20,17 +20,24 @@ public:
     IEWrapper(InferenceEngine::Core& ie,
               const std::string& modelPath,
               const std::string& deviceName);
+    // The methods taking requestId work with a pool of infer requests, which grows when a new requestId comes.
+    // All of the requests may run at the same time
+
     // For setting input blobs containing images
-    void setInputBlob(const std::string& blobName, const cv::Mat& image);
+    void setInputBlob(const std::string& blobName, const cv::Mat& image, size_t requestId = 0);
+    // For setting input blobs containing images warped straight to the blob size, e.g. rotated and resized ROIs
+    void warpInputBlob(const std::string& blobName, const cv::Mat& image, const cv::Mat& transform,
+                       size_t requestId = 0);
     // For setting input blobs containing vectors of data
-    void setInputBlob(const std::string& blobName, const std::vector<float>& data);
+    void setInputBlob(const std::string& blobName, const std::vector<float>& data, size_t requestId = 0);
 
     // Get output blob content as a vector given its name
-    void getOutputBlob(const std::string& blobName, std::vector<float>& output);
+    void getOutputBlob(const std::string& blobName, std::vector<float>& output, size_t requestId = 0);
 
     void printPerlayerPerformance() const;
 
     const std::map<std::string, std::vector<unsigned long>>& getInputBlobDimsInfo() const;
+    cv::Size getInputImageSize(const std::string& blobName) const;
     const std::map<std::string, std::vector<unsigned long>>& getOutputBlobDimsInfo() const;
 
     std::string expectSingleInput() const;
@@ -40,7 +47,9 @@ public:
 
     void reshape(const std::map<std::string, std::vector<unsigned long>>& newBlobsDimsInfo);
 
-    void infer();
+    void infer(size_t requestId = 0);
+    void startAsync(size_t requestId);
+    void wait(size_t requestId);
 
 private:
     std::string modelPath;
@@ -48,10 +57,11 @@ private:
     InferenceEngine::Core& ie;
     InferenceEngine::CNNNetwork network;
     InferenceEngine::ExecutableNetwork executableNetwork;
-    InferenceEngine::InferRequest request;
+    std::vector<InferenceEngine::InferRequest> requests;
     std::map<std::string, std::vector<unsigned long>> inputBlobsDimsInfo;
     std::map<std::string, std::vector<unsigned long>> outputBlobsDimsInfo;
 
     void setExecPart();
+    InferenceEngine::InferRequest& getRequest(size_t requestId);
 };
 }  // namespace gaze_estimation
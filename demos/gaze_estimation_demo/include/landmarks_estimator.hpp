@@ -18,8 +18,11 @@ public:
     LandmarksEstimator(InferenceEngine::Core& ie,
                        const std::string& modelPath,
                        const std::string& deviceName);
-    void estimate(const cv::Mat& image,
-                  FaceInferenceResults& outputResults) override;
+    void startEstimation(const cv::Mat& image,
+                         FaceInferenceResults& outputResults,
+                         size_t requestId) override;
+    void finishEstimation(FaceInferenceResults& outputResults,
+                          size_t requestId) override;
     void printPerformanceCounts() const override;
     ~LandmarksEstimator() override;
 
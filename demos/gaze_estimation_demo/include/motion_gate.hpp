@@ -0,0 +1,52 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "face_inference_results.hpp"
+
+namespace gaze_estimation {
+// Keeps the head pose and the gaze of the faces which barely moved since they were last estimated, so that their
+// estimation can be skipped. The faces of consecutive frames are matched by their bounding boxes
+class MotionGate {
+public:
+    // The motion is measured in face widths, a non-positive threshold keeps nothing
+    explicit MotionGate(double threshold);
+
+    // Matches the detected faces to the faces of the previous frame
+    void matchFaces(const std::vector<FaceInferenceResults>& faces);
+    // If the face box stayed, copies the kept head pose to the face and returns true
+    bool keepHeadPose(size_t faceId, FaceInferenceResults& face);
+    // If the face box and the eye landmarks stayed, copies the kept gaze to the face and returns true.
+    // Needs the landmarks and the eye states
+    bool keepGaze(size_t faceId, FaceInferenceResults& face);
+    // Remembers the results of the frame, the newly estimated ones become the kept ones
+    void update(const std::vector<FaceInferenceResults>& faces);
+
+private:
+    struct KeptResults {
+        cv::Rect faceBoundingBox;  // in the last frame, for matching
+
+        cv::Rect headPoseFaceBoundingBox;
+        cv::Point3f headPoseAngles;
+
+        cv::Rect gazeFaceBoundingBox;
+        std::vector<cv::Point2i> gazeEyeLandmarks;
+        bool hasGaze;
+        cv::Point3f gazeVector;
+    };
+
+    double threshold;
+    std::vector<KeptResults> keptResults;
+    std::vector<int> matches;  // the kept results of each face of the current frame, -1 for the new faces
+    std::vector<char> isHeadPoseKept, isGazeKept;
+
+    double boxMotion(const cv::Rect& from, const cv::Rect& to) const;
+};
+}  // namespace gaze_estimation
@@ -20,6 +20,11 @@ namespace gaze_estimation {
 void initializeIEObject(InferenceEngine::Core& ie,
                         const std::vector<std::pair<std::string, std::string>>& cmdOptions);
 
+// The transform from image coordinates to a blob image of the given size, the eye bounding box is rotated by roll
+// around its center and resized to the blob image. The eye isn't cropped, so the pixels around the box are used
+// for the rotated corners
+cv::Mat eyeToBlobTransform(const cv::Rect& eyeBoundingBox, float roll, const cv::Size& blobImageSize);
+
 void gazeVectorToGazeAngles(const cv::Point3f& gazeVector, cv::Point2f& gazeAngles);
 
 void putTimingInfoOnFrame(cv::Mat& image, double overallTime, double inferenceTime);
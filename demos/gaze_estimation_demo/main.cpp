@@ -45,6 +45,8 @@
 #include "eye_state_estimator.hpp"
 #include "gaze_estimator.hpp"
 
+#include "motion_gate.hpp"
+
 #include "results_marker.hpp"
 
 #include "exponential_averager.hpp"
@@ -114,6 +116,11 @@ int main(int argc, char *argv[]) {
 
         // Put pointers to all estimators in an array so that they could be processed uniformly in a loop
         BaseEstimator* estimators[] = {&headPoseEstimator, &landmarksEstimator, &eyeStateEstimator, &gazeEstimator};
+        // The estimators of a stage need only the results of the previous stages, so all faces of a frame go
+        // through the estimators of a stage in parallel
+        const std::vector<std::vector<BaseEstimator*>> estimationStages = {
+            {&headPoseEstimator, &landmarksEstimator}, {&eyeStateEstimator}, {&gazeEstimator}};
+        MotionGate motionGate(FLAGS_motion_thr);
         // Each element of the vector contains inference results on one face
         std::vector<FaceInferenceResults> inferenceResults;
 
@@ -146,11 +153,30 @@ int main(int argc, char *argv[]) {
             // Infer results
             auto tInferenceBegins = cv::getTickCount();
             auto inferenceResults = faceDetector.detect(frame);
-            for (auto& inferenceResult : inferenceResults) {
-                for (auto estimator : estimators) {
-                    estimator->estimate(frame, inferenceResult);
+            motionGate.matchFaces(inferenceResults);
+            for (const auto& stage : estimationStages) {
+                // The estimation is skipped for the results kept by the motion gate
+                std::vector<std::vector<char>> isEstimated(stage.size(), std::vector<char>(inferenceResults.size()));
+                for (size_t i = 0; i < inferenceResults.size(); i++) {
+                    for (size_t j = 0; j < stage.size(); j++) {
+                        FaceInferenceResults& face = inferenceResults[i];
+                        bool isKept = (stage[j] == &headPoseEstimator && motionGate.keepHeadPose(i, face))
+                            || (stage[j] == &gazeEstimator && motionGate.keepGaze(i, face));
+                        if (!isKept) {
+                            stage[j]->startEstimation(frame, inferenceResults[i], i);
+                            isEstimated[j][i] = 1;
+                        }
+                    }
+                }
+                for (size_t i = 0; i < inferenceResults.size(); i++) {
+                    for (size_t j = 0; j < stage.size(); j++) {
+                        if (isEstimated[j][i]) {
+                            stage[j]->finishEstimation(inferenceResults[i], i);
+                        }
+                    }
                 }
             }
+            motionGate.update(inferenceResults);
             auto tInferenceEnds = cv::getTickCount();
 
             // Measure FPS
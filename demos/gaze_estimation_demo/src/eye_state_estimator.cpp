@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "eye_state_estimator.hpp"
+#include "utils.hpp"
 
 namespace gaze_estimation {
 
@@ -16,6 +17,7 @@ EyeStateEstimator::EyeStateEstimator(InferenceEngine::Core& ie,
     inputBlobName = ieWrapper.expectSingleInput();
     ieWrapper.expectImageInput(inputBlobName);
     outputBlobName = ieWrapper.expectSingleOutput();
+    inputSize = ieWrapper.getInputImageSize(inputBlobName);
 }
 
 cv::Rect EyeStateEstimator::createEyeBoundingBox(const cv::Point2i& p1,
@@ -35,53 +37,46 @@ cv::Rect EyeStateEstimator::createEyeBoundingBox(const cv::Point2i& p1,
     return result;
 }
 
-void EyeStateEstimator::rotateImageAroundCenter(const cv::Mat& srcImage,
-                                                cv::Mat& dstImage,
-                                                float angle) const {
-    auto w = srcImage.cols;
-    auto h = srcImage.rows;
-
-    cv::Size size(w, h);
-
-    cv::Point2f center(static_cast<float>(w / 2), static_cast<float>(h / 2));
-
-    auto rotMatrix = cv::getRotationMatrix2D(center, static_cast<double>(angle), 1);
-    cv::warpAffine(srcImage, dstImage, rotMatrix, size, 1, cv::BORDER_REPLICATE);
-}
-
-void EyeStateEstimator::estimate(const cv::Mat& image, FaceInferenceResults& outputResults) {
+void EyeStateEstimator::startEstimation(const cv::Mat& image,
+                                        FaceInferenceResults& outputResults,
+                                        size_t requestId) {
+    // The eyes are inferred on two requests of their own
     auto roll = outputResults.headPoseAngles.z;
 
     outputResults.leftEyeMidpoint = (outputResults.faceLandmarks[0] + outputResults.faceLandmarks[1]) / 2;
     auto leftEyeBoundingBox = createEyeBoundingBox(outputResults.faceLandmarks[0], outputResults.faceLandmarks[1]);
     outputResults.leftEyeBoundingBox = leftEyeBoundingBox;
     if (leftEyeBoundingBox.area()) {
-        auto leftEyeImage(cv::Mat(image, leftEyeBoundingBox));
-        cv::Mat leftEyeImageRotated;
-        rotateImageAroundCenter(leftEyeImage, leftEyeImageRotated, roll);
-        leftEyeImage = leftEyeImageRotated;
-        std::vector<float> outputValue;
-        ieWrapper.setInputBlob(inputBlobName, leftEyeImage);
-        ieWrapper.infer();
-        ieWrapper.getOutputBlob(outputBlobName, outputValue);
-        outputResults.leftEyeState = outputValue[0] < outputValue[1];
-    } else {
-        // Landmarks collapsed and the eye takes no area on image, pretend it's closed
-        outputResults.leftEyeState = false;
+        ieWrapper.warpInputBlob(inputBlobName, image, eyeToBlobTransform(leftEyeBoundingBox, roll, inputSize),
+                                2 * requestId);
+        ieWrapper.startAsync(2 * requestId);
     }
 
     outputResults.rightEyeMidpoint = (outputResults.faceLandmarks[2] + outputResults.faceLandmarks[3]) / 2;
     auto rightEyeBoundingBox = createEyeBoundingBox(outputResults.faceLandmarks[2], outputResults.faceLandmarks[3]);
     outputResults.rightEyeBoundingBox = rightEyeBoundingBox;
     if (rightEyeBoundingBox.area()) {
-        auto rightEyeImage(cv::Mat(image, rightEyeBoundingBox));
-        cv::Mat rightEyeImageRotated;
-        rotateImageAroundCenter(rightEyeImage, rightEyeImageRotated, roll);
-        rightEyeImage = rightEyeImageRotated;
-        std::vector<float> outputValue;
-        ieWrapper.setInputBlob(inputBlobName, rightEyeImage);
-        ieWrapper.infer();
-        ieWrapper.getOutputBlob(outputBlobName, outputValue);
+        ieWrapper.warpInputBlob(inputBlobName, image, eyeToBlobTransform(rightEyeBoundingBox, roll, inputSize),
+                                2 * requestId + 1);
+        ieWrapper.startAsync(2 * requestId + 1);
+    }
+}
+
+void EyeStateEstimator::finishEstimation(FaceInferenceResults& outputResults,
+                                         size_t requestId) {
+    std::vector<float> outputValue;
+    if (outputResults.leftEyeBoundingBox.area()) {
+        ieWrapper.wait(2 * requestId);
+        ieWrapper.getOutputBlob(outputBlobName, outputValue, 2 * requestId);
+        outputResults.leftEyeState = outputValue[0] < outputValue[1];
+    } else {
+        // Landmarks collapsed and the eye takes no area on image, pretend it's closed
+        outputResults.leftEyeState = false;
+    }
+
+    if (outputResults.rightEyeBoundingBox.area()) {
+        ieWrapper.wait(2 * requestId + 1);
+        ieWrapper.getOutputBlob(outputBlobName, outputValue, 2 * requestId + 1);
         outputResults.rightEyeState = outputValue[0] < outputValue[1];
     } else {
         // Landmarks collapsed and the eye takes no area on image, pretend it's closed
@@ -7,6 +7,7 @@
 #include <cmath>
 
 #include "gaze_estimator.hpp"
+#include "utils.hpp"
 
 namespace gaze_estimation {
 
@@ -45,24 +46,14 @@ GazeEstimator::GazeEstimator(InferenceEngine::Core& ie,
 
     outputBlobName = ieWrapper.expectSingleOutput();
     expectAngles(outputBlobName, outputInfo.at(outputBlobName));
-}
-
-void GazeEstimator::rotateImageAroundCenter(const cv::Mat& srcImage,
-                                              cv::Mat& dstImage,
-                                              float angle) const {
-    auto w = srcImage.cols;
-    auto h = srcImage.rows;
-
-    cv::Size size(w, h);
 
-    cv::Point2f center(static_cast<float>(w / 2), static_cast<float>(h / 2));
-
-    auto rotMatrix = cv::getRotationMatrix2D(center, static_cast<double>(angle), 1);
-    cv::warpAffine(srcImage, dstImage, rotMatrix, size, 1, cv::BORDER_REPLICATE);
+    leftEyeInputSize = ieWrapper.getInputImageSize(BLOB_LEFT_EYE_IMAGE);
+    rightEyeInputSize = ieWrapper.getInputImageSize(BLOB_RIGHT_EYE_IMAGE);
 }
 
-void GazeEstimator::estimate(const cv::Mat& image,
-                             FaceInferenceResults& outputResults) {
+void GazeEstimator::startEstimation(const cv::Mat& image,
+                                    FaceInferenceResults& outputResults,
+                                    size_t requestId) {
     if (!outputResults.leftEyeState && !outputResults.rightEyeState)
         return;
     std::vector<float> headPoseAngles(3);
@@ -71,27 +62,34 @@ void GazeEstimator::estimate(const cv::Mat& image,
     headPoseAngles[1] = outputResults.headPoseAngles.y;
     headPoseAngles[2] = roll;
 
-    cv::Mat leftEyeImage(image, outputResults.leftEyeBoundingBox);
-    cv::Mat rightEyeImage(image, outputResults.rightEyeBoundingBox);
-
+    // The eyes are warped from the whole image by the same bounding boxes the eye state estimator used
+    float eyeRoll = 0;
     if (rollAlign) {
         headPoseAngles[2] = 0;
-        cv::Mat leftEyeImageRotated, rightEyeImageRotated;
-        rotateImageAroundCenter(leftEyeImage, leftEyeImageRotated, roll);
-        rotateImageAroundCenter(rightEyeImage, rightEyeImageRotated, roll);
-        leftEyeImage = leftEyeImageRotated;
-        rightEyeImage = rightEyeImageRotated;
+        eyeRoll = roll;
     }
 
-    ieWrapper.setInputBlob(BLOB_HEAD_POSE_ANGLES, headPoseAngles);
-    ieWrapper.setInputBlob(BLOB_LEFT_EYE_IMAGE, leftEyeImage);
-    ieWrapper.setInputBlob(BLOB_RIGHT_EYE_IMAGE, rightEyeImage);
+    ieWrapper.setInputBlob(BLOB_HEAD_POSE_ANGLES, headPoseAngles, requestId);
+    ieWrapper.warpInputBlob(BLOB_LEFT_EYE_IMAGE, image,
+        eyeToBlobTransform(outputResults.leftEyeBoundingBox, eyeRoll, leftEyeInputSize), requestId);
+    ieWrapper.warpInputBlob(BLOB_RIGHT_EYE_IMAGE, image,
+        eyeToBlobTransform(outputResults.rightEyeBoundingBox, eyeRoll, rightEyeInputSize), requestId);
+
+    ieWrapper.startAsync(requestId);
+}
+
+void GazeEstimator::finishEstimation(FaceInferenceResults& outputResults,
+                                     size_t requestId) {
+    // startEstimation() skips the faces with both eyes closed
+    if (!outputResults.leftEyeState && !outputResults.rightEyeState)
+        return;
+    auto roll = outputResults.headPoseAngles.z;
 
-    ieWrapper.infer();
+    ieWrapper.wait(requestId);
 
     std::vector<float> rawResults;
 
-    ieWrapper.getOutputBlob(outputBlobName, rawResults);
+    ieWrapper.getOutputBlob(outputBlobName, rawResults, requestId);
 
     cv::Point3f gazeVector;
     gazeVector.x = rawResults[0];
@@ -39,18 +39,24 @@ HeadPoseEstimator::HeadPoseEstimator(InferenceEngine::Core& ie,
     }
 }
 
-void HeadPoseEstimator::estimate(const cv::Mat& image,
-                                 FaceInferenceResults& outputResults) {
+void HeadPoseEstimator::startEstimation(const cv::Mat& image,
+                                        FaceInferenceResults& outputResults,
+                                        size_t requestId) {
     auto faceBoundingBox = outputResults.faceBoundingBox;
     auto faceCrop(cv::Mat(image, faceBoundingBox));
 
-    ieWrapper.setInputBlob(inputBlobName, faceCrop);
-    ieWrapper.infer();
+    ieWrapper.setInputBlob(inputBlobName, faceCrop, requestId);
+    ieWrapper.startAsync(requestId);
+}
+
+void HeadPoseEstimator::finishEstimation(FaceInferenceResults& outputResults,
+                                         size_t requestId) {
+    ieWrapper.wait(requestId);
 
     std::vector<float> outputValue;
 
     for (const auto &output: OUTPUTS) {
-        ieWrapper.getOutputBlob(output.first, outputValue);
+        ieWrapper.getOutputBlob(output.first, outputValue, requestId);
         outputResults.headPoseAngles.*output.second = outputValue[0];
     }
 }
@@ -55,11 +55,20 @@ void IEWrapper::setExecPart() {
     }
 
     executableNetwork = ie.LoadNetwork(network, deviceName);
-    request = executableNetwork.CreateInferRequest();
+    requests.clear();
+    requests.push_back(executableNetwork.CreateInferRequest());
+}
+
+InferRequest& IEWrapper::getRequest(size_t requestId) {
+    while (requests.size() <= requestId) {
+        requests.push_back(executableNetwork.CreateInferRequest());
+    }
+    return requests[requestId];
 }
 
 void IEWrapper::setInputBlob(const std::string& blobName,
-                             const cv::Mat& image) {
+                             const cv::Mat& image,
+                             size_t requestId) {
     auto blobDims = inputBlobsDimsInfo[blobName];
 
     if (blobDims.size() != 4) {
@@ -70,12 +79,25 @@ void IEWrapper::setInputBlob(const std::string& blobName,
     cv::Mat resizedImage;
     cv::resize(image, resizedImage, scaledSize, 0, 0, cv::INTER_CUBIC);
 
-    auto inputBlob = request.GetBlob(blobName);
+    auto inputBlob = getRequest(requestId).GetBlob(blobName);
     matU8ToBlob<uint8_t>(resizedImage, inputBlob);
 }
 
+void IEWrapper::warpInputBlob(const std::string& blobName,
+                              const cv::Mat& image,
+                              const cv::Mat& transform,
+                              size_t requestId) {
+    if (inputBlobsDimsInfo[blobName].size() != 4) {
+        throw std::runtime_error("Input data does not match size of the blob");
+    }
+
+    auto inputBlob = getRequest(requestId).GetBlob(blobName);
+    warpAffineToBlob<uint8_t>(image, transform, inputBlob);
+}
+
 void IEWrapper::setInputBlob(const std::string& blobName,
-                             const std::vector<float>& data) {
+                             const std::vector<float>& data,
+                             size_t requestId) {
     auto blobDims = inputBlobsDimsInfo[blobName];
     unsigned long dimsProduct = 1;
     for (auto const& dim : blobDims) {
@@ -84,7 +106,7 @@ void IEWrapper::setInputBlob(const std::string& blobName,
     if (dimsProduct != data.size()) {
         throw std::runtime_error("Input data does not match size of the blob");
     }
-    LockedMemory<void> blobMapped = as<MemoryBlob>(request.GetBlob(blobName))->wmap();
+    LockedMemory<void> blobMapped = as<MemoryBlob>(getRequest(requestId).GetBlob(blobName))->wmap();
     auto buffer = blobMapped.as<float *>();
     for (unsigned long int i = 0; i < data.size(); ++i) {
         buffer[i] = data[i];
@@ -92,7 +114,8 @@ void IEWrapper::setInputBlob(const std::string& blobName,
 }
 
 void IEWrapper::getOutputBlob(const std::string& blobName,
-                              std::vector<float> &output) {
+                              std::vector<float> &output,
+                              size_t requestId) {
     output.clear();
     auto blobDims = outputBlobsDimsInfo[blobName];
     auto dataSize = 1;
@@ -100,7 +123,7 @@ void IEWrapper::getOutputBlob(const std::string& blobName,
         dataSize *= dim;
     }
 
-    LockedMemory<const void> blobMapped = as<MemoryBlob>(request.GetBlob(blobName))->rmap();
+    LockedMemory<const void> blobMapped = as<MemoryBlob>(getRequest(requestId).GetBlob(blobName))->rmap();
     auto buffer = blobMapped.as<float *>();
 
     for (int i = 0; i < dataSize; ++i) {
@@ -111,6 +134,11 @@ void IEWrapper::getOutputBlob(const std::string& blobName,
 const std::map<std::string, std::vector<unsigned long>>& IEWrapper::getInputBlobDimsInfo() const {
     return inputBlobsDimsInfo;
 }
+cv::Size IEWrapper::getInputImageSize(const std::string& blobName) const {
+    const auto& dims = inputBlobsDimsInfo.at(blobName);
+    return cv::Size(static_cast<int>(dims.at(3)), static_cast<int>(dims.at(2)));
+}
+
 const std::map<std::string, std::vector<unsigned long>>& IEWrapper::getOutputBlobDimsInfo() const {
     return outputBlobsDimsInfo;
 }
@@ -139,8 +167,16 @@ void IEWrapper::expectImageInput(const std::string& blobName) const {
     }
 }
 
-void IEWrapper::infer() {
-    request.Infer();
+void IEWrapper::infer(size_t requestId) {
+    getRequest(requestId).Infer();
+}
+
+void IEWrapper::startAsync(size_t requestId) {
+    getRequest(requestId).StartAsync();
+}
+
+void IEWrapper::wait(size_t requestId) {
+    getRequest(requestId).Wait(IInferRequest::WaitMode::RESULT_READY);
 }
 
 void IEWrapper::reshape(const std::map<std::string, std::vector<unsigned long> > &newBlobsDimsInfo) {
@@ -163,7 +199,7 @@ void IEWrapper::reshape(const std::map<std::string, std::vector<unsigned long> >
 void IEWrapper::printPerlayerPerformance() const {
     std::cout << "\n-----------------START-----------------" << std::endl;
     std::cout << "Performance for " << modelPath << " model\n" << std::endl;
-    printPerformanceCounts(request, std::cout, getFullDeviceName(ie, deviceName), false);
+    printPerformanceCounts(requests[0], std::cout, getFullDeviceName(ie, deviceName), false);
     std::cout << "------------------END------------------\n" << std::endl;
 }
 }  // namespace gaze_estimation
@@ -29,20 +29,29 @@ LandmarksEstimator::LandmarksEstimator(InferenceEngine::Core& ie,
     }
 }
 
-void LandmarksEstimator::estimate(const cv::Mat& image,
-                                  FaceInferenceResults& outputResults) {
+void LandmarksEstimator::startEstimation(const cv::Mat& image,
+                                         FaceInferenceResults& outputResults,
+                                         size_t requestId) {
     auto faceBoundingBox = outputResults.faceBoundingBox;
     auto faceCrop(cv::Mat(image, faceBoundingBox));
 
-    ieWrapper.setInputBlob(inputBlobName, faceCrop);
-    ieWrapper.infer();
+    ieWrapper.setInputBlob(inputBlobName, faceCrop, requestId);
+    ieWrapper.startAsync(requestId);
+}
+
+void LandmarksEstimator::finishEstimation(FaceInferenceResults& outputResults,
+                                          size_t requestId) {
+    // startEstimation() inferred the crop of the whole bounding box
+    auto faceBoundingBox = outputResults.faceBoundingBox;
+
+    ieWrapper.wait(requestId);
     std::vector<float> rawLandmarks;
 
-    ieWrapper.getOutputBlob(outputBlobName, rawLandmarks);
+    ieWrapper.getOutputBlob(outputBlobName, rawLandmarks, requestId);
 
     for (unsigned long i = 0; i < rawLandmarks.size() / 2; ++i) {
-        int x = static_cast<int>(rawLandmarks[2 * i] * faceCrop.cols + faceBoundingBox.tl().x);
-        int y = static_cast<int>(rawLandmarks[2 * i + 1] * faceCrop.rows + faceBoundingBox.tl().y);
+        int x = static_cast<int>(rawLandmarks[2 * i] * faceBoundingBox.width + faceBoundingBox.tl().x);
+        int y = static_cast<int>(rawLandmarks[2 * i + 1] * faceBoundingBox.height + faceBoundingBox.tl().y);
         outputResults.faceLandmarks.push_back(cv::Point2i(x, y));
     }
 }
@@ -0,0 +1,119 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include <algorithm>
+#include <vector>
+
+#include "motion_gate.hpp"
+
+namespace gaze_estimation {
+namespace {
+const double MIN_MATCH_IOU = 0.5;
+// The corners of the eyes are the first landmarks
+const size_t EYE_LANDMARKS_COUNT = 4;
+
+std::vector<cv::Point2i> eyeLandmarks(const FaceInferenceResults& face) {
+    return std::vector<cv::Point2i>(face.faceLandmarks.begin(),
+        face.faceLandmarks.begin() + std::min(EYE_LANDMARKS_COUNT, face.faceLandmarks.size()));
+}
+}  // namespace
+
+MotionGate::MotionGate(double threshold): threshold(threshold) {
+}
+
+double MotionGate::boxMotion(const cv::Rect& from, const cv::Rect& to) const {
+    double motion = std::max(cv::norm(to.tl() - from.tl()), cv::norm(to.br() - from.br()));
+    return motion / std::max(from.width, 1);
+}
+
+void MotionGate::matchFaces(const std::vector<FaceInferenceResults>& faces) {
+    matches.assign(faces.size(), -1);
+    isHeadPoseKept.assign(faces.size(), 0);
+    isGazeKept.assign(faces.size(), 0);
+    if (threshold <= 0) {
+        return;
+    }
+
+    std::vector<char> isMatched(keptResults.size(), 0);
+    for (size_t i = 0; i < faces.size(); i++) {
+        double bestIou = MIN_MATCH_IOU;
+        for (size_t j = 0; j < keptResults.size(); j++) {
+            const cv::Rect& box = keptResults[j].faceBoundingBox;
+            double iou = static_cast<double>((box & faces[i].faceBoundingBox).area())
+                / (box | faces[i].faceBoundingBox).area();
+            if (!isMatched[j] && iou >= bestIou) {
+                bestIou = iou;
+                matches[i] = static_cast<int>(j);
+            }
+        }
+        if (matches[i] != -1) {
+            isMatched[matches[i]] = 1;
+        }
+    }
+}
+
+bool MotionGate::keepHeadPose(size_t faceId, FaceInferenceResults& face) {
+    if (matches[faceId] == -1) {
+        return false;
+    }
+    const KeptResults& kept = keptResults[matches[faceId]];
+    if (boxMotion(kept.headPoseFaceBoundingBox, face.faceBoundingBox) > threshold) {
+        return false;
+    }
+    face.headPoseAngles = kept.headPoseAngles;
+    isHeadPoseKept[faceId] = 1;
+    return true;
+}
+
+bool MotionGate::keepGaze(size_t faceId, FaceInferenceResults& face) {
+    // The faces with both eyes closed have no gaze, and getting the gaze for reopened eyes needs the estimation
+    if (matches[faceId] == -1 || (!face.leftEyeState && !face.rightEyeState)) {
+        return false;
+    }
+    const KeptResults& kept = keptResults[matches[faceId]];
+    if (!kept.hasGaze || boxMotion(kept.gazeFaceBoundingBox, face.faceBoundingBox) > threshold) {
+        return false;
+    }
+    std::vector<cv::Point2i> landmarks = eyeLandmarks(face);
+    if (landmarks.size() != kept.gazeEyeLandmarks.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < landmarks.size(); i++) {
+        if (cv::norm(landmarks[i] - kept.gazeEyeLandmarks[i]) / std::max(kept.gazeFaceBoundingBox.width, 1)
+                > threshold) {
+            return false;
+        }
+    }
+    face.gazeVector = kept.gazeVector;
+    isGazeKept[faceId] = 1;
+    return true;
+}
+
+void MotionGate::update(const std::vector<FaceInferenceResults>& faces) {
+    if (threshold <= 0) {
+        return;
+    }
+
+    std::vector<KeptResults> newKeptResults(faces.size());
+    for (size_t i = 0; i < faces.size(); i++) {
+        const FaceInferenceResults& face = faces[i];
+        KeptResults& kept = newKeptResults[i];
+        if (isHeadPoseKept[i] || isGazeKept[i]) {
+            kept = keptResults[matches[i]];
+        }
+        kept.faceBoundingBox = face.faceBoundingBox;
+        if (!isHeadPoseKept[i]) {
+            kept.headPoseFaceBoundingBox = face.faceBoundingBox;
+            kept.headPoseAngles = face.headPoseAngles;
+        }
+        if (!isGazeKept[i]) {
+            kept.gazeFaceBoundingBox = face.faceBoundingBox;
+            kept.gazeEyeLandmarks = eyeLandmarks(face);
+            kept.hasGaze = face.leftEyeState || face.rightEyeState;
+            kept.gazeVector = face.gazeVector;
+        }
+    }
+    keptResults.swap(newKeptResults);
+}
+}  // namespace gaze_estimation
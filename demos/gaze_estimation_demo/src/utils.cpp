@@ -43,6 +43,16 @@ void initializeIEObject(InferenceEngine::Core& ie,
     }
 }
 
+cv::Mat eyeToBlobTransform(const cv::Rect& eyeBoundingBox, float roll, const cv::Size& blobImageSize) {
+    cv::Point2f center(static_cast<float>(eyeBoundingBox.x + eyeBoundingBox.width / 2),
+                       static_cast<float>(eyeBoundingBox.y + eyeBoundingBox.height / 2));
+    cv::Mat imageToEye = cv::Mat::eye(3, 3, CV_64F);
+    cv::getRotationMatrix2D(center, static_cast<double>(roll), 1).copyTo(imageToEye.rowRange(0, 2));
+    imageToEye.at<double>(0, 2) -= eyeBoundingBox.x;
+    imageToEye.at<double>(1, 2) -= eyeBoundingBox.y;
+    return resizeTransform(cv::Rect(cv::Point(), eyeBoundingBox.size()), blobImageSize) * imageToEye;
+}
+
 void gazeVectorToGazeAngles(const cv::Point3f& gazeVector, cv::Point2f& gazeAngles) {
     auto r = cv::norm(gazeVector);
 
@@ -18,19 +18,40 @@ static const char target_device_message[] = "Optional. Specify the target device
                                             "Use \"-d HETERO:<comma-separated_devices_list>\" format to specify HETERO plugin. "
                                             "The application looks for a suitable plugin for the specified device.";
 static const char performance_counter_message[] = "Optional. Enable per-layer performance report.";
+static const char num_inf_req_message[] = "Optional. Number of infer requests. 1 runs inference synchronously.";
+static const char num_threads_message[] = "Optional. Number of threads.";
+static const char num_streams_message[] = "Optional. Number of streams to use for inference on the CPU or/and GPU in "
+                                          "throughput mode (for HETERO and MULTI device cases use format "
+                                          "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
+static const char postprocess_threads_message[] = "Optional. Number of threads postprocessing inference results "
+                                                  "in parallel with inference and with each other. "
+                                                  "0 postprocesses them in the main thread.";
 static const char no_show_processed_video[] = "Optional. Do not show processed video.";
 static const char black_background[] = "Optional. Show black background.";
 static const char raw_output_message[] = "Optional. Output inference results as raw values.";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
+static const char sparse_postprocessing_message[] = "Optional. Find poses on the feature maps of the network "
+                                                    "resolution instead of upsampled ones. It's faster and "
+                                                    "the keypoints are slightly less precise.";
+static const char temporal_postprocessing_message[] = "Optional. Track poses of the previous frame to the keypoints "
+                                                      "found on the next one and group keypoints into poses only "
+                                                      "when the tracking fails. It's faster for slowly moving people.";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(m, "", human_pose_estimation_model_message);
 DEFINE_string(d, "CPU", target_device_message);
 DEFINE_bool(pc, false, performance_counter_message);
+DEFINE_uint32(nireq, 2, num_inf_req_message);
+DEFINE_uint32(nthreads, 0, num_threads_message);
+DEFINE_string(nstreams, "", num_streams_message);
+DEFINE_uint32(postprocess_threads, 1, postprocess_threads_message);
 DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_bool(black, false, black_background);
 DEFINE_bool(r, false, raw_output_message);
 DEFINE_string(u, "", utilization_monitors_message);
+DEFINE_bool(sparse_pp, false, sparse_postprocessing_message);
+DEFINE_bool(temporal_pp, false, temporal_postprocessing_message);
+DEFINE_BENCHMARK_FLAGS
 
 /**
 * @brief This function shows a help message
@@ -46,8 +67,16 @@ static void showUsage() {
     std::cout << "    -m \"<path>\"                " << human_pose_estimation_model_message << std::endl;
     std::cout << "    -d \"<device>\"              " << target_device_message << std::endl;
     std::cout << "    -pc                        " << performance_counter_message << std::endl;
+    std::cout << "    -nireq \"<integer>\"         " << num_inf_req_message << std::endl;
+    std::cout << "    -nthreads \"<integer>\"      " << num_threads_message << std::endl;
+    std::cout << "    -nstreams                  " << num_streams_message << std::endl;
+    std::cout << "    -postprocess_threads \"<integer>\" " << postprocess_threads_message << std::endl;
     std::cout << "    -no_show                   " << no_show_processed_video << std::endl;
     std::cout << "    -black                     " << black_background << std::endl;
     std::cout << "    -r                         " << raw_output_message << std::endl;
     std::cout << "    -u                         " << utilization_monitors_message << std::endl;
+    std::cout << "    -sparse_pp                 " << sparse_postprocessing_message << std::endl;
+    std::cout << "    -temporal_pp               " << temporal_postprocessing_message << std::endl;
+    std::cout << "    -limit                     " << limit_message << std::endl;
+    std::cout << "    -report_perf               " << report_perf_message << std::endl;
 }
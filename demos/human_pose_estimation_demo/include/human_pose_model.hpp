@@ -0,0 +1,80 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "models/model_base.h"
+#include "models/results_pool.h"
+
+#include "human_pose.hpp"
+
+namespace human_pose_estimation {
+struct HumanPoseResult : public ResultBase {
+    std::vector<HumanPose> poses;
+};
+
+// The model for AsyncPipeline. Results of different requests can be postprocessed at once by postprocessing workers of
+// the pipeline. With temporal tracking the poses of the latest postprocessed frame are tracked to the peaks of the next
+// one and the peaks are grouped into poses only when the tracking fails, it's meant for slowly moving people
+class HumanPoseModel : public ModelBase {
+public:
+    static const size_t keypointsNumber = 18;
+
+    // The input width of the network is changed to keep the aspect ratio of frames of imageSize.
+    // Frames of other sizes are stretched to it
+    HumanPoseModel(const std::string& modelFileName, const cv::Size& imageSize, bool sparsePostprocessing = false,
+                   bool temporalTracking = false);
+
+    std::shared_ptr<InternalModelData> preprocess(const InputData& inputData,
+                                                  InferenceEngine::InferRequest::Ptr& request) override;
+    std::unique_ptr<ResultBase> postprocess(InferenceResult& infResult) override;
+    void recycleResult(std::unique_ptr<ResultBase>&& result) override {resultsPool.release(std::move(result));}
+
+protected:
+    void prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) override;
+
+private:
+    std::vector<HumanPose> extractPoses(const std::vector<cv::Mat>& heatMaps,
+                                        const std::vector<cv::Mat>& pafs,
+                                        int64_t frameId);
+    void resizeFeatureMaps(std::vector<cv::Mat>& featureMaps) const;
+    // Upsampling ratio of the maps which aren't resized in sparse postprocessing, 1 if they are resized
+    int featureMapsScale() const {return sparsePostprocessing ? upsampleRatio : 1;}
+    void correctCoordinates(std::vector<HumanPose>& poses,
+                            const cv::Size& featureMapsSize,
+                            const cv::Size& imageSize) const;
+    void setInputWidth(const cv::Size& imageSize);
+
+    int minJointsNumber;
+    int stride;
+    cv::Vec4i pad;
+    cv::Vec3f meanPixel;
+    float minPeaksDistance;
+    float midPointsScoreThreshold;
+    float foundMidPointsRatioThreshold;
+    float minSubsetScore;
+    cv::Size inputLayerSize;
+    cv::Size imageSize;
+    int upsampleRatio;
+    bool sparsePostprocessing;
+    bool temporalTracking;
+    float maxKeypointShift;
+    float minTrackedKeypointsRatio;
+    int maxTrackedFrames;
+    ResultsPool<HumanPoseResult> resultsPool;
+
+    // Poses of the latest postprocessed frame in the coordinates of feature maps
+    std::mutex trackingMtx;
+    std::vector<HumanPose> trackedPoses;
+    int64_t trackedFrameId = -1;
+    int trackedFramesNumber = 0;  // frames tracked since the last grouping
+};
+}  // namespace human_pose_estimation
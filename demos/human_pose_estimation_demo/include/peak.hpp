@@ -39,10 +39,14 @@ struct TwoJointsConnection {
     float score;
 };
 
+// featureMapsScale is the upsampling ratio of the maps which the peaks and poses are found for. 1 means the maps are
+// upsampled already. Otherwise the maps have the network resolution and the peaks are refined to sub-pixel positions,
+// the PAFs are sampled bilinearly along the limbs, so the maps aren't resized
 void findPeaks(const std::vector<cv::Mat>& heatMaps,
                const float minPeaksDistance,
                std::vector<std::vector<Peak> >& allPeaks,
-               int heatMapId);
+               int heatMapId,
+               int featureMapsScale);
 
 std::vector<HumanPose> groupPeaksToPoses(
         const std::vector<std::vector<Peak> >& allPeaks,
@@ -51,5 +55,17 @@ std::vector<HumanPose> groupPeaksToPoses(
         const float midPointsScoreThreshold,
         const float foundMidPointsRatioThreshold,
         const int minJointsNumber,
-        const float minSubsetScore);
+        const float minSubsetScore,
+        const int featureMapsScale);
+
+// Moves the keypoints of poses found on the previous frame (in the coordinates of groupPeaksToPoses()) to the nearest
+// peaks of their type not farther than maxKeypointShift, a peak is taken by one keypoint at most. Keypoints which
+// don't find a peak are lost. Returns false without changing the poses if the tracking isn't confident: a pose keeps
+// less than minTrackedKeypointsRatio of its keypoints or less than minJointsNumber of them, or minJointsNumber peaks
+// aren't taken by any pose and may belong to a new person. Grouping of the peaks is needed then
+bool trackPoses(const std::vector<std::vector<Peak> >& allPeaks,
+                std::vector<HumanPose>& poses,
+                const float maxKeypointShift,
+                const float minTrackedKeypointsRatio,
+                const int minJointsNumber);
 }  // namespace human_pose_estimation
@@ -8,17 +8,25 @@
 * \example human_pose_estimation_demo/main.cpp
 */
 
-#include <vector>
 #include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <vector>
 
 #include <inference_engine.hpp>
 
 #include <monitors/presenter.h>
 #include <samples/images_capture.h>
 #include <samples/ocv_common.hpp>
+#include <samples/performance_metrics.hpp>
+
+#include "pipelines/async_pipeline.h"
+#include "pipelines/config_factory.h"
+#include "pipelines/metadata.h"
 
 #include "human_pose_estimation_demo.hpp"
-#include "human_pose_estimator.hpp"
+#include "human_pose_model.hpp"
 #include "render_human_pose.hpp"
 
 using namespace InferenceEngine;
@@ -44,11 +52,43 @@ bool ParseAndCheckCommandLine(int argc, char* argv[]) {
         throw std::logic_error("Parameter -m is not set");
     }
 
+    if (!FLAGS_report_perf.empty() && FLAGS_report_perf != "json") {
+        throw std::logic_error("Parameter -report_perf supports json only");
+    }
+
     return true;
 }
 
+void printRawPoses(const std::vector<HumanPose>& poses) {
+    if (!poses.empty()) {
+        std::time_t result = std::time(nullptr);
+        char timeString[sizeof("2020-01-01 00:00:00: ")];
+        std::strftime(timeString, sizeof(timeString), "%Y-%m-%d %H:%M:%S: ", std::localtime(&result));
+        std::cout << timeString;
+    }
+
+    for (HumanPose const& pose : poses) {
+        std::stringstream rawPose;
+        rawPose << std::fixed << std::setprecision(0);
+        for (auto const& keypoint : pose.keypoints) {
+            rawPose << keypoint.x << "," << keypoint.y << " ";
+        }
+        rawPose << pose.score;
+        std::cout << rawPose.str() << std::endl;
+    }
+}
+
+cv::Mat renderPoses(const HumanPoseResult& result, bool blackBackground) {
+    cv::Mat frame = result.metaData->asRef<ImageMetaData>().img;
+    frame = blackBackground ? cv::Mat::zeros(frame.size(), frame.type()) : frame.clone();
+    renderHumanPose(result.poses, frame);
+    return frame;
+}
+
 int main(int argc, char* argv[]) {
     try {
+        PerformanceMetrics metrics;
+
         std::cout << "InferenceEngine: " << printable(*GetInferenceEngineVersion()) << std::endl;
 
         // ------------------------------ Parsing and validation of input args ---------------------------------
@@ -56,19 +96,27 @@ int main(int argc, char* argv[]) {
             return EXIT_SUCCESS;
         }
 
-        HumanPoseEstimator estimator(FLAGS_m, FLAGS_d, FLAGS_pc);
-
-        std::unique_ptr<ImagesCapture> cap = openImagesCapture(FLAGS_i, FLAGS_loop);
+        std::unique_ptr<ImagesCapture> cap = openImagesCapture(FLAGS_i, FLAGS_loop, 0,
+            FLAGS_limit > 0 ? FLAGS_limit : std::numeric_limits<size_t>::max());
+        auto startTime = std::chrono::steady_clock::now();
         cv::Mat curr_frame = cap->read();
         if (!curr_frame.data) {
             throw std::runtime_error("Can't read an image from the input");
         }
 
+        // The input width of the network is set for the aspect ratio of the first frame
+        Core core;
+        CnnConfig cnnConfig = ConfigFactory::getUserConfig(FLAGS_d, "", "", FLAGS_pc, FLAGS_nireq, FLAGS_nstreams,
+                                                           FLAGS_nthreads);
+        cnnConfig.postprocessThreads = FLAGS_postprocess_threads;
+        AsyncPipeline pipeline(std::unique_ptr<HumanPoseModel>(
+                                   new HumanPoseModel(FLAGS_m, curr_frame.size(), FLAGS_sparse_pp, FLAGS_temporal_pp)),
+                               cnnConfig, core);
+        pipeline.setPerformanceMetrics(&metrics);
+
         cv::Size graphSize{curr_frame.cols / 4, 60};
         Presenter presenter(FLAGS_u, curr_frame.rows - graphSize.height - 10, graphSize);
 
-        estimator.reshape(curr_frame);  // Do not measure network reshape, if it happened
-
         std::cout << "To close the application, press 'CTRL+C' here";
         if (!FLAGS_no_show) {
             std::cout << " or switch to the output window and press ESC key" << std::endl;
@@ -77,142 +125,67 @@ int main(int argc, char* argv[]) {
         std::cout << std::endl;
 
         int delay = 1;
-        bool isAsyncMode = false; // execution is always started in SYNC mode
-        bool isModeChanged = false; // set to true when execution mode is changed (SYNC<->ASYNC)
         bool blackBackground = FLAGS_black;
-
-        typedef std::chrono::duration<double, std::ratio<1, 1000>> ms;
-        auto total_t0 = std::chrono::high_resolution_clock::now();
-        auto wallclock = std::chrono::high_resolution_clock::now();
-        double render_time = 0;
-        do {
-            auto t0 = std::chrono::high_resolution_clock::now();
-            //here is the first asynchronus point:
-            //in the async mode we capture frame to populate the NEXT infer request
-            //in the regular mode we capture frame to the current infer request
-
-            cv::Mat next_frame = cap->read();
-            if (isAsyncMode) {
-                if (isModeChanged) {
-                    estimator.frameToBlobCurr(curr_frame);
-                }
-                if (next_frame.data) {
-                    estimator.frameToBlobNext(next_frame);
-                }
-            } else if (!isModeChanged) {
-                estimator.frameToBlobCurr(curr_frame);
-            }
-            auto t1 = std::chrono::high_resolution_clock::now();
-            double decode_time = std::chrono::duration_cast<ms>(t1 - t0).count();
-
-            t0 = std::chrono::high_resolution_clock::now();
-            // Main sync point:
-            // in the truly Async mode we start the NEXT infer request, while waiting for the CURRENT to complete
-            // in the regular mode we start the CURRENT request and immediately wait for it's completion
-            if (isAsyncMode) {
-                if (isModeChanged) {
-                    estimator.startCurr();
-                }
-                if (next_frame.data) {
-                    estimator.startNext();
-                }
-            } else if (!isModeChanged) {
-                estimator.startCurr();
-            }
-
-            estimator.waitCurr();
-            t1 = std::chrono::high_resolution_clock::now();
-            ms detection = std::chrono::duration_cast<ms>(t1 - t0);
-            t0 = std::chrono::high_resolution_clock::now();
-            ms wall = std::chrono::duration_cast<ms>(t0 - wallclock);
-            wallclock = t0;
-
-            t0 = std::chrono::high_resolution_clock::now();
-
-            if (blackBackground) {
-                curr_frame = cv::Mat::zeros(curr_frame.size(), curr_frame.type());
-            }
-            std::ostringstream out;
-            out << "OpenCV cap/render time: " << std::fixed << std::setprecision(1)
-                << (decode_time + render_time) << " ms";
-            cv::putText(curr_frame, out.str(), cv::Point2f(0, 25),
-                        cv::FONT_HERSHEY_TRIPLEX, 0.6, cv::Scalar(0, 255, 0));
-            out.str("");
-            out << "Wallclock time " << (isAsyncMode ? "(TRUE ASYNC):      " : "(SYNC, press Tab): ");
-            out << std::fixed << std::setprecision(2) << wall.count()
-                << " ms (" << 1000.0 / wall.count() << " fps)";
-            cv::putText(curr_frame, out.str(), cv::Point2f(0, 50),
-                        cv::FONT_HERSHEY_TRIPLEX, 0.6, cv::Scalar(0, 0, 255));
-            if (!isAsyncMode) {  // In the true async mode, there is no way to measure detection time directly
-                out.str("");
-                out << "Detection time  : " << std::fixed << std::setprecision(1) << detection.count()
-                << " ms ("
-                << 1000.0 / detection.count() << " fps)";
-                cv::putText(curr_frame, out.str(), cv::Point2f(0, 75), cv::FONT_HERSHEY_TRIPLEX, 0.6,
-                    cv::Scalar(255, 0, 0));
-            }
-
-            std::vector<HumanPose> poses = estimator.postprocessCurr();
-
+        bool keepRunning = true;
+        std::unique_ptr<ResultBase> result;
+        auto showResult = [&](const HumanPoseResult& poseResult) {
             if (FLAGS_r) {
-                if (!poses.empty()) {
-                    std::time_t result = std::time(nullptr);
-                    char timeString[sizeof("2020-01-01 00:00:00: ")];
-                    std::strftime(timeString, sizeof(timeString), "%Y-%m-%d %H:%M:%S: ", std::localtime(&result));
-                    std::cout << timeString;
-                    }
-
-                for (HumanPose const& pose : poses) {
-                    std::stringstream rawPose;
-                    rawPose << std::fixed << std::setprecision(0);
-                    for (auto const& keypoint : pose.keypoints) {
-                        rawPose << keypoint.x << "," << keypoint.y << " ";
-                    }
-                    rawPose << pose.score;
-                    std::cout << rawPose.str() << std::endl;
-                }
+                printRawPoses(poseResult.poses);
             }
 
-            presenter.drawGraphs(curr_frame);
-            renderHumanPose(poses, curr_frame);
-
+            auto renderStartTime = std::chrono::steady_clock::now();
+            cv::Mat outFrame = renderPoses(poseResult, blackBackground);
+            metrics.recordStage(PerformanceMetrics::Stage::Render, renderStartTime);
+            presenter.drawGraphs(outFrame);
+            metrics.update(poseResult.metaData->asRef<ImageMetaData>().timeStamp, outFrame, {10, 22}, 0.65);
             if (!FLAGS_no_show) {
-                cv::imshow("Human Pose Estimation on " + FLAGS_d, curr_frame);
+                cv::imshow("Human Pose Estimation on " + FLAGS_d, outFrame);
             }
-
-            t1 = std::chrono::high_resolution_clock::now();
-            render_time = std::chrono::duration_cast<ms>(t1 - t0).count();
-
-            if (isModeChanged) {
-                isModeChanged = false;
+        };
+
+        while (keepRunning && curr_frame.data) {
+            if (pipeline.isReadyToProcess()) {
+                pipeline.submitData(ImageInputData(curr_frame),
+                                    makeImageMetaData(curr_frame, startTime));
+                startTime = std::chrono::steady_clock::now();
+                curr_frame = cap->read();
+                metrics.recordStage(PerformanceMetrics::Stage::Decode, startTime);
             }
 
-            // Final point:
-            // in the truly Async mode we swap the NEXT and CURRENT requests for the next iteration
-            curr_frame = std::move(next_frame);
-            if (isAsyncMode) {
-                estimator.swapRequest();
+            //--- Waiting for free input slot or output data available. Function will return immediately if any of them are available.
+            pipeline.waitForData();
+
+            while (keepRunning && (result = pipeline.getResult())) {
+                showResult(result->asRef<HumanPoseResult>());
+                pipeline.releaseResult(std::move(result));
+                if (!FLAGS_no_show) {
+                    const int key = cv::waitKey(delay) & 255;
+                    if (key == 'p') {
+                        delay = (delay == 0) ? 1 : 0;
+                    } else if (27 == key) { // Esc
+                        keepRunning = false;
+                    } else if (32 == key) { // Space
+                        blackBackground = !blackBackground;
+                    }
+                    presenter.handleKey(key);
+                }
             }
+        }
 
+        // ------------ Waiting for completion of data processing and rendering the rest of results ---------
+        pipeline.waitForTotalCompletion();
+        while (keepRunning && (result = pipeline.getResult())) {
+            showResult(result->asRef<HumanPoseResult>());
+            pipeline.releaseResult(std::move(result));
             if (!FLAGS_no_show) {
-                const int key = cv::waitKey(delay) & 255;
-                if (key == 'p') {
-                    delay = (delay == 0) ? 1 : 0;
-                } else if (27 == key) { // Esc
-                    break;
-                } else if (9 == key) { // Tab
-                    isAsyncMode = !isAsyncMode;
-                    isModeChanged = true;
-                } else if (32 == key) { // Space
-                    blackBackground = !blackBackground;
-                }
-                presenter.handleKey(key);
+                cv::waitKey(1);
             }
-        } while (curr_frame.data);
+        }
 
-        auto total_t1 = std::chrono::high_resolution_clock::now();
-        ms total = std::chrono::duration_cast<ms>(total_t1 - total_t0);
-        std::cout << "Total Inference time: " << total.count() << std::endl;
+        metrics.printTotal();
+        if (!FLAGS_report_perf.empty()) {
+            metrics.reportTotal(FLAGS_report_perf);
+        }
         std::cout << presenter.reportMeans() << '\n';
     }
     catch (const std::exception& error) {
@@ -0,0 +1,279 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <kernels/demo_kernels.h>
+#include <samples/ocv_common.hpp>
+
+#include "human_pose_model.hpp"
+#include "peak.hpp"
+
+namespace human_pose_estimation {
+namespace {
+// Wraps the FP32 feature maps of the output, FP16 ones are converted, the resizing and the peaks search need float
+void getFeatureMaps(const InferenceEngine::MemoryBlob::Ptr& blob, const void* data, int height, int width,
+                    std::vector<cv::Mat>& featureMaps) {
+    const size_t area = static_cast<size_t>(height) * width;
+    const bool isFp16 = blob->getTensorDesc().getPrecision() == InferenceEngine::Precision::FP16;
+    for (size_t i = 0; i < featureMaps.size(); i++) {
+        if (isFp16) {
+            featureMaps[i].create(height, width, CV_32FC1);
+            kernels::convertHalfToFloat(static_cast<const uint16_t*>(data) + i * area, static_cast<int>(area),
+                                        featureMaps[i].ptr<float>());
+        } else {
+            featureMaps[i] = cv::Mat(height, width, CV_32FC1,
+                                     const_cast<float*>(static_cast<const float*>(data) + i * area));
+        }
+    }
+}
+}  // namespace
+
+HumanPoseModel::HumanPoseModel(const std::string& modelFileName,
+                               const cv::Size& imageSize,
+                               bool sparsePostprocessing,
+                               bool temporalTracking)
+    : ModelBase(modelFileName),
+      minJointsNumber(3),
+      stride(8),
+      pad(cv::Vec4i::all(0)),
+      meanPixel(cv::Vec3f::all(128)),
+      minPeaksDistance(3.0f),
+      midPointsScoreThreshold(0.05f),
+      foundMidPointsRatioThreshold(0.8f),
+      minSubsetScore(0.2f),
+      inputLayerSize(-1, -1),
+      imageSize(imageSize),
+      upsampleRatio(4),
+      sparsePostprocessing(sparsePostprocessing),
+      temporalTracking(temporalTracking),
+      maxKeypointShift(8.0f),
+      minTrackedKeypointsRatio(0.8f),
+      maxTrackedFrames(30) {}
+
+void HumanPoseModel::prepareInputsOutputs(InferenceEngine::CNNNetwork& cnnNetwork) {
+    InferenceEngine::ICNNNetwork::InputShapes inputShapes = cnnNetwork.getInputShapes();
+    if (inputShapes.size() != 1) {
+        throw std::runtime_error(modelFileName + ": expected to have 1 input");
+    }
+    inputsNames.push_back(inputShapes.begin()->first);
+    InferenceEngine::SizeVector& inputDims = inputShapes.begin()->second;
+    if (inputDims.size() != 4 || inputDims[1] != 3) {
+        throw std::runtime_error(
+            modelFileName + ": expected \"" + inputsNames[0] + "\" to have dimensions Nx3xHxW");
+    }
+
+    inputLayerSize = cv::Size(inputDims[3], inputDims[2]);
+    setInputWidth(imageSize);
+    inputDims[3] = inputLayerSize.width;
+    cnnNetwork.reshape(inputShapes);
+    cnnNetwork.getInputsInfo().begin()->second->setPrecision(InferenceEngine::Precision::U8);
+
+    const InferenceEngine::OutputsDataMap& outputInfo = cnnNetwork.getOutputsInfo();
+    if (outputInfo.size() != 2) {
+        throw std::runtime_error(modelFileName + ": expected to have 2 outputs");
+    }
+
+    auto outputIt = outputInfo.begin();
+    const std::string& pafsBlobName = outputIt->first;
+    const auto& pafsOutputDims = (outputIt++)->second->getTensorDesc().getDims();
+    if (pafsOutputDims.size() != 4 || pafsOutputDims[1] != 2 * (keypointsNumber + 1)) {
+        throw std::runtime_error(
+            modelFileName + ": expected \"" + pafsBlobName + "\" to have dimensions "
+                "Nx" + std::to_string(2 * (keypointsNumber + 1)) + "xHFMxWFM");
+    }
+
+    const std::string& heatmapsBlobName = outputIt->first;
+    const auto& heatmapsOutputDims = outputIt->second->getTensorDesc().getDims();
+    if (heatmapsOutputDims.size() != 4 || heatmapsOutputDims[1] != keypointsNumber + 1) {
+        throw std::runtime_error(
+            modelFileName + ": expected \"" + heatmapsBlobName + "\" to have dimensions "
+                "Nx" + std::to_string(keypointsNumber + 1) + "xHFMxWFM");
+    }
+
+    if (pafsOutputDims[2] != heatmapsOutputDims[2] || pafsOutputDims[3] != heatmapsOutputDims[3]) {
+        throw std::runtime_error(
+            modelFileName + ": expected \"" + pafsBlobName + "\" and \"" + heatmapsBlobName + "\""
+                "to have matching last two dimensions");
+    }
+    outputsNames.push_back(pafsBlobName);
+    outputsNames.push_back(heatmapsBlobName);
+    if (fp16OutputsAllowed) {
+        for (const auto& output : outputInfo) {
+            output.second->setPrecision(InferenceEngine::Precision::FP16);
+        }
+    }
+}
+
+std::shared_ptr<InternalModelData> HumanPoseModel::preprocess(const InputData& inputData,
+                                                              InferenceEngine::InferRequest::Ptr& request) {
+    const cv::Mat& image = inputData.asRef<ImageInputData>().inputImage;
+    CV_Assert(image.type() == CV_8UC3);
+
+    cv::Mat resizedImage;
+    cv::resize(image, resizedImage,
+               cv::Size(inputLayerSize.width - pad(1) - pad(3), inputLayerSize.height - pad(0) - pad(2)),
+               0, 0, cv::INTER_CUBIC);
+    cv::Mat paddedImage;
+    cv::copyMakeBorder(resizedImage, paddedImage, pad(0), pad(2), pad(1), pad(3),
+                       cv::BORDER_CONSTANT, meanPixel);
+    InferenceEngine::Blob::Ptr input = request->GetBlob(inputsNames[0]);
+    matU8ToBlob<uint8_t>(paddedImage, input);
+    return internalImageDataPool.make(image.cols, image.rows);
+}
+
+std::unique_ptr<ResultBase> HumanPoseModel::postprocess(InferenceResult& infResult) {
+    auto retVal = resultsPool.acquire();
+    HumanPoseResult* result = retVal.get();
+    *static_cast<ResultBase*>(result) = static_cast<ResultBase&>(infResult);
+
+    const auto& inputImgSize = infResult.internalModelData->asRef<InternalImageModelData>();
+    InferenceEngine::MemoryBlob::Ptr pafsBlob = infResult.outputsData[outputsNames[0]];
+    InferenceEngine::MemoryBlob::Ptr heatMapsBlob = infResult.outputsData[outputsNames[1]];
+    const InferenceEngine::SizeVector& heatMapDims = heatMapsBlob->getTensorDesc().getDims();
+    const int featureMapHeight = static_cast<int>(heatMapDims[2]);
+    const int featureMapWidth = static_cast<int>(heatMapDims[3]);
+
+    InferenceEngine::LockedMemory<const void> heatMapsBlobMapped = heatMapsBlob->rmap();
+    InferenceEngine::LockedMemory<const void> pafsBlobMapped = pafsBlob->rmap();
+
+    // The last heat map is the background, it isn't used
+    std::vector<cv::Mat> heatMaps(keypointsNumber);
+    getFeatureMaps(heatMapsBlob, heatMapsBlobMapped.as<const void*>(), featureMapHeight, featureMapWidth, heatMaps);
+    std::vector<cv::Mat> pafs(pafsBlob->getTensorDesc().getDims()[1]);
+    getFeatureMaps(pafsBlob, pafsBlobMapped.as<const void*>(), featureMapHeight, featureMapWidth, pafs);
+    if (!sparsePostprocessing) {
+        resizeFeatureMaps(heatMaps);
+        resizeFeatureMaps(pafs);
+    }
+
+    result->poses = extractPoses(heatMaps, pafs, infResult.frameId);
+    correctCoordinates(result->poses, heatMaps[0].size() * featureMapsScale(),
+                       cv::Size(inputImgSize.inputImgWidth, inputImgSize.inputImgHeight));
+    return std::unique_ptr<ResultBase>(retVal.release());
+}
+
+class FindPeaksBody: public cv::ParallelLoopBody {
+public:
+    FindPeaksBody(const std::vector<cv::Mat>& heatMaps, float minPeaksDistance,
+                  std::vector<std::vector<Peak> >& peaksFromHeatMap, int featureMapsScale)
+        : heatMaps(heatMaps),
+          minPeaksDistance(minPeaksDistance),
+          peaksFromHeatMap(peaksFromHeatMap),
+          featureMapsScale(featureMapsScale) {}
+
+    void operator()(const cv::Range& range) const override {
+        for (int i = range.start; i < range.end; i++) {
+            findPeaks(heatMaps, minPeaksDistance, peaksFromHeatMap, i, featureMapsScale);
+        }
+    }
+
+private:
+    const std::vector<cv::Mat>& heatMaps;
+    float minPeaksDistance;
+    std::vector<std::vector<Peak> >& peaksFromHeatMap;
+    int featureMapsScale;
+};
+
+std::vector<HumanPose> HumanPoseModel::extractPoses(
+        const std::vector<cv::Mat>& heatMaps,
+        const std::vector<cv::Mat>& pafs,
+        int64_t frameId) {
+    std::vector<std::vector<Peak> > peaksFromHeatMap(heatMaps.size());
+    FindPeaksBody findPeaksBody(heatMaps, minPeaksDistance, peaksFromHeatMap, featureMapsScale());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(heatMaps.size())),
+                      findPeaksBody);
+    int peaksBefore = 0;
+    for (size_t heatmapId = 1; heatmapId < heatMaps.size(); heatmapId++) {
+        peaksBefore += static_cast<int>(peaksFromHeatMap[heatmapId - 1].size());
+        for (auto& peak : peaksFromHeatMap[heatmapId]) {
+            peak.id += peaksBefore;
+        }
+    }
+    if (!temporalTracking) {
+        return groupPeaksToPoses(
+                    peaksFromHeatMap, pafs, keypointsNumber, midPointsScoreThreshold,
+                    foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore, featureMapsScale());
+    }
+
+    std::vector<HumanPose> poses;
+    int framesNumber;
+    {
+        std::lock_guard<std::mutex> lock(trackingMtx);
+        poses = trackedPoses;
+        framesNumber = trackedFramesNumber;
+    }
+    // Grouping is repeated regularly, so wrong tracks (like swapped limbs of close people) don't live long
+    const bool isTracked = framesNumber < maxTrackedFrames
+        && trackPoses(peaksFromHeatMap, poses, maxKeypointShift, minTrackedKeypointsRatio, minJointsNumber);
+    if (!isTracked) {
+        poses = groupPeaksToPoses(
+                    peaksFromHeatMap, pafs, keypointsNumber, midPointsScoreThreshold,
+                    foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore, featureMapsScale());
+    }
+    {
+        // Frames may be postprocessed out of order by several workers, older frames don't replace the tracks
+        std::lock_guard<std::mutex> lock(trackingMtx);
+        if (frameId > trackedFrameId) {
+            trackedPoses = poses;
+            trackedFrameId = frameId;
+            trackedFramesNumber = isTracked ? framesNumber + 1 : 0;
+        }
+    }
+    return poses;
+}
+
+void HumanPoseModel::resizeFeatureMaps(std::vector<cv::Mat>& featureMaps) const {
+    for (auto& featureMap : featureMaps) {
+        cv::resize(featureMap, featureMap, cv::Size(),
+                   upsampleRatio, upsampleRatio, cv::INTER_CUBIC);
+    }
+}
+
+void HumanPoseModel::correctCoordinates(std::vector<HumanPose>& poses,
+                                        const cv::Size& featureMapsSize,
+                                        const cv::Size& imageSize) const {
+    CV_Assert(stride % upsampleRatio == 0);
+
+    cv::Size fullFeatureMapSize = featureMapsSize * stride / upsampleRatio;
+
+    float scaleX = imageSize.width /
+            static_cast<float>(fullFeatureMapSize.width - pad(1) - pad(3));
+    float scaleY = imageSize.height /
+            static_cast<float>(fullFeatureMapSize.height - pad(0) - pad(2));
+    for (auto& pose : poses) {
+        for (auto& keypoint : pose.keypoints) {
+            if (keypoint != cv::Point2f(-1, -1)) {
+                keypoint.x *= stride / upsampleRatio;
+                keypoint.x -= pad(1);
+                keypoint.x *= scaleX;
+
+                keypoint.y *= stride / upsampleRatio;
+                keypoint.y -= pad(0);
+                keypoint.y *= scaleY;
+            }
+        }
+    }
+}
+
+void HumanPoseModel::setInputWidth(const cv::Size& imageSize) {
+    double scale = static_cast<double>(inputLayerSize.height) / static_cast<double>(imageSize.height);
+    cv::Size scaledSize(static_cast<int>(cvRound(imageSize.width * scale)),
+                        static_cast<int>(cvRound(imageSize.height * scale)));
+    cv::Size scaledImageSize(std::max(scaledSize.width, inputLayerSize.height),
+                             inputLayerSize.height);
+    int minHeight = std::min(scaledImageSize.height, scaledSize.height);
+    scaledImageSize.width = static_cast<int>(std::ceil(
+                scaledImageSize.width / static_cast<float>(stride))) * stride;
+    pad(0) = static_cast<int>(std::floor((scaledImageSize.height - minHeight) / 2.0));
+    pad(1) = static_cast<int>(std::floor((scaledImageSize.width - scaledSize.width) / 2.0));
+    pad(2) = scaledImageSize.height - minHeight - pad(0);
+    pad(3) = scaledImageSize.width - scaledSize.width - pad(1);
+    inputLayerSize.width = scaledImageSize.width;
+}
+}  // namespace human_pose_estimation
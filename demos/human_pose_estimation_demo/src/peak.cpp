@@ -7,6 +7,7 @@
 #include <vector>
 
 #include <samples/common.hpp>
+#include <samples/heatmap_peaks.hpp>
 
 #include "peak.hpp"
 
@@ -28,81 +29,169 @@ TwoJointsConnection::TwoJointsConnection(const int firstJointIdx,
       secondJointIdx(secondJointIdx),
       score(score) {}
 
-void findPeaks(const std::vector<cv::Mat>& heatMaps,
-               const float minPeaksDistance,
-               std::vector<std::vector<Peak> >& allPeaks,
-               int heatMapId) {
-    const float threshold = 0.1f;
-    std::vector<cv::Point> peaks;
-    const cv::Mat& heatMap = heatMaps[heatMapId];
-    const float* heatMapData = heatMap.ptr<float>();
-    size_t heatMapStep = heatMap.step1();
-    for (int y = -1; y < heatMap.rows + 1; y++) {
-        for (int x = -1; x < heatMap.cols + 1; x++) {
-            float val = 0;
-            if (x >= 0
-                    && y >= 0
-                    && x < heatMap.cols
-                    && y < heatMap.rows) {
-                val = heatMapData[y * heatMapStep + x];
-                val = val >= threshold ? val : 0;
-            }
+namespace {
+// Offset of the vertex of the parabola through the values at -1, 0 and 1 from 0, clamped to the pixel.
+// Adds the increase of the value at the vertex to value
+float quadraticPeakOffset(float prev, float center, float next, float& value) {
+    const float curvature = prev - 2 * center + next;
+    if (curvature >= 0) {
+        return 0.0f;
+    }
+    const float offset = std::max(-0.5f, std::min(0.5f, 0.5f * (prev - next) / curvature));
+    value += 0.25f * (next - prev) * offset;
+    return offset;
+}
 
-            float left_val = 0;
-            if (y >= 0
-                    && x < (heatMap.cols - 1)
-                    && y < heatMap.rows) {
-                left_val = heatMapData[y * heatMapStep + x + 1];
-                left_val = left_val >= threshold ? left_val : 0;
-            }
+// Sub-pixel position of a maximum of the heatmap by quadratic fits along x and y, in the coordinates of the heatmap
+// upsampled by scale like cv::resize() does it, so the peak matches the one of the upsampled heatmap
+Peak refinePeak(const cv::Mat& heatMap, const cv::Point& peak, int scale) {
+    const float center = heatMap.at<float>(peak);
+    const float left = peak.x > 0 ? heatMap.at<float>(peak.y, peak.x - 1) : center;
+    const float right = peak.x < heatMap.cols - 1 ? heatMap.at<float>(peak.y, peak.x + 1) : center;
+    const float top = peak.y > 0 ? heatMap.at<float>(peak.y - 1, peak.x) : center;
+    const float bottom = peak.y < heatMap.rows - 1 ? heatMap.at<float>(peak.y + 1, peak.x) : center;
+    float score = center;
+    const float dx = quadraticPeakOffset(left, center, right, score);
+    const float dy = quadraticPeakOffset(top, center, bottom, score);
+    return Peak(-1, cv::Point2f((peak.x + dx + 0.5f) * scale - 0.5f, (peak.y + dy + 0.5f) * scale - 0.5f), score);
+}
 
-            float right_val = 0;
-            if (x > 0
-                    && y >= 0
-                    && y < heatMap.rows) {
-                right_val = heatMapData[y * heatMapStep + x - 1];
-                right_val = right_val >= threshold ? right_val : 0;
-            }
+// Value of the feature map upsampled by scale at the point. The upsampled map isn't computed:
+// scale 1 means the map is upsampled already, otherwise the value is interpolated bilinearly
+float sampleFeatureMap(const cv::Mat& featureMap, const cv::Point& point, int scale) {
+    if (1 == scale) {
+        return featureMap.at<float>(point);
+    }
+    const float x = std::max(0.0f, std::min((point.x + 0.5f) / scale - 0.5f, featureMap.cols - 1.0f));
+    const float y = std::max(0.0f, std::min((point.y + 0.5f) / scale - 0.5f, featureMap.rows - 1.0f));
+    const int x0 = static_cast<int>(x);
+    const int y0 = static_cast<int>(y);
+    const int x1 = std::min(x0 + 1, featureMap.cols - 1);
+    const int y1 = std::min(y0 + 1, featureMap.rows - 1);
+    const float ax = x - x0;
+    const float ay = y - y0;
+    const float* row0 = featureMap.ptr<float>(y0);
+    const float* row1 = featureMap.ptr<float>(y1);
+    return (1 - ay) * ((1 - ax) * row0[x0] + ax * row0[x1]) + ay * ((1 - ax) * row1[x0] + ax * row1[x1]);
+}
 
-            float top_val = 0;
-            if (x >= 0
-                    && x < heatMap.cols
-                    && y < (heatMap.rows - 1)) {
-                top_val = heatMapData[(y + 1) * heatMapStep + x];
-                top_val = top_val >= threshold ? top_val : 0;
-            }
+// Subsets of the peaks grouped so far by the peaks in them. A peak has a single joint type, so a subset has the peak
+// at the joint iff it contains the peak. Every peak keeps a list of its subsets, a subset is checked on lookup as
+// the peak of its joint may be replaced after the subset has been added to the list
+class SubsetsByPeak {
+public:
+    void reset(size_t peaksNumber) {
+        heads.assign(peaksNumber, -1);
+        entries.clear();
+    }
 
-            float bottom_val = 0;
-            if (x >= 0
-                    && y > 0
-                    && x < heatMap.cols) {
-                bottom_val = heatMapData[(y - 1) * heatMapStep + x];
-                bottom_val = bottom_val >= threshold ? bottom_val : 0;
-            }
+    void add(int peakId, int subsetId) {
+        entries.push_back({subsetId, heads[peakId]});
+        heads[peakId] = static_cast<int>(entries.size()) - 1;
+    }
 
-            if ((val > left_val)
-                    && (val > right_val)
-                    && (val > top_val)
-                    && (val > bottom_val)) {
-                peaks.push_back(cv::Point(x, y));
+    template <typename Callback>
+    void forEach(const std::vector<HumanPoseByPeaksIndices>& subset, int jointId, int peakId, Callback callback) const {
+        for (int entryId = heads[peakId]; entryId >= 0; entryId = entries[entryId].next) {
+            const int subsetId = entries[entryId].subsetId;
+            if (subset[subsetId].peaksIndices[jointId] == peakId) {
+                callback(subsetId);
             }
         }
     }
-    std::sort(peaks.begin(), peaks.end(), [](const cv::Point& a, const cv::Point& b) {
-        return a.x < b.x;
+
+    bool contains(const std::vector<HumanPoseByPeaksIndices>& subset, int jointId, int peakId) const {
+        bool isFound = false;
+        forEach(subset, jointId, peakId, [&isFound](int) {isFound = true;});
+        return isFound;
+    }
+
+private:
+    struct Entry {
+        int subsetId;
+        int next;
+    };
+    std::vector<int> heads;
+    std::vector<Entry> entries;
+};
+
+// Buffers of groupPeaksToPoses() reused for the next frames of the thread
+struct GroupingBuffers {
+    std::vector<TwoJointsConnection> jointConnections;
+    std::vector<TwoJointsConnection> connections;
+    std::vector<bool> occurA;
+    std::vector<bool> occurB;
+    SubsetsByPeak subsetsByPeak;
+};
+
+void setSubsetPeak(std::vector<HumanPoseByPeaksIndices>& subset, SubsetsByPeak& subsetsByPeak,
+                   int subsetId, int jointId, int peakId) {
+    int& peakIdx = subset[subsetId].peaksIndices[jointId];
+    if (peakIdx != peakId) {
+        peakIdx = peakId;
+        subsetsByPeak.add(peakId, subsetId);
+    }
+}
+
+const int limbMidPointsNum = 10;
+
+// Mean score of the points along the limb from a to b whose PAF values match the limb direction vec.
+// The PAF values are sampled first, then the scores are computed without branches in a loop the compiler vectorizes
+float limbPafScore(const std::pair<cv::Mat, cv::Mat>& scoreMid, const cv::Point2f& a, const cv::Point2f& b,
+                   const cv::Point2f& vec, float midPointsScoreThreshold, int featureMapsScale, int& passedNum) {
+    float pafX[limbMidPointsNum];
+    float pafY[limbMidPointsNum];
+    const cv::Point2f step = (b - a) / (limbMidPointsNum - 1);
+    for (int n = 0; n < limbMidPointsNum; n++) {
+        const cv::Point midPoint(cvRound(a.x + n * step.x), cvRound(a.y + n * step.y));
+        pafX[n] = sampleFeatureMap(scoreMid.first, midPoint, featureMapsScale);
+        pafY[n] = sampleFeatureMap(scoreMid.second, midPoint, featureMapsScale);
+    }
+    float sum = 0.0f;
+    passedNum = 0;
+    for (int n = 0; n < limbMidPointsNum; n++) {
+        const float score = vec.x * pafX[n] + vec.y * pafY[n];
+        const bool isPassed = score > midPointsScoreThreshold;
+        sum += isPassed ? score : 0.0f;
+        passedNum += isPassed;
+    }
+    return passedNum > 0 ? sum / passedNum : 0.0f;
+}
+}  // namespace
+
+void findPeaks(const std::vector<cv::Mat>& heatMaps,
+               const float minPeaksDistance,
+               std::vector<std::vector<Peak> >& allPeaks,
+               int heatMapId,
+               int featureMapsScale) {
+    const float threshold = 0.1f;
+    std::vector<cv::Point> peaks;
+    const cv::Mat& heatMap = heatMaps[heatMapId];
+    findHeatMapPeaks(heatMap, threshold, peaks);
+    std::vector<Peak> candidates;
+    candidates.reserve(peaks.size());
+    for (const cv::Point& peak : peaks) {
+        if (1 == featureMapsScale) {
+            candidates.push_back(Peak(-1, peak, heatMap.at<float>(peak)));
+        } else {
+            candidates.push_back(refinePeak(heatMap, peak, featureMapsScale));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Peak& a, const Peak& b) {
+        return a.pos.x < b.pos.x;
     });
-    std::vector<bool> isActualPeak(peaks.size(), true);
+    std::vector<cv::Point2f> positions;
+    positions.reserve(candidates.size());
+    for (const Peak& candidate : candidates) {
+        positions.push_back(candidate.pos);
+    }
+    const std::vector<bool> isActualPeak = suppressClosePoints(positions, minPeaksDistance);
     int peakCounter = 0;
     std::vector<Peak>& peaksWithScoreAndID = allPeaks[heatMapId];
-    for (size_t i = 0; i < peaks.size(); i++) {
+    for (size_t i = 0; i < candidates.size(); i++) {
         if (isActualPeak[i]) {
-            for (size_t j = i + 1; j < peaks.size(); j++) {
-                if (sqrt((peaks[i].x - peaks[j].x) * (peaks[i].x - peaks[j].x) +
-                         (peaks[i].y - peaks[j].y) * (peaks[i].y - peaks[j].y)) < minPeaksDistance) {
-                    isActualPeak[j] = false;
-                }
-            }
-            peaksWithScoreAndID.push_back(Peak(peakCounter++, peaks[i], heatMap.at<float>(peaks[i])));
+            candidates[i].id = peakCounter++;
+            peaksWithScoreAndID.push_back(candidates[i]);
         }
     }
 }
@@ -113,7 +202,8 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
                                          const float midPointsScoreThreshold,
                                          const float foundMidPointsRatioThreshold,
                                          const int minJointsNumber,
-                                         const float minSubsetScore) {
+                                         const float minSubsetScore,
+                                         const int featureMapsScale) {
     static const std::pair<int, int> limbIdsHeatmap[] = {
         {2, 3}, {2, 6}, {3, 4}, {4, 5}, {6, 7}, {7, 8}, {2, 9}, {9, 10}, {10, 11}, {2, 12}, {12, 13}, {13, 14},
         {2, 1}, {1, 15}, {15, 17}, {1, 16}, {16, 18}, {3, 17}, {6, 18}
@@ -127,9 +217,13 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
     for (const auto& peaks : allPeaks) {
          candidates.insert(candidates.end(), peaks.begin(), peaks.end());
     }
-    std::vector<HumanPoseByPeaksIndices> subset(0, HumanPoseByPeaksIndices(keypointsNumber));
+    static thread_local GroupingBuffers buffers;
+    SubsetsByPeak& subsetsByPeak = buffers.subsetsByPeak;
+    subsetsByPeak.reset(candidates.size());
+    std::vector<HumanPoseByPeaksIndices> subset;
     for (size_t k = 0; k < arraySize(limbIdsPaf); k++) {
-        std::vector<TwoJointsConnection> connections;
+        std::vector<TwoJointsConnection>& connections = buffers.connections;
+        connections.clear();
         const int mapIdxOffset = keypointsNumber + 1;
         std::pair<cv::Mat, cv::Mat> scoreMid = { pafs[limbIdsPaf[k].first - mapIdxOffset],
                                                  pafs[limbIdsPaf[k].second - mapIdxOffset] };
@@ -142,45 +236,24 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
         if (nJointsA == 0
                 && nJointsB == 0) {
             continue;
-        } else if (nJointsA == 0) {
-            for (size_t i = 0; i < nJointsB; i++) {
-                int num = 0;
-                for (size_t j = 0; j < subset.size(); j++) {
-                    if (subset[j].peaksIndices[idxJointB] == candB[i].id) {
-                        num++;
-                        continue;
-                    }
-                }
-                if (num == 0) {
+        } else if (nJointsA == 0 || nJointsB == 0) {
+            // The joints of the other type start their own subsets unless they are in a subset already
+            const int idxJoint = nJointsA == 0 ? idxJointB : idxJointA;
+            for (const Peak& peak : nJointsA == 0 ? candB : candA) {
+                if (!subsetsByPeak.contains(subset, idxJoint, peak.id)) {
                     HumanPoseByPeaksIndices personKeypoints(keypointsNumber);
-                    personKeypoints.peaksIndices[idxJointB] = candB[i].id;
                     personKeypoints.nJoints = 1;
-                    personKeypoints.score = candB[i].score;
-                    subset.push_back(personKeypoints);
-                }
-            }
-            continue;
-        } else if (nJointsB == 0) {
-            for (size_t i = 0; i < nJointsA; i++) {
-                int num = 0;
-                for (size_t j = 0; j < subset.size(); j++) {
-                    if (subset[j].peaksIndices[idxJointA] == candA[i].id) {
-                        num++;
-                        continue;
-                    }
-                }
-                if (num == 0) {
-                    HumanPoseByPeaksIndices personKeypoints(keypointsNumber);
-                    personKeypoints.peaksIndices[idxJointA] = candA[i].id;
-                    personKeypoints.nJoints = 1;
-                    personKeypoints.score = candA[i].score;
+                    personKeypoints.score = peak.score;
                     subset.push_back(personKeypoints);
+                    setSubsetPeak(subset, subsetsByPeak, static_cast<int>(subset.size()) - 1, idxJoint, peak.id);
                 }
             }
             continue;
         }
 
-        std::vector<TwoJointsConnection> tempJointConnections;
+        std::vector<TwoJointsConnection>& tempJointConnections = buffers.jointConnections;
+        tempJointConnections.clear();
+        const int height_n = pafs[0].rows * featureMapsScale / 2;
         for (size_t i = 0; i < nJointsA; i++) {
             for (size_t j = 0; j < nJointsB; j++) {
                 cv::Point2f pt = candA[i].pos * 0.5 + candB[j].pos * 0.5;
@@ -191,30 +264,16 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
                     continue;
                 }
                 vec /= norm_vec;
-                float score = vec.x * scoreMid.first.at<float>(mid) + vec.y * scoreMid.second.at<float>(mid);
-                int height_n  = pafs[0].rows / 2;
+                float score = vec.x * sampleFeatureMap(scoreMid.first, mid, featureMapsScale)
+                    + vec.y * sampleFeatureMap(scoreMid.second, mid, featureMapsScale);
                 float suc_ratio = 0.0f;
                 float mid_score = 0.0f;
-                const int mid_num = 10;
                 const float scoreThreshold = -100.0f;
                 if (score > scoreThreshold) {
-                    float p_sum = 0;
                     int p_count = 0;
-                    cv::Size2f step((candB[j].pos.x - candA[i].pos.x)/(mid_num - 1),
-                                    (candB[j].pos.y - candA[i].pos.y)/(mid_num - 1));
-                    for (int n = 0; n < mid_num; n++) {
-                        cv::Point midPoint(cvRound(candA[i].pos.x + n * step.width),
-                                           cvRound(candA[i].pos.y + n * step.height));
-                        cv::Point2f pred(scoreMid.first.at<float>(midPoint),
-                                         scoreMid.second.at<float>(midPoint));
-                        score = vec.x * pred.x + vec.y * pred.y;
-                        if (score > midPointsScoreThreshold) {
-                            p_sum += score;
-                            p_count++;
-                        }
-                    }
-                    suc_ratio = static_cast<float>(p_count / mid_num);
-                    float ratio = p_count > 0 ? p_sum / p_count : 0.0f;
+                    const float ratio = limbPafScore(scoreMid, candA[i].pos, candB[j].pos, vec,
+                                                     midPointsScoreThreshold, featureMapsScale, p_count);
+                    suc_ratio = static_cast<float>(p_count / limbMidPointsNum);
                     mid_score = ratio + static_cast<float>(std::min(height_n / norm_vec - 1, 0.0));
                 }
                 if (mid_score > 0
@@ -232,8 +291,10 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
         }
         size_t num_limbs = std::min(nJointsA, nJointsB);
         size_t cnt = 0;
-        std::vector<int> occurA(nJointsA, 0);
-        std::vector<int> occurB(nJointsB, 0);
+        std::vector<bool>& occurA = buffers.occurA;
+        std::vector<bool>& occurB = buffers.occurB;
+        occurA.assign(nJointsA, false);
+        occurB.assign(nJointsB, false);
         for (size_t row = 0; row < tempJointConnections.size(); row++) {
             if (cnt == num_limbs) {
                 break;
@@ -241,12 +302,12 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
             const int& indexA = tempJointConnections[row].firstJointIdx;
             const int& indexB = tempJointConnections[row].secondJointIdx;
             const float& score = tempJointConnections[row].score;
-            if (occurA[indexA] == 0
-                    && occurB[indexB] == 0) {
+            if (!occurA[indexA]
+                    && !occurB[indexB]) {
                 connections.push_back(TwoJointsConnection(candA[indexA].id, candB[indexB].id, score));
                 cnt++;
-                occurA[indexA] = 1;
-                occurB[indexB] = 1;
+                occurA[indexA] = true;
+                occurB[indexB] = true;
             }
         }
         if (connections.empty()) {
@@ -257,27 +318,30 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
         if (k == 0) {
             subset = std::vector<HumanPoseByPeaksIndices>(
                         connections.size(), HumanPoseByPeaksIndices(keypointsNumber));
+            subsetsByPeak.reset(candidates.size());
             for (size_t i = 0; i < connections.size(); i++) {
                 const int& indexA = connections[i].firstJointIdx;
                 const int& indexB = connections[i].secondJointIdx;
-                subset[i].peaksIndices[idxJointA] = indexA;
-                subset[i].peaksIndices[idxJointB] = indexB;
+                setSubsetPeak(subset, subsetsByPeak, static_cast<int>(i), idxJointA, indexA);
+                setSubsetPeak(subset, subsetsByPeak, static_cast<int>(i), idxJointB, indexB);
                 subset[i].nJoints = 2;
                 subset[i].score = candidates[indexA].score + candidates[indexB].score + connections[i].score;
             }
         } else if (extraJointConnections) {
+            // A subset which has one peak of the connection gets the other one if it's missing
             for (size_t i = 0; i < connections.size(); i++) {
                 const int& indexA = connections[i].firstJointIdx;
                 const int& indexB = connections[i].secondJointIdx;
-                for (size_t j = 0; j < subset.size(); j++) {
-                    if (subset[j].peaksIndices[idxJointA] == indexA
-                            && subset[j].peaksIndices[idxJointB] == -1) {
-                        subset[j].peaksIndices[idxJointB] = indexB;
-                    } else if (subset[j].peaksIndices[idxJointB] == indexB
-                                && subset[j].peaksIndices[idxJointA] == -1) {
-                        subset[j].peaksIndices[idxJointA] = indexA;
+                subsetsByPeak.forEach(subset, idxJointA, indexA, [&](int j) {
+                    if (subset[j].peaksIndices[idxJointB] == -1) {
+                        setSubsetPeak(subset, subsetsByPeak, j, idxJointB, indexB);
                     }
-                }
+                });
+                subsetsByPeak.forEach(subset, idxJointB, indexB, [&](int j) {
+                    if (subset[j].peaksIndices[idxJointA] == -1) {
+                        setSubsetPeak(subset, subsetsByPeak, j, idxJointA, indexA);
+                    }
+                });
             }
             continue;
         } else {
@@ -285,21 +349,20 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
                 const int& indexA = connections[i].firstJointIdx;
                 const int& indexB = connections[i].secondJointIdx;
                 bool num = false;
-                for (size_t j = 0; j < subset.size(); j++) {
-                    if (subset[j].peaksIndices[idxJointA] == indexA) {
-                        subset[j].peaksIndices[idxJointB] = indexB;
-                        subset[j].nJoints++;
-                        subset[j].score += candidates[indexB].score + connections[i].score;
-                        num = true;
-                    }
-                }
+                subsetsByPeak.forEach(subset, idxJointA, indexA, [&](int j) {
+                    setSubsetPeak(subset, subsetsByPeak, j, idxJointB, indexB);
+                    subset[j].nJoints++;
+                    subset[j].score += candidates[indexB].score + connections[i].score;
+                    num = true;
+                });
                 if (!num) {
                     HumanPoseByPeaksIndices hpWithScore(keypointsNumber);
-                    hpWithScore.peaksIndices[idxJointA] = indexA;
-                    hpWithScore.peaksIndices[idxJointB] = indexB;
                     hpWithScore.nJoints = 2;
                     hpWithScore.score = candidates[indexA].score + candidates[indexB].score + connections[i].score;
                     subset.push_back(hpWithScore);
+                    const int subsetId = static_cast<int>(subset.size()) - 1;
+                    setSubsetPeak(subset, subsetsByPeak, subsetId, idxJointA, indexA);
+                    setSubsetPeak(subset, subsetsByPeak, subsetId, idxJointB, indexB);
                 }
             }
         }
@@ -325,4 +388,85 @@ std::vector<HumanPose> groupPeaksToPoses(const std::vector<std::vector<Peak> >&
     }
     return poses;
 }
+
+bool trackPoses(const std::vector<std::vector<Peak> >& allPeaks,
+                std::vector<HumanPose>& poses,
+                const float maxKeypointShift,
+                const float minTrackedKeypointsRatio,
+                const int minJointsNumber) {
+    if (poses.empty()) {
+        return false;
+    }
+    struct Match {
+        int poseId;
+        int jointId;
+        int peakIdx;
+        float distanceSquared;
+    };
+    // Keypoints of groupPeaksToPoses() are shifted by half a pixel from their peaks
+    const cv::Point2f keypointOffset(0.5f, 0.5f);
+    const cv::Point2f absentKeypoint(-1.0f, -1.0f);
+    const float maxShiftSquared = maxKeypointShift * maxKeypointShift;
+    std::vector<Match> matches;
+    std::vector<cv::Point2f> peakKeypoints;
+    for (size_t jointId = 0; jointId < allPeaks.size(); jointId++) {
+        for (const Peak& peak : allPeaks[jointId]) {
+            const cv::Point2f keypoint = peak.pos + keypointOffset;
+            for (size_t poseId = 0; poseId < poses.size(); poseId++) {
+                const cv::Point2f& previous = poses[poseId].keypoints[jointId];
+                if (previous == absentKeypoint) {
+                    continue;
+                }
+                const cv::Point2f shift = keypoint - previous;
+                const float distanceSquared = shift.x * shift.x + shift.y * shift.y;
+                if (distanceSquared <= maxShiftSquared) {
+                    matches.push_back({static_cast<int>(poseId), static_cast<int>(jointId),
+                                       static_cast<int>(peakKeypoints.size()), distanceSquared});
+                }
+            }
+            peakKeypoints.push_back(keypoint);
+        }
+    }
+    // The closest pairs are matched first, like connections of limbs are taken by their scores in grouping
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.distanceSquared < b.distanceSquared;
+    });
+
+    const size_t keypointsNumber = allPeaks.size();
+    std::vector<int> keypointPeaks(poses.size() * keypointsNumber, -1);
+    std::vector<bool> isPeakTaken(peakKeypoints.size(), false);
+    int takenPeaksNumber = 0;
+    for (const Match& match : matches) {
+        int& keypointPeak = keypointPeaks[match.poseId * keypointsNumber + match.jointId];
+        if (keypointPeak < 0 && !isPeakTaken[match.peakIdx]) {
+            keypointPeak = match.peakIdx;
+            isPeakTaken[match.peakIdx] = true;
+            takenPeaksNumber++;
+        }
+    }
+    if (static_cast<int>(peakKeypoints.size()) - takenPeaksNumber >= minJointsNumber) {
+        return false;
+    }
+
+    for (size_t poseId = 0; poseId < poses.size(); poseId++) {
+        int previousJointsNumber = 0;
+        int trackedJointsNumber = 0;
+        for (size_t jointId = 0; jointId < keypointsNumber; jointId++) {
+            previousJointsNumber += poses[poseId].keypoints[jointId] != absentKeypoint;
+            trackedJointsNumber += keypointPeaks[poseId * keypointsNumber + jointId] >= 0;
+        }
+        if (trackedJointsNumber < minJointsNumber
+                || trackedJointsNumber < minTrackedKeypointsRatio * previousJointsNumber) {
+            return false;
+        }
+    }
+
+    for (size_t poseId = 0; poseId < poses.size(); poseId++) {
+        for (size_t jointId = 0; jointId < keypointsNumber; jointId++) {
+            const int peakIdx = keypointPeaks[poseId * keypointsNumber + jointId];
+            poses[poseId].keypoints[jointId] = peakIdx >= 0 ? peakKeypoints[peakIdx] : absentKeypoint;
+        }
+    }
+    return true;
+}
 }  // namespace human_pose_estimation
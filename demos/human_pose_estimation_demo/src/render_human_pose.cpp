@@ -2,19 +2,21 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 #include <vector>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
-#include "human_pose_estimator.hpp"
+#include "human_pose_model.hpp"
 #include "render_human_pose.hpp"
 
 namespace human_pose_estimation {
 void renderHumanPose(const std::vector<HumanPose>& poses, cv::Mat& image) {
     CV_Assert(image.type() == CV_8UC3);
 
-    static const cv::Scalar colors[HumanPoseEstimator::keypointsNumber] = {
+    static const cv::Scalar colors[HumanPoseModel::keypointsNumber] = {
         cv::Scalar(255, 0, 0), cv::Scalar(255, 85, 0), cv::Scalar(255, 170, 0),
         cv::Scalar(255, 255, 0), cv::Scalar(170, 255, 0), cv::Scalar(85, 255, 0),
         cv::Scalar(0, 255, 0), cv::Scalar(0, 255, 85), cv::Scalar(0, 255, 170),
@@ -34,7 +36,7 @@ void renderHumanPose(const std::vector<HumanPose>& poses, cv::Mat& image) {
     const int stickWidth = 4;
     const cv::Point2f absentKeypoint(-1.0f, -1.0f);
     for (const auto& pose : poses) {
-        CV_Assert(pose.keypoints.size() == HumanPoseEstimator::keypointsNumber);
+        CV_Assert(pose.keypoints.size() == HumanPoseModel::keypointsNumber);
 
         for (size_t keypointIdx = 0; keypointIdx < pose.keypoints.size(); keypointIdx++) {
             if (pose.keypoints[keypointIdx] != absentKeypoint) {
@@ -42,8 +44,20 @@ void renderHumanPose(const std::vector<HumanPose>& poses, cv::Mat& image) {
             }
         }
     }
-    cv::Mat pane = image.clone();
+    // The limbs are blended with the image. Blending changes only the pixels of the limbs, so every group of poses
+    // with overlapping bounding rectangles is blended in its rectangle instead of the whole image
+    struct Limb {
+        std::vector<cv::Point> polygon;
+        cv::Scalar color;
+    };
+    struct LimbGroup {
+        std::vector<Limb> limbs;
+        cv::Rect roi;
+    };
+    const cv::Rect imageRect(0, 0, image.cols, image.rows);
+    std::vector<LimbGroup> groups;
     for (const auto& pose : poses) {
+        LimbGroup group;
         for (const auto& limbKeypointsId : limbKeypointsIds) {
             std::pair<cv::Point2f, cv::Point2f> limbKeypoints(pose.keypoints[limbKeypointsId.first],
                     pose.keypoints[limbKeypointsId.second]);
@@ -57,12 +71,43 @@ void renderHumanPose(const std::vector<HumanPose>& poses, cv::Mat& image) {
             cv::Point difference = limbKeypoints.first - limbKeypoints.second;
             double length = std::sqrt(difference.x * difference.x + difference.y * difference.y);
             int angle = static_cast<int>(std::atan2(difference.y, difference.x) * 180 / CV_PI);
-            std::vector<cv::Point> polygon;
+            Limb limb{{}, colors[limbKeypointsId.second]};
             cv::ellipse2Poly(cv::Point2d(meanX, meanY), cv::Size2d(length / 2, stickWidth),
-                             angle, 0, 360, 1, polygon);
-            cv::fillConvexPoly(pane, polygon, colors[limbKeypointsId.second]);
+                             angle, 0, 360, 1, limb.polygon);
+            group.roi |= cv::boundingRect(limb.polygon);
+            group.limbs.push_back(std::move(limb));
+        }
+        group.roi &= imageRect;
+        if (group.roi.area() > 0) {
+            groups.push_back(std::move(group));
+        }
+    }
+    // A grown rectangle may overlap the groups checked before, so merge until nothing overlaps
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < groups.size(); i++) {
+            for (size_t j = i + 1; j < groups.size();) {
+                if ((groups[i].roi & groups[j].roi).area() > 0) {
+                    groups[i].roi |= groups[j].roi;
+                    std::move(groups[j].limbs.begin(), groups[j].limbs.end(), std::back_inserter(groups[i].limbs));
+                    groups.erase(groups.begin() + j);
+                    merged = true;
+                } else {
+                    j++;
+                }
+            }
+        }
+    }
+    for (auto& group : groups) {
+        cv::Mat roi = image(group.roi);
+        cv::Mat pane = roi.clone();
+        for (auto& limb : group.limbs) {
+            for (auto& point : limb.polygon) {
+                point -= group.roi.tl();
+            }
+            cv::fillConvexPoly(pane, limb.polygon, limb.color);
         }
+        cv::addWeighted(roi, 0.4, pane, 0.6, 0, roi);
     }
-    cv::addWeighted(image, 0.4, pane, 0.6, 0, image);
 }
 }  // namespace human_pose_estimation
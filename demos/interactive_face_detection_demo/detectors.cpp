@@ -21,6 +21,7 @@
 
 #include <samples/ocv_common.hpp>
 #include <samples/slog.hpp>
+#include <samples/warmup.hpp>
 
 #include "detectors.hpp"
 
@@ -31,7 +32,7 @@ BaseDetection::BaseDetection(const std::string &topoName,
                              const std::string &deviceForInference,
                              int maxBatch, bool isBatchDynamic, bool isAsync,
                              bool doRawOutputMessages)
-    : topoName(topoName), pathToModel(pathToModel), deviceForInference(deviceForInference),
+    : requestsSets(2), numSubmittedRequests(2, 0), setId(0), topoName(topoName), pathToModel(pathToModel), deviceForInference(deviceForInference),
       maxBatch(maxBatch), isBatchDynamic(isBatchDynamic), isAsync(isAsync),
       enablingChecked(false), _enabled(false), doRawOutputMessages(doRawOutputMessages) {
     if (isAsync) {
@@ -55,9 +56,51 @@ void BaseDetection::submitRequest() {
 }
 
 void BaseDetection::wait() {
-    if (!enabled()|| !request || !isAsync)
+    if (!enabled() || !isAsync)
         return;
-    request->Wait(IInferRequest::WaitMode::RESULT_READY);
+    for (size_t i = 0; i < numSubmittedRequests[setId]; i++) {
+        requestsSets[setId][i]->Wait(IInferRequest::WaitMode::RESULT_READY);
+    }
+}
+
+void BaseDetection::switchRequest() {
+    setId = (setId + 1) % requestsSets.size();
+}
+
+InferRequest::Ptr BaseDetection::requestForFace(size_t faceId) {
+    std::vector<InferRequest::Ptr>& requests = requestsSets[setId];
+    const size_t requestIdx = faceId / maxBatch;
+    if (faceId % maxBatch == 0 && requestIdx > 0) {
+        // The previous request is full, it is inferred while the next faces are enqueued
+        request = requests[requestIdx - 1];
+        if (isBatchDynamic) {
+            request->SetBatch(maxBatch);
+        }
+        BaseDetection::submitRequest();
+    }
+    if (requests.size() == requestIdx) {
+        requests.push_back(net.CreateInferRequestPtr());
+    }
+    request = requests[requestIdx];
+    return request;
+}
+
+void BaseDetection::submitFaces(size_t numFaces) {
+    numSubmittedRequests[setId] = 0;
+    if (!enabled() || !numFaces)
+        return;
+    const size_t numRequests = (numFaces + maxBatch - 1) / maxBatch;
+    request = requestsSets[setId][numRequests - 1];
+    if (isBatchDynamic) {
+        // The last request takes the rest of the faces only
+        request->SetBatch(numFaces - (numRequests - 1) * maxBatch);
+    }
+    BaseDetection::submitRequest();
+    numSubmittedRequests[setId] = numRequests;
+}
+
+const InferRequest::Ptr& BaseDetection::resultRequest(size_t faceId) const {
+    return requestsSets[setId][faceId / maxBatch];
 }
 
 bool BaseDetection::enabled() const  {
@@ -72,7 +115,7 @@ bool BaseDetection::enabled() const  {
 }
 
 void BaseDetection::printPerformanceCounts(std::string fullDeviceName) {
-    if (!enabled()) {
+    if (!enabled() || !request) {
         return;
     }
     slog::info << "Performance counts for " << topoName << slog::endl << slog::endl;
@@ -80,6 +123,49 @@ void BaseDetection::printPerformanceCounts(std::string fullDeviceName) {
 }
 
 
+void FaceInputs::addInputSize(const cv::Size& size) {
+    auto it = std::find_if(inputs.begin(), inputs.end(), [&](const Input& input) { return input.size == size; });
+    if (it == inputs.end()) {
+        inputs.push_back({size, cv::Mat(), false});
+        baseSize = cv::Size(std::max(baseSize.width, size.width), std::max(baseSize.height, size.height));
+        isBaseReady = false;
+    }
+}
+
+void FaceInputs::setFace(const cv::Mat& face) {
+    this->face = face;
+    isBaseReady = false;
+    for (Input& input : inputs) {
+        input.isReady = false;
+    }
+}
+
+const cv::Mat& FaceInputs::resized(const cv::Size& size) {
+    if (face.size() == size) {
+        return face;
+    }
+    addInputSize(size);
+    Input& input = *std::find_if(inputs.begin(), inputs.end(), [&](const Input& input) { return input.size == size; });
+    if (!input.isReady) {
+        cv::resize(source(size), input.image, size);
+        input.isReady = true;
+    }
+    return input.image;
+}
+
+const cv::Mat& FaceInputs::source(const cv::Size& size) {
+    // Shrinking to the base only pays off for the faces bigger than it
+    if (size == baseSize || face.cols <= baseSize.width || face.rows <= baseSize.height) {
+        return face;
+    }
+    if (!isBaseReady) {
+        cv::resize(face, base, baseSize);
+        isBaseReady = true;
+    }
+    return base;
+}
+
+
 FaceDetection::FaceDetection(const std::string &pathToModel,
                              const std::string &deviceForInference,
                              int maxBatch, bool isBatchDynamic, bool isAsync,
@@ -97,15 +183,13 @@ void FaceDetection::submitRequest() {
     enquedFrames = 0;
     resultsFetched = false;
     results.clear();
-    BaseDetection::submitRequest();
+    submitFaces(1);
 }
 
 void FaceDetection::enqueue(const cv::Mat &frame) {
     if (!enabled()) return;
 
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
+    requestForFace(0);
 
     width = static_cast<float>(frame.cols);
     height = static_cast<float>(frame.rows);
@@ -293,39 +377,26 @@ AntispoofingClassifier::AntispoofingClassifier(const std::string& pathToModel,
 }
 
 void AntispoofingClassifier::submitRequest() {
-    if (!enquedFaces)
-        return;
-    if (isBatchDynamic) {
-        request->SetBatch(enquedFaces);
-    }
-    BaseDetection::submitRequest();
+    submitFaces(enquedFaces);
     enquedFaces = 0;
 }
 
-void AntispoofingClassifier::enqueue(const cv::Mat& face) {
+void AntispoofingClassifier::enqueue(FaceInputs& face) {
     if (!enabled()) {
         return;
     }
-    if (enquedFaces == maxBatch) {
-        slog::warn << "Number of detected faces more than maximum(" << maxBatch << ") processed by Antispoofing Classifier network" << slog::endl;
-        return;
-    }
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
-
-    Blob::Ptr  inputBlob = request->GetBlob(input);
+    Blob::Ptr inputBlob = requestForFace(enquedFaces)->GetBlob(input);
 
-    matU8ToBlob<uint8_t>(face, inputBlob, enquedFaces);
+    matU8ToBlob<uint8_t>(face.resized(inputSize), inputBlob, enquedFaces % maxBatch);
 
     enquedFaces++;
 }
 
 float AntispoofingClassifier::operator[] (int idx) const {
-    Blob::Ptr  ProbBlob = request->GetBlob(prob_output);
+    Blob::Ptr  ProbBlob = resultRequest(idx)->GetBlob(prob_output);
     LockedMemory<const void> ProbBlobMapped = as<MemoryBlob>(ProbBlob)->rmap();
     // use prediction for real face only
-    float r = ProbBlobMapped.as<float*>()[2 * idx] * 100;
+    float r = ProbBlobMapped.as<float*>()[2 * (idx % maxBatch)] * 100;
     if (doRawOutputMessages) {
         std::cout << "[" << idx << "] element, real face probability = " << r << std::endl;
     }
@@ -378,42 +449,30 @@ AgeGenderDetection::AgeGenderDetection(const std::string &pathToModel,
 }
 
 void AgeGenderDetection::submitRequest()  {
-    if (!enquedFaces)
-        return;
-    if (isBatchDynamic) {
-        request->SetBatch(enquedFaces);
-    }
-    BaseDetection::submitRequest();
+    submitFaces(enquedFaces);
     enquedFaces = 0;
 }
 
-void AgeGenderDetection::enqueue(const cv::Mat &face) {
+void AgeGenderDetection::enqueue(FaceInputs &face) {
     if (!enabled()) {
         return;
     }
-    if (enquedFaces == maxBatch) {
-        slog::warn << "Number of detected faces more than maximum(" << maxBatch << ") processed by Age/Gender Recognition network" << slog::endl;
-        return;
-    }
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
-
-    Blob::Ptr  inputBlob = request->GetBlob(input);
+    Blob::Ptr inputBlob = requestForFace(enquedFaces)->GetBlob(input);
 
-    matU8ToBlob<uint8_t>(face, inputBlob, enquedFaces);
+    matU8ToBlob<uint8_t>(face.resized(inputSize), inputBlob, enquedFaces % maxBatch);
 
     enquedFaces++;
 }
 
 AgeGenderDetection::Result AgeGenderDetection::operator[] (int idx) const {
-    Blob::Ptr  genderBlob = request->GetBlob(outputGender);
-    Blob::Ptr  ageBlob    = request->GetBlob(outputAge);
+    Blob::Ptr  genderBlob = resultRequest(idx)->GetBlob(outputGender);
+    Blob::Ptr  ageBlob    = resultRequest(idx)->GetBlob(outputAge);
+    const size_t batchIdx = idx % maxBatch;
 
     LockedMemory<const void> ageBlobMapped = as<MemoryBlob>(ageBlob)->rmap();
     LockedMemory<const void> genderBlobMapped = as<MemoryBlob>(genderBlob)->rmap();
-    AgeGenderDetection::Result r = {ageBlobMapped.as<float*>()[idx] * 100,
-                                    genderBlobMapped.as<float*>()[idx * 2 + 1]};
+    AgeGenderDetection::Result r = {ageBlobMapped.as<float*>()[batchIdx] * 100,
+                                    genderBlobMapped.as<float*>()[batchIdx * 2 + 1]};
     if (doRawOutputMessages) {
         std::cout << "[" << idx << "] element, male prob = " << r.maleProb << ", age = " << r.age << std::endl;
     }
@@ -469,44 +528,33 @@ HeadPoseDetection::HeadPoseDetection(const std::string &pathToModel,
 }
 
 void HeadPoseDetection::submitRequest()  {
-    if (!enquedFaces) return;
-    if (isBatchDynamic) {
-        request->SetBatch(enquedFaces);
-    }
-    BaseDetection::submitRequest();
+    submitFaces(enquedFaces);
     enquedFaces = 0;
 }
 
-void HeadPoseDetection::enqueue(const cv::Mat &face) {
+void HeadPoseDetection::enqueue(FaceInputs &face) {
     if (!enabled()) {
         return;
     }
-    if (enquedFaces == maxBatch) {
-        slog::warn << "Number of detected faces more than maximum(" << maxBatch << ") processed by Head Pose estimator" << slog::endl;
-        return;
-    }
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
-
-    Blob::Ptr inputBlob = request->GetBlob(input);
+    Blob::Ptr inputBlob = requestForFace(enquedFaces)->GetBlob(input);
 
-    matU8ToBlob<uint8_t>(face, inputBlob, enquedFaces);
+    matU8ToBlob<uint8_t>(face.resized(inputSize), inputBlob, enquedFaces % maxBatch);
 
     enquedFaces++;
 }
 
 HeadPoseDetection::Results HeadPoseDetection::operator[] (int idx) const {
-    Blob::Ptr  angleR = request->GetBlob(outputAngleR);
-    Blob::Ptr  angleP = request->GetBlob(outputAngleP);
-    Blob::Ptr  angleY = request->GetBlob(outputAngleY);
+    Blob::Ptr  angleR = resultRequest(idx)->GetBlob(outputAngleR);
+    Blob::Ptr  angleP = resultRequest(idx)->GetBlob(outputAngleP);
+    Blob::Ptr  angleY = resultRequest(idx)->GetBlob(outputAngleY);
+    const size_t batchIdx = idx % maxBatch;
 
     LockedMemory<const void> angleRMapped = as<MemoryBlob>(angleR)->rmap();
     LockedMemory<const void> anglePMapped = as<MemoryBlob>(angleP)->rmap();
     LockedMemory<const void> angleYMapped = as<MemoryBlob>(angleY)->rmap();
-    HeadPoseDetection::Results r = {angleRMapped.as<float*>()[idx],
-                                    anglePMapped.as<float*>()[idx],
-                                    angleYMapped.as<float*>()[idx]};
+    HeadPoseDetection::Results r = {angleRMapped.as<float*>()[batchIdx],
+                                    anglePMapped.as<float*>()[batchIdx],
+                                    angleYMapped.as<float*>()[batchIdx]};
 
     if (doRawOutputMessages) {
         std::cout << "[" << idx << "] element, yaw = " << r.angle_y <<
@@ -562,29 +610,17 @@ EmotionsDetection::EmotionsDetection(const std::string &pathToModel,
 }
 
 void EmotionsDetection::submitRequest() {
-    if (!enquedFaces) return;
-    if (isBatchDynamic) {
-        request->SetBatch(enquedFaces);
-    }
-    BaseDetection::submitRequest();
+    submitFaces(enquedFaces);
     enquedFaces = 0;
 }
 
-void EmotionsDetection::enqueue(const cv::Mat &face) {
+void EmotionsDetection::enqueue(FaceInputs &face) {
     if (!enabled()) {
         return;
     }
-    if (enquedFaces == maxBatch) {
-        slog::warn << "Number of detected faces more than maximum(" << maxBatch << ") processed by Emotions Recognition network" << slog::endl;
-        return;
-    }
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
+    Blob::Ptr inputBlob = requestForFace(enquedFaces)->GetBlob(input);
 
-    Blob::Ptr inputBlob = request->GetBlob(input);
-
-    matU8ToBlob<uint8_t>(face, inputBlob, enquedFaces);
+    matU8ToBlob<uint8_t>(face.resized(inputSize), inputBlob, enquedFaces % maxBatch);
 
     enquedFaces++;
 }
@@ -592,7 +628,7 @@ void EmotionsDetection::enqueue(const cv::Mat &face) {
 std::map<std::string, float> EmotionsDetection::operator[] (int idx) const {
     auto emotionsVecSize = emotionsVec.size();
 
-    Blob::Ptr emotionsBlob = request->GetBlob(outputEmotions);
+    Blob::Ptr emotionsBlob = resultRequest(idx)->GetBlob(outputEmotions);
 
     /* emotions vector must have the same size as number of channels
      * in model output. Default output format is NCHW, so index 1 is checked */
@@ -606,7 +642,7 @@ std::map<std::string, float> EmotionsDetection::operator[] (int idx) const {
 
     LockedMemory<const void> emotionsBlobMapped = as<MemoryBlob>(emotionsBlob)->rmap();
     auto emotionsValues = emotionsBlobMapped.as<float *>();
-    auto outputIdxPos = emotionsValues + idx * emotionsVecSize;
+    auto outputIdxPos = emotionsValues + (idx % maxBatch) * emotionsVecSize;
     std::map<std::string, float> emotions;
 
     if (doRawOutputMessages) {
@@ -676,29 +712,17 @@ FacialLandmarksDetection::FacialLandmarksDetection(const std::string &pathToMode
 }
 
 void FacialLandmarksDetection::submitRequest() {
-    if (!enquedFaces) return;
-    if (isBatchDynamic) {
-        request->SetBatch(enquedFaces);
-    }
-    BaseDetection::submitRequest();
+    submitFaces(enquedFaces);
     enquedFaces = 0;
 }
 
-void FacialLandmarksDetection::enqueue(const cv::Mat &face) {
+void FacialLandmarksDetection::enqueue(FaceInputs &face) {
     if (!enabled()) {
         return;
     }
-    if (enquedFaces == maxBatch) {
-        slog::warn << "Number of detected faces more than maximum(" << maxBatch << ") processed by Facial Landmarks estimator" << slog::endl;
-        return;
-    }
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
+    Blob::Ptr inputBlob = requestForFace(enquedFaces)->GetBlob(input);
 
-    Blob::Ptr inputBlob = request->GetBlob(input);
-
-    matU8ToBlob<uint8_t>(face, inputBlob, enquedFaces);
+    matU8ToBlob<uint8_t>(face.resized(inputSize), inputBlob, enquedFaces % maxBatch);
 
     enquedFaces++;
 }
@@ -706,17 +730,16 @@ void FacialLandmarksDetection::enqueue(const cv::Mat &face) {
 std::vector<float> FacialLandmarksDetection::operator[] (int idx) const {
     std::vector<float> normedLandmarks;
 
-    auto landmarksBlob = request->GetBlob(outputFacialLandmarksBlobName);
+    auto landmarksBlob = resultRequest(idx)->GetBlob(outputFacialLandmarksBlobName);
     auto n_lm = getTensorChannels(landmarksBlob->getTensorDesc());
-    LockedMemory<const void> facialLandmarksBlobMapped =
-        as<MemoryBlob>(request->GetBlob(outputFacialLandmarksBlobName))->rmap();
+    LockedMemory<const void> facialLandmarksBlobMapped = as<MemoryBlob>(landmarksBlob)->rmap();
     const float *normed_coordinates = facialLandmarksBlobMapped.as<float *>();
 
     if (doRawOutputMessages) {
         std::cout << "[" << idx << "] element, normed facial landmarks coordinates (x, y):" << std::endl;
     }
 
-    auto begin = n_lm * idx;
+    auto begin = n_lm * (idx % maxBatch);
     auto end = begin + n_lm / 2;
     for (auto i_lm = begin; i_lm < end; ++i_lm) {
         float normed_x = normed_coordinates[2 * i_lm];
@@ -779,9 +802,10 @@ CNNNetwork FacialLandmarksDetection::read(const InferenceEngine::Core& ie) {
 Load::Load(BaseDetection& detector) : detector(detector) {
 }
 
-void Load::into(InferenceEngine::Core & ie, const std::string & deviceName, bool enable_dynamic_batch) const {
+void Load::into(InferenceEngine::Core & ie, const std::string & deviceName, bool enable_dynamic_batch,
+                const std::map<std::string, std::string>& extraConfig) const {
     if (detector.enabled()) {
-        std::map<std::string, std::string> config = { };
+        std::map<std::string, std::string> config = extraConfig;
         bool isPossibleDynBatch = deviceName.find("CPU") != std::string::npos ||
                                   deviceName.find("GPU") != std::string::npos;
 
@@ -790,6 +814,16 @@ void Load::into(InferenceEngine::Core & ie, const std::string & deviceName, bool
         }
 
         detector.net = ie.LoadNetwork(detector.read(ie), deviceName, config);
+        const SizeVector& inputDims = detector.net.GetInputsInfo().begin()->second->getTensorDesc().getDims();
+        detector.inputSize = cv::Size(static_cast<int>(inputDims[3]), static_cast<int>(inputDims[2]));
+
+        // The first request of every set is created and warmed up here, so the first frames don't pay for it
+        std::vector<InferRequest::Ptr> requests;
+        for (auto& requestsSet : detector.requestsSets) {
+            requestsSet.push_back(detector.net.CreateInferRequestPtr());
+            requests.push_back(requestsSet.back());
+        }
+        warmupRequests(requests, detector.net.GetInputsInfo(), 3);
     }
 }
 
@@ -29,7 +29,12 @@
 
 struct BaseDetection {
     InferenceEngine::ExecutableNetwork net;
-    InferenceEngine::InferRequest::Ptr request;
+    InferenceEngine::InferRequest::Ptr request;  // the last used request
+    // Two sets of requests take turns, see switchRequest(). The faces of a frame are split into the requests
+    // of the current set by maxBatch
+    std::vector<std::vector<InferenceEngine::InferRequest::Ptr>> requestsSets;
+    std::vector<size_t> numSubmittedRequests;
+    size_t setId;
     std::string topoName;
     std::string pathToModel;
     std::string deviceForInference;
@@ -39,6 +44,7 @@ struct BaseDetection {
     mutable bool enablingChecked;
     mutable bool _enabled;
     const bool doRawOutputMessages;
+    cv::Size inputSize;  // the size of the image input, it's known after the network is loaded
 
     BaseDetection(const std::string &topoName,
                   const std::string &pathToModel,
@@ -52,10 +58,45 @@ struct BaseDetection {
     virtual InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) = 0;
     virtual void submitRequest();
     virtual void wait();
+    // Switches to the other set of requests, the requests of the current set keep running meanwhile
+    void switchRequest();
+    // Returns the request to enqueue the face to. The previous request is started if it is full
+    InferenceEngine::InferRequest::Ptr requestForFace(size_t faceId);
+    // Starts the request holding the last of the enqueued faces
+    void submitFaces(size_t numFaces);
+    // Returns the request holding the results for the face, faceId % maxBatch is the index in its batch
+    const InferenceEngine::InferRequest::Ptr& resultRequest(size_t faceId) const;
     bool enabled() const;
     void printPerformanceCounts(std::string fullDeviceName);
 };
 
+// Prepares the images of a face for the inputs of the face analytics networks. The face is shrunk to the largest
+// of the inputs first if it's bigger, and the smaller inputs are resized from that image, so the frame is read
+// once per face. Every input size is resized once however many networks share it, and an input matching
+// the face takes the face as is. The buffers are reused for the next faces
+class FaceInputs {
+public:
+    void addInputSize(const cv::Size& size);
+    // Starts the next face, face is a view into the frame, which has to stay valid until the next face
+    void setFace(const cv::Mat& face);
+    // Returns the face resized to size, the image is valid until the next face
+    const cv::Mat& resized(const cv::Size& size);
+
+private:
+    struct Input {
+        cv::Size size;
+        cv::Mat image;
+        bool isReady;
+    };
+
+    const cv::Mat& source(const cv::Size& size);
+
+    std::vector<Input> inputs;
+    cv::Size baseSize;  // bounds all the inputs
+    cv::Mat face, base;
+    bool isBaseReady = false;
+};
+
 struct FaceDetection : BaseDetection {
     struct Result {
         int label;
@@ -113,7 +154,7 @@ struct AgeGenderDetection : BaseDetection {
     InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) override;
     void submitRequest() override;
 
-    void enqueue(const cv::Mat &face);
+    void enqueue(FaceInputs &face);
     Result operator[] (int idx) const;
 };
 
@@ -139,7 +180,7 @@ struct HeadPoseDetection : BaseDetection {
     InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) override;
     void submitRequest() override;
 
-    void enqueue(const cv::Mat &face);
+    void enqueue(FaceInputs &face);
     Results operator[] (int idx) const;
 };
 
@@ -156,7 +197,7 @@ struct EmotionsDetection : BaseDetection {
     InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) override;
     void submitRequest() override;
 
-    void enqueue(const cv::Mat &face);
+    void enqueue(FaceInputs &face);
     std::map<std::string, float> operator[] (int idx) const;
 
     const std::vector<std::string> emotionsVec = {"neutral", "happy", "sad", "surprise", "anger"};
@@ -177,7 +218,7 @@ struct FacialLandmarksDetection : BaseDetection {
     InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) override;
     void submitRequest() override;
 
-    void enqueue(const cv::Mat &face);
+    void enqueue(FaceInputs &face);
     std::vector<float> operator[] (int idx) const;
 };
 
@@ -194,7 +235,7 @@ struct AntispoofingClassifier : BaseDetection {
     InferenceEngine::CNNNetwork read(const InferenceEngine::Core& ie) override;
     void submitRequest() override;
 
-    void enqueue(const cv::Mat& frame);
+    void enqueue(FaceInputs& face);
     float operator[] (int idx) const;
 };
 
@@ -203,7 +244,8 @@ struct Load {
 
     explicit Load(BaseDetection& detector);
 
-    void into(InferenceEngine::Core & ie, const std::string & deviceName, bool enable_dynamic_batch = false) const;
+    void into(InferenceEngine::Core & ie, const std::string & deviceName, bool enable_dynamic_batch = false,
+              const std::map<std::string, std::string>& extraConfig = {}) const;
 };
 
 class CallStat {
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <algorithm>
 #include <string>
 #include <map>
 #include <utility>
@@ -10,6 +11,23 @@
 
 #include "face.hpp"
 
+AttributeRefresh::AttributeRefresh(size_t interval) :
+    interval(std::max<size_t>(interval, 1)), framesLeft(0), isConfident(false) {
+}
+
+bool AttributeRefresh::isDue() {
+    if (framesLeft == 0 || !isConfident) {
+        framesLeft = interval - 1;
+        return true;
+    }
+    --framesLeft;
+    return false;
+}
+
+void AttributeRefresh::update(bool isConfident) {
+    this->isConfident = isConfident;
+}
+
 Face::Face(size_t id, cv::Rect& location):
     _location(location), _intensity_mean(0.f), _id(id), _age(-1),
     _maleScore(0), _femaleScore(0), _headPose({0.f, 0.f, 0.f}), _realFaceConfidence(0),
@@ -15,6 +15,22 @@
 
 // -------------------------Describe detected face on a frame-------------------------------------------------
 
+// Tells when an attribute network has to be inferred for a tracked face: for a new face, once per interval frames,
+// and every frame while the last result isn't confident. The face keeps its last results in the other frames
+class AttributeRefresh {
+public:
+    explicit AttributeRefresh(size_t interval = 1);
+
+    // Called once per frame of the face
+    bool isDue();
+    void update(bool isConfident);
+
+private:
+    size_t interval;
+    size_t framesLeft;
+    bool isConfident;
+};
+
 struct Face {
 public:
     using Ptr = std::shared_ptr<Face>;
@@ -52,6 +68,9 @@ public:
 public:
     cv::Rect _location;
     float _intensity_mean;
+    AttributeRefresh _ageGenderRefresh;
+    AttributeRefresh _emotionsRefresh;
+    AttributeRefresh _antispoofingRefresh;
 
 private:
     size_t _id;
@@ -40,15 +40,15 @@ static const char target_device_message_lm[] = "Optional. Target device for Faci
 static const char target_device_message_am[] = "Optional. Target device for Antispoofing Classification network (the list of available devices is shown below). "
                                                "Default value is CPU. Use \"-d HETERO:<comma-separated_devices_list>\" format to specify HETERO plugin. "
                                                "The demo will look for a suitable plugin for a specified device.";
-static const char num_batch_ag_message[] = "Optional. Number of maximum simultaneously processed faces for Age/Gender Recognition network "
+static const char num_batch_ag_message[] = "Optional. Batch size for Age/Gender Recognition network, more faces are split into several infer requests "
                                            "(by default, it is 16)";
-static const char num_batch_hp_message[] = "Optional. Number of maximum simultaneously processed faces for Head Pose Estimation network "
+static const char num_batch_hp_message[] = "Optional. Batch size for Head Pose Estimation network, more faces are split into several infer requests "
                                            "(by default, it is 16)";
-static const char num_batch_em_message[] = "Optional. Number of maximum simultaneously processed faces for Emotions Recognition network "
+static const char num_batch_em_message[] = "Optional. Batch size for Emotions Recognition network, more faces are split into several infer requests "
                                            "(by default, it is 16)";
-static const char num_batch_lm_message[] = "Optional. Number of maximum simultaneously processed faces for Facial Landmarks Estimation network "
+static const char num_batch_lm_message[] = "Optional. Batch size for Facial Landmarks Estimation network, more faces are split into several infer requests "
                                            "(by default, it is 16)";
-static const char num_batch_am_message[] = "Optional. Number of maximum simultaneously processed faces for Antispoofing Classification network "
+static const char num_batch_am_message[] = "Optional. Batch size for Antispoofing Classification network, more faces are split into several infer requests "
                                            "(by default, it is 16)";
 static const char dyn_batch_ag_message[] = "Optional. Enable dynamic batch size for Age/Gender Recognition network";
 static const char dyn_batch_hp_message[] = "Optional. Enable dynamic batch size for Head Pose Estimation network";
@@ -69,11 +69,24 @@ static const char dx_coef_output_message[] = "Optional. Coefficient to shift the
 static const char dy_coef_output_message[] = "Optional. Coefficient to shift the bounding box around the detected face along the Oy axis";
 static const char fps_output_message[] = "Optional. Maximum FPS for playing video";
 static const char no_smooth_output_message[] = "Optional. Do not smooth person attributes";
+static const char refresh_ag_message[] = "Optional. Infer Age/Gender Recognition network for a tracked face once per this "
+                                        "number of frames, the face keeps its last results in between. Uncertain "
+                                        "results are inferred every frame. Requires smoothing (by default, it is 1)";
+static const char refresh_em_message[] = "Optional. Infer Emotions Recognition network for a tracked face once per this "
+                                        "number of frames, the face keeps its last results in between. Uncertain "
+                                        "results are inferred every frame. Requires smoothing (by default, it is 1)";
+static const char refresh_am_message[] = "Optional. Infer Antispoofing Classification network for a tracked face once per "
+                                        "this number of frames, the face keeps its last results in between. Uncertain "
+                                        "results are inferred every frame. Requires smoothing (by default, it is 1)";
 static const char no_show_emotion_bar_message[] = "Optional. Do not show emotion bar";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
+static const char nthreads_app_message[] = "Optional. If not 0, CPU threads of the networks running on CPU are split "
+                                           "between them according to their load, except for this number of threads "
+                                           "left for OpenCV processing.";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(o, "", output_video_message);
+DEFINE_VIDEO_ENCODE_FLAG
 DEFINE_string(m, "", face_detection_model_message);
 DEFINE_string(m_ag, "", age_gender_model_message);
 DEFINE_string(m_hp, "", head_pose_model_message);
@@ -108,8 +121,12 @@ DEFINE_double(dx_coef, 1, dx_coef_output_message);
 DEFINE_double(dy_coef, 1, dy_coef_output_message);
 DEFINE_double(fps, -std::numeric_limits<double>::infinity(), fps_output_message);
 DEFINE_bool(no_smooth, false, no_smooth_output_message);
+DEFINE_uint32(refresh_ag, 1, refresh_ag_message);
+DEFINE_uint32(refresh_em, 1, refresh_em_message);
+DEFINE_uint32(refresh_am, 1, refresh_am_message);
 DEFINE_bool(no_show_emotion_bar, false, no_show_emotion_bar_message);
 DEFINE_string(u, "", utilization_monitors_message);
+DEFINE_uint32(nthreads_app, 0, nthreads_app_message);
 
 
 /**
@@ -125,6 +142,7 @@ static void showUsage() {
     std::cout << "    -i                         " << input_message << std::endl;
     std::cout << "    -loop                      " << loop_message << std::endl;
     std::cout << "    -o \"<path>\"                " << output_video_message << std::endl;
+    std::cout << "    -encode \"<mode>\"           " << encode_message << std::endl;
     std::cout << "    -m \"<path>\"                " << face_detection_model_message << std::endl;
     std::cout << "    -m_ag \"<path>\"             " << age_gender_model_message << std::endl;
     std::cout << "    -m_hp \"<path>\"             " << head_pose_model_message << std::endl;
@@ -160,6 +178,10 @@ static void showUsage() {
     std::cout << "    -dy_coef                   " << dy_coef_output_message << std::endl;
     std::cout << "    -fps                       " << fps_output_message << std::endl;
     std::cout << "    -no_smooth                 " << no_smooth_output_message << std::endl;
+    std::cout << "    -refresh_ag \"<num>\"         " << refresh_ag_message << std::endl;
+    std::cout << "    -refresh_em \"<num>\"         " << refresh_em_message << std::endl;
+    std::cout << "    -refresh_am \"<num>\"         " << refresh_am_message << std::endl;
     std::cout << "    -no_show_emotion_bar       " << no_show_emotion_bar_message << std::endl;
     std::cout << "    -u                         " << utilization_monitors_message << std::endl;
+    std::cout << "    -nthreads_app \"<integer>\"    " << nthreads_app_message << std::endl;
 }
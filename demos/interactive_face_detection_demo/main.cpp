@@ -26,9 +26,13 @@
 
 #include <monitors/presenter.h>
 #include <samples/images_capture.h>
+#include <samples/model_loader.hpp>
 #include <samples/ocv_common.hpp>
 #include <samples/slog.hpp>
+#include <samples/thread_budget.hpp>
+#include <samples/video_writer.h>
 
+#include "pipelines/config_factory.h"
 #include "interactive_face_detection.hpp"
 #include "detectors.hpp"
 #include "face.hpp"
@@ -62,9 +66,23 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     if (FLAGS_n_hp < 1) {
         throw std::logic_error("Parameter -n_hp cannot be 0");
     }
+
+    if (FLAGS_refresh_ag < 1 || FLAGS_refresh_em < 1 || FLAGS_refresh_am < 1) {
+        throw std::logic_error("Parameters -refresh_ag, -refresh_em and -refresh_am cannot be 0");
+    }
     return true;
 }
 
+// A face of a frame and the indices of its results for the attribute networks, -1 if the face keeps the results
+// of its previous frames. Head pose and landmarks are inferred for every face, their index is the index of the face
+struct FrameFace {
+    Face::Ptr face;
+    cv::Rect location;
+    int ageGenderIdx;
+    int emotionsIdx;
+    int antispoofingIdx;
+};
+
 int main(int argc, char *argv[]) {
     try {
         std::cout << "InferenceEngine: " << printable(*GetInferenceEngineVersion()) << std::endl;
@@ -133,23 +151,69 @@ int main(int argc, char *argv[]) {
         // ---------------------------------------------------------------------------------------------------
 
         // --------------------------- 2. Reading IR models and loading them to plugins ----------------------
+        // Networks running on CPU get their shares of CPU threads, so they don't oversubscribe the cores
+        std::map<const BaseDetection*, std::map<std::string, std::string>> cpuConfigs;
+        if (FLAGS_nthreads_app != 0) {
+            std::vector<const BaseDetection*> cpuDetectors;
+            std::vector<float> loads;
+            auto addCpuDetector = [&](const BaseDetection& detector, const std::string& deviceName, float load) {
+                if (detector.enabled() && deviceName == "CPU") {
+                    cpuDetectors.push_back(&detector);
+                    loads.push_back(load);
+                }
+            };
+            // The face detector processes whole frames, the others process small images of the faces
+            addCpuDetector(faceDetector, FLAGS_d, 2.0f);
+            addCpuDetector(ageGenderDetector, FLAGS_d_ag, 1.0f);
+            addCpuDetector(headPoseDetector, FLAGS_d_hp, 1.0f);
+            addCpuDetector(emotionsDetector, FLAGS_d_em, 1.0f);
+            addCpuDetector(facialLandmarksDetector, FLAGS_d_lm, 1.0f);
+            addCpuDetector(antispoofingClassifier, FLAGS_d_am, 1.0f);
+            auto configs = ConfigFactory::planCpuNetworks(loads, FLAGS_nthreads_app);
+            for (size_t i = 0; i < cpuDetectors.size(); i++) {
+                cpuConfigs[cpuDetectors[i]] = configs[i];
+                ThreadBudget::global().addCpuNetwork(configs[i]);
+            }
+            ThreadBudget::global().applyToOpenCV();
+        }
+        auto cpuConfig = [&](const BaseDetection& detector) {
+            auto it = cpuConfigs.find(&detector);
+            return it != cpuConfigs.end() ? it->second : std::map<std::string, std::string>{};
+        };
+
+        // The networks are read and loaded concurrently
+        ModelLoader modelLoader;
         // Disable dynamic batching for face detector as it processes one image at a time
-        Load(faceDetector).into(ie, FLAGS_d, false);
-        Load(ageGenderDetector).into(ie, FLAGS_d_ag, FLAGS_dyn_ag);
-        Load(headPoseDetector).into(ie, FLAGS_d_hp, FLAGS_dyn_hp);
-        Load(emotionsDetector).into(ie, FLAGS_d_em, FLAGS_dyn_em);
-        Load(facialLandmarksDetector).into(ie, FLAGS_d_lm, FLAGS_dyn_lm);
-        Load(antispoofingClassifier).into(ie, FLAGS_d_am, FLAGS_dyn_am);
+        modelLoader.add([&]() { Load(faceDetector).into(ie, FLAGS_d, false, cpuConfig(faceDetector)); });
+        modelLoader.add([&]() { Load(ageGenderDetector).into(ie, FLAGS_d_ag, FLAGS_dyn_ag, cpuConfig(ageGenderDetector)); });
+        modelLoader.add([&]() { Load(headPoseDetector).into(ie, FLAGS_d_hp, FLAGS_dyn_hp, cpuConfig(headPoseDetector)); });
+        modelLoader.add([&]() { Load(emotionsDetector).into(ie, FLAGS_d_em, FLAGS_dyn_em, cpuConfig(emotionsDetector)); });
+        modelLoader.add([&]() {
+            Load(facialLandmarksDetector).into(ie, FLAGS_d_lm, FLAGS_dyn_lm, cpuConfig(facialLandmarksDetector));
+        });
+        modelLoader.add([&]() {
+            Load(antispoofingClassifier).into(ie, FLAGS_d_am, FLAGS_dyn_am, cpuConfig(antispoofingClassifier));
+        });
+        modelLoader.wait();
         // ----------------------------------------------------------------------------------------------------
 
         bool isFaceAnalyticsEnabled = ageGenderDetector.enabled() || headPoseDetector.enabled() ||
                                       emotionsDetector.enabled() || facialLandmarksDetector.enabled() || antispoofingClassifier.enabled();
+        // Every face is resized once for all the face analytics networks
+        FaceInputs faceInputs;
+        for (const BaseDetection* detector : std::initializer_list<const BaseDetection*>{&ageGenderDetector,
+                &headPoseDetector, &emotionsDetector, &facialLandmarksDetector, &antispoofingClassifier}) {
+            if (detector->enabled()) {
+                faceInputs.addInputSize(detector->inputSize);
+            }
+        }
 
         Timer timer;
         std::ostringstream out;
         size_t framesCounter = 0;
         double msrate = 1000.0 / FLAGS_fps;
-        std::list<Face::Ptr> faces;
+        std::list<Face::Ptr> faces;  // the faces of the shown frame
+        std::list<Face::Ptr> tracks;  // the faces of the last frame enqueued to the face analytics networks
         size_t id = 0;
 
         std::unique_ptr<ImagesCapture> cap = openImagesCapture(FLAGS_i, FLAGS_loop);
@@ -166,13 +230,11 @@ int main(int argc, char *argv[]) {
                 visualizer.enableEmotionBar(emotionsDetector.emotionsVec);
         }
 
-        cv::VideoWriter videoWriter;
+        std::unique_ptr<AsyncVideoWriter> videoWriter;
         if (!FLAGS_o.empty()) {
-            videoWriter.open(FLAGS_o, cv::VideoWriter::fourcc('I', 'Y', 'U', 'V'),
-                !FLAGS_no_show && FLAGS_fps > 0.0 ? FLAGS_fps : cap->fps(), frame.size());
-            if (!videoWriter.isOpened()) {
-                throw std::runtime_error("Can't open video writer");
-            }
+            videoWriter.reset(new AsyncVideoWriter(FLAGS_o, cv::VideoWriter::fourcc('I', 'Y', 'U', 'V'),
+                !FLAGS_no_show && FLAGS_fps > 0.0 ? FLAGS_fps : cap->fps(), frame.size(),
+                parseVideoEncodeMode(FLAGS_encode)));
         }
 
         // Detecting all faces on the first frame and reading the next one
@@ -187,71 +249,39 @@ int main(int argc, char *argv[]) {
         }
         std::cout << std::endl;
 
-        while (frame.data) {
-            timer.start("total");
-            cv::Mat prev_frame = std::move(frame);
-            frame = std::move(next_frame);
-            framesCounter++;
-
-            // Retrieving face detection results for the previous frame
-            faceDetector.wait();
-            faceDetector.fetchResults();
-            auto prev_detection_results = faceDetector.results;
-
-            // No valid frame to infer if previous frame is the last
-            if (frame.data) {
-                if (frame.size() != prev_frame.size()) {
-                    throw std::runtime_error("Images of different size are not supported");
-                }
-                faceDetector.enqueue(frame);
-                faceDetector.submitRequest();
-            }
-
-            // Filling inputs of face analytics networks
-            for (auto &&face : prev_detection_results) {
-                if (isFaceAnalyticsEnabled) {
-                    cv::Rect clippedRect = face.location & cv::Rect({0, 0}, prev_frame.size());
-                    cv::Mat face = prev_frame(clippedRect);
-                    ageGenderDetector.enqueue(face);
-                    headPoseDetector.enqueue(face);
-                    emotionsDetector.enqueue(face);
-                    facialLandmarksDetector.enqueue(face);
-                    antispoofingClassifier.enqueue(face);
-                }
-            }
-
-            // Running Age/Gender Recognition, Head Pose Estimation, Emotions Recognition, Facial Landmarks Estimation and Antispoofing Classifier networks simultaneously
-            if (isFaceAnalyticsEnabled) {
-                ageGenderDetector.submitRequest();
-                headPoseDetector.submitRequest();
-                emotionsDetector.submitRequest();
-                facialLandmarksDetector.submitRequest();
-                antispoofingClassifier.submitRequest();
-            }
-
-            // Read the next frame while waiting for inference results
-            next_frame = cap->read();
-
-            if (isFaceAnalyticsEnabled) {
-                ageGenderDetector.wait();
-                headPoseDetector.wait();
-                emotionsDetector.wait();
-                facialLandmarksDetector.wait();
-                antispoofingClassifier.wait();
+        // The face analytics networks have two requests each. A frame is enqueued to one of them while the previous
+        // frame is inferred by the other one and then postprocessed
+        cv::Mat pending_frame;
+        std::vector<FrameFace> pending_faces;
+        auto switchRequests = [&]() {
+            for (BaseDetection* detector : std::initializer_list<BaseDetection*>{&ageGenderDetector, &headPoseDetector,
+                    &emotionsDetector, &facialLandmarksDetector, &antispoofingClassifier}) {
+                detector->switchRequest();
+                detector->wait();
             }
+        };
 
-            //  Postprocessing
+        // Matches the detected faces to the tracked ones and enqueues them to the face analytics networks. The faces
+        // are tracked in the order of the frames, so a frame is tracked before the previous one is shown
+        auto track = [&](const cv::Mat& prev_frame, const std::vector<FaceDetection::Result>& prev_detection_results) {
             std::list<Face::Ptr> prev_faces;
 
             if (!FLAGS_no_smooth) {
-                prev_faces.insert(prev_faces.begin(), faces.begin(), faces.end());
+                prev_faces.insert(prev_faces.begin(), tracks.begin(), tracks.end());
             }
 
-            faces.clear();
+            tracks.clear();
 
-            // For every detected face
-            for (size_t i = 0; i < prev_detection_results.size(); i++) {
-                auto& result = prev_detection_results[i];
+            auto newFace = [&](cv::Rect& rect) {
+                Face::Ptr face = std::make_shared<Face>(id++, rect);
+                face->_ageGenderRefresh = AttributeRefresh(FLAGS_refresh_ag);
+                face->_emotionsRefresh = AttributeRefresh(FLAGS_refresh_em);
+                face->_antispoofingRefresh = AttributeRefresh(FLAGS_refresh_am);
+                return face;
+            };
+
+            std::vector<FrameFace> frameFaces;
+            for (auto& result : prev_detection_results) {
                 cv::Rect rect = result.location & cv::Rect({0, 0}, prev_frame.size());
 
                 Face::Ptr face;
@@ -261,7 +291,7 @@ int main(int argc, char *argv[]) {
 
                     if ((face == nullptr) ||
                         ((std::abs(intensity_mean - face->_intensity_mean) / face->_intensity_mean) > 0.07f)) {
-                        face = std::make_shared<Face>(id++, rect);
+                        face = newFace(rect);
                     } else {
                         prev_faces.remove(face);
                     }
@@ -269,42 +299,84 @@ int main(int argc, char *argv[]) {
                     face->_intensity_mean = intensity_mean;
                     face->_location = rect;
                 } else {
-                    face = std::make_shared<Face>(id++, rect);
+                    face = newFace(rect);
+                }
+                tracks.push_back(face);
+
+                FrameFace frameFace{face, rect, -1, -1, -1};
+                if (isFaceAnalyticsEnabled) {
+                    faceInputs.setFace(prev_frame(rect));
+                    if (ageGenderDetector.enabled() && face->_ageGenderRefresh.isDue()) {
+                        frameFace.ageGenderIdx = static_cast<int>(ageGenderDetector.enquedFaces);
+                        ageGenderDetector.enqueue(faceInputs);
+                    }
+                    headPoseDetector.enqueue(faceInputs);
+                    if (emotionsDetector.enabled() && face->_emotionsRefresh.isDue()) {
+                        frameFace.emotionsIdx = static_cast<int>(emotionsDetector.enquedFaces);
+                        emotionsDetector.enqueue(faceInputs);
+                    }
+                    facialLandmarksDetector.enqueue(faceInputs);
+                    if (antispoofingClassifier.enabled() && face->_antispoofingRefresh.isDue()) {
+                        frameFace.antispoofingIdx = static_cast<int>(antispoofingClassifier.enquedFaces);
+                        antispoofingClassifier.enqueue(faceInputs);
+                    }
                 }
+                frameFaces.push_back(frameFace);
+            }
+            return frameFaces;
+        };
+
+        // Reads the face analytics results of the current requests, draws and shows the frame, returns false to quit
+        auto postprocess = [&](cv::Mat& prev_frame, const std::vector<FrameFace>& prev_faces) {
+            //  Postprocessing
+            faces.clear();
 
-                face->ageGenderEnable((ageGenderDetector.enabled() &&
-                                       i < ageGenderDetector.maxBatch));
-                if (face->isAgeGenderEnabled()) {
-                    AgeGenderDetection::Result ageGenderResult = ageGenderDetector[i];
+            // For every detected face
+            for (size_t i = 0; i < prev_faces.size(); i++) {
+                const FrameFace& frameFace = prev_faces[i];
+                const Face::Ptr& face = frameFace.face;
+
+                // A result close to the decision boundary isn't reused, the attribute is inferred again next frame
+                face->ageGenderEnable(ageGenderDetector.enabled());
+                if (face->isAgeGenderEnabled() && frameFace.ageGenderIdx >= 0) {
+                    AgeGenderDetection::Result ageGenderResult = ageGenderDetector[frameFace.ageGenderIdx];
                     face->updateGender(ageGenderResult.maleProb);
                     face->updateAge(ageGenderResult.age);
+                    face->_ageGenderRefresh.update(std::abs(ageGenderResult.maleProb - 0.5f) > 0.25f);
                 }
 
-                face->emotionsEnable((emotionsDetector.enabled() &&
-                                      i < emotionsDetector.maxBatch));
-                if (face->isEmotionsEnabled()) {
-                    face->updateEmotions(emotionsDetector[i]);
+                face->emotionsEnable(emotionsDetector.enabled());
+                if (face->isEmotionsEnabled() && frameFace.emotionsIdx >= 0) {
+                    std::map<std::string, float> emotions = emotionsDetector[frameFace.emotionsIdx];
+                    float maxProb = 0.0f;
+                    for (const auto& emotion : emotions) {
+                        maxProb = std::max(maxProb, emotion.second);
+                    }
+                    face->updateEmotions(std::move(emotions));
+                    face->_emotionsRefresh.update(maxProb > 0.5f);
                 }
 
-                face->headPoseEnable((headPoseDetector.enabled() &&
-                                      i < headPoseDetector.maxBatch));
+                face->headPoseEnable(headPoseDetector.enabled());
                 if (face->isHeadPoseEnabled()) {
                     face->updateHeadPose(headPoseDetector[i]);
                 }
 
-                face->landmarksEnable((facialLandmarksDetector.enabled() &&
-                                       i < facialLandmarksDetector.maxBatch));
+                face->landmarksEnable(facialLandmarksDetector.enabled());
                 if (face->isLandmarksEnabled()) {
                     face->updateLandmarks(facialLandmarksDetector[i]);
                 }
 
-                face->antispoofingEnable((antispoofingClassifier.enabled() &&
-                    i < antispoofingClassifier.maxBatch));
-                if (face->isAntispoofingEnabled()) {
-                    face->updateRealFaceConfidence(antispoofingClassifier[i]);
+                face->antispoofingEnable(antispoofingClassifier.enabled());
+                if (face->isAntispoofingEnabled() && frameFace.antispoofingIdx >= 0) {
+                    float realFaceConfidence = antispoofingClassifier[frameFace.antispoofingIdx];
+                    face->updateRealFaceConfidence(realFaceConfidence);
+                    face->_antispoofingRefresh.update(std::abs(realFaceConfidence - 50.f) > 25.f);
                 }
 
-                faces.push_back(face);
+                // The face may be tracked in the next frame already, it's drawn as of this frame
+                Face::Ptr shownFace = std::make_shared<Face>(*face);
+                shownFace->_location = frameFace.location;
+                faces.push_back(shownFace);
             }
 
             presenter.drawGraphs(prev_frame);
@@ -319,8 +391,8 @@ int main(int argc, char *argv[]) {
             cv::putText(prev_frame, out.str(), THROUGHPUT_METRIC_POSITION, cv::FONT_HERSHEY_TRIPLEX, 1,
                         cv::Scalar(255, 0, 0), 2);
 
-            if (videoWriter.isOpened()) {
-                videoWriter.write(prev_frame);
+            if (videoWriter) {
+                videoWriter->write(prev_frame);
             }
 
             int delay = std::max(1, static_cast<int>(msrate - timer["total"].getLastCallDuration()));
@@ -328,13 +400,78 @@ int main(int argc, char *argv[]) {
                 cv::imshow("Detection results", prev_frame);
                 int key = cv::waitKey(delay);
                 if (27 == key || 'Q' == key || 'q' == key) {
-                    break;
+                    return false;
                 }
                 presenter.handleKey(key);
             }
+            return true;
+        };
+
+        while (frame.data) {
+            timer.start("total");
+            cv::Mat prev_frame = std::move(frame);
+            frame = std::move(next_frame);
+            framesCounter++;
+
+            // Retrieving face detection results for the previous frame
+            faceDetector.wait();
+            faceDetector.fetchResults();
+            auto prev_detection_results = faceDetector.results;
+
+            // No valid frame to infer if previous frame is the last
+            if (frame.data) {
+                if (frame.size() != prev_frame.size()) {
+                    throw std::runtime_error("Images of different size are not supported");
+                }
+                faceDetector.enqueue(frame);
+                faceDetector.submitRequest();
+            }
+
+            // Tracking the faces and filling inputs of face analytics networks
+            std::vector<FrameFace> prev_faces = track(prev_frame, prev_detection_results);
+
+            // Running Age/Gender Recognition, Head Pose Estimation, Emotions Recognition, Facial Landmarks Estimation and Antispoofing Classifier networks simultaneously
+            if (isFaceAnalyticsEnabled) {
+                ageGenderDetector.submitRequest();
+                headPoseDetector.submitRequest();
+                emotionsDetector.submitRequest();
+                facialLandmarksDetector.submitRequest();
+                antispoofingClassifier.submitRequest();
+            }
+
+            // Read the next frame while waiting for inference results
+            next_frame = cap->read();
+
+            if (!isFaceAnalyticsEnabled) {
+                if (!postprocess(prev_frame, prev_faces)) {
+                    break;
+                }
+                continue;
+            }
+
+            // The face analytics of prev_frame run while the frame submitted to them before is shown
+            switchRequests();
+            if (pending_frame.data && !postprocess(pending_frame, pending_faces)) {
+                pending_frame.release();
+                break;
+            }
+            pending_frame = std::move(prev_frame);
+            pending_faces = std::move(prev_faces);
+        }
+        // Showing the last frame of the analytics pipeline
+        if (pending_frame.data) {
+            timer.start("total");
+            switchRequests();
+            postprocess(pending_frame, pending_faces);
         }
 
         slog::info << "Number of processed frames: " << framesCounter << slog::endl;
+        if (videoWriter) {
+            videoWriter->close();
+            if (videoWriter->getDroppedCount() > 0) {
+                slog::info << "Frames dropped by the video writer: " << videoWriter->getDroppedCount() << slog::endl;
+            }
+        }
         slog::info << "Total image throughput: " << framesCounter * (1000.0 / timer["total"].getTotalDuration()) << " fps" << slog::endl;
 
         // Showing performance results
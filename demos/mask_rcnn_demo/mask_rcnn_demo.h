@@ -21,6 +21,8 @@ static const char custom_cpu_library_message[] = "Required for CPU custom layers
                                                  "Absolute path to a shared library with the kernels implementations.";
 static const char detection_output_layer_name_message[] = "Optional. The name of detection output layer. Default value is \"reshape_do_2d\"";
 static const char masks_layer_name_message[] = "Optional. The name of masks layer. Default value is \"masks\"";
+static const char num_inf_req_message[] = "Optional. Number of infer requests. Several images are inferred at once "
+                                          "if it's greater than 1. Default value is 2.";
 
 DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
@@ -30,6 +32,7 @@ DEFINE_string(m, "", model_message);
 DEFINE_string(d, "CPU", target_device_message);
 DEFINE_string(detection_output_name, "reshape_do_2d", detection_output_layer_name_message);
 DEFINE_string(masks_name, "masks", masks_layer_name_message);
+DEFINE_uint32(nireq, 2, num_inf_req_message);
 
 /**
 * @brief This function show a help message
@@ -48,4 +51,5 @@ static void showUsage() {
     std::cout << "    -d \"<device>\"                     " << target_device_message << std::endl;
     std::cout << "    -detection_output_name \"<string>\" " << detection_output_layer_name_message << std::endl;
     std::cout << "    -masks_name \"<string>\"            " << masks_layer_name_message << std::endl;
+    std::cout << "    -nireq \"<integer>\"                " << num_inf_req_message << std::endl;
 }
@@ -0,0 +1,427 @@
+/*
+// Copyright (C) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/**
+* \brief The entry point for the demos_microbench application, measuring CPU kernels of demo postprocessing
+* \file microbench/main.cpp
+* \example microbench/main.cpp
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <opencv2/core.hpp>
+
+#include <samples/args_helper.hpp>
+#include <samples/common.hpp>
+#include <samples/heatmap_peaks.hpp>
+#include <samples/latency_histogram.hpp>
+#include <samples/ocv_common.hpp>
+#include <samples/slog.hpp>
+#include <tracker_core/kuhn_munkres.h>
+
+#include "models/nms.h"
+
+static const char help_message[] = "Print a usage message.";
+static const char kernels_message[] = "Optional. Comma separated kernels to measure: heatmap_peaks, nms, "
+"kuhn_munkres, mat_to_blob. All of them are measured by default.";
+static const char people_message[] = "Optional. Comma separated numbers of people on synthetic heatmaps.";
+static const char heatmap_size_message[] = "Optional. Size of heatmaps in <width>x<height> format.";
+static const char boxes_message[] = "Optional. Comma separated numbers of synthetic boxes to suppress.";
+static const char tracks_message[] = "Optional. Comma separated sizes of square synthetic cost matrices "
+"to assign.";
+static const char frame_sizes_message[] = "Optional. Comma separated sizes of synthetic frames put to the blob "
+"in <width>x<height> format.";
+static const char blob_size_message[] = "Optional. Size of the network input blob in <width>x<height> format.";
+static const char fixture_message[] = "Optional. Path to a file of cv::FileStorage with recorded tensors. "
+"Every tensor found in it is measured in addition to the synthetic ones.";
+static const char time_message[] = "Optional. Duration of measurement of every case in seconds.";
+static const char output_message[] = "Optional. Path to the JSON report file. Report is printed to "
+"the standard output if it isn't set.";
+
+DEFINE_bool(h, false, help_message);
+DEFINE_string(kernels, "heatmap_peaks,nms,kuhn_munkres,mat_to_blob", kernels_message);
+DEFINE_string(people, "1,5,20", people_message);
+DEFINE_string(heatmap_size, "228x128", heatmap_size_message);
+DEFINE_string(boxes, "100,1000,10000", boxes_message);
+DEFINE_string(tracks, "10,50,200", tracks_message);
+DEFINE_string(frame_sizes, "640x480,1280x720,1920x1080", frame_sizes_message);
+DEFINE_string(blob_size, "544x320", blob_size_message);
+DEFINE_string(fixture, "", fixture_message);
+DEFINE_double(t, 0.5, time_message);
+DEFINE_string(o, "", output_message);
+
+/**
+* \brief This function shows a help message
+*/
+static void showUsage() {
+    std::cout << std::endl;
+    std::cout << "demos_microbench [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "    -h                          " << help_message << std::endl;
+    std::cout << "    -kernels \"<list>\"           " << kernels_message << std::endl;
+    std::cout << "    -people \"<list>\"            " << people_message << std::endl;
+    std::cout << "    -heatmap_size \"<WxH>\"       " << heatmap_size_message << std::endl;
+    std::cout << "    -boxes \"<list>\"             " << boxes_message << std::endl;
+    std::cout << "    -tracks \"<list>\"            " << tracks_message << std::endl;
+    std::cout << "    -frame_sizes \"<list>\"       " << frame_sizes_message << std::endl;
+    std::cout << "    -blob_size \"<WxH>\"          " << blob_size_message << std::endl;
+    std::cout << "    -fixture \"<path>\"           " << fixture_message << std::endl;
+    std::cout << "    -t \"<seconds>\"              " << time_message << std::endl;
+    std::cout << "    -o \"<path>\"                 " << output_message << std::endl;
+}
+
+bool ParseAndCheckCommandLine(int argc, char *argv[]) {
+    // ---------------------------Parsing and validation of input args--------------------------------------
+    gflags::ParseCommandLineNonHelpFlags(&argc, &argv, true);
+    if (FLAGS_h) {
+        showUsage();
+        return false;
+    }
+    slog::info << "Parsing input parameters" << slog::endl;
+
+    if (FLAGS_t <= 0) {
+        throw std::logic_error("Parameter -t must be positive");
+    }
+
+    return true;
+}
+
+namespace {
+/// Number of heatmaps of the human pose estimation model, one for every keypoint
+const int KEYPOINTS_COUNT = 18;
+/// Kernels are run this many times before measurement, so their buffers are allocated and caches are warm
+const int WARMUP_RUNS = 3;
+const uint64_t MIN_RUNS = 10;
+
+struct CaseResult {
+    std::string kernel;
+    std::string parameter;
+    std::string value;
+    uint64_t runsCount;
+    /// Time of a run in microseconds. Mean is measured over all runs, the rest come from the histogram
+    /// with microsecond resolution
+    double mean, p50, p90, max;
+};
+
+std::vector<uint32_t> parseNumbers(const std::string& list, const char* flagName) {
+    std::vector<uint32_t> numbers;
+    for (const std::string& item : split(list, ',')) {
+        try {
+            numbers.push_back(static_cast<uint32_t>(std::stoul(item)));
+        } catch (const std::logic_error&) {
+            throw std::invalid_argument(std::string("Can't parse the value \"") + item + "\" of -" + flagName);
+        }
+    }
+    if (numbers.empty()) {
+        throw std::invalid_argument(std::string("Parameter -") + flagName + " is empty");
+    }
+    return numbers;
+}
+
+cv::Size parseSize(const std::string& size, const char* flagName) {
+    std::vector<std::string> sides = split(size, 'x');
+    try {
+        if (sides.size() == 2) {
+            return cv::Size(std::stoi(sides[0]), std::stoi(sides[1]));
+        }
+    } catch (const std::logic_error&) {}
+    throw std::invalid_argument(std::string("Can't parse the value \"") + size + "\" of -" + flagName);
+}
+
+std::string sizeToString(const cv::Size& size) {
+    return std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+/// Runs the kernel until -t seconds pass, but at least MIN_RUNS times
+CaseResult measure(const std::string& kernel, const std::string& parameter, const std::string& value,
+                   const std::function<void()>& run) {
+    slog::info << "Running " << kernel << " " << parameter << "=" << value << slog::endl;
+    for (int i = 0; i < WARMUP_RUNS; i++) {
+        run();
+    }
+
+    LatencyHistogram histogram;
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto endTime = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(FLAGS_t));
+    auto runStartTime = startTime;
+    uint64_t runsCount = 0;
+    while (runsCount < MIN_RUNS || runStartTime < endTime) {
+        run();
+        const auto runEndTime = std::chrono::steady_clock::now();
+        histogram.record(runEndTime - runStartTime);
+        runStartTime = runEndTime;
+        ++runsCount;
+    }
+    const double elapsedUs = std::chrono::duration<double, std::micro>(runStartTime - startTime).count();
+    return {kernel, parameter, value, runsCount, elapsedUs / runsCount,
+            histogram.getPercentile(50) * 1000, histogram.getPercentile(90) * 1000, histogram.getMax() * 1000};
+}
+
+/// Heatmaps of randomly placed people, every keypoint is a gaussian blob like the ones the model outputs
+std::vector<cv::Mat> makeHeatMaps(cv::RNG& rng, const cv::Size& size, uint32_t peopleCount) {
+    const float sigma = 3.f;
+    const int radius = static_cast<int>(3 * sigma);
+    std::vector<cv::Mat> heatMaps;
+    for (int k = 0; k < KEYPOINTS_COUNT; k++) {
+        cv::Mat heatMap(size, CV_32FC1, cv::Scalar(0));
+        for (uint32_t p = 0; p < peopleCount; p++) {
+            const cv::Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+            const float peak = rng.uniform(0.3f, 1.f);
+            for (int y = std::max(center.y - radius, 0); y <= std::min(center.y + radius, size.height - 1); y++) {
+                float* row = heatMap.ptr<float>(y);
+                for (int x = std::max(center.x - radius, 0); x <= std::min(center.x + radius, size.width - 1); x++) {
+                    const float distance2 = static_cast<float>((x - center.x) * (x - center.x)
+                        + (y - center.y) * (y - center.y));
+                    row[x] = std::max(row[x], peak * std::exp(-distance2 / (2 * sigma * sigma)));
+                }
+            }
+        }
+        heatMaps.push_back(heatMap);
+    }
+    return heatMaps;
+}
+
+/// The peak search of the pose estimation demos: peaks of every heatmap are found and the close ones are suppressed
+std::function<void()> heatMapPeaksKernel(const std::vector<cv::Mat>& heatMaps) {
+    auto peaks = std::make_shared<std::vector<cv::Point>>();
+    auto points = std::make_shared<std::vector<cv::Point2f>>();
+    return [heatMaps, peaks, points]() {
+        for (const cv::Mat& heatMap : heatMaps) {
+            peaks->clear();
+            findHeatMapPeaks(heatMap, 0.1f, *peaks);
+            points->assign(peaks->begin(), peaks->end());
+            suppressClosePoints(*points, 6.f);
+        }
+    };
+}
+
+/// Boxes in x1, y1, x2, y2, score rows. Detection models output several overlapping boxes for every object,
+/// so the boxes are jittered copies of the boxes of objects
+cv::Mat makeBoxes(cv::RNG& rng, uint32_t boxesCount) {
+    const int boxesPerObject = 5;
+    cv::Mat boxes(static_cast<int>(boxesCount), 5, CV_32FC1);
+    cv::Rect2f object;
+    for (int i = 0; i < boxes.rows; i++) {
+        if (i % boxesPerObject == 0) {
+            object.width = rng.uniform(20.f, 200.f);
+            object.height = rng.uniform(20.f, 200.f);
+            object.x = rng.uniform(0.f, 1280.f - object.width);
+            object.y = rng.uniform(0.f, 720.f - object.height);
+        }
+        float* box = boxes.ptr<float>(i);
+        box[0] = object.x + rng.uniform(-0.1f, 0.1f) * object.width;
+        box[1] = object.y + rng.uniform(-0.1f, 0.1f) * object.height;
+        box[2] = box[0] + object.width * rng.uniform(0.9f, 1.1f);
+        box[3] = box[1] + object.height * rng.uniform(0.9f, 1.1f);
+        box[4] = rng.uniform(0.f, 1.f);
+    }
+    return boxes;
+}
+
+std::function<void()> nmsKernel(const cv::Mat& boxes) {
+    auto nms = std::make_shared<NonMaxSuppression>(NonMaxSuppression::Method::Greedy, 0.5f);
+    return [boxes, nms]() {
+        nms->clear();
+        for (int i = 0; i < boxes.rows; i++) {
+            const float* box = boxes.ptr<float>(i);
+            nms->add(cv::Rect2f(cv::Point2f(box[0], box[1]), cv::Point2f(box[2], box[3])), box[4]);
+        }
+        nms->apply();
+    };
+}
+
+std::function<void()> kuhnMunkresKernel(const cv::Mat& costs) {
+    return [costs]() {
+        KuhnMunkres().Solve(costs);
+    };
+}
+
+std::function<void()> matToBlobKernel(const cv::Mat& frame, const cv::Size& blobSize) {
+    InferenceEngine::TensorDesc desc(InferenceEngine::Precision::U8,
+        {1, 3, static_cast<size_t>(blobSize.height), static_cast<size_t>(blobSize.width)},
+        InferenceEngine::Layout::NCHW);
+    InferenceEngine::Blob::Ptr blob = InferenceEngine::make_shared_blob<uint8_t>(desc);
+    blob->allocate();
+    return [frame, blob]() mutable {
+        matU8ToBlob<uint8_t>(frame, blob);
+    };
+}
+
+std::string escapeJson(const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    try {
+        // ------------------------------ Parsing and validation of input args ---------------------------------
+        if (!ParseAndCheckCommandLine(argc, argv)) {
+            return 0;
+        }
+
+        std::vector<std::string> kernels = split(FLAGS_kernels, ',');
+        for (const std::string& kernel : kernels) {
+            if (kernel != "heatmap_peaks" && kernel != "nms" && kernel != "kuhn_munkres" && kernel != "mat_to_blob") {
+                throw std::invalid_argument("Unknown kernel: " + kernel);
+            }
+        }
+        auto isSelected = [&kernels](const char* kernel) {
+            return std::find(kernels.begin(), kernels.end(), kernel) != kernels.end();
+        };
+
+        //------------------------------- Reading fixtures -----------------------------------------------------
+        cv::FileStorage fixture;
+        if (!FLAGS_fixture.empty() && !fixture.open(FLAGS_fixture, cv::FileStorage::READ)) {
+            throw std::runtime_error("Can't open " + FLAGS_fixture);
+        }
+        auto readFixture = [&fixture](const char* name) {
+            cv::Mat tensor;
+            if (fixture.isOpened() && !fixture[name].empty()) {
+                fixture[name] >> tensor;
+            }
+            return tensor;
+        };
+
+        //------------------------------- Running cases --------------------------------------------------------
+        // Synthetic data doesn't change from run to run, so the results of different builds can be compared
+        cv::RNG rng(12345);
+        std::vector<CaseResult> results;
+
+        if (isSelected("heatmap_peaks")) {
+            const cv::Size heatMapSize = parseSize(FLAGS_heatmap_size, "heatmap_size");
+            for (uint32_t peopleCount : parseNumbers(FLAGS_people, "people")) {
+                results.push_back(measure("heatmap_peaks", "people", std::to_string(peopleCount),
+                    heatMapPeaksKernel(makeHeatMaps(rng, heatMapSize, peopleCount))));
+            }
+            // Keypoints x height x width output of the model, upsampled as the demos do it
+            cv::Mat recorded = readFixture("heatmaps");
+            if (!recorded.empty()) {
+                if (recorded.dims != 3 || recorded.type() != CV_32FC1) {
+                    throw std::runtime_error("The heatmaps of the fixture must be a 3D CV_32F tensor");
+                }
+                std::vector<cv::Mat> heatMaps;
+                for (int k = 0; k < recorded.size[0]; k++) {
+                    heatMaps.emplace_back(recorded.size[1], recorded.size[2], CV_32FC1, recorded.ptr<float>(k));
+                }
+                results.push_back(measure("heatmap_peaks", "fixture", "heatmaps", heatMapPeaksKernel(heatMaps)));
+            }
+        }
+
+        if (isSelected("nms")) {
+            for (uint32_t boxesCount : parseNumbers(FLAGS_boxes, "boxes")) {
+                results.push_back(measure("nms", "boxes", std::to_string(boxesCount),
+                    nmsKernel(makeBoxes(rng, boxesCount))));
+            }
+            // Rows of x1, y1, x2, y2, score, e.g. SSD output boxes with the scores above the threshold
+            cv::Mat recorded = readFixture("boxes");
+            if (!recorded.empty()) {
+                if (recorded.dims != 2 || recorded.cols != 5 || recorded.type() != CV_32FC1) {
+                    throw std::runtime_error("The boxes of the fixture must be a CV_32F matrix of 5 columns");
+                }
+                results.push_back(measure("nms", "fixture", "boxes", nmsKernel(recorded)));
+            }
+        }
+
+        if (isSelected("kuhn_munkres")) {
+            for (uint32_t tracksCount : parseNumbers(FLAGS_tracks, "tracks")) {
+                cv::Mat costs(static_cast<int>(tracksCount), static_cast<int>(tracksCount), CV_32FC1);
+                rng.fill(costs, cv::RNG::UNIFORM, 0.f, 1.f);
+                results.push_back(measure("kuhn_munkres", "tracks", std::to_string(tracksCount),
+                    kuhnMunkresKernel(costs)));
+            }
+            // Dissimilarities of the tracks and the detections of a frame
+            cv::Mat recorded = readFixture("costs");
+            if (!recorded.empty()) {
+                if (recorded.dims != 2 || recorded.type() != CV_32FC1) {
+                    throw std::runtime_error("The costs of the fixture must be a CV_32F matrix");
+                }
+                results.push_back(measure("kuhn_munkres", "fixture", "costs", kuhnMunkresKernel(recorded)));
+            }
+        }
+
+        if (isSelected("mat_to_blob")) {
+            const cv::Size blobSize = parseSize(FLAGS_blob_size, "blob_size");
+            for (const std::string& frameSize : split(FLAGS_frame_sizes, ',')) {
+                cv::Mat frame(parseSize(frameSize, "frame_sizes"), CV_8UC3);
+                rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+                results.push_back(measure("mat_to_blob", "frame", sizeToString(frame.size()),
+                    matToBlobKernel(frame, blobSize)));
+            }
+            cv::Mat recorded = readFixture("frame");
+            if (!recorded.empty()) {
+                if (recorded.type() != CV_8UC3) {
+                    throw std::runtime_error("The frame of the fixture must be a CV_8UC3 image");
+                }
+                results.push_back(measure("mat_to_blob", "fixture", sizeToString(recorded.size()),
+                    matToBlobKernel(recorded, blobSize)));
+            }
+        }
+
+        //// --------------------------- Report results -------------------------------------------------------
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(3);
+        report << "{\"cases\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const CaseResult& result = results[i];
+            report << (i ? ", " : "") << "{\"kernel\": \"" << result.kernel
+                   << "\", \"parameter\": \"" << result.parameter
+                   << "\", \"value\": \"" << escapeJson(result.value) << "\", \"runs\": " << result.runsCount
+                   << ", \"time_us\": {\"mean\": " << result.mean << ", \"p50\": " << result.p50
+                   << ", \"p90\": " << result.p90 << ", \"max\": " << result.max << "}}";
+        }
+        report << "]}" << std::endl;
+
+        if (FLAGS_o.empty()) {
+            std::cout << report.str();
+        } else {
+            std::ofstream out(FLAGS_o);
+            if (!out) {
+                throw std::runtime_error("Can't open " + FLAGS_o + " for writing");
+            }
+            out << report.str();
+        }
+    }
+    catch (const std::exception& error) {
+        slog::err << "[ ERROR ] " << error.what() << slog::endl;
+        return 1;
+    }
+    catch (...) {
+        slog::err << "[ ERROR ] Unknown/internal exception happened." << slog::endl;
+        return 1;
+    }
+
+    slog::info << slog::endl << "The execution has completed successfully" << slog::endl;
+    return 0;
+}
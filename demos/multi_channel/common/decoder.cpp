@@ -11,9 +11,13 @@
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <sstream>
 #include <thread>
@@ -290,6 +294,16 @@ void map_va_buffer(VADisplay display, VABufferID buffer, F&& func) {
     CHECK_VA(vaUnmapBuffer(display, buffer));
 }
 
+// Owns the display with the X display or the DRM device it's opened on
+struct VADisplayHolder {
+#ifdef VA_USE_X11
+    XDisplayPtr x_display;
+#else
+    fd_wrapper dri_fd;
+#endif
+    VAPtr va_display;  // it's terminated before the device is closed
+};
+
 unsigned make_size_val(unsigned w, unsigned h) {
     assert(w <= std::numeric_limits<unsigned short>::max());
     assert(h <= std::numeric_limits<unsigned short>::max());
@@ -304,12 +318,7 @@ struct Decoder::HwContext {
 
     const Decoder::Settings settings;
 
-#ifdef VA_USE_X11
-    XDisplayPtr x_display;
-#else
-    fd_wrapper dri_fd;
-#endif
-    VAPtr va_display;
+    std::shared_ptr<void> va_display;  // VADisplay
 
     enum {
         PicParam,
@@ -351,32 +360,7 @@ struct Decoder::HwContext {
         settings(s),
         perf_timer_decode(s.collect_stats ? PerfTimer::DefaultIterationsCount :
                                             0) {
-#ifdef VA_USE_X11
-        x_display.reset(XOpenDisplay(nullptr));
-        if (nullptr == x_display) {
-            throw std::runtime_error("XOpenDisplay failed");
-        }
-
-        va_display.reset(vaGetDisplay(x_display.get()));
-        if (nullptr == va_display) {
-            throw std::runtime_error("vaGetDisplay failed");
-        }
-#else
-        dri_fd = fd_wrapper(open("/dev/dri/renderD128", O_RDWR));
-        if (-1 == dri_fd.get()) {
-            throw std::runtime_error("Cannot open dri device");
-        }
-
-        va_display.reset(vaGetDisplayDRM(dri_fd.get()));
-        if (nullptr == va_display) {
-            throw std::runtime_error("vaGetDisplayDRM failed");
-        }
-#endif
-
-        int major_version = 0;
-        int minor_version = 0;
-        CHECK_VA(vaInitialize(va_display.get(), &major_version,
-                              &minor_version));
+        va_display = nullptr != s.va_display ? s.va_display : Decoder::openVaDisplay();
 
         wait_thread = std::thread([this]() {
             while (true) {
@@ -878,8 +862,93 @@ struct Decoder::HwContext {
 
 #endif
 
+#ifdef USE_TBB
+// Every queued frame has one arena task, which decodes the oldest queued frame of its source. Frames are dropped
+// together with their tasks, so the arena never holds more tasks than max_in_flight for every source
+struct Decoder::AsyncQueue {
+    struct Source {
+        std::deque<std::function<void()>> queued;
+        unsigned decoding = 0;
+    };
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::map<const void*, Source> sources;
+    std::size_t queued_count = 0;
+    std::size_t tasks_count = 0;  // enqueued into the arena and not finished yet
+    std::uint64_t dropped_count = 0;
+    bool stopping = false;
+};
+
+void Decoder::decode_async(const void* source, std::function<void()> task) {
+    assert(nullptr != async_queue);
+    AsyncQueue& q = *async_queue;
+    std::function<void()> dropped;
+    bool is_queued = false;
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        auto& src = q.sources[source];
+        const bool is_full = 0 != settings.max_in_flight &&
+            src.queued.size() + src.decoding >= settings.max_in_flight;
+        if (is_full && src.queued.empty()) {
+            // All frames in flight are being decoded, the new one is the oldest not started
+            dropped = std::move(task);
+            ++q.dropped_count;
+        } else {
+            if (is_full) {
+                dropped = std::move(src.queued.front());
+                src.queued.pop_front();
+                ++q.dropped_count;
+            } else {
+                ++q.queued_count;
+                ++q.tasks_count;
+                is_queued = true;
+            }
+            src.queued.push_back(std::move(task));
+        }
+    }
+    dropped = nullptr;  // releases the callback outside of the lock
+    if (!is_queued) {
+        return;
+    }
+    get_tbb_arena().enqueue([this, source]() {
+        AsyncQueue& q = *async_queue;
+        std::function<void()> next;
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.stopping) {
+                auto& src = q.sources[source];
+                assert(!src.queued.empty());
+                next = std::move(src.queued.front());
+                src.queued.pop_front();
+                --q.queued_count;
+                ++src.decoding;
+            }
+        }
+        if (nullptr != next) {
+            next();
+            next = nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.stopping) {
+                --q.sources[source].decoding;
+            }
+            --q.tasks_count;
+            // Under the lock: the destructor may destroy the queue as soon as it's released
+            q.finished.notify_all();
+        }
+    });
+}
+#endif
+
 Decoder::Decoder(const Settings& s):
     settings(s) {
+#ifdef USE_TBB
+    if (Mode::Async == settings.mode) {
+        async_queue.reset(new AsyncQueue);
+    }
+#endif
     if (Mode::Hw == settings.mode) {
 #ifdef USE_LIBVA
         hw_context.reset(new HwContext(settings));
@@ -890,18 +959,68 @@ Decoder::Decoder(const Settings& s):
 }
 
 Decoder::~Decoder() {
+#ifdef USE_TBB
+    if (nullptr != async_queue) {
+        std::map<const void*, AsyncQueue::Source> dropped;
+        std::unique_lock<std::mutex> lock(async_queue->mutex);
+        // Queued frames are dropped, the tasks already in the arena still have to finish
+        async_queue->stopping = true;
+        dropped.swap(async_queue->sources);
+        async_queue->queued_count = 0;
+        async_queue->finished.wait(lock, [this]() {return 0 == async_queue->tasks_count;});
+    }
+#endif
 }
 
 Decoder::Stats Decoder::getStats() const {
+    Stats ret;
 #ifdef USE_LIBVA
     if (nullptr != hw_context) {
-        return {hw_context->getLatency()};
+        ret.decoding_latency = hw_context->getLatency();
     }
 #endif
-    return {};
+#ifdef USE_TBB
+    if (nullptr != async_queue) {
+        std::lock_guard<std::mutex> lock(async_queue->mutex);
+        ret.queue_depth = async_queue->queued_count;
+        ret.dropped_frames = async_queue->dropped_count;
+    }
+#endif
+    return ret;
 }
 
 #ifdef USE_LIBVA
+std::shared_ptr<void> Decoder::openVaDisplay() {
+    auto holder = std::make_shared<VADisplayHolder>();
+#ifdef VA_USE_X11
+    holder->x_display.reset(XOpenDisplay(nullptr));
+    if (nullptr == holder->x_display) {
+        throw std::runtime_error("XOpenDisplay failed");
+    }
+
+    holder->va_display.reset(vaGetDisplay(holder->x_display.get()));
+    if (nullptr == holder->va_display) {
+        throw std::runtime_error("vaGetDisplay failed");
+    }
+#else
+    holder->dri_fd = fd_wrapper(open("/dev/dri/renderD128", O_RDWR));
+    if (-1 == holder->dri_fd.get()) {
+        throw std::runtime_error("Cannot open dri device");
+    }
+
+    holder->va_display.reset(vaGetDisplayDRM(holder->dri_fd.get()));
+    if (nullptr == holder->va_display) {
+        throw std::runtime_error("vaGetDisplayDRM failed");
+    }
+#endif
+
+    int major_version = 0;
+    int minor_version = 0;
+    CHECK_VA(vaInitialize(holder->va_display.get(), &major_version,
+                          &minor_version));
+    return std::shared_ptr<void>(holder, holder->va_display.get());
+}
+
 void Decoder::decode_hw(const void* data, size_t size, unsigned width,
                         unsigned height, callback_t callback) {
     assert(nullptr != hw_context);
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <memory>
 #include <type_traits>
@@ -26,10 +28,18 @@ public:
 
     struct Settings {
         Mode mode = Mode::Immediate;
+        // Size of the network input. Hw mode scales frames to it, other modes decode JPEG frames reduced
+        // by 2, 4 or 8 times if they stay at least that large. 0 keeps the frame size
         unsigned output_width = 0;
         unsigned output_height = 0;
         unsigned num_buffers = 1;
+        // Async mode: frames of one source which are queued or decoded at once. If a new frame exceeds it,
+        // the oldest queued frame of the source is dropped. 0 is unlimited
+        unsigned max_in_flight = 0;
         bool collect_stats = false;
+        // Hw mode: VADisplay shared with other users of the device, e.g. the GPU plugin.
+        // If it's null, the decoder opens its own display
+        std::shared_ptr<void> va_display;
     };
 
     explicit Decoder(const Settings& s);
@@ -39,13 +49,22 @@ public:
 
     struct Stats {
         float decoding_latency = 0.0f;
+        std::size_t queue_depth = 0;  // frames waiting for Async decoding
+        std::uint64_t dropped_frames = 0;  // frames dropped by Async decoding
     };
 
     Stats getStats() const;
 
+#ifdef USE_LIBVA
+    // Opens and initializes a VADisplay, it's terminated when the last pointer is released
+    static std::shared_ptr<void> openVaDisplay();
+#endif
+
+    // callback receives the decoded image. In Async mode a dropped frame's callback is destroyed without a call,
+    // data must stay valid until one of them. max_in_flight is counted for every source separately
     template<typename F>
     void decode(const void* data, size_t size, unsigned width, unsigned height,
-                F&& callback) {
+                F&& callback, const void* source = nullptr) {
         assert(nullptr != data);
         assert(size > 0);
         assert(width > 0);
@@ -56,19 +75,18 @@ public:
             auto img = cv::imdecode(
             {static_cast<const char*>(data),
              static_cast<int>(size)},
-                           cv::IMREAD_COLOR);
+                           decodeFlags(width, height));
             callback(std::move(img));
         } else if (Mode::Async == mode) {
 #ifdef USE_TBB
-            auto decode = [data, size, c = std::move(callback), this]() mutable {
+            auto decode = [data, size, flags = decodeFlags(width, height), c = std::move(callback)]() mutable {
                 auto img = cv::imdecode(
                 {static_cast<const char*>(data),
                  static_cast<int>(size)},
-                            cv::IMREAD_COLOR);
+                            flags);
                 c(std::move(img));
             };
-            auto& arena = get_tbb_arena();
-            arena.enqueue(std::move(decode));
+            decode_async(source, make_copyable(std::move(decode)));
 #else
             throw std::logic_error("Async decoding is not supported");
 #endif
@@ -80,6 +98,7 @@ public:
             };
             decode_hw(data, size, width, height,
                       make_copyable(std::move(decode)));
+            (void)source;
 #else
             assert(false);
 #endif
@@ -90,8 +109,23 @@ public:
 
 private:
     const Settings settings;
-#ifdef USE_LIBVA
-    struct HwContext;
+
+    // Software decoding scales JPEG frames down by 2, 4 or 8 times while decoding, if they stay at least
+    // as large as the output size
+    int decodeFlags(unsigned width, unsigned height) const {
+        if (0 == settings.output_width || 0 == settings.output_height) {
+            return cv::IMREAD_COLOR;
+        }
+        unsigned factor = 1;
+        while (factor < 8 && width / (factor * 2) >= settings.output_width
+               && height / (factor * 2) >= settings.output_height) {
+            factor *= 2;
+        }
+        return 8 == factor ? cv::IMREAD_REDUCED_COLOR_8
+            : 4 == factor ? cv::IMREAD_REDUCED_COLOR_4
+            : 2 == factor ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_COLOR;
+    }
+#if defined(USE_LIBVA) || defined(USE_TBB)
     template<typename T>
     struct MoveHack {
         union {
@@ -118,6 +152,15 @@ private:
     ->MoveHack<typename std::remove_reference<T>::type> {
         return MoveHack<typename std::remove_reference<T>::type>{std::move(val)};
     }
+#endif
+#ifdef USE_TBB
+    struct AsyncQueue;
+    std::unique_ptr<AsyncQueue> async_queue;
+
+    void decode_async(const void* source, std::function<void()> task);
+#endif
+#ifdef USE_LIBVA
+    struct HwContext;
 
     using callback_t = std::function<void(cv::Mat&&)>;
 
@@ -0,0 +1,74 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <samples/frame_allocator.h>
+
+// Frame buffers of one source which are reused once the frames read into them are released.
+// A buffer is free when the pool holds the only reference to it, so frames return to the pool when the last
+// cv::Mat sharing them (e.g. in VideoFrame) is destroyed, without any callbacks. Only one thread may acquire buffers,
+// other threads may hold and release frames freely.
+class FramePool {
+public:
+    explicit FramePool(std::size_t reservedSize) : reservedSize(reservedSize) {
+        buffers.reserve(reservedSize);
+    }
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Returns a free buffer to read the next frame into. Readers which write into the existing data if the size and
+    // type match (like cv::VideoCapture::read()) allocate the memory once per buffer then
+    cv::Mat& acquire() {
+        for (std::size_t i = 0; i < buffers.size(); ++i) {
+            cv::Mat& buffer = buffers[(nextBufferId + i) % buffers.size()];
+            // Nobody else can take a new reference to the buffer, so it stays free after the check
+            if (!buffer.u || CV_XADD(&buffer.u->refcount, 0) == 1) {
+                nextBufferId = (nextBufferId + i + 1) % buffers.size();
+                return buffer;
+            }
+        }
+        // All buffers are in flight, the pool grows to the number of frames the pipeline holds at once
+        buffers.emplace_back();
+        nextBufferId = 0;
+        return buffers.back();
+    }
+
+    // Allocates the rest of the reserved buffers like the frame and writes them, so the page faults of the buffers
+    // happen at once after the first frame instead of on the next frames. Returns at once when they are allocated.
+    // The references returned by acquire() stay valid
+    void prefill(const cv::Mat& frame) {
+        while (buffers.size() < reservedSize && !frame.empty()) {
+            buffers.emplace_back();
+            buffers.back().allocator = getFrameAllocator();
+            buffers.back().create(frame.size(), frame.type());
+            buffers.back().setTo(cv::Scalar::all(0));
+        }
+    }
+
+    // Changes the number of buffers prefill() allocates and releases the free buffers above it, so the memory
+    // returns to the system when the queue of the source gets shorter. Must be called by the acquiring thread,
+    // the references returned by acquire() become invalid
+    void setReservedSize(std::size_t size) {
+        reservedSize = size;
+        for (std::size_t i = buffers.size(); i-- > 0 && buffers.size() > reservedSize;) {
+            if (!buffers[i].u || CV_XADD(&buffers[i].u->refcount, 0) == 1) {
+                buffers.erase(buffers.begin() + i);
+            }
+        }
+        nextBufferId = 0;
+    }
+
+    std::size_t size() const {return buffers.size();}
+
+private:
+    std::size_t reservedSize;
+    std::vector<cv::Mat> buffers;  // a reference returned by acquire() is valid until the next acquire()
+    std::size_t nextBufferId = 0;
+};
@@ -4,11 +4,18 @@
 
 #include <algorithm>
 #include <chrono>
+#include <exception>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <samples/blob_allocator.h>
+#include <samples/read_network.hpp>
+#include <samples/thread_budget.hpp>
+#include <samples/warmup.hpp>
+
 #include "graph.hpp"
 #include "threading.hpp"
 
@@ -16,33 +23,43 @@
 #include <tbb/parallel_for.h>
 #endif
 
+#ifdef USE_LIBVA
+#include <gpu/gpu_context_api_va.hpp>
+#endif
+
 namespace {
 
-void loadImgToIEGraph(const cv::Mat& img, size_t batch, void* ieBuffer) {
+void loadImgToIEGraph(const cv::Mat& img, size_t batch, void* ieBuffer, std::vector<cv::Mat>& u8Planes) {
     const int channels = img.channels();
     const int height = img.rows;
     const int width = img.cols;
 
     float* ieData = reinterpret_cast<float*>(ieBuffer);
-    int bOffset = static_cast<int>(batch) * channels * width * height;
+    const size_t planeSize = static_cast<size_t>(width) * height;
+    const size_t bOffset = batch * channels * planeSize;
+    // The image is split in U8, and every plane is converted straight into the blob memory, so no float copy
+    // of the whole image is written and read again
+    cv::split(img, u8Planes);
     for (int c = 0; c < channels; c++) {
-        int cOffset = c * width * height;
-        for (int w = 0; w < width; w++) {
-            for (int h = 0; h < height; h++) {
-                ieData[bOffset + cOffset + h * width + w] =
-                        static_cast<float>(img.at<cv::Vec3b>(h, w)[c]);
-            }
-        }
+        cv::Mat plane(height, width, CV_32FC1, ieData + bOffset + c * planeSize);
+        u8Planes[c].convertTo(plane, CV_32F);
     }
 }
 
 }  // namespace
 
 void IEGraph::initNetwork(const std::string& deviceName) {
-    auto cnnNetwork = ie.ReadNetwork(modelPath);
+    auto cnnNetwork = readNetwork(ie, modelPath, mapWeights);
 
     if (deviceName.find("CPU") != std::string::npos) {
         ie.SetConfig({{InferenceEngine::PluginConfigParams::KEY_CPU_BIND_THREAD, "NO"}}, "CPU");
+        if (cpuThreadsNum > 0) {
+            ie.SetConfig({{InferenceEngine::PluginConfigParams::KEY_CPU_THREADS_NUM, std::to_string(cpuThreadsNum)}},
+                "CPU");
+        }
+        ThreadBudget::global().addCpuNetwork(
+            {{InferenceEngine::PluginConfigParams::KEY_CPU_THREADS_NUM, std::to_string(cpuThreadsNum)}});
+        ThreadBudget::global().applyToOpenCV();
     }
     if (!cpuExtensionPath.empty()) {
         auto extension_ptr = InferenceEngine::make_so_pointer<InferenceEngine::IExtension>(cpuExtensionPath);
@@ -68,8 +85,25 @@ void IEGraph::initNetwork(const std::string& deviceName) {
         cnnNetwork.reshape(inShapes);
     }
 
+    std::map<std::string, std::string> loadConfig;
+    if (isDynamicBatch()) {
+        // Partial batches are inferred with InferRequest::SetBatch()
+        loadConfig[InferenceEngine::PluginConfigParams::KEY_DYN_BATCH_ENABLED] = InferenceEngine::PluginConfigParams::YES;
+    }
     InferenceEngine::ExecutableNetwork network;
-    network = ie.LoadNetwork(cnnNetwork, deviceName);
+#ifdef USE_LIBVA
+    if (0 == deviceName.find("GPU")) {
+        // The network is loaded on a context of the decoder's display, so decoding and inference share the device
+        vaDisplay = Decoder::openVaDisplay();
+        auto context = InferenceEngine::gpu::make_shared_context(ie, deviceName,
+                                                                 static_cast<VADisplay>(vaDisplay.get()));
+        network = ie.LoadNetwork(cnnNetwork, context, loadConfig);
+    } else {
+        network = ie.LoadNetwork(cnnNetwork, deviceName, loadConfig);
+    }
+#else
+    network = ie.LoadNetwork(cnnNetwork, deviceName, loadConfig);
+#endif
 
     InferenceEngine::InputsDataMap inputInfo(cnnNetwork.getInputsInfo());
     if (inputInfo.size() != 1) {
@@ -83,52 +117,224 @@ void IEGraph::initNetwork(const std::string& deviceName) {
         outputDataBlobNames.push_back(i.first);
     }
 
+    slots.resize(maxRequests);
     for (size_t i = 0; i < maxRequests; ++i) {
-        auto req = network.CreateInferRequestPtr();
-        availableRequests.push(req);
+        slots[i].req = network.CreateInferRequestPtr();
+        setHugePageBlobs(network, *slots[i].req, deviceName);
+        idleSlots.push(i);
     }
 
     if (postLoad != nullptr)
         postLoad(outputDataBlobNames, cnnNetwork);
 
-    availableRequests.front()->StartAsync();
-    availableRequests.front()->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
+    // Every request is inferred before the first frame, so the slow first inferences don't stall the sources
+    std::vector<InferenceEngine::InferRequest::Ptr> requests;
+    for (const BatchSlot& slot : slots) {
+        requests.push_back(slot.req);
+    }
+    WarmupResult warmup = warmupRequests(requests, network.GetInputsInfo(), std::max(warmupRounds, 1u));
+    slog::info << "Warmed up in " << warmup.rounds << " rounds, the last one took "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(warmup.latency).count() << " ms" << slog::endl;
+}
+
+void IEGraph::startReader() {
+    readerThread = std::thread([&]() {
+        FRAME_TRACE_THREAD_NAME("IEGraph reader");
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtxReadFrames);
+                // Frames aren't read ahead for more than one batch, so they don't get stale
+                condVarReadFrames.wait(lock, [&]() {
+                    return readFrames.size() < batchSize || terminate;
+                });
+                if (terminate) {
+                    break;
+                }
+            }
+            VideoFrame vframe;
+            const bool isRead = getter(vframe);
+            {
+                std::lock_guard<std::mutex> lock(mtxReadFrames);
+                if (isRead) {
+                    readFrames.push_back(std::make_shared<VideoFrame>(vframe));
+                } else {
+                    isReadingFinished = true;
+                }
+            }
+            condVarReadFrames.notify_all();
+            if (!isRead) {
+                break;
+            }
+        }
+    });
+}
+
+bool IEGraph::collectBatch(std::vector<std::shared_ptr<VideoFrame>>& vframes) {
+    if (!isDynamicBatch()) {
+        while (vframes.size() != batchSize) {
+            VideoFrame vframe;
+            if (!getter(vframe)) {
+                return false;
+            }
+            vframes.push_back(std::make_shared<VideoFrame>(vframe));
+        }
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mtxReadFrames);
+    condVarReadFrames.wait(lock, [&]() {
+        return !readFrames.empty() || isReadingFinished || terminate;
+    });
+    // The deadline starts with the first frame of the batch, so a stalled source delays the others by this time only
+    condVarReadFrames.wait_until(lock, std::chrono::steady_clock::now() + maxBatchWaitTime, [&]() {
+        return readFrames.size() >= batchSize || isReadingFinished || terminate;
+    });
+    while (!readFrames.empty() && vframes.size() != batchSize) {
+        vframes.push_back(std::move(readFrames.front()));
+        readFrames.pop_front();
+    }
+    lock.unlock();
+    condVarReadFrames.notify_all();
+    return !vframes.empty();
+}
+
+void IEGraph::releaseFrames(std::vector<std::shared_ptr<VideoFrame>>& vframes, const std::vector<int64_t>& seqIds,
+                            std::chrono::high_resolution_clock::time_point startTime,
+                            std::chrono::high_resolution_clock::time_point endTime) {
+    {
+        std::lock_guard<std::mutex> lock(mtxReady);
+        for (size_t i = 0; i < vframes.size(); i++) {
+            SourceFrames& source = sourcesFrames[vframes[i]->sourceIdx];
+            source.postponed.emplace(seqIds[i], std::move(vframes[i]));
+            auto it = source.postponed.begin();
+            while (it != source.postponed.end() && it->first == source.nextSeqId) {
+                readyFrames.push_back(std::move(it->second));
+                it = source.postponed.erase(it);
+                source.nextSeqId++;
+            }
+        }
+        if (perfTimerInfer.enabled()) {
+            perfTimerInfer.addValue(endTime - startTime);
+        }
+        startedBatches--;
+    }
+    condVarReady.notify_all();
+}
+
+void IEGraph::postprocessingLoop() {
+    FRAME_TRACE_THREAD_NAME("IEGraph postprocessing");
+    std::vector<std::shared_ptr<VideoFrame>> vframes;
+    std::vector<int64_t> seqIds;
+    for (;;) {
+        std::size_t slotId;
+        {
+            std::unique_lock<std::mutex> lock(mtxCompletedSlots);
+            condVarCompletedSlots.wait(lock, [&]() {
+                return !completedSlots.empty() || isPostprocessingStopped;
+            });
+            if (completedSlots.empty()) {
+                break;
+            }
+            slotId = completedSlots.front();
+            completedSlots.pop_front();
+        }
+        BatchSlot& slot = slots[slotId];
+        const InferenceEngine::InferRequest::Ptr& req = slot.req;
+        vframes.clear();
+        vframes.swap(slot.vframes);
+        seqIds.clear();
+        seqIds.swap(slot.seqIds);
+        const auto startTime = slot.startTime;
+        const auto endTime = std::chrono::high_resolution_clock::now();
+
+        auto setException = [&]() {
+            std::lock_guard<std::mutex> lock(mtxReady);
+            if (!postprocessingException) {
+                postprocessingException = std::current_exception();
+            }
+        };
+        bool isPostprocessed = false;
+        // The request has completed, so Wait() only returns its status
+        if (InferenceEngine::OK == req->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY)) {
+            try {
+                FRAME_TRACE_SCOPE("Postprocess", -1, -1);
+                traceFrameFlows(vframes);
+                auto detections = postprocessing(req, outputDataBlobNames, frameSize);
+                // A partial batch has less frames than detections
+                for (decltype(detections.size()) i = 0; i < std::min(detections.size(), vframes.size()); i ++) {
+                    vframes[i]->detections = std::move(detections[i]);
+                }
+                isPostprocessed = true;
+            } catch (...) {
+                setException();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtxIdleSlots);
+            idleSlots.push(slotId);
+        }
+        // The chained stage needs the frames only, so the request already infers the next batch
+        if (isPostprocessed && chainedStage) {
+            try {
+                FRAME_TRACE_SCOPE("Chained stage", -1, -1);
+                traceFrameFlows(vframes);
+                chainedStage(vframes);
+            } catch (...) {
+                setException();
+            }
+        }
+        releaseFrames(vframes, seqIds, startTime, endTime);
+    }
 }
 
-void IEGraph::start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc) {
+void IEGraph::start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc, cv::Size frameSize,
+                    ChainedStageFunc chainedStageFunc) {
     assert(nullptr != getterFunc);
     assert(nullptr != postprocessingFunc);
     assert(nullptr == getter);
     getter = std::move(getterFunc);
     postprocessing = std::move(postprocessingFunc);
+    chainedStage = std::move(chainedStageFunc);
+    this->frameSize = frameSize;
+    for (size_t slotId = 0; slotId < slots.size(); ++slotId) {
+        slots[slotId].req->SetCompletionCallback([this, slotId]() {
+            {
+                std::lock_guard<std::mutex> lock(mtxCompletedSlots);
+                completedSlots.push_back(slotId);
+            }
+            condVarCompletedSlots.notify_one();
+        });
+    }
+    for (size_t i = 0; i < postprocessingThreadsNum; ++i) {
+        postprocessingThreads.emplace_back(&IEGraph::postprocessingLoop, this);
+    }
+    if (isDynamicBatch()) {
+        startReader();
+    }
     getterThread = std::thread([&]() {
+        FRAME_TRACE_THREAD_NAME("IEGraph getter");
         std::vector<std::shared_ptr<VideoFrame>> vframes;
         std::vector<cv::Mat> imgsToProc(batchSize);
+        std::vector<std::vector<cv::Mat>> u8Planes(batchSize);
+        std::map<std::size_t, int64_t> sourcesSeqIds;
         while (!terminate) {
             vframes.clear();
-            size_t b = 0;
-            while (b != batchSize) {
-                VideoFrame vframe;
-                if (getter(vframe)) {
-                    vframes.push_back(std::make_shared<VideoFrame>(vframe));
-                    ++b;
-                } else {
-                    terminate = true;
-                    break;
-                }
+            if (!collectBatch(vframes)) {
+                terminate = true;
             }
 
-            InferenceEngine::InferRequest::Ptr req;
-            {
-                std::unique_lock<std::mutex> lock(mtxAvalableRequests);
-                condVarAvailableRequests.wait(lock, [&]() {
-                    return !availableRequests.empty() || terminate;
-                });
-                if (terminate) {
-                    break;
-                }
-                req = std::move(availableRequests.front());
-                availableRequests.pop();
+            std::size_t slotId;
+            if (!idleSlots.pop(slotId) || terminate) {
+                break;
+            }
+            BatchSlot& slot = slots[slotId];
+            const InferenceEngine::InferRequest::Ptr& req = slot.req;
+            // The frames go with the slot to a postprocessing thread, its vectors were emptied there.
+            // They are set before the start, as the completion callback can be called before StartAsync() returns
+            std::swap(slot.vframes, vframes);
+            for (const std::shared_ptr<VideoFrame>& vframe : slot.vframes) {
+                slot.seqIds.push_back(sourcesSeqIds[vframe->sourceIdx]++);
             }
 
             auto inputBlob = req->GetBlob(inputDataBlobName);
@@ -144,56 +350,80 @@ void IEGraph::start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc
             }
 
             auto preprocess = [&]() {
+                FRAME_TRACE_SCOPE("Preprocess", -1, -1);
+                traceFrameFlows(slot.vframes);
                 InferenceEngine::LockedMemory<void> buff = InferenceEngine::as<
                     InferenceEngine::MemoryBlob>(inputBlob)->wmap();
                 float* inputPtr = static_cast<float*>(buff);
                 auto loopBody = [&](size_t i) {
-                    cv::resize(vframes[i]->frame,
-                               imgsToProc[i],
-                               imgsToProc[i].size());
-                    loadImgToIEGraph(imgsToProc[i], i, inputPtr);
+                    const cv::Mat& frame = slot.vframes[i]->frame;
+                    // Hardware decoding scales frames to the input size already
+                    if (frame.size() == imgsToProc[i].size() && CV_8UC3 == frame.type()) {
+                        loadImgToIEGraph(frame, i, inputPtr, u8Planes[i]);
+                    } else {
+                        cv::resize(frame, imgsToProc[i], imgsToProc[i].size());
+                        loadImgToIEGraph(imgsToProc[i], i, inputPtr, u8Planes[i]);
+                    }
                 };
 #ifdef USE_TBB
                 run_in_arena([&](){
-                    tbb::parallel_for<size_t>(0, batchSize, loopBody);
+                    tbb::parallel_for<size_t>(0, slot.vframes.size(), loopBody);
                 });
 #else
-                for (size_t i = 0; i < batchSize; i++) {
-                    loopBody(i);
-                }
+                // The frames go to separate slots and buffers, so they are filled on OpenCV threads in parallel
+                cv::parallel_for_(cv::Range(0, static_cast<int>(slot.vframes.size())), [&](const cv::Range& range) {
+                    for (int i = range.start; i < range.end; i++) {
+                        loopBody(static_cast<size_t>(i));
+                    }
+                });
 #endif
             };
 
+            auto startInfer = [&]() {
+                FRAME_TRACE_SCOPE("Start infer", -1, -1);
+                traceFrameFlows(slot.vframes);
+                if (isDynamicBatch()) {
+                    req->SetBatch(static_cast<int>(slot.vframes.size()));
+                }
+                submittedBatches++;
+                submittedFrames += slot.vframes.size();
+                {
+                    std::lock_guard<std::mutex> lock(mtxReady);
+                    startedBatches++;
+                }
+                req->StartAsync();
+            };
+
             if (perfTimerInfer.enabled()) {
                 {
                     ScopedTimer st(perfTimerPreprocess);
                     preprocess();
                 }
-                auto startTime = std::chrono::high_resolution_clock::now();
-                req->StartAsync();
-                std::unique_lock<std::mutex> lock(mtxBusyRequests);
-                busyBatchRequests.push({std::move(vframes), std::move(req), startTime});
+                slot.startTime = std::chrono::high_resolution_clock::now();
+                startInfer();
             } else {
                 preprocess();
-                req->StartAsync();
-                std::unique_lock<std::mutex> lock(mtxBusyRequests);
-                busyBatchRequests.push({std::move(vframes), std::move(req),
-                                    std::chrono::high_resolution_clock::time_point()});
+                startInfer();
             }
-            condVarBusyRequests.notify_one();
         }
-        condVarBusyRequests.notify_one(); // notify that there will be no new InferRequests
+        {
+            std::lock_guard<std::mutex> lock(mtxReady);
+            isSubmissionFinished = true; // notify that there will be no new InferRequests
+        }
+        condVarReady.notify_all();
     });
 }
 
 IEGraph::IEGraph(const InitParams& p):
     perfTimerPreprocess(p.collectStats ? PerfTimer::DefaultIterationsCount : 0),
     perfTimerInfer(p.collectStats ? PerfTimer::DefaultIterationsCount : 0),
-    confidenceThreshold(0.5f), batchSize(p.batchSize),
+    confidenceThreshold(0.5f), batchSize(p.batchSize), maxBatchWaitTime(p.maxBatchWaitTime),
     modelPath(p.modelPath),
-    cpuExtensionPath(p.cpuExtPath), cldnnConfigPath(p.cldnnConfigPath),
+    cpuExtensionPath(p.cpuExtPath), cldnnConfigPath(p.cldnnConfigPath), cpuThreadsNum(p.cpuThreadsNum),
+    mapWeights(p.mapWeights), warmupRounds(p.warmupRounds),
     printPerfReport(p.reportPerf), deviceName(p.deviceName),
-    maxRequests(p.maxRequests) {
+    maxRequests(p.maxRequests), postprocessingThreadsNum(std::max<std::size_t>(p.postprocessingThreads, 1)),
+    idleSlots(p.maxRequests) {
     assert(p.maxRequests > 0);
 
     postLoad = p.postLoadFunc;
@@ -201,53 +431,29 @@ IEGraph::IEGraph(const InitParams& p):
 }
 
 bool IEGraph::isRunning() {
-    std::lock_guard<std::mutex> lock(mtxBusyRequests);
-    return !terminate || !busyBatchRequests.empty();
+    std::lock_guard<std::mutex> lock(mtxReady);
+    return !terminate || startedBatches > 0 || !readyFrames.empty();
 }
 
 InferenceEngine::SizeVector IEGraph::getInputDims() const {
-    assert(!availableRequests.empty());
-    auto inputBlob = availableRequests.front()->GetBlob(inputDataBlobName);
+    assert(!slots.empty());
+    auto inputBlob = slots.front().req->GetBlob(inputDataBlobName);
     return inputBlob->getTensorDesc().getDims();
 }
 
-std::vector<std::shared_ptr<VideoFrame> > IEGraph::getBatchData(cv::Size frameSize) {
+std::vector<std::shared_ptr<VideoFrame> > IEGraph::getBatchData() {
     std::vector<std::shared_ptr<VideoFrame>> vframes;
-    InferenceEngine::InferRequest::Ptr req;
-    std::chrono::high_resolution_clock::time_point startTime;
-    {
-        std::unique_lock<std::mutex> lock(mtxBusyRequests);
-        condVarBusyRequests.wait(lock, [&]() {
-            // wait until the pipeline is stopped or there are new InferRequests
-            return terminate || !busyBatchRequests.empty();
-        });
-        if (busyBatchRequests.empty()) {
-            return {}; // woke up because of termination, so leave if nothing to preces
-        }
-        vframes = std::move(busyBatchRequests.front().vfPtrVec);
-        req = std::move(busyBatchRequests.front().req);
-        startTime = std::move(busyBatchRequests.front().startTime);
-        busyBatchRequests.pop();
-    }
-
-    if (nullptr != req && InferenceEngine::OK == req->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY)) {
-        auto detections = postprocessing(req, outputDataBlobNames, frameSize);
-        for (decltype(detections.size()) i = 0; i < detections.size(); i ++) {
-            vframes[i]->detections = std::move(detections[i]);
-        }
-        if (perfTimerInfer.enabled()) {
-            auto endTime = std::chrono::high_resolution_clock::now();
-            perfTimerInfer.addValue(endTime - startTime);
-        }
-    }
-
-    if (nullptr != req) {
-        std::unique_lock<std::mutex> lock(mtxAvalableRequests);
-        availableRequests.push(std::move(req));
-        lock.unlock();
-        condVarAvailableRequests.notify_one();
+    std::unique_lock<std::mutex> lock(mtxReady);
+    // wait until the pipeline is stopped or there are postprocessed frames
+    condVarReady.wait(lock, [&]() {
+        return !readyFrames.empty() || postprocessingException || (isSubmissionFinished && 0 == startedBatches);
+    });
+    if (postprocessingException) {
+        std::exception_ptr exception = postprocessingException;
+        postprocessingException = nullptr;
+        std::rethrow_exception(exception);
     }
-
+    vframes.swap(readyFrames); // empty if woke up because of termination
     return vframes;
 }
 
@@ -262,37 +468,44 @@ void IEGraph::setDetectionConfidence(float conf) {
 IEGraph::~IEGraph() {
     terminate = true;
     {
-        std::unique_lock<std::mutex> lock(mtxAvalableRequests);
-        bool ready = false;
-        while (!ready) {
-            std::unique_lock<std::mutex> lock(mtxBusyRequests);
-            if (!busyBatchRequests.empty()) {
-                auto& req = busyBatchRequests.front().req;
-                if (nullptr != req) {
-                    req->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
-                    availableRequests.push(std::move(req));
-                }
-                busyBatchRequests.pop();
-            }
-            if (availableRequests.size() == maxRequests) {
-                ready = true;
-            }
-        }
-        if (printPerfReport) {
-            slog::info << "Performance counts report" << slog::endl << slog::endl;
-            printPerformanceCounts(getFullDeviceName(ie, deviceName));
-        }
-        condVarAvailableRequests.notify_one();
+        std::lock_guard<std::mutex> lock(mtxReadFrames);
     }
+    condVarReadFrames.notify_all();
+    idleSlots.stop();
     if (getterThread.joinable()) {
         getterThread.join();
     }
+    // Nothing is started anymore, so the started requests just have to complete and be postprocessed.
+    // No completion callback is called after that
+    {
+        std::unique_lock<std::mutex> lock(mtxReady);
+        condVarReady.wait(lock, [&]() {return 0 == startedBatches;});
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtxCompletedSlots);
+        isPostprocessingStopped = true;
+    }
+    condVarCompletedSlots.notify_all();
+    for (std::thread& thread : postprocessingThreads) {
+        thread.join();
+    }
+    if (printPerfReport) {
+        slog::info << "Performance counts report" << slog::endl << slog::endl;
+        printPerformanceCounts(getFullDeviceName(ie, deviceName));
+    }
+    if (readerThread.joinable()) {
+        readerThread.join();
+    }
 }
 
 IEGraph::Stats IEGraph::getStats() const {
-    return Stats{perfTimerPreprocess.getValue(), perfTimerInfer.getValue()};
+    const uint64_t batches = submittedBatches;
+    const float fillRatio = 0 == batches ? 0.0f
+        : static_cast<float>(submittedFrames) / static_cast<float>(batches * batchSize);
+    const PerfTimer::Statistics inferTime = perfTimerInfer.getStatistics();
+    return Stats{perfTimerPreprocess.getValue(), inferTime.mean, inferTime.p99, inferTime.max, fillRatio};
 }
 
 void IEGraph::printPerformanceCounts(std::string fullDeviceName) {
-    ::printPerformanceCounts(*availableRequests.front(), std::cout, fullDeviceName, false);
+    ::printPerformanceCounts(*slots.front().req, std::cout, fullDeviceName, false);
 }
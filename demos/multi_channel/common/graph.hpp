@@ -6,7 +6,9 @@
 
 #include <vector>
 #include <chrono>
-#include <queue>
+#include <deque>
+#include <exception>
+#include <map>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -21,6 +23,7 @@
 #include <samples/slog.hpp>
 #include "perf_timer.hpp"
 #include "input.hpp"
+#include "spsc_ring.hpp"
 
 void loadImageToIEGraph(cv::Mat img, void* ie_buffer);
 
@@ -34,10 +37,14 @@ private:
     float confidenceThreshold;
 
     std::size_t batchSize;
+    std::chrono::milliseconds maxBatchWaitTime;
 
     std::string modelPath;
     std::string cpuExtensionPath;
     std::string cldnnConfigPath;
+    unsigned cpuThreadsNum;
+    bool mapWeights;
+    unsigned warmupRounds;
 
     std::string inputDataBlobName;
     std::vector<std::string> outputDataBlobNames;
@@ -45,59 +52,124 @@ private:
     bool printPerfReport;
     std::string deviceName;
 
+    // GPU inference and hardware decoding share it, so the plugin works on the decoder's device
+    std::shared_ptr<void> vaDisplay;
     InferenceEngine::Core ie;
-    std::queue<InferenceEngine::InferRequest::Ptr> availableRequests;
 
-    struct BatchRequestDesc {
-        std::vector<std::shared_ptr<VideoFrame>> vfPtrVec;
+    // Every slot owns a request, slots are passed between threads by their indices
+    struct BatchSlot {
         InferenceEngine::InferRequest::Ptr req;
+        std::vector<std::shared_ptr<VideoFrame>> vframes;
+        std::vector<int64_t> seqIds;  // numbers of the frames among the frames of their sources
         std::chrono::high_resolution_clock::time_point startTime;
     };
-    std::queue<BatchRequestDesc> busyBatchRequests;
+    std::vector<BatchSlot> slots;
 
     std::size_t maxRequests = 0;
+    std::size_t postprocessingThreadsNum = 1;
+
+    SpscRing<std::size_t> idleSlots;  // filled by the postprocessing threads, taken by the getter thread
+    std::mutex mtxIdleSlots;  // the postprocessing threads take it to be a single producer of idleSlots
+
+    // Completion callbacks of the requests queue their slots for a pool of postprocessing threads
+    std::vector<std::thread> postprocessingThreads;
+    std::mutex mtxCompletedSlots;
+    std::condition_variable condVarCompletedSlots;
+    std::deque<std::size_t> completedSlots;
+    bool isPostprocessingStopped = false;
+
+    // Batches complete in any order, so frames wait for the previous frames of their sources to be ready
+    struct SourceFrames {
+        int64_t nextSeqId = 0;
+        std::map<int64_t, std::shared_ptr<VideoFrame>> postponed;
+    };
+    std::mutex mtxReady;
+    std::condition_variable condVarReady;
+    std::map<std::size_t, SourceFrames> sourcesFrames;
+    std::vector<std::shared_ptr<VideoFrame>> readyFrames;
+    std::size_t startedBatches = 0;  // started and not postprocessed yet
+    bool isSubmissionFinished = false;
+    std::exception_ptr postprocessingException;
 
     std::atomic_bool terminate = {false};
-    std::mutex mtxAvalableRequests;
-    std::mutex mtxBusyRequests;
-    std::condition_variable condVarAvailableRequests;
-    std::condition_variable condVarBusyRequests;
+    cv::Size frameSize;
 
     using GetterFunc = std::function<bool(VideoFrame&)>;
     GetterFunc getter;
     using PostprocessingFunc = std::function<std::vector<Detections>(InferenceEngine::InferRequest::Ptr, const std::vector<std::string>&, cv::Size)>;
     PostprocessingFunc postprocessing;
+    std::function<void(const std::vector<std::shared_ptr<VideoFrame>>&)> chainedStage;
     using PostLoadFunc = std::function<void (const std::vector<std::string>&, InferenceEngine::CNNNetwork&)>;
     PostLoadFunc postLoad;
     std::thread getterThread;
 
+    // With maxBatchWaitTime frames are read in a separate thread, so a batch can be sent without waiting for all of them
+    std::thread readerThread;
+    std::mutex mtxReadFrames;
+    std::condition_variable condVarReadFrames;
+    std::deque<std::shared_ptr<VideoFrame>> readFrames;
+    bool isReadingFinished = false;
+
+    std::atomic<uint64_t> submittedBatches = {0};
+    std::atomic<uint64_t> submittedFrames = {0};
+
+    bool isDynamicBatch() const {return maxBatchWaitTime.count() > 0 && batchSize > 1;}
+    void postprocessingLoop();
+    void releaseFrames(std::vector<std::shared_ptr<VideoFrame>>& vframes, const std::vector<int64_t>& seqIds,
+                       std::chrono::high_resolution_clock::time_point startTime,
+                       std::chrono::high_resolution_clock::time_point endTime);
+    void startReader();
+    bool collectBatch(std::vector<std::shared_ptr<VideoFrame>>& vframes);
+
     void initNetwork(const std::string& deviceName);
 
 public:
     struct InitParams {
         std::size_t batchSize = 1;
+        // If not zero, a batch is sent with the frames read by this time since the first of them,
+        // the device has to support dynamic batching then
+        std::chrono::milliseconds maxBatchWaitTime{0};
         std::size_t maxRequests = 5;
+        std::size_t postprocessingThreads = 2;
         bool collectStats = false;
         bool reportPerf = false;
         std::string modelPath;
         std::string cpuExtPath;
         std::string cldnnConfigPath;
         std::string deviceName;
+        // If not zero, the number of CPU plugin threads, e.g. the number of cores the demo is bound to
+        unsigned cpuThreadsNum = 0;
+        // If true, the .bin file of the model is mapped to memory and shared with other processes (see readNetwork)
+        bool mapWeights = false;
+        // Maximum number of rounds of all the requests inferring synthetic inputs after loading (see warmupRequests)
+        unsigned warmupRounds = 3;
         PostLoadFunc postLoadFunc = nullptr;
     };
 
     explicit IEGraph(const InitParams& p);
 
-    void start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc);
+    using ChainedStageFunc = std::function<void(const std::vector<std::shared_ptr<VideoFrame>>&)>;
+
+    // frameSize is passed to postprocessingFunc.
+    // chainedStageFunc is optional, it gets the frames of every batch after postprocessingFunc set their detections
+    // and before they are ready, e.g. to run RoiStage on the detected objects
+    void start(GetterFunc getterFunc, PostprocessingFunc postprocessingFunc, cv::Size frameSize,
+               ChainedStageFunc chainedStageFunc = nullptr);
 
     bool isRunning();
 
     InferenceEngine::SizeVector getInputDims() const;
 
-    std::vector<std::shared_ptr<VideoFrame>> getBatchData(cv::Size windowSize);
+    // Returns postprocessed frames, the frames of every source are in the order they were read.
+    // The frames of a batch can be returned with the ones of other batches or by parts. Empty result means stop
+    std::vector<std::shared_ptr<VideoFrame>> getBatchData();
 
     unsigned int getBatchSize() const;
 
+    // Returns the VADisplay the network is loaded on, it's null unless the device is GPU and hardware decoding
+    // is built. It's passed to VideoSources::InitParams::vaDisplay
+    std::shared_ptr<void> getVaDisplay() const {return vaDisplay;}
+
     void setDetectionConfidence(float conf);
 
     ~IEGraph();
@@ -105,6 +177,9 @@ public:
     struct Stats {
         float preprocessTime;
         float inferTime;
+        float inferTimeP99;
+        float inferTimeMax;
+        float batchFillRatio;  // mean part of batch slots filled with frames
     };
 
     Stats getStats() const;
@@ -4,6 +4,7 @@
 
 #include "input.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -13,11 +14,15 @@
 #include <utility>
 
 #include <samples/args_helper.hpp>
+#include <samples/frame_tracer.hpp>
 #include <samples/images_capture.h>
+#include <samples/slog.hpp>
 
 #include "perf_timer.hpp"
 
 #include "decoder.hpp"
+#include "frame_pool.hpp"
+#include "shm_frames.hpp"
 #include "threading.hpp"
 
 #ifdef USE_NATIVE_CAMERA_API
@@ -43,9 +48,33 @@ public:
 
     virtual bool read(VideoFrame& frame) = 0;
 
-    virtual float getAvgReadTime() const = 0;
+    // Whether read() returns without waiting. Sources reading in the calling thread are always ready
+    virtual bool isReady() {
+        return true;
+    }
+
+    virtual PerfTimer::Statistics getReadTimeStatistics() const = 0;
+
+    // Limits the number of frames read ahead to at most the queue size the source was created with. The sources
+    // whose buffers are allocated at once, such as hardware decoded and native camera ones, keep their queues
+    virtual void setQueueLimit(size_t /*limit*/) {}
 
     virtual ~VideoSource();
+
+    // The callback is called when the source gets a frame or stops, without the locks of the source held
+    void setReadyCallback(std::function<void()> callback) {
+        readyCallback = std::move(callback);
+    }
+
+protected:
+    void notifyReady() {
+        if (readyCallback) {
+            readyCallback();
+        }
+    }
+
+private:
+    std::function<void()> readyCallback;
 };
 
 VideoSource::~VideoSource() {}
@@ -202,7 +231,7 @@ public:
                             }
                             is_decoding = false;
                             condVar.notify_one();
-                        });
+                        }, this);
                         stream.advance_frame();
                     }
 
@@ -212,6 +241,7 @@ public:
                     });
                 }
                 hasFrame.notify_one();
+                notifyReady();
             }
         });
     }
@@ -224,6 +254,11 @@ public:
         }
     }
 
+    bool isReady() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !frameQueue.empty() || !running;
+    }
+
     bool read(VideoFrame& frame) override {
         queue_elem_t elem;
 
@@ -244,8 +279,8 @@ public:
         return elem.first && running;
     }
 
-    float getAvgReadTime() const override {
-        return perfTimer.getValue();
+    PerfTimer::Statistics getReadTimeStatistics() const override {
+        return perfTimer.getStatistics();
     }
 };
 
@@ -267,8 +302,11 @@ class GeneralCaptureSource : public VideoSource {
     bool realFps;
 
     const size_t queueSize;
+    std::atomic<size_t> queueLimit;
     const size_t pollingTimeMSec;
 
+    FramePool framePool;  // async reading decodes into these buffers
+
     template<bool CollectStats>
     cv::Mat readFrame();
 
@@ -290,10 +328,14 @@ public:
     bool read(cv::Mat& frame);
     bool read(VideoFrame& frame) override;
 
-    float getAvgReadTime() const override {
-        return perfTimer.getValue();
+    bool isReady() override;
+
+    PerfTimer::Statistics getReadTimeStatistics() const override {
+        return perfTimer.getStatistics();
     }
 
+    void setQueueLimit(size_t limit) override;
+
 private:
     template<bool CollectStats>
     static void thread_fn(GeneralCaptureSource*);
@@ -322,6 +364,7 @@ class VideoSourceNative : public VideoSource {
     void frameHandler(mcam::camera::frame_status status,
                       const mcam::camera::settings& settings,
                       mcam::camera::frame frame);
+    void pushFrame(cv::Mat&& img);
 
 public:
     VideoSourceNative(VideoSources& p, mcam::controller& ctrl,
@@ -336,8 +379,13 @@ public:
 
     bool read(VideoFrame& frame) override;
 
-    float getAvgReadTime() const override {
-        return perfTimer.getValue();
+    bool isReady() override {
+        // Without realFps the latest frame is repeated while the queue is empty
+        return !realFps || !frameQueue.empty();
+    }
+
+    PerfTimer::Statistics getReadTimeStatistics() const override {
+        return perfTimer.getStatistics();
     }
 };
 
@@ -374,12 +422,29 @@ void VideoSourceNative::frameHandler(mcam::camera::frame_status status,
                   mcam::camera::frame frame) {
     if (status == mcam::camera::frame_status::ok) {
         if (frameQueue.size() < queueSize) {
-            (void)settings;
-            assert(mcam::make_4cc('M', 'J', 'P', 'G') ==
-                   settings.format4cc);
             assert(frame.valid());
-            auto data = frame.data();
+            auto data = const_cast<void*>(frame.data());
             auto size = frame.size();
+            const int width = static_cast<int>(settings.width);
+            const int height = static_cast<int>(settings.height);
+
+            // Raw frames are converted straight from the camera buffer
+            if (mcam::make_4cc('Y', 'U', 'Y', 'V') == settings.format4cc) {
+                cv::Mat img;
+                cv::cvtColor(cv::Mat(height, width, CV_8UC2, data, settings.bytes_per_line),
+                             img, cv::COLOR_YUV2BGR_YUYV);
+                pushFrame(std::move(img));
+                return;
+            }
+            if (mcam::make_4cc('N', 'V', '1', '2') == settings.format4cc) {
+                cv::Mat img;
+                cv::cvtColor(cv::Mat(height * 3 / 2, width, CV_8UC1, data, settings.bytes_per_line),
+                             img, cv::COLOR_YUV2BGR_NV12);
+                pushFrame(std::move(img));
+                return;
+            }
+            assert(mcam::make_4cc('M', 'J', 'P', 'G') ==
+                   settings.format4cc);
 
             std::unique_lock<std::mutex> lock(parent.decode_mutex);
 
@@ -387,21 +452,26 @@ void VideoSourceNative::frameHandler(mcam::camera::frame_status status,
                         data, size, settings.width, settings.height,
             [this, fr = std::move(frame)](cv::Mat&& img) mutable {
                 fr = {};
-                bool success = !img.empty();
-                frameQueue.push({success, std::move(img)});
-                if (perfTimer.enabled()) {
-                    auto prev = lastFrameTime;
-                    auto current = clock::now();
-                    using dur = decltype (prev.time_since_epoch());
-                    if (dur::zero() != prev.time_since_epoch()) {
-                        perfTimer.addValue(current - prev);
-                    }
+                pushFrame(std::move(img));
+            }, this);
+        }
+    }
+}
 
-                    lastFrameTime = current;
-                }
-            });
+void VideoSourceNative::pushFrame(cv::Mat&& img) {
+    bool success = !img.empty();
+    frameQueue.push({success, std::move(img)});
+    if (perfTimer.enabled()) {
+        auto prev = lastFrameTime;
+        auto current = clock::now();
+        using dur = decltype (prev.time_since_epoch());
+        if (dur::zero() != prev.time_since_epoch()) {
+            perfTimer.addValue(current - prev);
         }
+
+        lastFrameTime = current;
     }
+    notifyReady();
 }
 
 bool VideoSourceNative::read(VideoFrame& frame) {
@@ -442,12 +512,16 @@ bool isNumeric(const std::string& str) {
 
 template<bool CollectStats>
 cv::Mat GeneralCaptureSource::readFrame() {
+    // The frame shares the pooled buffer, so it's reused only after the frame and its copies are released
+    cv::Mat& buffer = framePool.acquire();
     if (CollectStats) {
         ScopedTimer st(perfTimer);
-        return cap->read();
+        cap->readInto(buffer);
     } else {
-        return cap->read();
+        cap->readInto(buffer);
     }
+    framePool.prefill(buffer);
+    return buffer;
 }
 
 GeneralCaptureSource::GeneralCaptureSource(bool async, bool collectStats_,
@@ -455,10 +529,19 @@ GeneralCaptureSource::GeneralCaptureSource(bool async, bool collectStats_,
                          size_t pollingTimeMSec_, bool realFps_):
     perfTimer(collectStats_ ? PerfTimer::DefaultIterationsCount : 0),
     isAsync(async),
-    cap(openImagesCapture(name, loopVideo)),
+    // Video files are decoded with the same hardware as MJPEG cameras if it's enabled.
+    // Async source reads in its own thread already, so the capture doesn't need to prefetch.
+    cap(openImagesCapture(name, loopVideo, 0, std::numeric_limits<size_t>::max(), {1280, 720},
+#if defined(USE_LIBVA)
+        async ? 0 : 4, 0, VideoDecodeMode::Hardware)),
+#else
+        async ? 0 : 4)),
+#endif
     realFps(realFps_),
     queueSize(queueSize_),
-    pollingTimeMSec(pollingTimeMSec_) {}
+    queueLimit(queueSize_),
+    pollingTimeMSec(pollingTimeMSec_),
+    framePool(queueSize_ + 1) {}
 
 GeneralCaptureSource::~GeneralCaptureSource() {
     stop();
@@ -470,18 +553,29 @@ bool GeneralCaptureSource::isRunning() const {
 
 template<bool CollectStats>
 void GeneralCaptureSource::thread_fn(GeneralCaptureSource *vs) {
+    FRAME_TRACE_THREAD_NAME("Decode");
+    size_t poolLimit = vs->queueSize;
     while (vs->running) {
+        // The pool is changed by the thread acquiring its buffers only
+        if (poolLimit != vs->queueLimit) {
+            poolLimit = vs->queueLimit;
+            vs->framePool.setReservedSize(poolLimit + 1);
+        }
+        FRAME_TRACE_BEGIN("Decode", -1, -1);
         cv::Mat frame = vs->readFrame<CollectStats>();
+        FRAME_TRACE_END("Decode", -1, -1);
         const bool result = frame.data;
         if (!result) {
             vs->running = false; // stop() also affects running, so override it only when out of frames
         }
         std::unique_lock<std::mutex> lock(vs->mutex);
         vs->condVar.wait(lock, [&]() {
-            return vs->queue.size() < vs->queueSize || !vs->running; // queue has space or source ran out of frames
+            return vs->queue.size() < vs->queueLimit || !vs->running; // queue has space or source ran out of frames
         });
         vs->queue.push({result, frame});
         vs->hasFrame.notify_one();
+        lock.unlock();
+        vs->notifyReady();
     }
 }
 
@@ -521,7 +615,7 @@ bool GeneralCaptureSource::read(cv::Mat& frame) {
             });
             res = queue.front().first;
             frame = queue.front().second;
-            if (realFps || queue.size() > 1 || queueSize == 1) {
+            if (realFps || queue.size() > 1 || queueLimit == 1) {
                 queue.pop();
             }
         }
@@ -537,20 +631,214 @@ bool GeneralCaptureSource::read(VideoFrame& frame) {
     return read(frame.frame);
 }
 
+void GeneralCaptureSource::setQueueLimit(size_t limit) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queueLimit = std::max<size_t>(1, std::min(limit, queueSize));
+    }
+    condVar.notify_one();
+}
+
+bool GeneralCaptureSource::isReady() {
+    if (!isAsync) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return !queue.empty() || !running;
+}
+
+// Hands out the frames of a synthetic input (see openImagesCapture()) in the calling thread. The frames are shared
+// with the ring of the capture already, so unlike GeneralCaptureSource there is no thread or frame pool to copy them
+class VideoSourceSynthetic : public VideoSource {
+    std::unique_ptr<ImagesCapture> cap;
+    PerfTimer perfTimer;
+    std::atomic_bool running = {true};
+
+public:
+    VideoSourceSynthetic(const std::string& name, bool collectStats_):
+        cap(openImagesCapture(name, true)),
+        perfTimer(collectStats_ ? PerfTimer::DefaultIterationsCount : 0) {}
+
+    bool isRunning() const override {
+        return running;
+    }
+
+    void start() override {}
+
+    bool read(VideoFrame& frame) override {
+        if (perfTimer.enabled()) {
+            ScopedTimer st(perfTimer);
+            frame.frame = cap->read();
+        } else {
+            frame.frame = cap->read();
+        }
+        return frame.frame.data;
+    }
+
+    PerfTimer::Statistics getReadTimeStatistics() const override {
+        return perfTimer.getStatistics();
+    }
+};
+
+// Reads the latest frames of a shared memory ring which another process or PublishingSource writes
+class VideoSourceShm : public VideoSource {
+    std::unique_ptr<ShmFrameRing> ring;
+    FramePool framePool;
+    PerfTimer perfTimer;
+    std::atomic_bool running = {true};
+    uint64_t lastSeq = 0;
+    const std::chrono::milliseconds pollingTime;
+
+public:
+    VideoSourceShm(std::unique_ptr<ShmFrameRing> ring_, bool collectStats_, size_t queueSize_,
+                   size_t pollingTimeMSec_):
+        ring(std::move(ring_)),
+        framePool(queueSize_ + 1),
+        perfTimer(collectStats_ ? PerfTimer::DefaultIterationsCount : 0),
+        pollingTime(pollingTimeMSec_) {}
+
+    bool isRunning() const override {
+        return running;
+    }
+
+    void start() override {}
+
+    bool read(VideoFrame& frame) override {
+        // The ring is copied into a local buffer, so the writer doesn't wait for the frame to be released
+        cv::Mat& buffer = framePool.acquire();
+        int64_t publishedId = 0;
+        ShmFrameRing::ReadStatus status = ShmFrameRing::ReadStatus::Timeout;
+        while (ShmFrameRing::ReadStatus::Timeout == status && running) {
+            if (perfTimer.enabled()) {
+                ScopedTimer st(perfTimer);
+                status = ring->read(buffer, publishedId, lastSeq, pollingTime);
+            } else {
+                status = ring->read(buffer, publishedId, lastSeq, pollingTime);
+            }
+        }
+        if (ShmFrameRing::ReadStatus::Frame != status) {
+            running = false;
+            return false;
+        }
+        framePool.prefill(buffer);
+        frame.frame = buffer;
+        return true;
+    }
+
+    PerfTimer::Statistics getReadTimeStatistics() const override {
+        return perfTimer.getStatistics();
+    }
+};
+
+// Publishes the frames of a source to a shared memory ring for other processes and reads them back from the ring,
+// so the frames are decoded once for all of the processes
+class PublishingSource : public VideoSource {
+    std::unique_ptr<VideoSource> source;
+    const std::string ringName;
+    const bool collectStats;
+    const size_t queueSize;
+    const size_t pollingTimeMSec;
+
+    std::unique_ptr<ShmFrameRing> ring;
+    std::unique_ptr<VideoSourceShm> reader;
+    cv::Size firstFrameSize;
+    std::atomic_bool running = {true};
+    std::thread workThread;
+
+    void publish(const cv::Mat& frame, int64_t frameId) {
+        if (frame.total() * frame.elemSize() > ring->maxFrameBytes()) {
+            // The ring is sized by the first frame, e.g. images of a folder can differ
+            cv::Mat resized;
+            cv::resize(frame, resized, firstFrameSize);
+            ring->publish(resized, frameId);
+        } else {
+            ring->publish(frame, frameId);
+        }
+    }
+
+public:
+    PublishingSource(std::unique_ptr<VideoSource> source_, const std::string& ringName_, bool collectStats_,
+                     size_t queueSize_, size_t pollingTimeMSec_):
+        source(std::move(source_)),
+        ringName(ringName_),
+        collectStats(collectStats_),
+        queueSize(queueSize_),
+        pollingTimeMSec(pollingTimeMSec_) {}
+
+    ~PublishingSource() override {
+        running = false;
+        if (workThread.joinable()) {
+            workThread.join();
+        }
+    }
+
+    bool isRunning() const override {
+        return !reader || reader->isRunning();
+    }
+
+    void start() override {
+        source->start();
+        VideoFrame first;
+        if (!source->read(first) || first.frame.empty()) {
+            throw std::runtime_error("Can't read the first frame to publish to /" + ringName);
+        }
+        firstFrameSize = first.frame.size();
+        const size_t slotsNum = 4;  // readers hold a slot only while they copy the frame
+        ring = ShmFrameRing::create(ringName, slotsNum, first.frame.total() * first.frame.elemSize());
+        reader.reset(new VideoSourceShm(ShmFrameRing::attach(ringName, std::chrono::milliseconds(0)),
+                                        collectStats, queueSize, pollingTimeMSec));
+        slog::info << "Publishing frames to shared memory /" << ringName << slog::endl;
+        publish(first.frame, 0);
+        workThread = std::thread([this]() {
+            FRAME_TRACE_THREAD_NAME("Publish");
+            for (int64_t frameId = 1; running; ++frameId) {
+                VideoFrame frame;
+                if (!source->read(frame) || frame.frame.empty()) {
+                    break;
+                }
+                publish(frame.frame, frameId);
+            }
+            ring->close();
+        });
+    }
+
+    bool read(VideoFrame& frame) override {
+        return reader->read(frame);
+    }
+
+    bool isReady() override {
+        return !reader || reader->isReady();
+    }
+
+    PerfTimer::Statistics getReadTimeStatistics() const override {
+        return source->getReadTimeStatistics();
+    }
+
+    void setQueueLimit(size_t limit) override {
+        source->setQueueLimit(limit);
+    }
+};
+
 namespace {
 Decoder::Settings makeDecoderSettings(bool collectStats, std::size_t queueSize,
-                                      unsigned width, unsigned height) {
+                                      unsigned width, unsigned height,
+                                      const std::shared_ptr<void>& vaDisplay) {
     Decoder::Settings ret = {};
 #if defined(USE_LIBVA)
     ret.mode = Decoder::Mode::Hw;
     ret.num_buffers = static_cast<unsigned>(queueSize);
-    ret.output_width = width;
-    ret.output_height = height;
+    ret.va_display = vaDisplay;
 #elif defined(USE_TBB)
     ret.mode = Decoder::Mode::Async;
+    ret.max_in_flight = static_cast<unsigned>(queueSize);
 #else
     ret.mode = Decoder::Mode::Immediate;
 #endif
+#ifndef USE_LIBVA
+    (void)vaDisplay;
+#endif
+    ret.output_width = width;
+    ret.output_height = height;
     ret.collect_stats = collectStats;
     return ret;
 }
@@ -558,14 +846,35 @@ Decoder::Settings makeDecoderSettings(bool collectStats, std::size_t queueSize,
 
 VideoSources::VideoSources(const InitParams& p):
     decoder(makeDecoderSettings(p.collectStats, p.queueSize, p.expectedWidth,
-                                p.expectedHeight)),
+                                p.expectedHeight, p.vaDisplay)),
+#ifdef USE_NATIVE_CAMERA_API
+    controller(p.nativeCameraThreads),
+#endif
     isAsync(p.isAsync),
     collectStats(p.collectStats),
-    realFps(p.realFps),
+    // A published input is read once per frame instead of repeating the latest one
+    realFps(p.realFps || !p.publishName.empty()),
     queueSize(p.queueSize),
     pollingTimeMSec(p.pollingTimeMSec) {
         for (const std::string& input : split(p.inputs, ','))
             openVideo(input, isNumeric(input), p.loop);
+        if (!p.publishName.empty()) {
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                inputs[i].reset(new PublishingSource(std::move(inputs[i]), p.publishName + "_" + std::to_string(i),
+                                                     collectStats, queueSize, pollingTimeMSec));
+            }
+        }
+        framesRead.resize(inputs.size());
+        readyInputs.resize(inputs.size());
+        for (auto& input : inputs) {
+            input->setReadyCallback([this]() {
+                {
+                    // Taking the mutex orders the notification after the check of the waiting thread
+                    std::lock_guard<std::mutex> lock(readyMutex);
+                }
+                readyCondVar.notify_all();
+            });
+        }
     }
 
 VideoSources::~VideoSources() {
@@ -580,6 +889,20 @@ bool VideoSources::isRunning() const {
 }
 
 void VideoSources::openVideo(const std::string& source, bool native, bool loopVideo) {
+    const std::string shmPrefix = "shm://";
+    if (0 == source.compare(0, shmPrefix.size(), shmPrefix)) {
+        // The writer may start a bit later than the readers
+        const std::chrono::seconds attachTimeout(10);
+        inputs.emplace_back(new VideoSourceShm(ShmFrameRing::attach(source.substr(shmPrefix.size()), attachTimeout),
+                                               collectStats, queueSize, pollingTimeMSec));
+        return;
+    }
+    cv::Size syntheticSize;
+    double syntheticFps;
+    if (parseSyntheticInput(source, syntheticSize, syntheticFps)) {
+        inputs.emplace_back(new VideoSourceSynthetic(source, collectStats));
+        return;
+    }
 #ifdef USE_NATIVE_CAMERA_API
     if (native) {
         std::string dev;
@@ -589,7 +912,8 @@ void VideoSources::openVideo(const std::string& source, bool native, bool loopVi
             dev = source;
         }
         mcam::camera::settings camSettings;
-        camSettings.format4cc = mcam::make_4cc('M', 'J', 'P', 'G');
+        camSettings.format4cc = 0;  // raw formats are preferred, MJPG is decoded
+        camSettings.io = mcam::camera::settings::memory::mmap;
         camSettings.width = 640;
         camSettings.height = 480;
         camSettings.num_buffers = static_cast<unsigned>(queueSize);
@@ -629,18 +953,64 @@ void VideoSources::start() {
 bool VideoSources::getFrame(size_t index, VideoFrame& frame) {
     if (inputs.size() > 0) {
         if (index < inputs.size()) {
+            frame.frameId = framesRead[index]++;
+            // sourceIdx is set by the caller and distinguishes duplicated inputs
+            FRAME_TRACE_SCOPE("Get frame", frame.frameId, static_cast<int64_t>(frame.sourceIdx));
+            FRAME_TRACE_FLOW(frame.frameId, static_cast<int64_t>(frame.sourceIdx));
             return inputs[index]->read(frame);
         }
     }
     return false;
 }
 
+bool VideoSources::getAnyFrame(VideoFrame& frame, const InputPicker& pick) {
+    if (inputs.empty()) {
+        return false;
+    }
+    size_t index = 0;
+    {
+        std::unique_lock<std::mutex> lock(readyMutex);
+        readyCondVar.wait(lock, [&]() {
+            bool anyReady = false;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                readyInputs[i] = inputs[i]->isReady();
+                anyReady = anyReady || readyInputs[i];
+            }
+            return anyReady;
+        });
+        if (pick) {
+            index = pick(readyInputs);
+        } else {
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                index = (nextInput + i) % inputs.size();
+                if (readyInputs[index]) {
+                    break;
+                }
+            }
+            nextInput = index + 1;
+            frame.sourceIdx = index;
+        }
+    }
+    return getFrame(index, frame);
+}
+
+void VideoSources::setQueueSize(size_t size) {
+    for (auto& input : inputs) {
+        input->setQueueLimit(size);
+    }
+}
+
 VideoSources::Stats VideoSources::getStats() const {
     Stats ret;
     if (collectStats) {
         ret.readTimes.reserve(inputs.size());
+        ret.readTimesP99.reserve(inputs.size());
+        ret.readTimesMax.reserve(inputs.size());
         for (auto& input : inputs) {
-            ret.readTimes.push_back(input->getAvgReadTime());
+            PerfTimer::Statistics readTime = input->getReadTimeStatistics();
+            ret.readTimes.push_back(readTime.mean);
+            ret.readTimesP99.push_back(readTime.p99);
+            ret.readTimesMax.push_back(readTime.max);
         }
         ret.decodingLatency = decoder.getStats().decoding_latency;
     }
@@ -4,16 +4,19 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 #include <queue>
 #include <string>
 
 #include <opencv2/opencv.hpp>
+#include <samples/frame_tracer.hpp>
 
 #ifdef USE_NATIVE_CAMERA_API
 #include "multicam/controller.hpp"
@@ -37,12 +40,24 @@ class VideoFrame final {
 public:
     cv::Mat frame;
     std::size_t sourceIdx = 0;
+    int64_t frameId = 0;  // number of the frame read from the source
     Detections detections;
     VideoFrame() = default;
 
     VideoFrame& operator =(VideoFrame const& vf) = delete;
 };
 
+// Connects the frames to the current slice of the frame trace
+inline void traceFrameFlows(const std::vector<std::shared_ptr<VideoFrame>>& vframes) {
+#ifdef OMZ_FRAME_TRACE
+    for (const std::shared_ptr<VideoFrame>& vframe : vframes) {
+        FRAME_TRACE_FLOW(vframe->frameId, static_cast<int64_t>(vframe->sourceIdx));
+    }
+#else
+    (void)vframes;
+#endif
+}
+
 class VideoSource;
 
 class VideoSources {
@@ -55,6 +70,7 @@ private:
     std::mutex decode_mutex;  // hardware decoding enqueue lock
 
     std::vector<std::unique_ptr<VideoSource>> inputs;
+    std::vector<int64_t> framesRead;
     const bool isAsync;
     const bool collectStats;
 
@@ -63,6 +79,12 @@ private:
     const size_t queueSize = 1;
     const size_t pollingTimeMSec = 1000;
 
+    // The sources notify about their frames, so getAnyFrame() sleeps until one of them has a frame
+    std::mutex readyMutex;
+    std::condition_variable readyCondVar;
+    std::vector<bool> readyInputs;
+    size_t nextInput = 0;
+
     void openVideo(const std::string& source, bool native, bool loopVideo);
     void stop();
 
@@ -77,6 +99,12 @@ public:
         bool realFps = false;
         unsigned expectedWidth = 0;
         unsigned expectedHeight = 0;
+        unsigned nativeCameraThreads = 1;  // cameras are read by this number of threads
+        // If not empty, the frames of input i are published to shared memory /<publishName>_<i>, which other
+        // processes read as input shm://<publishName>_<i>
+        std::string publishName;
+        // Hardware decoding works on this VADisplay if it isn't null, e.g. on the one of the GPU inference
+        std::shared_ptr<void> vaDisplay;
     };
 
     explicit VideoSources(const InitParams& p);
@@ -88,8 +116,22 @@ public:
 
     bool getFrame(size_t index, VideoFrame& frame);
 
+    // Chooses the input to read among the ready ones, readyInputs has an element for every input
+    using InputPicker = std::function<size_t(const std::vector<bool>& readyInputs)>;
+
+    // Waits until any of the inputs has a frame and reads it. Without the picker the ready inputs are taken in turn
+    // and frame.sourceIdx is set to the index of the input, otherwise the picker sets it. Inputs which can't tell
+    // whether they have a frame, such as shared memory ones, are considered ready
+    bool getAnyFrame(VideoFrame& frame, const InputPicker& pick = nullptr);
+
+    // Shortens the frame queues of the inputs to size frames or lengthens them back up to InitParams::queueSize,
+    // the memory of the frames which don't fit is released. Inputs which allocate their buffers at once keep them
+    void setQueueSize(size_t size);
+
     struct Stats {
         std::vector<float> readTimes;
+        std::vector<float> readTimesP99;
+        std::vector<float> readTimesMax;
         float decodingLatency = 0.0f;
     };
 
@@ -0,0 +1,40 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "mosaic.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+Mosaic::Mosaic(cv::Size canvasSize, std::vector<cv::Point> tilePositions, cv::Size tileSize):
+    canvas(cv::Mat::zeros(canvasSize, CV_8UC3)),
+    tilePositions(std::move(tilePositions)),
+    tileSize(tileSize),
+    shownFrames(this->tilePositions.size()) {}
+
+void Mosaic::render(const std::vector<std::shared_ptr<VideoFrame>>& frames, const DrawTileFunc& drawTile,
+                    cv::Mat& output) {
+    for (const std::shared_ptr<VideoFrame>& frame : frames) {
+        if (frame->sourceIdx >= tilePositions.size()) {
+            throw std::logic_error("Cannot display source " + std::to_string(frame->sourceIdx) + " in a mosaic with "
+                + std::to_string(tilePositions.size()) + " tiles");
+        }
+        // The frame is kept until the next frame of its source replaces it, so a pointer identifies it
+        std::shared_ptr<VideoFrame>& shownFrame = shownFrames[frame->sourceIdx];
+        if (shownFrame == frame) {
+            continue;
+        }
+        shownFrame = frame;
+        if (frame->frame.empty()) {
+            continue;
+        }
+        cv::Mat tile = canvas(cv::Rect(tilePositions[frame->sourceIdx], tileSize));
+        cv::resize(frame->frame, tile, tileSize);
+        drawTile(tile, *frame);
+    }
+    canvas.copyTo(output);
+}
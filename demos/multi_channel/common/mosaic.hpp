@@ -0,0 +1,36 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "input.hpp"
+
+// Keeps tiles of the last shown frames on a persistent canvas. A tile is resized and drawn again only when a new
+// frame of its source arrives, so channels which are slower than the display don't cost anything.
+class Mosaic {
+public:
+    // Draws results of the frame over its tile, the tile already contains the resized frame
+    using DrawTileFunc = std::function<void(cv::Mat& tile, const VideoFrame& frame)>;
+
+    // Tile of VideoFrame::sourceIdx i is placed at tilePositions[i]
+    Mosaic(cv::Size canvasSize, std::vector<cv::Point> tilePositions, cv::Size tileSize);
+
+    // Redraws the tiles of frames which differ from the shown ones and copies the canvas to output. output keeps
+    // its buffer if it already has the canvas size, overlays are drawn over it then
+    void render(const std::vector<std::shared_ptr<VideoFrame>>& frames, const DrawTileFunc& drawTile,
+                cv::Mat& output);
+
+private:
+    cv::Mat canvas;
+    const std::vector<cv::Point> tilePositions;
+    const cv::Size tileSize;
+    std::vector<std::shared_ptr<VideoFrame>> shownFrames;
+};
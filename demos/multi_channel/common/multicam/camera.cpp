@@ -10,10 +10,12 @@
 #include <string>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <fcntl.h>
 #include <linux/videodev2.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -51,6 +53,33 @@ file_descriptor open_device(string_ref name) {
     return fd;
 }
 
+v4l2_memory to_v4l2_memory(camera::settings::memory io) {
+    return camera::settings::memory::mmap == io ? V4L2_MEMORY_MMAP
+                                                : V4L2_MEMORY_USERPTR;
+}
+
+unsigned choose_format(const file_descriptor& fd) {
+    const unsigned preferred[] = {
+        make_4cc('N', 'V', '1', '2'),
+        make_4cc('Y', 'U', 'Y', 'V'),
+        make_4cc('M', 'J', 'P', 'G')
+    };
+    std::vector<unsigned> supported;
+    v4l2_fmtdesc desc = {};
+    desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    while (0 == xioctl(fd.get(), VIDIOC_ENUM_FMT, &desc)) {
+        supported.push_back(desc.pixelformat);
+        ++desc.index;
+    }
+    for (auto format : preferred) {
+        if (supported.end() !=
+            std::find(supported.begin(), supported.end(), format)) {
+            return format;
+        }
+    }
+    throw_error("camera doesn't support NV12, YUYV or MJPG formats");
+}
+
 void set_device_params(const file_descriptor& fd, camera::settings& params,
                        std::size_t& frame_buffer_size) {
     v4l2_capability cap = {};
@@ -71,6 +100,10 @@ void set_device_params(const file_descriptor& fd, camera::settings& params,
 
 //    v4l2_cropcap cropcap = {};
 
+    if (0 == params.format4cc) {
+        params.format4cc = choose_format(fd);
+    }
+
     v4l2_format fmt = {};
     fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     fmt.fmt.pix.width       = params.width;
@@ -84,6 +117,7 @@ void set_device_params(const file_descriptor& fd, camera::settings& params,
     params.width     = fmt.fmt.pix.width;
     params.height    = fmt.fmt.pix.height;
     params.format4cc = fmt.fmt.pix.pixelformat;
+    params.bytes_per_line = fmt.fmt.pix.bytesperline;
 
     if (0 != params.frametime_numerator ||
         0 != params.frametime_denominator) {
@@ -122,42 +156,79 @@ camera::camera(controller& owner_, string_ref name_, callback_t callback_,
 
 camera::~camera() {
     owner.unregister_camera(*this);
+    stop_capture();
+    for (auto& buff : buffers) {
+        if (nullptr == buff.user_ptr && nullptr != buff.ptr) {
+            munmap(buff.ptr, buff.length);
+        }
+    }
 }
 
 void camera::alloc_buffers() {
     assert(frame_buffer_size > 0);
     assert(params.num_buffers > 0);
     assert(dev.valid());
+    const bool is_mmap = settings::memory::mmap == params.io;
     v4l2_requestbuffers req = {};
 
     req.count  = params.num_buffers;
     req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_USERPTR;
+    req.memory = to_v4l2_memory(params.io);
 
     if (-1 == xioctl(dev.get(), VIDIOC_REQBUFS, &req)) {
         if (EINVAL == errno) {
-            throw_error("User pointer i/o not supported");
+            throw_error(is_mmap ? "Memory mapping i/o not supported"
+                                : "User pointer i/o not supported");
         } else {
-            throw_errno_error("Unable to setup user pointer i/o mode:", errno);
+            throw_errno_error(is_mmap ? "Unable to setup memory mapping i/o mode:"
+                                      : "Unable to setup user pointer i/o mode:", errno);
         }
     }
+    if (0 == req.count) {
+        throw_error("No frame buffers allocated");
+    }
     params.num_buffers = req.count;
 
-    buffers.clear();
     const auto count = params.num_buffers;
-    buffers.reserve(count);
-    for (unsigned i = 0 ; i < count; ++i) {
-        std::unique_ptr<char[]> buff(new char[frame_buffer_size]);
-        buffers.emplace_back(std::move(buff));
-    }
-
+    // Buffers are created in place: the vector must not reallocate mapped
+    // memory and descriptors owned by its elements
+    buffers.clear();
+    buffers = std::vector<buffer>(count);
     for (unsigned i = 0 ; i < count; ++i) {
+        auto& buff = buffers[i];
         v4l2_buffer buf = {};
         buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_USERPTR;
+        buf.memory = req.memory;
         buf.index = i;
-        buf.m.userptr = reinterpret_cast<unsigned long>(buffers[i].get());
-        buf.length = static_cast<__u32>(frame_buffer_size);
+        if (is_mmap) {
+            if (-1 == xioctl(dev.get(), VIDIOC_QUERYBUF, &buf)) {
+                throw_errno_error("Unable to query frame buffer:", errno);
+            }
+            void* ptr = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE,
+                             MAP_SHARED, dev.get(), buf.m.offset);
+            if (MAP_FAILED == ptr) {
+                throw_errno_error("Unable to map frame buffer:", errno);
+            }
+            buff.ptr = ptr;
+            buff.length = buf.length;
+
+            if (params.export_dmabuf) {
+                v4l2_exportbuffer expbuf = {};
+                expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                expbuf.index = i;
+                expbuf.flags = O_RDONLY | O_CLOEXEC;
+                if (-1 == xioctl(dev.get(), VIDIOC_EXPBUF, &expbuf)) {
+                    throw_errno_error("Unable to export frame buffer:", errno);
+                }
+                buff.dmabuf = file_descriptor(expbuf.fd);
+            }
+        } else {
+            buff.user_ptr.reset(new char[frame_buffer_size]);
+            buff.ptr = buff.user_ptr.get();
+            buff.length = frame_buffer_size;
+            buf.m.userptr = reinterpret_cast<unsigned long>(buff.ptr);
+            buf.length = static_cast<__u32>(frame_buffer_size);
+        }
 
         if (-1 == xioctl(dev.get(), VIDIOC_QBUF, &buf)) {
             throw_errno_error("Unable to enqueue frame buffer ptr:", errno);
@@ -173,13 +244,20 @@ void camera::start_capture() {
     }
 }
 
+void camera::stop_capture() {
+    assert(dev.valid());
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    // Called from the destructor, so the failure isn't reported
+    xioctl(dev.get(), VIDIOC_STREAMOFF, &type);
+}
+
 void camera::read_frame() {
     assert(dev.valid());
     assert(nullptr != callback);
     while (true) {
         v4l2_buffer buf = {};
         buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_USERPTR;
+        buf.memory = to_v4l2_memory(params.io);
         if (-1 == xioctl(dev.get(), VIDIOC_DQBUF, &buf)) {
             switch (errno) {
             case EAGAIN:
@@ -194,7 +272,19 @@ void camera::read_frame() {
                 throw_errno_error("Unable to get frame buffer ptr:", errno);
             }
         }
-        auto ptr = reinterpret_cast<void*>(buf.m.userptr);
+        if (has_sequence) {
+            const std::uint32_t gap = buf.sequence - last_sequence - 1;
+            // Ignores reordered and restarted sequences
+            if (gap < 0x80000000u) {
+                frames_dropped += gap;
+            }
+        }
+        has_sequence = true;
+        last_sequence = buf.sequence;
+        ++frames_captured;
+
+        assert(buf.index < buffers.size());
+        auto ptr = buffers[buf.index].ptr;
         assert(nullptr != ptr);
         auto len = buf.bytesused;
         assert(len > 0);
@@ -202,13 +292,22 @@ void camera::read_frame() {
     }
 }
 
+camera::stats camera::get_stats() const {
+    stats ret;
+    ret.captured = frames_captured;
+    ret.dropped = frames_dropped;
+    return ret;
+}
+
 void camera::reclaim_frame(frame& f) {
     v4l2_buffer buf = {};
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_USERPTR;
+    buf.memory = to_v4l2_memory(params.io);
     buf.index = f.index;
-    buf.m.userptr = reinterpret_cast<unsigned long>(f.ptr);
-    buf.length = static_cast<__u32>(frame_buffer_size);
+    if (settings::memory::user_ptr == params.io) {
+        buf.m.userptr = reinterpret_cast<unsigned long>(f.ptr);
+        buf.length = static_cast<__u32>(frame_buffer_size);
+    }
 
     if (-1 == xioctl(dev.get(), VIDIOC_QBUF, &buf)) {
         throw_errno_error("Unable to enqueue frame buffer ptr:", errno);
@@ -256,4 +355,9 @@ std::size_t camera::frame::size() const {
     return len;
 }
 
+int camera::frame::dmabuf_fd() const {
+    assert(valid());
+    return cam->buffers[index].dmabuf.get();
+}
+
 }  // namespace mcam
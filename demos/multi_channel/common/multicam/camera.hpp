@@ -8,6 +8,8 @@
 
 #include <boost/intrusive/list.hpp>
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -20,9 +22,25 @@ class camera final {
 public:
     friend class ::mcam::controller;
     struct settings final {
+        enum class memory {
+            /// Frames are captured into buffers allocated by the application
+            user_ptr,
+            /// Frames are captured into driver buffers mapped to the application
+            mmap
+        };
+
         unsigned width = 0;
         unsigned height = 0;
+        /// 0 selects the first format the camera supports of NV12, YUYV
+        /// and MJPG, raw formats don't need decoding
         unsigned format4cc = 0;
+        /// Set by the camera
+        unsigned bytes_per_line = 0;
+
+        memory io = memory::user_ptr;
+        /// Export mmap buffers as DMABUF file descriptors, see
+        /// frame::dmabuf_fd()
+        bool export_dmabuf = false;
 
         /// Requested frame time (e.g. 1 / 60 for 60 fps)
         unsigned frametime_numerator = 0;
@@ -53,6 +71,9 @@ public:
 
         const void* data() const;
         std::size_t size() const;
+        /// DMABUF file descriptor of the frame buffer or -1 if it wasn't
+        /// exported. The descriptor is owned by the camera
+        int dmabuf_fd() const;
     };
     enum class frame_status {
         ok,
@@ -65,6 +86,16 @@ public:
            const settings& params_);
     ~camera();
 
+    struct stats final {
+        std::uint64_t captured = 0;
+        /// Frames the driver dropped because the consumer held all buffers
+        /// or the controller didn't read them in time
+        std::uint64_t dropped = 0;
+    };
+
+    /// Can be called from any thread
+    stats get_stats() const;
+
 private:
     friend class camera::frame;
     struct device {
@@ -75,6 +106,7 @@ private:
     };
 
     void alloc_buffers();
+    void stop_capture();
     void start_capture();
     void read_frame();
     void reclaim_frame(frame& f);
@@ -83,10 +115,23 @@ private:
     settings params;
     file_descriptor dev;
     std::size_t frame_buffer_size = 0;
-    std::vector<std::unique_ptr<char[]>> buffers;
+    struct buffer final {
+        std::unique_ptr<char[]> user_ptr;
+        void* ptr = nullptr;
+        std::size_t length = 0;
+        file_descriptor dmabuf;
+    };
+    std::vector<buffer> buffers;
     callback_t callback;
 
+    // Gaps in the sequence numbers of dequeued buffers are dropped frames
+    bool has_sequence = false;
+    std::uint32_t last_sequence = 0;
+    std::atomic<std::uint64_t> frames_captured = {0};
+    std::atomic<std::uint64_t> frames_dropped = {0};
+
     boost::intrusive::list_member_hook<> list_node;
+    std::size_t controller_shard = 0;
 };
 
 }  // namespace mcam
@@ -4,82 +4,157 @@
 
 #include "controller.hpp"
 
+#include <algorithm>
 #include <vector>
 
 #include "utils.hpp"
 
 #include <fcntl.h>
-#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <unistd.h>
 
 namespace mcam {
 namespace {
 using lock_guard = std::lock_guard<std::mutex>;
-}
 
-controller::controller() {
-    queue_thread = std::thread([this]() {
-        std::vector<pollfd> fds;
-        std::vector<camera*> temp_ptrs;
-        const auto poll_flags = POLLIN | POLLRDNORM | POLLERR;
-        while (!terminate) { {
-                lock_guard lock(list_mutex);
-                auto size = cameras.size() + 1;
-                if (fds.size() != size) {
-                    fds.clear();
-                    temp_ptrs.clear();
-                    fds.push_back(pollfd{notifier.get_fd_to_poll(), POLLIN, 0});
-                    for (auto& cam : cameras) {
-                        assert(cam.dev.valid());
-                        fds.push_back(pollfd{cam.dev.get(), poll_flags, 0});
-                        temp_ptrs.push_back(&cam);
-                    }
-                }
-            }
+/// Cores the calling thread may run on, e.g. the ones the process is bound to
+std::vector<unsigned> allowed_cores() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int err = pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (0 != err) {
+        throw_errno_error("Unable to get thread affinity:", err);
+    }
+    std::vector<unsigned> cores;
+    for (unsigned core = 0; core < CPU_SETSIZE; ++core) {
+        if (CPU_ISSET(core, &cpus)) {
+            cores.push_back(core);
+        }
+    }
+    return cores;
+}
 
-            if (-1 == poll(fds.data(), fds.size(), -1)) {
-                throw_errno_error("failed wait on poll:", errno);
-            }
+void pin_thread(std::thread& thread, unsigned core) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    int err = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+    if (0 != err) {
+        throw_errno_error("Unable to pin controller thread:", err);
+    }
+}
+}  // namespace
 
-            for (size_t i = 0; i < fds.size(); ++i) {
-                if (0 != (fds[i].revents & poll_flags)) {
-                    if (0 == i) {
-                        notifier.flush();
-                    } else {
-                        auto cam = temp_ptrs[i - 1];
-                        assert(nullptr != cam);
-                        cam->read_frame();
-                    }
-                }
-            }
+controller::controller(unsigned num_threads, bool pin_threads) {
+    num_threads = std::max(num_threads, 1u);
+    const std::vector<unsigned> cores = pin_threads ? allowed_cores() : std::vector<unsigned>();
+    for (unsigned i = 0; i < num_threads; ++i) {
+        shards.emplace_back(new shard);
+        shard& s = *shards.back();
+        s.thread = std::thread([this, &s]() {
+            s.run(terminate);
+        });
+        if (pin_threads) {
+            pin_thread(s.thread, cores[i % cores.size()]);
         }
-    });
+    }
 }
 
 controller::~controller() {
     terminate = true;
-    notifier.signal();
-    if (queue_thread.joinable()) {
-        queue_thread.join();
+    for (auto& s : shards) {
+        s->wakeup.signal();
+    }
+    for (auto& s : shards) {
+        if (s->thread.joinable()) {
+            s->thread.join();
+        }
     }
 }
 
 void controller::register_camera(camera& cam) {
+    assert(cam.dev.valid());
+    shard* target = nullptr;
     {
-        lock_guard lock(list_mutex);
-        cameras.push_back(cam);
+        lock_guard lock(shards_mutex);
+        std::size_t min_size = 0;
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            lock_guard list_lock(shards[i]->list_mutex);
+            if (nullptr == target || shards[i]->cameras.size() < min_size) {
+                target = shards[i].get();
+                cam.controller_shard = i;
+                min_size = target->cameras.size();
+            }
+        }
+    }
+    assert(nullptr != target);
+    lock_guard lock(target->list_mutex);
+    target->cameras.push_back(cam);
+    epoll_event event = {};
+    // Edge triggered: camera::read_frame() dequeues frames until EAGAIN
+    event.events = EPOLLIN | EPOLLRDNORM | EPOLLERR | EPOLLET;
+    event.data.ptr = &cam;
+    if (-1 == epoll_ctl(target->epoll_fd.get(), EPOLL_CTL_ADD, cam.dev.get(), &event)) {
+        target->cameras.erase(decltype(target->cameras)::s_iterator_to(cam));
+        throw_errno_error("Unable to add camera to epoll:", errno);
     }
-    notifier.signal();
 }
 
 void controller::unregister_camera(camera& cam) {
-    {
+    shard& s = *shards[cam.controller_shard];
+    lock_guard lock(s.list_mutex);
+    // Also removes the camera events which are ready but not returned yet
+    epoll_ctl(s.epoll_fd.get(), EPOLL_CTL_DEL, cam.dev.get(), nullptr);
+    s.cameras.erase(decltype(s.cameras)::s_iterator_to(cam));
+}
+
+controller::shard::shard():
+    epoll_fd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (!epoll_fd.valid()) {
+        throw_errno_error("failed to create epoll:", errno);
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (-1 == epoll_ctl(epoll_fd.get(), EPOLL_CTL_ADD, wakeup.get_fd_to_poll(), &event)) {
+        throw_errno_error("Unable to add notifier to epoll:", errno);
+    }
+}
+
+bool controller::shard::contains(const camera* cam) const {
+    // Compares the addresses only, an unregistered camera may be destroyed
+    return cameras.end() != std::find_if(cameras.begin(), cameras.end(),
+        [cam](const camera& c) { return &c == cam; });
+}
+
+void controller::shard::run(const std::atomic_bool& terminate) {
+    constexpr const int MaxEvents = 64;
+    epoll_event events[MaxEvents];
+    while (!terminate) {
+        int count = epoll_wait(epoll_fd.get(), events, MaxEvents, -1);
+        if (-1 == count) {
+            if (EINTR == errno) {
+                continue;
+            }
+            throw_errno_error("failed wait on epoll:", errno);
+        }
+
         lock_guard lock(list_mutex);
-        cameras.erase(decltype(cameras)::s_iterator_to(cam));
+        for (int i = 0; i < count; ++i) {
+            auto cam = static_cast<camera*>(events[i].data.ptr);
+            if (nullptr == cam) {
+                wakeup.flush();
+            } else if (contains(cam)) {
+                // The camera could be unregistered after epoll_wait() returned
+                cam->read_frame();
+            }
+        }
     }
-    notifier.signal();
 }
 
-controller::poll_notifier::poll_notifier() {
+controller::notifier::notifier() {
     int pfd[2] = {};
     if (-1 == pipe(pfd)) {
         throw_errno_error("failed to create a pipe:", errno);
@@ -92,7 +167,7 @@ controller::poll_notifier::poll_notifier() {
     }
 }
 
-void controller::poll_notifier::signal() {
+void controller::notifier::signal() {
     assert(write_fd.valid());
     char buff[1] = {42};
     if (-1 == write(write_fd.get(), buff, 1)) {
@@ -100,7 +175,7 @@ void controller::poll_notifier::signal() {
     }
 }
 
-void controller::poll_notifier::flush() {
+void controller::notifier::flush() {
     assert(read_fd.valid());
     constexpr const size_t Len = 1024;
     char buff[Len];
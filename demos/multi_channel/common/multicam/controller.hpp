@@ -5,42 +5,36 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "camera.hpp"
 #include "utils.hpp"
 
 namespace mcam {
 
+/// Reads frames of registered cameras in an edge triggered epoll loop.
+/// Cameras are distributed across num_threads loops, each camera is added
+/// to the loop with the least cameras. With pin_threads loop threads are
+/// bound in order to the cores the creating thread is allowed to run on.
 class controller final {
 public:
     friend class ::mcam::camera;
 
-    controller();
+    explicit controller(unsigned num_threads = 1, bool pin_threads = false);
     ~controller();
 
 private:
     void register_camera(camera& cam);
     void unregister_camera(camera& cam);
 
-    std::thread queue_thread;
-    std::atomic_bool terminate = {false};
-
-    std::mutex list_mutex;
-    boost::intrusive::list<
-        camera,
-        boost::intrusive::member_hook<
-            camera,
-            boost::intrusive::list_member_hook<>, &camera::list_node
-        >
-    > cameras;
-
-    struct poll_notifier final {
+    struct notifier final {
         file_descriptor read_fd;
         file_descriptor write_fd;
 
-        poll_notifier();
+        notifier();
 
         void signal();
         void flush();
@@ -48,7 +42,30 @@ private:
         int get_fd_to_poll() const { return read_fd.get(); }
     };
 
-    poll_notifier notifier;
+    struct shard final {
+        file_descriptor epoll_fd;
+        notifier wakeup;
+        std::thread thread;
+
+        // Held while events are dispatched, so a camera isn't read after
+        // unregister_camera() returns
+        std::mutex list_mutex;
+        boost::intrusive::list<
+            camera,
+            boost::intrusive::member_hook<
+                camera,
+                boost::intrusive::list_member_hook<>, &camera::list_node
+            >
+        > cameras;
+
+        shard();
+        void run(const std::atomic_bool& terminate);
+        bool contains(const camera* cam) const;
+    };
+
+    std::atomic_bool terminate = {false};
+    std::mutex shards_mutex;
+    std::vector<std::unique_ptr<shard>> shards;
 };
 
 }  // namespace mcam
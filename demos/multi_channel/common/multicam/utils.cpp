@@ -58,6 +58,10 @@ file_descriptor::file_descriptor(int fd_):
     desc(fd_) {
 }
 
+file_descriptor::file_descriptor(file_descriptor&& other) {
+    swap(other);
+}
+
 file_descriptor::~file_descriptor() {
     if (-1 != desc) {
         close(desc);
@@ -10,7 +10,8 @@
 
 static const char help_message[] = "Print a usage message";
 static const char input_message[] = "Required. A comma separated list of inputs to process. Each input must be a "
-    "single image, a folder of images or anything that cv::VideoCapture can process.";
+    "single image, a folder of images or anything that cv::VideoCapture can process. synthetic:WxH[@fps] generates "
+    "frames of the given size without decoding to measure the pipeline alone.";
 static const char loop_message[] = "Optional. Enable reading the inputs in a loop.";
 static const char duplication_channel_number_message[] = "Optional. Multiply the inputs by the given factor. For "
     "example, if only one input is provided, but -ni is set to 2, the demo uses half of images from the input as it was"
@@ -26,6 +27,9 @@ static const char custom_cpu_library_message[] = "Required for CPU custom layers
                                                  "Absolute path to a shared library with the kernels implementations";
 static const char no_show_processed_video[] = "Optional. Do not show processed video.";
 static const char batch_size[] = "Optional. Batch size for processing (the number of frames processed per infer request)";
+static const char batch_wait_time[] = "Optional. Maximum time in msec to wait for a full batch since its first frame. "
+                                     "Zero (default) waits for all frames of a batch, otherwise the device has to "
+                                     "support dynamic batching";
 static const char num_infer_requests[] = "Optional. Number of infer requests";
 static const char input_queue_size[] = "Optional. Frame queue size for input channels";
 static const char fps_sampling_period[] = "Optional. FPS measurement sampling period between timepoints in msec";
@@ -33,6 +37,29 @@ static const char num_sampling_periods[] = "Optional. Number of sampling periods
 static const char show_statistics[] = "Optional. Enable statistics report";
 static const char real_input_fps[] = "Optional. Disable input frames caching, for maximum throughput pipeline";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
+static const char output_video_message[] = "Optional. Write the rendered results to a video file or to a GStreamer "
+    "pipeline starting with appsrc, e.g. \"appsrc ! videoconvert ! vaapih264enc ! h264parse ! rtspclientsink "
+    "location=rtsp://localhost:8554/demo\" for hardware encoded RTSP streaming. Works with -no_show";
+static const char output_json_message[] = "Optional. Write the detections of every frame as a JSON line to a file, "
+    "a named pipe or tcp://<host>:<port>. Works with -no_show";
+static const char cpus_message[] = "Optional. Bind the demo to a list of cores, e.g. \"0-15,32-47\". Its threads "
+    "and the inference threads run on these cores and the memory comes from their NUMA node. To use several sockets, "
+    "run a demo per socket with its cores and inputs";
+static const char publish_message[] = "Optional. Publish the decoded frames of input i to shared memory "
+    "/<name>_<i>, so other demos read them with -i shm://<name>_<i> instead of decoding the input again. Linux only";
+static const char priorities_message[] = "Optional. Comma separated priorities of the channels, e.g. \"4,1,1\". "
+    "A channel gets frames in proportion to its priority, the missing ones are 1";
+static const char min_fps_message[] = "Optional. Minimum frame rate of every channel. A channel waiting longer than "
+    "1/min_fps seconds gets the next frame whatever its priority. 0 disables it";
+static const char map_weights_message[] = "Optional. Map the .bin files of the models to memory instead of reading "
+    "them. Demos running the same models share one copy of their weights through the page cache";
+static const char output_queue_size[] = "Optional. Queue size of every -o and -o_json output, the oldest results "
+    "are dropped if an output can't keep up";
+static const char queue_budget_message[] = "Optional. Memory budget in MB of the infer requests and of the input and "
+    "output queues. The queues get the sizes of -n_iqs and -n_oqs or shorter ones fitting into the budget. "
+    "0 (default) disables it";
+static const char adapt_queues_message[] = "Optional. Shorten the queues of -queue_budget_mb while the system is "
+    "short of memory and lengthen them back when the memory is free";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(i, "", input_message);
@@ -45,6 +72,7 @@ DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_uint32(bs, 1, batch_size);
+DEFINE_uint32(bw, 0, batch_wait_time);
 DEFINE_uint32(nireq, 5, num_infer_requests);
 DEFINE_uint32(n_iqs, 5, input_queue_size);
 DEFINE_uint32(fps_sp, 1000, fps_sampling_period);
@@ -52,3 +80,13 @@ DEFINE_uint32(n_sp, 10, num_sampling_periods);
 DEFINE_bool(show_stats, false, show_statistics);
 DEFINE_bool(real_input_fps, false, real_input_fps);
 DEFINE_string(u, "", utilization_monitors_message);
+DEFINE_string(o, "", output_video_message);
+DEFINE_string(o_json, "", output_json_message);
+DEFINE_uint32(n_oqs, 8, output_queue_size);
+DEFINE_uint32(queue_budget_mb, 0, queue_budget_message);
+DEFINE_bool(adapt_queues, false, adapt_queues_message);
+DEFINE_string(cpus, "", cpus_message);
+DEFINE_string(publish, "", publish_message);
+DEFINE_string(priorities, "", priorities_message);
+DEFINE_double(min_fps, 0, min_fps_message);
+DEFINE_bool(map_weights, false, map_weights_message);
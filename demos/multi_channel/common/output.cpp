@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <utility>
@@ -34,6 +35,7 @@ void AsyncOutput::push(std::vector<std::shared_ptr<VideoFrame> > &&item) {
 
 void AsyncOutput::start() {
     thread = std::thread([&]() {
+        FRAME_TRACE_THREAD_NAME("Render");
         std::vector<std::shared_ptr<VideoFrame>> elem;
         while (!terminate) {
             std::unique_lock<std::mutex> lock(mutex);
@@ -48,6 +50,8 @@ void AsyncOutput::start() {
             queue.pop();
             lock.unlock();
 
+            FRAME_TRACE_SCOPE("Render", -1, -1);
+            traceFrameFlows(elem);
             if (perfTimer.enabled()) {
                 ScopedTimer sc(perfTimer);
                 if (!drawFunc(elem)) {
@@ -62,10 +66,15 @@ void AsyncOutput::start() {
     });
 }
 
+void AsyncOutput::setQueueSize(size_t size) {
+    queueSize = std::max<size_t>(1, size);
+}
+
 bool AsyncOutput::isAlive() const {
     return !terminate;
 }
 
 AsyncOutput::Stats AsyncOutput::getStats() const {
-    return Stats{perfTimer.getValue()};
+    const PerfTimer::Statistics renderTime = perfTimer.getStatistics();
+    return Stats{renderTime.mean, renderTime.p99, renderTime.max};
 }
@@ -25,13 +25,17 @@ public:
     void push(std::vector<std::shared_ptr<VideoFrame>>&& item);
     void start();
     bool isAlive() const;
+    // The oldest results are dropped at the next push() if the queue is longer
+    void setQueueSize(size_t size);
     struct Stats {
         float renderTime;
+        float renderTimeP99;
+        float renderTimeMax;
     };
     Stats getStats() const;
 
 private:
-    const size_t queueSize;
+    std::atomic<size_t> queueSize;
     DrawFunc drawFunc;
     std::queue<std::vector<std::shared_ptr<VideoFrame>>> queue;
     std::atomic_bool terminate = {false};
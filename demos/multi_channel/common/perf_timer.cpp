@@ -4,13 +4,101 @@
 
 #include "perf_timer.hpp"
 
+#include <algorithm>
+
+namespace {
+// Values less than 2 * SUB_BUCKETS us are stored exactly, every next power of two range is split to SUB_BUCKETS
+const size_t SUB_BUCKET_BITS = 5;
+const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+const size_t MAX_VALUE_BITS = 32;  // ~71 minutes
+const size_t BUCKETS_COUNT = 2 * SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+size_t highestBit(uint64_t value) {
+    size_t bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+}  // namespace
+
 PerfTimer::PerfTimer(size_t maxCount_):
-    maxCount(maxCount_) {
-    values.reserve(maxCount);
+    maxCount(maxCount_),
+    buckets(maxCount_ > 0 ? BUCKETS_COUNT : 0) {}
+
+size_t PerfTimer::bucketIndex(uint64_t us) {
+    us = std::min(us, (uint64_t(1) << MAX_VALUE_BITS) - 1);
+    if (us < 2 * SUB_BUCKETS) {
+        return static_cast<size_t>(us);
+    }
+    size_t bit = highestBit(us);
+    size_t subBucket = static_cast<size_t>(us >> (bit - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return 2 * SUB_BUCKETS + (bit - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t PerfTimer::bucketLowerBound(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    size_t range = (index - 2 * SUB_BUCKETS) / SUB_BUCKETS;
+    size_t subBucket = (index - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    return static_cast<uint64_t>(SUB_BUCKETS + subBucket) << (range + 1);
+}
+
+void PerfTimer::addMicroseconds(uint64_t us) {
+    buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(us, std::memory_order_relaxed);
+    uint64_t currentMax = maxValue.load(std::memory_order_relaxed);
+    while (us > currentMax && !maxValue.compare_exchange_weak(currentMax, us, std::memory_order_relaxed)) {}
+
+    // Only one thread gets exactly maxCount, so windows are published without locks.
+    // Values added while the window is published may be attributed to either window.
+    if (count.fetch_add(1, std::memory_order_acq_rel) + 1 == maxCount) {
+        publish();
+    }
+}
+
+void PerfTimer::publish() {
+    uint64_t total = 0;
+    std::vector<uint32_t> counts(buckets.size());
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        counts[i] = buckets[i].exchange(0, std::memory_order_relaxed);
+        total += counts[i];
+    }
+    uint64_t windowSum = sum.exchange(0, std::memory_order_relaxed);
+    uint64_t windowMax = maxValue.exchange(0, std::memory_order_relaxed);
+    count.fetch_sub(maxCount, std::memory_order_acq_rel);
+    if (total == 0) {
+        return;
+    }
+
+    uint64_t p99Rank = (total * 99 + 99) / 100;
+    uint64_t seen = 0;
+    uint64_t p99 = windowMax;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= p99Rank) {
+            // Upper bound of the bucket, so the percentile isn't underestimated
+            p99 = std::min(i + 1 < counts.size() ? bucketLowerBound(i + 1) - 1 : windowMax, windowMax);
+            break;
+        }
+    }
+
+    meanValue = static_cast<float>(windowSum) / total / 1000.0f;
+    p99Value = p99 / 1000.0f;
+    maxPublished = windowMax / 1000.0f;
 }
 
 float PerfTimer::getValue() const {
-    return avgValue;
+    return meanValue;
+}
+
+PerfTimer::Statistics PerfTimer::getStatistics() const {
+    Statistics statistics;
+    statistics.mean = meanValue;
+    statistics.p99 = p99Value;
+    statistics.max = maxPublished;
+    return statistics;
 }
 
 bool PerfTimer::enabled() const {
@@ -5,18 +5,22 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <vector>
 #include <chrono>
 #include <atomic>
-#include <numeric>
 
+// Collects statistics of durations over windows of maxCount values.
+// addValue may be called from any number of threads at once: values are put to a histogram
+// of atomic counters with ~3% precision, so neither locks nor storing of the values are needed.
 class PerfTimer final {
-    const size_t maxCount;
-    using duration = std::chrono::duration<float, std::milli>;
-    std::vector<duration> values;
-    std::atomic<float> avgValue = {0.0f};
-
 public:
+    struct Statistics {
+        float mean = 0.0f;  // ms
+        float p99 = 0.0f;  // ms
+        float max = 0.0f;  // ms
+    };
+
     enum {
         DefaultIterationsCount = 50
     };
@@ -26,19 +30,35 @@ public:
     template<typename T>
     void addValue(const T& dur) {
         assert(enabled());
-        values.push_back(std::chrono::duration_cast<duration>(dur));
-        if (values.size() >= maxCount) {
-            auto res = std::accumulate(values.begin(),
-                                       values.end(),
-                                       duration(0.0f));
-            avgValue = res.count() / static_cast<float>(values.size());
-            values.clear();
-        }
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(dur).count();
+        addMicroseconds(us > 0 ? static_cast<uint64_t>(us) : 0);
     }
 
+    // Mean of the last finished window
     float getValue() const;
 
+    // Statistics of the last finished window
+    Statistics getStatistics() const;
+
     bool enabled() const;
+
+private:
+    void addMicroseconds(uint64_t us);
+    // Moves the counters of the window to the published statistics
+    void publish();
+
+    static size_t bucketIndex(uint64_t us);
+    static uint64_t bucketLowerBound(size_t index);
+
+    const size_t maxCount;
+    std::vector<std::atomic<uint32_t>> buckets;
+    std::atomic<uint64_t> count = {0};
+    std::atomic<uint64_t> sum = {0};
+    std::atomic<uint64_t> maxValue = {0};
+
+    std::atomic<float> meanValue = {0.0f};
+    std::atomic<float> p99Value = {0.0f};
+    std::atomic<float> maxPublished = {0.0f};
 };
 
 struct ScopedTimer final{
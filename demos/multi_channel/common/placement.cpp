@@ -0,0 +1,120 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "placement.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <samples/slog.hpp>
+
+std::vector<unsigned> parseCpuList(const std::string& list) {
+    std::vector<unsigned> cores;
+    std::istringstream listStream(list);
+    std::string range;
+    while (std::getline(listStream, range, ',')) {
+        unsigned first = 0;
+        unsigned last = 0;
+        char dash = 0;
+        std::istringstream rangeStream(range);
+        if (!(rangeStream >> first)) {
+            throw std::invalid_argument("Invalid list of cores: " + list);
+        }
+        last = first;
+        if (rangeStream >> dash && ('-' != dash || !(rangeStream >> last) || last < first)) {
+            throw std::invalid_argument("Invalid list of cores: " + list);
+        }
+        for (unsigned core = first; core <= last; ++core) {
+            cores.push_back(core);
+        }
+    }
+    std::sort(cores.begin(), cores.end());
+    cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+    if (cores.empty()) {
+        throw std::invalid_argument("Empty list of cores");
+    }
+    return cores;
+}
+
+#ifdef __linux__
+int numaNodeOfCores(const std::vector<unsigned>& cores) {
+    const std::string nodesPath = "/sys/devices/system/node/";
+    DIR* nodesDir = opendir(nodesPath.c_str());
+    if (nullptr == nodesDir) {
+        return -1;
+    }
+    int coresNode = -1;
+    while (dirent* entry = readdir(nodesDir)) {
+        int node = -1;
+        if (1 != std::sscanf(entry->d_name, "node%d", &node)) {
+            continue;
+        }
+        std::ifstream cpuListFile(nodesPath + entry->d_name + "/cpulist");
+        std::string cpuList;
+        if (!std::getline(cpuListFile, cpuList) || cpuList.empty()) {
+            continue;  // a memory only node
+        }
+        std::vector<unsigned> nodeCores = parseCpuList(cpuList);
+        if (std::includes(nodeCores.begin(), nodeCores.end(), cores.begin(), cores.end())) {
+            coresNode = node;
+            break;
+        }
+    }
+    closedir(nodesDir);
+    return coresNode;
+}
+
+void bindToCores(const std::vector<unsigned>& cores) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (unsigned core : cores) {
+        if (core >= CPU_SETSIZE) {
+            throw std::invalid_argument("Core " + std::to_string(core) + " is out of the supported range");
+        }
+        CPU_SET(core, &cpus);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (0 != err) {
+        throw std::runtime_error(std::string("Can't bind the thread to the cores: ") + std::strerror(err));
+    }
+
+    const int node = numaNodeOfCores(cores);
+    if (node < 0) {
+        slog::warn << "The cores don't belong to a single NUMA node, the memory is placed by the system" << slog::endl;
+        return;
+    }
+    // The kernel places a page by the policy of the thread which touches it first, and the threads started later
+    // inherit the policy, so it doesn't matter which of them fills a buffer first
+    const int preferredPolicy = 1;  // MPOL_PREFERRED from numaif.h, which comes with libnuma
+    const unsigned long bitsPerWord = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> nodeMask(node / bitsPerWord + 1, 0);
+    nodeMask[node / bitsPerWord] = 1ul << (node % bitsPerWord);
+    if (0 != syscall(SYS_set_mempolicy, preferredPolicy, nodeMask.data(), nodeMask.size() * bitsPerWord + 1)) {
+        slog::warn << "Can't prefer memory of NUMA node " << node << ": " << std::strerror(errno) << slog::endl;
+    }
+}
+#else
+int numaNodeOfCores(const std::vector<unsigned>&) {
+    return -1;
+}
+
+void bindToCores(const std::vector<unsigned>&) {
+    throw std::runtime_error("Binding to cores is supported on Linux only");
+}
+#endif
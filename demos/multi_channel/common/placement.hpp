@@ -0,0 +1,21 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Parses a list of cores like "0-15,32-47"
+std::vector<unsigned> parseCpuList(const std::string& list);
+
+// Returns the NUMA node which has all the cores, or -1 if they span several nodes or the system has no NUMA info
+int numaNodeOfCores(const std::vector<unsigned>& cores);
+
+// Binds the calling thread to the cores and makes its memory prefer the NUMA node of the cores.
+// Threads started by the calling thread afterwards inherit both, so called at the beginning of main() it places
+// the engines of a demo: input, inference and output threads, TBB and plugin workers, and the frame and blob buffers
+// they first touch. To split the channels between sockets, run a process with the inputs of every socket.
+// Linux only, throws on other systems
+void bindToCores(const std::vector<unsigned>& cores);
@@ -0,0 +1,155 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "queue_planner.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include <monitors/memory_monitor.h>
+#include <samples/slog.hpp>
+
+namespace {
+constexpr double bytesInGiB = 1024.0 * 1024.0 * 1024.0;
+constexpr double bytesInMiB = 1024.0 * 1024.0;
+}  // namespace
+
+QueuePlanner::QueuePlanner(std::size_t budgetBytes) : budgetBytes(budgetBytes), availableBytes(budgetBytes) {}
+
+QueuePlanner::~QueuePlanner() = default;
+
+std::size_t QueuePlanner::addStage(const std::string& name, std::size_t itemBytes, std::size_t queues,
+                                   std::size_t minDepth, std::size_t maxDepth) {
+    stages.push_back({name, itemBytes, queues, minDepth, std::max(minDepth, maxDepth), minDepth});
+    return stages.size() - 1;
+}
+
+void QueuePlanner::setItemBytes(std::size_t stage, std::size_t itemBytes) {
+    stages[stage].itemBytes = itemBytes;
+}
+
+void QueuePlanner::enableAdaptation(double reserveGiB) {
+    this->reserveGiB = reserveGiB;
+    memoryMonitor.reset(new MemoryMonitor);
+    memoryMonitor->setHistorySize(1);
+}
+
+bool QueuePlanner::adapt() {
+    if (memoryMonitor) {
+        memoryMonitor->collectData();
+        // The memory held by the queues now is available to them, so shrinking the queues doesn't make the budget
+        // grow back at the next sample
+        const double freeBytes = (memoryMonitor->getMemTotal() - memoryMonitor->getLastHistory().back().first
+            - reserveGiB) * bytesInGiB;
+        const double available = std::max(0.0, static_cast<double>(plannedBytes()) + freeBytes);
+        availableBytes = std::min(budgetBytes, static_cast<std::size_t>(available));
+    }
+    return plan();
+}
+
+bool QueuePlanner::plan() {
+    std::vector<std::size_t> oldDepths;
+    std::size_t total = 0;
+    for (Stage& stage : stages) {
+        oldDepths.push_back(stage.depth);
+        stage.depth = stage.minDepth;
+        total += stage.itemBytes * stage.queues * stage.depth;
+    }
+    while (true) {
+        Stage* next = nullptr;
+        for (Stage& stage : stages) {
+            const std::size_t step = stage.itemBytes * stage.queues;
+            if (stage.depth < stage.maxDepth && total + step <= availableBytes
+                    && (!next || stage.depth * next->maxDepth < next->depth * stage.maxDepth)) {
+                next = &stage;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        ++next->depth;
+        total += next->itemBytes * next->queues;
+    }
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        if (stages[i].depth != oldDepths[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t QueuePlanner::plannedBytes() const {
+    std::size_t total = 0;
+    for (const Stage& stage : stages) {
+        total += stage.itemBytes * stage.queues * stage.depth;
+    }
+    return total;
+}
+
+std::string QueuePlanner::report() const {
+    std::ostringstream report;
+    report.precision(1);
+    report << std::fixed;
+    for (const Stage& stage : stages) {
+        report << stage.name << ": " << stage.depth << " of " << stage.maxDepth << " x "
+            << stage.itemBytes / bytesInMiB << " MB";
+        if (stage.queues != 1) {
+            report << " x " << stage.queues << " queues";
+        }
+        report << ", ";
+    }
+    report << "total " << plannedBytes() / bytesInMiB << " MB of " << availableBytes / bytesInMiB << " MB";
+    if (plannedBytes() > availableBytes) {
+        report << ", the minimal queues don't fit";
+    }
+    return report.str();
+}
+
+PipelineQueues::PipelineQueues(std::size_t budgetBytes, bool adaptive, VideoSources& sources,
+                               std::size_t inputQueueSize, const std::vector<std::unique_ptr<AsyncOutput>>& sinks,
+                               std::size_t outputQueueSize, std::size_t numRequests,
+                               const std::vector<std::size_t>& inputDims) :
+        sources(sources), sinks(sinks), planner(budgetBytes), lastUpdate(std::chrono::steady_clock::now()) {
+    // U8 image blobs of a batch of inputDims[0] frames
+    std::size_t blobBytes = 1;
+    for (std::size_t dim : inputDims) {
+        blobBytes *= dim;
+    }
+    const std::size_t frameBytes = inputDims.size() == 4 ? inputDims[1] * inputDims[2] * inputDims[3] : blobBytes;
+    planner.addStage("infer requests", blobBytes, 1, numRequests, numRequests);
+    inputStage = planner.addStage("input queues", frameBytes, sources.numberOfInputs(), 1, inputQueueSize);
+    outputStage = planner.addStage("output queues", frameBytes * sources.numberOfInputs(), sinks.size(), 1,
+                                   outputQueueSize);
+    if (adaptive) {
+        planner.enableAdaptation(0.5);
+    }
+    planner.adapt();
+    apply();
+}
+
+void PipelineQueues::update(const std::vector<std::shared_ptr<VideoFrame>>& results) {
+    auto now = std::chrono::steady_clock::now();
+    if (results.empty() || now - lastUpdate < std::chrono::seconds(1)) {
+        return;
+    }
+    lastUpdate = now;
+    // An output holds the frames of all the channels of a result
+    std::size_t resultBytes = 0;
+    for (const std::shared_ptr<VideoFrame>& result : results) {
+        resultBytes += result->frame.total() * result->frame.elemSize();
+    }
+    planner.setItemBytes(inputStage, resultBytes / results.size());
+    planner.setItemBytes(outputStage, resultBytes);
+    if (planner.adapt()) {
+        apply();
+    }
+}
+
+void PipelineQueues::apply() {
+    slog::info << "Queues: " << planner.report() << slog::endl;
+    sources.setQueueSize(planner.depth(inputStage));
+    for (const std::unique_ptr<AsyncOutput>& sink : sinks) {
+        sink->setQueueSize(planner.depth(outputStage));
+    }
+}
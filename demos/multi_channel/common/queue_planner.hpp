@@ -0,0 +1,82 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "input.hpp"
+#include "output.hpp"
+
+class MemoryMonitor;
+
+// Chooses the depths of the queues of the pipeline stages, so the frames, blobs and results they hold fit into
+// a memory budget. Every stage gets its minimal depth, then the depths grow by an item at a time, the stage having
+// the smallest part of its requested depth goes first, until every stage has its requested depth or no next item fits.
+// With adaptation enabled the budget is also limited by the memory the system has available
+class QueuePlanner {
+public:
+    struct Stage {
+        std::string name;
+        std::size_t itemBytes;  // memory held by one queued item
+        std::size_t queues;  // the number of queues of the stage, e.g. one per input
+        std::size_t minDepth;
+        std::size_t maxDepth;  // the requested depth, a deeper queue doesn't help
+        std::size_t depth;  // the planned depth
+    };
+
+    explicit QueuePlanner(std::size_t budgetBytes);
+    ~QueuePlanner();
+
+    // Returns the index of the stage
+    std::size_t addStage(const std::string& name, std::size_t itemBytes, std::size_t queues,
+                         std::size_t minDepth, std::size_t maxDepth);
+    void setItemBytes(std::size_t stage, std::size_t itemBytes);
+
+    // Keeps reserveGiB of the system memory free besides staying within the budget. The memory is sampled by adapt()
+    void enableAdaptation(double reserveGiB);
+
+    // Samples the available memory if the adaptation is enabled and replans. Returns true if any depth has changed
+    bool adapt();
+
+    // Returns true if any depth has changed
+    bool plan();
+
+    std::size_t depth(std::size_t stage) const {return stages[stage].depth;}
+    std::size_t plannedBytes() const;
+    std::string report() const;
+
+private:
+    const std::size_t budgetBytes;
+    std::size_t availableBytes;  // the budget limited by the available memory
+    std::vector<Stage> stages;
+    double reserveGiB = 0.0;
+    std::unique_ptr<MemoryMonitor> memoryMonitor;
+};
+
+// Sizes the frame queues of the inputs and the queues of the -o and -o_json outputs of a multichannel demo by
+// QueuePlanner. The infer requests are created with the network, so their number is fixed and their blobs take
+// their part of the budget. The sizes of the frames are estimated by the network input until the first results
+class PipelineQueues {
+public:
+    PipelineQueues(std::size_t budgetBytes, bool adaptive, VideoSources& sources, std::size_t inputQueueSize,
+                   const std::vector<std::unique_ptr<AsyncOutput>>& sinks, std::size_t outputQueueSize,
+                   std::size_t numRequests, const std::vector<std::size_t>& inputDims);
+
+    // Measures the frames of the results and, at most once a second, resizes the queues if the plan has changed
+    void update(const std::vector<std::shared_ptr<VideoFrame>>& results);
+
+private:
+    void apply();
+
+    VideoSources& sources;
+    const std::vector<std::unique_ptr<AsyncOutput>>& sinks;
+    QueuePlanner planner;
+    std::size_t inputStage, outputStage;
+    std::chrono::steady_clock::time_point lastUpdate;
+};
@@ -0,0 +1,172 @@
+// Copyright (C) 2018-2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "roi_stage.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <samples/read_network.hpp>
+
+RoiStage::RoiStage(InferenceEngine::Core& ie, const InitParams& p):
+    batchSize(std::max<std::size_t>(p.batchSize, 1)),
+    perfTimerInfer(p.collectStats ? PerfTimer::DefaultIterationsCount : 0) {
+    if (0 == p.maxRequests) {
+        throw std::invalid_argument("RoiStage needs at least one request");
+    }
+    auto cnnNetwork = readNetwork(ie, p.modelPath, p.mapWeights);
+
+    InferenceEngine::InputsDataMap inputInfo(cnnNetwork.getInputsInfo());
+    if (inputInfo.size() != 1) {
+        throw std::logic_error("The network of regions should have only one input");
+    }
+    inputName = inputInfo.begin()->first;
+    // Regions are resized by OpenCV straight to the blob, so the network takes them as they are
+    inputInfo.begin()->second->setPrecision(InferenceEngine::Precision::U8);
+    inputInfo.begin()->second->setLayout(InferenceEngine::Layout::NCHW);
+
+    InferenceEngine::OutputsDataMap outputInfo(cnnNetwork.getOutputsInfo());
+    for (auto& output : outputInfo) {
+        output.second->setPrecision(InferenceEngine::Precision::FP32);
+        outputNames.push_back(output.first);
+    }
+
+    std::map<std::string, std::string> loadConfig;
+    if (batchSize > 1) {
+        auto inShapes = cnnNetwork.getInputShapes();
+        for (auto& pair : inShapes) {
+            auto& dims = pair.second;
+            if (!dims.empty()) {
+                dims[0] = batchSize;
+            }
+        }
+        cnnNetwork.reshape(inShapes);
+        // The number of regions is rarely a multiple of the batch size
+        loadConfig[InferenceEngine::PluginConfigParams::KEY_DYN_BATCH_ENABLED] = InferenceEngine::PluginConfigParams::YES;
+    }
+    network = ie.LoadNetwork(cnnNetwork, p.deviceName, loadConfig);
+
+    requests.reserve(p.maxRequests);
+    for (std::size_t i = 0; i < p.maxRequests; ++i) {
+        requests.push_back(network.CreateInferRequest());
+        idleRequests.push_back(i);
+    }
+}
+
+void RoiStage::fillInput(InferenceEngine::InferRequest& req, const std::vector<Roi>& rois,
+                         std::size_t begin, std::size_t end) {
+    InferenceEngine::Blob::Ptr inputBlob = req.GetBlob(inputName);
+    const InferenceEngine::SizeVector& dims = inputBlob->getTensorDesc().getDims();
+    const int channels = static_cast<int>(dims[1]);
+    const int height = static_cast<int>(dims[2]);
+    const int width = static_cast<int>(dims[3]);
+    const std::size_t planeSize = static_cast<std::size_t>(width) * height;
+
+    InferenceEngine::LockedMemory<void> buff = InferenceEngine::as<InferenceEngine::MemoryBlob>(inputBlob)->wmap();
+    uint8_t* inputPtr = buff.as<uint8_t*>();
+    cv::Mat resized;
+    std::vector<cv::Mat> planes(channels);
+    for (std::size_t i = begin; i < end; ++i) {
+        const Roi& roi = rois[i];
+        const cv::Rect rect = roi.rect & cv::Rect(0, 0, roi.frame.cols, roi.frame.rows);
+        if (rect.empty() || roi.frame.channels() != channels) {
+            throw std::invalid_argument("Region doesn't match the frame or the network input");
+        }
+        cv::resize(roi.frame(rect), resized, cv::Size(width, height));
+        // The planes wrap the blob memory, so cv::split() writes the channels there without copying
+        uint8_t* batchItemPtr = inputPtr + (i - begin) * channels * planeSize;
+        for (int c = 0; c < channels; ++c) {
+            planes[c] = cv::Mat(height, width, CV_8UC1, batchItemPtr + c * planeSize);
+        }
+        cv::split(resized, planes);
+    }
+}
+
+void RoiStage::finishBatch(const StartedBatch& batch, const std::vector<Roi>& rois,
+                           const PostprocessingFunc& postprocessing) {
+    InferenceEngine::InferRequest& req = requests[batch.requestId];
+    InferenceEngine::StatusCode status = req.Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
+    if (perfTimerInfer.enabled()) {
+        perfTimerInfer.addValue(std::chrono::high_resolution_clock::now() - batch.startTime);
+    }
+    try {
+        if (InferenceEngine::OK != status) {
+            throw std::runtime_error("Inference of regions failed");
+        }
+        for (std::size_t i = batch.roiBegin; i < batch.roiEnd; ++i) {
+            postprocessing(req, outputNames, i - batch.roiBegin, i);
+        }
+    } catch (...) {
+        releaseRequest(batch.requestId);
+        throw;
+    }
+    releaseRequest(batch.requestId);
+}
+
+void RoiStage::releaseRequest(std::size_t requestId) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        idleRequests.push_back(requestId);
+    }
+    condVar.notify_one();
+}
+
+void RoiStage::process(const std::vector<Roi>& rois, const PostprocessingFunc& postprocessing) {
+    std::deque<StartedBatch> started;
+    // Takes the oldest started batch off the list before finishing it, as finishBatch() releases its request
+    auto finishOldest = [&]() {
+        StartedBatch batch = started.front();
+        started.pop_front();
+        finishBatch(batch, rois, postprocessing);
+    };
+    try {
+        for (std::size_t begin = 0; begin < rois.size(); begin += batchSize) {
+            const std::size_t end = std::min(begin + batchSize, rois.size());
+            std::size_t requestId;
+            for (;;) {
+                std::unique_lock<std::mutex> lock(mtx);
+                if (!idleRequests.empty()) {
+                    requestId = idleRequests.back();
+                    idleRequests.pop_back();
+                    break;
+                }
+                if (!started.empty()) {
+                    // Completing an own batch instead of waiting for the other threads,
+                    // so the threads holding the requests can't wait for each other
+                    lock.unlock();
+                    finishOldest();
+                } else {
+                    condVar.wait(lock, [&]() {return !idleRequests.empty();});
+                }
+            }
+
+            InferenceEngine::InferRequest& req = requests[requestId];
+            started.push_back({requestId, begin, end, std::chrono::high_resolution_clock::now()});
+            fillInput(req, rois, begin, end);
+            if (batchSize > 1) {
+                req.SetBatch(static_cast<int>(end - begin));
+            }
+            started.back().startTime = std::chrono::high_resolution_clock::now();
+            req.StartAsync();
+        }
+        while (!started.empty()) {
+            finishOldest();
+        }
+    } catch (...) {
+        // The started requests have to be completed before they are given to the others
+        for (const StartedBatch& batch : started) {
+            requests[batch.requestId].Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
+        }
+        for (const StartedBatch& batch : started) {
+            releaseRequest(batch.requestId);
+        }
+        throw;
+    }
+}
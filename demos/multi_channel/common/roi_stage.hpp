@@ -0,0 +1,77 @@
+// Copyright (C) 2018-2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <inference_engine.hpp>
+#include <opencv2/core/core.hpp>
+
+#include "perf_timer.hpp"
+
+// Second stage of a pipeline infering a network on regions of the frames postprocessed by IEGraph,
+// e.g. on faces found by a detector. Regions of all frames given at once are batched together,
+// so the faces of different channels share requests. Only the pixels of the regions are copied:
+// every region is resized straight to its place in the input blob.
+class RoiStage {
+public:
+    struct InitParams {
+        // Every request infers up to batchSize regions, partial batches are inferred
+        // with InferRequest::SetBatch(), so the device has to support dynamic batching if it's greater than 1
+        std::size_t batchSize = 1;
+        std::size_t maxRequests = 2;
+        bool collectStats = false;
+        std::string modelPath;
+        std::string deviceName;
+        bool mapWeights = false;  // see IEGraph::InitParams
+    };
+
+    struct Roi {
+        cv::Mat frame;  // BGR frame, the header shares the data of the frame
+        cv::Rect rect;  // in pixels of the frame
+    };
+
+    // Called for every region when its request is completed. batchIndex is the index of the region in the request
+    using PostprocessingFunc = std::function<void(InferenceEngine::InferRequest& req,
+        const std::vector<std::string>& outputNames, std::size_t batchIndex, std::size_t roiIndex)>;
+
+    RoiStage(InferenceEngine::Core& ie, const InitParams& p);
+
+    // Infers the network on all the regions and postprocesses them. Returns when all of them are postprocessed.
+    // Can be called by several threads at once, they share the requests.
+    void process(const std::vector<Roi>& rois, const PostprocessingFunc& postprocessing);
+
+    float getAvgInferTime() const {return perfTimerInfer.getValue();}
+
+private:
+    struct StartedBatch {
+        std::size_t requestId;
+        std::size_t roiBegin;
+        std::size_t roiEnd;
+        std::chrono::high_resolution_clock::time_point startTime;
+    };
+
+    void fillInput(InferenceEngine::InferRequest& req, const std::vector<Roi>& rois, std::size_t begin, std::size_t end);
+    void finishBatch(const StartedBatch& batch, const std::vector<Roi>& rois, const PostprocessingFunc& postprocessing);
+    void releaseRequest(std::size_t requestId);
+
+    std::size_t batchSize;
+    PerfTimer perfTimerInfer;
+
+    std::string inputName;
+    std::vector<std::string> outputNames;
+    InferenceEngine::ExecutableNetwork network;
+    std::vector<InferenceEngine::InferRequest> requests;
+
+    std::mutex mtx;
+    std::condition_variable condVar;
+    std::vector<std::size_t> idleRequests;
+};
@@ -0,0 +1,266 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "shm_frames.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Atomics in shared memory must be lock free");
+
+namespace {
+const uint32_t ringMagic = 0x4f4d5a46;  // OMZF
+
+std::size_t alignedSize(std::size_t size) {
+    const std::size_t cacheLine = 64;
+    return (size + cacheLine - 1) / cacheLine * cacheLine;
+}
+}  // namespace
+
+struct ShmFrameRing::Header {
+    std::atomic<uint32_t> magic;  // set when the ring is initialized
+    uint32_t slotsNum;
+    uint64_t slotSize;  // Slot and the frame data after it
+    uint64_t maxFrameBytes;
+    std::atomic<uint64_t> publishedSeq;  // sequence number of the latest frame
+    std::atomic<uint32_t> latestSlot;
+    std::atomic<uint32_t> futexWord;  // changes on every publish() and close(), readers wait for it
+    std::atomic<uint32_t> isClosed;
+};
+
+struct ShmFrameRing::Slot {
+    static constexpr uint32_t writerFlag = 0x80000000u;
+    std::atomic<uint32_t> state;  // writerFlag while the frame is written, the number of readers otherwise
+    std::atomic<uint64_t> seq;
+    int64_t frameId;
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+
+    unsigned char* data() {return reinterpret_cast<unsigned char*>(this) + alignedSize(sizeof(Slot));}
+};
+
+std::size_t ShmFrameRing::ringSize(std::size_t slotsNum, std::size_t slotSize) {
+    return alignedSize(sizeof(Header)) + slotsNum * slotSize;
+}
+
+#ifdef __linux__
+namespace {
+void futexWait(std::atomic<uint32_t>& word, uint32_t value, std::chrono::milliseconds timeout) {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+    timespec ts = {static_cast<time_t>(timeout.count() / 1000), static_cast<long>(timeout.count() % 1000 * 1000000)};
+    // Not FUTEX_PRIVATE_FLAG, the word is shared between processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &ts, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+std::runtime_error shmError(const std::string& message, const std::string& name) {
+    return std::runtime_error(message + " /" + name + ": " + std::strerror(errno));
+}
+}  // namespace
+
+std::unique_ptr<ShmFrameRing> ShmFrameRing::create(const std::string& name, std::size_t slotsNum,
+                                                   std::size_t maxFrameBytes) {
+    const std::string path = "/" + name;
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (-1 == fd && EEXIST == errno) {
+        // Left by a writer which didn't exit cleanly
+        shm_unlink(path.c_str());
+        fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (-1 == fd) {
+        throw shmError("Can't create shared memory", name);
+    }
+    const std::size_t slotSize = alignedSize(sizeof(Slot)) + alignedSize(maxFrameBytes);
+    const std::size_t size = ringSize(slotsNum, slotSize);
+    void* memory = MAP_FAILED;
+    if (0 == ftruncate(fd, static_cast<off_t>(size))) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (MAP_FAILED == memory) {
+        std::runtime_error error = shmError("Can't map shared memory", name);
+        shm_unlink(path.c_str());
+        throw error;
+    }
+
+    // The memory is zeroed by ftruncate(), which is the initial state of the atomics
+    std::unique_ptr<ShmFrameRing> ring(new ShmFrameRing(name, memory, size, true));
+    ring->header.slotsNum = static_cast<uint32_t>(slotsNum);
+    ring->header.slotSize = slotSize;
+    ring->header.maxFrameBytes = maxFrameBytes;
+    ring->header.magic.store(ringMagic, std::memory_order_release);
+    return ring;
+}
+
+std::unique_ptr<ShmFrameRing> ShmFrameRing::attach(const std::string& name, std::chrono::milliseconds timeout) {
+    const std::string path = "/" + name;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        int fd = shm_open(path.c_str(), O_RDWR, 0);
+        if (-1 == fd && ENOENT != errno) {
+            throw shmError("Can't open shared memory", name);
+        }
+        if (-1 != fd) {
+            struct stat sb;
+            void* memory = MAP_FAILED;
+            const bool isSized = 0 == fstat(fd, &sb) && static_cast<std::size_t>(sb.st_size) >= sizeof(Header);
+            if (isSized) {
+                memory = mmap(nullptr, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+            if (MAP_FAILED != memory) {
+                std::unique_ptr<ShmFrameRing> ring(new ShmFrameRing(name, memory, sb.st_size, false));
+                if (ringMagic == ring->header.magic.load(std::memory_order_acquire)) {
+                    if (ringSize(ring->header.slotsNum, ring->header.slotSize) > ring->memorySize) {
+                        throw std::runtime_error("Shared memory /" + name + " isn't a frame ring");
+                    }
+                    return ring;
+                }
+            }
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error("Shared memory /" + name + " wasn't created by a writer in time");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+ShmFrameRing::~ShmFrameRing() {
+    if (isOwner) {
+        close();
+        shm_unlink(("/" + name).c_str());
+    }
+    munmap(memory, memorySize);
+}
+
+void ShmFrameRing::close() {
+    header.isClosed.store(1, std::memory_order_release);
+    header.futexWord.fetch_add(1, std::memory_order_release);
+    futexWakeAll(header.futexWord);
+}
+#else
+std::unique_ptr<ShmFrameRing> ShmFrameRing::create(const std::string&, std::size_t, std::size_t) {
+    throw std::runtime_error("Shared memory frames are supported on Linux only");
+}
+
+std::unique_ptr<ShmFrameRing> ShmFrameRing::attach(const std::string&, std::chrono::milliseconds) {
+    throw std::runtime_error("Shared memory frames are supported on Linux only");
+}
+
+ShmFrameRing::~ShmFrameRing() {}
+
+void ShmFrameRing::close() {}
+
+namespace {
+void futexWait(std::atomic<uint32_t>&, uint32_t, std::chrono::milliseconds) {}
+void futexWakeAll(std::atomic<uint32_t>&) {}
+}  // namespace
+#endif
+
+ShmFrameRing::ShmFrameRing(const std::string& name, void* memory, std::size_t memorySize, bool isOwner):
+    name(name), memory(memory), memorySize(memorySize), isOwner(isOwner), header(*static_cast<Header*>(memory)) {}
+
+ShmFrameRing::Slot& ShmFrameRing::slot(uint32_t slotId) const {
+    unsigned char* slots = static_cast<unsigned char*>(memory) + alignedSize(sizeof(Header));
+    return *reinterpret_cast<Slot*>(slots + slotId * header.slotSize);
+}
+
+std::size_t ShmFrameRing::maxFrameBytes() const {
+    return header.maxFrameBytes;
+}
+
+bool ShmFrameRing::publish(const cv::Mat& frame, int64_t frameId) {
+    const std::size_t rowBytes = frame.cols * frame.elemSize();
+    if (rowBytes * frame.rows > header.maxFrameBytes) {
+        throw std::invalid_argument("The frame doesn't fit into shared memory /" + name);
+    }
+    // The slot after the latest one was read the longest time ago
+    const uint32_t latestSlot = header.latestSlot.load(std::memory_order_relaxed);
+    for (uint32_t i = 1; i <= header.slotsNum; ++i) {
+        const uint32_t slotId = (latestSlot + i) % header.slotsNum;
+        Slot& s = slot(slotId);
+        uint32_t noReaders = 0;
+        if (!s.state.compare_exchange_strong(noReaders, Slot::writerFlag, std::memory_order_acquire)) {
+            continue;
+        }
+        s.frameId = frameId;
+        s.rows = frame.rows;
+        s.cols = frame.cols;
+        s.type = frame.type();
+        for (int row = 0; row < frame.rows; ++row) {
+            std::memcpy(s.data() + row * rowBytes, frame.ptr(row), rowBytes);
+        }
+        const uint64_t seq = ++publishedNum;
+        s.seq.store(seq, std::memory_order_relaxed);
+        s.state.store(0, std::memory_order_release);
+
+        header.latestSlot.store(slotId, std::memory_order_relaxed);
+        header.publishedSeq.store(seq, std::memory_order_release);
+        header.futexWord.fetch_add(1, std::memory_order_release);
+        futexWakeAll(header.futexWord);
+        return true;
+    }
+    return false;
+}
+
+ShmFrameRing::ReadStatus ShmFrameRing::read(cv::Mat& frame, int64_t& frameId, uint64_t& lastSeq,
+                                            std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        const uint32_t futexValue = header.futexWord.load(std::memory_order_acquire);
+        if (header.publishedSeq.load(std::memory_order_acquire) > lastSeq) {
+            Slot& s = slot(header.latestSlot.load(std::memory_order_relaxed));
+            uint32_t state = s.state.load(std::memory_order_relaxed);
+            // Register as a reader unless the writer has taken the slot, then a newer frame is coming
+            while (0 == (state & Slot::writerFlag)
+                   && !s.state.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {}
+            if (0 == (state & Slot::writerFlag)) {
+                const uint64_t seq = s.seq.load(std::memory_order_relaxed);
+                const bool isNew = seq > lastSeq;
+                if (isNew) {
+                    frame.create(s.rows, s.cols, s.type);
+                    const std::size_t rowBytes = frame.cols * frame.elemSize();
+                    for (int row = 0; row < frame.rows; ++row) {
+                        std::memcpy(frame.ptr(row), s.data() + row * rowBytes, rowBytes);
+                    }
+                    frameId = s.frameId;
+                    lastSeq = seq;
+                }
+                s.state.fetch_sub(1, std::memory_order_release);
+                if (isNew) {
+                    return ReadStatus::Frame;
+                }
+            }
+            continue;  // the latest slot is rewritten, read the next latest one
+        }
+        if (header.isClosed.load(std::memory_order_acquire)) {
+            return ReadStatus::Closed;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return ReadStatus::Timeout;
+        }
+        futexWait(header.futexWord, futexValue, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now));
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <opencv2/core/core.hpp>
+
+// Ring of decoded frames in POSIX shared memory, written by one process and read by any number of processes.
+// Readers take the latest frame, so a slow reader skips frames instead of holding the writer back. A reader counts
+// itself in the slot while it copies the frame and the writer skips slots which are being read, readers wait for
+// new frames on a futex in the ring. Linux only, other systems throw on creation.
+class ShmFrameRing {
+public:
+    enum class ReadStatus {Frame, Timeout, Closed};
+
+    // Creates /<name> for frames up to maxFrameBytes, it's unlinked when the ring is destroyed
+    static std::unique_ptr<ShmFrameRing> create(const std::string& name, std::size_t slotsNum,
+                                                std::size_t maxFrameBytes);
+    // Waits for the writer to create /<name> if it doesn't exist yet
+    static std::unique_ptr<ShmFrameRing> attach(const std::string& name, std::chrono::milliseconds timeout);
+
+    ~ShmFrameRing();
+    ShmFrameRing(const ShmFrameRing&) = delete;
+    ShmFrameRing& operator=(const ShmFrameRing&) = delete;
+
+    // Returns false if the frame is dropped because all slots are being read
+    bool publish(const cv::Mat& frame, int64_t frameId);
+
+    // Tells the readers there are no more frames
+    void close();
+
+    // Copies a frame published after lastSeq to frame and updates lastSeq, 0 is before the first frame.
+    // frame keeps its buffer if it already has the size and type
+    ReadStatus read(cv::Mat& frame, int64_t& frameId, uint64_t& lastSeq, std::chrono::milliseconds timeout);
+
+    std::size_t maxFrameBytes() const;
+
+private:
+    struct Header;
+    struct Slot;
+
+    static std::size_t ringSize(std::size_t slotsNum, std::size_t slotSize);
+
+    ShmFrameRing(const std::string& name, void* memory, std::size_t memorySize, bool isOwner);
+    Slot& slot(uint32_t slotId) const;
+
+    const std::string name;
+    void* const memory;
+    const std::size_t memorySize;
+    const bool isOwner;
+    Header& header;
+    uint64_t publishedNum = 0;  // used by the writer only
+};
@@ -0,0 +1,134 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "sinks.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <opencv2/videoio.hpp>
+#include <samples/slog.hpp>
+
+namespace {
+int connectTcp(const std::string& host, const std::string& port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int err = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+    if (0 != err) {
+        throw std::runtime_error("Can't resolve " + host + ": " + gai_strerror(err));
+    }
+    int fd = -1;
+    for (addrinfo* addr = addresses; nullptr != addr && -1 == fd; addr = addr->ai_next) {
+        fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (-1 != fd && 0 != connect(fd, addr->ai_addr, addr->ai_addrlen)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (-1 == fd) {
+        throw std::runtime_error("Can't connect to " + host + ":" + port);
+    }
+    return fd;
+}
+}  // namespace
+
+LinesWriter::LinesWriter(const std::string& target) {
+    const std::string tcpPrefix = "tcp://";
+    if (0 == target.compare(0, tcpPrefix.size(), tcpPrefix)) {
+        const std::string address = target.substr(tcpPrefix.size());
+        const std::size_t colonPos = address.rfind(':');
+        if (std::string::npos == colonPos) {
+            throw std::invalid_argument("Expected tcp://<host>:<port>, got " + target);
+        }
+        socketFd = connectTcp(address.substr(0, colonPos), address.substr(colonPos + 1));
+    } else {
+        file.open(target);
+        if (!file) {
+            throw std::runtime_error("Can't open " + target);
+        }
+    }
+}
+
+LinesWriter::~LinesWriter() {
+    if (-1 != socketFd) {
+        close(socketFd);
+    }
+}
+
+bool LinesWriter::write(const std::string& line) {
+    if (-1 == socketFd) {
+        file << line << '\n';
+        file.flush();  // a reader of a pipe gets every line as soon as it's ready
+        return static_cast<bool>(file);
+    }
+    std::string data = line + '\n';
+    const char* ptr = data.data();
+    std::size_t left = data.size();
+    while (left > 0) {
+        ssize_t written = send(socketFd, ptr, left, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        ptr += written;
+        left -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+std::unique_ptr<AsyncOutput> makeJsonSink(const std::string& target, std::size_t queueSize, bool collectStats,
+                                          DetectionsToJsonFunc toJson) {
+    std::shared_ptr<LinesWriter> writer = std::make_shared<LinesWriter>(target);
+    std::unique_ptr<AsyncOutput> sink(new AsyncOutput(collectStats, queueSize,
+    [writer, toJson](const std::vector<std::shared_ptr<VideoFrame>>& frames) {
+        for (const std::shared_ptr<VideoFrame>& frame : frames) {
+            if (!writer->write("{\"source\": " + std::to_string(frame->sourceIdx) + ", \"frame\": "
+                    + std::to_string(frame->frameId) + ", \"detections\": [" + toJson(*frame) + "]}")) {
+                slog::err << "Failed to write detections, the JSON output is stopped" << slog::endl;
+                return false;
+            }
+        }
+        return true;
+    }));
+    sink->start();
+    return sink;
+}
+
+std::unique_ptr<AsyncOutput> makeVideoSink(const std::string& target, std::size_t queueSize, bool collectStats,
+                                           cv::Size canvasSize, std::vector<cv::Point> tilePositions,
+                                           cv::Size tileSize, Mosaic::DrawTileFunc drawTile) {
+    const double fps = 30.0;  // the mosaic has no frame rate of its own, it's updated as the results arrive
+    std::shared_ptr<cv::VideoWriter> writer = std::make_shared<cv::VideoWriter>();
+    if (std::string::npos != target.find('!')) {
+        writer->open(target, cv::CAP_GSTREAMER, 0, fps, canvasSize);
+    } else {
+        writer->open(target, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, canvasSize);
+    }
+    if (!writer->isOpened()) {
+        throw std::runtime_error("Can't open video output " + target);
+    }
+    std::shared_ptr<Mosaic> mosaic = std::make_shared<Mosaic>(canvasSize, std::move(tilePositions), tileSize);
+    std::shared_ptr<cv::Mat> image = std::make_shared<cv::Mat>();
+    std::unique_ptr<AsyncOutput> sink(new AsyncOutput(collectStats, queueSize,
+    [writer, mosaic, image, drawTile](const std::vector<std::shared_ptr<VideoFrame>>& frames) {
+        mosaic->render(frames, drawTile, *image);
+        writer->write(*image);
+        return true;
+    }));
+    sink->start();
+    return sink;
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "input.hpp"
+#include "mosaic.hpp"
+#include "output.hpp"
+
+// Headless outputs of the demos. Every sink is an AsyncOutput with its own bounded queue and thread, so a slow
+// consumer drops its oldest results and doesn't stall inference or the other sinks
+
+// Writes lines to a file, which can be a named pipe, or to a TCP server given as tcp://<host>:<port>
+class LinesWriter {
+public:
+    explicit LinesWriter(const std::string& target);
+    ~LinesWriter();
+    LinesWriter(const LinesWriter&) = delete;
+    LinesWriter& operator=(const LinesWriter&) = delete;
+
+    // Returns false if the line couldn't be written, e.g. the server closed the connection
+    bool write(const std::string& line);
+
+private:
+    int socketFd = -1;
+    std::ofstream file;
+};
+
+// Writes a JSON line per frame: {"source": <sourceIdx>, "frame": <frameId>, "detections": [<toJson(frame)>]}
+// to a file, a named pipe or tcp://<host>:<port>. toJson returns comma separated JSON objects of the detections
+using DetectionsToJsonFunc = std::function<std::string(const VideoFrame& frame)>;
+std::unique_ptr<AsyncOutput> makeJsonSink(const std::string& target, std::size_t queueSize, bool collectStats,
+                                          DetectionsToJsonFunc toJson);
+
+// Renders the results on its own mosaic and writes it to a video file, or to a GStreamer pipeline if target
+// contains '!'. The pipeline must start with appsrc, so the mosaic can be encoded by hardware and streamed, e.g.
+// "appsrc ! videoconvert ! vaapih264enc ! h264parse ! rtspclientsink location=rtsp://localhost:8554/demo"
+std::unique_ptr<AsyncOutput> makeVideoSink(const std::string& target, std::size_t queueSize, bool collectStats,
+                                           cv::Size canvasSize, std::vector<cv::Point> tilePositions,
+                                           cv::Size tileSize, Mosaic::DrawTileFunc drawTile);
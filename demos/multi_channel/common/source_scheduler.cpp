@@ -0,0 +1,88 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "source_scheduler.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<double> parsePriorities(const std::string& list, size_t channelsNum) {
+    std::vector<double> priorities(channelsNum, 1.0);
+    std::istringstream stream(list);
+    std::string item;
+    for (size_t i = 0; std::getline(stream, item, ','); i++) {
+        if (i >= channelsNum) {
+            throw std::invalid_argument("There are more priorities than channels: " + list);
+        }
+        double priority = std::stod(item);
+        if (priority <= 0) {
+            throw std::invalid_argument("Channel priority must be positive: " + item);
+        }
+        priorities[i] = priority;
+    }
+    return priorities;
+}
+
+SourceScheduler::SourceScheduler(const std::vector<double>& priorities, double minFps) :
+        passes(priorities.size(), 0.0),
+        lastPicks(priorities.size(), Clock::now()),
+        maxGap(Clock::duration::zero()) {
+    if (priorities.empty()) {
+        throw std::invalid_argument("SourceScheduler needs at least one channel");
+    }
+    for (double priority : priorities) {
+        strides.push_back(1.0 / priority);
+    }
+    if (minFps > 0) {
+        maxGap = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / minFps));
+    }
+}
+
+size_t SourceScheduler::next() {
+    return next(std::vector<bool>(passes.size(), true));
+}
+
+size_t SourceScheduler::next(const std::vector<bool>& ready) {
+    if (ready.size() != passes.size()) {
+        throw std::invalid_argument("SourceScheduler got readiness of a wrong number of channels");
+    }
+    const bool anyReady = std::find(ready.begin(), ready.end(), true) != ready.end();
+    auto eligible = [&](size_t i) { return ready[i] || !anyReady; };
+    std::lock_guard<std::mutex> lock(mtx);
+    auto now = Clock::now();
+    size_t channel = 0;
+    while (!eligible(channel)) {
+        channel++;
+    }
+    bool overdue = false;
+    if (maxGap != Clock::duration::zero()) {
+        // The channel waiting the longest past its deadline goes first
+        for (size_t i = 0; i < lastPicks.size(); i++) {
+            if (eligible(i) && now - lastPicks[i] > maxGap && (!overdue || lastPicks[i] < lastPicks[channel])) {
+                channel = i;
+                overdue = true;
+            }
+        }
+    }
+    if (!overdue) {
+        for (size_t i = channel + 1; i < passes.size(); i++) {
+            if (eligible(i) && passes[i] < passes[channel]) {
+                channel = i;
+            }
+        }
+    }
+    passes[channel] += strides[channel];
+    lastPicks[channel] = now;
+
+    // Keep the passes small, only their differences matter
+    double minPass = passes[0];
+    for (double pass : passes) {
+        minPass = std::min(minPass, pass);
+    }
+    for (double& pass : passes) {
+        pass -= minPass;
+    }
+    return channel;
+}
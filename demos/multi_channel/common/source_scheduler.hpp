@@ -0,0 +1,36 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Parses a list of channel priorities like "4,1,1". Channels missing from the list get priority 1
+std::vector<double> parsePriorities(const std::string& list, size_t channelsNum);
+
+// Chooses the channel the next frame is taken from. Channels share the inference by weighted fair queuing:
+// a channel with priority 4 gets 4 times the frames of a channel with priority 1 (stride scheduling). A channel
+// which got no frame for 1/minFps seconds is chosen before the others, so low priority channels aren't starved
+// while the high priority ones are busy. Equal priorities without minFps give the former round robin order
+class SourceScheduler {
+public:
+    SourceScheduler(const std::vector<double>& priorities, double minFps = 0);
+
+    size_t next();
+
+    // Chooses among the channels with true in ready, e.g. the ones having a frame. If none is ready, chooses among all
+    size_t next(const std::vector<bool>& ready);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex mtx;
+    std::vector<double> strides;
+    std::vector<double> passes;
+    std::vector<Clock::time_point> lastPicks;
+    Clock::duration maxGap;
+};
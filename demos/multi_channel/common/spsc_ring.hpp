@@ -0,0 +1,113 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue for one producer thread and one consumer thread.
+// The consumer spins for a while if the ring is empty and then sleeps until the producer pushes an element
+// or the ring is stopped. The producer takes the mutex only if the consumer sleeps.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) : elements(capacity + 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Returns false if the ring is full
+    bool tryPush(T value) {
+        const std::size_t currentTail = tail.load(std::memory_order_relaxed);
+        const std::size_t nextTail = next(currentTail);
+        if (nextTail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        elements[currentTail] = std::move(value);
+        tail.store(nextTail, std::memory_order_release);
+        wakeConsumer();
+        return true;
+    }
+
+    // The caller ensures the ring has space, e.g. by creating it with capacity for all elements in circulation
+    void push(T value) {
+        const bool isPushed = tryPush(std::move(value));
+        assert(isPushed);
+        (void)isPushed;
+    }
+
+    bool tryPop(T& value) {
+        const std::size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(elements[currentHead]);
+        head.store(next(currentHead), std::memory_order_release);
+        return true;
+    }
+
+    // Waits for an element. Returns false if the ring is stopped and empty
+    bool pop(T& value) {
+        for (int i = 0; i < spinCount; ++i) {
+            if (tryPop(value)) {
+                return true;
+            }
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        isConsumerWaiting.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in wakeConsumer(): either the producer sees the flag or this thread sees the element
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        condVar.wait(lock, [&]() {
+            return !empty() || isStopped.load(std::memory_order_relaxed);
+        });
+        isConsumerWaiting.store(false, std::memory_order_relaxed);
+        lock.unlock();
+        return tryPop(value);
+    }
+
+    // Wakes the consumer, pop() doesn't wait anymore
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            isStopped.store(true, std::memory_order_relaxed);
+        }
+        condVar.notify_all();
+    }
+
+    // Exact for the producer and the consumer, approximate for other threads
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::size_t next(std::size_t index) const {
+        return index + 1 == elements.size() ? 0 : index + 1;
+    }
+
+    void wakeConsumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (isConsumerWaiting.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+            }
+            condVar.notify_one();
+        }
+    }
+
+    static constexpr int spinCount = 1000;
+
+    std::vector<T> elements; // one element is always free to tell a full ring from an empty one
+    std::atomic<std::size_t> head{0}; // written by the consumer only
+    std::atomic<std::size_t> tail{0}; // written by the producer only
+    std::atomic<bool> isConsumerWaiting{false};
+    std::atomic<bool> isStopped{false};
+    std::mutex mtx;
+    std::condition_variable condVar;
+};
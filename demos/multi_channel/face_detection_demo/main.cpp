@@ -29,11 +29,17 @@
 #include <samples/slog.hpp>
 
 #include "input.hpp"
+#include "source_scheduler.hpp"
 #include "multichannel_params.hpp"
 #include "multichannel_face_detection_params.hpp"
+#include "mosaic.hpp"
 #include "output.hpp"
+#include "queue_planner.hpp"
+#include "placement.hpp"
+#include "sinks.hpp"
 #include "threading.hpp"
 #include "graph.hpp"
+#include "roi_stage.hpp"
 
 namespace {
 
@@ -55,16 +61,32 @@ void showUsage() {
     std::cout << "      -c \"<absolute_path>\"       " << custom_cldnn_message << std::endl;
     std::cout << "    -d \"<device>\"                " << target_device_message << std::endl;
     std::cout << "    -bs                          " << batch_size << std::endl;
+    std::cout << "    -bw                          " << batch_wait_time << std::endl;
     std::cout << "    -nireq                       " << num_infer_requests << std::endl;
     std::cout << "    -n_iqs                       " << input_queue_size << std::endl;
     std::cout << "    -fps_sp                      " << fps_sampling_period << std::endl;
     std::cout << "    -n_sp                        " << num_sampling_periods << std::endl;
     std::cout << "    -pc                          " << performance_counter_message << std::endl;
     std::cout << "    -t                           " << thresh_output_message << std::endl;
+    std::cout << "    -m_ag \"<path>\"               " << age_gender_model_message << std::endl;
+    std::cout << "    -m_lm \"<path>\"               " << landmarks_model_message << std::endl;
+    std::cout << "    -d_roi \"<device>\"            " << roi_device_message << std::endl;
+    std::cout << "    -bs_roi                      " << roi_batch_size_message << std::endl;
+    std::cout << "    -nireq_roi                   " << roi_num_infer_requests_message << std::endl;
     std::cout << "    -no_show                     " << no_show_processed_video << std::endl;
     std::cout << "    -show_stats                  " << show_statistics << std::endl;
     std::cout << "    -real_input_fps              " << real_input_fps << std::endl;
     std::cout << "    -u                           " << utilization_monitors_message << std::endl;
+    std::cout << "    -o \"<path>\"                  " << output_video_message << std::endl;
+    std::cout << "    -o_json \"<path>\"             " << output_json_message << std::endl;
+    std::cout << "    -n_oqs                       " << output_queue_size << std::endl;
+    std::cout << "    -queue_budget_mb             " << queue_budget_message << std::endl;
+    std::cout << "    -adapt_queues                " << adapt_queues_message << std::endl;
+    std::cout << "    -cpus \"<list>\"               " << cpus_message << std::endl;
+    std::cout << "    -publish \"<name>\"            " << publish_message << std::endl;
+    std::cout << "    -map_weights                 " << map_weights_message << std::endl;
+    std::cout << "    -priorities \"<list>\"         " << priorities_message << std::endl;
+    std::cout << "    -min_fps                     " << min_fps_message << std::endl;
 }
 
 bool ParseAndCheckCommandLine(int argc, char *argv[]) {
@@ -97,6 +119,12 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     }
     slog::info << "\tBatch size:                " << FLAGS_bs << slog::endl;
     slog::info << "\tNumber of infer requests:  " << FLAGS_nireq << slog::endl;
+    if (!FLAGS_m_ag.empty()) {
+        slog::info << "\tAge/gender model:          " << FLAGS_m_ag << slog::endl;
+    }
+    if (!FLAGS_m_lm.empty()) {
+        slog::info << "\tLandmarks model:           " << FLAGS_m_lm << slog::endl;
+    }
 
     return true;
 }
@@ -105,7 +133,8 @@ struct Face {
     cv::Rect2f rect;
     float confidence;
     unsigned char age;
-    unsigned char gender;
+    unsigned char gender;  // 0 - female, 1 - male
+    std::vector<cv::Point2f> landmarks;  // relative to the frame like rect
     Face(cv::Rect2f r, float c, unsigned char a, unsigned char g): rect(r), confidence(c), age(a), gender(g) {}
 };
 
@@ -114,9 +143,118 @@ void drawDetections(cv::Mat& img, const std::vector<Face>& detections) {
         cv::Rect ri(static_cast<int>(f.rect.x*img.cols), static_cast<int>(f.rect.y*img.rows),
                     static_cast<int>(f.rect.width*img.cols), static_cast<int>(f.rect.height*img.rows));
         cv::rectangle(img, ri, cv::Scalar(255, 0, 0), 2);
+        if (!FLAGS_m_ag.empty()) {
+            cv::putText(img, (f.gender ? "M," : "F,") + std::to_string(f.age), ri.tl() - cv::Point(0, 4),
+                        cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(255, 0, 0));
+        }
+        for (const cv::Point2f& point : f.landmarks) {
+            cv::circle(img, cv::Point(static_cast<int>(point.x*img.cols), static_cast<int>(point.y*img.rows)),
+                       2, cv::Scalar(0, 255, 255), -1);
+        }
     }
 }
 
+std::string detectionsToJson(const std::vector<Face>& detections) {
+    std::ostringstream json;
+    for (const Face& f : detections) {
+        json << (&f == &detections.front() ? "" : ", ") << "{\"x\": " << f.rect.x << ", \"y\": " << f.rect.y
+             << ", \"width\": " << f.rect.width << ", \"height\": " << f.rect.height
+             << ", \"confidence\": " << f.confidence;
+        if (!FLAGS_m_ag.empty()) {
+            json << ", \"age\": " << static_cast<int>(f.age) << ", \"gender\": \"" << (f.gender ? "M" : "F") << '"';
+        }
+        if (!f.landmarks.empty()) {
+            json << ", \"landmarks\": [";
+            for (const cv::Point2f& point : f.landmarks) {
+                json << (&point == &f.landmarks.front() ? "" : ", ") << '[' << point.x << ", " << point.y << ']';
+            }
+            json << ']';
+        }
+        json << '}';
+    }
+    return json.str();
+}
+
+// Runs the networks of the faces on the faces detected on all frames of a batch at once
+class FacesAnalyzer {
+public:
+    FacesAnalyzer(InferenceEngine::Core& ie, bool collectStats) {
+        RoiStage::InitParams roiParams;
+        roiParams.batchSize = FLAGS_bs_roi;
+        roiParams.maxRequests = FLAGS_nireq_roi;
+        roiParams.collectStats = collectStats;
+        roiParams.deviceName = FLAGS_d_roi;
+        roiParams.mapWeights = FLAGS_map_weights;
+        if (!FLAGS_m_ag.empty()) {
+            roiParams.modelPath = FLAGS_m_ag;
+            ageGender.reset(new RoiStage(ie, roiParams));
+        }
+        if (!FLAGS_m_lm.empty()) {
+            roiParams.modelPath = FLAGS_m_lm;
+            landmarks.reset(new RoiStage(ie, roiParams));
+        }
+    }
+
+    bool empty() const {return !ageGender && !landmarks;}
+
+    void process(const std::vector<std::shared_ptr<VideoFrame>>& vframes) {
+        std::vector<RoiStage::Roi> rois;
+        std::vector<Face*> faces;
+        for (const std::shared_ptr<VideoFrame>& vframe : vframes) {
+            const cv::Mat& frame = vframe->frame;
+            for (Face& face : vframe->detections.get<std::vector<Face>>()) {
+                cv::Rect rect = cv::Rect(static_cast<int>(face.rect.x * frame.cols),
+                                         static_cast<int>(face.rect.y * frame.rows),
+                                         static_cast<int>(face.rect.width * frame.cols),
+                                         static_cast<int>(face.rect.height * frame.rows))
+                                & cv::Rect(0, 0, frame.cols, frame.rows);
+                if (!rect.empty()) {
+                    rois.push_back({frame, rect});
+                    faces.push_back(&face);
+                }
+            }
+        }
+        if (rois.empty()) {
+            return;
+        }
+
+        if (ageGender) {
+            ageGender->process(rois, [&](InferenceEngine::InferRequest& req, const std::vector<std::string>&,
+                                         std::size_t batchIndex, std::size_t roiIndex) {
+                InferenceEngine::LockedMemory<const void> ageMapped = InferenceEngine::as<
+                    InferenceEngine::MemoryBlob>(req.GetBlob("age_conv3"))->rmap();
+                InferenceEngine::LockedMemory<const void> genderMapped = InferenceEngine::as<
+                    InferenceEngine::MemoryBlob>(req.GetBlob("prob"))->rmap();
+                const float* genderData = genderMapped.as<const float*>() + batchIndex * 2;
+                Face& face = *faces[roiIndex];
+                face.age = cv::saturate_cast<unsigned char>(ageMapped.as<const float*>()[batchIndex] * 100);
+                face.gender = genderData[1] > genderData[0] ? 1 : 0;
+            });
+        }
+        if (landmarks) {
+            landmarks->process(rois, [&](InferenceEngine::InferRequest& req, const std::vector<std::string>& outputNames,
+                                         std::size_t batchIndex, std::size_t roiIndex) {
+                InferenceEngine::Blob::Ptr blob = req.GetBlob(outputNames[0]);
+                const std::size_t pointsNumber = blob->getTensorDesc().getDims()[1] / 2;
+                InferenceEngine::LockedMemory<const void> mapped = InferenceEngine::as<
+                    InferenceEngine::MemoryBlob>(blob)->rmap();
+                const float* data = mapped.as<const float*>() + batchIndex * pointsNumber * 2;
+                // The points are relative to the face, they are converted to be relative to the frame
+                const RoiStage::Roi& roi = rois[roiIndex];
+                Face& face = *faces[roiIndex];
+                face.landmarks.resize(pointsNumber);
+                for (std::size_t i = 0; i < pointsNumber; ++i) {
+                    face.landmarks[i] = {(roi.rect.x + data[2 * i] * roi.rect.width) / roi.frame.cols,
+                                         (roi.rect.y + data[2 * i + 1] * roi.rect.height) / roi.frame.rows};
+                }
+            });
+        }
+    }
+
+    std::unique_ptr<RoiStage> ageGender;
+    std::unique_ptr<RoiStage> landmarks;
+};
+
 const size_t DISP_WIDTH  = 1920;
 const size_t DISP_HEIGHT = 1080;
 const size_t MAX_INPUTS  = 25;
@@ -155,18 +293,9 @@ void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
                      float time,
                      const std::string& stats,
                      DisplayParams params,
-                     Presenter& presenter) {
-    cv::Mat windowImage = cv::Mat::zeros(params.windowSize, CV_8UC3);
-    auto loopBody = [&](size_t i) {
-        auto& elem = data[i];
-        if (!elem->frame.empty()) {
-            cv::Rect rectFrame = cv::Rect(params.points[i], params.frameSize);
-            cv::Mat windowPart = windowImage(rectFrame);
-            cv::resize(elem->frame, windowPart, params.frameSize);
-            drawDetections(windowPart, elem->detections.get<std::vector<Face>>());
-        }
-    };
-
+                     Presenter& presenter,
+                     Mosaic& mosaic,
+                     cv::Mat& windowImage) {
     auto drawStats = [&]() {
         if (FLAGS_show_stats && !stats.empty()) {
             static const cv::Point posPoint = cv::Point(3*DISP_WIDTH/4, 4*DISP_HEIGHT/5);
@@ -184,18 +313,9 @@ void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
         }
     };
 
-//  #ifdef USE_TBB
-#if 0  // disable multithreaded rendering for now
-    run_in_arena([&](){
-        tbb::parallel_for<size_t>(0, data.size(), [&](size_t i) {
-            loopBody(i);
-        });
-    });
-#else
-    for (size_t i = 0; i < data.size(); ++i) {
-        loopBody(i);
-    }
-#endif
+    mosaic.render(data, [&](cv::Mat& tile, const VideoFrame& frame) {
+        drawDetections(tile, frame.detections.get<std::vector<Face>>());
+    }, windowImage);
     presenter.drawGraphs(windowImage);
     drawStats();
 
@@ -220,6 +340,14 @@ int main(int argc, char* argv[]) {
             return 0;
         }
 
+        // Before any engine starts its threads, so they inherit the cores and the memory node
+        std::vector<unsigned> cores;
+        if (!FLAGS_cpus.empty()) {
+            cores = parseCpuList(FLAGS_cpus);
+            bindToCores(cores);
+            slog::info << "Bound to " << cores.size() << " cores" << slog::endl;
+        }
+
         std::string modelPath = FLAGS_m;
         std::size_t found = modelPath.find_last_of(".");
         if (found > modelPath.size()) {
@@ -231,13 +359,20 @@ int main(int argc, char* argv[]) {
 
         IEGraph::InitParams graphParams;
         graphParams.batchSize       = FLAGS_bs;
+        graphParams.maxBatchWaitTime = std::chrono::milliseconds(FLAGS_bw);
         graphParams.maxRequests     = FLAGS_nireq;
         graphParams.collectStats    = FLAGS_show_stats;
         graphParams.reportPerf      = FLAGS_pc;
         graphParams.modelPath       = modelPath;
+        graphParams.mapWeights      = FLAGS_map_weights;
         graphParams.cpuExtPath      = FLAGS_l;
         graphParams.cldnnConfigPath = FLAGS_c;
         graphParams.deviceName      = FLAGS_d;
+        graphParams.cpuThreadsNum   = static_cast<unsigned>(cores.size());
+
+        // The stages of the faces are used by the network, so they are destroyed after it
+        InferenceEngine::Core roiIe;
+        FacesAnalyzer facesAnalyzer(roiIe, FLAGS_show_stats);
 
         std::shared_ptr<IEGraph> network(new IEGraph(graphParams));
         auto inputDims = network->getInputDims();
@@ -251,6 +386,8 @@ int main(int argc, char* argv[]) {
         vsParams.queueSize            = FLAGS_n_iqs;
         vsParams.collectStats         = FLAGS_show_stats;
         vsParams.realFps              = FLAGS_real_input_fps;
+        vsParams.publishName          = FLAGS_publish;
+        vsParams.vaDisplay            = network->getVaDisplay();
         vsParams.expectedHeight = static_cast<unsigned>(inputDims[2]);
         vsParams.expectedWidth  = static_cast<unsigned>(inputDims[3]);
 
@@ -258,13 +395,20 @@ int main(int argc, char* argv[]) {
         DisplayParams params = prepareDisplayParams(sources.numberOfInputs() * FLAGS_duplicate_num);
         sources.start();
 
-        size_t currentFrame = 0;
+        SourceScheduler scheduler(parsePriorities(FLAGS_priorities, sources.numberOfInputs() * FLAGS_duplicate_num),
+                                  FLAGS_min_fps);
 
+        std::vector<bool> readyChannels(sources.numberOfInputs() * FLAGS_duplicate_num);
         network->start([&](VideoFrame& img) {
-            img.sourceIdx = currentFrame;
-            size_t camIdx = currentFrame / FLAGS_duplicate_num;
-            currentFrame = (currentFrame + 1) % (sources.numberOfInputs() * FLAGS_duplicate_num);
-            return sources.getFrame(camIdx, img);
+            // The next channel is chosen among the ones having a frame, so a slow input doesn't hold the others
+            return sources.getAnyFrame(img, [&](const std::vector<bool>& readyInputs) {
+                for (size_t channel = 0; channel < readyChannels.size(); channel++) {
+                    readyChannels[channel] = readyInputs[channel / FLAGS_duplicate_num];
+                }
+                size_t channel = scheduler.next(readyChannels);
+                img.sourceIdx = channel;
+                return channel / FLAGS_duplicate_num;
+            });
         }, [](InferenceEngine::InferRequest::Ptr req, const std::vector<std::string>& outputDataBlobNames, cv::Size frameSize) {
             auto output = req->GetBlob(outputDataBlobNames[0]);
 
@@ -297,7 +441,10 @@ int main(int argc, char* argv[]) {
                 }
             }
             return detections;
-        });
+        }, params.frameSize, facesAnalyzer.empty() ? IEGraph::ChainedStageFunc() :
+            [&facesAnalyzer](const std::vector<std::shared_ptr<VideoFrame>>& vframes) {
+                facesAnalyzer.process(vframes);
+            });
 
         network->setDetectionConfidence(static_cast<float>(FLAGS_t));
 
@@ -316,6 +463,8 @@ int main(int argc, char* argv[]) {
 
         cv::Size graphSize{static_cast<int>(params.windowSize.width / 4), 60};
         Presenter presenter(FLAGS_u, params.windowSize.height - graphSize.height - 10, graphSize);
+        Mosaic mosaic(params.windowSize, {params.points, params.points + params.count}, params.frameSize);
+        cv::Mat windowImage;
 
         const size_t outputQueueSize = 1;
         AsyncOutput output(FLAGS_show_stats, outputQueueSize,
@@ -325,7 +474,7 @@ int main(int argc, char* argv[]) {
                 std::unique_lock<std::mutex> lock(statMutex);
                 str = statStream.str();
             }
-            displayNSources(result, averageFps, str, params, presenter);
+            displayNSources(result, averageFps, str, params, presenter, mosaic, windowImage);
             int key = cv::waitKey(1);
             presenter.handleKey(key);
 
@@ -334,6 +483,27 @@ int main(int argc, char* argv[]) {
 
         output.start();
 
+        std::vector<std::unique_ptr<AsyncOutput>> sinks;
+        if (!FLAGS_o.empty()) {
+            sinks.push_back(makeVideoSink(FLAGS_o, FLAGS_n_oqs, FLAGS_show_stats, params.windowSize,
+                {params.points, params.points + params.count}, params.frameSize,
+                [](cv::Mat& tile, const VideoFrame& frame) {
+                    drawDetections(tile, frame.detections.get<std::vector<Face>>());
+                }));
+        }
+        if (!FLAGS_o_json.empty()) {
+            sinks.push_back(makeJsonSink(FLAGS_o_json, FLAGS_n_oqs, FLAGS_show_stats, [](const VideoFrame& frame) {
+                return detectionsToJson(frame.detections.get<std::vector<Face>>());
+            }));
+        }
+
+        // Without a budget the queues keep the sizes of -n_iqs and -n_oqs
+        std::unique_ptr<PipelineQueues> queues;
+        if (FLAGS_queue_budget_mb) {
+            queues.reset(new PipelineQueues(size_t{FLAGS_queue_budget_mb} << 20, FLAGS_adapt_queues, sources,
+                                            FLAGS_n_iqs, sinks, FLAGS_n_oqs, FLAGS_nireq, inputDims));
+        }
+
         using timer = std::chrono::high_resolution_clock;
         using duration = std::chrono::duration<float, std::milli>;
         timer::time_point lastTime = timer::now();
@@ -346,7 +516,7 @@ int main(int argc, char* argv[]) {
         while (sources.isRunning() || network->isRunning()) {
             bool readData = true;
             while (readData) {
-                auto br = network->getBatchData(params.frameSize);
+                auto br = network->getBatchData();
                 if (br.empty()) {
                     break; // IEGraph::getBatchData had nothing to process and returned. That means it was stopped
                 }
@@ -356,6 +526,12 @@ int main(int argc, char* argv[]) {
                     auto val = static_cast<unsigned int>(br[i]->sourceIdx);
                     auto it = find_if(batchRes.begin(), batchRes.end(), [val] (const std::shared_ptr<VideoFrame>& vf) { return vf->sourceIdx == val; } );
                     if (it != batchRes.end()) {
+                        if (queues) {
+                            queues->update(batchRes);
+                        }
+                        for (std::unique_ptr<AsyncOutput>& sink : sinks) {
+                            sink->push(std::vector<std::shared_ptr<VideoFrame>>(batchRes));
+                        }
                         if (!FLAGS_no_show) {
                             output.push(std::move(batchRes));
                         }
@@ -367,7 +543,8 @@ int main(int argc, char* argv[]) {
             }
             ++fpsCounter;
 
-            if (!output.isAlive()) {
+            if (!output.isAlive() || std::any_of(sinks.begin(), sinks.end(),
+                    [](const std::unique_ptr<AsyncOutput>& sink) {return !sink->isAlive();})) {
                 break;
             }
 
@@ -412,11 +589,25 @@ int main(int argc, char* argv[]) {
                                << inferStat.preprocessTime << "ms";
                     statStream << std::endl;
                     statStream << "Plugin latency: "
-                               << inferStat.inferTime << "ms";
+                               << inferStat.inferTime << "ms (p99 " << inferStat.inferTimeP99
+                               << "ms, max " << inferStat.inferTimeMax << "ms)";
+                    statStream << std::endl;
+                    statStream << "Batch fill: "
+                               << inferStat.batchFillRatio * 100 << "%";
                     statStream << std::endl;
 
+                    if (facesAnalyzer.ageGender) {
+                        statStream << "Age/gender latency: " << facesAnalyzer.ageGender->getAvgInferTime() << "ms";
+                        statStream << std::endl;
+                    }
+                    if (facesAnalyzer.landmarks) {
+                        statStream << "Landmarks latency: " << facesAnalyzer.landmarks->getAvgInferTime() << "ms";
+                        statStream << std::endl;
+                    }
+
                     statStream << "Render time: " << outputStat.renderTime
-                               << "ms" << std::endl;
+                               << "ms (p99 " << outputStat.renderTimeP99
+                               << "ms, max " << outputStat.renderTimeMax << "ms)" << std::endl;
 
                     if (FLAGS_no_show) {
                         slog::info << statStream.str() << slog::endl;
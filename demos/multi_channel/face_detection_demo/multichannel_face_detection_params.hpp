@@ -9,5 +9,18 @@
 #include <gflags/gflags.h>
 
 static const char thresh_output_message[] = "Optional. Probability threshold for detections";
+static const char age_gender_model_message[] = "Optional. Path to an .xml file with an age/gender recognition model. "
+    "It runs on the detected faces";
+static const char landmarks_model_message[] = "Optional. Path to an .xml file with a facial landmarks regression "
+    "model. It runs on the detected faces";
+static const char roi_device_message[] = "Optional. Target device for the networks of the faces. Default value is CPU";
+static const char roi_batch_size_message[] = "Optional. Maximum number of faces of all channels inferred per infer "
+    "request of the networks of the faces. If it's greater than 1, the device has to support dynamic batching";
+static const char roi_num_infer_requests_message[] = "Optional. Number of infer requests of every network of the faces";
 
 DEFINE_double(t, 0.5, thresh_output_message);
+DEFINE_string(m_ag, "", age_gender_model_message);
+DEFINE_string(m_lm, "", landmarks_model_message);
+DEFINE_string(d_roi, "CPU", roi_device_message);
+DEFINE_uint32(bs_roi, 16, roi_batch_size_message);
+DEFINE_uint32(nireq_roi, 2, roi_num_infer_requests_message);
@@ -22,6 +22,7 @@
 #include <vector>
 #include <utility>
 
+#include <algorithm>
 #include <mutex>
 #include <atomic>
 #include <queue>
@@ -41,8 +42,14 @@
 #include <samples/args_helper.hpp>
 
 #include "input.hpp"
+#include "source_scheduler.hpp"
 #include "multichannel_params.hpp"
+#include "multichannel_human_pose_estimation_params.hpp"
+#include "mosaic.hpp"
 #include "output.hpp"
+#include "queue_planner.hpp"
+#include "placement.hpp"
+#include "sinks.hpp"
 #include "threading.hpp"
 #include "graph.hpp"
 
@@ -72,6 +79,7 @@ void showUsage() {
     std::cout << "      -c \"<absolute_path>\"       " << custom_cldnn_message << std::endl;
     std::cout << "    -d \"<device>\"                " << target_device_message << std::endl;
     std::cout << "    -bs                          " << batch_size << std::endl;
+    std::cout << "    -bw                          " << batch_wait_time << std::endl;
     std::cout << "    -nireq                       " << num_infer_requests << std::endl;
     std::cout << "    -n_iqs                       " << input_queue_size << std::endl;
     std::cout << "    -fps_sp                      " << fps_sampling_period << std::endl;
@@ -81,6 +89,17 @@ void showUsage() {
     std::cout << "    -show_stats                  " << show_statistics << std::endl;
     std::cout << "    -real_input_fps              " << real_input_fps << std::endl;
     std::cout << "    -u                           " << utilization_monitors_message << std::endl;
+    std::cout << "    -o \"<path>\"                  " << output_video_message << std::endl;
+    std::cout << "    -o_json \"<path>\"             " << output_json_message << std::endl;
+    std::cout << "    -n_oqs                       " << output_queue_size << std::endl;
+    std::cout << "    -queue_budget_mb             " << queue_budget_message << std::endl;
+    std::cout << "    -adapt_queues                " << adapt_queues_message << std::endl;
+    std::cout << "    -cpus \"<list>\"               " << cpus_message << std::endl;
+    std::cout << "    -publish \"<name>\"            " << publish_message << std::endl;
+    std::cout << "    -map_weights                 " << map_weights_message << std::endl;
+    std::cout << "    -priorities \"<list>\"         " << priorities_message << std::endl;
+    std::cout << "    -min_fps                     " << min_fps_message << std::endl;
+    std::cout << "    -sparse_pp                   " << sparse_postprocessing_message << std::endl;
 }
 
 bool ParseAndCheckCommandLine(int argc, char *argv[]) {
@@ -116,6 +135,25 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     return true;
 }
 
+// Keypoints are relative to the frame, a missing keypoint is null
+std::string posesToJson(const std::vector<HumanPose>& poses, cv::Size frameSize) {
+    std::ostringstream json;
+    for (const HumanPose& pose : poses) {
+        json << (&pose == &poses.front() ? "" : ", ") << "{\"keypoints\": [";
+        for (std::size_t i = 0; i < pose.keypoints.size(); ++i) {
+            const cv::Point2f& keypoint = pose.keypoints[i];
+            json << (0 == i ? "" : ", ");
+            if (keypoint == cv::Point2f(-1, -1)) {
+                json << "null";
+            } else {
+                json << "[" << keypoint.x / frameSize.width << ", " << keypoint.y / frameSize.height << "]";
+            }
+        }
+        json << "], \"score\": " << pose.score << "}";
+    }
+    return json.str();
+}
+
 const size_t DISP_WIDTH  = 1920;
 const size_t DISP_HEIGHT = 1080;
 const size_t MAX_INPUTS  = 25;
@@ -154,18 +192,9 @@ void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
                      float time,
                      const std::string& stats,
                      DisplayParams params,
-                     Presenter& presenter) {
-    cv::Mat windowImage = cv::Mat::zeros(params.windowSize, CV_8UC3);
-    auto loopBody = [&](size_t i) {
-        auto& elem = data[i];
-        if (!elem->frame.empty()) {
-            cv::Rect rectFrame = cv::Rect(params.points[i], params.frameSize);
-            cv::Mat windowPart = windowImage(rectFrame);
-            cv::resize(elem->frame, windowPart, params.frameSize);
-            renderHumanPose(elem->detections.get<std::vector<HumanPose>>(), windowPart);
-        }
-    };
-
+                     Presenter& presenter,
+                     Mosaic& mosaic,
+                     cv::Mat& windowImage) {
     auto drawStats = [&]() {
         if (FLAGS_show_stats && !stats.empty()) {
             static const cv::Point posPoint = cv::Point(3*DISP_WIDTH/4, 4*DISP_HEIGHT/5);
@@ -183,18 +212,9 @@ void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
         }
     };
 
-//  #ifdef USE_TBB
-#if 0  // disable multithreaded rendering for now
-    run_in_arena([&](){
-        tbb::parallel_for<size_t>(0, data.size(), [&](size_t i) {
-            loopBody(i);
-        });
-    });
-#else
-    for (size_t i = 0; i < data.size(); ++i) {
-        loopBody(i);
-    }
-#endif
+    mosaic.render(data, [&](cv::Mat& tile, const VideoFrame& frame) {
+        renderHumanPose(frame.detections.get<std::vector<HumanPose>>(), tile);
+    }, windowImage);
     presenter.drawGraphs(windowImage);
     drawStats();
 
@@ -219,6 +239,14 @@ int main(int argc, char* argv[]) {
             return 0;
         }
 
+        // Before any engine starts its threads, so they inherit the cores and the memory node
+        std::vector<unsigned> cores;
+        if (!FLAGS_cpus.empty()) {
+            cores = parseCpuList(FLAGS_cpus);
+            bindToCores(cores);
+            slog::info << "Bound to " << cores.size() << " cores" << slog::endl;
+        }
+
         std::string modelPath = FLAGS_m;
         std::size_t found = modelPath.find_last_of(".");
         if (found > modelPath.size()) {
@@ -230,13 +258,16 @@ int main(int argc, char* argv[]) {
 
         IEGraph::InitParams graphParams;
         graphParams.batchSize       = FLAGS_bs;
+        graphParams.maxBatchWaitTime = std::chrono::milliseconds(FLAGS_bw);
         graphParams.maxRequests     = FLAGS_nireq;
         graphParams.collectStats    = FLAGS_show_stats;
         graphParams.reportPerf      = FLAGS_pc;
         graphParams.modelPath       = modelPath;
+        graphParams.mapWeights      = FLAGS_map_weights;
         graphParams.cpuExtPath      = FLAGS_l;
         graphParams.cldnnConfigPath = FLAGS_c;
         graphParams.deviceName      = FLAGS_d;
+        graphParams.cpuThreadsNum   = static_cast<unsigned>(cores.size());
 
         std::shared_ptr<IEGraph> network(new IEGraph(graphParams));
         auto inputDims = network->getInputDims();
@@ -250,6 +281,8 @@ int main(int argc, char* argv[]) {
         vsParams.queueSize            = FLAGS_n_iqs;
         vsParams.collectStats         = FLAGS_show_stats;
         vsParams.realFps              = FLAGS_real_input_fps;
+        vsParams.publishName          = FLAGS_publish;
+        vsParams.vaDisplay            = network->getVaDisplay();
         vsParams.expectedHeight = static_cast<unsigned>(inputDims[2]);
         vsParams.expectedWidth  = static_cast<unsigned>(inputDims[3]);
 
@@ -257,13 +290,20 @@ int main(int argc, char* argv[]) {
         DisplayParams params = prepareDisplayParams(sources.numberOfInputs() * FLAGS_duplicate_num);
         sources.start();
 
-        size_t currentFrame = 0;
+        SourceScheduler scheduler(parsePriorities(FLAGS_priorities, sources.numberOfInputs() * FLAGS_duplicate_num),
+                                  FLAGS_min_fps);
 
+        std::vector<bool> readyChannels(sources.numberOfInputs() * FLAGS_duplicate_num);
         network->start([&](VideoFrame& img) {
-            img.sourceIdx = currentFrame;
-            size_t camIdx = currentFrame / FLAGS_duplicate_num;
-            currentFrame = (currentFrame + 1) % (sources.numberOfInputs() * FLAGS_duplicate_num);
-            return sources.getFrame(camIdx, img);
+            // The next channel is chosen among the ones having a frame, so a slow input doesn't hold the others
+            return sources.getAnyFrame(img, [&](const std::vector<bool>& readyInputs) {
+                for (size_t channel = 0; channel < readyChannels.size(); channel++) {
+                    readyChannels[channel] = readyInputs[channel / FLAGS_duplicate_num];
+                }
+                size_t channel = scheduler.next(readyChannels);
+                img.sourceIdx = channel;
+                return channel / FLAGS_duplicate_num;
+            });
         }, [](InferenceEngine::InferRequest::Ptr req, const std::vector<std::string>& outputDataBlobNames, cv::Size frameSize) {
             auto pafsBlobIt   = req->GetBlob(outputDataBlobNames[0]);
             auto pafsDesc     = pafsBlobIt->getTensorDesc();
@@ -284,23 +324,36 @@ int main(int argc, char* argv[]) {
                 InferenceEngine::MemoryBlob>(heatMapsBlobIt)->rmap();
             InferenceEngine::LockedMemory<const void> pafsBlobMapped = InferenceEngine::as<
                 InferenceEngine::MemoryBlob>(pafsBlobIt)->rmap();
-            for (size_t i = 0; i < pafsBatch; i++) {
-                std::vector<HumanPose> poses = postprocess(
-                heatMapsBlobMapped.as<float*>() + i * heatMapsWidth * heatMapsHeight * heatMapsChannels,
-                heatMapsWidth * heatMapsHeight,
-                keypointsNumber,
-                pafsBlobMapped.as<float*>() + i * pafsWidth * pafsHeight * pafsChannels,
-                pafsWidth * pafsHeight,
-                pafsChannels,
-                heatMapsWidth, heatMapsHeight, frameSize);
-
-                detections[i].set(new std::vector<HumanPose>(poses.size()));
-                for (decltype(poses.size()) j = 0; j < poses.size(); j++) {
-                    detections[i].get<std::vector<HumanPose>>()[j] = std::move(poses[j]);
-                }
+            // Poses of the batch images are found in parallel, every image is processed by one thread
+            auto extractPoses = [&](size_t i) {
+                std::vector<HumanPose>* poses = new std::vector<HumanPose>(postprocess(
+                    heatMapsBlobMapped.as<float*>() + i * heatMapsWidth * heatMapsHeight * heatMapsChannels,
+                    heatMapsWidth * heatMapsHeight,
+                    keypointsNumber,
+                    pafsBlobMapped.as<float*>() + i * pafsWidth * pafsHeight * pafsChannels,
+                    pafsWidth * pafsHeight,
+                    pafsChannels,
+                    heatMapsWidth, heatMapsHeight, frameSize, FLAGS_sparse_pp));
+                detections[i].set(poses);
+            };
+            if (1 == pafsBatch) {
+                // The single image is processed by the current thread, so peaks search runs in parallel inside it
+                extractPoses(0);
+            } else {
+#ifdef USE_TBB
+                run_in_arena([&]() {
+                    tbb::parallel_for<size_t>(0, pafsBatch, extractPoses);
+                });
+#else
+                cv::parallel_for_(cv::Range(0, static_cast<int>(pafsBatch)), [&](const cv::Range& range) {
+                    for (int i = range.start; i < range.end; i++) {
+                        extractPoses(static_cast<size_t>(i));
+                    }
+                });
+#endif
             }
             return detections;
-        });
+        }, params.frameSize);
 
         std::atomic<float> averageFps = {0.0f};
 
@@ -317,6 +370,8 @@ int main(int argc, char* argv[]) {
 
         cv::Size graphSize{static_cast<int>(params.windowSize.width / 4), 60};
         Presenter presenter(FLAGS_u, params.windowSize.height - graphSize.height - 10, graphSize);
+        Mosaic mosaic(params.windowSize, {params.points, params.points + params.count}, params.frameSize);
+        cv::Mat windowImage;
 
         const size_t outputQueueSize = 1;
         AsyncOutput output(FLAGS_show_stats, outputQueueSize,
@@ -326,7 +381,7 @@ int main(int argc, char* argv[]) {
                 std::unique_lock<std::mutex> lock(statMutex);
                 str = statStream.str();
             }
-            displayNSources(result, averageFps, str, params, presenter);
+            displayNSources(result, averageFps, str, params, presenter, mosaic, windowImage);
             int key = cv::waitKey(1);
             presenter.handleKey(key);
 
@@ -335,6 +390,27 @@ int main(int argc, char* argv[]) {
 
         output.start();
 
+        std::vector<std::unique_ptr<AsyncOutput>> sinks;
+        if (!FLAGS_o.empty()) {
+            sinks.push_back(makeVideoSink(FLAGS_o, FLAGS_n_oqs, FLAGS_show_stats, params.windowSize,
+                {params.points, params.points + params.count}, params.frameSize,
+                [](cv::Mat& tile, const VideoFrame& frame) {
+                    renderHumanPose(frame.detections.get<std::vector<HumanPose>>(), tile);
+                }));
+        }
+        if (!FLAGS_o_json.empty()) {
+            sinks.push_back(makeJsonSink(FLAGS_o_json, FLAGS_n_oqs, FLAGS_show_stats, [&params](const VideoFrame& frame) {
+                return posesToJson(frame.detections.get<std::vector<HumanPose>>(), params.frameSize);
+            }));
+        }
+
+        // Without a budget the queues keep the sizes of -n_iqs and -n_oqs
+        std::unique_ptr<PipelineQueues> queues;
+        if (FLAGS_queue_budget_mb) {
+            queues.reset(new PipelineQueues(size_t{FLAGS_queue_budget_mb} << 20, FLAGS_adapt_queues, sources,
+                                            FLAGS_n_iqs, sinks, FLAGS_n_oqs, FLAGS_nireq, inputDims));
+        }
+
         using timer = std::chrono::high_resolution_clock;
         using duration = std::chrono::duration<float, std::milli>;
         timer::time_point lastTime = timer::now();
@@ -347,7 +423,7 @@ int main(int argc, char* argv[]) {
         while (sources.isRunning() || network->isRunning()) {
             bool readData = true;
             while (readData) {
-                auto br = network->getBatchData(params.frameSize);
+                auto br = network->getBatchData();
                 if (br.empty()) {
                     break; // IEGraph::getBatchData had nothing to process and returned. That means it was stopped
                 }
@@ -357,6 +433,12 @@ int main(int argc, char* argv[]) {
                     auto val = static_cast<unsigned int>(br[i]->sourceIdx);
                     auto it = find_if(batchRes.begin(), batchRes.end(), [val] (const std::shared_ptr<VideoFrame>& vf) { return vf->sourceIdx == val; } );
                     if (it != batchRes.end()) {
+                        if (queues) {
+                            queues->update(batchRes);
+                        }
+                        for (std::unique_ptr<AsyncOutput>& sink : sinks) {
+                            sink->push(std::vector<std::shared_ptr<VideoFrame>>(batchRes));
+                        }
                         if (!FLAGS_no_show) {
                             output.push(std::move(batchRes));
                         }
@@ -368,7 +450,8 @@ int main(int argc, char* argv[]) {
             }
             ++fpsCounter;
 
-            if (!output.isAlive()) {
+            if (!output.isAlive() || std::any_of(sinks.begin(), sinks.end(),
+                    [](const std::unique_ptr<AsyncOutput>& sink) {return !sink->isAlive();})) {
                 break;
             }
 
@@ -413,11 +496,16 @@ int main(int argc, char* argv[]) {
                                << inferStat.preprocessTime << "ms";
                     statStream << std::endl;
                     statStream << "Plugin latency: "
-                               << inferStat.inferTime << "ms";
+                               << inferStat.inferTime << "ms (p99 " << inferStat.inferTimeP99
+                               << "ms, max " << inferStat.inferTimeMax << "ms)";
+                    statStream << std::endl;
+                    statStream << "Batch fill: "
+                               << inferStat.batchFillRatio * 100 << "%";
                     statStream << std::endl;
 
                     statStream << "Render time: " << outputStat.renderTime
-                               << "ms" << std::endl;
+                               << "ms (p99 " << outputStat.renderTimeP99
+                               << "ms, max " << outputStat.renderTimeMax << "ms)" << std::endl;
 
                     if (FLAGS_no_show) {
                         slog::info << statStream.str() << slog::endl;
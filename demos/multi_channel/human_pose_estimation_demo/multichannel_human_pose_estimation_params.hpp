@@ -0,0 +1,12 @@
+// Copyright (C) 2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+static const char sparse_postprocessing_message[] = "Optional. Find poses on the feature maps of the network "
+    "resolution instead of upsampled ones. It's faster and the keypoints are slightly less precise";
+
+DEFINE_bool(sparse_pp, false, sparse_postprocessing_message);
@@ -24,14 +24,15 @@ namespace {
 class FindPeaksBody: public cv::ParallelLoopBody {
 public:
     FindPeaksBody(const std::vector<cv::Mat>& heatMaps, float minPeaksDistance,
-                  std::vector<std::vector<Peak> >& peaksFromHeatMap)
+                  std::vector<std::vector<Peak> >& peaksFromHeatMap, int featureMapsScale)
         : heatMaps(heatMaps),
           minPeaksDistance(minPeaksDistance),
-          peaksFromHeatMap(peaksFromHeatMap) {}
+          peaksFromHeatMap(peaksFromHeatMap),
+          featureMapsScale(featureMapsScale) {}
 
     void operator()(const cv::Range& range) const override {
         for (int i = range.start; i < range.end; i++) {
-            findPeaks(heatMaps, minPeaksDistance, peaksFromHeatMap, i);
+            findPeaks(heatMaps, minPeaksDistance, peaksFromHeatMap, i, featureMapsScale);
         }
     }
 
@@ -39,6 +40,7 @@ private:
     const std::vector<cv::Mat>& heatMaps;
     float minPeaksDistance;
     std::vector<std::vector<Peak> >& peaksFromHeatMap;
+    int featureMapsScale;
 };
 
 int upsampleRatio = 4;
@@ -53,9 +55,10 @@ float minSubsetScore = 0.2f;
 
 std::vector<HumanPose> extractPoses(
         const std::vector<cv::Mat>& heatMaps,
-        const std::vector<cv::Mat>& pafs) {
+        const std::vector<cv::Mat>& pafs,
+        int featureMapsScale) {
     std::vector<std::vector<Peak> > peaksFromHeatMap(heatMaps.size());
-    FindPeaksBody findPeaksBody(heatMaps, minPeaksDistance, peaksFromHeatMap);
+    FindPeaksBody findPeaksBody(heatMaps, minPeaksDistance, peaksFromHeatMap, featureMapsScale);
     cv::parallel_for_(cv::Range(0, static_cast<int>(heatMaps.size())),
                       findPeaksBody);
     int peaksBefore = 0;
@@ -67,7 +70,7 @@ std::vector<HumanPose> extractPoses(
     }
     std::vector<HumanPose> poses = groupPeaksToPoses(
                 peaksFromHeatMap, pafs, keypointsNumber, midPointsScoreThreshold,
-                foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore);
+                foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore, featureMapsScale);
     return poses;
 }
 }  // namespace
@@ -76,7 +79,7 @@ std::vector<HumanPose> postprocess(
         const float* heatMapsData, const int heatMapOffset, const int nHeatMaps,
         const float* pafsData, const int pafOffset, const int nPafs,
         const int featureMapWidth, const int featureMapHeight,
-        const cv::Size& imageSize) {
+        const cv::Size& imageSize, bool sparse) {
     std::vector<cv::Mat> heatMaps(nHeatMaps);
     for (size_t i = 0; i < heatMaps.size(); i++) {
         heatMaps[i] = cv::Mat(featureMapHeight, featureMapWidth, CV_32FC1,
@@ -84,7 +87,9 @@ std::vector<HumanPose> postprocess(
                                   const_cast<float*>(
                                       heatMapsData + i * heatMapOffset)));
     }
-    postprocessor.resizeFeatureMaps(heatMaps);
+    if (!sparse) {
+        postprocessor.resizeFeatureMaps(heatMaps);
+    }
 
     std::vector<cv::Mat> pafs(nPafs);
     for (size_t i = 0; i < pafs.size(); i++) {
@@ -93,9 +98,13 @@ std::vector<HumanPose> postprocess(
                               const_cast<float*>(
                                   pafsData + i * pafOffset)));
     }
-    postprocessor.resizeFeatureMaps(pafs);
+    if (!sparse) {
+        postprocessor.resizeFeatureMaps(pafs);
+    }
 
-    std::vector<HumanPose> poses = extractPoses(heatMaps, pafs);
-    postprocessor.correctCoordinates(poses, heatMaps[0].size(), imageSize);
+    // The peaks are in the coordinates of the upsampled maps either way
+    const int featureMapsScale = sparse ? upsampleRatio : 1;
+    std::vector<HumanPose> poses = extractPoses(heatMaps, pafs, featureMapsScale);
+    postprocessor.correctCoordinates(poses, heatMaps[0].size() * featureMapsScale, imageSize);
     return poses;
 }
@@ -24,8 +24,9 @@
 
 size_t constexpr keypointsNumber = 18;
 
+// Sparse postprocessing finds the poses on the feature maps of the network resolution instead of upsampled ones
 std::vector<HumanPose> postprocess(
         float const* heatMapsData, int const heatMapOffset, int const nHeatMaps,
         float const* pafsData, int const pafOffset, int const nPafs,
         int const featureMapWidth, int const featureMapHeight,
-        cv::Size const& imageSize);
+        cv::Size const& imageSize, bool sparse = false);
@@ -14,6 +14,8 @@
 // limitations under the License.
 */
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -51,8 +53,20 @@ void renderHumanPose(const std::vector<HumanPose>& poses, cv::Mat& image) {
             }
         }
     }
-    cv::Mat pane = image.clone();
+    // The limbs are blended with the image. Blending changes only the pixels of the limbs, so every group of poses
+    // with overlapping bounding rectangles is blended in its rectangle instead of the whole image
+    struct Limb {
+        std::vector<cv::Point> polygon;
+        cv::Scalar color;
+    };
+    struct LimbGroup {
+        std::vector<Limb> limbs;
+        cv::Rect roi;
+    };
+    const cv::Rect imageRect(0, 0, image.cols, image.rows);
+    std::vector<LimbGroup> groups;
     for (const auto& pose : poses) {
+        LimbGroup group;
         for (const auto& limbKeypointsId : limbKeypointsIds) {
             std::pair<cv::Point2f, cv::Point2f> limbKeypoints(pose.keypoints[limbKeypointsId.first],
                     pose.keypoints[limbKeypointsId.second]);
@@ -66,11 +80,42 @@ void renderHumanPose(const std::vector<HumanPose>& poses, cv::Mat& image) {
             cv::Point difference = limbKeypoints.first - limbKeypoints.second;
             double length = std::sqrt(difference.x * difference.x + difference.y * difference.y);
             int angle = static_cast<int>(std::atan2(difference.y, difference.x) * 180 / CV_PI);
-            std::vector<cv::Point> polygon;
+            Limb limb{{}, colors[limbKeypointsId.second]};
             cv::ellipse2Poly(cv::Point2d(meanX, meanY), cv::Size2d(length / 2, stickWidth),
-                             angle, 0, 360, 1, polygon);
-            cv::fillConvexPoly(pane, polygon, colors[limbKeypointsId.second]);
+                             angle, 0, 360, 1, limb.polygon);
+            group.roi |= cv::boundingRect(limb.polygon);
+            group.limbs.push_back(std::move(limb));
+        }
+        group.roi &= imageRect;
+        if (group.roi.area() > 0) {
+            groups.push_back(std::move(group));
+        }
+    }
+    // A grown rectangle may overlap the groups checked before, so merge until nothing overlaps
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < groups.size(); i++) {
+            for (size_t j = i + 1; j < groups.size();) {
+                if ((groups[i].roi & groups[j].roi).area() > 0) {
+                    groups[i].roi |= groups[j].roi;
+                    std::move(groups[j].limbs.begin(), groups[j].limbs.end(), std::back_inserter(groups[i].limbs));
+                    groups.erase(groups.begin() + j);
+                    merged = true;
+                } else {
+                    j++;
+                }
+            }
+        }
+    }
+    for (auto& group : groups) {
+        cv::Mat roi = image(group.roi);
+        cv::Mat pane = roi.clone();
+        for (auto& limb : group.limbs) {
+            for (auto& point : limb.polygon) {
+                point -= group.roi.tl();
+            }
+            cv::fillConvexPoly(pane, limb.polygon, limb.color);
         }
+        cv::addWeighted(roi, 0.4, pane, 0.6, 0, roi);
     }
-    cv::addWeighted(image, 0.4, pane, 0.6, 0, image);
 }
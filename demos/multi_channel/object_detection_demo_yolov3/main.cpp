@@ -24,15 +24,20 @@
 #endif
 
 #include <opencv2/opencv.hpp>
-#include <ngraph/ngraph.hpp>
 
+#include <models/detection_model_yolo.h>
 #include <monitors/presenter.h>
 #include <samples/slog.hpp>
 
 #include "input.hpp"
+#include "source_scheduler.hpp"
 #include "multichannel_params.hpp"
 #include "multichannel_object_detection_demo_yolov3_params.hpp"
+#include "mosaic.hpp"
 #include "output.hpp"
+#include "queue_planner.hpp"
+#include "placement.hpp"
+#include "sinks.hpp"
 #include "threading.hpp"
 #include "graph.hpp"
 
@@ -56,6 +61,7 @@ void showUsage() {
     std::cout << "      -c \"<absolute_path>\"       " << custom_cldnn_message << std::endl;
     std::cout << "    -d \"<device>\"                " << target_device_message << std::endl;
     std::cout << "    -bs                          " << batch_size << std::endl;
+    std::cout << "    -bw                          " << batch_wait_time << std::endl;
     std::cout << "    -nireq                       " << num_infer_requests << std::endl;
     std::cout << "    -n_iqs                       " << input_queue_size << std::endl;
     std::cout << "    -fps_sp                      " << fps_sampling_period << std::endl;
@@ -66,6 +72,16 @@ void showUsage() {
     std::cout << "    -show_stats                  " << show_statistics << std::endl;
     std::cout << "    -real_input_fps              " << real_input_fps << std::endl;
     std::cout << "    -u                           " << utilization_monitors_message << std::endl;
+    std::cout << "    -o \"<path>\"                  " << output_video_message << std::endl;
+    std::cout << "    -o_json \"<path>\"             " << output_json_message << std::endl;
+    std::cout << "    -n_oqs                       " << output_queue_size << std::endl;
+    std::cout << "    -queue_budget_mb             " << queue_budget_message << std::endl;
+    std::cout << "    -adapt_queues                " << adapt_queues_message << std::endl;
+    std::cout << "    -cpus \"<list>\"               " << cpus_message << std::endl;
+    std::cout << "    -publish \"<name>\"            " << publish_message << std::endl;
+    std::cout << "    -map_weights                 " << map_weights_message << std::endl;
+    std::cout << "    -priorities \"<list>\"         " << priorities_message << std::endl;
+    std::cout << "    -min_fps                     " << min_fps_message << std::endl;
 }
 
 bool ParseAndCheckCommandLine(int argc, char *argv[]) {
@@ -102,135 +118,24 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     return true;
 }
 
-static int EntryIndex(int side, int lcoords, int lclasses, int location, int entry) {
-    int n = location / (side * side);
-    int loc = location % (side * side);
-    return n * side * side * (lcoords + lclasses + 1) + entry * side * side + loc;
-}
-
-class YoloParams {
-    template <typename T>
-    void computeAnchors(const std::vector<float> & initialAnchors, const std::vector<T> & mask) {
-        anchors.resize(num * 2);
-        for (int i = 0; i < num; ++i) {
-            anchors[i * 2] = initialAnchors[mask[i] * 2];
-            anchors[i * 2 + 1] = initialAnchors[mask[i] * 2 + 1];
-        }
-    }
-
-public:
-    int num = 0, classes = 0, coords = 0;
-    std::vector<float> anchors;
-
-    YoloParams() {}
-
-    YoloParams(const std::shared_ptr<ngraph::op::RegionYolo> regionYolo) {
-        coords = regionYolo->get_num_coords();
-        classes = regionYolo->get_num_classes();
-        auto initialAnchors = regionYolo->get_anchors();
-        auto mask = regionYolo->get_mask();
-        num = mask.size();
-
-        computeAnchors(initialAnchors, mask);
+void drawDetections(cv::Mat& img, const std::vector<DetectedObject>& detections, const std::vector<cv::Scalar>& colors) {
+    for (const DetectedObject& f : detections) {
+        cv::rectangle(img, f, colors[static_cast<int>(f.labelID)], 2);
     }
-};
-
-struct DetectionObject {
-    int xmin, ymin, xmax, ymax, class_id;
-    float confidence;
-
-    DetectionObject(double x, double y, double h, double w, int class_id, float confidence, float h_scale, float w_scale) :
-        xmin{static_cast<int>((x - w / 2) * w_scale)},
-        ymin{static_cast<int>((y - h / 2) * h_scale)},
-        xmax{static_cast<int>(this->xmin + w * w_scale)},
-        ymax{static_cast<int>(this->ymin + h * h_scale)},
-        class_id{class_id},
-        confidence{confidence} {}
-
-    bool operator <(const DetectionObject &s2) const {
-        return this->confidence < s2.confidence;
-    }
-    bool operator >(const DetectionObject &s2) const {
-        return this->confidence > s2.confidence;
-    }
-};
-
-double IntersectionOverUnion(const DetectionObject &box_1, const DetectionObject &box_2) {
-    double width_of_overlap_area = fmin(box_1.xmax, box_2.xmax) - fmax(box_1.xmin, box_2.xmin);
-    double height_of_overlap_area = fmin(box_1.ymax, box_2.ymax) - fmax(box_1.ymin, box_2.ymin);
-    double area_of_overlap;
-    if (width_of_overlap_area < 0 || height_of_overlap_area < 0)
-        area_of_overlap = 0;
-    else
-        area_of_overlap = width_of_overlap_area * height_of_overlap_area;
-    double box_1_area = (box_1.ymax - box_1.ymin)  * (box_1.xmax - box_1.xmin);
-    double box_2_area = (box_2.ymax - box_2.ymin)  * (box_2.xmax - box_2.xmin);
-    double area_of_union = box_1_area + box_2_area - area_of_overlap;
-    return area_of_overlap / area_of_union;
 }
 
-void ParseYOLOV3Output(InferenceEngine::InferRequest::Ptr req,
-                       const std::string &outputName,
-                       const YoloParams &yoloParams, const unsigned long resized_im_h,
-                       const unsigned long resized_im_w, const unsigned long original_im_h,
-                       const unsigned long original_im_w,
-                       const double threshold, std::vector<DetectionObject> &objects) {
-    InferenceEngine::Blob::Ptr blob = req->GetBlob(outputName);
-
-    const int out_blob_h = static_cast<int>(blob->getTensorDesc().getDims()[2]);
-    const int out_blob_w = static_cast<int>(blob->getTensorDesc().getDims()[3]);
-    if (out_blob_h != out_blob_w)
-        throw std::runtime_error("Invalid size of output. It should be in NCHW layout and H should be equal to W. Current H = " + std::to_string(out_blob_h) +
-        ", current W = " + std::to_string(out_blob_h));
-
-    auto num = yoloParams.num;
-    auto coords = yoloParams.coords;
-    auto classes = yoloParams.classes;
-
-    auto anchors = yoloParams.anchors;
-
-    auto side = out_blob_h;
-    auto side_square = side * side;
-    InferenceEngine::LockedMemory<const void> blobMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->rmap();
-    const float *output_blob  = blobMapped.as<float *>();
-    // --------------------------- Parsing YOLO Region output -------------------------------------
-    for (int i = 0; i < side_square; ++i) {
-        int row = i / side;
-        int col = i % side;
-        for (int n = 0; n < num; ++n) {
-            int obj_index = EntryIndex(side, coords, classes, n * side * side + i, coords);
-            int box_index = EntryIndex(side, coords, classes, n * side * side + i, 0);
-            float scale = output_blob[obj_index];
-            if (scale < threshold)
-                continue;
-            double x = (col + output_blob[box_index + 0 * side_square]) / side * resized_im_w;
-            double y = (row + output_blob[box_index + 1 * side_square]) / side * resized_im_h;
-            double height = std::exp(output_blob[box_index + 3 * side_square]) * anchors[2 * n + 1];
-            double width = std::exp(output_blob[box_index + 2 * side_square]) * anchors[2 * n];
-            for (int j = 0; j < classes; ++j) {
-                int class_index = EntryIndex(side, coords, classes, n * side_square + i, coords + 1 + j);
-                float prob = scale * output_blob[class_index];
-                if (prob < threshold)
-                    continue;
-                DetectionObject obj(x, y, height, width, j, prob,
-                        static_cast<float>(original_im_h) / static_cast<float>(resized_im_h),
-                        static_cast<float>(original_im_w) / static_cast<float>(resized_im_w));
-                objects.push_back(obj);
-            }
-        }
-    }
-}
-
-void drawDetections(cv::Mat& img, const std::vector<DetectionObject>& detections, const std::vector<cv::Scalar>& colors) {
-    for (const DetectionObject& f : detections) {
-        cv::rectangle(img,
-                      cv::Rect2f(static_cast<float>(f.xmin),
-                                 static_cast<float>(f.ymin),
-                                 static_cast<float>((f.xmax-f.xmin)),
-                                 static_cast<float>((f.ymax-f.ymin))),
-                      colors[static_cast<int>(f.class_id)],
-                      2);
+// Coordinates are relative to the frame, like in the other demos
+std::string detectionsToJson(const std::vector<DetectedObject>& detections, cv::Size frameSize) {
+    std::ostringstream json;
+    for (const DetectedObject& f : detections) {
+        json << (&f == &detections.front() ? "" : ", ")
+             << "{\"xmin\": " << f.x / frameSize.width
+             << ", \"ymin\": " << f.y / frameSize.height
+             << ", \"xmax\": " << (f.x + f.width) / frameSize.width
+             << ", \"ymax\": " << (f.y + f.height) / frameSize.height
+             << ", \"class_id\": " << f.labelID << ", \"confidence\": " << f.confidence << "}";
     }
+    return json.str();
 }
 
 const size_t DISP_WIDTH  = 1920;
@@ -267,52 +172,14 @@ DisplayParams prepareDisplayParams(size_t count) {
     return params;
 }
 
-std::map<std::string, YoloParams> GetYoloParams(const std::vector<std::string>& outputDataBlobNames,
-                                                InferenceEngine::CNNNetwork &network) {
-    std::map<std::string, YoloParams> __yoloParams;
-
-    for (auto &output_name : outputDataBlobNames) {
-        YoloParams params;
-
-        if (auto ngraphFunction = network.getFunction()) {
-            for (const auto op : ngraphFunction->get_ops()) {
-                if (op->get_friendly_name() == output_name) {
-                    auto regionYolo = std::dynamic_pointer_cast<ngraph::op::RegionYolo>(op);
-                    if (!regionYolo) {
-                        throw std::runtime_error("Invalid output type: " +
-                            std::string(regionYolo->get_type_info().name) + ". RegionYolo expected");
-                    }
-
-                    params = regionYolo;
-                    break;
-                }
-            }
-        } else {
-            throw std::runtime_error("Can't get ngraph::Function. Make sure the provided model is in IR version 10 or greater.");
-        }
-        __yoloParams.insert(std::pair<std::string, YoloParams>(output_name.c_str(), params));
-    }
-
-    return __yoloParams;
-}
-
 void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
                      float time,
                      const std::string& stats,
                      const DisplayParams& params,
                      const std::vector<cv::Scalar> &colors,
-                     Presenter& presenter) {
-    cv::Mat windowImage = cv::Mat::zeros(params.windowSize, CV_8UC3);
-    auto loopBody = [&](size_t i) {
-        auto& elem = data[i];
-        if (!elem->frame.empty()) {
-            cv::Rect rectFrame = cv::Rect(params.points[i], params.frameSize);
-            cv::Mat windowPart = windowImage(rectFrame);
-            cv::resize(elem->frame, windowPart, params.frameSize);
-            drawDetections(windowPart, elem->detections.get<std::vector<DetectionObject>>(), colors);
-        }
-    };
-
+                     Presenter& presenter,
+                     Mosaic& mosaic,
+                     cv::Mat& windowImage) {
     auto drawStats = [&]() {
         if (FLAGS_show_stats && !stats.empty()) {
             static const cv::Point posPoint = cv::Point(3*DISP_WIDTH/4, 4*DISP_HEIGHT/5);
@@ -330,18 +197,9 @@ void displayNSources(const std::vector<std::shared_ptr<VideoFrame>>& data,
         }
     };
 
-//  #ifdef USE_TBB
-#if 0  // disable multithreaded rendering for now
-    run_in_arena([&](){
-        tbb::parallel_for<size_t>(0, data.size(), [&](size_t i) {
-            loopBody(i);
-        });
-    });
-#else
-    for (size_t i = 0; i < data.size(); ++i) {
-        loopBody(i);
-    }
-#endif
+    mosaic.render(data, [&](cv::Mat& tile, const VideoFrame& frame) {
+        drawDetections(tile, frame.detections.get<std::vector<DetectedObject>>(), colors);
+    }, windowImage);
     presenter.drawGraphs(windowImage);
     drawStats();
 
@@ -367,6 +225,14 @@ int main(int argc, char* argv[]) {
             return 0;
         }
 
+        // Before any engine starts its threads, so they inherit the cores and the memory node
+        std::vector<unsigned> cores;
+        if (!FLAGS_cpus.empty()) {
+            cores = parseCpuList(FLAGS_cpus);
+            bindToCores(cores);
+            slog::info << "Bound to " << cores.size() << " cores" << slog::endl;
+        }
+
         std::string modelPath = FLAGS_m;
         std::size_t found = modelPath.find_last_of(".");
         if (found > modelPath.size()) {
@@ -376,21 +242,24 @@ int main(int argc, char* argv[]) {
         }
         slog::info << "Model   path: " << modelPath << slog::endl;
 
-        std::map<std::string, YoloParams> yoloParams;
+        // Only postprocessing of the model is used, IEGraph loads and infers the network
+        ModelYolo3 model(modelPath, static_cast<float>(FLAGS_t), false);
 
         IEGraph::InitParams graphParams;
         graphParams.batchSize       = FLAGS_bs;
+        graphParams.maxBatchWaitTime = std::chrono::milliseconds(FLAGS_bw);
         graphParams.maxRequests     = FLAGS_nireq;
         graphParams.collectStats    = FLAGS_show_stats;
         graphParams.reportPerf      = FLAGS_pc;
         graphParams.modelPath       = modelPath;
+        graphParams.mapWeights      = FLAGS_map_weights;
         graphParams.cpuExtPath      = FLAGS_l;
         graphParams.cldnnConfigPath = FLAGS_c;
         graphParams.deviceName      = FLAGS_d;
-        graphParams.postLoadFunc    = [&yoloParams](const std::vector<std::string>& outputDataBlobNames,
-                                                    InferenceEngine::CNNNetwork &network) {
-                                                        yoloParams = GetYoloParams(outputDataBlobNames, network);
-                                                    };
+        graphParams.cpuThreadsNum   = static_cast<unsigned>(cores.size());
+        graphParams.postLoadFunc    = [&model](const std::vector<std::string>&, InferenceEngine::CNNNetwork &network) {
+                                          model.initPostprocessing(network);
+                                      };
 
         std::shared_ptr<IEGraph> network(new IEGraph(graphParams));
         auto inputDims = network->getInputDims();
@@ -404,6 +273,8 @@ int main(int argc, char* argv[]) {
         vsParams.queueSize            = FLAGS_n_iqs;
         vsParams.collectStats         = FLAGS_show_stats;
         vsParams.realFps              = FLAGS_real_input_fps;
+        vsParams.publishName          = FLAGS_publish;
+        vsParams.vaDisplay            = network->getVaDisplay();
         vsParams.expectedHeight = static_cast<unsigned>(inputDims[2]);
         vsParams.expectedWidth  = static_cast<unsigned>(inputDims[3]);
 
@@ -411,51 +282,42 @@ int main(int argc, char* argv[]) {
         DisplayParams params = prepareDisplayParams(sources.numberOfInputs() * FLAGS_duplicate_num);
         sources.start();
 
-        size_t currentFrame = 0;
+        SourceScheduler scheduler(parsePriorities(FLAGS_priorities, sources.numberOfInputs() * FLAGS_duplicate_num),
+                                  FLAGS_min_fps);
 
         std::vector<cv::Scalar> colors;
-        if (yoloParams.size() > 0)
-            for (int i = 0; i < static_cast<int>(yoloParams.begin()->second.classes); ++i)
-                colors.push_back(cv::Scalar(rand() % 256, rand() % 256, rand() % 256));
+        for (int i = 0; i < model.getNumClasses(); ++i)
+            colors.push_back(cv::Scalar(rand() % 256, rand() % 256, rand() % 256));
 
+        std::vector<bool> readyChannels(sources.numberOfInputs() * FLAGS_duplicate_num);
         network->start([&](VideoFrame& img) {
-            img.sourceIdx = currentFrame;
-            size_t camIdx = currentFrame / FLAGS_duplicate_num;
-            currentFrame = (currentFrame + 1) % (sources.numberOfInputs() * FLAGS_duplicate_num);
-            return sources.getFrame(camIdx, img);
-        }, [&yoloParams](InferenceEngine::InferRequest::Ptr req,
+            // The next channel is chosen among the ones having a frame, so a slow input doesn't hold the others
+            return sources.getAnyFrame(img, [&](const std::vector<bool>& readyInputs) {
+                for (size_t channel = 0; channel < readyChannels.size(); channel++) {
+                    readyChannels[channel] = readyInputs[channel / FLAGS_duplicate_num];
+                }
+                size_t channel = scheduler.next(readyChannels);
+                img.sourceIdx = channel;
+                return channel / FLAGS_duplicate_num;
+            });
+        }, [&model](InferenceEngine::InferRequest::Ptr req,
                 const std::vector<std::string>& outputDataBlobNames,
                 cv::Size frameSize
                 ) {
-            unsigned long resized_im_h = 416;
-            unsigned long resized_im_w = 416;
-
-            std::vector<DetectionObject> objects;
-            // Parsing outputs
-            for (auto &output_name :outputDataBlobNames) {
-                ParseYOLOV3Output(req, output_name, yoloParams[output_name], resized_im_h, resized_im_w, frameSize.height, frameSize.width, FLAGS_t, objects);
-            }
-            // Filtering overlapping boxes and lower confidence object
-            std::sort(objects.begin(), objects.end(), std::greater<DetectionObject>());
-            for (size_t i = 0; i < objects.size(); ++i) {
-                if (objects[i].confidence == 0)
-                    continue;
-                for (size_t j = i + 1; j < objects.size(); ++j)
-                    if (IntersectionOverUnion(objects[i], objects[j]) >= 0.4)
-                        objects[j].confidence = 0;
+            std::map<std::string, InferenceEngine::Blob::Ptr> outputs;
+            for (auto &output_name : outputDataBlobNames) {
+                outputs.emplace(output_name, req->GetBlob(output_name));
             }
+            // Every image of the batch is parsed, so partial and full batches are handled the same way
+            std::vector<std::vector<DetectedObject>> objects;
+            model.detectBatch(outputs, frameSize, objects);
 
-            std::vector<Detections> detections(1);
-            detections[0].set(new std::vector<DetectionObject>);
-
-            for (auto &object : objects) {
-                if (object.confidence < FLAGS_t)
-                    continue;
-                detections[0].get<std::vector<DetectionObject>>().push_back(object);
+            std::vector<Detections> detections(objects.size());
+            for (size_t i = 0; i < objects.size(); ++i) {
+                detections[i].set(new std::vector<DetectedObject>(std::move(objects[i])));
             }
-
             return detections;
-        });
+        }, params.frameSize);
 
         network->setDetectionConfidence(static_cast<float>(FLAGS_t));
 
@@ -474,6 +336,8 @@ int main(int argc, char* argv[]) {
 
         cv::Size graphSize{static_cast<int>(params.windowSize.width / 4), 60};
         Presenter presenter(FLAGS_u, params.windowSize.height - graphSize.height - 10, graphSize);
+        Mosaic mosaic(params.windowSize, {params.points, params.points + params.count}, params.frameSize);
+        cv::Mat windowImage;
 
         const size_t outputQueueSize = 1;
         AsyncOutput output(FLAGS_show_stats, outputQueueSize,
@@ -483,7 +347,7 @@ int main(int argc, char* argv[]) {
                 std::unique_lock<std::mutex> lock(statMutex);
                 str = statStream.str();
             }
-            displayNSources(result, averageFps, str, params, colors, presenter);
+            displayNSources(result, averageFps, str, params, colors, presenter, mosaic, windowImage);
             int key = cv::waitKey(1);
             presenter.handleKey(key);
 
@@ -492,6 +356,27 @@ int main(int argc, char* argv[]) {
 
         output.start();
 
+        std::vector<std::unique_ptr<AsyncOutput>> sinks;
+        if (!FLAGS_o.empty()) {
+            sinks.push_back(makeVideoSink(FLAGS_o, FLAGS_n_oqs, FLAGS_show_stats, params.windowSize,
+                {params.points, params.points + params.count}, params.frameSize,
+                [colors](cv::Mat& tile, const VideoFrame& frame) {
+                    drawDetections(tile, frame.detections.get<std::vector<DetectedObject>>(), colors);
+                }));
+        }
+        if (!FLAGS_o_json.empty()) {
+            sinks.push_back(makeJsonSink(FLAGS_o_json, FLAGS_n_oqs, FLAGS_show_stats, [&params](const VideoFrame& frame) {
+                return detectionsToJson(frame.detections.get<std::vector<DetectedObject>>(), params.frameSize);
+            }));
+        }
+
+        // Without a budget the queues keep the sizes of -n_iqs and -n_oqs
+        std::unique_ptr<PipelineQueues> queues;
+        if (FLAGS_queue_budget_mb) {
+            queues.reset(new PipelineQueues(size_t{FLAGS_queue_budget_mb} << 20, FLAGS_adapt_queues, sources,
+                                            FLAGS_n_iqs, sinks, FLAGS_n_oqs, FLAGS_nireq, inputDims));
+        }
+
         using timer = std::chrono::high_resolution_clock;
         using duration = std::chrono::duration<float, std::milli>;
         timer::time_point lastTime = timer::now();
@@ -504,7 +389,7 @@ int main(int argc, char* argv[]) {
         while (sources.isRunning() || network->isRunning()) {
             bool readData = true;
             while (readData) {
-                auto br = network->getBatchData(params.frameSize);
+                auto br = network->getBatchData();
                 if (br.empty()) {
                     break;
                 }
@@ -512,6 +397,12 @@ int main(int argc, char* argv[]) {
                     auto val = static_cast<unsigned int>(br[i]->sourceIdx);
                     auto it = find_if(batchRes.begin(), batchRes.end(), [val] (const std::shared_ptr<VideoFrame>& vf) { return vf->sourceIdx == val; } );
                     if (it != batchRes.end()) {
+                        if (queues) {
+                            queues->update(batchRes);
+                        }
+                        for (std::unique_ptr<AsyncOutput>& sink : sinks) {
+                            sink->push(std::vector<std::shared_ptr<VideoFrame>>(batchRes));
+                        }
                         if (!FLAGS_no_show) {
                             output.push(std::move(batchRes));
                         }
@@ -523,7 +414,8 @@ int main(int argc, char* argv[]) {
             }
             ++fpsCounter;
 
-            if (!output.isAlive()) {
+            if (!output.isAlive() || std::any_of(sinks.begin(), sinks.end(),
+                    [](const std::unique_ptr<AsyncOutput>& sink) {return !sink->isAlive();})) {
                 break;
             }
 
@@ -568,11 +460,16 @@ int main(int argc, char* argv[]) {
                                << inferStat.preprocessTime << "ms";
                     statStream << std::endl;
                     statStream << "Plugin latency: "
-                               << inferStat.inferTime << "ms";
+                               << inferStat.inferTime << "ms (p99 " << inferStat.inferTimeP99
+                               << "ms, max " << inferStat.inferTimeMax << "ms)";
+                    statStream << std::endl;
+                    statStream << "Batch fill: "
+                               << inferStat.batchFillRatio * 100 << "%";
                     statStream << std::endl;
 
                     statStream << "Render time: " << outputStat.renderTime
-                               << "ms" << std::endl;
+                               << "ms (p99 " << outputStat.renderTimeP99
+                               << "ms, max " << outputStat.renderTimeMax << "ms)" << std::endl;
 
                     if (FLAGS_no_show) {
                         slog::info << statStream.str() << slog::endl;
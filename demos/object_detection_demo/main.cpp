@@ -20,38 +20,57 @@
 * \example object_detection_demo_ssd_async/main.cpp
 */
 
+#include <fstream>
 #include <iostream>
 #include <vector>
+#include <sstream>
 #include <string>
+#include <utility>
 
 #include <monitors/presenter.h>
 #include <samples/ocv_common.hpp>
 #include <samples/args_helper.hpp>
 #include <samples/slog.hpp>
 #include <samples/images_capture.h>
+#include <samples/motion_gate.h>
 #include <samples/default_flags.hpp>
+#include <samples/frame_tracer.hpp>
 #include <unordered_map>
 #include <gflags/gflags.h>
 
 #include <iostream>
 
 #include <samples/performance_metrics.hpp>
+#include <samples/results_writer.hpp>
+#include <samples/text_cache.hpp>
+#include <samples/trace_profiler.hpp>
 
 #include "pipelines/async_pipeline.h"
 #include "pipelines/config_factory.h"
 #include "pipelines/metadata.h"
+#include "pipelines/recorded_outputs.h"
+#include "pipelines/staged_runner.h"
 #include "models/detection_model_yolo.h"
 #include "models/detection_model_ssd.h"
+#include "models/detection_model_tiled.h"
 
 static const char help_message[] = "Print a usage message.";
 static const char at_message[] = "Required. Architecture type: ssd or yolo";
-static const char video_message[] = "Required. Path to a video file (specify \"cam\" to work with camera).";
+static const char video_message[] = "Required. Path to a video file (specify \"cam\" to work with camera). "
+"A comma separated list of inputs is processed by one network, the results of every input are shown in its own window.";
 static const char model_message[] = "Required. Path to an .xml file with a trained model.";
 static const char target_device_message[] = "Optional. Specify the target device to infer on (the list of available devices is shown below). "
 "Default value is CPU. Use \"-d HETERO:<comma-separated_devices_list>\" format to specify HETERO plugin. "
+"Use \"-d BALANCE:<comma-separated_devices_list>\" format to load the model to every device separately "
+"and send every frame to the device expected to infer it first. "
 "The demo will look for a suitable plugin for a specified device.";
 static const char labels_message[] = "Optional. Path to a file with labels mapping.";
 static const char performance_counter_message[] = "Optional. Enables per-layer performance report.";
+static const char trace_message[] = "Optional. Path to the file to write timeline of processing stages and "
+"network layers to in Chrome trace format (can be opened with chrome://tracing or Perfetto UI). Enables -pc.";
+static const char record_outputs_message[] = "Optional. Path to the file to write raw outputs of the network for "
+"every frame to, so postprocessing can be profiled on them without inference with -replay of demo_bench. "
+"Can't be used with -tiles.";
 static const char custom_cldnn_message[] = "Required for GPU custom kernels. "
 "Absolute path to the .xml file with the kernel descriptions.";
 static const char custom_cpu_library_message[] = "Required for CPU custom layers. "
@@ -64,10 +83,27 @@ static const char num_threads_message[] = "Optional. Number of threads.";
 static const char num_streams_message[] = "Optional. Number of streams to use for inference on the CPU or/and GPU in "
 "throughput mode (for HETERO and MULTI device cases use format "
 "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
+static const char autotune_message[] = "Optional. Choose the number of infer requests in flight on the first frames: "
+"-nireq requests are created and the number of them giving the highest throughput within -latency_limit is used. "
+"The decision is cached in OMZ_NETWORK_CACHE_DIR directory if it's set.";
+static const char latency_limit_message[] = "Optional. Maximum mean inference latency in milliseconds for -autotune. "
+"Zero (default) means no limit.";
 static const char no_show_processed_video[] = "Optional. Do not show processed video.";
+static const char zero_copy_message[] = "Optional. Postprocess the outputs right in the blobs of the infer request instead of "
+"copying them. The request is busy until the frame is postprocessed, so it's worth it for large outputs.";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
 static const char iou_thresh_output_message[] = "Optional. Filtering intersection over union threshold for overlapping boxes (YOLOv3 only).";
 static const char yolo_af_message[] = "Optional. Use advanced postprocessing/filtering algorithm for YOLO.";
+static const char drop_frames_message[] = "Optional. Drop the oldest frames instead of waiting when inference or "
+"rendering can't keep up with the input. Useful for live cameras.";
+static const char max_frame_age_message[] = "Optional. Discard captured frames which waited for inference longer than "
+"this number of milliseconds, so the latency of live cameras stays bounded. Zero (default) means no limit.";
+static const char reduce_decode_message[] = "Optional. Decode images reduced by 2, 4 or 8 times while they stay "
+"at least as large as the network input. JPEG images are decoded several times faster then. Not compatible with -tiles.";
+static const char tiles_message[] = "Optional. Detect objects on overlapping tiles of the frame, e.g. \"3x2\" for 3 "
+"columns and 2 rows, so small objects of high resolution frames are found. The whole frame is detected as one more "
+"tile, all tiles of a frame are inferred as one batch and the detections are merged with NMS. "
+"Not compatible with -auto_resize.";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(at, "", at_message);
@@ -76,19 +112,33 @@ DEFINE_string(m, "", model_message);
 DEFINE_string(d, "CPU", target_device_message);
 DEFINE_string(labels, "", labels_message);
 DEFINE_bool(pc, false, performance_counter_message);
+DEFINE_string(trace, "", trace_message);
+DEFINE_string(record_outputs, "", record_outputs_message);
 DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_bool(r, false, raw_output_message);
+DEFINE_DUMP_FLAG
 DEFINE_double(t, 0.5, thresh_output_message);
 DEFINE_double(iou_t, 0.4, iou_thresh_output_message);
 DEFINE_bool(auto_resize, false, input_resizable_message);
 DEFINE_uint32(nireq, 2, num_inf_req_message);
 DEFINE_uint32(nthreads, 0, num_threads_message);
 DEFINE_string(nstreams, "", num_streams_message);
+DEFINE_bool(autotune, false, autotune_message);
+DEFINE_uint32(latency_limit, 0, latency_limit_message);
+DEFINE_bool(zero_copy, false, zero_copy_message);
 DEFINE_bool(loop, false, loop_message);
 DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_string(u, "", utilization_monitors_message);
 DEFINE_bool(yolo_af, false, yolo_af_message);
+DEFINE_bool(drop_frames, false, drop_frames_message);
+DEFINE_uint32(max_frame_age, 0, max_frame_age_message);
+DEFINE_MOTION_GATE_FLAG
+DEFINE_PP_DEVICE_FLAG
+DEFINE_MAP_WEIGHTS_FLAG
+DEFINE_string(tiles, "", tiles_message);
+DEFINE_bool(reduce_decode, false, reduce_decode_message);
+DEFINE_BENCHMARK_FLAGS
 
 /**
 * \brief This function shows a help message
@@ -108,16 +158,31 @@ static void showUsage() {
     std::cout << "    -d \"<device>\"             " << target_device_message << std::endl;
     std::cout << "    -labels \"<path>\"          " << labels_message << std::endl;
     std::cout << "    -pc                       " << performance_counter_message << std::endl;
+    std::cout << "    -trace \"<path>\"           " << trace_message << std::endl;
+    std::cout << "    -record_outputs \"<path>\"  " << record_outputs_message << std::endl;
     std::cout << "    -r                        " << raw_output_message << std::endl;
+    std::cout << "    -dump \"<path>\"            " << dump_message << std::endl;
     std::cout << "    -t                        " << thresh_output_message << std::endl;
     std::cout << "    -auto_resize              " << input_resizable_message << std::endl;
     std::cout << "    -nireq \"<integer>\"        " << num_inf_req_message << std::endl;
     std::cout << "    -nthreads \"<integer>\"     " << num_threads_message << std::endl;
     std::cout << "    -nstreams                 " << num_streams_message << std::endl;
+    std::cout << "    -autotune                 " << autotune_message << std::endl;
+    std::cout << "    -latency_limit \"<integer>\" " << latency_limit_message << std::endl;
+    std::cout << "    -zero_copy                " << zero_copy_message << std::endl;
     std::cout << "    -loop                     " << loop_message << std::endl;
     std::cout << "    -no_show                  " << no_show_processed_video << std::endl;
     std::cout << "    -u                        " << utilization_monitors_message << std::endl;
     std::cout << "    -yolo_af                  " << yolo_af_message << std::endl;
+    std::cout << "    -drop_frames              " << drop_frames_message << std::endl;
+    std::cout << "    -max_frame_age \"<integer>\" " << max_frame_age_message << std::endl;
+    std::cout << "    -motion_gate              " << motion_gate_message << std::endl;
+    std::cout << "    -pp_device                " << pp_device_message << std::endl;
+    std::cout << "    -map_weights              " << map_weights_message << std::endl;
+    std::cout << "    -tiles \"<cols>x<rows>\"     " << tiles_message << std::endl;
+    std::cout << "    -reduce_decode            " << reduce_decode_message << std::endl;
+    std::cout << "    -limit                    " << limit_message << std::endl;
+    std::cout << "    -report_perf              " << report_perf_message << std::endl;
 }
 
 
@@ -143,9 +208,31 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
         throw std::logic_error("Parameter -at is not set");
     }
 
+    if (!FLAGS_report_perf.empty() && FLAGS_report_perf != "json") {
+        throw std::logic_error("Parameter -report_perf supports json only");
+    }
+
+    if (!FLAGS_tiles.empty() && FLAGS_auto_resize) {
+        throw std::logic_error("Parameter -tiles can't be used together with -auto_resize");
+    }
+
+    if (FLAGS_i.find(',') != std::string::npos && FLAGS_motion_gate > 0) {
+        throw std::logic_error("Parameter -motion_gate can't be used with several inputs");
+    }
+
     return true;
 }
 
+cv::Size parseTilesGrid(const std::string& tiles) {
+    int cols = 0, rows = 0;
+    char separator = 0;
+    std::istringstream stream(tiles);
+    if (!(stream >> cols >> separator >> rows) || separator != 'x' || !stream.eof() || cols <= 0 || rows <= 0) {
+        throw std::invalid_argument("Invalid -tiles value: " + tiles + ", expected <cols>x<rows>");
+    }
+    return cv::Size(cols, rows);
+}
+
 // Input image is stored inside metadata, as we put it there during submission stage
 cv::Mat renderDetectionData(const DetectionResult& result) {
     if (!result.metaData) {
@@ -163,10 +250,10 @@ cv::Mat renderDetectionData(const DetectionResult& result) {
         slog::info << " Class ID  | Confidence | XMIN | YMIN | XMAX | YMAX " << slog::endl;
     }
 
-    for (auto obj : result.objects) {
+    for (const auto& obj : result.objects) {
         if (FLAGS_r) {
             slog::info << " "
-                       << std::left << std::setw(9) << obj.label << " | "
+                       << std::left << std::setw(9) << obj.getLabelName() << " | "
                        << std::setw(10) << obj.confidence << " | "
                        << std::setw(4) << std::max(int(obj.x), 0) << " | "
                        << std::setw(4) << std::max(int(obj.y), 0) << " | "
@@ -178,7 +265,9 @@ cv::Mat renderDetectionData(const DetectionResult& result) {
         std::ostringstream conf;
         conf << ":" << std::fixed << std::setprecision(3) << obj.confidence;
 
-        cv::putText(outputImg, obj.label + conf.str(),
+        // Labels mostly repeat from frame to frame, the cache draws them without rasterizing them again
+        static TextCache textCache(1024);
+        textCache.putText(outputImg, obj.getLabelName() + conf.str(),
             cv::Point2f(obj.x, obj.y - 5), cv::FONT_HERSHEY_COMPLEX_SMALL, 1,
             cv::Scalar(0, 0, 255));
         cv::rectangle(outputImg, obj, cv::Scalar(0, 0, 255));
@@ -187,6 +276,19 @@ cv::Mat renderDetectionData(const DetectionResult& result) {
     return outputImg;
 }
 
+void dumpDetections(ResultsWriter& writer, const DetectionResult& result, std::vector<ResultsWriter::Record>& records) {
+    records.resize(result.objects.size());
+    for (size_t i = 0; i < result.objects.size(); i++) {
+        const DetectedObject& obj = result.objects[i];
+        ResultsWriter::Record& record = records[i];
+        record.frame = result.frameId;
+        record.label = static_cast<int>(obj.labelID);
+        record.confidence = obj.confidence;
+        record.box = obj;
+        record.text = obj.getLabelName();
+    }
+    writer.write(records);
+}
 
 int main(int argc, char *argv[]) {
     try {
@@ -199,101 +301,164 @@ int main(int argc, char *argv[]) {
             return 0;
         }
 
-        //------------------------------- Preparing Input ------------------------------------------------------
-        slog::info << "Reading input" << slog::endl;
-        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop);
-        cv::Mat curr_frame;
-
         //------------------------------ Running Detection routines ----------------------------------------------
         std::vector<std::string> labels;
         if (!FLAGS_labels.empty())
             labels = DetectionModel::loadLabels(FLAGS_labels);
 
-        std::unique_ptr<ModelBase> model;
+        std::unique_ptr<DetectionModel> detectionModel;
         if (FLAGS_at == "ssd") {
-            model.reset(new ModelSSD(FLAGS_m, (float)FLAGS_t, FLAGS_auto_resize, labels));
+            detectionModel.reset(new ModelSSD(FLAGS_m, (float)FLAGS_t, FLAGS_auto_resize, labels));
         }
         else if (FLAGS_at == "yolo") {
-            model.reset(new ModelYolo3(FLAGS_m, (float)FLAGS_t, FLAGS_auto_resize, FLAGS_yolo_af, (float)FLAGS_iou_t, labels));
+            detectionModel.reset(new ModelYolo3(FLAGS_m, (float)FLAGS_t, FLAGS_auto_resize, FLAGS_yolo_af, (float)FLAGS_iou_t, labels));
         }
         else {
             slog::err << "No model type or invalid model type (-at) provided: " + FLAGS_at << slog::endl;
             return -1;
         }
 
-        InferenceEngine::Core core;
-        AsyncPipeline pipeline(std::move(model),
-            ConfigFactory::getUserConfig(FLAGS_d, FLAGS_l, FLAGS_c, FLAGS_pc, FLAGS_nireq, FLAGS_nstreams, FLAGS_nthreads),
-            core);
-        Presenter presenter;
-
-        bool keepRunning = true;
-        int64_t frameNum = -1;
-        std::unique_ptr<ResultBase> result;
-
-        while (keepRunning) {
-            if (pipeline.isReadyToProcess()) {
-                //--- Capturing frame. If previous frame hasn't been inferred yet, reuse it instead of capturing new one
-                auto startTime = std::chrono::steady_clock::now();
-                curr_frame = cap->read();
-                if (curr_frame.empty()) {
-                    if (frameNum == -1) {
-                        throw std::logic_error("Can't read an image from the input");
-                    }
-                    else {
-                        // Input stream is over
-                        break;
-                    }
-                }
+        const DetectionModel* plainDetectionModel = FLAGS_tiles.empty() ? detectionModel.get() : nullptr;
+        std::unique_ptr<ModelBase> model;
+        if (!FLAGS_tiles.empty()) {
+            model.reset(new TiledDetectionModel(std::move(detectionModel), parseTilesGrid(FLAGS_tiles)));
+        }
+        else {
+            model = std::move(detectionModel);
+        }
 
-                frameNum = pipeline.submitData(ImageInputData(curr_frame),
-                    std::make_shared<ImageMetaData>(curr_frame, startTime));
+        if (!setPreprocessingDevice(FLAGS_pp_device)) {
+            slog::warn << "OpenCL isn't available, images are preprocessed on the CPU" << slog::endl;
+        }
+        const bool isProfiling = FLAGS_pc || !FLAGS_trace.empty();
+        InferenceEngine::Core core;
+        CnnConfig cnnConfig = ConfigFactory::getUserConfig(FLAGS_d, FLAGS_l, FLAGS_c, isProfiling,
+            FLAGS_nireq, FLAGS_nstreams, FLAGS_nthreads);
+        cnnConfig.autotuneRequests = FLAGS_autotune;
+        cnnConfig.mapWeights = FLAGS_map_weights;
+        cnnConfig.latencyLimit = std::chrono::milliseconds(FLAGS_latency_limit);
+        cnnConfig.zeroCopyOutputs = FLAGS_zero_copy;
+        // The recorder is written by the pipeline, so it's created first
+        std::unique_ptr<OutputsRecorder> outputsRecorder;
+        if (!FLAGS_record_outputs.empty()) {
+            // Tiled model keeps the tiles in its InternalModelData, which isn't recorded
+            if (!FLAGS_tiles.empty()) {
+                throw std::logic_error("-record_outputs can't be used with -tiles");
             }
+            outputsRecorder.reset(new OutputsRecorder(FLAGS_record_outputs));
+        }
+        AsyncPipeline pipeline(std::move(model), cnnConfig, core);
 
-            //--- Waiting for free input slot or output data available. Function will return immediately if any of them are available.
-            pipeline.waitForData();
-
-            //--- Checking for results and rendering data if it's ready
-            //--- If you need just plain data without rendering - cast result's underlying pointer to DetectionResult*
-            //    and use your own processing instead of calling renderDetectionData().
-            while ((result = pipeline.getResult()) && keepRunning) {
-                cv::Mat outFrame = renderDetectionData(result->asRef<DetectionResult>());
-                //--- Showing results and device information
-                presenter.drawGraphs(outFrame);
-                metrics.update(result->metaData->asRef<ImageMetaData>().timeStamp,
-                    outFrame, { 10,22 }, 0.65);
-                if (!FLAGS_no_show) {
-                    cv::imshow("Detection Results", outFrame);
-                    //--- Processing keyboard events
-                    int key = cv::waitKey(1);
-                    if (27 == key || 'q' == key || 'Q' == key) {  // Esc
-                        keepRunning = false;
-                    }
-                    else {
-                        presenter.handleKey(key);
-                    }
-                }
-            }
+        //------------------------------- Preparing Input ------------------------------------------------------
+        // The input is opened after the network is loaded, as the decoded images may be reduced to its input size
+        slog::info << "Reading input" << slog::endl;
+        cv::Size decodeSizeHint;
+        if (FLAGS_reduce_decode && plainDetectionModel) {
+            decodeSizeHint = plainDetectionModel->getInputSize();
+        }
+        const size_t readLengthLimit = FLAGS_limit > 0 ? FLAGS_limit : std::numeric_limits<size_t>::max();
+        const bool isMultiSource = FLAGS_i.find(',') != std::string::npos;
+        std::unique_ptr<ImagesCapture> cap;
+        if (isMultiSource) {
+            cap = openMultiSourceCapture(FLAGS_i, FLAGS_loop, readLengthLimit);
+        } else {
+            cap = openImagesCapture(FLAGS_i, FLAGS_loop, 0, readLengthLimit, {1280, 720}, 4, 0,
+                VideoDecodeMode::Software, decodeSizeHint);
+        }
+        MotionGatedCapture* gatedCap = nullptr;
+        if (FLAGS_motion_gate > 0) {
+            gatedCap = new MotionGatedCapture(std::move(cap), FLAGS_motion_gate);
+            cap.reset(gatedCap);
         }
 
-        //// ------------ Waiting for completion of data processing and rendering the rest of results ---------
-        pipeline.waitForTotalCompletion();
-        while (result = pipeline.getResult()) {
-            cv::Mat outFrame = renderDetectionData(result->asRef<DetectionResult>());
+        pipeline.setPerformanceMetrics(&metrics);
+        TraceProfiler profiler;
+        if (isProfiling)
+            pipeline.setTraceProfiler(&profiler);
+        if (outputsRecorder)
+            pipeline.setOutputsRecorder(outputsRecorder.get());
+        Presenter presenter;
+
+        StagedRunner::Config runnerConfig;
+        if (FLAGS_drop_frames) {
+            runnerConfig.capturePolicy = StagedRunner::DropPolicy::DropOldest;
+            runnerConfig.renderPolicy = StagedRunner::DropPolicy::DropOldest;
+        }
+        runnerConfig.maxFrameAge = std::chrono::milliseconds(FLAGS_max_frame_age);
+        StagedRunner runner(pipeline, runnerConfig);
+        runner.setPerformanceMetrics(&metrics);
+        if (isProfiling)
+            runner.setTraceProfiler(&profiler);
+
+        std::unique_ptr<ResultsWriter> resultsWriter;
+        if (!FLAGS_dump.empty()) {
+            resultsWriter.reset(new ResultsWriter(FLAGS_dump, ResultsWriter::formatFromFileName(FLAGS_dump)));
+        }
+        std::vector<ResultsWriter::Record> dumpedRecords;
+
+        FRAME_TRACE_THREAD_NAME("Main");
+        //--- Frames are captured and submitted for inference on background threads, so rendering results here
+        //    doesn't delay submission of the next frames.
+        //--- If you need just plain data without rendering - cast result to DetectionResult
+        //    and use your own processing instead of calling renderDetectionData().
+        StagedRunner::RenderFunction render = [&](const ResultBase& result) {
+            FRAME_TRACE_SCOPE("Render", result.frameId, 0);
+            FRAME_TRACE_FLOW(result.frameId, 0);
+            if (resultsWriter)
+                dumpDetections(*resultsWriter, result.asRef<DetectionResult>(), dumpedRecords);
+            auto renderStartTime = std::chrono::steady_clock::now();
+            cv::Mat outFrame = renderDetectionData(result.asRef<DetectionResult>());
+            metrics.recordStage(PerformanceMetrics::Stage::Render, renderStartTime);
+            if (isProfiling)
+                profiler.addSpan("Render", renderStartTime, std::chrono::steady_clock::now());
             //--- Showing results and device information
             presenter.drawGraphs(outFrame);
-            metrics.update(result->metaData->asRef<ImageMetaData>().timeStamp,
+            metrics.update(result.metaData->asRef<ImageMetaData>().timeStamp,
                 outFrame, { 10, 22 }, 0.65);
             if (!FLAGS_no_show) {
-                cv::imshow("Detection Results", outFrame);
-                //--- Updating output window
-                cv::waitKey(1);
+                std::string windowName = "Detection Results";
+                if (isMultiSource) {
+                    windowName += " " + std::to_string(result.metaData->asRef<ImageMetaData>().sourceId);
+                }
+                cv::imshow(windowName, outFrame);
+                //--- Processing keyboard events
+                int key = cv::waitKey(1);
+                if (27 == key || 'q' == key || 'Q' == key) {  // Esc
+                    return false;
+                }
+                presenter.handleKey(key);
             }
+            return true;
+        };
+        runner.run(*cap, render);
+
+        if (resultsWriter)
+            resultsWriter->close();
+
+        if (runner.getDroppedCapturedCount() || runner.getDroppedResultsCount()) {
+            slog::info << "Dropped frames: " << runner.getDroppedCapturedCount() << " captured, "
+                << runner.getDroppedResultsCount() << " inferred" << slog::endl;
+        }
+
+        if (gatedCap) {
+            slog::info << "Frames skipped by the motion gate: " << gatedCap->getSkippedCount() << slog::endl;
         }
 
         //// --------------------------- Report metrics -------------------------------------------------------
         slog::info << slog::endl << "Metric reports:" << slog::endl;
         metrics.printTotal();
+        if (!FLAGS_report_perf.empty()) {
+            metrics.reportTotal(FLAGS_report_perf);
+        }
+        if (isProfiling) {
+            profiler.printTopLayers(std::cout, 10);
+        }
+        if (!FLAGS_trace.empty()) {
+            std::ofstream traceFile(FLAGS_trace);
+            if (!traceFile)
+                throw std::runtime_error("Can't open " + FLAGS_trace + " for writing");
+            profiler.exportChromeTrace(traceFile);
+        }
 
         slog::info << presenter.reportMeans() << slog::endl;
     }
@@ -17,14 +17,16 @@
 /**
  * @brief Base class of config for network
  */
-struct CnnConfig {
-    explicit CnnConfig(const std::string& path_to_model)
+struct CnnBaseConfig {
+    explicit CnnBaseConfig(const std::string& path_to_model)
         : path_to_model(path_to_model) {}
 
     /** @brief Path to model description */
     std::string path_to_model;
     /** @brief Maximal size of batch */
     int max_batch_size{1};
+    /** @brief Number of infer requests running the batches in parallel */
+    int num_requests{1};
 };
 
 /**
@@ -32,7 +34,7 @@ struct CnnConfig {
  */
 class CnnBase {
 public:
-    using Config = CnnConfig;
+    using Config = CnnBaseConfig;
 
     /**
      * @brief Constructor
@@ -69,6 +71,10 @@ protected:
     /**
      * @brief Run network in batch mode
      *
+     * The batches are inferred asynchronously by all the infer requests,
+     * the results are fetched in the order of the batches.
+     * The last batch is not padded if the device supports dynamic batch.
+     *
      * @param frames Vector of input images
      * @param results_fetcher Callback to fetch inference results
      */
@@ -85,17 +91,19 @@ protected:
     InferenceEngine::OutputsDataMap outInfo_;
     /** @brief IE network */
     InferenceEngine::ExecutableNetwork executable_network_;
-    /** @brief IE InferRequest */
-    mutable InferenceEngine::InferRequest infer_request_;
-    /** @brief Pointer to the pre-allocated input blob */
-    mutable InferenceEngine::Blob::Ptr input_blob_;
-    /** @brief Map of output blobs */
-    InferenceEngine::BlobMap outputs_;
+    /** @brief IE InferRequests */
+    mutable std::vector<InferenceEngine::InferRequest> infer_requests_;
+    /** @brief Pointers to the pre-allocated input blobs of the requests */
+    mutable std::vector<InferenceEngine::Blob::Ptr> input_blobs_;
+    /** @brief Maps of output blobs of the requests */
+    std::vector<InferenceEngine::BlobMap> outputs_;
+    /** @brief Whether the batch size can be set for each inference */
+    bool dynamic_batch_{false};
 };
 
 class VectorCNN : public CnnBase {
 public:
-    VectorCNN(const CnnConfig& config,
+    VectorCNN(const CnnBaseConfig& config,
               const InferenceEngine::Core & ie,
               const std::string & deviceName);
 
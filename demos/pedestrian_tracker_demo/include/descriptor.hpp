@@ -7,6 +7,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <inference_engine.hpp>
 
 #include "opencv2/core/core.hpp"
@@ -53,9 +54,10 @@ public:
 
 
 ///
-/// \brief Uses resized image as descriptor.
+/// \brief Uses resized image as descriptor. It is final, so the batch
+/// Compute() resizes the images without virtual dispatch.
 ///
-class ResizedImageDescriptor : public IImageDescriptor {
+class ResizedImageDescriptor final : public IImageDescriptor {
 public:
     ///
     /// \brief Constructor.
@@ -96,7 +98,7 @@ public:
         PT_CHECK(descrs != nullptr);
         descrs->resize(mats.size());
         for (size_t i = 0; i < mats.size(); i++)  {
-            Compute(mats[i], &(descrs[i]));
+            Compute(mats[i], &(*descrs)[i]);
         }
     }
 
@@ -107,12 +109,17 @@ private:
 };
 
 
-class DescriptorIE : public IImageDescriptor {
+///
+/// \brief Uses embeddings computed by a reidentification network as descriptors.
+/// It is thread-safe, so the trackers of several streams can share it.
+///
+class DescriptorIE final : public IImageDescriptor {
 private:
     VectorCNN handler;
+    std::mutex mutex;
 
 public:
-    DescriptorIE(const CnnConfig& config,
+    DescriptorIE(const CnnBaseConfig& config,
                  const InferenceEngine::Core& ie,
                  const std::string & deviceName):
         handler(config, ie, deviceName) {}
@@ -131,6 +138,7 @@ public:
     /// \param[out] descr Computed descriptor.
     ///
     void Compute(const cv::Mat &mat, cv::Mat *descr) override {
+        std::lock_guard<std::mutex> lock(mutex);
         handler.Compute(mat, descr);
     }
 
@@ -141,6 +149,7 @@ public:
     ///
     void Compute(const std::vector<cv::Mat> &mats,
                  std::vector<cv::Mat> *descrs) override {
+        std::lock_guard<std::mutex> lock(mutex);
         handler.Compute(mats, descrs);
     }
 
@@ -4,61 +4,88 @@
 
 #pragma once
 
-#include <map>
+#include <memory>
 #include <string>
-#include <vector>
 
 #include <opencv2/core/core.hpp>
 
+#include <pipelines/async_pipeline.h>
+#include <samples/trace_profiler.hpp>
+
 #include "core.hpp"
-#include "cnn.hpp"
 
 
-struct DetectorConfig : public CnnConfig {
+struct DetectorConfig {
     explicit DetectorConfig(const std::string& path_to_model)
-        : CnnConfig(path_to_model) {}
+        : path_to_model(path_to_model) {}
 
+    /** @brief Path to model description */
+    std::string path_to_model;
     float confidence_threshold{0.5f};
     float increase_scale_x{1.f};
     float increase_scale_y{1.f};
-    bool is_async = false;
 };
 
-class ObjectDetector {
-private:
-    InferenceEngine::InferRequest::Ptr request;
-    DetectorConfig config_;
-    InferenceEngine::Core ie_;
-    std::string deviceName_;
-
-    InferenceEngine::ExecutableNetwork net_;
-    std::string input_name_;
-    std::string im_info_name_;
-    std::string output_name_;
-    int max_detections_count_;
-    int object_size_;
-    int enqueued_frames_ = 0;
-    float width_ = 0;
-    float height_ = 0;
-    bool results_fetched_ = false;
-    int frame_idx_ = -1;
-
-    TrackedObjects results_;
-
-    void enqueue(const cv::Mat &frame);
-    void submitRequest();
-    void wait();
-    void fetchResults();
+///
+/// \brief Frame with its detections.
+///
+struct DetectedFrame {
+    cv::Mat frame;  ///< Frame the objects are detected on.
+    int frame_idx{-1};  ///< Index of the frame passed to submitFrame.
+    TrackedObjects detections;  ///< Detected objects.
+    bool is_detected{true};  ///< False if the frame is skipped by the detector.
+};
 
+///
+/// \brief Detects objects with the SSD network on top of AsyncPipeline, so
+/// up to nireq frames are detected while the previous ones are tracked.
+/// The results are returned in the order the frames are submitted.
+///
+class ObjectDetector {
 public:
+    ///
+    /// \brief Loads the network.
+    /// \param config Detector parameters.
+    /// \param cnn_config Device, requests and streams, see ConfigFactory.
+    /// \param ie Inference engine, its extensions should be loaded already.
+    ///
     ObjectDetector(const DetectorConfig& config,
-                   const InferenceEngine::Core& ie,
-                   const std::string & deviceName);
+                   const CnnConfig& cnn_config,
+                   InferenceEngine::Core& ie);
 
-    void submitFrame(const cv::Mat &frame, int frame_idx);
-    void waitAndFetchResults();
+    ///
+    /// \brief Returns true if a frame can be submitted now.
+    ///
+    bool isReadyToProcess();
 
-    const TrackedObjects& getResults() const;
+    ///
+    /// \brief Submits the frame for detection, the frame should not be
+    /// modified until its detections are taken.
+    /// \return false if there is no free infer request.
+    ///
+    bool submitFrame(const cv::Mat &frame, int frame_idx);
+
+    ///
+    /// \brief Waits until either the detections of the next frame are ready
+    /// or a frame can be submitted.
+    ///
+    void waitForData();
+
+    ///
+    /// \brief Waits until all the submitted frames are detected.
+    ///
+    void waitForTotalCompletion();
+
+    ///
+    /// \brief Takes the detections of the next submitted frame.
+    /// \return false if they are not ready yet.
+    ///
+    bool getResults(DetectedFrame *detected);
 
     void PrintPerformanceCounts(std::string fullDeviceName);
+
+private:
+    DetectorConfig config_;
+    TraceProfiler profiler_;  ///< Should outlive the pipeline.
+    std::unique_ptr<AsyncPipeline> pipeline_;
 };
@@ -35,14 +35,25 @@ public:
     virtual std::vector<float> Compute(const std::vector<cv::Mat> &descrs1,
                                        const std::vector<cv::Mat> &descrs2) = 0;
 
+    ///
+    /// \brief Computes distances between all pairs of descriptors.
+    /// \param[in] descrs1 First descriptors.
+    /// \param[in] descrs2 Second descriptors.
+    /// \return CV_32F matrix with descrs1.size() rows and descrs2.size() columns,
+    /// its element (i, j) is the distance between descrs1[i] and descrs2[j].
+    ///
+    virtual cv::Mat ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                  const std::vector<cv::Mat> &descrs2);
+
     virtual ~IDescriptorDistance() {}
 };
 
 ///
 /// \brief The CosDistance class allows computing cosine distance between two
-/// reidentification descriptors.
+/// reidentification descriptors. It is final, so its own loops over the
+/// descriptors call Compute() without virtual dispatch.
 ///
-class CosDistance : public IDescriptorDistance {
+class CosDistance final : public IDescriptorDistance {
 public:
     ///
     /// \brief CosDistance constructor.
@@ -68,6 +79,16 @@ public:
         const std::vector<cv::Mat> &descrs1,
         const std::vector<cv::Mat> &descrs2) override;
 
+    ///
+    /// \brief Computes distances between all pairs of descriptors with a
+    /// single matrix multiplication.
+    /// \param[in] descrs1 First descriptors.
+    /// \param[in] descrs2 Second descriptors.
+    /// \return Matrix of distances between descrs1[i] and descrs2[j].
+    ///
+    cv::Mat ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                          const std::vector<cv::Mat> &descrs2) override;
+
 private:
     cv::Size descriptor_size_;
 };
@@ -78,8 +99,10 @@ private:
 /// \brief Computes distance between images
 ///        using MatchTemplate function from OpenCV library
 ///        and its cross-correlation computation method in particular.
+///        It is final, so its own loops over the descriptors call Compute()
+///        without virtual dispatch.
 ///
-class MatchTemplateDistance : public IDescriptorDistance {
+class MatchTemplateDistance final : public IDescriptorDistance {
 public:
     ///
     /// \brief Constructs the distance object.
@@ -110,6 +133,16 @@ public:
     ///
     std::vector<float> Compute(const std::vector<cv::Mat> &descrs1,
                                const std::vector<cv::Mat> &descrs2) override;
+    ///
+    /// \brief Computes distances between all pairs of image descriptors.
+    /// For TM_CCORR_NORMED of equally sized descriptors it is a single matrix
+    /// multiplication instead of a MatchTemplate call per pair.
+    /// \param[in] descrs1 First image descriptors.
+    /// \param[in] descrs2 Second image descriptors.
+    /// \return Matrix of distances between descrs1[i] and descrs2[j].
+    ///
+    cv::Mat ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                          const std::vector<cv::Mat> &descrs2) override;
     virtual ~MatchTemplateDistance() {}
 
 private:
@@ -17,6 +17,9 @@ static const char help_message[] = "Print a usage message.";
 static const char first_frame_message[] = "Optional. The index of the first frame of the input to process. "
                                            "The actual first frame captured depends on cv::VideoCapture implementation "
                                            "and may have slightly different number.";
+static const char extra_inputs_message[] = "Optional. Comma-separated list of more inputs. Every input is tracked "
+                                           "as a separate camera stream in its own thread with its own detection "
+                                           "infer requests, the streams share the reidentification network.";
 static const char limit_message[] = "Optional. Read length limit before stopping or restarting reading the input.";
 static const char pedestrian_detection_model_message[] = "Required. Path to the Pedestrian Detection Retail model (.xml) file.";
 static const char pedestrian_reid_model_message[] = "Required. Path to the Pedestrian Reidentification Retail model (.xml) file.";
@@ -26,6 +29,16 @@ static const char target_device_detection_message[] = "Optional. Specify the tar
 static const char target_device_reid_message[] = "Optional. Specify the target device for pedestrian reidentification "
                                                  "(the list of available devices is shown below). Default value is CPU. "
                                                  "Use \"-d HETERO:<comma-separated_devices_list>\" format to specify HETERO plugin.";
+static const char num_inf_req_message[] = "Optional. Number of infer requests of pedestrian detection. "
+                                          "Detection of the next frames overlaps tracking of the current one.";
+static const char detection_interval_message[] = "Optional. Detect pedestrians on every N-th frame only. Between the "
+                                                 "detected frames the tracks are propagated by their motion and "
+                                                 "template matching, a frame is detected earlier if a track is lost. "
+                                                 "Default value is 1 (every frame is detected).";
+static const char num_threads_message[] = "Optional. Number of threads for pedestrian detection on the CPU.";
+static const char num_streams_message[] = "Optional. Number of streams to use for pedestrian detection on the CPU or/and GPU "
+                                          "in throughput mode (for HETERO and MULTI device cases use format "
+                                          "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
 static const char performance_counter_message[] = "Optional. Enable per-layer performance statistics.";
 static const char custom_cldnn_message[] = "Optional. For GPU custom kernels, if any. "
                                             "Absolute path to the .xml file with the kernels description.";
@@ -43,16 +56,22 @@ static const char utilization_monitors_message[] = "Optional. List of monitors t
 
 
 DEFINE_bool(h, false, help_message);
+DEFINE_string(extra_i, "", extra_inputs_message);
 DEFINE_uint32(first, 0, first_frame_message);
 DEFINE_uint32(limit, gflags::uint32(std::numeric_limits<size_t>::max()), limit_message);
 DEFINE_string(m_det, "", pedestrian_detection_model_message);
 DEFINE_string(m_reid, "", pedestrian_reid_model_message);
 DEFINE_string(d_det, "CPU", target_device_detection_message);
 DEFINE_string(d_reid, "CPU", target_device_reid_message);
+DEFINE_uint32(nireq, 2, num_inf_req_message);
+DEFINE_uint32(det_interval, 1, detection_interval_message);
+DEFINE_uint32(nthreads, 0, num_threads_message);
+DEFINE_string(nstreams, "", num_streams_message);
 DEFINE_bool(pc, false, performance_counter_message);
 DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_bool(r, false, raw_output_message);
+DEFINE_DUMP_FLAG
 DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_int32(delay, 3, delay_message);
 DEFINE_string(out, "", output_log_message);
@@ -70,6 +89,7 @@ static void showUsage() {
     std::cout << "    -h                           " << help_message << std::endl;
     std::cout << "    -i                           " << input_message << std::endl;
     std::cout << "    -loop                        " << loop_message << std::endl;
+    std::cout << "    -extra_i                     " << extra_inputs_message << std::endl;
     std::cout << "    -first                       " << first_frame_message << std::endl;
     std::cout << "    -limit                       " << limit_message << std::endl;
     std::cout << "    -m_det \"<path>\"              " << pedestrian_detection_model_message << std::endl;
@@ -79,7 +99,12 @@ static void showUsage() {
     std::cout << "    -c \"<absolute_path>\"         " << custom_cldnn_message << std::endl;
     std::cout << "    -d_det \"<device>\"            " << target_device_detection_message << std::endl;
     std::cout << "    -d_reid \"<device>\"           " << target_device_reid_message << std::endl;
+    std::cout << "    -nireq \"<integer>\"           " << num_inf_req_message << std::endl;
+    std::cout << "    -det_interval \"<integer>\"    " << detection_interval_message << std::endl;
+    std::cout << "    -nthreads \"<integer>\"        " << num_threads_message << std::endl;
+    std::cout << "    -nstreams                    " << num_streams_message << std::endl;
     std::cout << "    -r                           " << raw_output_message << std::endl;
+    std::cout << "    -dump \"<path>\"               " << dump_message << std::endl;
     std::cout << "    -pc                          " << performance_counter_message << std::endl;
     std::cout << "    -no_show                     " << no_show_processed_video << std::endl;
     std::cout << "    -delay                       " << delay_message << std::endl;
@@ -15,6 +15,8 @@
 #include <unordered_map>
 #include <utility>
 
+#include <tracker_core/tracker_core.h>
+
 #include "utils.hpp"
 #include "descriptor.hpp"
 #include "distance.hpp"
@@ -65,6 +67,10 @@ struct TrackerParams {
                                    /// restricted by this parameter. If it is negative or zero, the max number of
                                    /// objects in track is not restricted.
 
+    float min_propagation_score;  ///< Min template matching score of a track
+                                  /// propagated to a frame without detections.
+                                  /// The track is lost if its score is lower.
+
     ///
     /// Default constructor.
     ///
@@ -74,7 +80,7 @@ struct TrackerParams {
 ///
 /// \brief The Track struct describes tracks.
 ///
-struct Track {
+struct Track : public TrackBase<TrackedObject, TrackedObjects> {
     ///
     /// \brief Track constructor.
     /// \param objs Detected objects sequence.
@@ -84,74 +90,18 @@ struct Track {
     ///
     Track(const TrackedObjects &objs, const cv::Mat &last_image,
           const cv::Mat &descriptor_fast, const cv::Mat &descriptor_strong)
-        : objects(objs),
-        predicted_rect(!objs.empty() ? objs.back().rect : cv::Rect()),
+        : TrackBase(objs),
+        predicted_rect(objs.back().rect),
         last_image(last_image),
         descriptor_fast(descriptor_fast),
-        descriptor_strong(descriptor_strong),
-        lost(0),
-        length(1) {
-            PT_CHECK(!objs.empty());
-            first_object = objs[0];
-        }
-
-    ///
-    /// \brief empty returns if track does not contain objects.
-    /// \return true if track does not contain objects.
-    ///
-    bool empty() const { return objects.empty(); }
-
-    ///
-    /// \brief size returns number of detected objects in a track.
-    /// \return number of detected objects in a track.
-    ///
-    size_t size() const { return objects.size(); }
-
-    ///
-    /// \brief operator [] return const reference to detected object with
-    ///        specified index.
-    /// \param i Index of object.
-    /// \return const reference to detected object with specified index.
-    ///
-    const TrackedObject &operator[](size_t i) const { return objects[i]; }
-
-    ///
-    /// \brief operator [] return non-const reference to detected object with
-    ///        specified index.
-    /// \param i Index of object.
-    /// \return non-const reference to detected object with specified index.
-    ///
-    TrackedObject &operator[](size_t i) { return objects[i]; }
+        descriptor_strong(descriptor_strong) {}
 
-    ///
-    /// \brief back returns const reference to last object in track.
-    /// \return const reference to last object in track.
-    ///
-    const TrackedObject &back() const {
-        PT_CHECK(!empty());
-        return objects.back();
-    }
-
-    ///
-    /// \brief back returns non-const reference to last object in track.
-    /// \return non-const reference to last object in track.
-    ///
-    TrackedObject &back() {
-        PT_CHECK(!empty());
-        return objects.back();
-    }
-
-    TrackedObjects objects;   ///< Detected objects;
     cv::Rect predicted_rect;  ///< Rectangle that represents predicted position
                               /// and size of bounding box if track has been lost.
-    cv::Mat last_image;       ///< Image of last detected object in track.
+    cv::Mat last_image;       ///< Image of last detected object in track. It is
+                              /// kept only until the strong descriptor is computed.
     cv::Mat descriptor_fast;  ///< Fast descriptor.
     cv::Mat descriptor_strong;  ///< Strong descriptor (reid embedding).
-    size_t lost;                ///< How many frames ago track has been lost.
-
-    TrackedObject first_object;  ///< First object in track.
-    size_t length;  ///< Length of a track including number of objects that were
-                    /// removed from track in order to avoid memory usage growth.
 };
 
 ///
@@ -194,6 +144,20 @@ public:
     void Process(const cv::Mat &frame, const TrackedObjects &detections,
                  uint64_t timestamp);
 
+    ///
+    /// \brief Propagates the tracks to a frame which isn't detected. The
+    /// position of every track is predicted by its motion and refined by
+    /// matching its fast descriptor around the predicted position.
+    /// \param[in] frame Colored image (CV_8UC3).
+    /// \param[in] frame_idx Index of the frame.
+    /// \param[in] timestamp Timestamp must be positive and measured in
+    /// milliseconds
+    /// \return The lowest matching score of the propagated tracks, 1 if there
+    /// are no tracks. The tracks with the score lower than
+    /// min_propagation_score are lost, so the next frame should be detected.
+    ///
+    float Propagate(const cv::Mat &frame, int frame_idx, uint64_t timestamp);
+
     ///
     /// \brief Pipeline parameters getter.
     /// \return Parameters of pipeline.
@@ -333,12 +297,6 @@ private:
 
 
     const ObjectTracks all_tracks(bool valid_only) const;
-    // Returns shape affinity.
-    static float ShapeAffinity(float w, const cv::Rect &trk, const cv::Rect &det);
-
-    // Returns motion affinity.
-    static float MotionAffinity(float w, const cv::Rect &trk,
-                                const cv::Rect &det);
 
     // Returns time affinity.
     static float TimeAffinity(float w, const float &trk, const float &det);
@@ -363,7 +321,7 @@ private:
     void ComputeDissimilarityMatrix(const std::set<size_t> &active_track_ids,
                                     const TrackedObjects &detections,
                                     const std::vector<cv::Mat> &fast_descriptors,
-                                    cv::Mat *dissimilarity_matrix);
+                                    float thr, cv::Mat *dissimilarity_matrix);
 
     std::vector<float> ComputeDistances(
         const cv::Mat &frame,
@@ -379,9 +337,6 @@ private:
     std::vector<std::pair<size_t, size_t>> GetTrackToDetectionIds(
         const std::set<std::tuple<size_t, size_t, float>> &matches);
 
-    float AffinityFast(const cv::Mat &descriptor1, const TrackedObject &obj1,
-                       const cv::Mat &descriptor2, const TrackedObject &obj2);
-
     float Affinity(const TrackedObject &obj1, const TrackedObject &obj2);
 
     void AddNewTrack(const cv::Mat &frame, const TrackedObject &detection,
@@ -410,14 +365,11 @@ private:
 
     const std::set<size_t> &active_track_ids() const;
 
-    TrackedObjects FilterDetections(const TrackedObjects &detections) const;
-    bool IsTrackForgotten(const Track &track) const;
-
     // Parameters of the pipeline.
     TrackerParams params_;
 
-    // Indexes of active tracks.
-    std::set<size_t> active_track_ids_;
+    // Tracks and their IDs.
+    TrackerCore<Track> core_;
 
     // Descriptor fast (base classifer).
     Descriptor descriptor_fast_;
@@ -431,25 +383,9 @@ private:
     // Distance strong (reid classifier).
     Distance distance_strong_;
 
-    // All tracks.
-    std::unordered_map<size_t, Track> tracks_;
-
     // Previous frame image.
     cv::Size prev_frame_size_;
 
-    struct pair_hash {
-        std::size_t operator()(const std::pair<size_t, size_t> &p) const {
-            PT_CHECK(p.first < 1e6 && p.second < 1e6);
-            return static_cast<size_t>(p.first * 1e6 + p.second);
-        }
-    };
-
-    // Distance between current active tracks.
-    std::unordered_map<std::pair<size_t, size_t>, float, pair_hash> tracks_dists_;
-
-    // Number of all current tracks.
-    size_t tracks_counter_;
-
     cv::Size frame_size_;
 
     std::vector<cv::Scalar> colors_;
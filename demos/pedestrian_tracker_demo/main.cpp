@@ -11,11 +11,22 @@
 #include "pedestrian_tracker_demo.hpp"
 
 #include <monitors/presenter.h>
+#include <pipelines/config_factory.h>
 #include <samples/images_capture.h>
+#include <samples/results_writer.hpp>
 
 #include <opencv2/core.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <map>
@@ -24,12 +35,33 @@
 #include <gflags/gflags.h>
 
 using namespace InferenceEngine;
-using ImageWithFrameIndex = std::pair<cv::Mat, int>;
+
+std::shared_ptr<IImageDescriptor>
+CreateReidDescriptor(const std::string& reid_model,
+                     const InferenceEngine::Core & ie,
+                     const std::string & deviceName) {
+    if (reid_model.empty()) {
+        std::cout << "WARNING: Reid model "
+            << "was not specified. "
+            << "Only fast reidentification approach will be used." << std::endl;
+        return nullptr;
+    }
+
+    CnnBaseConfig reid_config(reid_model);
+    reid_config.max_batch_size = 16;   // defaulting to 16
+    reid_config.num_requests = 2;      // the next batch is filled while the previous one is inferred
+
+    std::shared_ptr<IImageDescriptor> descriptor_strong =
+        std::make_shared<DescriptorIE>(reid_config, ie, deviceName);
+
+    if (descriptor_strong == nullptr) {
+        THROW_IE_EXCEPTION << "[SAMPLES] internal error - invalid descriptor";
+    }
+    return descriptor_strong;
+}
 
 std::unique_ptr<PedestrianTracker>
-CreatePedestrianTracker(const std::string& reid_model,
-                        const InferenceEngine::Core & ie,
-                        const std::string & deviceName,
+CreatePedestrianTracker(const std::shared_ptr<IImageDescriptor>& descriptor_strong,
                         bool should_keep_tracking_info) {
     TrackerParams params;
 
@@ -50,30 +82,289 @@ CreatePedestrianTracker(const std::string& reid_model,
     tracker->set_descriptor_fast(descriptor_fast);
     tracker->set_distance_fast(distance_fast);
 
-    if (!reid_model.empty()) {
-        CnnConfig reid_config(reid_model);
-        reid_config.max_batch_size = 16;   // defaulting to 16
-
-        std::shared_ptr<IImageDescriptor> descriptor_strong =
-            std::make_shared<DescriptorIE>(reid_config, ie, deviceName);
-
-        if (descriptor_strong == nullptr) {
-            THROW_IE_EXCEPTION << "[SAMPLES] internal error - invalid descriptor";
-        }
+    if (descriptor_strong != nullptr) {
         std::shared_ptr<IDescriptorDistance> distance_strong =
             std::make_shared<CosDistance>(descriptor_strong->size());
 
         tracker->set_descriptor_strong(descriptor_strong);
         tracker->set_distance_strong(distance_strong);
-    } else {
-        std::cout << "WARNING: Reid model "
-            << "was not specified. "
-            << "Only fast reidentification approach will be used." << std::endl;
     }
 
     return tracker;
 }
 
+///
+/// \brief Chooses the frames to detect: every interval-th frame and the frame
+/// after a track is lost between the detected frames.
+///
+class KeyframeSelector {
+public:
+    explicit KeyframeSelector(unsigned interval)
+        : interval_(static_cast<int>(std::max(interval, 1u))), last_detected_idx_(-interval_) {}
+
+    bool ShouldDetect(int frame_idx) {
+        if (!is_detection_requested_ && frame_idx - last_detected_idx_ < interval_) return false;
+        is_detection_requested_ = false;
+        last_detected_idx_ = frame_idx;
+        return true;
+    }
+
+    void RequestDetection() { is_detection_requested_ = true; }
+
+private:
+    int interval_;
+    int last_detected_idx_;
+    bool is_detection_requested_ = false;
+};
+
+///
+/// \brief Detects the frames of the input starting from the first frame, the
+/// next frames are read and submitted while there are free infer requests.
+/// \param should_detect Called for every read frame, returns false to skip
+/// the detection of the frame.
+/// \param process Called for every frame in the order of the frames, returns
+/// false to stop.
+///
+void DetectFrames(ImagesCapture &cap, const cv::Mat &first_frame, ObjectDetector &detector,
+                  const std::function<bool(int)> &should_detect,
+                  const std::function<bool(const DetectedFrame &)> &process) {
+    // The skipped frames wait for the frames submitted before them, so the
+    // number of read frames is limited when most of them are skipped
+    const size_t max_read_frames = 16;
+    const cv::Size first_frame_size = first_frame.size();
+    std::deque<DetectedFrame> read_frames;
+    auto submit = [&](const cv::Mat &frame, int frame_idx) {
+        DetectedFrame read;
+        read.frame = frame;
+        read.frame_idx = frame_idx;
+        read.is_detected = should_detect(frame_idx);
+        if (read.is_detected) detector.submitFrame(frame, frame_idx);
+        read_frames.push_back(std::move(read));
+    };
+
+    submit(first_frame, 0);
+    int next_frame_idx = 1;
+    bool is_input_finished = false;
+    DetectedFrame detected;
+    for (;;) {
+        while (!is_input_finished && read_frames.size() < max_read_frames && detector.isReadyToProcess()) {
+            cv::Mat frame = cap.read();
+            if (!frame.data) {
+                is_input_finished = true;
+                break;
+            }
+            if (frame.size() != first_frame_size)
+                throw std::runtime_error("Can't track objects on images of different size");
+            submit(frame, next_frame_idx++);
+        }
+
+        bool is_processed = false;
+        while (!read_frames.empty()) {
+            if (read_frames.front().is_detected) {
+                if (!detector.getResults(&detected)) break;
+                detected.is_detected = true;
+            } else {
+                detected = std::move(read_frames.front());
+            }
+            read_frames.pop_front();
+            is_processed = true;
+            if (!process(detected)) return;
+        }
+        if (is_input_finished && read_frames.empty()) return;
+
+        if (!is_processed) {
+            if (is_input_finished || read_frames.size() >= max_read_frames) {
+                detector.waitForTotalCompletion();
+            } else {
+                detector.waitForData();
+            }
+        }
+    }
+}
+
+///
+/// \brief Passes the detections of the frame to the tracker or propagates the
+/// tracks if the frame is skipped by the detector.
+///
+void TrackFrame(PedestrianTracker &tracker, KeyframeSelector &keyframes, const DetectedFrame &detected,
+                double video_fps) {
+    // timestamp in milliseconds
+    uint64_t cur_timestamp = static_cast<uint64_t >(1000.0 / video_fps * detected.frame_idx);
+    if (detected.is_detected) {
+        tracker.Process(detected.frame, detected.detections, cur_timestamp);
+    } else if (tracker.Propagate(detected.frame, detected.frame_idx, cur_timestamp)
+               < tracker.params().min_propagation_score) {
+        keyframes.RequestDetection();
+    }
+}
+
+///
+/// \brief Writes the tracked objects of the frame, records are reused by the
+/// next frames of the same thread.
+///
+void DumpTrackedObjects(ResultsWriter &writer, unsigned stream_idx, int frame_idx,
+                        const TrackedObjects &objects, std::vector<ResultsWriter::Record> &records) {
+    records.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        ResultsWriter::Record &record = records[i];
+        record.stream = stream_idx;
+        record.frame = frame_idx;
+        record.id = objects[i].object_id;
+        record.confidence = static_cast<float>(objects[i].confidence);
+        record.box = objects[i].rect;
+    }
+    writer.write(records);
+}
+
+///
+/// \brief One of several tracked streams. The stream owns its detector and
+/// tracker, the reid descriptor is shared by all the streams.
+///
+struct TrackedStream {
+    TrackedStream(std::unique_ptr<ImagesCapture> &&cap, const DetectorConfig &detector_config,
+                  const CnnConfig &detector_cnn_config, InferenceEngine::Core &ie,
+                  std::unique_ptr<PedestrianTracker> &&tracker)
+        : cap(std::move(cap)), detector(detector_config, detector_cnn_config, ie),
+          tracker(std::move(tracker)) {}
+
+    std::unique_ptr<ImagesCapture> cap;
+    ObjectDetector detector;
+    std::unique_ptr<PedestrianTracker> tracker;
+    std::exception_ptr error;
+
+    std::mutex mutex;
+    cv::Mat shown_frame;  ///< The last frame with the tracks drawn, protected by the mutex.
+};
+
+void TrackStream(TrackedStream &stream, unsigned stream_idx, bool should_show, ResultsWriter *results_writer,
+                 const std::atomic<bool> &stop) {
+    cv::Mat frame = stream.cap->read();
+    if (!frame.data) throw std::runtime_error("Can't read an image from the input");
+    double video_fps = stream.cap->fps();
+    if (0.0 == video_fps) {
+        // the default frame rate for DukeMTMC dataset
+        video_fps = 60.0;
+    }
+
+    std::vector<ResultsWriter::Record> dumped_records;
+    KeyframeSelector keyframes(FLAGS_det_interval);
+    auto should_detect = [&](int frame_idx) { return keyframes.ShouldDetect(frame_idx); };
+    DetectFrames(*stream.cap, frame, stream.detector, should_detect, [&](const DetectedFrame &detected) {
+        TrackFrame(*stream.tracker, keyframes, detected, video_fps);
+        if (results_writer) {
+            DumpTrackedObjects(*results_writer, stream_idx, detected.frame_idx,
+                               stream.tracker->TrackedDetections(), dumped_records);
+        }
+
+        if (should_show) {
+            cv::Mat shown_frame = stream.tracker->DrawActiveTracks(detected.frame);
+            for (const auto &detection : stream.tracker->TrackedDetections()) {
+                cv::rectangle(shown_frame, detection.rect, cv::Scalar(0, 0, 255), 3);
+            }
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            stream.shown_frame = shown_frame;
+        }
+        return !stop;
+    });
+}
+
+cv::Mat TileFrames(const std::vector<cv::Mat> &frames, const cv::Size &size) {
+    const int cols = static_cast<int>(std::ceil(std::sqrt(frames.size())));
+    const int rows = static_cast<int>((frames.size() + cols - 1) / cols);
+    const cv::Size tile_size(size.width / cols, size.height / cols);
+    cv::Mat tiled(tile_size.height * rows, tile_size.width * cols, CV_8UC3, cv::Scalar(0, 0, 0));
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (!frames[i].empty()) {
+            cv::Rect tile(cv::Point(static_cast<int>(i % cols) * tile_size.width,
+                                    static_cast<int>(i / cols) * tile_size.height), tile_size);
+            cv::resize(frames[i], tiled(tile), tile_size);
+        }
+    }
+    return tiled;
+}
+
+std::string GetStreamLogPath(const std::string &path, size_t stream_idx) {
+    if (stream_idx == 0) return path;
+    size_t ext_pos = path.find_last_of('.');
+    if (ext_pos == std::string::npos || path.find_first_of("/\\", ext_pos) != std::string::npos)
+        ext_pos = path.size();
+    return path.substr(0, ext_pos) + "_" + std::to_string(stream_idx) + path.substr(ext_pos);
+}
+
+void TrackStreams(const std::vector<std::string> &inputs, const DetectorConfig &detector_config,
+                  const CnnConfig &detector_cnn_config,
+                  const std::shared_ptr<IImageDescriptor> &descriptor_strong,
+                  bool should_keep_tracking_info, int delay, Presenter &presenter,
+                  InferenceEngine::Core &ie, ResultsWriter *results_writer) {
+    std::vector<std::unique_ptr<TrackedStream>> streams;
+    for (const auto &input : inputs) {
+        streams.emplace_back(new TrackedStream(
+            openImagesCapture(input, FLAGS_loop, FLAGS_first, FLAGS_limit),
+            detector_config, detector_cnn_config, ie,
+            CreatePedestrianTracker(descriptor_strong, should_keep_tracking_info)));
+    }
+
+    const bool should_show = delay >= 0;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> num_running{streams.size()};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < streams.size(); i++) {
+        TrackedStream *stream_ptr = streams[i].get();
+        const unsigned stream_idx = static_cast<unsigned>(i);
+        workers.emplace_back([stream_ptr, stream_idx, should_show, results_writer, &stop, &num_running] {
+            try {
+                TrackStream(*stream_ptr, stream_idx, should_show, results_writer, stop);
+            } catch (...) {
+                stream_ptr->error = std::current_exception();
+            }
+            num_running--;
+        });
+    }
+
+    cv::Size window_size;
+    while (should_show && num_running > 0) {
+        std::vector<cv::Mat> shown_frames;
+        for (auto &stream : streams) {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            shown_frames.push_back(stream->shown_frame);
+            if (window_size == cv::Size() && !stream->shown_frame.empty())
+                window_size = stream->shown_frame.size() / 2;
+        }
+        if (window_size != cv::Size()) {
+            cv::Mat tiled = TileFrames(shown_frames, window_size);
+            presenter.drawGraphs(tiled);
+            cv::imshow("dbg", tiled);
+        }
+        char k = cv::waitKey(std::max(delay, 1));
+        if (k == 27)
+            stop = true;
+        presenter.handleKey(k);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (auto &stream : streams) {
+        if (stream->error) std::rethrow_exception(stream->error);
+    }
+
+    if (should_keep_tracking_info) {
+        for (size_t i = 0; i < streams.size(); i++) {
+            DetectionLog log = streams[i]->tracker->GetDetectionLog(true);
+
+            if (!FLAGS_out.empty())
+                SaveDetectionLogToTrajFile(GetStreamLogPath(FLAGS_out, i), log);
+            if (FLAGS_r) {
+                std::cout << "Stream " << i << " (" << inputs[i] << "):" << std::endl;
+                PrintDetectionLog(log);
+            }
+        }
+    }
+    if (FLAGS_pc) {
+        streams.front()->detector.PrintPerformanceCounts(getFullDeviceName(ie, FLAGS_d_det));
+        streams.front()->tracker->PrintReidPerformanceCounts(getFullDeviceName(ie, FLAGS_d_reid));
+    }
+}
+
 bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     // ---------------------------Parsing and validation of input args--------------------------------------
 
@@ -136,13 +427,60 @@ int main(int argc, char **argv) {
                 devices, custom_cpu_library, path_to_custom_layers,
                 should_use_perf_counter);
 
+        const bool is_multi_stream = !FLAGS_extra_i.empty();
+        if (is_multi_stream) {
+            // The requests of different streams run in parallel
+            for (const auto &device : devices) {
+                if (device.find("CPU") != std::string::npos) {
+                    ie.SetConfig({{CONFIG_KEY(CPU_THROUGHPUT_STREAMS), CONFIG_VALUE(CPU_THROUGHPUT_AUTO)}}, "CPU");
+                } else if (device.find("GPU") != std::string::npos) {
+                    ie.SetConfig({{CONFIG_KEY(GPU_THROUGHPUT_STREAMS), CONFIG_VALUE(GPU_THROUGHPUT_AUTO)}}, "GPU");
+                }
+            }
+        }
+
         DetectorConfig detector_confid(det_model);
-        ObjectDetector pedestrian_detector(detector_confid, ie, detector_mode);
+        // The extensions are loaded to the engine already
+        CnnConfig detector_cnn_config = ConfigFactory::getUserConfig(
+            detector_mode, "", "", should_use_perf_counter, FLAGS_nireq, FLAGS_nstreams, FLAGS_nthreads);
 
         bool should_keep_tracking_info = should_save_det_log || should_print_out;
+        std::shared_ptr<IImageDescriptor> descriptor_strong =
+            CreateReidDescriptor(reid_model, ie, reid_mode);
+
+        std::unique_ptr<ResultsWriter> results_writer;
+        if (!FLAGS_dump.empty()) {
+            results_writer.reset(new ResultsWriter(FLAGS_dump, ResultsWriter::formatFromFileName(FLAGS_dump)));
+        }
+
+        if (is_multi_stream) {
+            std::vector<std::string> inputs{FLAGS_i};
+            std::stringstream extra_inputs(FLAGS_extra_i);
+            std::string input;
+            while (std::getline(extra_inputs, input, ',')) {
+                if (!input.empty()) inputs.push_back(input);
+            }
+
+            Presenter presenter(FLAGS_u, 10);
+
+            std::cout << "To close the application, press 'CTRL+C' here";
+            if (should_show) {
+                std::cout << " or switch to the output window and press ESC key";
+            }
+            std::cout << std::endl;
+
+            TrackStreams(inputs, detector_confid, detector_cnn_config, descriptor_strong,
+                         should_keep_tracking_info, delay, presenter, ie, results_writer.get());
+            if (results_writer) results_writer->close();
+
+            std::cout << presenter.reportMeans() << '\n';
+            std::cout << "Execution successful" << std::endl;
+            return 0;
+        }
+
+        ObjectDetector pedestrian_detector(detector_confid, detector_cnn_config, ie);
         std::unique_ptr<PedestrianTracker> tracker =
-            CreatePedestrianTracker(reid_model, ie, reid_mode,
-                                    should_keep_tracking_info);
+            CreatePedestrianTracker(descriptor_strong, should_keep_tracking_info);
 
         std::unique_ptr<ImagesCapture> cap = openImagesCapture(FLAGS_i, FLAGS_loop, FLAGS_first, FLAGS_limit);
         double video_fps = cap->fps();
@@ -151,11 +489,10 @@ int main(int argc, char **argv) {
             video_fps = 60.0;
         }
 
-        cv::Mat frame = cap->read();
-        if (!frame.data) throw std::runtime_error("Can't read an image from the input");
-        cv::Size firstFrameSize = frame.size();
+        cv::Mat first_frame = cap->read();
+        if (!first_frame.data) throw std::runtime_error("Can't read an image from the input");
 
-        cv::Size graphSize{static_cast<int>(frame.cols / 4), 60};
+        cv::Size graphSize{static_cast<int>(first_frame.cols / 4), 60};
         Presenter presenter(FLAGS_u, 10, graphSize);
 
         std::cout << "To close the application, press 'CTRL+C' here";
@@ -164,15 +501,18 @@ int main(int argc, char **argv) {
         }
         std::cout << std::endl;
 
-        for (unsigned frameIdx = 0; ; ++frameIdx) {
-            pedestrian_detector.submitFrame(frame, frameIdx);
-            pedestrian_detector.waitAndFetchResults();
-
-            TrackedObjects detections = pedestrian_detector.getResults();
-
-            // timestamp in milliseconds
-            uint64_t cur_timestamp = static_cast<uint64_t >(1000.0 / video_fps * frameIdx);
-            tracker->Process(frame, detections, cur_timestamp);
+        std::vector<ResultsWriter::Record> dumped_records;
+        KeyframeSelector keyframes(FLAGS_det_interval);
+        auto should_detect = [&](int frame_idx) { return keyframes.ShouldDetect(frame_idx); };
+        DetectFrames(*cap, first_frame, pedestrian_detector, should_detect, [&](const DetectedFrame &detected) {
+            const auto &detections = detected.detections;
+            const int frameIdx = detected.frame_idx;
+            cv::Mat frame = detected.frame;
+
+            TrackFrame(*tracker, keyframes, detected, video_fps);
+            if (results_writer) {
+                DumpTrackedObjects(*results_writer, 0, frameIdx, tracker->TrackedDetections(), dumped_records);
+            }
 
             presenter.drawGraphs(frame);
 
@@ -199,7 +539,7 @@ int main(int argc, char **argv) {
                 cv::imshow("dbg", frame);
                 char k = cv::waitKey(delay);
                 if (k == 27)
-                    break;
+                    return false;
                 presenter.handleKey(k);
             }
 
@@ -207,11 +547,10 @@ int main(int argc, char **argv) {
                 DetectionLog log = tracker->GetDetectionLog(true);
                 SaveDetectionLogToTrajFile(detlog_out, log);
             }
-            frame = cap->read();
-            if (!frame.data) break;
-            if (frame.size() != firstFrameSize)
-                throw std::runtime_error("Can't track objects on images of different size");
-        }
+            return true;
+        });
+
+        if (results_writer) results_writer->close();
 
         if (should_keep_tracking_info) {
             DetectionLog log = tracker->GetDetectionLog(true);
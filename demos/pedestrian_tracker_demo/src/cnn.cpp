@@ -4,6 +4,7 @@
 
 #include "cnn.hpp"
 
+#include <map>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -37,49 +38,86 @@ void CnnBase::Load() {
 
     SizeVector inputDims = in.begin()->second->getTensorDesc().getDims();
     in.begin()->second->setPrecision(Precision::U8);
-    input_blob_ = make_shared_blob<uint8_t>(TensorDesc(Precision::U8, inputDims, Layout::NCHW));
-    input_blob_->allocate();
-    BlobMap inputs;
-    inputs[in.begin()->first] = input_blob_;
     outInfo_ = cnnNetwork.getOutputsInfo();
-
     for (auto&& item : outInfo_) {
-        SizeVector outputDims = item.second->getTensorDesc().getDims();
-        auto outputLayout = item.second->getTensorDesc().getLayout();
         item.second->setPrecision(Precision::FP32);
-        TBlob<float>::Ptr output =
-            make_shared_blob<float>(TensorDesc(Precision::FP32, outputDims, outputLayout));
-        output->allocate();
-        outputs_[item.first] = output;
     }
 
-    executable_network_ = ie_.LoadNetwork(cnnNetwork, deviceName_);
-    infer_request_ = executable_network_.CreateInferRequest();
-    infer_request_.SetInput(inputs);
-    infer_request_.SetOutput(outputs_);
+    std::map<std::string, std::string> loadConfig;
+    dynamic_batch_ = config_.max_batch_size > 1 &&
+                     (deviceName_.find("CPU") != std::string::npos ||
+                      deviceName_.find("GPU") != std::string::npos);
+    if (dynamic_batch_) {
+        loadConfig[PluginConfigParams::KEY_DYN_BATCH_ENABLED] = PluginConfigParams::YES;
+    }
+    executable_network_ = ie_.LoadNetwork(cnnNetwork, deviceName_, loadConfig);
+
+    for (int i = 0; i < std::max(config_.num_requests, 1); i++) {
+        Blob::Ptr input = make_shared_blob<uint8_t>(TensorDesc(Precision::U8, inputDims, Layout::NCHW));
+        input->allocate();
+        BlobMap inputs;
+        inputs[in.begin()->first] = input;
+
+        BlobMap outputs;
+        for (auto&& item : outInfo_) {
+            SizeVector outputDims = item.second->getTensorDesc().getDims();
+            auto outputLayout = item.second->getTensorDesc().getLayout();
+            TBlob<float>::Ptr output =
+                make_shared_blob<float>(TensorDesc(Precision::FP32, outputDims, outputLayout));
+            output->allocate();
+            outputs[item.first] = output;
+        }
+
+        infer_requests_.push_back(executable_network_.CreateInferRequest());
+        infer_requests_.back().SetInput(inputs);
+        infer_requests_.back().SetOutput(outputs);
+        input_blobs_.push_back(input);
+        outputs_.push_back(outputs);
+    }
 }
 
 void CnnBase::InferBatch(
     const std::vector<cv::Mat>& frames,
     const std::function<void(const InferenceEngine::BlobMap&, size_t)>& fetch_results) const {
-    const size_t batch_size = input_blob_->getTensorDesc().getDims()[0];
+    const size_t batch_size = input_blobs_.front()->getTensorDesc().getDims()[0];
+    const size_t num_requests = infer_requests_.size();
 
     size_t num_imgs = frames.size();
-    for (size_t batch_i = 0; batch_i < num_imgs; batch_i += batch_size) {
-        const size_t current_batch_size = std::min(batch_size, num_imgs - batch_i);
-        for (size_t b = 0; b < current_batch_size; b++) {
-            matU8ToBlob<uint8_t>(frames[batch_i + b], input_blob_, b);
+    const size_t num_batches = (num_imgs + batch_size - 1) / batch_size;
+    auto current_batch_size = [&](size_t batch) {
+        return std::min(batch_size, num_imgs - batch * batch_size);
+    };
+    auto wait_and_fetch = [&](size_t batch) {
+        const size_t request_i = batch % num_requests;
+        infer_requests_[request_i].Wait(IInferRequest::WaitMode::RESULT_READY);
+        fetch_results(outputs_[request_i], current_batch_size(batch));
+    };
+
+    for (size_t batch = 0; batch < num_batches; batch++) {
+        // The request is free once its previous batch is fetched
+        if (batch >= num_requests) {
+            wait_and_fetch(batch - num_requests);
         }
 
-        infer_request_.Infer();
+        const size_t request_i = batch % num_requests;
+        for (size_t b = 0; b < current_batch_size(batch); b++) {
+            matU8ToBlob<uint8_t>(frames[batch * batch_size + b], input_blobs_[request_i], b);
+        }
+        if (dynamic_batch_) {
+            infer_requests_[request_i].SetBatch(static_cast<int>(current_batch_size(batch)));
+        }
+        infer_requests_[request_i].StartAsync();
+    }
 
-        fetch_results(outputs_, current_batch_size);
+    for (size_t batch = num_batches > num_requests ? num_batches - num_requests : 0;
+         batch < num_batches; batch++) {
+        wait_and_fetch(batch);
     }
 }
 
 void CnnBase::PrintPerformanceCounts(std::string fullDeviceName) const {
     std::cout << "Performance counts for " << config_.path_to_model << std::endl << std::endl;
-    ::printPerformanceCounts(infer_request_, std::cout, fullDeviceName, false);
+    ::printPerformanceCounts(infer_requests_.front(), std::cout, fullDeviceName, false);
 }
 
 void CnnBase::Infer(const cv::Mat& frame,
@@ -93,7 +131,7 @@ VectorCNN::VectorCNN(const Config& config,
     : CnnBase(config, ie, deviceName) {
     Load();
 
-    if (outputs_.size() != 1) {
+    if (outInfo_.size() != 1) {
         THROW_IE_EXCEPTION << "Demo supports topologies only with 1 output";
     }
 
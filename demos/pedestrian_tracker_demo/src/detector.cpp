@@ -5,18 +5,31 @@
 #include "detector.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
 #include <string>
-#include <map>
+#include <vector>
 #include <opencv2/core/core.hpp>
 #include <inference_engine.hpp>
 
-#include <ngraph/ngraph.hpp>
+#include <models/detection_model_ssd.h>
+#include <pipelines/metadata.h>
 
 using namespace InferenceEngine;
 
-#define SSD_EMPTY_DETECTIONS_INDICATOR -1.0
-
 namespace {
+struct FrameMetaData : public ImageMetaData {
+    FrameMetaData(const cv::Mat& frame, int frame_idx)
+        : ImageMetaData(frame, std::chrono::steady_clock::now()), frame_idx(frame_idx) {}
+
+    int frame_idx;
+};
+
+int RoundCoordinate(float value, float max_value) {
+    return static_cast<int>(std::round(std::min(std::max(0.0f, value), max_value)));
+}
+
 cv::Rect TruncateToValidRect(const cv::Rect& rect,
                              const cv::Size& size) {
     auto tl = rect.tl(), br = rect.br();
@@ -46,166 +59,78 @@ cv::Rect IncreaseRect(const cv::Rect& r, float coeff_x,
 }
 }  // namespace
 
-void ObjectDetector::submitRequest() {
-    if (request == nullptr) return;
-    if (!enqueued_frames_) return;
-    enqueued_frames_ = 0;
-    results_fetched_ = false;
-    results_.clear();
-
-    if (config_.is_async) {
-        request->StartAsync();
-    } else {
-        request->Infer();
+ObjectDetector::ObjectDetector(
+    const DetectorConfig& config,
+    const CnnConfig& cnn_config,
+    InferenceEngine::Core& ie) :
+    config_(config) {
+    pipeline_.reset(new AsyncPipeline(
+        std::unique_ptr<ModelBase>(new ModelSSD(config_.path_to_model, config_.confidence_threshold, false,
+            std::vector<std::string>(), true)),
+        cnn_config, ie));
+    auto perf_count = cnn_config.execNetworkConfig.find(CONFIG_KEY(PERF_COUNT));
+    if (perf_count != cnn_config.execNetworkConfig.end() && perf_count->second == PluginConfigParams::YES) {
+        pipeline_->setTraceProfiler(&profiler_);
     }
 }
 
-const TrackedObjects& ObjectDetector::getResults() const {
-    return results_;
+bool ObjectDetector::isReadyToProcess() {
+    return pipeline_->isReadyToProcess();
 }
 
-void ObjectDetector::enqueue(const cv::Mat &frame) {
-    if (!request) {
-        request = net_.CreateInferRequestPtr();
-    }
-
-    width_ = static_cast<float>(frame.cols);
-    height_ = static_cast<float>(frame.rows);
-
-    Blob::Ptr inputBlob = request->GetBlob(input_name_);
-
-    matU8ToBlob<uint8_t>(frame, inputBlob);
-
-    if (!im_info_name_.empty()) {
-        LockedMemory<void> imInfoMapped = as<MemoryBlob>(request->GetBlob(im_info_name_))->wmap();
-        float* buffer = imInfoMapped.as<float*>();
-        buffer[0] = static_cast<float>(inputBlob->getTensorDesc().getDims()[2]);
-        buffer[1] = static_cast<float>(inputBlob->getTensorDesc().getDims()[3]);
-        buffer[2] = buffer[4] = static_cast<float>(inputBlob->getTensorDesc().getDims()[3]) / width_;
-        buffer[3] = buffer[5] = static_cast<float>(inputBlob->getTensorDesc().getDims()[2]) / height_;
-    }
-
-    enqueued_frames_ = 1;
-}
-
-void ObjectDetector::submitFrame(const cv::Mat &frame, int frame_idx) {
-    frame_idx_ = frame_idx;
-    enqueue(frame);
-    submitRequest();
+bool ObjectDetector::submitFrame(const cv::Mat &frame, int frame_idx) {
+    static SharedPool<FrameMetaData> metaDataPool;
+    return pipeline_->submitData(ImageInputData(frame), metaDataPool.make(frame, frame_idx)) >= 0;
 }
 
-ObjectDetector::ObjectDetector(
-    const DetectorConfig& config,
-    const InferenceEngine::Core & ie,
-    const std::string & deviceName) :
-    config_(config),
-    ie_(ie),
-    deviceName_(deviceName) {
-    auto cnnNetwork = ie_.ReadNetwork(config.path_to_model);
-
-    InputsDataMap inputInfo(cnnNetwork.getInputsInfo());
-    if (1 == inputInfo.size() || 2 == inputInfo.size()) {
-        for (const std::pair<std::string, InputInfo::Ptr>& input : inputInfo) {
-            InputInfo::Ptr inputInfo = input.second;
-            if (4 == inputInfo->getTensorDesc().getDims().size()) {
-                inputInfo->setPrecision(Precision::U8);
-                inputInfo->getInputData()->setLayout(Layout::NCHW);
-                input_name_ = input.first;
-            } else if (SizeVector{1, 6} == inputInfo->getTensorDesc().getDims()) {
-                inputInfo->setPrecision(Precision::FP32);
-                im_info_name_ = input.first;
-            } else {
-                THROW_IE_EXCEPTION << "Unknown input for Person Detection network";
-            }
-        }
-        if (input_name_.empty()) {
-            THROW_IE_EXCEPTION << "No image input for Person Detection network found";
-        }
-    } else {
-        THROW_IE_EXCEPTION << "Person Detection network should have one or two inputs";
-    }
-    InputInfo::Ptr inputInfoFirst = inputInfo.begin()->second;
-    inputInfoFirst->setPrecision(Precision::U8);
-    inputInfoFirst->getInputData()->setLayout(Layout::NCHW);
-
-    OutputsDataMap outputInfo(cnnNetwork.getOutputsInfo());
-    if (outputInfo.size() != 1) {
-        THROW_IE_EXCEPTION << "Person Detection network should have only one output";
-    }
-    DataPtr& _output = outputInfo.begin()->second;
-    output_name_ = outputInfo.begin()->first;
-
-    const SizeVector outputDims = _output->getTensorDesc().getDims();
-    if (outputDims.size() != 4) {
-        THROW_IE_EXCEPTION << "Person Detection network output dimensions not compatible shoulld be 4, but was " +
-            std::to_string(outputDims.size());
-    }
-    max_detections_count_ = outputDims[2];
-    object_size_ = outputDims[3];
-    if (object_size_ != 7) {
-        THROW_IE_EXCEPTION << "Person Detection network output layer should have 7 as a last dimension";
-    }
-    _output->setPrecision(Precision::FP32);
-    _output->setLayout(TensorDesc::getLayoutByDims(_output->getDims()));
-
-    net_ = ie_.LoadNetwork(cnnNetwork, deviceName_);
+void ObjectDetector::waitForData() {
+    pipeline_->waitForData();
 }
 
-void ObjectDetector::wait() {
-    if (!request || !config_.is_async) return;
-    request->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY);
+void ObjectDetector::waitForTotalCompletion() {
+    pipeline_->waitForTotalCompletion();
+    pipeline_->rethrowCallbackException();
 }
 
-void ObjectDetector::fetchResults() {
-    results_.clear();
-    if (results_fetched_) return;
-    results_fetched_ = true;
-    LockedMemory<const void> outputMapped = as<MemoryBlob>(request->GetBlob(output_name_))->rmap();
-    const float *data = outputMapped.as<float *>();
-
-    for (int det_id = 0; det_id < max_detections_count_; ++det_id) {
-        const int start_pos = det_id * object_size_;
-
-        const float batchID = data[start_pos];
-        if (batchID == SSD_EMPTY_DETECTIONS_INDICATOR) {
-            break;
-        }
-
-        const float score = std::min(std::max(0.0f, data[start_pos + 2]), 1.0f);
-        const float x0 =
-            std::min(std::max(0.0f, data[start_pos + 3]), 1.0f) * width_;
-        const float y0 =
-            std::min(std::max(0.0f, data[start_pos + 4]), 1.0f) * height_;
-        const float x1 =
-            std::min(std::max(0.0f, data[start_pos + 5]), 1.0f) * width_;
-        const float y1 =
-            std::min(std::max(0.0f, data[start_pos + 6]), 1.0f) * height_;
+bool ObjectDetector::getResults(DetectedFrame *detected) {
+    std::unique_ptr<ResultBase> result = pipeline_->getResult();
+    if (!result) {
+        return false;
+    }
 
+    const auto &meta = result->metaData->asRef<FrameMetaData>();
+    detected->frame = meta.img;
+    detected->frame_idx = meta.frame_idx;
+    detected->detections.clear();
+
+    const float width = static_cast<float>(meta.img.cols);
+    const float height = static_cast<float>(meta.img.rows);
+    // Labels aren't used by the tracker, so only boxes and confidences are read
+    const auto &detections = result->asRef<DetectionArraysResult>();
+    for (size_t i = 0; i < detections.size(); i++) {
+        const cv::Rect2f &box = detections.boxes[i];
         TrackedObject object;
-        object.confidence = score;
-        object.rect = cv::Rect(cv::Point(static_cast<int>(round(static_cast<double>(x0))),
-                                         static_cast<int>(round(static_cast<double>(y0)))),
-                               cv::Point(static_cast<int>(round(static_cast<double>(x1))),
-                                         static_cast<int>(round(static_cast<double>(y1)))));
+        object.confidence = std::min(detections.confidences[i], 1.0f);
+        object.rect = cv::Rect(cv::Point(RoundCoordinate(box.x, width),
+                                         RoundCoordinate(box.y, height)),
+                               cv::Point(RoundCoordinate(box.x + box.width, width),
+                                         RoundCoordinate(box.y + box.height, height)));
 
         object.rect = TruncateToValidRect(IncreaseRect(object.rect,
                                                        config_.increase_scale_x,
                                                        config_.increase_scale_y),
-                                          cv::Size(static_cast<int>(width_), static_cast<int>(height_)));
-        object.frame_idx = frame_idx_;
+                                          meta.img.size());
+        object.frame_idx = meta.frame_idx;
 
-        if (object.confidence > config_.confidence_threshold && object.rect.area() > 0) {
-            results_.emplace_back(object);
+        if (object.rect.area() > 0) {
+            detected->detections.emplace_back(object);
         }
     }
-}
-
-void ObjectDetector::waitAndFetchResults() {
-    wait();
-    fetchResults();
+    pipeline_->releaseResult(std::move(result));
+    return true;
 }
 
 void ObjectDetector::PrintPerformanceCounts(std::string fullDeviceName) {
-    std::cout << "Performance counts for object detector" << std::endl << std::endl;
-    ::printPerformanceCounts(*request, std::cout, fullDeviceName, false);
+    std::cout << "Performance counts for object detector on " << fullDeviceName << std::endl << std::endl;
+    profiler_.printTopLayers(std::cout, 10);
 }
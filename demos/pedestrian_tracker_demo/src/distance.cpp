@@ -5,8 +5,69 @@
 #include "distance.hpp"
 #include "logging.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
+namespace {
+
+///
+/// \brief Puts the descriptors of the same size and type into the rows of a
+/// CV_32F matrix.
+///
+cv::Mat PackDescriptors(const std::vector<cv::Mat> &descrs) {
+    PT_CHECK(!descrs.empty());
+    const cv::Mat &first = descrs.front();
+    PT_CHECK(!first.empty());
+    cv::Mat packed(static_cast<int>(descrs.size()),
+                   static_cast<int>(first.total() * first.channels()), CV_32F);
+    for (size_t i = 0; i < descrs.size(); i++) {
+        PT_CHECK_EQ(descrs[i].size(), first.size());
+        PT_CHECK_EQ(descrs[i].type(), first.type());
+        cv::Mat descr = descrs[i].isContinuous() ? descrs[i] : descrs[i].clone();
+        descr.reshape(1, 1).convertTo(packed.row(static_cast<int>(i)), CV_32F);
+    }
+    return packed;
+}
+
+///
+/// \brief Computes the dot products of all pairs of the rows and the squared
+/// norms of the rows.
+///
+void ComputeDotProducts(const cv::Mat &packed1, const cv::Mat &packed2,
+                        cv::Mat *products, cv::Mat *sq_norms1, cv::Mat *sq_norms2) {
+    PT_CHECK_EQ(packed1.cols, packed2.cols);
+    cv::gemm(packed1, packed2, 1.0, cv::noArray(), 0.0, *products, cv::GEMM_2_T);
+    cv::reduce(packed1.mul(packed1), *sq_norms1, 1, cv::REDUCE_SUM, CV_64F);
+    cv::reduce(packed2.mul(packed2), *sq_norms2, 1, cv::REDUCE_SUM, CV_64F);
+}
+
+///
+/// \brief Computes the distances between all pairs of the descriptors one by
+/// one. For a final Distance class the calls of Compute() are bound
+/// statically and can be inlined.
+///
+template <typename Distance>
+cv::Mat ComputePairwise(Distance &distance, const std::vector<cv::Mat> &descrs1,
+                        const std::vector<cv::Mat> &descrs2) {
+    cv::Mat distances(static_cast<int>(descrs1.size()),
+                      static_cast<int>(descrs2.size()), CV_32F);
+    for (int i = 0; i < distances.rows; i++) {
+        auto ptr = distances.ptr<float>(i);
+        for (int j = 0; j < distances.cols; j++) {
+            ptr[j] = distance.Compute(descrs1[i], descrs2[j]);
+        }
+    }
+    return distances;
+}
+
+}  // anonymous namespace
+
+cv::Mat IDescriptorDistance::ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                            const std::vector<cv::Mat> &descrs2) {
+    return ComputePairwise(*this, descrs1, descrs2);
+}
+
 CosDistance::CosDistance(const cv::Size &descriptor_size)
     : descriptor_size_(descriptor_size) {
     PT_CHECK(descriptor_size.area() != 0);
@@ -38,6 +99,25 @@ std::vector<float> CosDistance::Compute(const std::vector<cv::Mat> &descrs1,
     return distances;
 }
 
+cv::Mat CosDistance::ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                   const std::vector<cv::Mat> &descrs2) {
+    if (descrs1.empty() || descrs2.empty()) {
+        return ComputePairwise(*this, descrs1, descrs2);
+    }
+    PT_CHECK(descrs1.front().size() == descriptor_size_);
+    PT_CHECK(descrs2.front().size() == descriptor_size_);
+
+    cv::Mat xy, xx, yy;
+    ComputeDotProducts(PackDescriptors(descrs1), PackDescriptors(descrs2), &xy, &xx, &yy);
+    for (int i = 0; i < xy.rows; i++) {
+        auto ptr = xy.ptr<float>(i);
+        for (int j = 0; j < xy.cols; j++) {
+            double norm = sqrt(xx.at<double>(i) * yy.at<double>(j)) + 1e-6;
+            ptr[j] = 0.5f * static_cast<float>(1.0 - ptr[j] / norm);
+        }
+    }
+    return xy;
+}
 
 float MatchTemplateDistance::Compute(const cv::Mat &descr1,
                                      const cv::Mat &descr2) {
@@ -59,3 +139,28 @@ std::vector<float> MatchTemplateDistance::Compute(const std::vector<cv::Mat> &de
     }
     return result;
 }
+
+cv::Mat MatchTemplateDistance::ComputeMatrix(const std::vector<cv::Mat> &descrs1,
+                                             const std::vector<cv::Mat> &descrs2) {
+    if (type_ != cv::TemplateMatchModes::TM_CCORR_NORMED || descrs1.empty() || descrs2.empty()) {
+        return ComputePairwise(*this, descrs1, descrs2);
+    }
+    PT_CHECK_EQ(descrs1.front().size(), descrs2.front().size());
+    PT_CHECK_EQ(descrs1.front().type(), descrs2.front().type());
+
+    // For the images of the same size the normed cross-correlation is the
+    // cosine of the angle between them. Like MatchTemplate, it is clipped to
+    // [-1, 1] and is 0 for the zero images.
+    cv::Mat ccorr, sq_norms1, sq_norms2;
+    ComputeDotProducts(PackDescriptors(descrs1), PackDescriptors(descrs2),
+                       &ccorr, &sq_norms1, &sq_norms2);
+    for (int i = 0; i < ccorr.rows; i++) {
+        auto ptr = ccorr.ptr<float>(i);
+        for (int j = 0; j < ccorr.cols; j++) {
+            double norm = std::sqrt(sq_norms1.at<double>(i) * sq_norms2.at<double>(j));
+            double dist = norm > 0 ? std::max(-1.0, std::min(1.0, ptr[j] / norm)) : 0.0;
+            ptr[j] = scale_ * static_cast<float>(dist) + offset_;
+        }
+    }
+    return ccorr;
+}
@@ -11,18 +11,13 @@
 #include <utility>
 #include <limits>
 #include <algorithm>
+#include <cmath>
 
 #include "core.hpp"
 #include "tracker.hpp"
 #include "utils.hpp"
-#include "kuhn_munkres.hpp"
 
 namespace {
-cv::Point Center(const cv::Rect& rect) {
-    return cv::Point(static_cast<int>(rect.x + rect.width * 0.5),
-                     static_cast<int>(rect.y + rect.height * 0.5));
-}
-
 std::vector<cv::Point> Centers(const TrackedObjects &detections) {
     std::vector<cv::Point> centers(detections.size());
     for (size_t i = 0; i < detections.size(); i++) {
@@ -55,14 +50,6 @@ DetectionLog ConvertTracksToDetectionLog(const ObjectTracks& tracks) {
     return log;
 }
 
-inline bool IsInRange(float val, float min, float max) {
-    return min <= val && val <= max;
-}
-
-inline bool IsInRange(float val, cv::Vec2f range) {
-    return IsInRange(val, range[0], range[1]);
-}
-
 std::vector<cv::Scalar> GenRandomColors(int colors_num) {
     std::vector<cv::Scalar> colors(colors_num);
     for (int i = 0; i < colors_num; i++) {
@@ -73,6 +60,38 @@ std::vector<cv::Scalar> GenRandomColors(int colors_num) {
     return colors;
 }
 
+// Searches the fast descriptor of a track, which is its resized image, in the
+// window around the predicted rectangle. The window is resized with the same
+// scale as the descriptor, so only a few small images are compared.
+cv::Rect MatchDescriptorAround(const cv::Mat &frame, const cv::Mat &descriptor,
+                               const cv::Rect &predicted, float *score) {
+    *score = -1.0f;
+    const cv::Rect window = cv::Rect(predicted.x - predicted.width / 4, predicted.y - predicted.height / 4,
+                                     predicted.width + predicted.width / 2, predicted.height + predicted.height / 2)
+                            & cv::Rect(cv::Point(), frame.size());
+    if (descriptor.empty() || window.width < predicted.width || window.height < predicted.height) {
+        return predicted;
+    }
+
+    const double scale_x = static_cast<double>(descriptor.cols) / predicted.width;
+    const double scale_y = static_cast<double>(descriptor.rows) / predicted.height;
+    cv::Mat resized_window;
+    cv::resize(frame(window), resized_window, cv::Size(), scale_x, scale_y, cv::INTER_LINEAR);
+    if (resized_window.cols < descriptor.cols || resized_window.rows < descriptor.rows) {
+        return predicted;
+    }
+
+    cv::Mat scores;
+    cv::matchTemplate(resized_window, descriptor, scores, cv::TM_CCOEFF_NORMED);
+    double max_score;
+    cv::Point max_loc;
+    cv::minMaxLoc(scores, nullptr, &max_score, nullptr, &max_loc);
+    *score = static_cast<float>(max_score);
+    return cv::Rect(window.x + static_cast<int>(std::round(max_loc.x / scale_x)),
+                    window.y + static_cast<int>(std::round(max_loc.y / scale_y)),
+                    predicted.width, predicted.height);
+}
+
 }  // anonymous namespace
 
 TrackerParams::TrackerParams()
@@ -90,7 +109,8 @@ TrackerParams::TrackerParams()
     strong_affinity_thr(0.2805f),
     reid_thr(0.61f),
     drop_forgotten_tracks(true),
-    max_num_objects_in_track(300) {}
+    max_num_objects_in_track(300),
+    min_propagation_score(0.5f) {}
 
 void ValidateParams(const TrackerParams &p) {
     PT_CHECK_GE(p.min_track_duration, static_cast<size_t>(500));
@@ -133,6 +153,9 @@ void ValidateParams(const TrackerParams &p) {
     PT_CHECK_GE(p.reid_thr, 0.0f);
     PT_CHECK_LE(p.reid_thr, 1.0f);
 
+    PT_CHECK_GE(p.min_propagation_score, -1.0f);
+    PT_CHECK_LE(p.min_propagation_score, 1.0f);
+
 
     if (p.max_num_objects_in_track > 0) {
         int min_required_track_length = static_cast<int>(p.forget_delay);
@@ -143,9 +166,9 @@ void ValidateParams(const TrackerParams &p) {
 
 PedestrianTracker::PedestrianTracker(const TrackerParams &params)
     : params_(params),
+    core_(params.forget_delay, params.max_num_objects_in_track),
     descriptor_strong_(nullptr),
     distance_strong_(nullptr),
-    tracks_counter_(0),
     frame_size_(0, 0),
     prev_timestamp_(std::numeric_limits<uint64_t>::max()) {
         ValidateParams(params);
@@ -189,12 +212,12 @@ void PedestrianTracker::set_distance_strong(const Distance &val) { distance_stro
 // Returns all tracks including forgotten (lost too many frames ago).
 const std::unordered_map<size_t, Track> &
 PedestrianTracker::tracks() const {
-    return tracks_;
+    return core_.tracks();
 }
 
 // Returns indexes of active tracks only.
 const std::set<size_t> &PedestrianTracker::active_track_ids() const {
-    return active_track_ids_;
+    return core_.active_track_ids();
 }
 
 
@@ -203,55 +226,20 @@ DetectionLog PedestrianTracker::GetDetectionLog(const bool valid_only) const {
     return ConvertTracksToDetectionLog(all_tracks(valid_only));
 }
 
-TrackedObjects PedestrianTracker::FilterDetections(
-    const TrackedObjects &detections) const {
-    TrackedObjects filtered_detections;
-    for (const auto &det : detections) {
-        float aspect_ratio = static_cast<float>(det.rect.height) / det.rect.width;
-        if (det.confidence > params_.min_det_conf &&
-            IsInRange(aspect_ratio, params_.bbox_aspect_ratios_range) &&
-            IsInRange(static_cast<float>(det.rect.height), params_.bbox_heights_range)) {
-            filtered_detections.emplace_back(det);
-        }
-    }
-    return filtered_detections;
-}
-
 void PedestrianTracker::SolveAssignmentProblem(
     const std::set<size_t> &track_ids, const TrackedObjects &detections,
     const std::vector<cv::Mat> &descriptors, float thr,
     std::set<size_t> *unmatched_tracks, std::set<size_t> *unmatched_detections,
     std::set<std::tuple<size_t, size_t, float>> *matches) {
-    PT_CHECK(unmatched_tracks);
-    PT_CHECK(unmatched_detections);
-    unmatched_tracks->clear();
-    unmatched_detections->clear();
-
-    PT_CHECK(!track_ids.empty());
     PT_CHECK(!detections.empty());
     PT_CHECK(descriptors.size() == detections.size());
-    PT_CHECK(matches);
-    matches->clear();
 
     cv::Mat dissimilarity;
-    ComputeDissimilarityMatrix(track_ids, detections, descriptors,
+    ComputeDissimilarityMatrix(track_ids, detections, descriptors, thr,
                                &dissimilarity);
 
-    auto res = KuhnMunkres().Solve(dissimilarity);
-
-    for (size_t i = 0; i < detections.size(); i++) {
-        unmatched_detections->insert(i);
-    }
-
-    size_t i = 0;
-    for (auto id : track_ids) {
-        if (res[i] < detections.size()) {
-            matches->emplace(id, res[i], 1 - dissimilarity.at<float>(i, res[i]));
-        } else {
-            unmatched_tracks->insert(id);
-        }
-        i++;
-    }
+    SolveTrackAssignment(track_ids, dissimilarity, thr, unmatched_tracks,
+                         unmatched_detections, matches);
 }
 
 const ObjectTracks PedestrianTracker::all_tracks(bool valid_only) const {
@@ -278,7 +266,7 @@ const ObjectTracks PedestrianTracker::all_tracks(bool valid_only) const {
 
 cv::Rect PedestrianTracker::PredictRect(size_t id, size_t k,
                                         size_t s) const {
-    const auto &track = tracks_.at(id);
+    const auto &track = core_.track(id);
     PT_CHECK(!track.empty());
 
     if (track.size() == 1) {
@@ -320,44 +308,20 @@ cv::Rect PedestrianTracker::PredictRect(size_t id, size_t k,
 
 
 bool PedestrianTracker::EraseTrackIfBBoxIsOutOfFrame(size_t track_id) {
-    if (tracks_.find(track_id) == tracks_.end()) return true;
-    auto c = Center(tracks_.at(track_id).predicted_rect);
-    if (!prev_frame_size_.empty() &&
-        (c.x < 0 || c.y < 0 || c.x > prev_frame_size_.width ||
-         c.y > prev_frame_size_.height)) {
-        tracks_.at(track_id).lost = params_.forget_delay + 1;
-        for (auto id : active_track_ids()) {
-            size_t min_id = std::min(id, track_id);
-            size_t max_id = std::max(id, track_id);
-            tracks_dists_.erase(std::pair<size_t, size_t>(min_id, max_id));
-        }
-        active_track_ids_.erase(track_id);
-        return true;
-    }
-    return false;
+    return core_.ForgetTrackIfBBoxIsOutOfFrame(track_id, prev_frame_size_,
+                                               [](const Track &track) { return track.predicted_rect; });
 }
 
 bool PedestrianTracker::EraseTrackIfItWasLostTooManyFramesAgo(
     size_t track_id) {
-    if (tracks_.find(track_id) == tracks_.end()) return true;
-    if (tracks_.at(track_id).lost > params_.forget_delay) {
-        for (auto id : active_track_ids()) {
-            size_t min_id = std::min(id, track_id);
-            size_t max_id = std::max(id, track_id);
-            tracks_dists_.erase(std::pair<size_t, size_t>(min_id, max_id));
-        }
-        active_track_ids_.erase(track_id);
-
-        return true;
-    }
-    return false;
+    return core_.ForgetTrackIfItWasLostTooManyFramesAgo(track_id);
 }
 
 bool PedestrianTracker::UpdateLostTrackAndEraseIfItsNeeded(
     size_t track_id) {
-    tracks_.at(track_id).lost++;
-    tracks_.at(track_id).predicted_rect =
-        PredictRect(track_id, params().predict, tracks_.at(track_id).lost);
+    core_.track(track_id).lost++;
+    core_.track(track_id).predicted_rect =
+        PredictRect(track_id, params().predict, core_.track(track_id).lost);
 
     bool erased = EraseTrackIfBBoxIsOutOfFrame(track_id);
     if (!erased) erased = EraseTrackIfItWasLostTooManyFramesAgo(track_id);
@@ -383,7 +347,9 @@ void PedestrianTracker::Process(const cv::Mat &frame,
         PT_CHECK_EQ(frame_size_, frame.size());
     }
 
-    TrackedObjects detections = FilterDetections(input_detections);
+    TrackedObjects detections = FilterDetections(input_detections, params_.min_det_conf,
+                                                 params_.bbox_aspect_ratios_range,
+                                                 params_.bbox_heights_range);
     for (auto &obj : detections) {
         obj.timestamp = timestamp;
     }
@@ -391,14 +357,14 @@ void PedestrianTracker::Process(const cv::Mat &frame,
     std::vector<cv::Mat> descriptors_fast;
     ComputeFastDesciptors(frame, detections, &descriptors_fast);
 
-    auto active_tracks = active_track_ids_;
+    auto active_tracks = active_track_ids();
 
     if (!active_tracks.empty() && !detections.empty()) {
         std::set<size_t> unmatched_tracks, unmatched_detections;
         std::set<std::tuple<size_t, size_t, float>> matches;
 
         SolveAssignmentProblem(active_tracks, detections, descriptors_fast,
-                               params_.aff_thr_fast, &unmatched_tracks,
+                               params_.strong_affinity_thr, &unmatched_tracks,
                                &unmatched_detections, &matches);
 
         std::map<size_t, std::pair<bool, cv::Mat>> is_matching_to_track;
@@ -415,8 +381,8 @@ void PedestrianTracker::Process(const cv::Mat &frame,
             size_t det_id = std::get<1>(match);
             float conf = std::get<2>(match);
 
-            auto last_det = tracks_.at(track_id).objects.back();
-            last_det.rect = tracks_.at(track_id).predicted_rect;
+            auto last_det = core_.track(track_id).objects.back();
+            last_det.rect = core_.track(track_id).predicted_rect;
 
             if (conf > params_.aff_thr_fast) {
                 AppendToTrack(frame, track_id, detections[det_id],
@@ -457,51 +423,60 @@ void PedestrianTracker::Process(const cv::Mat &frame,
 
     prev_frame_size_ = frame.size();
     if (params_.drop_forgotten_tracks) DropForgottenTracks();
-
-    tracks_dists_.clear();
     prev_timestamp_ = timestamp;
 }
 
-void PedestrianTracker::DropForgottenTracks() {
-    std::unordered_map<size_t, Track> new_tracks;
-    std::set<size_t> new_active_tracks;
+float PedestrianTracker::Propagate(const cv::Mat &frame, int frame_idx,
+                                   uint64_t timestamp) {
+    if (prev_timestamp_ != std::numeric_limits<uint64_t>::max())
+        PT_CHECK_LT(prev_timestamp_, timestamp);
 
-    size_t max_id = 0;
-    if (!active_track_ids_.empty())
-        max_id =
-            *std::max_element(active_track_ids_.begin(), active_track_ids_.end());
+    if (frame_size_ == cv::Size(0, 0)) {
+        frame_size_ = frame.size();
+    } else {
+        PT_CHECK_EQ(frame_size_, frame.size());
+    }
 
-    const size_t kMaxTrackID = 10000;
-    bool reassign_id = max_id > kMaxTrackID;
+    float min_score = 1.0f;
+    std::set<size_t> lost_tracks;
+    const std::set<size_t> active_tracks = active_track_ids();
+    for (size_t id : active_tracks) {
+        const auto &track = core_.track(id);
+        // The lost tracks keep being predicted until they are detected again
+        if (track.lost) {
+            lost_tracks.insert(id);
+            continue;
+        }
 
-    size_t counter = 0;
-    for (const auto &pair : tracks_) {
-        if (!IsTrackForgotten(pair.first)) {
-            new_tracks.emplace(reassign_id ? counter : pair.first, pair.second);
-            new_active_tracks.emplace(reassign_id ? counter : pair.first);
-            counter++;
+        float score;
+        const cv::Rect rect = MatchDescriptorAround(frame, track.descriptor_fast,
+                                                    PredictRect(id, params_.predict, 0), &score);
+        min_score = std::min(min_score, score);
+        if (score < params_.min_propagation_score) {
+            lost_tracks.insert(id);
+            continue;
         }
-    }
-    tracks_.swap(new_tracks);
-    active_track_ids_.swap(new_active_tracks);
 
-    tracks_counter_ = reassign_id ? counter : tracks_counter_;
-}
+        // The descriptor isn't updated, so the errors of the matching don't accumulate
+        TrackedObject object = track.objects.back();
+        object.rect = rect;
+        object.frame_idx = frame_idx;
+        object.timestamp = timestamp;
+        core_.AppendToTrack(id, object).predicted_rect = rect;
+    }
+    UpdateLostTracks(lost_tracks);
 
-float PedestrianTracker::ShapeAffinity(float weight, const cv::Rect &trk,
-                                       const cv::Rect &det) {
-    float w_dist = static_cast<float>(std::abs(trk.width - det.width) / (trk.width + det.width));
-    float h_dist = static_cast<float>(std::abs(trk.height - det.height) / (trk.height + det.height));
-    return static_cast<float>(exp(static_cast<double>(-weight * (w_dist + h_dist))));
+    prev_frame_size_ = frame.size();
+    for (size_t id : active_tracks) {
+        EraseTrackIfBBoxIsOutOfFrame(id);
+    }
+    if (params_.drop_forgotten_tracks) DropForgottenTracks();
+    prev_timestamp_ = timestamp;
+    return min_score;
 }
 
-float PedestrianTracker::MotionAffinity(float weight, const cv::Rect &trk,
-                                        const cv::Rect &det) {
-    float x_dist = static_cast<float>(trk.x - det.x) * (trk.x - det.x) /
-        (det.width * det.width);
-    float y_dist = static_cast<float>(trk.y - det.y) * (trk.y - det.y) /
-        (det.height * det.height);
-    return static_cast<float>(exp(static_cast<double>(-weight * (x_dist + y_dist))));
+void PedestrianTracker::DropForgottenTracks() {
+    core_.DropForgottenTracks();
 }
 
 float PedestrianTracker::TimeAffinity(float weight, const float &trk_time,
@@ -512,28 +487,74 @@ float PedestrianTracker::TimeAffinity(float weight, const float &trk_time,
 void PedestrianTracker::ComputeFastDesciptors(
     const cv::Mat &frame, const TrackedObjects &detections,
     std::vector<cv::Mat> *descriptors) {
-    *descriptors = std::vector<cv::Mat>(detections.size(), cv::Mat());
-    for (size_t i = 0; i < detections.size(); i++) {
-        descriptor_fast_->Compute(frame(detections[i].rect).clone(),
-                                  &((*descriptors)[i]));
+    std::vector<cv::Mat> crops;
+    crops.reserve(detections.size());
+    for (const auto &detection : detections) {
+        crops.push_back(frame(detection.rect));
     }
+    descriptor_fast_->Compute(crops, descriptors);
 }
 
 void PedestrianTracker::ComputeDissimilarityMatrix(
     const std::set<size_t> &active_tracks, const TrackedObjects &detections,
-    const std::vector<cv::Mat> &descriptors_fast,
+    const std::vector<cv::Mat> &descriptors_fast, float thr,
     cv::Mat *dissimilarity_matrix) {
-    cv::Mat am(active_tracks.size(), detections.size(), CV_32F, cv::Scalar(0));
-    size_t i = 0;
+    std::vector<cv::Mat> track_descriptors;
+    std::vector<TrackedObject> track_objects;
+    track_descriptors.reserve(active_tracks.size());
+    track_objects.reserve(active_tracks.size());
     for (auto id : active_tracks) {
+        const auto &track = core_.track(id);
+        track_descriptors.push_back(track.descriptor_fast);
+        track_objects.push_back(track.objects.back());
+        track_objects.back().rect = track.predicted_rect;
+    }
+
+    // The appearance affinity is not greater than 1, so the pairs with the
+    // shape, motion and time affinity not greater than thr are rejected
+    // without comparing their descriptors. The descriptors are compared only
+    // for the tracks and the detections that have a candidate pair.
+    cv::Mat am(active_tracks.size(), detections.size(), CV_32F, cv::Scalar(0));
+    std::vector<int> track_candidates, det_candidates;
+    std::vector<int> det_candidate_idx(detections.size(), -1);
+    for (size_t i = 0; i < track_objects.size(); i++) {
         auto ptr = am.ptr<float>(i);
-        for (size_t j = 0; j < descriptors_fast.size(); j++) {
-            auto last_det = tracks_.at(id).objects.back();
-            last_det.rect = tracks_.at(id).predicted_rect;
-            ptr[j] = AffinityFast(tracks_.at(id).descriptor_fast, last_det,
-                                  descriptors_fast[j], detections[j]);
+        bool has_candidates = false;
+        for (size_t j = 0; j < detections.size(); j++) {
+            float aff = Affinity(track_objects[i], detections[j]);
+            if (aff > thr) {
+                ptr[j] = aff;
+                has_candidates = true;
+                if (det_candidate_idx[j] < 0) {
+                    det_candidate_idx[j] = static_cast<int>(det_candidates.size());
+                    det_candidates.push_back(static_cast<int>(j));
+                }
+            }
+        }
+        if (has_candidates) {
+            track_candidates.push_back(static_cast<int>(i));
+        }
+    }
+
+    if (!track_candidates.empty()) {
+        std::vector<cv::Mat> candidate_track_descriptors, candidate_det_descriptors;
+        for (int i : track_candidates) {
+            candidate_track_descriptors.push_back(track_descriptors[i]);
+        }
+        for (int j : det_candidates) {
+            candidate_det_descriptors.push_back(descriptors_fast[j]);
+        }
+        cv::Mat app_dist = distance_fast_->ComputeMatrix(candidate_track_descriptors,
+                                                         candidate_det_descriptors);
+        for (size_t k = 0; k < track_candidates.size(); k++) {
+            auto ptr = am.ptr<float>(track_candidates[k]);
+            auto app_dist_ptr = app_dist.ptr<float>(static_cast<int>(k));
+            for (size_t j = 0; j < detections.size(); j++) {
+                if (ptr[j] > 0) {
+                    ptr[j] *= 1.0f - app_dist_ptr[det_candidate_idx[j]];
+                }
+            }
         }
-        i++;
     }
     *dissimilarity_matrix = 1.0 - am;
 }
@@ -552,8 +573,8 @@ std::vector<float> PedestrianTracker::ComputeDistances(
         size_t track_id = track_and_det_ids[i].first;
         size_t det_id = track_and_det_ids[i].second;
 
-        if (tracks_.at(track_id).descriptor_strong.empty()) {
-            images.push_back(tracks_.at(track_id).last_image);
+        if (core_.track(track_id).descriptor_strong.empty()) {
+            images.push_back(core_.track(track_id).last_image);
             descriptors.push_back(cv::Mat());
             track_to_batch_ids[track_id] = descriptors.size() - 1;
         }
@@ -571,14 +592,14 @@ std::vector<float> PedestrianTracker::ComputeDistances(
         size_t track_id = track_and_det_ids[i].first;
         size_t det_id = track_and_det_ids[i].second;
 
-        if (tracks_.at(track_id).descriptor_strong.empty()) {
-            tracks_.at(track_id).descriptor_strong =
+        if (core_.track(track_id).descriptor_strong.empty()) {
+            core_.track(track_id).descriptor_strong =
                 descriptors[track_to_batch_ids[track_id]].clone();
         }
         (*det_id_to_descriptor)[det_id] = descriptors[det_to_batch_ids[det_id]];
 
         descriptors1.push_back(descriptors[det_to_batch_ids[det_id]]);
-        descriptors2.push_back(tracks_.at(track_id).descriptor_strong);
+        descriptors2.push_back(core_.track(track_id).descriptor_strong);
     }
 
     std::vector<float> distances =
@@ -625,7 +646,7 @@ PedestrianTracker::StrongMatching(
         size_t track_id = track_and_det_ids[i].first;
         size_t det_id = track_and_det_ids[i].second;
 
-        const auto& track = tracks_.at(track_id);
+        const auto& track = core_.track(track_id);
         const auto& detection = detections[det_id];
 
         auto last_det = track.objects.back();
@@ -665,20 +686,12 @@ void PedestrianTracker::AddNewTrack(const cv::Mat &frame,
                                     const TrackedObject &detection,
                                     const cv::Mat &descriptor_fast,
                                     const cv::Mat &descriptor_strong) {
-    auto detection_with_id = detection;
-    detection_with_id.object_id = tracks_counter_;
-    tracks_.emplace(std::pair<size_t, Track>(
-            tracks_counter_,
-            Track({detection_with_id}, frame(detection.rect).clone(),
-                  descriptor_fast.clone(), descriptor_strong.clone())));
-
-    for (size_t id : active_track_ids_) {
-        tracks_dists_.emplace(std::pair<size_t, size_t>(id, tracks_counter_),
-                              std::numeric_limits<float>::max());
+    // The image is needed only to compute the strong descriptor later
+    cv::Mat last_image;
+    if (descriptor_strong_ && descriptor_strong.empty()) {
+        last_image = frame(detection.rect).clone();
     }
-
-    active_track_ids_.insert(tracks_counter_);
-    tracks_counter_++;
+    core_.AddTrack(detection, last_image, descriptor_fast.clone(), descriptor_strong.clone());
 }
 
 void PedestrianTracker::AppendToTrack(const cv::Mat &frame,
@@ -686,18 +699,9 @@ void PedestrianTracker::AppendToTrack(const cv::Mat &frame,
                                       const TrackedObject &detection,
                                       const cv::Mat &descriptor_fast,
                                       const cv::Mat &descriptor_strong) {
-    PT_CHECK(!IsTrackForgotten(track_id));
-
-    auto detection_with_id = detection;
-    detection_with_id.object_id = track_id;
-
-    auto &cur_track = tracks_.at(track_id);
-    cur_track.objects.emplace_back(detection_with_id);
+    auto &cur_track = core_.AppendToTrack(track_id, detection);
     cur_track.predicted_rect = detection.rect;
-    cur_track.lost = 0;
-    cur_track.last_image = frame(detection.rect).clone();
     cur_track.descriptor_fast = descriptor_fast.clone();
-    cur_track.length++;
 
     if (cur_track.descriptor_strong.empty()) {
         cur_track.descriptor_strong = descriptor_strong.clone();
@@ -706,36 +710,13 @@ void PedestrianTracker::AppendToTrack(const cv::Mat &frame,
             0.5 * (descriptor_strong + cur_track.descriptor_strong);
     }
 
-
-    if (params_.max_num_objects_in_track > 0) {
-        while (cur_track.size() >
-               static_cast<size_t>(params_.max_num_objects_in_track)) {
-            cur_track.objects.erase(cur_track.objects.begin());
-        }
+    if (descriptor_strong_ && cur_track.descriptor_strong.empty()) {
+        frame(detection.rect).copyTo(cur_track.last_image);
+    } else {
+        cur_track.last_image.release();
     }
 }
 
-float PedestrianTracker::AffinityFast(const cv::Mat &descriptor1,
-                                      const TrackedObject &obj1,
-                                      const cv::Mat &descriptor2,
-                                      const TrackedObject &obj2) {
-    const float eps = 1e-6f;
-    float shp_aff = ShapeAffinity(params_.shape_affinity_w, obj1.rect, obj2.rect);
-    if (shp_aff < eps) return 0.0f;
-
-    float mot_aff =
-        MotionAffinity(params_.motion_affinity_w, obj1.rect, obj2.rect);
-    if (mot_aff < eps) return 0.0f;
-    float time_aff =
-        TimeAffinity(params_.time_affinity_w, static_cast<float>(obj1.frame_idx), static_cast<float>(obj2.frame_idx));
-
-    if (time_aff < eps) return 0.0f;
-
-    float app_aff = 1.0f - distance_fast_->Compute(descriptor1, descriptor2);
-
-    return shp_aff * mot_aff * app_aff * time_aff;
-}
-
 float PedestrianTracker::Affinity(const TrackedObject &obj1,
                                   const TrackedObject &obj2) {
     float shp_aff = ShapeAffinity(params_.shape_affinity_w, obj1.rect, obj2.rect);
@@ -747,7 +728,7 @@ float PedestrianTracker::Affinity(const TrackedObject &obj1,
 }
 
 bool PedestrianTracker::IsTrackValid(size_t id) const {
-    const auto& track = tracks_.at(id);
+    const auto& track = core_.track(id);
     const auto &objects = track.objects;
     if (objects.empty()) {
         return false;
@@ -759,18 +740,14 @@ bool PedestrianTracker::IsTrackValid(size_t id) const {
 }
 
 bool PedestrianTracker::IsTrackForgotten(size_t id) const {
-    return IsTrackForgotten(tracks_.at(id));
-}
-
-bool PedestrianTracker::IsTrackForgotten(const Track &track) const {
-    return (track.lost > params_.forget_delay);
+    return core_.IsTrackForgotten(id);
 }
 
 std::unordered_map<size_t, std::vector<cv::Point>>
 PedestrianTracker::GetActiveTracks() const {
     std::unordered_map<size_t, std::vector<cv::Point>> active_tracks;
     for (size_t idx : active_track_ids()) {
-        auto track = tracks().at(idx);
+        const auto &track = tracks().at(idx);
         if (IsTrackValid(idx) && !IsTrackForgotten(idx)) {
             active_tracks.emplace(idx, Centers(track.objects));
         }
@@ -781,7 +758,7 @@ PedestrianTracker::GetActiveTracks() const {
 TrackedObjects PedestrianTracker::TrackedDetections() const {
     TrackedObjects detections;
     for (size_t idx : active_track_ids()) {
-        auto track = tracks().at(idx);
+        const auto &track = tracks().at(idx);
         if (IsTrackValid(idx) && !track.lost) {
             detections.emplace_back(track.objects.back());
         }
@@ -806,7 +783,7 @@ cv::Mat PedestrianTracker::DrawActiveTracks(const cv::Mat &frame) {
         ss << idx;
         cv::putText(out_frame, ss.str(), centers.back(), cv::FONT_HERSHEY_SCRIPT_COMPLEX, 2.0,
                     colors_[idx % colors_.size()], 3);
-        auto track = tracks().at(idx);
+        const auto &track = tracks().at(idx);
         if (track.lost) {
             cv::line(out_frame, active_track.second.back(),
                      Center(track.predicted_rect), cv::Scalar(0, 0, 0), 4);
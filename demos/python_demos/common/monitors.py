@@ -15,7 +15,7 @@
 """
 
 try:
-    from monitors_extension import Presenter
+    from monitors_extension import Presenter, SystemSampler
 except ImportError:
     import logging
 
@@ -33,3 +33,9 @@ except ImportError:
         def drawGraphs(self, frame): pass
 
         def reportMeans(self): return ''
+
+
+    class SystemSampler:
+        def __init__(self, periodMs=1000): pass
+
+        def getSnapshot(self): return None
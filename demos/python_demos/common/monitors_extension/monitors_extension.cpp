@@ -5,20 +5,31 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
-#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
-#include "numpy/arrayobject.h"
-
+#include <chrono>
+#include <cstring>
 #include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <monitors/presenter.h>
+#include <monitors/system_sampler.h>
 
+// The methods release the GIL while they work, so the mutex keeps calls from several Python threads apart
 struct PresenterObject {
     PyObject_HEAD
     Presenter *_presenter;
+    std::mutex *_mutex;
+};
+
+struct SystemSamplerObject {
+    PyObject_HEAD
+    SystemSampler *_sampler;
 };
 
 namespace {
 void presenter_dealloc(PresenterObject *self) {
     delete self->_presenter;
+    delete self->_mutex;
     PyTypeObject *tp = Py_TYPE(self);
     tp->tp_free(self);
     Py_DECREF(tp);
@@ -35,6 +46,9 @@ int presenter_init(PresenterObject *self, PyObject *args, PyObject *kwds) {
     if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|i(ii)K", kwlist, &keys, &yPos, &graphSizeWidth, &graphSizeHeight,
         &historySize)) return -1;
     try {
+        delete self->_presenter;
+        self->_presenter = nullptr;
+        if (!self->_mutex) self->_mutex = new std::mutex;
         self->_presenter = new Presenter(keys, yPos, {graphSizeWidth, graphSizeHeight}, historySize);
         return 0;
     } catch (std::exception &exception) {
@@ -52,13 +66,20 @@ PyObject *presenter_handleKey(PresenterObject *self, PyObject *args, PyObject *k
     static char *kwlist[] = {keyName, nullptr};
     int key;
     if (!PyArg_ParseTupleAndKeywords(args, kwds, "i", kwlist, &key)) return nullptr;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
     try {
+        std::lock_guard<std::mutex> lock(*self->_mutex);
         self->_presenter->handleKey(key);
-        Py_RETURN_NONE;
     } catch (std::exception &exception) {
-        PyErr_SetString(PyExc_RuntimeError, exception.what());
+        error = exception.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
         return nullptr;
     }
+    Py_RETURN_NONE;
 }
 
 PyObject *presenter_drawGraphs(PresenterObject *self, PyObject *args, PyObject *kwds) {
@@ -68,26 +89,35 @@ PyObject *presenter_drawGraphs(PresenterObject *self, PyObject *args, PyObject *
     }
     static char frameName[] = "frame";
     static char *kwlist[] = {frameName, nullptr};
-    PyArrayObject *npFrame;
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &npFrame)) return nullptr;
-    if (PyArray_Check(npFrame)
-            && PyArray_TYPE(npFrame) != NPY_UINT8
-            && PyArray_NDIM(npFrame) != 3
-            && PyArray_SHAPE(npFrame)[2] != 3) {
-        PyErr_SetString(PyExc_TypeError, "frame must be an array of type uint8 with 3 dimensions with 3 elements in the"
-            " last dimension");
+    PyObject *frameObject;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &frameObject)) return nullptr;
+    // The graphs are drawn in place, in the memory of the array, which is locked by the buffer while they are drawn
+    Py_buffer view;
+    if (PyObject_GetBuffer(frameObject, &view, PyBUF_RECORDS) < 0) return nullptr;
+    if (view.ndim != 3 || view.itemsize != 1 || (view.format && std::strcmp(view.format, "B") != 0)
+            || view.shape[2] != 3 || view.strides[2] != 1 || view.strides[1] != 3) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_TypeError, "frame must be a writable array of type uint8 with 3 dimensions with 3"
+            " contiguous elements in the last dimension");
         return nullptr;
     }
-    int height = static_cast<int>(PyArray_SHAPE(npFrame)[0]);
-    int width = static_cast<int>(PyArray_SHAPE(npFrame)[1]);
+    cv::Mat frame(static_cast<int>(view.shape[0]), static_cast<int>(view.shape[1]), CV_8UC3, view.buf,
+        static_cast<size_t>(view.strides[0]));
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
     try {
-        cv::Mat frame(height, width, CV_8UC3, PyArray_DATA(npFrame), PyArray_STRIDE(npFrame, 0));
+        std::lock_guard<std::mutex> lock(*self->_mutex);
         self->_presenter->drawGraphs(frame);
-        Py_RETURN_NONE;
     } catch (std::exception &exception) {
-        PyErr_SetString(PyExc_RuntimeError, exception.what());
+        error = exception.what();
+    }
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
         return nullptr;
     }
+    Py_RETURN_NONE;
 }
 
 PyObject *presenter_reportMeans(PresenterObject *self, PyObject *Py_UNUSED(ignored)) {
@@ -96,6 +126,7 @@ PyObject *presenter_reportMeans(PresenterObject *self, PyObject *Py_UNUSED(ignor
         return nullptr;
     }
     try {
+        std::lock_guard<std::mutex> lock(*self->_mutex);
         return PyUnicode_FromFormat(self->_presenter->reportMeans().c_str());
     } catch (std::exception &exception) {
         PyErr_SetString(PyExc_RuntimeError, exception.what());
@@ -154,24 +185,90 @@ PyType_Slot presenterSlots[] = {
 
 PyType_Spec presenterSpec{"monitors_extension.Presenter", sizeof(PresenterObject), 0, 0, presenterSlots};
 
-PyModuleDef monitors_extension{PyModuleDef_HEAD_INIT, "monitors_extension", monitors_extension_doc, 0};
+void systemSampler_dealloc(SystemSamplerObject *self) {
+    delete self->_sampler;
+    PyTypeObject *tp = Py_TYPE(self);
+    tp->tp_free(self);
+    Py_DECREF(tp);
 }
 
-PyMODINIT_FUNC PyInit_monitors_extension() {
-    import_array();
-    if (PyErr_Occurred()) return nullptr;
-
-    PyObject *presenterType = PyType_FromSpec(&presenterSpec);
-    if (!presenterType) return nullptr;
+int systemSampler_init(SystemSamplerObject *self, PyObject *args, PyObject *kwds) {
+    static char periodName[] = "periodMs";
+    static char *kwlist[] = {periodName, nullptr};
+    unsigned long long periodMs = 1000;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|K", kwlist, &periodMs)) return -1;
+    try {
+        delete self->_sampler;
+        self->_sampler = nullptr;
+        self->_sampler = new SystemSampler(std::chrono::milliseconds(periodMs));
+        return 0;
+    } catch (std::exception &exception) {
+        PyErr_SetString(PyExc_RuntimeError, exception.what());
+        return -1;
+    }
+}
 
-    PyObject *m = PyModule_Create(&monitors_extension);
-    if (m == nullptr) {
-        Py_DECREF(presenterType);
+PyObject *systemSampler_getSnapshot(SystemSamplerObject *self, PyObject *Py_UNUSED(ignored)) {
+    if (!self->_sampler) {
+        PyErr_SetString(PyExc_AssertionError, "Underlying C++ sampler is nullptr");
+        return nullptr;
+    }
+    std::shared_ptr<const SystemSnapshot> snapshot;
+    try {
+        snapshot = self->_sampler->getSnapshot();
+    } catch (std::exception &exception) {
+        PyErr_SetString(PyExc_RuntimeError, exception.what());
         return nullptr;
     }
+    if (!snapshot) Py_RETURN_NONE;
+    PyObject *coresLoad = PyList_New(static_cast<Py_ssize_t>(snapshot->coresLoad.size()));
+    if (!coresLoad) return nullptr;
+    for (size_t i = 0; i < snapshot->coresLoad.size(); ++i) {
+        PyList_SET_ITEM(coresLoad, static_cast<Py_ssize_t>(i), PyFloat_FromDouble(snapshot->coresLoad[i]));
+    }
+    double timeStamp = std::chrono::duration<double>(snapshot->timeStamp.time_since_epoch()).count();
+    return Py_BuildValue("{s:d,s:N,s:d,s:d,s:d,s:d}", "timeStamp", timeStamp, "coresLoad", coresLoad,
+        "memTotal", snapshot->memTotal, "usedMem", snapshot->usedMem, "usedSwap", snapshot->usedSwap,
+        "processRss", snapshot->processRss);
+}
+
+PyMethodDef systemSampler_methods[] = {
+        {"getSnapshot", reinterpret_cast<PyCFunction>(systemSampler_getSnapshot), METH_NOARGS},
+        {}};  // Sentinel
+
+char systemSampler_doc[] = "Samples CPU load and memory usage in a background C++ thread, which doesn't take the "
+    "GIL. getSnapshot() returns the latest sample as a dict (time stamp in seconds of a monotonic clock, load of "
+    "every core in [0, 1], memory in GiB) without waiting, or None until the first sample is taken.";
+
+PyType_Slot systemSamplerSlots[] = {
+    {Py_tp_dealloc, reinterpret_cast<void*>(systemSampler_dealloc)},
+    {Py_tp_doc, systemSampler_doc},
+    {Py_tp_methods, systemSampler_methods},
+    {Py_tp_init, reinterpret_cast<void*>(systemSampler_init)},
+    {Py_tp_new, reinterpret_cast<void*>(PyType_GenericNew)},
+    {}};  // Sentinel
+
+PyType_Spec systemSamplerSpec{"monitors_extension.SystemSampler", sizeof(SystemSamplerObject), 0, 0,
+    systemSamplerSlots};
+
+PyModuleDef monitors_extension{PyModuleDef_HEAD_INIT, "monitors_extension", monitors_extension_doc, 0};
+
+int addType(PyObject *m, const char *name, PyType_Spec *spec) {
+    PyObject *type = PyType_FromSpec(spec);
+    if (!type) return -1;
+    if (PyModule_AddObject(m, name, type) < 0) {
+        Py_DECREF(type);
+        return -1;
+    }
+    return 0;
+}
+}
+
+PyMODINIT_FUNC PyInit_monitors_extension() {
+    PyObject *m = PyModule_Create(&monitors_extension);
+    if (m == nullptr) return nullptr;
 
-    if (PyModule_AddObject(m, "Presenter", presenterType) < 0) {
-        Py_DECREF(presenterType);
+    if (addType(m, "Presenter", &presenterSpec) < 0 || addType(m, "SystemSampler", &systemSamplerSpec) < 0) {
         Py_DECREF(m);
         return nullptr;
     }
@@ -9,23 +9,27 @@
 
 namespace human_pose_estimation {
 static void resizeFeatureMaps(std::vector<cv::Mat>& featureMaps, int upsampleRatio) {
-    for (auto& featureMap : featureMaps) {
-        cv::resize(featureMap, featureMap, cv::Size(),
-                   upsampleRatio, upsampleRatio, cv::INTER_CUBIC);
-    }
+    // The maps are small, so resizing different maps in parallel scales better than parallel resize of every map
+    cv::parallel_for_(cv::Range(0, static_cast<int>(featureMaps.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            cv::resize(featureMaps[i], featureMaps[i], cv::Size(),
+                       upsampleRatio, upsampleRatio, cv::INTER_CUBIC);
+        }
+    });
 }
 
 class FindPeaksBody: public cv::ParallelLoopBody {
 public:
     FindPeaksBody(const std::vector<cv::Mat>& heatMaps, float minPeaksDistance,
-                  std::vector<std::vector<Peak> >& peaksFromHeatMap)
+                  std::vector<std::vector<Peak> >& peaksFromHeatMap, int featureMapsScale)
         : heatMaps(heatMaps),
           minPeaksDistance(minPeaksDistance),
-          peaksFromHeatMap(peaksFromHeatMap) {}
+          peaksFromHeatMap(peaksFromHeatMap),
+          featureMapsScale(featureMapsScale) {}
 
     virtual void operator()(const cv::Range& range) const {
         for (int i = range.start; i < range.end; i++) {
-            findPeaks(heatMaps, minPeaksDistance, peaksFromHeatMap, i);
+            findPeaks(heatMaps, minPeaksDistance, peaksFromHeatMap, i, featureMapsScale);
         }
     }
 
@@ -33,17 +37,22 @@ private:
     const std::vector<cv::Mat>& heatMaps;
     float minPeaksDistance;
     std::vector<std::vector<Peak> >& peaksFromHeatMap;
+    int featureMapsScale;
 };
 
 std::vector<HumanPose> extractPoses(
         std::vector<cv::Mat>& heatMaps,
         std::vector<cv::Mat>& pafs,
-        int upsampleRatio) {
-    resizeFeatureMaps(heatMaps, upsampleRatio);
-    resizeFeatureMaps(pafs, upsampleRatio);
+        int upsampleRatio,
+        bool sparse) {
+    if (!sparse) {
+        resizeFeatureMaps(heatMaps, upsampleRatio);
+        resizeFeatureMaps(pafs, upsampleRatio);
+    }
+    const int featureMapsScale = sparse ? upsampleRatio : 1;
     std::vector<std::vector<Peak> > peaksFromHeatMap(heatMaps.size());
     float minPeaksDistance = 3.0f;
-    FindPeaksBody findPeaksBody(heatMaps, minPeaksDistance, peaksFromHeatMap);
+    FindPeaksBody findPeaksBody(heatMaps, minPeaksDistance, peaksFromHeatMap, featureMapsScale);
     cv::parallel_for_(cv::Range(0, static_cast<int>(heatMaps.size())),
                       findPeaksBody);
     int peaksBefore = 0;
@@ -60,7 +69,7 @@ std::vector<HumanPose> extractPoses(
     float minSubsetScore = 0.2f;
     std::vector<HumanPose> poses = groupPeaksToPoses(
                 peaksFromHeatMap, pafs, keypointsNumber, midPointsScoreThreshold,
-                foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore);
+                foundMidPointsRatioThreshold, minJointsNumber, minSubsetScore, featureMapsScale);
     return poses;
 }
 } // namespace human_pose_estimation
@@ -9,8 +9,11 @@
 #include "human_pose.hpp"
 
 namespace human_pose_estimation {
+// The keypoints are in the coordinates of the feature maps upsampled by upsampleRatio. Sparse extraction finds them
+// on the original feature maps instead of resizing them
 std::vector<HumanPose> extractPoses(
         std::vector<cv::Mat>& heatMaps,
         std::vector<cv::Mat>& pafs,
-        int upsampleRatio);
+        int upsampleRatio,
+        bool sparse = false);
 } // namespace human_pose_estimation
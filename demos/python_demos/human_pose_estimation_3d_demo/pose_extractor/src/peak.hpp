@@ -39,10 +39,14 @@ struct TwoJointsConnection {
     float score;
 };
 
+// featureMapsScale is the upsampling ratio of the maps which the peaks and poses are found for. 1 means the maps are
+// upsampled already. Otherwise the maps have the network resolution and the peaks are refined to sub-pixel positions,
+// the PAFs are sampled bilinearly along the limbs, so the maps aren't resized
 void findPeaks(const std::vector<cv::Mat>& heatMaps,
                const float minPeaksDistance,
                std::vector<std::vector<Peak> >& allPeaks,
-               int heatMapId);
+               int heatMapId,
+               int featureMapsScale);
 
 std::vector<HumanPose> groupPeaksToPoses(
         const std::vector<std::vector<Peak> >& allPeaks,
@@ -51,5 +55,6 @@ std::vector<HumanPose> groupPeaksToPoses(
         const float midPointsScoreThreshold,
         const float foundMidPointsRatioThreshold,
         const int minJointsNumber,
-        const float minSubsetScore);
+        const float minSubsetScore,
+        const int featureMapsScale);
 } // namespace human_pose_estimation
@@ -5,8 +5,10 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
-#include <iostream>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
@@ -16,32 +18,100 @@
 
 #include "extract_poses.hpp"
 
-static std::vector<cv::Mat> wrap_feature_maps(PyArrayObject* py_feature_maps) {
-    int num_channels = static_cast<int>(PyArray_SHAPE(py_feature_maps)[0]);
-    int h = static_cast<int>(PyArray_SHAPE(py_feature_maps)[1]);
-    int w = static_cast<int>(PyArray_SHAPE(py_feature_maps)[2]);
-    float* data = static_cast<float*>(PyArray_DATA(py_feature_maps));
-    std::vector<cv::Mat> feature_maps(num_channels);
-    for (long c_id = 0; c_id < num_channels; c_id++) {
-        feature_maps[c_id] = cv::Mat(h, w, CV_32FC1,
-                                     data + c_id * PyArray_STRIDE(py_feature_maps, 0) / sizeof(float),
-                                     PyArray_STRIDE(py_feature_maps, 1));
+static const size_t keypoints_number = 18;
+
+// Buffer of an object exported through the buffer protocol, it's released with the view
+struct BufferView {
+    Py_buffer buffer;
+    bool is_acquired = false;
+
+    ~BufferView() {
+        if (is_acquired) {
+            PyBuffer_Release(&buffer);
+        }
     }
-    return feature_maps;
+};
+
+static bool is_float32_format(const char* format) {
+    return format != nullptr && (std::strcmp(format, "f") == 0 || std::strcmp(format, "=f") == 0);
+}
+
+// Wraps float32 feature maps of shape (channels, height, width) into cv::Mat without copying. Any object with the
+// buffer protocol is accepted (numpy arrays, memoryviews), slices of channels and rows are fine if the rows are
+// contiguous. Returns false with a Python exception set if the maps can't be wrapped
+static bool wrap_feature_maps(PyObject* object, const char* name, BufferView& view,
+                              std::vector<cv::Mat>& feature_maps) {
+    if (PyObject_GetBuffer(object, &view.buffer, PyBUF_STRIDES | PyBUF_FORMAT) != 0) {
+        return false;
+    }
+    view.is_acquired = true;
+    const Py_buffer& buffer = view.buffer;
+    if (buffer.ndim != 3 || buffer.itemsize != sizeof(float) || !is_float32_format(buffer.format)) {
+        PyErr_Format(PyExc_TypeError, "%s must be a 3-dimensional float32 array", name);
+        return false;
+    }
+    const Py_ssize_t h = buffer.shape[1];
+    const Py_ssize_t w = buffer.shape[2];
+    if (buffer.strides[2] != sizeof(float) || buffer.strides[1] < static_cast<Py_ssize_t>(w * sizeof(float))
+            || buffer.strides[0] % sizeof(float) != 0 || buffer.strides[1] % sizeof(float) != 0
+            || reinterpret_cast<uintptr_t>(buffer.buf) % alignof(float) != 0) {
+        PyErr_Format(PyExc_ValueError, "%s must have aligned contiguous rows", name);
+        return false;
+    }
+
+    // The maps aren't written, cv::resize() replaces them with new ones
+    char* data = static_cast<char*>(buffer.buf);
+    feature_maps.resize(buffer.shape[0]);
+    for (Py_ssize_t c_id = 0; c_id < buffer.shape[0]; c_id++) {
+        feature_maps[c_id] = cv::Mat(static_cast<int>(h), static_cast<int>(w), CV_32FC1,
+                                     data + c_id * buffer.strides[0], buffer.strides[1]);
+    }
+    return true;
 }
 
 static PyObject* extract_poses(PyObject* self, PyObject* args) {
-    PyArrayObject* py_heatmaps;
-    PyArrayObject* py_pafs;
+    PyObject* py_heatmaps;
+    PyObject* py_pafs;
     int ratio;
-    if (!PyArg_ParseTuple(args, "OOi", &py_heatmaps, &py_pafs, &ratio)) {
+    int sparse = 0;
+    if (!PyArg_ParseTuple(args, "OOi|p", &py_heatmaps, &py_pafs, &ratio, &sparse)) {
+        return nullptr;
+    }
+    BufferView heatmaps_view;
+    BufferView pafs_view;
+    std::vector<cv::Mat> heatmaps;
+    std::vector<cv::Mat> pafs;
+    if (!wrap_feature_maps(py_heatmaps, "heatmaps", heatmaps_view, heatmaps)
+            || !wrap_feature_maps(py_pafs, "pafs", pafs_view, pafs)) {
+        return nullptr;
+    }
+    if (heatmaps.size() != keypoints_number || pafs.size() != 2 * (keypoints_number + 1)
+            || heatmaps[0].size() != pafs[0].size()) {
+        PyErr_Format(PyExc_ValueError, "Expected %d heatmaps and %d pafs of the same size",
+                     static_cast<int>(keypoints_number), static_cast<int>(2 * (keypoints_number + 1)));
+        return nullptr;
+    }
+    if (ratio < 1) {
+        PyErr_SetString(PyExc_ValueError, "Upsample ratio must be positive");
         return nullptr;
     }
-    std::vector<cv::Mat> heatmaps = wrap_feature_maps(py_heatmaps);
-    std::vector<cv::Mat> pafs = wrap_feature_maps(py_pafs);
 
-    std::vector<human_pose_estimation::HumanPose> poses = human_pose_estimation::extractPoses(
-                heatmaps, pafs, ratio);
+    // Python threads run while the poses are extracted, the buffers stay exported until the views are destroyed
+    std::vector<human_pose_estimation::HumanPose> poses;
+    std::string error;
+    bool is_failed = false;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        poses = human_pose_estimation::extractPoses(heatmaps, pafs, ratio, sparse != 0);
+    } catch (const std::exception& e) {
+        error = e.what();
+        is_failed = true;
+    }
+    Py_END_ALLOW_THREADS
+    if (is_failed) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return nullptr;
+    }
 
     size_t num_persons = poses.size();
     size_t num_keypoints = 0;
@@ -66,7 +136,7 @@ static PyObject* extract_poses(PyObject* self, PyObject* args) {
 
 PyMethodDef method_table[] = {
     {"extract_poses", static_cast<PyCFunction>(extract_poses), METH_VARARGS,
-     "Extracts 2D poses from provided heatmaps and pafs"},
+     "Extracts 2D poses from provided heatmaps and pafs. The maps aren't copied and the GIL is released meanwhile"},
     {NULL, NULL, 0, NULL}
 };
 
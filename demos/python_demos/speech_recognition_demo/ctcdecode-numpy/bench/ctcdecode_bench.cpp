@@ -0,0 +1,409 @@
+/*********************************************************************
+* Copyright (c) 2020 Intel Corporation
+* SPDX-License-Identifier: Apache-2.0
+**********************************************************************/
+
+// Benchmark of the CTC beam search with the yoklm scorer. It decodes recorded
+// probabilities (.npy files saved by speech_recognition_demo.py --save-probs)
+// with every combination of the given beam sizes and thread counts and prints
+// a JSON line per combination with the real-time factor, the time of the
+// decoder phases and the peak resident memory.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "ctc_beam_search_decoder.h"
+#include "decoder_profile.h"
+#include "scorer_yoklm.h"
+
+namespace {
+const char usage[] =
+    "Usage: ctcdecode_numpy_bench [options]\n"
+    "  --logits <a.npy,b.npy>  Probabilities of the utterances to decode, float32 arrays\n"
+    "                          of (frames, classes) or (batch, frames, classes) shape.\n"
+    "                          Random peaky probabilities of 8 utterances of 20 s are\n"
+    "                          generated if they aren't given.\n"
+    "  --lm <path>             KenLM binary file loaded with ScorerYoklm. Without it\n"
+    "                          the beams aren't scored by a language model.\n"
+    "  --dictionary <path>     Word prefix dictionary of the LM, built and saved there\n"
+    "                          if it doesn't exist.\n"
+    "  --alphabet <path>       Alphabet file in the format of the demo, the default\n"
+    "                          alphabet of Mozilla DeepSpeech is used otherwise.\n"
+    "  --beam <list>           Comma separated beam sizes (default 10,100,500).\n"
+    "  --threads <list>        Comma separated numbers of decoding threads (default 1,4).\n"
+    "  --repeat <n>            Decodes of the utterances measured per combination (default 3).\n"
+    "  --alpha <x>             LM weight (default 0.75).\n"
+    "  --beta <x>              Word insertion bonus (default 1.85).\n"
+    "  --cutoff_top_n <n>      Classes considered at a time step (default 40).\n"
+    "  --frame_ms <x>          Audio duration of a frame for the real-time factor (default 20).\n"
+    "  --log_input             The probabilities are natural logarithms.\n";
+
+struct Options {
+  std::vector<std::string> logits;
+  std::string lm;
+  std::string dictionary;
+  std::string alphabet;
+  std::vector<size_t> beams = {10, 100, 500};
+  std::vector<size_t> threads = {1, 4};
+  size_t repeat = 3;
+  double alpha = 0.75;
+  double beta = 1.85;
+  size_t cutoff_top_n = 40;
+  double frame_ms = 20.0;
+  bool log_input = false;
+};
+
+std::vector<std::string> split(const std::string &s, char delim) {
+  std::vector<std::string> result;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, delim)) {
+    if (!item.empty()) {
+      result.push_back(item);
+    }
+  }
+  return result;
+}
+
+std::vector<size_t> parse_sizes(const std::string &s, const std::string &option) {
+  std::vector<size_t> result;
+  for (const std::string &item : split(s, ',')) {
+    char *end = nullptr;
+    unsigned long long value = std::strtoull(item.c_str(), &end, 10);
+    if (*end != '\0' || value == 0) {
+      throw std::invalid_argument(option + " expects positive integers, got " + s);
+    }
+    result.push_back(static_cast<size_t>(value));
+  }
+  if (result.empty()) {
+    throw std::invalid_argument(option + " is empty");
+  }
+  return result;
+}
+
+// Returns false if the usage is printed
+bool parse_options(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      std::cout << usage;
+      return false;
+    }
+    if (arg == "--log_input") {
+      options.log_input = true;
+      continue;
+    }
+    if (i + 1 == argc) {
+      throw std::invalid_argument("Option " + arg + " has no value");
+    }
+    const std::string value = argv[++i];
+    if (arg == "--logits") {
+      options.logits = split(value, ',');
+    } else if (arg == "--lm") {
+      options.lm = value;
+    } else if (arg == "--dictionary") {
+      options.dictionary = value;
+    } else if (arg == "--alphabet") {
+      options.alphabet = value;
+    } else if (arg == "--beam") {
+      options.beams = parse_sizes(value, arg);
+    } else if (arg == "--threads") {
+      options.threads = parse_sizes(value, arg);
+    } else if (arg == "--repeat") {
+      options.repeat = parse_sizes(value, arg).front();
+    } else if (arg == "--alpha") {
+      options.alpha = std::stod(value);
+    } else if (arg == "--beta") {
+      options.beta = std::stod(value);
+    } else if (arg == "--cutoff_top_n") {
+      options.cutoff_top_n = parse_sizes(value, arg).front();
+    } else if (arg == "--frame_ms") {
+      options.frame_ms = std::stod(value);
+    } else {
+      throw std::invalid_argument("Unknown option " + arg + ", see --help");
+    }
+  }
+  return true;
+}
+
+// The same format as load_alphabet() of the demo
+std::vector<std::string> load_alphabet(const std::string &path) {
+  if (path.empty()) {
+    std::vector<std::string> alphabet = {" "};
+    for (char c = 'a'; c <= 'z'; ++c) {
+      alphabet.push_back(std::string(1, c));
+    }
+    alphabet.push_back("'");
+    return alphabet;
+  }
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Can't open " + path);
+  }
+  std::vector<std::string> alphabet;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      break;
+    }
+    if (line[0] == '#') {
+      continue;
+    }
+    if (line.compare(0, 2, "\\s") == 0) {
+      line = " " + line.substr(2);
+    } else if (line[0] == '\\') {
+      line = line.substr(1);
+    }
+    alphabet.push_back(line);
+  }
+  return alphabet;
+}
+
+// Utterances padded to the longest one, as the demo passes a batch
+struct Utterances {
+  std::vector<float> probs;
+  std::vector<size_t> seq_lens;
+  size_t max_frames = 0;
+  size_t num_classes = 0;
+};
+
+// Reads a float32 C-ordered array of a .npy file as (batch, frames, classes)
+void load_npy(const std::string &path, std::vector<std::vector<float>> &sequences,
+              std::vector<size_t> &frames, size_t &num_classes) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[8];
+  if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, "\x93NUMPY", 6) != 0) {
+    throw std::runtime_error(path + " isn't a .npy file");
+  }
+  uint32_t header_size = 0;
+  unsigned char size_bytes[4] = {};
+  if (magic[6] == 1) {
+    file.read(reinterpret_cast<char *>(size_bytes), 2);
+  } else {
+    file.read(reinterpret_cast<char *>(size_bytes), 4);
+  }
+  header_size = size_bytes[0] | size_bytes[1] << 8 | size_bytes[2] << 16 | uint32_t(size_bytes[3]) << 24;
+  std::string header(header_size, '\0');
+  if (!file.read(&header[0], header_size)) {
+    throw std::runtime_error(path + " is truncated");
+  }
+  if (header.find("'descr': '<f4'") == std::string::npos || header.find("'fortran_order': False") == std::string::npos) {
+    throw std::runtime_error(path + " should hold a float32 array in C order");
+  }
+  const size_t shape_begin = header.find('(', header.find("'shape'"));
+  const size_t shape_end = header.find(')', shape_begin);
+  std::vector<size_t> shape;
+  for (const std::string &dim : split(header.substr(shape_begin + 1, shape_end - shape_begin - 1), ',')) {
+    if (dim.find_first_not_of(' ') != std::string::npos) {
+      shape.push_back(std::stoul(dim));
+    }
+  }
+  if (shape.size() == 2) {
+    shape.insert(shape.begin(), 1);
+  }
+  if (shape.size() != 3) {
+    throw std::runtime_error(path + " should hold (frames, classes) or (batch, frames, classes) array");
+  }
+  if (num_classes != 0 && num_classes != shape[2]) {
+    throw std::runtime_error(path + " has another number of classes than the other files");
+  }
+  num_classes = shape[2];
+  for (size_t b = 0; b < shape[0]; ++b) {
+    std::vector<float> sequence(shape[1] * shape[2]);
+    if (!file.read(reinterpret_cast<char *>(sequence.data()), sequence.size() * sizeof(float))) {
+      throw std::runtime_error(path + " is truncated");
+    }
+    sequences.push_back(std::move(sequence));
+    frames.push_back(shape[1]);
+  }
+}
+
+// Probabilities peaking at a random class for several frames, like the ones
+// of an acoustic model, so the beams are pruned as they are in practice
+std::vector<float> make_peaky_probs(size_t num_frames, size_t num_classes, std::mt19937 &rng) {
+  std::vector<float> probs(num_frames * num_classes);
+  std::uniform_int_distribution<size_t> classes(0, num_classes - 1);
+  std::uniform_int_distribution<int> durations(1, 6);
+  std::uniform_real_distribution<float> peaks(0.5f, 0.99f);
+  size_t peak_class = num_classes - 1;
+  for (size_t t = 0; t < num_frames; ++t) {
+    if (durations(rng) == 1) {
+      peak_class = classes(rng);
+    }
+    const float peak = peaks(rng);
+    float *frame = &probs[t * num_classes];
+    std::fill(frame, frame + num_classes, (1.0f - peak) / (num_classes - 1));
+    frame[peak_class] = peak;
+  }
+  return probs;
+}
+
+Utterances load_utterances(const Options &options, size_t num_classes) {
+  std::vector<std::vector<float>> sequences;
+  Utterances utterances;
+  if (options.logits.empty()) {
+    std::mt19937 rng(12345);
+    for (size_t i = 0; i < 8; ++i) {
+      sequences.push_back(make_peaky_probs(1000, num_classes, rng));
+      utterances.seq_lens.push_back(1000);
+    }
+    utterances.num_classes = num_classes;
+  } else {
+    for (const std::string &path : options.logits) {
+      load_npy(path, sequences, utterances.seq_lens, utterances.num_classes);
+    }
+    if (utterances.num_classes != num_classes) {
+      throw std::runtime_error("The probabilities have " + std::to_string(utterances.num_classes)
+          + " classes, the alphabet and the blank have " + std::to_string(num_classes));
+    }
+  }
+  utterances.max_frames = *std::max_element(utterances.seq_lens.begin(), utterances.seq_lens.end());
+  utterances.probs.resize(sequences.size() * utterances.max_frames * num_classes);
+  for (size_t b = 0; b < sequences.size(); ++b) {
+    std::copy(sequences[b].begin(), sequences[b].end(),
+              utterances.probs.begin() + b * utterances.max_frames * num_classes);
+  }
+  return utterances;
+}
+
+// Peak resident memory of the process in megabytes
+double peak_rss_mb() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.PeakWorkingSetSize / 1048576.0;
+  }
+  return 0.0;
+#else
+#ifdef __linux__
+  // VmHWM is reset by reset_peak_rss(), unlike ru_maxrss
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::stod(line.substr(6)) / 1024.0;  // kilobytes
+    }
+  }
+#endif
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1048576.0;  // bytes
+#else
+  return usage.ru_maxrss / 1024.0;  // kilobytes
+#endif
+#endif
+}
+
+// Makes the peak resident memory start from the current one where it's
+// supported (Linux 4.0+), so it's measured for every combination. Returns
+// false if the peak stays the one of the whole process
+bool reset_peak_rss() {
+#ifdef __linux__
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  return static_cast<bool>(clear_refs << "5" << std::flush);
+#else
+  return false;
+#endif
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  try {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+      return 0;
+    }
+#ifndef CTCDECODE_PROFILE
+    std::cerr << "The decoder is built without CTCDECODE_PROFILE, the phases aren't timed" << std::endl;
+#endif
+
+    std::vector<std::string> labels = load_alphabet(options.alphabet);
+    labels.push_back("");  // blank, as the demo adds it
+    const size_t blank_id = labels.size() - 1;
+    const Utterances utterances = load_utterances(options, labels.size());
+    const double audio_seconds = options.frame_ms / 1000.0
+        * std::accumulate(utterances.seq_lens.begin(), utterances.seq_lens.end(), size_t(0));
+
+    std::unique_ptr<ScorerYoklm> scorer;
+    double lm_load_seconds = 0.0;
+    if (!options.lm.empty()) {
+      const auto start = std::chrono::steady_clock::now();
+      if (options.dictionary.empty()) {
+        scorer.reset(new ScorerYoklm(options.alpha, options.beta, options.lm, labels));
+      } else {
+        scorer.reset(new ScorerYoklm(options.alpha, options.beta, options.lm, labels, options.dictionary));
+      }
+      lm_load_seconds = seconds_since(start);
+    }
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "{\"utterances\": " << utterances.seq_lens.size() << ", \"audio_s\": " << audio_seconds
+              << ", \"lm_load_s\": " << lm_load_seconds << ", \"rss_after_load_mb\": " << peak_rss_mb()
+              << "}" << std::endl;
+
+    for (size_t beam : options.beams) {
+      for (size_t threads : options.threads) {
+        CtcBeamSearchBatchDecoder decoder(labels, beam, threads, 1.0f, options.cutoff_top_n,
+                                          blank_id, options.log_input, scorer.get());
+        auto decode = [&]() {
+          return decoder.decode(utterances.probs.data(), utterances.seq_lens, utterances.num_classes,
+                                utterances.max_frames * utterances.num_classes, utterances.num_classes, 1);
+        };
+        // The first decode allocates the nodes of the prefix tries of the threads
+        decode();
+        const bool is_peak_per_run = reset_peak_rss();
+        reset_decoder_phase_times();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < options.repeat; ++i) {
+          decode();
+        }
+        const double decode_seconds = seconds_since(start) / options.repeat;
+        uint64_t phase_nanoseconds[NUM_DECODER_PHASES];
+        get_decoder_phase_times(phase_nanoseconds);
+
+        std::cout << "{\"beam\": " << beam << ", \"threads\": " << threads
+                  << ", \"decode_s\": " << decode_seconds << ", \"rtf\": " << decode_seconds / audio_seconds
+                  << ", \"phases_thread_s\": {";
+        for (size_t phase = 0; phase < NUM_DECODER_PHASES; ++phase) {
+          std::cout << (phase ? ", " : "") << "\"" << decoder_phase_name(static_cast<DecoderPhase>(phase))
+                    << "\": " << phase_nanoseconds[phase] / 1e9 / options.repeat;
+        }
+        std::cout << "}, \"peak_rss_mb\": " << peak_rss_mb()
+                  << ", \"peak_rss_scope\": \"" << (is_peak_per_run ? "run" : "process") << "\"}" << std::endl;
+      }
+    }
+  } catch (const std::exception &error) {
+    std::cerr << "[ ERROR ] " << error.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -12,7 +12,8 @@ from . import impl as ctc_decode
 
 class CTCBeamDecoder(object):
     def __init__(self, labels, model_path=None, alpha=0, beta=0, cutoff_top_n=40, cutoff_prob=1.0, beam_width=100,
-                 max_candidates_per_batch=None, num_processes=4, blank_id=0, log_probs_input=False, loader='yoklm'):
+                 max_candidates_per_batch=None, num_processes=4, blank_id=0, log_probs_input=False, loader='yoklm',
+                 dictionary_path=None):
         self.cutoff_top_n = cutoff_top_n
         self._beam_width = beam_width
         self._max_candidates_per_batch = max_candidates_per_batch
@@ -23,10 +24,22 @@ class CTCBeamDecoder(object):
         self._log_probs = bool(log_probs_input)
         if model_path is not None:
             if loader == 'yoklm':
-                self._scorer = ctc_decode.create_scorer_yoklm(alpha, beta, model_path, self._labels)
+                self._scorer = ctc_decode.create_scorer_yoklm(alpha, beta, model_path, self._labels,
+                                                             dictionary_path or '')
             else:
                 raise ValueError("Unknown loader type: \"%s\"" % loader)
         self._cutoff_prob = cutoff_prob
+        # Keeps its threads between the calls of decode()
+        self._batch_decoder = ctc_decode.create_batch_decoder(
+            self._labels,
+            self._beam_width,
+            self._num_processes,
+            self._cutoff_prob,
+            self.cutoff_top_n,
+            self._blank_id,
+            self._log_probs,
+            self._scorer,
+        )
 
     def decode(self, probs, seq_lens=None):
         # We expect probs as batch x seq x label_size
@@ -36,33 +49,15 @@ class CTCBeamDecoder(object):
         max_candidates_per_batch = self._max_candidates_per_batch
         if max_candidates_per_batch is None or max_candidates_per_batch > self._beam_width:
             max_candidates_per_batch = self._beam_width
-        if self._scorer is not None:
-            output, timesteps, scores, out_seq_len = ctc_decode.numpy_beam_decode(
-                probs,  # batch_size x max_seq_lens x vocab_size
-                seq_lens,  # batch_size
-                self._labels,  # list(str)
-                self._beam_width,
-                max_candidates_per_batch,
-                self._num_processes,
-                self._cutoff_prob,
-                self.cutoff_top_n,
-                self._blank_id,
-                self._log_probs,  # log_input, bool
-                self._scorer,
-            )
-        else:
-            output, timesteps, scores, out_seq_len = ctc_decode.numpy_beam_decode_no_lm(
-                probs,  # batch_size x max_seq_lens x vocab_size
-                seq_lens,  # batch_size
-                self._labels,  # list(str)
-                self._beam_width,
-                max_candidates_per_batch,
-                self._num_processes,
-                self._cutoff_prob,
-                self.cutoff_top_n,
-                self._blank_id,
-                self._log_probs,  # log_input, bool
-            )
+        # float16 probabilities are converted by the decoder one time step at a time
+        decode = (ctc_decode.numpy_batch_decoder_decode_fp16 if probs.dtype == np.float16
+                  else ctc_decode.numpy_batch_decoder_decode)
+        output, timesteps, scores, out_seq_len = decode(
+            self._batch_decoder,
+            probs,  # batch_size x max_seq_lens x vocab_size
+            seq_lens,  # batch_size
+            max_candidates_per_batch,
+        )
         output.shape =      (batch_size, max_candidates_per_batch, -1)
         timesteps.shape =   (batch_size, max_candidates_per_batch, -1)
         scores.shape =      (batch_size, max_candidates_per_batch)
@@ -70,6 +65,65 @@ class CTCBeamDecoder(object):
 
         return output, scores, timesteps, out_seq_len
 
+    def decode_sparse(self, class_ids, class_probs, seq_lens=None):
+        """
+        Decode the top classes of every time step, e.g. selected by a TopK layer appended to the model, so the whole
+        vocabulary is neither transferred nor scanned. We expect int32 class_ids and their class_probs (or log
+        probabilities with log_probs_input) as batch x seq x top_k, the other classes are pruned. Return the same as
+        decode()
+        """
+        batch_size, max_seq_len = class_ids.shape[0], class_ids.shape[1]
+        if seq_lens is None:
+            seq_lens = np.full(batch_size, max_seq_len, dtype=np.int32)
+        max_candidates_per_batch = self._max_candidates_per_batch
+        if max_candidates_per_batch is None or max_candidates_per_batch > self._beam_width:
+            max_candidates_per_batch = self._beam_width
+        output, timesteps, scores, out_seq_len = ctc_decode.numpy_batch_decoder_decode_sparse(
+            self._batch_decoder,
+            class_ids,  # batch_size x max_seq_lens x top_k
+            class_probs,  # batch_size x max_seq_lens x top_k
+            seq_lens,  # batch_size
+            max_candidates_per_batch,
+        )
+        output.shape =      (batch_size, max_candidates_per_batch, -1)
+        timesteps.shape =   (batch_size, max_candidates_per_batch, -1)
+        scores.shape =      (batch_size, max_candidates_per_batch)
+        out_seq_len.shape = (batch_size, max_candidates_per_batch)
+
+        return output, scores, timesteps, out_seq_len
+
+    def output_buffers(self, batch_size, max_len):
+        """
+        Return (output, scores, timesteps, out_seq_len) arrays for decode_into()
+        """
+        max_candidates_per_batch = self._max_candidates_per_batch
+        if max_candidates_per_batch is None or max_candidates_per_batch > self._beam_width:
+            max_candidates_per_batch = self._beam_width
+        return _output_buffers((batch_size, max_candidates_per_batch), max_len)
+
+    def decode_into(self, probs, output, scores, timesteps, out_seq_len, seq_lens=None):
+        """
+        Decode like decode() writing the results into the arrays of the caller, which can be reused between the calls:
+        int32 output and timesteps of (batch_size, max_candidates, max_len) shape, float32 scores and int32 out_seq_len
+        of (batch_size, max_candidates) shape, see output_buffers(). max_len = max_seq_len is always enough.
+        Return the length of the longest candidate, the tokens after out_seq_len of every candidate are left as they were
+        """
+        batch_size, max_seq_len = probs.shape[0], probs.shape[1]
+        if seq_lens is None:
+            seq_lens = np.full(batch_size, max_seq_len, dtype=np.int32)
+        return ctc_decode.numpy_batch_decoder_decode_into(
+            self._batch_decoder,
+            probs,  # batch_size x max_seq_lens x vocab_size
+            seq_lens,  # batch_size
+            output, timesteps, scores, out_seq_len,
+        )
+
+    def create_stream(self, max_candidates=None):
+        """
+        Return a CTCBeamDecoderStream to decode a single utterance fed chunk by chunk
+        """
+        return CTCBeamDecoderStream(self, max_candidates)
+
     def character_based(self):
         return ctc_decode.is_character_based(self._scorer) if self._scorer else None
 
@@ -83,6 +137,95 @@ class CTCBeamDecoder(object):
         if self._scorer is not None:
             ctc_decode.reset_params(self._scorer, alpha, beta)
 
+    def set_lm_cache_size(self, memory_budget):
+        """
+        Set the size in bytes of the cache of language model queries shared by the decoding threads, 0 disables it.
+        The cached queries are dropped
+        """
+        if self._scorer is not None:
+            ctc_decode.set_lm_cache_size(self._scorer, memory_budget)
+
+    def lm_cache_stats(self):
+        """Return (hits, lookups) of the language model cache"""
+        if self._scorer is None:
+            return None
+        return ctc_decode.get_lm_cache_hits(self._scorer), ctc_decode.get_lm_cache_lookups(self._scorer)
+
     def __del__(self):
+        if getattr(self, '_batch_decoder', None) is not None:
+            ctc_decode.delete_batch_decoder(self._batch_decoder)
         if self._scorer is not None:
             ctc_decode.delete_scorer(self._scorer)
+
+
+class CTCBeamDecoderStream(object):
+    def __init__(self, decoder, max_candidates=None):
+        if max_candidates is None or max_candidates > decoder._beam_width:
+            max_candidates = decoder._beam_width
+        self._max_candidates = max_candidates
+        self._decoder = decoder  # keeps the scorer alive
+        self.num_frames = 0
+        self._state = ctc_decode.create_decoder_state(
+            decoder._labels,
+            decoder._beam_width,
+            decoder._cutoff_prob,
+            decoder.cutoff_top_n,
+            decoder._blank_id,
+            decoder._log_probs,
+            decoder._scorer,
+        )
+
+    def feed(self, probs):
+        # We expect probs as seq x label_size, float32 or float16
+        if probs.dtype == np.float16:
+            ctc_decode.numpy_decoder_state_feed_fp16(self._state, probs)
+        else:
+            ctc_decode.numpy_decoder_state_feed(self._state, probs)
+        self.num_frames += probs.shape[0]
+
+    def feed_sparse(self, class_ids, class_probs):
+        # We expect class_ids and class_probs as seq x top_k, see CTCBeamDecoder.decode_sparse()
+        ctc_decode.numpy_decoder_state_feed_sparse(self._state, class_ids, class_probs)
+        self.num_frames += class_ids.shape[0]
+
+    def partial_result(self):
+        return self._result(False)
+
+    def finalize(self):
+        return self._result(True)
+
+    def output_buffers(self, max_len=None):
+        """
+        Return (output, scores, timesteps, out_seq_len) arrays for result_into(), max_len defaults to the number of
+        frames fed so far
+        """
+        return _output_buffers((self._max_candidates,), max(max_len or self.num_frames, 1))
+
+    def result_into(self, output, scores, timesteps, out_seq_len, finalize=False):
+        """
+        Write the partial or the final results into the arrays of the caller, which can be reused between the calls:
+        int32 output and timesteps of (max_candidates, max_len) shape, float32 scores and int32 out_seq_len of
+        (max_candidates,) shape, see output_buffers(). max_len = num_frames is always enough.
+        Return the length of the longest candidate, the tokens after out_seq_len of every candidate are left as they were
+        """
+        return ctc_decode.numpy_decoder_state_result_into(self._state, finalize, output, timesteps, scores, out_seq_len)
+
+    def _result(self, finalize):
+        output, timesteps, scores, out_seq_len = ctc_decode.numpy_decoder_state_result(
+            self._state, finalize, self._max_candidates)
+        output.shape = (self._max_candidates, -1)
+        timesteps.shape = (self._max_candidates, -1)
+        return output, scores, timesteps, out_seq_len
+
+    def __del__(self):
+        if getattr(self, '_state', None) is not None:
+            ctc_decode.delete_decoder_state(self._state)
+
+
+def _output_buffers(candidates_shape, max_len):
+    return (
+        np.empty(candidates_shape + (max_len,), dtype=np.int32),
+        np.empty(candidates_shape, dtype=np.float32),
+        np.empty(candidates_shape + (max_len,), dtype=np.int32),
+        np.empty(candidates_shape, dtype=np.int32),
+    )
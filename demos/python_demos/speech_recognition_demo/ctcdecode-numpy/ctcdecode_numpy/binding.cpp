@@ -19,10 +19,122 @@
 #include "scorer_base.h"
 #include "ctc_beam_search_decoder.h"
 
-size_t index_3d(size_t i1, size_t i2, size_t i3, size_t dim1, size_t dim2, size_t dim3) {
-  return i3 + dim3 * (i2 + dim2 * i1);
+namespace {
+size_t results_max_len(const std::vector<std::vector<std::pair<float, Output> > >& batch_results,
+                       size_t max_candidates_per_batch)
+{
+    size_t max_len = 0;
+    for (auto&& result_batch_entry : batch_results) {
+        size_t candidate_idx = 0;
+        for (auto&& result_candidate : result_batch_entry) {
+            if (candidate_idx++ >= max_candidates_per_batch)
+                break;
+            size_t len = result_candidate.second.tokens.size();
+            if (max_len < len)
+                max_len = len;
+        }
+    }
+    return max_len;
+}
+
+// Writes the candidates to (batch_size, max_candidates_per_batch, row_len) and (batch_size, max_candidates_per_batch)
+// arrays, the tokens beyond the lengths of the candidates are left untouched
+void write_results(
+        const std::vector<std::vector<std::pair<float, Output> > >& batch_results,
+        size_t max_candidates_per_batch,
+        size_t row_len,
+        int * tokens, int * timesteps, float * scores, int * tokens_lengths)
+{
+    for (size_t b = 0; b < batch_results.size(); b++) {
+        const std::vector<std::pair<float, Output> >& results = batch_results[b];
+        size_t p = 0;
+        for (; p < results.size() && p < max_candidates_per_batch; p++) {
+            const size_t index_bp = b * max_candidates_per_batch + p;
+            const std::pair<float, Output>& n_path_result = results[p];
+            const Output& output = n_path_result.second;
+            for (size_t t = 0; t < output.tokens.size(); t++) {
+                tokens[index_bp * row_len + t] = output.tokens[t]; // fill output tokens
+                timesteps[index_bp * row_len + t] = output.timesteps[t];
+            }
+            scores[index_bp] = n_path_result.first;  // scores are -log(p), so lower = better
+            tokens_lengths[index_bp] = output.tokens.size();
+        }
+        for (; p < max_candidates_per_batch; p++) {
+            const size_t index_bp = b * max_candidates_per_batch + p;
+            // fill the absent candidates with infitite scores and no tokens
+            scores[index_bp] = std::numeric_limits<float>::infinity();
+            tokens_lengths[index_bp] = 0;
+        }
+    }
+}
+
+void fill_numpy_results(
+        std::vector<std::vector<std::pair<float, Output> > >& batch_results,
+        size_t max_candidates_per_batch,
+        int ** tokens, size_t * tokens_dim,
+        int ** timesteps, size_t * timesteps_dim,
+        float ** scores, size_t * scores_dim,
+        int ** tokens_lengths, size_t * tokens_lengths_dim)
+{
+    const size_t batch_size = batch_results.size();
+    const size_t max_len = std::max(results_max_len(batch_results, max_candidates_per_batch), size_t(1));
+
+    if ((size_t)-1 / sizeof(**tokens) / batch_size / max_candidates_per_batch / max_len == 0)
+        throw std::runtime_error("beam_decode: dimension of output arg \"tokens\" exceeds size_t");
+    if ((size_t)-1 / sizeof(**timesteps) / batch_size / max_candidates_per_batch / max_len == 0)
+        throw std::runtime_error("beam_decode: dimension of output arg \"timesteps\" exceeds size_t");
+
+    *tokens_dim = *timesteps_dim = batch_size * max_candidates_per_batch * max_len;
+    *tokens = (int *)malloc(sizeof(**tokens) * *tokens_dim);
+    if (*tokens == 0)
+        throw std::runtime_error("beam_decode: cannot malloc() tokens");
+
+    *timesteps = (int *)malloc(sizeof(**timesteps) * *timesteps_dim);
+    if (*timesteps == 0)
+        throw std::runtime_error("beam_decode: cannot malloc() timesteps");
+
+    *scores_dim = *tokens_lengths_dim = batch_size * max_candidates_per_batch;
+    *scores = (float *)malloc(sizeof(**scores) * *scores_dim);
+    if (*scores == 0)
+        throw std::runtime_error("beam_decode: cannot malloc() scores");
+
+    *tokens_lengths = (int *)malloc(sizeof(**tokens_lengths) * *tokens_lengths_dim);
+    if (*tokens_lengths == 0)
+        throw std::runtime_error("beam_decode: cannot malloc() tokens_lengths");
+
+    write_results(batch_results, max_candidates_per_batch, max_len, *tokens, *timesteps, *scores, *tokens_lengths);
 }
 
+size_t write_results_into(
+        const std::vector<std::vector<std::pair<float, Output> > >& batch_results,
+        size_t max_candidates_per_batch,
+        size_t row_len,
+        int * tokens, int * timesteps, float * scores, int * tokens_lengths)
+{
+    const size_t max_len = results_max_len(batch_results, max_candidates_per_batch);
+    if (max_len > row_len)
+        throw std::runtime_error("beam_decode: output arrays are shorter than the longest candidate");
+    write_results(batch_results, max_candidates_per_batch, row_len, tokens, timesteps, scores, tokens_lengths);
+    return max_len;
+}
+
+std::vector<size_t> checked_seq_lens(const int * seq_lens, size_t seq_lens_dim_batch, size_t batch_size,
+                                     size_t max_frames)
+{
+    if (seq_lens_dim_batch != batch_size)
+        throw std::runtime_error("beam_decode: probs and seq_lens batch sizes differ");
+
+    std::vector<size_t> seq_lens_vec(batch_size);
+    for (size_t b = 0; b < batch_size; b++) {
+        // ensure that an erroneous seq_len doesn't make us try to access memory we shouldn't
+        if (seq_lens[b] < 0)
+            throw std::runtime_error("beam_decode: negative integer in seq_lens[]");
+        seq_lens_vec[b] = std::min((size_t)(seq_lens[b]), max_frames);
+    }
+    return seq_lens_vec;
+}
+}  // namespace
+
 void numpy_beam_decode(
         const float * probs,  size_t batch_size, size_t max_frames, size_t num_classes,
         const int * seq_lens,  size_t seq_lens_dim_batch,
@@ -47,94 +159,25 @@ void numpy_beam_decode(
         ext_scorer = static_cast<ScorerBase *>(scorer);
     }
 
-    if (seq_lens_dim_batch != batch_size)
-        throw std::runtime_error("beam_decode: probs and seq_lens batch sizes differ");
     if (max_candidates_per_batch > beam_size)
         max_candidates_per_batch = beam_size;
     if (max_candidates_per_batch < 1)
         throw std::runtime_error("numpy_beam_decode: max_candidates_per_batch must be at least 1");
 
-    std::vector<std::vector<std::vector<float> > > probs_vec;
-    probs_vec.reserve(batch_size);
-
-    for (size_t b = 0; b < batch_size; b++) {
-        // ensure that an erroneous seq_len doesn't make us try to access memory we shouldn't
-        if (seq_lens[b] < 0)
-            throw std::runtime_error("beam_decode: negative integer in seq_lens[]");
-        size_t seq_len = std::min((size_t)(seq_lens[b]), max_frames);
-        std::vector<std::vector<float> > probs_one_batch(seq_len, std::vector<float>(num_classes));
-        for (size_t t = 0; t < seq_len; t++) {
-            for (size_t n = 0; n < num_classes; n++) {
-                float val = probs[index_3d(b,t,n, batch_size, max_frames, num_classes)];
-                probs_one_batch[t][n] = val;
-            }
-        }
-        probs_vec.emplace_back(std::move(probs_one_batch));
-    }
+    std::vector<size_t> seq_lens_vec = checked_seq_lens(seq_lens, seq_lens_dim_batch, batch_size, max_frames);
 
+    // The decoders read the probabilities straight from the numpy array
     std::vector<std::vector<std::pair<float, Output> > > batch_results =
-        ctc_beam_search_decoder_batch(probs_vec, labels, beam_size, num_processes,
+        ctc_beam_search_decoder_batch_strided(probs, seq_lens_vec, num_classes,
+            max_frames * num_classes, num_classes, 1,
+            labels, beam_size, num_processes,
             cutoff_prob, cutoff_top_n, blank_id, log_input, ext_scorer);
 
     if (batch_results.size() != batch_size)
         throw std::runtime_error("numpy_beam_decode: internal error: output batch size differs from input batch size");
 
-    size_t max_len = 1;
-    for (auto&& result_batch_entry : batch_results) {
-        size_t candidate_idx = 0;
-        for (auto&& result_candidate : result_batch_entry) {
-            if (candidate_idx++ >= max_candidates_per_batch)
-                break;
-            size_t len = result_candidate.second.tokens.size();
-            if (max_len < len)
-                max_len = len;
-        }
-    }
-
-    if ((size_t)-1 / sizeof(**tokens) / batch_size / max_candidates_per_batch / max_len == 0)
-        throw std::runtime_error("numpy_beam_decode: dimension of output arg \"tokens\" exceeds size_t");
-    if ((size_t)-1 / sizeof(**timesteps) / batch_size / max_candidates_per_batch / max_len == 0)
-        throw std::runtime_error("numpy_beam_decode: dimension of output arg \"timesteps\" exceeds size_t");
-
-    *tokens_dim = *timesteps_dim = batch_size * max_candidates_per_batch * max_len;
-    *tokens = (int *)malloc(sizeof(**tokens) * *tokens_dim);
-    if (*tokens == 0)
-        throw std::runtime_error("numpy_beam_decode: cannot malloc() tokens");
-
-    *timesteps = (int *)malloc(sizeof(**timesteps) * *timesteps_dim);
-    if (*timesteps == 0)
-        throw std::runtime_error("numpy_beam_decode: cannot malloc() timesteps");
-
-    *scores_dim = *tokens_lengths_dim = batch_size * max_candidates_per_batch;
-    *scores = (float *)malloc(sizeof(**scores) * *scores_dim);
-    if (*scores == 0)
-        throw std::runtime_error("numpy_beam_decode: cannot malloc() scores");
-
-    *tokens_lengths = (int *)malloc(sizeof(**tokens_lengths) * *tokens_lengths_dim);
-    if (*tokens_lengths == 0)
-        throw std::runtime_error("numpy_beam_decode: cannot malloc() tokens_lengths");
-
-    for (size_t b = 0; b < batch_results.size(); b++) {
-        std::vector<std::pair<float, Output> >& results = batch_results[b];
-        size_t p = 0;
-        for (; p < results.size() && p < max_candidates_per_batch; p++) {
-            const size_t index_bp = b * max_candidates_per_batch + p;
-            std::pair<float, Output>& n_path_result = results[p];
-            Output& output = n_path_result.second;
-            for (size_t t = 0; t < output.tokens.size(); t++) {
-                (*tokens)[index_bp * max_len + t] = output.tokens[t]; // fill output tokens
-                (*timesteps)[index_bp * max_len + t] = output.timesteps[t];
-            }
-            (*scores)[index_bp] = n_path_result.first;  // scores are -log(p), so lower = better
-            (*tokens_lengths)[index_bp] = output.tokens.size();
-        }
-        for (; p < max_candidates_per_batch; p++) {
-            const size_t index_bp = b * max_candidates_per_batch + p;
-            // fill the absent candidates with infitite scores and no tokens
-            (*scores)[index_bp] = std::numeric_limits<float>::infinity();
-            (*tokens_lengths)[index_bp] = 0;
-        }
-    }
+    fill_numpy_results(batch_results, max_candidates_per_batch,
+        tokens, tokens_dim, timesteps, timesteps_dim, scores, scores_dim, tokens_lengths, tokens_lengths_dim);
 }
 
 void numpy_beam_decode_no_lm(
@@ -174,13 +217,214 @@ void numpy_beam_decode_no_lm(
 }
 
 
+void* create_batch_decoder(
+        const std::vector<std::string>& labels,
+        size_t beam_size,
+        size_t num_processes,
+        float cutoff_prob,
+        size_t cutoff_top_n,
+        size_t blank_id,
+        bool log_input,
+        void *scorer)
+{
+    CtcBeamSearchBatchDecoder* decoder = new CtcBeamSearchBatchDecoder(labels, beam_size, num_processes,
+        cutoff_prob, cutoff_top_n, blank_id, log_input, static_cast<ScorerBase *>(scorer));
+    return static_cast<void*>(decoder);
+}
+
+void delete_batch_decoder(void* decoder) {
+    delete static_cast<CtcBeamSearchBatchDecoder*>(decoder);
+}
+
+void numpy_batch_decoder_decode(
+        void* decoder,
+        const float * probs,  size_t batch_size, size_t max_frames, size_t num_classes,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        size_t max_candidates_per_batch,
+        int ** tokens, size_t * tokens_dim,
+        int ** timesteps, size_t * timesteps_dim,
+        float ** scores, size_t * scores_dim,
+        int ** tokens_lengths, size_t * tokens_lengths_dim)
+{
+    if (max_candidates_per_batch < 1)
+        throw std::runtime_error("numpy_batch_decoder_decode: max_candidates_per_batch must be at least 1");
+
+    std::vector<size_t> seq_lens_vec = checked_seq_lens(seq_lens, seq_lens_dim_batch, batch_size, max_frames);
+
+    // The decoders read the probabilities straight from the numpy array
+    std::vector<std::vector<std::pair<float, Output> > > batch_results =
+        static_cast<CtcBeamSearchBatchDecoder*>(decoder)->decode(probs, seq_lens_vec, num_classes,
+            max_frames * num_classes, num_classes, 1);
+
+    fill_numpy_results(batch_results, max_candidates_per_batch,
+        tokens, tokens_dim, timesteps, timesteps_dim, scores, scores_dim, tokens_lengths, tokens_lengths_dim);
+}
+
+
+void numpy_batch_decoder_decode_fp16(
+        void* decoder,
+        const unsigned short * probs_fp16,  size_t batch_size, size_t max_frames, size_t num_classes,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        size_t max_candidates_per_batch,
+        int ** tokens, size_t * tokens_dim,
+        int ** timesteps, size_t * timesteps_dim,
+        float ** scores, size_t * scores_dim,
+        int ** tokens_lengths, size_t * tokens_lengths_dim)
+{
+    if (max_candidates_per_batch < 1)
+        throw std::runtime_error("numpy_batch_decoder_decode_fp16: max_candidates_per_batch must be at least 1");
+
+    std::vector<size_t> seq_lens_vec = checked_seq_lens(seq_lens, seq_lens_dim_batch, batch_size, max_frames);
+
+    // The decoders read the probabilities straight from the numpy array
+    std::vector<std::vector<std::pair<float, Output> > > batch_results =
+        static_cast<CtcBeamSearchBatchDecoder*>(decoder)->decode_fp16(probs_fp16, seq_lens_vec, num_classes,
+            max_frames * num_classes, num_classes, 1);
+
+    fill_numpy_results(batch_results, max_candidates_per_batch,
+        tokens, tokens_dim, timesteps, timesteps_dim, scores, scores_dim, tokens_lengths, tokens_lengths_dim);
+}
+
+void numpy_batch_decoder_decode_sparse(
+        void* decoder,
+        const int * class_ids,  size_t batch_size, size_t max_frames, size_t top_k,
+        const float * class_probs,  size_t class_probs_dim_batch, size_t class_probs_dim_frames,
+        size_t class_probs_dim_top_k,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        size_t max_candidates_per_batch,
+        int ** tokens, size_t * tokens_dim,
+        int ** timesteps, size_t * timesteps_dim,
+        float ** scores, size_t * scores_dim,
+        int ** tokens_lengths, size_t * tokens_lengths_dim)
+{
+    if (max_candidates_per_batch < 1)
+        throw std::runtime_error("numpy_batch_decoder_decode_sparse: max_candidates_per_batch must be at least 1");
+    if (class_probs_dim_batch != batch_size || class_probs_dim_frames != max_frames
+            || class_probs_dim_top_k != top_k)
+        throw std::runtime_error("numpy_batch_decoder_decode_sparse: class_ids and class_probs shapes differ");
+
+    std::vector<size_t> seq_lens_vec = checked_seq_lens(seq_lens, seq_lens_dim_batch, batch_size, max_frames);
+
+    // The decoders read the classes and the probabilities straight from the numpy arrays
+    std::vector<std::vector<std::pair<float, Output> > > batch_results =
+        static_cast<CtcBeamSearchBatchDecoder*>(decoder)->decode_sparse(class_ids, class_probs, seq_lens_vec, top_k,
+            max_frames * top_k, top_k);
+
+    fill_numpy_results(batch_results, max_candidates_per_batch,
+        tokens, tokens_dim, timesteps, timesteps_dim, scores, scores_dim, tokens_lengths, tokens_lengths_dim);
+}
+
+size_t numpy_batch_decoder_decode_into(
+        void* decoder,
+        const float * probs,  size_t batch_size, size_t max_frames, size_t num_classes,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        int * tokens_out, size_t tokens_dim_batch, size_t tokens_dim_candidates, size_t tokens_dim_len,
+        int * timesteps_out, size_t timesteps_dim_batch, size_t timesteps_dim_candidates, size_t timesteps_dim_len,
+        float * scores_out, size_t scores_dim_batch, size_t scores_dim_candidates,
+        int * tokens_lengths_out, size_t tokens_lengths_dim_batch, size_t tokens_lengths_dim_candidates)
+{
+    if (tokens_dim_candidates < 1)
+        throw std::runtime_error("numpy_batch_decoder_decode_into: output arrays must have at least 1 candidate");
+    if (tokens_dim_batch != batch_size || timesteps_dim_batch != batch_size || scores_dim_batch != batch_size
+            || tokens_lengths_dim_batch != batch_size)
+        throw std::runtime_error("numpy_batch_decoder_decode_into: probs and output arrays batch sizes differ");
+    if (timesteps_dim_candidates != tokens_dim_candidates || scores_dim_candidates != tokens_dim_candidates
+            || tokens_lengths_dim_candidates != tokens_dim_candidates || timesteps_dim_len != tokens_dim_len)
+        throw std::runtime_error("numpy_batch_decoder_decode_into: output arrays shapes differ");
+
+    std::vector<size_t> seq_lens_vec = checked_seq_lens(seq_lens, seq_lens_dim_batch, batch_size, max_frames);
+
+    std::vector<std::vector<std::pair<float, Output> > > batch_results =
+        static_cast<CtcBeamSearchBatchDecoder*>(decoder)->decode(probs, seq_lens_vec, num_classes,
+            max_frames * num_classes, num_classes, 1);
+
+    return write_results_into(batch_results, tokens_dim_candidates, tokens_dim_len,
+        tokens_out, timesteps_out, scores_out, tokens_lengths_out);
+}
+
+void* create_decoder_state(
+        const std::vector<std::string>& labels,
+        size_t beam_size,
+        float cutoff_prob,
+        size_t cutoff_top_n,
+        size_t blank_id,
+        bool log_input,
+        void *scorer)
+{
+    CtcBeamSearchDecoderState* state = new CtcBeamSearchDecoderState(labels, beam_size, cutoff_prob, cutoff_top_n,
+        blank_id, log_input, static_cast<ScorerBase *>(scorer));
+    return static_cast<void*>(state);
+}
+
+void delete_decoder_state(void* state) {
+    delete static_cast<CtcBeamSearchDecoderState*>(state);
+}
+
+void numpy_decoder_state_feed(void* state, const float * probs, size_t num_frames, size_t num_classes) {
+    // The probabilities are read straight from the numpy array
+    static_cast<CtcBeamSearchDecoderState*>(state)->feed(probs, num_frames, num_classes, num_classes, 1);
+}
+
+void numpy_decoder_state_feed_fp16(void* state, const unsigned short * probs_fp16, size_t num_frames,
+        size_t num_classes) {
+    // The probabilities are read straight from the numpy array
+    static_cast<CtcBeamSearchDecoderState*>(state)->feed_fp16(probs_fp16, num_frames, num_classes, num_classes, 1);
+}
+
+void numpy_decoder_state_feed_sparse(void* state, const int * class_ids, size_t num_frames, size_t top_k,
+        const float * class_probs, size_t class_probs_dim_frames, size_t class_probs_dim_top_k) {
+    if (class_probs_dim_frames != num_frames || class_probs_dim_top_k != top_k)
+        throw std::runtime_error("numpy_decoder_state_feed_sparse: class_ids and class_probs shapes differ");
+    static_cast<CtcBeamSearchDecoderState*>(state)->feed_sparse(class_ids, class_probs, num_frames, top_k, top_k);
+}
+
+void numpy_decoder_state_result(
+        void* state,
+        bool finalize,
+        size_t max_candidates,
+        int ** tokens, size_t * tokens_dim,
+        int ** timesteps, size_t * timesteps_dim,
+        float ** scores, size_t * scores_dim,
+        int ** tokens_lengths, size_t * tokens_lengths_dim)
+{
+    if (max_candidates < 1)
+        throw std::runtime_error("numpy_decoder_state_result: max_candidates must be at least 1");
+    CtcBeamSearchDecoderState* decoder_state = static_cast<CtcBeamSearchDecoderState*>(state);
+    std::vector<std::vector<std::pair<float, Output> > > batch_results(1,
+        finalize ? decoder_state->finalize() : decoder_state->partial_result());
+    fill_numpy_results(batch_results, max_candidates,
+        tokens, tokens_dim, timesteps, timesteps_dim, scores, scores_dim, tokens_lengths, tokens_lengths_dim);
+}
+
+
+size_t numpy_decoder_state_result_into(
+        void* state,
+        bool finalize,
+        int * tokens_out, size_t tokens_dim_candidates, size_t tokens_dim_len,
+        int * timesteps_out, size_t timesteps_dim_candidates, size_t timesteps_dim_len,
+        float * scores_out, size_t scores_dim_candidates,
+        int * tokens_lengths_out, size_t tokens_lengths_dim_candidates)
+{
+    if (tokens_dim_candidates < 1)
+        throw std::runtime_error("numpy_decoder_state_result_into: output arrays must have at least 1 candidate");
+    if (timesteps_dim_candidates != tokens_dim_candidates || scores_dim_candidates != tokens_dim_candidates
+            || tokens_lengths_dim_candidates != tokens_dim_candidates || timesteps_dim_len != tokens_dim_len)
+        throw std::runtime_error("numpy_decoder_state_result_into: output arrays shapes differ");
+    CtcBeamSearchDecoderState* decoder_state = static_cast<CtcBeamSearchDecoderState*>(state);
+    std::vector<std::vector<std::pair<float, Output> > > batch_results(1,
+        finalize ? decoder_state->finalize() : decoder_state->partial_result());
+    return write_results_into(batch_results, tokens_dim_candidates, tokens_dim_len,
+        tokens_out, timesteps_out, scores_out, tokens_lengths_out);
+}
+
 void* create_scorer_yoklm(
         double alpha,
         double beta,
         const std::string& lm_path,
-        const std::vector<std::string>& labels)
+        const std::vector<std::string>& labels,
+        const std::string& dictionary_path)
 {
-    ScorerBase* scorer = new ScorerYoklm(alpha, beta, lm_path, labels);
+    ScorerBase* scorer = new ScorerYoklm(alpha, beta, lm_path, labels, dictionary_path);
     return static_cast<void*>(scorer);
 }
 
@@ -207,3 +451,24 @@ void reset_params(void *scorer, double alpha, double beta){
     ScorerBase *ext_scorer  = static_cast<ScorerBase *>(scorer);
     ext_scorer->reset_params(alpha, beta);
 }
+
+namespace {
+ScorerYoklm* scorer_yoklm(void *scorer) {
+    ScorerYoklm *yoklm_scorer = dynamic_cast<ScorerYoklm *>(static_cast<ScorerBase *>(scorer));
+    if (yoklm_scorer == NULL)
+        throw std::runtime_error("The scorer isn't ScorerYoklm");
+    return yoklm_scorer;
+}
+}  // namespace
+
+void set_lm_cache_size(void *scorer, size_t memory_budget) {
+    scorer_yoklm(scorer)->set_lm_cache_size(memory_budget);
+}
+
+size_t get_lm_cache_hits(void *scorer) {
+    return scorer_yoklm(scorer)->lm_cache_stats().hits;
+}
+
+size_t get_lm_cache_lookups(void *scorer) {
+    return scorer_yoklm(scorer)->lm_cache_stats().lookups;
+}
@@ -41,11 +41,121 @@ void numpy_beam_decode_no_lm(
         float ** scores, size_t * scores_dim,  // to be reshaped to (batch_size, beam_size)
         int ** tokens_lengths, size_t * tokens_lengths_dim);  // to be reshaped to (batch_size, beam_size)
 
+// Batch decoding with threads kept between the batches
+void* create_batch_decoder(
+        const std::vector<std::string>& labels,
+        size_t beam_size,
+        size_t num_processes,
+        float cutoff_prob,
+        size_t cutoff_top_n,
+        size_t blank_id,
+        bool log_input,
+        void *scorer);  // may be NULL, must outlive the decoder
+
+void delete_batch_decoder(void* decoder);
+
+// The same as numpy_beam_decode() with the parameters of the decoder
+void numpy_batch_decoder_decode(
+        void* decoder,
+        const float * probs,  size_t batch_size, size_t max_frames, size_t num_classes,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        size_t max_candidates_per_batch,  // limits candidates returned from beam search, must not exceed beam_size
+        // Output arrays (SWIG memory managed argout, malloc() allocator):
+        int ** tokens, size_t * tokens_dim,  // to be reshaped to (batch_size, max_candidates_per_batch, -1)
+        int ** timesteps, size_t * timesteps_dim,  // to be reshaped to (batch_size, max_candidates_per_batch, -1)
+        float ** scores, size_t * scores_dim,  // to be reshaped to (batch_size, max_candidates_per_batch)
+        int ** tokens_lengths, size_t * tokens_lengths_dim);  // to be reshaped to (batch_size, max_candidates_per_batch)
+
+// The same as numpy_batch_decoder_decode() for numpy.float16 probabilities, which are converted one time step at a time
+void numpy_batch_decoder_decode_fp16(
+        void* decoder,
+        const unsigned short * probs_fp16,  size_t batch_size, size_t max_frames, size_t num_classes,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        size_t max_candidates_per_batch,  // limits candidates returned from beam search, must not exceed beam_size
+        // Output arrays (SWIG memory managed argout, malloc() allocator):
+        int ** tokens, size_t * tokens_dim,  // to be reshaped to (batch_size, max_candidates_per_batch, -1)
+        int ** timesteps, size_t * timesteps_dim,  // to be reshaped to (batch_size, max_candidates_per_batch, -1)
+        float ** scores, size_t * scores_dim,  // to be reshaped to (batch_size, max_candidates_per_batch)
+        int ** tokens_lengths, size_t * tokens_lengths_dim);  // to be reshaped to (batch_size, max_candidates_per_batch)
+
+// The same as numpy_batch_decoder_decode() for the sparse probabilities, e.g. the outputs of a TopK layer appended
+// to the model: the probability of the class class_ids[b, t, k] at the time step t of the sample b is
+// class_probs[b, t, k], the other classes are pruned
+void numpy_batch_decoder_decode_sparse(
+        void* decoder,
+        const int * class_ids,  size_t batch_size, size_t max_frames, size_t top_k,
+        const float * class_probs,  size_t class_probs_dim_batch, size_t class_probs_dim_frames,
+        size_t class_probs_dim_top_k,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        size_t max_candidates_per_batch,  // limits candidates returned from beam search, must not exceed beam_size
+        // Output arrays (SWIG memory managed argout, malloc() allocator):
+        int ** tokens, size_t * tokens_dim,  // to be reshaped to (batch_size, max_candidates_per_batch, -1)
+        int ** timesteps, size_t * timesteps_dim,  // to be reshaped to (batch_size, max_candidates_per_batch, -1)
+        float ** scores, size_t * scores_dim,  // to be reshaped to (batch_size, max_candidates_per_batch)
+        int ** tokens_lengths, size_t * tokens_lengths_dim);  // to be reshaped to (batch_size, max_candidates_per_batch)
+
+// The same as numpy_batch_decoder_decode(), but the results are written into the arrays of the caller, which can be
+// reused between the calls instead of allocating the outputs every time. The number of candidates is given by
+// the arrays. Returns the length of the longest candidate, the tokens after the length of every candidate
+// are left as they were. Throws if the arrays are too short, the length of max_frames is always enough.
+size_t numpy_batch_decoder_decode_into(
+        void* decoder,
+        const float * probs,  size_t batch_size, size_t max_frames, size_t num_classes,
+        const int * seq_lens,  size_t seq_lens_dim_batch,
+        // Output arrays (numpy arrays of the caller):
+        int * tokens_out, size_t tokens_dim_batch, size_t tokens_dim_candidates, size_t tokens_dim_len,
+        int * timesteps_out, size_t timesteps_dim_batch, size_t timesteps_dim_candidates, size_t timesteps_dim_len,
+        float * scores_out, size_t scores_dim_batch, size_t scores_dim_candidates,
+        int * tokens_lengths_out, size_t tokens_lengths_dim_batch, size_t tokens_lengths_dim_candidates);
+
+// Streaming decoding: the state is fed with (num_frames, num_classes) arrays of an utterance
+void* create_decoder_state(
+        const std::vector<std::string>& labels,
+        size_t beam_size,
+        float cutoff_prob,
+        size_t cutoff_top_n,
+        size_t blank_id,
+        bool log_input,
+        void *scorer);  // may be NULL, must outlive the state
+
+void delete_decoder_state(void* state);
+
+void numpy_decoder_state_feed(void* state, const float * probs, size_t num_frames, size_t num_classes);
+
+void numpy_decoder_state_feed_fp16(void* state, const unsigned short * probs_fp16, size_t num_frames, size_t num_classes);
+
+// Feeds (num_frames, top_k) arrays of the classes and their probabilities, see numpy_batch_decoder_decode_sparse()
+void numpy_decoder_state_feed_sparse(void* state, const int * class_ids, size_t num_frames, size_t top_k,
+        const float * class_probs, size_t class_probs_dim_frames, size_t class_probs_dim_top_k);
+
+// Returns the partial results, or the final ones if finalize is true (the state can't be used after that)
+void numpy_decoder_state_result(
+        void* state,
+        bool finalize,
+        size_t max_candidates,
+        // Output arrays (SWIG memory managed argout, malloc() allocator):
+        int ** tokens, size_t * tokens_dim,  // to be reshaped to (max_candidates, -1)
+        int ** timesteps, size_t * timesteps_dim,  // to be reshaped to (max_candidates, -1)
+        float ** scores, size_t * scores_dim,  // to be reshaped to (max_candidates,)
+        int ** tokens_lengths, size_t * tokens_lengths_dim);  // to be reshaped to (max_candidates,)
+
+// The same as numpy_decoder_state_result() writing into the arrays of the caller, see numpy_batch_decoder_decode_into().
+// The length of the number of frames fed is always enough
+size_t numpy_decoder_state_result_into(
+        void* state,
+        bool finalize,
+        // Output arrays (numpy arrays of the caller):
+        int * tokens_out, size_t tokens_dim_candidates, size_t tokens_dim_len,
+        int * timesteps_out, size_t timesteps_dim_candidates, size_t timesteps_dim_len,
+        float * scores_out, size_t scores_dim_candidates,
+        int * tokens_lengths_out, size_t tokens_lengths_dim_candidates);
+
 void* create_scorer_yoklm(
         double alpha,
         double beta,
         const std::string& lm_path,
-        const std::vector<std::string>& labels);
+        const std::vector<std::string>& labels,
+        const std::string& dictionary_path);  // may be empty, see ScorerBase::setup()
 
 void delete_scorer(void* scorer);
 
@@ -53,3 +163,8 @@ int is_character_based(void *scorer);
 size_t get_max_order(void *scorer);
 size_t get_dict_size(void *scorer);
 void reset_params(void *scorer, double alpha, double beta);
+
+// The cache of the n-gram queries of a ScorerYoklm shared by the decoding threads, see ScorerYoklm::set_lm_cache_size()
+void set_lm_cache_size(void *scorer, size_t memory_budget);
+size_t get_lm_cache_hits(void *scorer);
+size_t get_lm_cache_lookups(void *scorer);
@@ -9,16 +9,33 @@
 #include "ctc_beam_search_decoder.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <numeric>
 #include <utility>
 
+#include "decoder_profile.h"
 #include "decoder_utils.h"
 #include "ThreadPool.h"
 #include "path_trie.h"
 
+namespace {
+// The order the samples of a batch are decoded in: the longest ones first,
+// so the pool threads don't wait for a long sample taken last by one of them
+std::vector<size_t> longest_first_order(const std::vector<size_t> &seq_lens) {
+  std::vector<size_t> order(seq_lens.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return seq_lens[a] > seq_lens[b];
+  });
+  return order;
+}
+}  // namespace
+
 std::vector<std::pair<float, Output>> ctc_beam_search_decoder(
     const std::vector<std::vector<float>> &probs_seq,
     const std::vector<std::string> &vocabulary,
@@ -37,129 +54,327 @@ std::vector<std::pair<float, Output>> ctc_beam_search_decoder(
                    "the shape of the vocabulary");
   }
 
-  // assign blank id
-  // size_t blank_id = vocabulary.size();
+  std::vector<float> probs;
+  probs.reserve(num_time_steps * vocabulary.size());
+  for (auto &probs_step : probs_seq) {
+    probs.insert(probs.end(), probs_step.begin(), probs_step.end());
+  }
+  return ctc_beam_search_decoder_strided(probs.data(),
+                                         num_time_steps,
+                                         vocabulary.size(),
+                                         vocabulary.size(),
+                                         1,
+                                         vocabulary,
+                                         beam_size,
+                                         cutoff_prob,
+                                         cutoff_top_n,
+                                         blank_id,
+                                         log_input,
+                                         ext_scorer);
+}
+
+
+std::vector<std::pair<float, Output>> ctc_beam_search_decoder_strided(
+    const float *probs,
+    size_t num_time_steps,
+    size_t num_classes,
+    size_t time_stride,
+    size_t class_stride,
+    const std::vector<std::string> &vocabulary,
+    size_t beam_size,
+    float cutoff_prob,
+    size_t cutoff_top_n,
+    size_t blank_id,
+    int log_input,
+    ScorerBase *ext_scorer) {
+  CtcBeamSearchDecoderState state(vocabulary,
+                                  beam_size,
+                                  cutoff_prob,
+                                  cutoff_top_n,
+                                  blank_id,
+                                  log_input,
+                                  ext_scorer);
+  state.feed(probs, num_time_steps, num_classes, time_stride, class_stride);
+  return state.finalize();
+}
+
+
+CtcBeamSearchDecoderState::CtcBeamSearchDecoderState(
+    const std::vector<std::string> &vocabulary,
+    size_t beam_size,
+    float cutoff_prob,
+    size_t cutoff_top_n,
+    size_t blank_id,
+    int log_input,
+    ScorerBase *ext_scorer)
+    : vocabulary_(vocabulary),
+      beam_size_(beam_size),
+      cutoff_prob_(cutoff_prob),
+      cutoff_top_n_(cutoff_top_n),
+      blank_id_(blank_id),
+      log_input_(log_input),
+      ext_scorer_(ext_scorer),
+      num_time_steps_(0),
+      is_finalized_(false) {
+  VALID_CHECK_GT(beam_size, 0, "beam_size must be positive!");
 
   // assign space id
   auto it = std::find(vocabulary.begin(), vocabulary.end(), " ");
-  int space_id = int(it - vocabulary.begin());
+  space_id_ = int(it - vocabulary.begin());
   // if no space in vocabulary
-  if ((size_t)space_id >= vocabulary.size()) {
-    space_id = -2;
+  if ((size_t)space_id_ >= vocabulary.size()) {
+    space_id_ = -2;
   }
 
+  init_root();
+}
+
+void CtcBeamSearchDecoderState::reset() {
+  root_.clear();
+  prefixes_.clear();
+  init_root();
+  num_time_steps_ = 0;
+  is_finalized_ = false;
+}
+
+void CtcBeamSearchDecoderState::init_root() {
   // init prefixes' root
-  PathTrie root;
-  root.score = root.log_prob_b_prev = 0.0;
-  std::vector<PathTrie *> prefixes;
-  prefixes.push_back(&root);
+  root_.score = root_.log_prob_b_prev = 0.0;
+  prefixes_.push_back(&root_);
 
-  if (ext_scorer != nullptr && !ext_scorer->is_character_based()) {
-    WordPrefixSet *dict_ptr = ext_scorer->dictionary.get();
-    root.set_dictionary(dict_ptr);
+  if (ext_scorer_ != nullptr && !ext_scorer_->is_character_based()) {
+    WordPrefixSet *dict_ptr = ext_scorer_->dictionary.get();
+    root_.set_dictionary(dict_ptr);
   }
+}
 
-  // prefix search over time
-  for (size_t time_step = 0; time_step < num_time_steps; ++time_step) {
-    auto &prob = probs_seq[time_step];
 
-    float min_cutoff = -NUM_FLT_INF;
-    bool full_beam = false;
-    if (ext_scorer != nullptr) {
-      size_t num_prefixes = std::min(prefixes.size(), beam_size);
+void CtcBeamSearchDecoderState::feed(const float *probs,
+                                     size_t num_time_steps,
+                                     size_t num_classes,
+                                     size_t time_stride,
+                                     size_t class_stride) {
+  VALID_CHECK(!is_finalized_, "The decoder state is already finalized");
+  // dimension check
+  VALID_CHECK_EQ(num_classes,
+                 vocabulary_.size(),
+                 "The shape of probs does not match with "
+                 "the shape of the vocabulary");
+
+  // prefix search over time, the time steps of the chunk continue the previous ones
+  for (size_t chunk_step = 0; chunk_step < num_time_steps; ++chunk_step) {
+    feed_step(probs + chunk_step * time_stride, num_classes, class_stride);
+  }
+}
+
+
+void CtcBeamSearchDecoderState::feed_fp16(const uint16_t *probs,
+                                          size_t num_time_steps,
+                                          size_t num_classes,
+                                          size_t time_stride,
+                                          size_t class_stride) {
+  VALID_CHECK(!is_finalized_, "The decoder state is already finalized");
+  // dimension check
+  VALID_CHECK_EQ(num_classes,
+                 vocabulary_.size(),
+                 "The shape of probs does not match with "
+                 "the shape of the vocabulary");
+
+  step_probs_.resize(num_classes);
+  for (size_t chunk_step = 0; chunk_step < num_time_steps; ++chunk_step) {
+    {
+      DECODER_PHASE_SCOPE(PHASE_PRUNING);
+      half_to_float(probs + chunk_step * time_stride, num_classes, class_stride, step_probs_.data());
+    }
+    feed_step(step_probs_.data(), num_classes, 1);
+  }
+}
+
+
+void CtcBeamSearchDecoderState::feed_step(const float *prob,
+                                          size_t num_classes,
+                                          size_t class_stride) {
+  float blank_log_prob = log_input_ ? prob[blank_id_ * class_stride]
+                                    : std::log(prob[blank_id_ * class_stride]);
+  std::vector<std::pair<size_t, float>> log_prob_idx;
+  {
+    DECODER_PHASE_SCOPE(PHASE_PRUNING);
+    log_prob_idx = get_pruned_log_probs(prob, num_classes, class_stride,
+                                        cutoff_prob_, cutoff_top_n_, log_input_);
+  }
+  advance(log_prob_idx, blank_log_prob);
+}
+
+
+void CtcBeamSearchDecoderState::feed_sparse(const int *class_ids,
+                                            const float *probs,
+                                            size_t num_time_steps,
+                                            size_t top_k,
+                                            size_t time_stride) {
+  VALID_CHECK(!is_finalized_, "The decoder state is already finalized");
+
+  for (size_t chunk_step = 0; chunk_step < num_time_steps; ++chunk_step) {
+    const int *step_class_ids = class_ids + chunk_step * time_stride;
+    const float *prob = probs + chunk_step * time_stride;
+    // the blank is less probable than all the given classes if it isn't
+    // among them, so the beams aren't cut by its probability then
+    float blank_log_prob = -NUM_FLT_INF;
+    for (size_t k = 0; k < top_k; ++k) {
+      if (size_t(step_class_ids[k]) == blank_id_) {
+        blank_log_prob = log_input_ ? prob[k] : std::log(prob[k]);
+      }
+    }
+    std::vector<std::pair<size_t, float>> log_prob_idx;
+    {
+      DECODER_PHASE_SCOPE(PHASE_PRUNING);
+      log_prob_idx = get_pruned_log_probs_sparse(step_class_ids, prob, top_k, vocabulary_.size(),
+                                                 cutoff_prob_, cutoff_top_n_, log_input_);
+    }
+    advance(log_prob_idx, blank_log_prob);
+  }
+}
+
+
+void CtcBeamSearchDecoderState::advance(
+    const std::vector<std::pair<size_t, float>> &log_prob_idx,
+    float blank_log_prob) {
+  const size_t time_step = num_time_steps_;
+  const size_t beam_size = beam_size_;
+  const size_t blank_id = blank_id_;
+  ScorerBase *ext_scorer = ext_scorer_;
+  std::vector<PathTrie *> &prefixes = prefixes_;
+
+  float min_cutoff = -NUM_FLT_INF;
+  bool full_beam = false;
+  if (ext_scorer != nullptr) {
+    size_t num_prefixes = std::min(prefixes.size(), beam_size);
+    {
+      DECODER_PHASE_SCOPE(PHASE_SORTING);
       std::sort(
           prefixes.begin(), prefixes.begin() + num_prefixes, prefix_compare);
-      float blank_prob = log_input ? prob[blank_id] : std::log(prob[blank_id]);
-      min_cutoff = prefixes[num_prefixes - 1]->score +
-                   blank_prob - std::max(0.0, ext_scorer->beta);
-      full_beam = (num_prefixes == beam_size);
     }
+    min_cutoff = prefixes[num_prefixes - 1]->score +
+                 blank_log_prob - std::max(0.0, ext_scorer->beta);
+    full_beam = (num_prefixes == beam_size);
+  }
 
-    std::vector<std::pair<size_t, float>> log_prob_idx =
-        get_pruned_log_probs(prob, cutoff_prob, cutoff_top_n, log_input);
-    // loop over chars
-    for (size_t index = 0; index < log_prob_idx.size(); index++) {
-      auto c = log_prob_idx[index].first;
-      auto log_prob_c = log_prob_idx[index].second;
-
-      for (size_t i = 0; i < prefixes.size() && i < beam_size; ++i) {
-        auto prefix = prefixes[i];
-        if (full_beam && log_prob_c + prefix->score < min_cutoff) {
-          break;
-        }
-        // blank
-        if (c == blank_id) {
-          prefix->log_prob_b_cur =
-              log_sum_exp(prefix->log_prob_b_cur, log_prob_c + prefix->score);
-          continue;
-        }
-        // repeated character
-        if (c == size_t(prefix->character)) {
-          prefix->log_prob_nb_cur = log_sum_exp(
-              prefix->log_prob_nb_cur, log_prob_c + prefix->log_prob_nb_prev);
-        }
-        // get new prefix
-        auto prefix_new = prefix->get_path_trie(c, time_step, log_prob_c);
+  // loop over chars
+  for (size_t index = 0; index < log_prob_idx.size(); index++) {
+    auto c = log_prob_idx[index].first;
+    auto log_prob_c = log_prob_idx[index].second;
+
+    for (size_t i = 0; i < prefixes.size() && i < beam_size; ++i) {
+      auto prefix = prefixes[i];
+      if (full_beam && log_prob_c + prefix->score < min_cutoff) {
+        break;
+      }
+      // blank
+      if (c == blank_id) {
+        prefix->log_prob_b_cur =
+            log_sum_exp(prefix->log_prob_b_cur, log_prob_c + prefix->score);
+        continue;
+      }
+      // repeated character
+      if (c == size_t(prefix->character)) {
+        prefix->log_prob_nb_cur = log_sum_exp(
+            prefix->log_prob_nb_cur, log_prob_c + prefix->log_prob_nb_prev);
+      }
+      // get new prefix
+      PathTrie *prefix_new;
+      {
+        DECODER_PHASE_SCOPE(PHASE_TRIE_EXTENSION);
+        prefix_new = prefix->get_path_trie(c, time_step, log_prob_c);
+      }
 
-        if (prefix_new != nullptr) {
-          float log_p = -NUM_FLT_INF;
+      if (prefix_new != nullptr) {
+        float log_p = -NUM_FLT_INF;
 
-          if (c == size_t(prefix->character) &&
-              prefix->log_prob_b_prev > -NUM_FLT_INF) {
-            log_p = log_prob_c + prefix->log_prob_b_prev;
-          } else if (c != size_t(prefix->character)) {
-            log_p = log_prob_c + prefix->score;
+        if (c == size_t(prefix->character) &&
+            prefix->log_prob_b_prev > -NUM_FLT_INF) {
+          log_p = log_prob_c + prefix->log_prob_b_prev;
+        } else if (c != size_t(prefix->character)) {
+          log_p = log_prob_c + prefix->score;
+        }
+
+        // language model scoring
+        if (ext_scorer != nullptr &&
+            (c == size_t(space_id_) || ext_scorer->is_character_based())) {
+          PathTrie *prefix_to_score = nullptr;
+          // skip scoring the space
+          if (ext_scorer->is_character_based()) {
+            prefix_to_score = prefix_new;
+          } else {
+            prefix_to_score = prefix;
           }
 
-          // language model scoring
-          if (ext_scorer != nullptr &&
-              (c == size_t(space_id) || ext_scorer->is_character_based())) {
-            PathTrie *prefix_to_score = nullptr;
-            // skip scoring the space
-            if (ext_scorer->is_character_based()) {
-              prefix_to_score = prefix_new;
-            } else {
-              prefix_to_score = prefix;
-            }
-
-            float score = 0.0;
-            std::vector<std::string> ngram;
-            ngram = ext_scorer->make_ngram(prefix_to_score);
-            score = ext_scorer->get_log_cond_prob(ngram) * ext_scorer->alpha;
-            log_p += score;
-            log_p += ext_scorer->beta;
+          float score = 0.0;
+          {
+            DECODER_PHASE_SCOPE(PHASE_LM_SCORING);
+            score = ext_scorer->get_log_cond_prob(prefix_to_score) * ext_scorer->alpha;
           }
-          prefix_new->log_prob_nb_cur =
-              log_sum_exp(prefix_new->log_prob_nb_cur, log_p);
+          log_p += score;
+          log_p += ext_scorer->beta;
         }
-      }  // end of loop over prefix
-    }    // end of loop over vocabulary
+        prefix_new->log_prob_nb_cur =
+            log_sum_exp(prefix_new->log_prob_nb_cur, log_p);
+      }
+    }  // end of loop over prefix
+  }    // end of loop over vocabulary
 
 
-    prefixes.clear();
+  prefixes.clear();
+  {
+    DECODER_PHASE_SCOPE(PHASE_TRIE_EXTENSION);
     // update log probs
-    root.iterate_to_vec(prefixes);
+    root_.iterate_to_vec(prefixes);
+  }
 
-    // only preserve top beam_size prefixes
-    if (prefixes.size() >= beam_size) {
+  // only preserve top beam_size prefixes
+  if (prefixes.size() >= beam_size) {
+    {
+      DECODER_PHASE_SCOPE(PHASE_SORTING);
       std::nth_element(prefixes.begin(),
                        prefixes.begin() + beam_size,
                        prefixes.end(),
                        prefix_compare);
-      for (size_t i = beam_size; i < prefixes.size(); ++i) {
-        prefixes[i]->remove();
-      }
     }
-  }  // end of loop over time
+    DECODER_PHASE_SCOPE(PHASE_TRIE_EXTENSION);
+    for (size_t i = beam_size; i < prefixes.size(); ++i) {
+      prefixes[i]->remove();
+    }
+    prefixes.resize(beam_size);
+  }
+  ++num_time_steps_;
+}
+
+
+std::vector<std::pair<float, Output>>
+CtcBeamSearchDecoderState::partial_result() {
+  // The prefixes aren't changed, so the results are ordered by the scores without the last words
+  std::vector<PathTrie *> prefixes(prefixes_);
+  for (auto prefix : prefixes) {
+    prefix->approx_ctc = prefix->score;
+  }
+  return get_beam_search_result(prefixes, beam_size_);
+}
+
+
+std::vector<std::pair<float, Output>> CtcBeamSearchDecoderState::finalize() {
+  VALID_CHECK(!is_finalized_, "The decoder state is already finalized");
+  is_finalized_ = true;
+
+  const size_t beam_size = beam_size_;
+  ScorerBase *ext_scorer = ext_scorer_;
+  std::vector<PathTrie *> &prefixes = prefixes_;
 
   // score the last word of each prefix that doesn't end with space
   if (ext_scorer != nullptr && !ext_scorer->is_character_based()) {
     for (size_t i = 0; i < beam_size && i < prefixes.size(); ++i) {
       auto prefix = prefixes[i];
-      if (!prefix->is_empty() && prefix->character != space_id) {
+      if (!prefix->is_empty() && prefix->character != space_id_) {
+        DECODER_PHASE_SCOPE(PHASE_LM_SCORING);
         float score = 0.0;
-        std::vector<std::string> ngram = ext_scorer->make_ngram(prefix);
-        score = ext_scorer->get_log_cond_prob(ngram) * ext_scorer->alpha;
+        score = ext_scorer->get_log_cond_prob(prefix) * ext_scorer->alpha;
         score += ext_scorer->beta;
         prefix->score += score;
       }
@@ -167,7 +382,10 @@ std::vector<std::pair<float, Output>> ctc_beam_search_decoder(
   }
 
   size_t num_prefixes = std::min(prefixes.size(), beam_size);
-  std::sort(prefixes.begin(), prefixes.begin() + num_prefixes, prefix_compare);
+  {
+    DECODER_PHASE_SCOPE(PHASE_SORTING);
+    std::sort(prefixes.begin(), prefixes.begin() + num_prefixes, prefix_compare);
+  }
 
   // compute approximate ctc score as the return score, without affecting the
   // return order of decoding result. To delete when decoder gets stable.
@@ -208,18 +426,23 @@ ctc_beam_search_decoder_batch(
   // number of samples
   size_t batch_size = probs_split.size();
 
-  // enqueue the tasks of decoding
-  std::vector<std::future<std::vector<std::pair<float, Output>>>> res;
-  for (size_t i = 0; i < batch_size; ++i) {
-    res.emplace_back(pool.enqueue(ctc_beam_search_decoder,
-                                  probs_split[i],
-                                  vocabulary,
-                                  beam_size,
-                                  cutoff_prob,
-                                  cutoff_top_n,
-                                  blank_id,
-                                  log_input,
-                                  ext_scorer));
+  // enqueue the tasks of decoding, they read their samples in place
+  std::vector<size_t> seq_lens;
+  for (const auto &probs_seq : probs_split) {
+    seq_lens.push_back(probs_seq.size());
+  }
+  std::vector<std::future<std::vector<std::pair<float, Output>>>> res(batch_size);
+  for (size_t i : longest_first_order(seq_lens)) {
+    res[i] = pool.enqueue([=, &probs_split, &vocabulary]() {
+      return ctc_beam_search_decoder(probs_split[i],
+                                     vocabulary,
+                                     beam_size,
+                                     cutoff_prob,
+                                     cutoff_top_n,
+                                     blank_id,
+                                     log_input,
+                                     ext_scorer);
+    });
   }
 
   // get decoding results
@@ -229,3 +452,146 @@ ctc_beam_search_decoder_batch(
   }
   return batch_results;
 }
+
+
+std::vector<std::vector<std::pair<float, Output>>>
+ctc_beam_search_decoder_batch_strided(
+    const float *probs,
+    const std::vector<size_t> &seq_lens,
+    size_t num_classes,
+    size_t batch_stride,
+    size_t time_stride,
+    size_t class_stride,
+    const std::vector<std::string> &vocabulary,
+    size_t beam_size,
+    size_t num_processes,
+    float cutoff_prob,
+    size_t cutoff_top_n,
+    size_t blank_id,
+    int log_input,
+    ScorerBase *ext_scorer) {
+  CtcBeamSearchBatchDecoder decoder(vocabulary,
+                                    beam_size,
+                                    num_processes,
+                                    cutoff_prob,
+                                    cutoff_top_n,
+                                    blank_id,
+                                    log_input,
+                                    ext_scorer);
+  return decoder.decode(
+      probs, seq_lens, num_classes, batch_stride, time_stride, class_stride);
+}
+
+
+CtcBeamSearchBatchDecoder::CtcBeamSearchBatchDecoder(
+    const std::vector<std::string> &vocabulary,
+    size_t beam_size,
+    size_t num_processes,
+    float cutoff_prob,
+    size_t cutoff_top_n,
+    size_t blank_id,
+    int log_input,
+    ScorerBase *ext_scorer) {
+  VALID_CHECK_GT(num_processes, 0, "num_processes must be nonnegative!");
+  for (size_t i = 0; i < num_processes; ++i) {
+    states_.emplace_back(new CtcBeamSearchDecoderState(vocabulary,
+                                                       beam_size,
+                                                       cutoff_prob,
+                                                       cutoff_top_n,
+                                                       blank_id,
+                                                       log_input,
+                                                       ext_scorer));
+  }
+  // thread pool
+  pool_.reset(new ThreadPool(num_processes));
+}
+
+CtcBeamSearchBatchDecoder::~CtcBeamSearchBatchDecoder() {
+  // The threads are joined by the pool
+}
+
+std::vector<std::vector<std::pair<float, Output>>>
+CtcBeamSearchBatchDecoder::decode(const float *probs,
+                                  const std::vector<size_t> &seq_lens,
+                                  size_t num_classes,
+                                  size_t batch_stride,
+                                  size_t time_stride,
+                                  size_t class_stride) {
+  return decode_samples(seq_lens, [&](CtcBeamSearchDecoderState *state, size_t b) {
+    state->feed(probs + b * batch_stride,
+                seq_lens[b],
+                num_classes,
+                time_stride,
+                class_stride);
+  });
+}
+
+std::vector<std::vector<std::pair<float, Output>>>
+CtcBeamSearchBatchDecoder::decode_fp16(const uint16_t *probs,
+                                       const std::vector<size_t> &seq_lens,
+                                       size_t num_classes,
+                                       size_t batch_stride,
+                                       size_t time_stride,
+                                       size_t class_stride) {
+  return decode_samples(seq_lens, [&](CtcBeamSearchDecoderState *state, size_t b) {
+    state->feed_fp16(probs + b * batch_stride,
+                     seq_lens[b],
+                     num_classes,
+                     time_stride,
+                     class_stride);
+  });
+}
+
+std::vector<std::vector<std::pair<float, Output>>>
+CtcBeamSearchBatchDecoder::decode_sparse(const int *class_ids,
+                                         const float *probs,
+                                         const std::vector<size_t> &seq_lens,
+                                         size_t top_k,
+                                         size_t batch_stride,
+                                         size_t time_stride) {
+  return decode_samples(seq_lens, [&](CtcBeamSearchDecoderState *state, size_t b) {
+    state->feed_sparse(class_ids + b * batch_stride,
+                       probs + b * batch_stride,
+                       seq_lens[b],
+                       top_k,
+                       time_stride);
+  });
+}
+
+std::vector<std::vector<std::pair<float, Output>>>
+CtcBeamSearchBatchDecoder::decode_samples(
+    const std::vector<size_t> &seq_lens,
+    const std::function<void(CtcBeamSearchDecoderState *, size_t)> &feed) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // number of samples
+  size_t batch_size = seq_lens.size();
+  std::vector<std::vector<std::pair<float, Output>>> batch_results(batch_size);
+
+  // enqueue a task for every state, the tasks decode the samples in place
+  // and put the results to batch_results, taking the samples one by one,
+  // the longest ones first
+  const std::vector<size_t> order = longest_first_order(seq_lens);
+  std::atomic<size_t> next_sample(0);
+  std::vector<std::future<void>> res;
+  for (size_t i = 0; i < states_.size() && i < batch_size; ++i) {
+    CtcBeamSearchDecoderState *state = states_[i].get();
+    res.emplace_back(pool_->enqueue([&, state]() {
+      for (size_t n = next_sample++; n < batch_size; n = next_sample++) {
+        const size_t b = order[n];
+        state->reset();
+        feed(state, b);
+        batch_results[b] = state->finalize();
+      }
+    }));
+  }
+
+  // all the tasks refer to the batch, so they are done before an exception
+  // of any of them is rethrown
+  for (auto &r : res) {
+    r.wait();
+  }
+  for (auto &r : res) {
+    r.get();
+  }
+  return batch_results;
+}
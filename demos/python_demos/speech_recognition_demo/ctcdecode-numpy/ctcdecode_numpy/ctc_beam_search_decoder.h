@@ -9,12 +9,19 @@
 #ifndef CTC_BEAM_SEARCH_DECODER_H_
 #define CTC_BEAM_SEARCH_DECODER_H_
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "scorer_base.h"
 #include "output.h"
+#include "path_trie.h"
+
+class ThreadPool;
 
 /* CTC Beam Search Decoder
 
@@ -43,6 +50,119 @@ std::vector<std::pair<float, Output>> ctc_beam_search_decoder(
     int log_input = 0,
     ScorerBase *ext_scorer = nullptr);
 
+/* CTC Beam Search Decoder reading the probabilities in place
+
+ * Parameters:
+ *     probs: The probability of the class c at the time step t is
+ *            probs[t * time_stride + c * class_stride].
+ *     num_time_steps: The number of time steps to decode.
+ *     num_classes: The number of classes, it must match the vocabulary.
+ *     The other parameters are the same as in ctc_beam_search_decoder().
+ * Return:
+ *     The same as ctc_beam_search_decoder().
+*/
+
+std::vector<std::pair<float, Output>> ctc_beam_search_decoder_strided(
+    const float *probs,
+    size_t num_time_steps,
+    size_t num_classes,
+    size_t time_stride,
+    size_t class_stride,
+    const std::vector<std::string> &vocabulary,
+    size_t beam_size,
+    float cutoff_prob = 1.0,
+    size_t cutoff_top_n = 40,
+    size_t blank_id = 0,
+    int log_input = 0,
+    ScorerBase *ext_scorer = nullptr);
+
+/* CTC Beam Search Decoder state for streaming data
+
+ * The probabilities of an utterance are fed chunk by chunk and the beams are
+ * advanced by the new time steps only, so decoding a growing utterance costs
+ * as much as decoding it at once. The parameters of the constructor are the
+ * same as in ctc_beam_search_decoder(), the vocabulary is copied and
+ * ext_scorer must outlive the state.
+*/
+class CtcBeamSearchDecoderState {
+public:
+  CtcBeamSearchDecoderState(const std::vector<std::string> &vocabulary,
+                            size_t beam_size,
+                            float cutoff_prob = 1.0,
+                            size_t cutoff_top_n = 40,
+                            size_t blank_id = 0,
+                            int log_input = 0,
+                            ScorerBase *ext_scorer = nullptr);
+  CtcBeamSearchDecoderState(const CtcBeamSearchDecoderState &) = delete;
+  CtcBeamSearchDecoderState &operator=(const CtcBeamSearchDecoderState &) = delete;
+
+  // Advances the beams, probs are the same as in ctc_beam_search_decoder_strided()
+  void feed(const float *probs,
+            size_t num_time_steps,
+            size_t num_classes,
+            size_t time_stride,
+            size_t class_stride);
+
+  // The same as feed() for half precision (IEEE 754 binary16) probabilities,
+  // which are converted to float one time step at a time
+  void feed_fp16(const uint16_t *probs,
+                 size_t num_time_steps,
+                 size_t num_classes,
+                 size_t time_stride,
+                 size_t class_stride);
+
+  // Advances the beams by the sparse probabilities of the time steps, e.g. the
+  // top classes selected by a TopK layer of the model, so the decoder doesn't
+  // scan the whole vocabulary: the probability of the class
+  // class_ids[t * time_stride + k] at the time step t is
+  // probs[t * time_stride + k], k < top_k. The other classes are pruned and
+  // cutoff_prob and cutoff_top_n are applied to the given ones
+  void feed_sparse(const int *class_ids,
+                   const float *probs,
+                   size_t num_time_steps,
+                   size_t top_k,
+                   size_t time_stride);
+
+  // The current results, the last words of the prefixes aren't scored by ext_scorer
+  std::vector<std::pair<float, Output>> partial_result();
+
+  // Scores the last words and returns the results of the utterance,
+  // the state can't be fed or finalized after it
+  std::vector<std::pair<float, Output>> finalize();
+
+  // Starts a new utterance, the nodes of the previous prefixes are kept
+  // for the new ones
+  void reset();
+
+  size_t num_time_steps() const { return num_time_steps_; }
+
+private:
+  // Makes the root the only prefix
+  void init_root();
+
+  // Prunes the classes of the next time step and extends the prefixes by them
+  void feed_step(const float *prob, size_t num_classes, size_t class_stride);
+
+  // Extends the prefixes by the pruned classes of the next time step
+  void advance(const std::vector<std::pair<size_t, float>> &log_prob_idx,
+               float blank_log_prob);
+
+  std::vector<std::string> vocabulary_;
+  size_t beam_size_;
+  float cutoff_prob_;
+  size_t cutoff_top_n_;
+  size_t blank_id_;
+  int log_input_;
+  ScorerBase *ext_scorer_;
+  int space_id_;
+  size_t num_time_steps_;
+  bool is_finalized_;
+  PathTrie root_;
+  std::vector<PathTrie *> prefixes_;
+  // The probabilities of the current time step converted by feed_fp16()
+  std::vector<float> step_probs_;
+};
+
 /* CTC Beam Search Decoder for batch data
 
  * Parameters:
@@ -56,9 +176,11 @@ std::vector<std::pair<float, Output>> ctc_beam_search_decoder(
  *     ext_scorer: External scorer to evaluate a prefix, which consists of
  *                 n-gram language model scoring and word insertion term.
  *                 Default null, decoding the input sample without scorer.
+ *     The longest samples are decoded first, so a long sample doesn't keep
+ *     one thread busy after the others are done with the batch.
  * Return:
  *     A 2-D vector that each element is a vector of beam search decoding
- *     result for one audio sample.
+ *     result for one audio sample, in the order of probs_split.
 */
 std::vector<std::vector<std::pair<float, Output>>>
 ctc_beam_search_decoder_batch(
@@ -72,4 +194,100 @@ ctc_beam_search_decoder_batch(
     int log_input = 0,
     ScorerBase *ext_scorer = nullptr);
 
+/* CTC Beam Search Decoder for batch data reading the probabilities in place
+
+ * Parameters:
+ *     probs: The probability of the class c at the time step t of the sample b
+ *            is probs[b * batch_stride + t * time_stride + c * class_stride].
+ *     seq_lens: The number of time steps to decode for every sample.
+ *     num_classes: The number of classes, it must match the vocabulary.
+ *     The other parameters are the same as in ctc_beam_search_decoder_batch().
+ * Return:
+ *     The same as ctc_beam_search_decoder_batch().
+*/
+std::vector<std::vector<std::pair<float, Output>>>
+ctc_beam_search_decoder_batch_strided(
+    const float *probs,
+    const std::vector<size_t> &seq_lens,
+    size_t num_classes,
+    size_t batch_stride,
+    size_t time_stride,
+    size_t class_stride,
+    const std::vector<std::string> &vocabulary,
+    size_t beam_size,
+    size_t num_processes,
+    float cutoff_prob = 1.0,
+    size_t cutoff_top_n = 40,
+    size_t blank_id = 0,
+    int log_input = 0,
+    ScorerBase *ext_scorer = nullptr);
+
+/* CTC Beam Search Decoder for batch data keeping its threads between batches
+
+ * ctc_beam_search_decoder_batch_strided() starts its threads for every batch,
+ * which takes longer than decoding the short batches of streaming chunks.
+ * Every thread of the decoder decodes the samples with its own decoder state,
+ * so the nodes of the prefixes of the previous samples are reused. The
+ * parameters of the constructor are the same as in
+ * ctc_beam_search_decoder_batch(), the vocabulary is copied and ext_scorer
+ * must outlive the decoder.
+*/
+class CtcBeamSearchBatchDecoder {
+public:
+  CtcBeamSearchBatchDecoder(const std::vector<std::string> &vocabulary,
+                            size_t beam_size,
+                            size_t num_processes,
+                            float cutoff_prob = 1.0,
+                            size_t cutoff_top_n = 40,
+                            size_t blank_id = 0,
+                            int log_input = 0,
+                            ScorerBase *ext_scorer = nullptr);
+  ~CtcBeamSearchBatchDecoder();
+  CtcBeamSearchBatchDecoder(const CtcBeamSearchBatchDecoder &) = delete;
+  CtcBeamSearchBatchDecoder &operator=(const CtcBeamSearchBatchDecoder &) = delete;
+
+  // The same as ctc_beam_search_decoder_batch_strided() with the parameters
+  // of the decoder. Concurrent calls decode their batches one by one
+  std::vector<std::vector<std::pair<float, Output>>> decode(
+      const float *probs,
+      const std::vector<size_t> &seq_lens,
+      size_t num_classes,
+      size_t batch_stride,
+      size_t time_stride,
+      size_t class_stride);
+
+  // The same as decode() for half precision (IEEE 754 binary16) probabilities
+  std::vector<std::vector<std::pair<float, Output>>> decode_fp16(
+      const uint16_t *probs,
+      const std::vector<size_t> &seq_lens,
+      size_t num_classes,
+      size_t batch_stride,
+      size_t time_stride,
+      size_t class_stride);
+
+  // The same as decode() for the sparse probabilities of the samples, see
+  // CtcBeamSearchDecoderState::feed_sparse(): the class of the entry k at
+  // the time step t of the sample b is
+  // class_ids[b * batch_stride + t * time_stride + k]
+  std::vector<std::vector<std::pair<float, Output>>> decode_sparse(
+      const int *class_ids,
+      const float *probs,
+      const std::vector<size_t> &seq_lens,
+      size_t top_k,
+      size_t batch_stride,
+      size_t time_stride);
+
+private:
+  // Decodes the samples in the threads, feed(state, b) feeds the sample b
+  std::vector<std::vector<std::pair<float, Output>>> decode_samples(
+      const std::vector<size_t> &seq_lens,
+      const std::function<void(CtcBeamSearchDecoderState *, size_t)> &feed);
+
+  std::mutex mutex_;
+  // One for every thread, a thread takes the next sample when it's done
+  std::vector<std::unique_ptr<CtcBeamSearchDecoderState>> states_;
+  // Destroyed first, so the threads are joined before the states are destroyed
+  std::unique_ptr<ThreadPool> pool_;
+};
+
 #endif  // CTC_BEAM_SEARCH_DECODER_H_
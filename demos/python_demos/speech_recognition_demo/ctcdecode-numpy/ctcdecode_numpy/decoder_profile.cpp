@@ -0,0 +1,98 @@
+/*********************************************************************
+* Copyright (c) 2020 Intel Corporation
+* SPDX-License-Identifier: Apache-2.0
+**********************************************************************/
+
+#include "decoder_profile.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+
+namespace {
+#ifdef CTCDECODE_PROFILE
+// The times of a thread are written by the thread only, so the probes don't
+// contend for a shared cache line. They are atomic to be read by other threads
+struct ThreadPhaseTimes {
+  std::atomic<uint64_t> nanoseconds[NUM_DECODER_PHASES];
+
+  ThreadPhaseTimes();
+  ~ThreadPhaseTimes();
+};
+
+struct PhaseTimesRegistry {
+  std::mutex mutex;
+  std::set<ThreadPhaseTimes *> threads;
+  // the times of the exited threads
+  uint64_t exited[NUM_DECODER_PHASES] = {};
+};
+
+PhaseTimesRegistry &registry() {
+  static PhaseTimesRegistry instance;
+  return instance;
+}
+
+ThreadPhaseTimes::ThreadPhaseTimes() {
+  for (auto &time : nanoseconds) {
+    time.store(0, std::memory_order_relaxed);
+  }
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  registry().threads.insert(this);
+}
+
+ThreadPhaseTimes::~ThreadPhaseTimes() {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  for (size_t i = 0; i < NUM_DECODER_PHASES; ++i) {
+    registry().exited[i] += nanoseconds[i].load(std::memory_order_relaxed);
+  }
+  registry().threads.erase(this);
+}
+#endif
+}  // namespace
+
+const char *decoder_phase_name(DecoderPhase phase) {
+  switch (phase) {
+    case PHASE_PRUNING: return "pruning";
+    case PHASE_TRIE_EXTENSION: return "trie_extension";
+    case PHASE_LM_SCORING: return "lm_scoring";
+    case PHASE_SORTING: return "sorting";
+    default: return "unknown";
+  }
+}
+
+#ifdef CTCDECODE_PROFILE
+void add_decoder_phase_time(DecoderPhase phase, uint64_t nanoseconds) {
+  static thread_local ThreadPhaseTimes times;
+  std::atomic<uint64_t> &time = times.nanoseconds[phase];
+  time.store(time.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+}
+
+void get_decoder_phase_times(uint64_t (&nanoseconds)[NUM_DECODER_PHASES]) {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  for (size_t i = 0; i < NUM_DECODER_PHASES; ++i) {
+    nanoseconds[i] = registry().exited[i];
+    for (const ThreadPhaseTimes *thread : registry().threads) {
+      nanoseconds[i] += thread->nanoseconds[i].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void reset_decoder_phase_times() {
+  // The threads which are decoding now may lose a part of their times
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  for (size_t i = 0; i < NUM_DECODER_PHASES; ++i) {
+    registry().exited[i] = 0;
+    for (ThreadPhaseTimes *thread : registry().threads) {
+      thread->nanoseconds[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+#else
+void get_decoder_phase_times(uint64_t (&nanoseconds)[NUM_DECODER_PHASES]) {
+  for (auto &time : nanoseconds) {
+    time = 0;
+  }
+}
+
+void reset_decoder_phase_times() {}
+#endif
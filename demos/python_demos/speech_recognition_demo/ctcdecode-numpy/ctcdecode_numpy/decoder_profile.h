@@ -0,0 +1,63 @@
+/*********************************************************************
+* Copyright (c) 2020 Intel Corporation
+* SPDX-License-Identifier: Apache-2.0
+**********************************************************************/
+
+#ifndef DECODER_PROFILE_H_
+#define DECODER_PROFILE_H_
+
+#include <cstdint>
+
+#ifdef CTCDECODE_PROFILE
+#include <chrono>
+#endif
+
+/* Time the beam search spends in its phases, summed over the decoding threads.
+ * The probes are compiled in only if CTCDECODE_PROFILE is defined, as for
+ * ctcdecode_numpy_bench, and cost nothing otherwise. */
+enum DecoderPhase {
+  PHASE_PRUNING,         // picking the classes of a time step to extend the prefixes with
+  PHASE_TRIE_EXTENSION,  // adding and removing the nodes of the prefix trie
+  PHASE_LM_SCORING,      // scoring the words of the prefixes by the external scorer
+  PHASE_SORTING,         // ordering the prefixes and choosing the beam
+  NUM_DECODER_PHASES
+};
+
+const char *decoder_phase_name(DecoderPhase phase);
+
+// Nanoseconds spent in every phase since the last reset by all the threads,
+// including the ones which have exited
+void get_decoder_phase_times(uint64_t (&nanoseconds)[NUM_DECODER_PHASES]);
+
+void reset_decoder_phase_times();
+
+#ifdef CTCDECODE_PROFILE
+// Adds the time of the calling thread, it's summed by get_decoder_phase_times()
+void add_decoder_phase_time(DecoderPhase phase, uint64_t nanoseconds);
+
+class DecoderPhaseScope {
+public:
+  explicit DecoderPhaseScope(DecoderPhase phase)
+      : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+  ~DecoderPhaseScope() {
+    add_decoder_phase_time(phase_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+  }
+  DecoderPhaseScope(const DecoderPhaseScope &) = delete;
+  DecoderPhaseScope &operator=(const DecoderPhaseScope &) = delete;
+
+private:
+  DecoderPhase phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+#define DECODER_PHASE_CONCAT_(a, b) a##b
+#define DECODER_PHASE_CONCAT(a, b) DECODER_PHASE_CONCAT_(a, b)
+// Times the rest of the enclosing scope as the phase
+#define DECODER_PHASE_SCOPE(phase) \
+  DecoderPhaseScope DECODER_PHASE_CONCAT(decoder_phase_scope_, __LINE__)(phase)
+#else
+#define DECODER_PHASE_SCOPE(phase)
+#endif
+
+#endif  // DECODER_PROFILE_H_
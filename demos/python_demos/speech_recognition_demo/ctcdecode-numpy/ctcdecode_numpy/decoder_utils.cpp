@@ -10,27 +10,40 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <limits>
 
-std::vector<std::pair<size_t, float>> get_pruned_log_probs(
-    const std::vector<float> &prob_step,
+#if defined(__F16C__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+std::vector<std::pair<size_t, float>> prune_log_probs(
+    std::vector<std::pair<int, float>> &prob_idx,
     float cutoff_prob,
     size_t cutoff_top_n,
     int log_input) {
-  std::vector<std::pair<int, float>> prob_idx;
+  const size_t num_classes = prob_idx.size();
   float log_cutoff_prob = log(cutoff_prob);
-  for (size_t i = 0; i < prob_step.size(); ++i) {
-    prob_idx.push_back(std::pair<int, float>(i, prob_step[i]));
-  }
   // pruning of vacobulary
-  size_t cutoff_len = prob_step.size();
-  if (log_cutoff_prob < 0.0 || cutoff_top_n < cutoff_len) {
-    std::sort(
-        prob_idx.begin(), prob_idx.end(), pair_comp_second_rev<int, float>);
+  size_t cutoff_len = num_classes;
+  if (num_classes > 0 && (log_cutoff_prob < 0.0 || cutoff_top_n < cutoff_len)) {
+    // at most cutoff_top_n classes (but at least one) are kept, so only they
+    // are sorted, the selection is linear in the size of the vocabulary
+    size_t top_n = std::min(std::max(cutoff_top_n, size_t(1)), num_classes);
+    std::nth_element(prob_idx.begin(),
+                     prob_idx.begin() + top_n - 1,
+                     prob_idx.end(),
+                     pair_comp_second_rev<int, float>);
+    std::sort(prob_idx.begin(),
+              prob_idx.begin() + top_n,
+              pair_comp_second_rev<int, float>);
     if (log_cutoff_prob < 0.0) {
       float cum_prob = 0.0;
       cutoff_len = 0;
-      for (size_t i = 0; i < prob_idx.size(); ++i) {
+      for (size_t i = 0; i < top_n; ++i) {
         cum_prob = log_sum_exp<float>(cum_prob, log_input ? prob_idx[i].second : log(prob_idx[i].second) );
         cutoff_len += 1;
         if (cum_prob >= cutoff_prob || cutoff_len >= cutoff_top_n) break;
@@ -38,16 +51,96 @@ std::vector<std::pair<size_t, float>> get_pruned_log_probs(
     }else{
       cutoff_len = cutoff_top_n;
     }
-    prob_idx = std::vector<std::pair<int, float>>(
-        prob_idx.begin(), prob_idx.begin() + cutoff_len);
   }
   std::vector<std::pair<size_t, float>> log_prob_idx;
+  log_prob_idx.reserve(cutoff_len);
   for (size_t i = 0; i < cutoff_len; ++i) {
     log_prob_idx.push_back(std::pair<int, float>(
         prob_idx[i].first, log_input ? prob_idx[i].second : log(prob_idx[i].second + NUM_FLT_MIN)));
   }
   return log_prob_idx;
 }
+}  // namespace
+
+std::vector<std::pair<size_t, float>> get_pruned_log_probs(
+    const float *prob_step,
+    size_t num_classes,
+    size_t class_stride,
+    float cutoff_prob,
+    size_t cutoff_top_n,
+    int log_input) {
+  std::vector<std::pair<int, float>> prob_idx;
+  prob_idx.reserve(num_classes);
+  for (size_t i = 0; i < num_classes; ++i) {
+    prob_idx.push_back(std::pair<int, float>(i, prob_step[i * class_stride]));
+  }
+  return prune_log_probs(prob_idx, cutoff_prob, cutoff_top_n, log_input);
+}
+
+std::vector<std::pair<size_t, float>> get_pruned_log_probs_sparse(
+    const int *class_ids,
+    const float *prob_step,
+    size_t num_entries,
+    size_t num_classes,
+    float cutoff_prob,
+    size_t cutoff_top_n,
+    int log_input) {
+  std::vector<std::pair<int, float>> prob_idx;
+  prob_idx.reserve(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    VALID_CHECK(class_ids[i] >= 0 && size_t(class_ids[i]) < num_classes,
+                "The class index is out of the vocabulary");
+    prob_idx.push_back(std::pair<int, float>(class_ids[i], prob_step[i]));
+  }
+  return prune_log_probs(prob_idx, cutoff_prob, cutoff_top_n, log_input);
+}
+
+
+namespace {
+float half_to_float(uint16_t h) {
+  uint32_t sign = uint32_t(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {  // infinity or NaN, which is quiet as converted by the hardware
+    bits = sign | 0x7f800000 | (mantissa ? 0x400000 | (mantissa << 13) : 0);
+  } else if (exponent != 0) {  // normal
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa != 0) {  // subnormal, normalized for float
+    exponent = 113;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      --exponent;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  } else {  // zero
+    bits = sign;
+  }
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+}  // namespace
+
+void half_to_float(const uint16_t *src, size_t n, size_t src_stride, float *dst) {
+  size_t i = 0;
+  if (src_stride == 1) {
+#if defined(__F16C__)
+    for (; i + 8 <= n; i += 8) {
+      __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+      _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+#elif defined(__aarch64__)
+    for (; i + 4 <= n; i += 4) {
+      float16x4_t h = vreinterpret_f16_u16(vld1_u16(src + i));
+      vst1q_f32(dst + i, vcvt_f32_f16(h));
+    }
+#endif
+  }
+  for (; i < n; ++i) {
+    dst[i] = half_to_float(src[i * src_stride]);
+  }
+}
 
 
 std::vector<std::pair<float, Output>> get_beam_search_result(
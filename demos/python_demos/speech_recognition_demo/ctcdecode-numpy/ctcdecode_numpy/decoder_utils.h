@@ -10,6 +10,7 @@
 #define DECODER_UTILS_H_
 
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <string>
 #include <utility>
@@ -66,13 +67,33 @@ T log_sum_exp(const T &x, const T &y) {
   return std::log(std::exp(x - xmax) + std::exp(y - xmax)) + xmax;
 }
 
-// Get pruned probability vector for each time step's beam search
+// Get pruned probability vector for each time step's beam search,
+// the probability of class i is prob_step[i * class_stride]
 std::vector<std::pair<size_t, float>> get_pruned_log_probs(
-    const std::vector<float> &prob_step,
+    const float *prob_step,
+    size_t num_classes,
+    size_t class_stride,
     float cutoff_prob,
     size_t cutoff_top_n,
     int log_input);
 
+// The same as get_pruned_log_probs() for the sparse probabilities of a time
+// step, e.g. the top classes selected by the model: the probability of class
+// class_ids[i] is prob_step[i], the other classes are pruned. The classes
+// are checked against num_classes and may be in any order
+std::vector<std::pair<size_t, float>> get_pruned_log_probs_sparse(
+    const int *class_ids,
+    const float *prob_step,
+    size_t num_entries,
+    size_t num_classes,
+    float cutoff_prob,
+    size_t cutoff_top_n,
+    int log_input);
+
+// Convert n half precision (IEEE 754 binary16) numbers src[i * src_stride]
+// to dst[i], with F16C or NEON instructions if the target has them
+void half_to_float(const uint16_t *src, size_t n, size_t src_stride, float *dst);
+
 // Get beam search result from prefixes in trie tree
 std::vector<std::pair<float, Output>> get_beam_search_result(
     const std::vector<PathTrie *> &prefixes,
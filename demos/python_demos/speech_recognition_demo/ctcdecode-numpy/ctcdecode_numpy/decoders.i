@@ -30,6 +30,8 @@ import_array();
 // Add support for size_t to numpy.i
 %numpy_typemaps(int   , NPY_INT   , size_t)
 %numpy_typemaps(float , NPY_FLOAT , size_t)
+// numpy.float16 arrays are passed as their bits, see half_to_float()
+%numpy_typemaps(unsigned short, NPY_HALF, size_t)
 
 namespace std {
     %template(IntVector) std::vector<int>;
@@ -38,13 +40,42 @@ namespace std {
 
 %apply (float * IN_ARRAY3, size_t DIM1, size_t DIM2, size_t DIM3) {(const float * probs, size_t batch_size, size_t max_frames, size_t num_classes)}
 %apply (int * IN_ARRAY1, size_t DIM1) {(const int * seq_lens, size_t seq_lens_dim_batch)}
+%apply (float * IN_ARRAY2, size_t DIM1, size_t DIM2) {(const float * probs, size_t num_frames, size_t num_classes)}
+%apply (unsigned short * IN_ARRAY3, size_t DIM1, size_t DIM2, size_t DIM3) {(const unsigned short * probs_fp16, size_t batch_size, size_t max_frames, size_t num_classes)}
+%apply (unsigned short * IN_ARRAY2, size_t DIM1, size_t DIM2) {(const unsigned short * probs_fp16, size_t num_frames, size_t num_classes)}
+%apply (int * IN_ARRAY3, size_t DIM1, size_t DIM2, size_t DIM3) {(const int * class_ids, size_t batch_size, size_t max_frames, size_t top_k)}
+%apply (float * IN_ARRAY3, size_t DIM1, size_t DIM2, size_t DIM3) {(const float * class_probs, size_t class_probs_dim_batch, size_t class_probs_dim_frames, size_t class_probs_dim_top_k)}
+%apply (int * IN_ARRAY2, size_t DIM1, size_t DIM2) {(const int * class_ids, size_t num_frames, size_t top_k)}
+%apply (float * IN_ARRAY2, size_t DIM1, size_t DIM2) {(const float * class_probs, size_t class_probs_dim_frames, size_t class_probs_dim_top_k)}
 %apply (int ** ARGOUTVIEWM_ARRAY1, size_t * DIM1) {(int ** tokens, size_t * tokens_dim)}
 %apply (int ** ARGOUTVIEWM_ARRAY1, size_t * DIM1) {(int ** timesteps, size_t * timesteps_dim)}
 %apply (float ** ARGOUTVIEWM_ARRAY1, size_t * DIM1) {(float ** scores, size_t * scores_dim)}
 %apply (int ** ARGOUTVIEWM_ARRAY1, size_t * DIM1) {(int ** tokens_lengths, size_t * tokens_lengths_dim)}
 
+%apply (int * INPLACE_ARRAY3, size_t DIM1, size_t DIM2, size_t DIM3) {
+    (int * tokens_out, size_t tokens_dim_batch, size_t tokens_dim_candidates, size_t tokens_dim_len),
+    (int * timesteps_out, size_t timesteps_dim_batch, size_t timesteps_dim_candidates, size_t timesteps_dim_len)}
+%apply (float * INPLACE_ARRAY2, size_t DIM1, size_t DIM2) {
+    (float * scores_out, size_t scores_dim_batch, size_t scores_dim_candidates)}
+%apply (int * INPLACE_ARRAY2, size_t DIM1, size_t DIM2) {
+    (int * tokens_lengths_out, size_t tokens_lengths_dim_batch, size_t tokens_lengths_dim_candidates),
+    (int * tokens_out, size_t tokens_dim_candidates, size_t tokens_dim_len),
+    (int * timesteps_out, size_t timesteps_dim_candidates, size_t timesteps_dim_len)}
+%apply (float * INPLACE_ARRAY1, size_t DIM1) {(float * scores_out, size_t scores_dim_candidates)}
+%apply (int * INPLACE_ARRAY1, size_t DIM1) {(int * tokens_lengths_out, size_t tokens_lengths_dim_candidates)}
+
 // Workaround for the absent support of std::unique_ptr<...>.
 %ignore ScorerBase::dictionary;
+// Scoring of prefixes is internal to the decoder, keep get_log_cond_prob() unambiguous in Python.
+%ignore ScorerBase::get_log_cond_prob(PathTrie *);
+%ignore ScorerYoklm::get_log_cond_prob(PathTrie *);
+// The dictionary file is passed through create_scorer_yoklm().
+%ignore ScorerYoklm::ScorerYoklm(double, double, const std::string &, const std::vector<std::string> &, const std::string &);
+
+// The cache is configured through set_lm_cache_size() and get_lm_cache_*() of binding.h.
+%ignore ScorerYoklm::set_lm_cache_size;
+%ignore ScorerYoklm::lm_cache_stats;
+%ignore ScorerYoklm::default_lm_cache_size;
 
 %include "scorer_base.h"
 %include "scorer_yoklm.h"
@@ -470,8 +470,60 @@ def numpy_beam_decode_no_lm(probs, seq_lens, labels, beam_size, max_candidates_p
     return _impl.numpy_beam_decode_no_lm(probs, seq_lens, labels, beam_size, max_candidates_per_batch, num_processes, cutoff_prob, cutoff_top_n, blank_id, log_input)
 numpy_beam_decode_no_lm = _impl.numpy_beam_decode_no_lm
 
-def create_scorer_yoklm(alpha, beta, lm_path, labels):
-    return _impl.create_scorer_yoklm(alpha, beta, lm_path, labels)
+def create_batch_decoder(labels, beam_size, num_processes, cutoff_prob, cutoff_top_n, blank_id, log_input, scorer):
+    return _impl.create_batch_decoder(labels, beam_size, num_processes, cutoff_prob, cutoff_top_n, blank_id, log_input, scorer)
+create_batch_decoder = _impl.create_batch_decoder
+
+def delete_batch_decoder(decoder):
+    return _impl.delete_batch_decoder(decoder)
+delete_batch_decoder = _impl.delete_batch_decoder
+
+def numpy_batch_decoder_decode(decoder, probs, seq_lens, max_candidates_per_batch):
+    return _impl.numpy_batch_decoder_decode(decoder, probs, seq_lens, max_candidates_per_batch)
+numpy_batch_decoder_decode = _impl.numpy_batch_decoder_decode
+
+def numpy_batch_decoder_decode_fp16(decoder, probs_fp16, seq_lens, max_candidates_per_batch):
+    return _impl.numpy_batch_decoder_decode_fp16(decoder, probs_fp16, seq_lens, max_candidates_per_batch)
+numpy_batch_decoder_decode_fp16 = _impl.numpy_batch_decoder_decode_fp16
+
+def numpy_batch_decoder_decode_sparse(decoder, class_ids, class_probs, seq_lens, max_candidates_per_batch):
+    return _impl.numpy_batch_decoder_decode_sparse(decoder, class_ids, class_probs, seq_lens, max_candidates_per_batch)
+numpy_batch_decoder_decode_sparse = _impl.numpy_batch_decoder_decode_sparse
+
+def numpy_batch_decoder_decode_into(decoder, probs, seq_lens, tokens_out, timesteps_out, scores_out, tokens_lengths_out):
+    return _impl.numpy_batch_decoder_decode_into(decoder, probs, seq_lens, tokens_out, timesteps_out, scores_out, tokens_lengths_out)
+numpy_batch_decoder_decode_into = _impl.numpy_batch_decoder_decode_into
+
+def create_decoder_state(labels, beam_size, cutoff_prob, cutoff_top_n, blank_id, log_input, scorer):
+    return _impl.create_decoder_state(labels, beam_size, cutoff_prob, cutoff_top_n, blank_id, log_input, scorer)
+create_decoder_state = _impl.create_decoder_state
+
+def delete_decoder_state(state):
+    return _impl.delete_decoder_state(state)
+delete_decoder_state = _impl.delete_decoder_state
+
+def numpy_decoder_state_feed(state, probs):
+    return _impl.numpy_decoder_state_feed(state, probs)
+numpy_decoder_state_feed = _impl.numpy_decoder_state_feed
+
+def numpy_decoder_state_feed_fp16(state, probs_fp16):
+    return _impl.numpy_decoder_state_feed_fp16(state, probs_fp16)
+numpy_decoder_state_feed_fp16 = _impl.numpy_decoder_state_feed_fp16
+
+def numpy_decoder_state_feed_sparse(state, class_ids, class_probs):
+    return _impl.numpy_decoder_state_feed_sparse(state, class_ids, class_probs)
+numpy_decoder_state_feed_sparse = _impl.numpy_decoder_state_feed_sparse
+
+def numpy_decoder_state_result(state, finalize, max_candidates):
+    return _impl.numpy_decoder_state_result(state, finalize, max_candidates)
+numpy_decoder_state_result = _impl.numpy_decoder_state_result
+
+def numpy_decoder_state_result_into(state, finalize, tokens_out, timesteps_out, scores_out, tokens_lengths_out):
+    return _impl.numpy_decoder_state_result_into(state, finalize, tokens_out, timesteps_out, scores_out, tokens_lengths_out)
+numpy_decoder_state_result_into = _impl.numpy_decoder_state_result_into
+
+def create_scorer_yoklm(alpha, beta, lm_path, labels, dictionary_path):
+    return _impl.create_scorer_yoklm(alpha, beta, lm_path, labels, dictionary_path)
 create_scorer_yoklm = _impl.create_scorer_yoklm
 
 def delete_scorer(scorer):
@@ -493,6 +545,18 @@ get_dict_size = _impl.get_dict_size
 def reset_params(scorer, alpha, beta):
     return _impl.reset_params(scorer, alpha, beta)
 reset_params = _impl.reset_params
+
+def set_lm_cache_size(scorer, memory_budget):
+    return _impl.set_lm_cache_size(scorer, memory_budget)
+set_lm_cache_size = _impl.set_lm_cache_size
+
+def get_lm_cache_hits(scorer):
+    return _impl.get_lm_cache_hits(scorer)
+get_lm_cache_hits = _impl.get_lm_cache_hits
+
+def get_lm_cache_lookups(scorer):
+    return _impl.get_lm_cache_lookups(scorer)
+get_lm_cache_lookups = _impl.get_lm_cache_lookups
 # This file is compatible with both classic and new-style classes.
 
 
@@ -16,7 +16,40 @@
 
 #include "decoder_utils.h"
 
-PathTrie::PathTrie() {
+class PathTrie::Arena {
+public:
+  PathTrie* allocate() {
+    if (free_nodes_.empty()) {
+      blocks_.emplace_back(new PathTrie[block_size_]);
+      for (size_t i = block_size_; i > 0; --i) {
+        free_nodes_.push_back(&blocks_.back()[i - 1]);
+      }
+    }
+    PathTrie* node = free_nodes_.back();
+    free_nodes_.pop_back();
+    return node;
+  }
+
+  void release(PathTrie* node) {
+    node->reset();
+    free_nodes_.push_back(node);
+  }
+
+private:
+  static const size_t block_size_ = 1024;
+  std::vector<std::unique_ptr<PathTrie[]>> blocks_;
+  std::vector<PathTrie*> free_nodes_;
+};
+
+PathTrie::PathTrie() : arena_(nullptr) {
+  reset();
+}
+
+PathTrie::~PathTrie() {
+  // The nodes are destroyed with the blocks of the root's arena
+}
+
+void PathTrie::reset() {
   log_prob_b_prev = -NUM_FLT_INF;
   log_prob_nb_prev = -NUM_FLT_INF;
   log_prob_b_cur = -NUM_FLT_INF;
@@ -30,38 +63,51 @@ PathTrie::PathTrie() {
   timestep = 0;
   exists_ = true;
   parent = nullptr;
+  children_chars_.clear();
+  children_.clear();
+
+  has_lm_state = false;
+  lm_state.backoffs.clear();
+  lm_state.context_words.clear();
+  lm_log_cond_prob = 0.0;
 
   dictionary_ = nullptr;
   has_dictionary_ = false;
   dictionary_state_ = {};
 }
 
-PathTrie::~PathTrie() {
-  for (auto child : children_) {
-    delete child.second;
+PathTrie* PathTrie::new_child(int new_char, int new_timestep, float cur_log_prob_c) {
+  if (arena_ == nullptr) {
+    own_arena_.reset(new Arena);
+    arena_ = own_arena_.get();
   }
+  PathTrie* new_path = arena_->allocate();
+  new_path->arena_ = arena_;
+  new_path->character = new_char;
+  new_path->timestep = new_timestep;
+  new_path->parent = this;
+  new_path->log_prob_c = cur_log_prob_c;
+  children_chars_.push_back(new_char);
+  children_.push_back(new_path);
+  return new_path;
 }
 
 PathTrie* PathTrie::get_path_trie(int new_char, int new_timestep, float cur_log_prob_c, bool reset) {
-  auto child = children_.begin();
-  for (child = children_.begin(); child != children_.end(); ++child) {
-    if (child->first == new_char) {
-      if (child->second->log_prob_c < cur_log_prob_c) {
-	child->second->log_prob_c = cur_log_prob_c;
-	child->second->timestep = new_timestep;
-      }
-      break;
+  auto child_char = std::find(children_chars_.begin(), children_chars_.end(), new_char);
+  if (child_char != children_chars_.end()) {
+    PathTrie* child = children_[child_char - children_chars_.begin()];
+    if (child->log_prob_c < cur_log_prob_c) {
+      child->log_prob_c = cur_log_prob_c;
+      child->timestep = new_timestep;
     }
-  }
-  if (child != children_.end()) {
-    if (!child->second->exists_) {
-      child->second->exists_ = true;
-      child->second->log_prob_b_prev = -NUM_FLT_INF;
-      child->second->log_prob_nb_prev = -NUM_FLT_INF;
-      child->second->log_prob_b_cur = -NUM_FLT_INF;
-      child->second->log_prob_nb_cur = -NUM_FLT_INF;
+    if (!child->exists_) {
+      child->exists_ = true;
+      child->log_prob_b_prev = -NUM_FLT_INF;
+      child->log_prob_nb_prev = -NUM_FLT_INF;
+      child->log_prob_b_cur = -NUM_FLT_INF;
+      child->log_prob_nb_cur = -NUM_FLT_INF;
     }
-    return (child->second);
+    return child;
   } else {
     if (has_dictionary_) {
       WordPrefixSetState new_state = dictionary_state_;
@@ -74,36 +120,24 @@ PathTrie* PathTrie::get_path_trie(int new_char, int new_timestep, float cur_log_
         }
         return nullptr;
       } else {
-        PathTrie* new_path = new PathTrie;
-        new_path->character = new_char;
-        new_path->timestep = new_timestep;
-        new_path->parent = this;
+        PathTrie* new_path = new_child(new_char, new_timestep, cur_log_prob_c);
         new_path->dictionary_ = dictionary_;
         new_path->has_dictionary_ = true;
-	new_path->log_prob_c = cur_log_prob_c;
 
         // set spell checker state
         // check to see if next state is final
         bool is_final = new_state.weight;
         if (is_final && reset) {
-	  // restart spell checker at the start state
+          // restart spell checker at the start state
           new_path->dictionary_state_ = dictionary_->empty_state();
         } else {
-	  // go to next state
+          // go to next state
           new_path->dictionary_state_ = new_state;
         }
-
-        children_.push_back(std::make_pair(new_char, new_path));
         return new_path;
       }
     } else {
-      PathTrie* new_path = new PathTrie;
-      new_path->character = new_char;
-      new_path->timestep = new_timestep;
-      new_path->parent = this;
-      new_path->log_prob_c = cur_log_prob_c;
-      children_.push_back(std::make_pair(new_char, new_path));
-      return new_path;
+      return new_child(new_char, new_timestep, cur_log_prob_c);
     }
   }
 }
@@ -139,7 +173,7 @@ void PathTrie::iterate_to_vec(std::vector<PathTrie*>& output) {
     output.push_back(this);
   }
   for (auto child : children_) {
-    child.second->iterate_to_vec(output);
+    child->iterate_to_vec(output);
   }
 }
 
@@ -147,21 +181,32 @@ void PathTrie::remove() {
   exists_ = false;
 
   if (children_.size() == 0) {
-    auto child = parent->children_.begin();
-    for (child = parent->children_.begin(); child != parent->children_.end();
-         ++child) {
-      if (child->first == character) {
-        parent->children_.erase(child);
-        break;
-      }
+    auto child_char = std::find(parent->children_chars_.begin(), parent->children_chars_.end(), character);
+    if (child_char != parent->children_chars_.end()) {
+      parent->children_.erase(parent->children_.begin() + (child_char - parent->children_chars_.begin()));
+      parent->children_chars_.erase(child_char);
     }
 
     if (parent->children_.size() == 0 && !parent->exists_) {
       parent->remove();
     }
 
-    delete this;
+    arena_->release(this);
+  }
+}
+
+void PathTrie::clear() {
+  release_children();
+  reset();
+}
+
+void PathTrie::release_children() {
+  for (auto child : children_) {
+    child->release_children();
+    arena_->release(child);
   }
+  children_chars_.clear();
+  children_.clear();
 }
 
 void PathTrie::set_dictionary(WordPrefixSet* dictionary) {
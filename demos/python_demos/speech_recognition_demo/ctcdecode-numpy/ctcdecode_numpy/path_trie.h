@@ -16,14 +16,19 @@
 #include <vector>
 
 #include "word_prefix_set.h"
+#include "yoklm/language_model.hpp"
 
 /* Trie tree for prefix storing and manipulating, with a dictionary in
  * finite-state transducer for spelling correction.
+ * The nodes are allocated in blocks owned by the root, removed nodes are
+ * reused by the next prefixes and all of them are released with the root.
  */
 class PathTrie {
 public:
   PathTrie();
   ~PathTrie();
+  PathTrie(const PathTrie&) = delete;
+  PathTrie& operator=(const PathTrie&) = delete;
 
   // get new prefix after appending new char
   PathTrie* get_path_trie(int new_char, int new_timestep, float log_prob_c, bool reset = true);
@@ -48,6 +53,10 @@ public:
   // remove current path from root
   void remove();
 
+  // remove all the paths from the root and restore its initial state,
+  // their nodes are kept in the arena for the next prefixes
+  void clear();
+
   float log_prob_b_prev;
   float log_prob_nb_prev;
   float log_prob_b_cur;
@@ -59,12 +68,33 @@ public:
   int timestep;
   PathTrie* parent;
 
+  // Cached by the scorer when the prefix is scored as ending with a word: the language model state after this word
+  // and its conditional log probability. They depend on the path from the root only, so they stay valid while the
+  // node exists
+  bool has_lm_state;
+  yoklm::LmState lm_state;
+  double lm_log_cond_prob;
+
 private:
+  class Arena;
+
+  // allocate a child node for new_char in the arena of the trie
+  PathTrie* new_child(int new_char, int new_timestep, float cur_log_prob_c);
+  // restore the state of a newly constructed node, keeping the capacity of children
+  void reset();
+  // release the nodes of the subtries of the children to the arena
+  void release_children();
+
   int ROOT_;
   bool exists_;
   bool has_dictionary_;
 
-  std::vector<std::pair<int, PathTrie*>> children_;
+  // The characters of the children are kept apart from the pointers, so a lookup scans a small contiguous array
+  std::vector<int> children_chars_;
+  std::vector<PathTrie*> children_;
+
+  Arena* arena_;  // nullptr until the root gets its first child
+  std::unique_ptr<Arena> own_arena_;  // set for the root only
 
   // pointer to word prefix dictionary
   WordPrefixSet* dictionary_;
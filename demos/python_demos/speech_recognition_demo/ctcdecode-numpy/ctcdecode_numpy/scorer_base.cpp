@@ -25,14 +25,15 @@ ScorerBase::ScorerBase(double alpha,
 ScorerBase::~ScorerBase() {}
 
 void ScorerBase::setup(const std::string& lm_path,
-                       const std::vector<std::string>& vocab_list) {
+                       const std::vector<std::string>& vocab_list,
+                       const std::string& dictionary_path) {
   // load language model
   load_lm(lm_path);
   // set char map for scorer
   set_char_map(vocab_list);
   // fill word prefix dictionary
   if (!is_character_based()) {
-    fill_dictionary(true);
+    fill_dictionary(true, dictionary_path);
   }
 }
 
@@ -105,28 +106,39 @@ void ScorerBase::set_char_map(const std::vector<std::string>& char_list) {
   }
 }
 
+double ScorerBase::get_log_cond_prob(PathTrie* prefix) {
+  return get_log_cond_prob(make_ngram(prefix));
+}
+
+PathTrie* ScorerBase::split_last_word(PathTrie* prefix, std::string& word) {
+  std::vector<int> prefix_vec;
+  std::vector<int> prefix_steps;
+  PathTrie* new_node = nullptr;
+  PathTrie* previous_words = nullptr;
+
+  if (is_character_based_) {
+    new_node = prefix->get_path_vec(prefix_vec, prefix_steps, -1, 1);
+    previous_words = new_node;
+  } else {
+    new_node = prefix->get_path_vec(prefix_vec, prefix_steps, space_id_);
+    previous_words = new_node->parent;  // Skipping spaces
+  }
+
+  // reconstruct word
+  word = vec2str(prefix_vec);
+  return new_node->character == -1 ? nullptr : previous_words;
+}
+
 std::vector<std::string> ScorerBase::make_ngram(PathTrie* prefix) {
   std::vector<std::string> ngram;
   PathTrie* current_node = prefix;
-  PathTrie* new_node = nullptr;
 
   for (size_t order = 0; order < max_order_; order++) {
-    std::vector<int> prefix_vec;
-    std::vector<int> prefix_steps;
-
-    if (is_character_based_) {
-      new_node = current_node->get_path_vec(prefix_vec, prefix_steps, -1, 1);
-      current_node = new_node;
-    } else {
-      new_node = current_node->get_path_vec(prefix_vec, prefix_steps, space_id_);
-      current_node = new_node->parent;  // Skipping spaces
-    }
-
-    // reconstruct word
-    std::string word = vec2str(prefix_vec);
+    std::string word;
+    current_node = split_last_word(current_node, word);
     ngram.push_back(word);
 
-    if (new_node->character == -1) {
+    if (current_node == nullptr) {
       // No more spaces, but still need order
       for (size_t i = 0; i < max_order_ - order - 1; i++) {
         ngram.push_back(START_TOKEN);
@@ -138,7 +150,14 @@ std::vector<std::string> ScorerBase::make_ngram(PathTrie* prefix) {
   return ngram;
 }
 
-void ScorerBase::fill_dictionary(bool add_space) {
+void ScorerBase::fill_dictionary(bool add_space, const std::string& dictionary_path) {
+  this->dictionary.reset(new WordPrefixSet);
+  const uint64_t tag = dictionary_tag(add_space);
+  if (!dictionary_path.empty() && this->dictionary->load(dictionary_path, tag)) {
+    dict_size_ = this->dictionary->num_words();
+    return;
+  }
+
   // For each unigram convert to ints and store
   std::vector<std::vector<int> > int_vocabulary;
   for (const auto& word : vocabulary_) {
@@ -146,6 +165,31 @@ void ScorerBase::fill_dictionary(bool add_space) {
   }
 
   // Add the converted vocabulary to WordPrefixSet
-  this->dictionary.reset(new WordPrefixSet);
   dict_size_ = this->dictionary->add_words(int_vocabulary);
+  if (!dictionary_path.empty()) {
+    this->dictionary->save(dictionary_path, tag);
+  }
+}
+
+uint64_t ScorerBase::dictionary_tag(bool add_space) const {
+  // FNV-1a hash of everything the dictionary is built from
+  uint64_t hash = 14695981039346656037ULL;
+  auto add_bytes = [&hash](const void* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ULL;
+    }
+  };
+  auto add_strings = [&add_bytes](const std::vector<std::string>& strings) {
+    const uint64_t count = strings.size();
+    add_bytes(&count, sizeof(count));
+    for (const auto& str : strings) {
+      // including the terminating zero to separate the strings
+      add_bytes(str.c_str(), str.size() + 1);
+    }
+  };
+  const uint8_t space_flag = add_space;
+  add_bytes(&space_flag, sizeof(space_flag));
+  add_strings(char_list_);
+  add_strings(vocabulary_);
+  return hash;
 }
@@ -9,6 +9,7 @@
 #ifndef SCORER_BASE_H_
 #define SCORER_BASE_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -39,6 +40,9 @@ public:
 
   virtual double get_log_cond_prob(const std::vector<std::string> &words) = 0;
 
+  // score the last word of a given prefix, the same as get_log_cond_prob(make_ngram(prefix))
+  virtual double get_log_cond_prob(PathTrie *prefix);
+
   double get_sent_log_prob(const std::vector<std::string> &words);
 
   // return the max order
@@ -70,8 +74,11 @@ public:
 
 protected:
   // necessary setup: load language model, set char map, fill word prefix dictionary
+  // If dictionary_path is not empty, the dictionary is loaded from this file,
+  // or built and saved there if the file is absent or built for other words.
   void setup(const std::string &lm_path,
-             const std::vector<std::string> &vocab_list);
+             const std::vector<std::string> &vocab_list,
+             const std::string &dictionary_path = "");
 
   // Load language model from given path
   // This method is responsible for:
@@ -80,8 +87,11 @@ protected:
   //  * setting vocabulary_
   virtual void load_lm(const std::string &lm_path) = 0;
 
-  // fill word prefix dictionary
-  void fill_dictionary(bool add_space);
+  // fill word prefix dictionary, load/save it from/to dictionary_path if not empty
+  void fill_dictionary(bool add_space, const std::string &dictionary_path = "");
+
+  // hash of the vocabulary and the char map identifying the saved dictionary
+  uint64_t dictionary_tag(bool add_space) const;
 
   // set char map
   void set_char_map(const std::vector<std::string> &char_list);
@@ -91,6 +101,10 @@ protected:
   // translate the vector in index to string
   std::string vec2str(const std::vector<int> &input);
 
+  // reconstruct the last word of a given prefix, return the prefix ending with
+  // the previous word or nullptr if the word is the first one
+  PathTrie *split_last_word(PathTrie *prefix, std::string &word);
+
   bool is_character_based_;
   size_t max_order_;
   std::vector<std::string> vocabulary_;
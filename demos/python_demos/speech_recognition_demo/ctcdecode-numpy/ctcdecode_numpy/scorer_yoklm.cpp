@@ -5,6 +5,8 @@
 
 #include "scorer_yoklm.h"
 
+#include <algorithm>
+
 #include "yoklm/kenlm_v5_loader.hpp"
 #include "yoklm/language_model.hpp"
 #include "yoklm/vocabulary.hpp"
@@ -19,6 +21,15 @@ ScorerYoklm::ScorerYoklm(double alpha,
   setup(lm_path, vocab_list);
 }
 
+ScorerYoklm::ScorerYoklm(double alpha,
+                         double beta,
+                         const std::string& lm_path,
+                         const std::vector<std::string>& vocab_list,
+                         const std::string& dictionary_path)
+      : ScorerBase(alpha, beta) {
+  setup(lm_path, vocab_list, dictionary_path);
+}
+
 ScorerYoklm::~ScorerYoklm() {}
 
 void ScorerYoklm::load_lm(const std::string& lm_path) {
@@ -29,7 +40,13 @@ void ScorerYoklm::load_lm(const std::string& lm_path) {
   lm_vocabulary_->load(loader->vocabulary_config());
   language_model_->load(loader->lm_config());
 
+  ngram_cache_.reset(new yoklm::NgramCache(default_lm_cache_size));
+
   max_order_ = language_model_->order();
+  start_state_ = yoklm::LmState(max_order_);
+  for (size_t i = 0; i + 1 < max_order_; ++i) {
+    language_model_->log10_p_cond(lm_vocabulary_->bos(), start_state_);
+  }
   vocabulary_.clear();
   vocabulary_.reserve(lm_vocabulary_->num_words());
   lm_vocabulary_->iterate_word_strings([this](yoklm::WordIndex index, std::string&& word) {
@@ -46,6 +63,10 @@ void ScorerYoklm::load_lm(const std::string& lm_path) {
   }
 }
 
+void ScorerYoklm::set_lm_cache_size(size_t memory_budget) {
+  ngram_cache_.reset(new yoklm::NgramCache(memory_budget));
+}
+
 double ScorerYoklm::get_log_cond_prob(const std::vector<std::string>& words) {
   double cond_prob = 0;
   // avoid inserting <s> in begin
@@ -61,3 +82,36 @@ double ScorerYoklm::get_log_cond_prob(const std::vector<std::string>& words) {
   // return log_e(prob)
   return cond_prob * (1./NUM_FLT_LOGE);
 }
+
+double ScorerYoklm::get_log_cond_prob(PathTrie* prefix) {
+  if (!prefix->has_lm_state) {
+    std::string word;
+    PathTrie* previous_words = split_last_word(prefix, word);
+    if (previous_words != nullptr) {
+      get_log_cond_prob(previous_words);
+    }
+    prefix->lm_state = previous_words != nullptr ? previous_words->lm_state : start_state_;
+    prefix->lm_log_cond_prob = score(lm_vocabulary_->find(word), prefix->lm_state);
+    prefix->has_lm_state = true;
+  }
+  return prefix->lm_log_cond_prob;
+}
+
+double ScorerYoklm::score(yoklm::WordIndex word_index, yoklm::LmState& state) const {
+  // The state keeps the previous (order-1) words, so the n-gram is OOV if any of them is
+  const yoklm::WordIndex unk = lm_vocabulary_->unk();
+  bool is_oov = word_index == unk ||
+      std::find(state.context_words.begin(), state.context_words.end(), unk) != state.context_words.end();
+  // The same n-grams are queried by the prefixes of all the threads, so their results are cached
+  const yoklm::NgramCache::Key key(word_index, state);
+  float cond_prob;
+  if (!ngram_cache_->find(key, cond_prob, state)) {
+    cond_prob = language_model_->log10_p_cond(word_index, state);
+    ngram_cache_->insert(key, cond_prob, state);
+  }
+  if (is_oov) {
+    return OOV_SCORE;
+  }
+  // return log_e(prob)
+  return cond_prob * (1./NUM_FLT_LOGE);
+}
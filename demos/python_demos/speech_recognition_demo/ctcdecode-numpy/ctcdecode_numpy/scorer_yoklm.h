@@ -14,9 +14,10 @@
 #include <memory>
 
 #include "scorer_base.h"
+#include "yoklm/language_model.hpp"
+#include "yoklm/ngram_cache.hpp"
 
 namespace yoklm {
-  class LanguageModel;
   class Vocabulary;
 }
 
@@ -35,10 +36,29 @@ public:
               double beta,
               const std::string &lm_path,
               const std::vector<std::string> &vocabulary);
+  // Load the word prefix dictionary from dictionary_path, or build and save it there
+  ScorerYoklm(double alpha,
+              double beta,
+              const std::string &lm_path,
+              const std::vector<std::string> &vocabulary,
+              const std::string &dictionary_path);
   virtual ~ScorerYoklm();
 
   virtual double get_log_cond_prob(const std::vector<std::string> &words);
 
+  // The language model states of the scored prefixes are cached in them, so
+  // only the words which weren't scored before are looked up
+  virtual double get_log_cond_prob(PathTrie *prefix);
+
+  // The n-gram queries of all the decoding threads share a cache of
+  // memory_budget bytes, 0 disables it. The cache is emptied, so it must not
+  // be resized while the scorer is used
+  void set_lm_cache_size(size_t memory_budget);
+
+  yoklm::NgramCache::Stats lm_cache_stats() const { return ngram_cache_->stats(); }
+
+  static const size_t default_lm_cache_size = 16 << 20;
+
 protected:
   // Load language model from given path
   // This method is responsible for:
@@ -48,8 +68,15 @@ protected:
   virtual void load_lm(const std::string &lm_path);
 
 private:
+  // advance the state by a word and return the log probability of the word
+  // in the context of the state
+  double score(yoklm::WordIndex word_index, yoklm::LmState &state) const;
+
   std::unique_ptr<yoklm::LanguageModel> language_model_;
   std::unique_ptr<yoklm::Vocabulary> lm_vocabulary_;
+  // the state after the start tokens padding the first words
+  yoklm::LmState start_state_;
+  std::unique_ptr<yoklm::NgramCache> ngram_cache_;
 };
 
 #endif  // SCORER_YOKLM_H_
@@ -7,9 +7,15 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
 
 typedef std::vector<int> IntWord;
 
+namespace {
+
 bool lex_less(const IntWord* a, const IntWord* b) {
   return *a < *b;
 }
@@ -18,85 +24,205 @@ bool int_word_equal(const IntWord* a, const IntWord* b) {
   return *a == *b;
 }
 
+// The file is this header followed by the units
+struct FileHeader {
+  char magic[16];
+  uint32_t version;
+  uint32_t unit_size;
+  uint64_t tag;
+  uint64_t num_words;
+  uint64_t num_units;
+};
+
+const char kMagic[16] = "WordPrefixSet\n";
+const uint32_t kVersion = 1;
+
+const size_t kSearchWindow = 4096;
+
+// A trie node waiting for its children to be placed: the words in
+// [begin, end) share the prefix of the node of length depth
+struct PendingNode {
+  uint32_t node;
+  size_t begin, end;
+  size_t depth;
+};
+
+}  // namespace
+
+const uint32_t WordPrefixSet::kFinalArc;
+
+WordPrefixSet::WordPrefixSet() : num_words_(0) {
+  // The root only
+  built_units_.assign(1, Unit{0, 0});
+  use_built_units();
+}
+
+void WordPrefixSet::use_built_units() {
+  mapped_units_.reset();
+  units_ = built_units_.data();
+  num_units_ = built_units_.size();
+}
+
 size_t WordPrefixSet::add_words(const std::vector<std::vector<int> >& words) {
   // Copy pointers to words
   std::vector<const IntWord*> word_ptrs;
   word_ptrs.reserve(words.size());
-  for (const auto& word : words)
+  for (const auto& word : words) {
+    if (std::find_if(word.begin(), word.end(), [](int c) { return c < 0; }) != word.end())
+      throw std::invalid_argument("WordPrefixSet: negative characters are not supported");
     word_ptrs.push_back(&word);
+  }
 
   // Sort pointers to word lexicographically
   std::sort(word_ptrs.begin(), word_ptrs.end(), lex_less);
 
   // Deduplicate
-  std::unique(word_ptrs.begin(), word_ptrs.end(), int_word_equal);
-
-  trie_chars_.clear();
-  trie_starts_.clear();
-  trie_weights_.clear();
-
-  // Go through the sorted list, and update children lists at every layer of trie.
-  // The new child may only be the last child in each list.
-  for (auto word : word_ptrs) {
-    size_t char_index;
-    // Skip the prefixes of the new word that are already present in the trie
-    for (char_index = 0; char_index < word->size() && char_index < trie_chars_.size(); char_index++) {
-      if (trie_chars_[char_index].back() != (*word)[char_index])
-        break;
-      // For our particular arc weight (char_index + 1 == word->size()), the following
-      // line would never change trie_weights_, since we process words in lexicographic order.
-      // To use this algo with other arc weights, the following line needs to be uncommented:
-      //trie_weights_[char_index].back() |= (char_index + 1 == word->size());
+  word_ptrs.erase(std::unique(word_ptrs.begin(), word_ptrs.end(), int_word_equal), word_ptrs.end());
+
+  std::vector<Unit> units(1, Unit{0, 0});
+  // The free units are linked in ascending order into a list with unit 0 (the root) as its head.
+  // Only the free units among the last kSearchWindow ones stay in the list, this bounds the
+  // search for the children places, while the other free units are left unused.
+  std::vector<uint32_t> next_free(1, 0), prev_free(1, 0);
+  auto remove_free = [&next_free, &prev_free](uint32_t unit) {
+    next_free[prev_free[unit]] = next_free[unit];
+    prev_free[next_free[unit]] = prev_free[unit];
+  };
+
+  std::vector<std::pair<int, size_t> > children;  // (arc label, first word) of a node
+  std::vector<PendingNode> pending(1, PendingNode{0, 0, word_ptrs.size(), 0});
+  while (!pending.empty()) {
+    const PendingNode parent = pending.back();
+    pending.pop_back();
+
+    // Since the words are sorted, the children of the node have contiguous ranges of words.
+    // The only word ending at the node (if any) comes first.
+    children.clear();
+    for (size_t i = parent.begin; i < parent.end; i++) {
+      const IntWord& word = *word_ptrs[i];
+      if (word.size() > parent.depth && (children.empty() || children.back().first != word[parent.depth]))
+        children.emplace_back(word[parent.depth], i);
     }
-    // Add the new prefixes
-    for (; char_index < word->size() && char_index + 1 < trie_chars_.size(); char_index++) {
-      trie_chars_[char_index].push_back((*word)[char_index]);
-      trie_starts_[char_index].push_back(trie_chars_[char_index + 1].size());
-      trie_weights_[char_index].push_back(char_index + 1 == word->size());
+    if (children.empty())
+      continue;
+
+    // Find the first base that puts all the children into free units, or else append them.
+    // Unit 0 is the root, so no child is placed there.
+    const size_t first_char = children.front().first;
+    size_t base = std::max(units.size(), first_char + 1) - first_char;
+    for (uint32_t unit = next_free[0]; unit != 0; unit = next_free[unit]) {
+      if (unit <= first_char)
+        continue;
+      bool fits = true;
+      for (const auto& child : children) {
+        const size_t child_unit = unit - first_char + child.first;
+        if (child_unit < units.size() && units[child_unit].check != 0) {
+          fits = false;
+          break;
+        }
+      }
+      if (fits) {
+        base = unit - first_char;
+        break;
+      }
     }
-    for (; char_index < word->size() && char_index + 1 == trie_chars_.size(); char_index++) {
-      trie_chars_[char_index].push_back((*word)[char_index]);
-      trie_starts_[char_index].push_back(0);
-      trie_weights_[char_index].push_back(char_index + 1 == word->size());
+    const size_t units_end = base + children.back().first + 1;
+    if (units_end > kFinalArc)
+      throw std::length_error("WordPrefixSet: too many prefixes");
+    while (units.size() < units_end) {
+      const uint32_t unit = static_cast<uint32_t>(units.size());
+      units.push_back(Unit{0, 0});
+      next_free.push_back(0);
+      prev_free.push_back(prev_free[0]);
+      next_free[prev_free[0]] = unit;
+      prev_free[0] = unit;
     }
-    for (; char_index < word->size(); char_index++) {
-      trie_chars_.emplace_back(1, (*word)[char_index]);
-      trie_starts_.emplace_back(1, 0);
-      trie_weights_.emplace_back(1, char_index + 1 == word->size());
+
+    units[parent.node].base = static_cast<uint32_t>(base);
+    for (size_t k = 0; k < children.size(); k++) {
+      const uint32_t node = static_cast<uint32_t>(base + children[k].first);
+      const size_t begin = children[k].second;
+      const size_t end = k + 1 < children.size() ? children[k + 1].second : parent.end;
+      const bool final_arc = word_ptrs[begin]->size() == parent.depth + 1;
+      units[node].check = (parent.node + 1) | (final_arc ? kFinalArc : 0);
+      remove_free(node);
+      pending.push_back(PendingNode{node, begin, end, parent.depth + 1});
     }
+    while (next_free[0] != 0 && next_free[0] + kSearchWindow < units.size())
+      remove_free(next_free[0]);
+  }
+
+  built_units_.swap(units);
+  use_built_units();
+  num_words_ = word_ptrs.size();
+  return num_words_;
+}
+
+void WordPrefixSet::save(const std::string& filename, uint64_t tag) const {
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(header.magic));
+  header.version = kVersion;
+  header.unit_size = sizeof(Unit);
+  header.tag = tag;
+  header.num_words = num_words_;
+  header.num_units = num_units_;
+
+  // Write to a temporary file and rename it, so that other processes
+  // mapping the old file keep reading consistent data
+  const std::string temp_filename = filename + ".tmp";
+  {
+    std::ofstream file(temp_filename, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(units_), num_units_ * sizeof(Unit));
+    if (!file.good())
+      throw std::runtime_error("Cannot write file: " + temp_filename);
+  }
+  if (std::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+    std::remove(temp_filename.c_str());
+    throw std::runtime_error("Cannot write file: " + filename);
   }
+}
 
-  // Finalize trie_starts_ by appending the size of the next layer
-  size_t prefix_length;
-  for (prefix_length = 0; prefix_length + 1 < trie_chars_.size(); prefix_length++)
-    trie_starts_[prefix_length].push_back(trie_chars_[prefix_length + 1].size());
-  for (; prefix_length < trie_starts_.size(); prefix_length++)
-    trie_starts_[prefix_length].push_back(0);
+bool WordPrefixSet::load(const std::string& filename, uint64_t tag) {
+  if (!std::ifstream(filename, std::ios::binary).good())
+    return false;
+  yoklm::MemorySection file = yoklm::map_file(filename);
+  if (file.size() < sizeof(FileHeader))
+    throw std::runtime_error("Broken WordPrefixSet file: " + filename);
+  // The mapping is page-aligned, so are the header and the units after it
+  const FileHeader& header = file.at<FileHeader>(0);
+  if (std::memcmp(header.magic, kMagic, sizeof(header.magic)) != 0)
+    throw std::runtime_error("Not a WordPrefixSet file: " + filename);
+  if (header.version != kVersion || header.unit_size != sizeof(Unit) || header.tag != tag)
+    return false;
+  if (header.num_units == 0 || header.num_units > (file.size() - sizeof(FileHeader)) / sizeof(Unit) ||
+      file.size() != sizeof(FileHeader) + header.num_units * sizeof(Unit))
+    throw std::runtime_error("Broken WordPrefixSet file: " + filename);
 
-  return word_ptrs.size();
+  mapped_units_ = file.without_prefix(sizeof(FileHeader));
+  units_ = reinterpret_cast<const Unit *>(mapped_units_.ptr());
+  num_units_ = header.num_units;
+  num_words_ = header.num_words;
+  built_units_.clear();
+  built_units_.shrink_to_fit();
+  return true;
 }
 
-WordPrefixSetState WordPrefixSet::empty_state() {
+WordPrefixSetState WordPrefixSet::empty_state() const {
   WordPrefixSetState empty;
-  empty.length = 0;
-  empty.start = 0;
-  empty.end = (trie_chars_.size() != 0) ? trie_chars_[0].size() : 0;
+  empty.node = 0;
   empty.weight = false;
   return empty;
 }
 
-bool WordPrefixSet::append_character(int character, WordPrefixSetState& state) {
-  for (size_t next_index = state.start; next_index < state.end; next_index++)
-    if (trie_chars_[state.length][next_index] == character) {
-      state.start = trie_starts_[state.length][next_index];
-      state.end = trie_starts_[state.length][next_index + 1];
-      state.weight |= trie_weights_[state.length][next_index];
-      state.length++;
-      return true;
-    }
-  state.length = 0;
-  state.start = 0;
-  state.end = (trie_chars_.size() != 0) ? trie_chars_[0].size() : 0;
-  state.weight = false;
+bool WordPrefixSet::append_character(int character, WordPrefixSetState& state) const {
+  // Negative characters become too large to be in the array
+  const size_t next = size_t(units_[state.node].base) + uint32_t(character);
+  if (next < num_units_ && (units_[next].check & ~kFinalArc) == state.node + 1) {
+    state.node = static_cast<uint32_t>(next);
+    state.weight |= (units_[next].check & kFinalArc) != 0;
+    return true;
+  }
+  state = empty_state();
   return false;
 }
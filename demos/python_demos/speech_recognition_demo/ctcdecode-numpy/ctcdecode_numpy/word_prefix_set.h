@@ -11,14 +11,15 @@
 #define WORD_PREFIX_SET_H
 
 #include <vector>
+#include <string>
+#include <cstddef>
 #include <cstdint>
 
+#include "yoklm/memory_section.hpp"
+
 struct WordPrefixSetState {
-  // Length of the current prefix
-  size_t length;
-  // Starting and ending indices in the arrays for the next trie layer, that is in trie_*[length] if it exists
-  // When trie_*[length] do not exist, we have start==end==0.
-  size_t start, end;
+  // Trie node of the current prefix, the root node 0 is the empty prefix
+  uint32_t node;
   // Weight of the current prefix defines as the logical OR of the weights of all its trie arcs.
   // "weight" must be public.
   bool weight;
@@ -26,35 +27,59 @@ struct WordPrefixSetState {
 
 class WordPrefixSet {
 public:
-  WordPrefixSet() = default;
+  WordPrefixSet();
   WordPrefixSet(const WordPrefixSet&) = delete;
-  WordPrefixSet& operator=(const WordPrefixSet&) = default;
+  WordPrefixSet& operator=(const WordPrefixSet&) = delete;
 
   // Fill (replace) prefix set with all prefixes of the provided words.
+  // The characters must be non-negative.
   // Return the number of unique full words.
   size_t add_words(const std::vector<std::vector<int> >& words);
 
+  // Return the number of unique full words
+  size_t num_words() const { return num_words_; }
+
+  // Save the prefix set to a file together with the tag identifying the words
+  // it is built from.  The file is in the native byte order.
+  // Throws an exception if cannot.
+  void save(const std::string& filename, uint64_t tag) const;
+
+  // Replace the prefix set with the one saved to the file, the file is mapped
+  // into memory.  Return false and keep the current prefix set if the file
+  // does not exist, has a different tag or is saved by another version.
+  // Throws an exception if the file is broken.
+  bool load(const std::string& filename, uint64_t tag);
+
   // Get a new state corresponding to an empty string
-  WordPrefixSetState empty_state();
+  WordPrefixSetState empty_state() const;
 
   // Append a character, and update state in place.
   // If the new state would correspond to a non-existent prefix, return false
   // and reset to an empty state.
   // Return true if the new prefix exists (that is, it is a prefix of a word in
   // the vocabulary).
-  bool append_character(int character, WordPrefixSetState& state);
+  bool append_character(int character, WordPrefixSetState& state) const;
 
 private:
-  // Each trie node is a triple (len, start, end), that is accessible from the root (0,0,len(trie_chars_[0])).
-  // Node's children arc labels are trie_chars_[len][index] for index in [begin, end).
-  // If trie_chars_[len] exists, then it has at least one element.
-  std::vector<std::vector<int>> trie_chars_;
-  // Node's children nodes ranges (begin,end) = (trie_starts_[len][index], trie_starts_[len][index+1]).
-  // trie_starts_[len] is always one element longer than trie_chars_[len].
-  std::vector<std::vector<size_t>> trie_starts_;
-  // Weights of the children arcs. Weight of the prefix is logical OR of its arcs.
-  // It is ad-hoc initialized to true for the final arcs in the words.
-  std::vector<std::vector<bool>> trie_weights_;
+  // Double-array trie: the child of node s with the arc label c is the node
+  // t = units_[s].base + c if units_[t].check is s+1 (without the kFinalArc bit).
+  // So a transition reads two units, and the children of a node are adjacent.
+  struct Unit {
+    uint32_t base;
+    // Parent node plus one, 0 for the free units.  The kFinalArc bit marks
+    // the arcs ending words, it is the weight of the arc.
+    uint32_t check;
+  };
+  static const uint32_t kFinalArc = 0x80000000u;
+
+  void use_built_units();
+
+  // The units are either built by add_words() or mapped by load()
+  std::vector<Unit> built_units_;
+  yoklm::MemorySection mapped_units_;
+  const Unit* units_;
+  size_t num_units_;
+  size_t num_words_;
 };
 
 #endif  // WORD_PREFIX_SET_H
@@ -31,7 +31,7 @@ struct KenlmV5LmFixedParametersFormat {
   uint8_t lm_order;
       char padding_probing_multiplier[3];
   float probing_multiplier;  // not used with this model_type/search_type
-  int32_t model_type;  // we only support 5 = quantized model with trie and arrays in Bhiksha format
+  int32_t model_type;  // we only support tries: 2 + (1 if quantized) + (2 if pointers are in Bhiksha format)
   int8_t with_vocabulary_strings;  // bool
       char padding_search_type[3];
   uint32_t search_type;  // we only support 1 = trie search
@@ -45,6 +45,11 @@ struct KenlmV5QuantizationHeaderFormat {
       uint8_t padding[5];
 };
 
+// The trie model types of kenlm
+const int32_t KENLM_MODEL_TYPE_TRIE = 2;
+const int32_t KENLM_MODEL_TYPE_QUANT_FLAG = 1;
+const int32_t KENLM_MODEL_TYPE_BHIKSHA_FLAG = 2;
+
 const int SIZE_KenlmV5BhikshaArrayHeaderFormat = 8;
 struct KenlmV5BhikshaArrayHeaderFormat {
   uint8_t bhiksha_type;  // we only support 0, which is the only type currently
@@ -54,11 +59,11 @@ struct KenlmV5BhikshaArrayHeaderFormat {
 
 
 KenlmV5Loader::KenlmV5Loader() : lm_config_(), vocabulary_config_(),
-    whole_file_(), with_vocabulary_strings_(false),
+    whole_file_(), with_vocabulary_strings_(false), with_bhiksha_arrays_(false),
     debug_print_sections_(false) {}
 
 void KenlmV5Loader::parse(const std::string& filename) {
-  parse(load_file(filename));
+  parse(map_file(filename));
 }
 
 void KenlmV5Loader::parse(MemorySection mem) {
@@ -117,8 +122,12 @@ MemorySection KenlmV5Loader::_parse_lm_config(MemorySection mem) {
     throw std::logic_error("Wrong size of KenlmV5LmFixedParametersFormat in the code.");
   const KenlmV5LmFixedParametersFormat& fixed_params = mem.at0_and_drop_prefix<KenlmV5LmFixedParametersFormat>();
 
-  if (fixed_params.model_type != 5 || fixed_params.search_type != 1)
-    throw std::runtime_error("KenlmV5 format: unsupported model_type/search_type. Only trie + quantization + Bhiksha arrays model type supported.");
+  const int32_t trie_flags = fixed_params.model_type - KENLM_MODEL_TYPE_TRIE;
+  if (trie_flags < 0 || trie_flags > (KENLM_MODEL_TYPE_QUANT_FLAG | KENLM_MODEL_TYPE_BHIKSHA_FLAG) ||
+      fixed_params.search_type != 1)
+    throw std::runtime_error("KenlmV5 format: unsupported model_type/search_type. Only trie model types supported.");
+  lm_config_.quantized = (trie_flags & KENLM_MODEL_TYPE_QUANT_FLAG) != 0;
+  with_bhiksha_arrays_ = (trie_flags & KENLM_MODEL_TYPE_BHIKSHA_FLAG) != 0;
 
   with_vocabulary_strings_ = (bool)fixed_params.with_vocabulary_strings;
 
@@ -169,20 +178,28 @@ MemorySection KenlmV5Loader::_parse_lm(MemorySection mem) {
   if (debug_print_sections_)
     std::cout << "_parse_lm offset= " << mem.offset(whole_file_) << std::endl;
 
-  if (sizeof(KenlmV5QuantizationHeaderFormat) != SIZE_KenlmV5QuantizationHeaderFormat)
-    throw std::logic_error("Wrong size of KenlmV5QuantizationHeaderFormat in the code.");
-  const KenlmV5QuantizationHeaderFormat& quant_header = mem.at0_and_drop_prefix<KenlmV5QuantizationHeaderFormat>();
-  if (quant_header.quantization_type != 2)
-    throw std::runtime_error("KenlmV5 format: unsupported quantization_type. Only quantized models are supported.");
-
-  lm_config_.prob_bits = quant_header.prob_bits;
-  lm_config_.backoff_bits = quant_header.backoff_bits;
-  if (lm_config_.prob_bits < 0 || lm_config_.prob_bits > 24)
-    throw std::runtime_error("KenlmV5 format: prob_bits must be from 0 to 24");
-  if (lm_config_.backoff_bits < 0 || lm_config_.backoff_bits > 24)
-    throw std::runtime_error("KenlmV5 format: backoff_bits must be from 0 to 24");
-
-  mem = _parse_lm_quant(mem);
+  if (lm_config_.quantized) {
+    if (sizeof(KenlmV5QuantizationHeaderFormat) != SIZE_KenlmV5QuantizationHeaderFormat)
+      throw std::logic_error("Wrong size of KenlmV5QuantizationHeaderFormat in the code.");
+    const KenlmV5QuantizationHeaderFormat& quant_header = mem.at0_and_drop_prefix<KenlmV5QuantizationHeaderFormat>();
+    if (quant_header.quantization_type != 2)
+      throw std::runtime_error("KenlmV5 format: unsupported quantization_type.");
+
+    lm_config_.prob_bits = quant_header.prob_bits;
+    lm_config_.backoff_bits = quant_header.backoff_bits;
+    if (lm_config_.prob_bits < 0 || lm_config_.prob_bits > 24)
+      throw std::runtime_error("KenlmV5 format: prob_bits must be from 0 to 24");
+    if (lm_config_.backoff_bits < 0 || lm_config_.backoff_bits > 24)
+      throw std::runtime_error("KenlmV5 format: backoff_bits must be from 0 to 24");
+
+    mem = _parse_lm_quant(mem);
+  } else {
+    // Floats without quantization tables: log-probabilities are non-positive, so their sign bit is not stored
+    lm_config_.prob_bits = 31;
+    lm_config_.backoff_bits = 32;
+    lm_config_.prob_quant_tables.clear();
+    lm_config_.backoff_quant_tables.clear();
+  }
   mem = _parse_trie_unigram(mem);
   mem = _parse_trie_medium(mem);
   mem = _parse_trie_long(mem);
@@ -282,6 +299,16 @@ MemorySection KenlmV5Loader::_parse_bhiksha_highs(MemorySection mem, MediumLayer
   if (debug_print_sections_)
     std::cout << "_parse_bhiksha_highs offset= " << mem.offset(whole_file_) << std::endl;
 
+  if (!with_bhiksha_arrays_) {
+    // All bits of the pointers are in the bit array, so the lookup finds the high bits 0 in a one-element array
+    layer_config.bhiksha_total_bits = layer_config.bhiksha_low_bits = required_bits(max_value);
+    layer_config.bhiksha_highs_count = 1;
+    std::shared_ptr<ManagedMemory> zero_high = std::make_shared<ManagedMemory>(sizeof(uint64_t));
+    std::memset(zero_high->ptr(), 0, sizeof(uint64_t));
+    layer_config.bhiksha_highs = MemorySection(zero_high);
+    return mem;
+  }
+
   if (sizeof(KenlmV5BhikshaArrayHeaderFormat) != SIZE_KenlmV5BhikshaArrayHeaderFormat)
     throw std::logic_error("Wrong size of KenlmV5BhikshaArrayHeaderFormat in the code.");
   const KenlmV5BhikshaArrayHeaderFormat& bhiksha_header = mem.at0_and_drop_prefix<KenlmV5BhikshaArrayHeaderFormat>();
@@ -304,7 +331,7 @@ MemorySection KenlmV5Loader::_parse_bhiksha_highs(MemorySection mem, MediumLayer
     std::cout << "_parse_bhiksha_highs aligned offset= " << layer_config.bhiksha_highs.offset(whole_file_) << std::endl;
 
   if (layer_config.bhiksha_highs_count == 0 || layer_config.bhiksha_highs[0] != 0)
-    std::runtime_error("Broken LM file: bhisha_highs[0] != 0");
+    throw std::runtime_error("Broken LM file: bhisha_highs[0] != 0");
 
   return mem;
 }
@@ -326,14 +353,23 @@ MemorySection KenlmV5Loader::_parse_bitarray(MemorySection mem, MediumLayer& lay
   layer_config.word_field.mask = make_bitmask(word_index_bits);
   offset += word_index_bits;
 
-  layer_config.backoff_field.offset = offset;
-  layer_config.backoff_field.mask = make_bitmask(backoff_bits);
-  offset += backoff_bits;
+  // kenlm puts the backoff before the log-probability if quantized, and after it otherwise
+  if (lm_config_.quantized) {
+    layer_config.backoff_field.offset = offset;
+    layer_config.backoff_field.mask = make_bitmask(backoff_bits);
+    offset += backoff_bits;
+  }
 
   layer_config.prob_field.offset = offset;
   layer_config.prob_field.mask = make_bitmask(lm_config_.prob_bits);
   offset += lm_config_.prob_bits;
 
+  if (!lm_config_.quantized) {
+    layer_config.backoff_field.offset = offset;
+    layer_config.backoff_field.mask = make_bitmask(backoff_bits);
+    offset += backoff_bits;
+  }
+
   layer_config.bhiksha_low_field.offset = offset;
   layer_config.bhiksha_low_field.mask = make_bitmask(layer_config.bhiksha_low_bits);
   offset += layer_config.bhiksha_low_bits;
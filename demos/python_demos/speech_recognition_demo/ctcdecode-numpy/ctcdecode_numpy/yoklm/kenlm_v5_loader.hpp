@@ -46,6 +46,8 @@ class KenlmV5Loader {
     MemorySection whole_file_;
     // This flag is set by _parse_header(), and is used in _parse_vocabulary_strings()
     bool with_vocabulary_strings_;
+    // This flag is set by _parse_lm_config(), and is used in _parse_bhiksha_highs()
+    bool with_bhiksha_arrays_;
 
     mutable bool debug_print_sections_;
 
@@ -5,6 +5,8 @@
 
 #include <iostream>
 #include <algorithm>
+#include <stdexcept>
+#include <cstring>
 
 #include "sorted_search.hpp"
 #include "language_model.hpp"
@@ -14,15 +16,25 @@ namespace yoklm {
 
 float LanguageModel::log10_p_cond(WordIndex new_word, LmState& state) const {
   LmState new_state(config_.order);
+  prepare_ngram(new_word, state, new_state);
+
+  // First fetch log10-p without backoff, then add backoff
+  float p = find_ngram(new_state);
+  return apply_backoffs(p, state, new_state);
+}
+
+void LanguageModel::prepare_ngram(WordIndex new_word, LmState& state, LmState& new_state) const {
   std::vector<WordIndex>& words = new_state.context_words;  // a shorthand
 
   words = std::move(state.context_words);
   if (words.size() > config_.order - 1)  // just in case
     words.resize(config_.order - 1);
   words.insert(words.begin(), new_word);
+}
+
+float LanguageModel::apply_backoffs(float p, LmState& state, LmState& new_state) const {
+  std::vector<WordIndex>& words = new_state.context_words;  // a shorthand
 
-  // First fetch log10-p without backoff, then add backoff
-  float p = find_ngram(new_state);
   // The length of the longest sententce postfix present in the LM
   size_t ngram_length = new_state.backoffs.size();
   for (size_t k = ngram_length; k <= state.backoffs.size(); k++)
@@ -34,6 +46,100 @@ float LanguageModel::log10_p_cond(WordIndex new_word, LmState& state) const {
   return p;
 }
 
+void LanguageModel::log10_p_cond_batch(const std::vector<WordIndex>& new_words,
+                                       const std::vector<LmState*>& states,
+                                       std::vector<float>& probs) const {
+  const size_t num_queries = new_words.size();
+  const size_t order = config_.order;
+
+  // The n-grams of the queries in reverse order, as find_ngram() expects them, padded with 0 to the order.
+  // They are kept here and the states are updated in place, so their vectors aren't reallocated
+  std::vector<WordIndex> ngrams(num_queries * order, 0);
+  std::vector<size_t> ngram_lengths(num_queries);
+  // The queries are sorted by the last two words of their n-grams, so the n-grams with a common postfix
+  // are mostly neighbours. The padding only affects the order, the common postfixes are found below
+  std::vector<std::pair<std::pair<WordIndex, WordIndex>, size_t>> sort_keys(num_queries);
+  for (size_t i = 0; i < num_queries; i++) {
+    const std::vector<WordIndex>& context_words = states[i]->context_words;
+    const size_t context_length = std::min(context_words.size(), order - 1);
+    WordIndex * ngram = &ngrams[i * order];
+    ngram[0] = new_words[i];
+    std::copy(context_words.begin(), context_words.begin() + context_length, ngram + 1);
+    ngram_lengths[i] = context_length + 1;
+    sort_keys[i] = std::make_pair(std::make_pair(ngram[0], order > 1 ? ngram[1] : 0), i);
+  }
+  std::sort(sort_keys.begin(), sort_keys.end());
+
+  // The search in the trie after each word of the previous n-gram
+  struct SearchLevel {
+    float p;
+    float backoff;
+    uint64_t l, r;
+  };
+  std::vector<SearchLevel> levels;
+  levels.reserve(order);
+  // The results of the search: raw p-values and backoffs of the found postfixes as find_ngram() returns them
+  std::vector<float> found_backoffs(num_queries * order);
+  std::vector<size_t> found_lengths(num_queries);
+  probs.resize(num_queries);
+
+  const UncheckedArray<UnigramNodeFormat> unigram_layer(config_.unigram_layer);
+  const size_t prefetch_distance = 4;
+  for (size_t q = 0; q < num_queries; q++) {
+#if defined(__GNUC__)
+    // The searches of the next n-grams start at their unigrams, fetch them in advance
+    if (q + prefetch_distance < num_queries)
+      __builtin_prefetch(&unigram_layer[ngrams[sort_keys[q + prefetch_distance].second * order]]);
+#endif
+    const size_t i = sort_keys[q].second;
+    const WordIndex * ngram = &ngrams[i * order];
+    const size_t ngram_length = ngram_lengths[i];
+
+    // The levels of the words in common with the previous n-gram are kept
+    size_t common_length = 0;
+    if (q > 0) {
+      const WordIndex * previous_ngram = &ngrams[sort_keys[q-1].second * order];
+      while (common_length < levels.size() && common_length < ngram_length
+             && ngram[common_length] == previous_ngram[common_length])
+        common_length++;
+    }
+    levels.resize(common_length);
+
+    if (levels.empty()) {
+      // 1-gram
+      SearchLevel level;
+      level.p = config_.unigram_layer[ngram[0]].prob;
+      level.backoff = config_.unigram_layer[ngram[0]].backoff;
+      level.l = config_.unigram_layer[ngram[0]].start_index;
+      level.r = config_.unigram_layer[ngram[0] + 1].start_index;
+      levels.push_back(level);
+    }
+    while (levels.size() < ngram_length && levels.back().l < levels.back().r) {
+      const size_t k = levels.size() + 1;
+      SearchLevel level = levels.back();
+      if (!find_in_layer(k, ngram[k-1], level.l, level.r, level.p, level.backoff))
+        break;
+      levels.push_back(level);
+    }
+
+    for (size_t k = 0; k < levels.size(); k++)
+      found_backoffs[i * order + k] = levels[k].backoff;
+    found_lengths[i] = levels.size();
+    probs[i] = levels.back().p;
+  }
+
+  // The same as apply_backoffs(), but the new state is in the arrays
+  for (size_t i = 0; i < num_queries; i++) {
+    LmState& state = *states[i];
+    for (size_t k = found_lengths[i]; k <= state.backoffs.size(); k++)
+      probs[i] += state.backoffs[k-1];
+
+    state.backoffs.assign(found_backoffs.begin() + i * order, found_backoffs.begin() + i * order + found_lengths[i]);
+    state.context_words.assign(ngrams.begin() + i * order,
+                               ngrams.begin() + i * order + std::min(ngram_lengths[i], order - 1));
+  }
+}
+
 //   Preconditions:
 // bhiksha_highs is non-decreasing array, bhiksha_highs[0] = 0
 // bhiksha_highs_count > 0 is the number of elements in bhiksha_highs
@@ -49,21 +155,30 @@ std::pair<uint64_t, uint64_t> bhiksha_lookup(
     uint64_t index)
 {
   // Find l = the last index with bhiksha_highs[l] <= index
-  const uint64_t l = binary_search<MemorySectionArray<uint64_t>, uint64_t, uint64_t>(
-    bhiksha_highs,
+  const UncheckedArray<uint64_t> highs(bhiksha_highs);
+  const uint64_t l = binary_search<UncheckedArray<uint64_t>, uint64_t, uint64_t>(
+    highs,
     0, bhiksha_highs_count,  // kenlm files have bhiksha_highs[0] = 0
     index
   );
 
   // Find r = the last index with bhiksha_highs[r] <= index+1
   uint64_t r = l + 1;
-  while (r < bhiksha_highs_count && bhiksha_highs[r] == (index + 1))
+  while (r < bhiksha_highs_count && highs[r] == (index + 1))
     r++;
   r--;
 
   return std::make_pair(l, r);
 }
 
+// Returns the float with the binary representation in the low 32 bits
+inline float float_from_bits(uint64_t bits) {
+  const uint32_t bits32 = static_cast<uint32_t>(bits);
+  float value;
+  std::memcpy(&value, &bits32, sizeof(value));
+  return value;
+}
+
 float LanguageModel::find_ngram(LmState& words_backoffs) const {
   const std::vector<WordIndex>& words = words_backoffs.context_words;
   std::vector<float>& backoffs = words_backoffs.backoffs;
@@ -80,44 +195,61 @@ float LanguageModel::find_ngram(LmState& words_backoffs) const {
   r = config_.unigram_layer[words[0] + 1].start_index;
 
   // Medium trie layers: 2-gram .. (n-1)-gram, and including n-gram.
-  const WordIndex not_found = (WordIndex)(-1);
   for (size_t k = 2; k <= config_.order && k < words.size() + 1 && l < r; k++) {
-    const WordIndex word = words[k-1];
-    const MediumLayer& layer = config_.medium_layers[k-2];
-
-    const uint64_t index = secant_search<MemorySectionBitArray, WordIndex, uint64_t>(
-      layer.bit_array,  // array
-      l, r,  // l, r
-      0, config_.ngram_counts[0],  // plv, rv
-      not_found,  // not_found
-      word  // value
-    );
-
-    if (index == not_found)
+    float backoff;
+    if (!find_in_layer(k, words[k-1], l, r, p, backoff))
       break;
-    p = config_.prob_quant_tables[k-2][layer.bit_array(index, layer.prob_field)];
-    if (k >= config_.order) {
-      // No backoff in full n-grams.
-      // But we use backoffs.size() to indicate the length of the longest postfix k-gram present in the LM
-      backoffs.push_back(0);
-      break;
-    }
+    // No backoff in full n-grams, it's 0 for them.
+    // But we use backoffs.size() to indicate the length of the longest postfix k-gram present in the LM
+    backoffs.push_back(backoff);
+  }
 
-    backoffs.push_back(config_.backoff_quant_tables[k-2][layer.bit_array(index, layer.backoff_field)]);
+  return p;
+}
 
-    // Fetch index range in the next layer
-    const uint64_t next_l_low = layer.bit_array(index, layer.bhiksha_low_field);
-    const uint64_t next_r_low = layer.bit_array(index + 1, layer.bhiksha_low_field);
-    const std::pair<uint64_t, uint64_t> next_high_lr =
-      bhiksha_lookup(layer.bhiksha_highs, layer.bhiksha_highs_count, index);
-    l = (next_high_lr.first << layer.bhiksha_low_bits) + next_l_low;
-    r = (next_high_lr.second << layer.bhiksha_low_bits) + next_r_low;
+bool LanguageModel::find_in_layer(size_t k, WordIndex word, uint64_t& l, uint64_t& r, float& p,
+                                  float& backoff) const {
+  const MediumLayer& layer = config_.medium_layers[k-2];
 
-    if (l >= r)
-      break;
+  // l and r come from the file, so they are checked once for the unchecked search in the layer.
+  // The search reads the records in [l, r), and the record after the found one is read for bhiksha_low
+  if (r >= layer.bit_array.index_limit())
+    throw std::runtime_error("Broken LM file: trie index range exceeds the layer of " + std::to_string(k) + "-grams");
+  const UncheckedBitArray bit_array(layer.bit_array);
+
+  const WordIndex not_found = (WordIndex)(-1);
+  const uint64_t index = secant_search<UncheckedBitArray, WordIndex, uint64_t>(
+    bit_array,  // array
+    l, r,  // l, r
+    0, config_.ngram_counts[0],  // plv, rv
+    not_found,  // not_found
+    word  // value
+  );
+
+  if (index == not_found)
+    return false;
+  // The quantization tables have an element for every value of a field
+  const uint64_t prob_value = bit_array(index, layer.prob_field);
+  p = config_.quantized ? UncheckedArray<float>(config_.prob_quant_tables[k-2])[prob_value] :
+                          float_from_bits(prob_value | 0x80000000u);
+  if (k >= config_.order) {
+    backoff = 0;
+    l = r;
+    return true;
   }
 
-  return p;
+  const uint64_t backoff_value = bit_array(index, layer.backoff_field);
+  backoff = config_.quantized ? UncheckedArray<float>(config_.backoff_quant_tables[k-2])[backoff_value] :
+                                float_from_bits(backoff_value);
+
+  // Fetch index range in the next layer
+  const uint64_t next_l_low = bit_array(index, layer.bhiksha_low_field);
+  const uint64_t next_r_low = bit_array(index + 1, layer.bhiksha_low_field);
+  const std::pair<uint64_t, uint64_t> next_high_lr =
+    bhiksha_lookup(layer.bhiksha_highs, layer.bhiksha_highs_count, index);
+  l = (next_high_lr.first << layer.bhiksha_low_bits) + next_l_low;
+  r = (next_high_lr.second << layer.bhiksha_low_bits) + next_r_low;
+  return true;
 }
 
 
@@ -40,10 +40,13 @@ struct MediumLayer {
 struct LmConfig {
   size_t order;  // the value of n in n-gram
   std::vector<uint64_t> ngram_counts;  // ngram_count[k-1] = number of k-grams, vector length = order
-  int prob_bits;  // size of quantized representation of log-probability values; guaranteed to be in [0,24]
-  int backoff_bits;  // size of quantized representation of log-backoff values; guaranteed to be in [0,24]
-  std::vector<MemorySectionArray<float> > prob_quant_tables;  // [k-2] for k-grams, k=2...n
-  std::vector<MemorySectionArray<float> > backoff_quant_tables;  // [k-2] for k-grams, k=2...(n-1)
+  // With quantization, the bit arrays keep indices into the quantization tables, otherwise they keep
+  // the values as floats: log-probabilities without their (always set) sign bit and log-backoffs as is.
+  bool quantized;
+  int prob_bits;  // size of log-probability values in bit arrays; in [0,24] with quantization, 31 without
+  int backoff_bits;  // size of log-backoff values in bit arrays; in [0,24] with quantization, 32 without
+  std::vector<MemorySectionArray<float> > prob_quant_tables;  // [k-2] for k-grams, k=2...n; empty without quantization
+  std::vector<MemorySectionArray<float> > backoff_quant_tables;  // [k-2] for k-grams, k=2...(n-1); empty without quantization
   MemorySectionArray<UnigramNodeFormat> unigram_layer;
   std::vector<MediumLayer> medium_layers;
   //MediumLayer leaves_layer;
@@ -52,7 +55,8 @@ struct LmConfig {
 struct LmState {
   LmState() {}
   explicit LmState(int order) {
-    backoffs.reserve(order - 1);
+    // find_ngram() marks a full n-gram found with an extra 0 backoff
+    backoffs.reserve(order);
     context_words.reserve(order);
   }
 
@@ -69,6 +73,12 @@ class LanguageModel {
 
     //float log10_p_cond(const std::vector<WordIndex>& words) const;
     float log10_p_cond(WordIndex new_word, LmState& state) const;
+    // The same as log10_p_cond(new_words[i], *states[i]) for every i, the states must be distinct objects.
+    // The n-grams are searched in sorted order, so the n-grams with common last words share the search of their
+    // layers, it pays off when many states are extended with the same word
+    void log10_p_cond_batch(const std::vector<WordIndex>& new_words,
+                            const std::vector<LmState*>& states,
+                            std::vector<float>& probs) const;
 
     size_t order() const { return config_.order; };
     uint64_t num_words() const { return config_.ngram_counts[0]; };
@@ -82,7 +92,16 @@ class LanguageModel {
     //   * state.backoff.size(): the length of the longest n-gram present in the LM
     //   * state.backoff[]: state.backoff[k] if backoff for (k+1)-gram postfix
     float find_ngram(LmState& state) const;
-    //std::pair<uint64_t, uint64_t> bhiksha_lookup(const MemorySectionArray<uint64_t>& bhiksha_highs, uint64_t index) const;
+
+    // The search of the word in the k-th layer (k >= 2) in [l, r), the range of the subtrie of the (k-1)-gram
+    // postfix. If the k-gram is found, sets p and backoff for it and [l, r) to the range of its subtrie in the
+    // next layer, which is empty for full n-grams
+    bool find_in_layer(size_t k, WordIndex word, uint64_t& l, uint64_t& r, float& p, float& backoff) const;
+
+    // Puts the (new_word, state) n-gram to new_state, as find_ngram() expects it
+    void prepare_ngram(WordIndex new_word, LmState& state, LmState& new_state) const;
+    // Adds the backoffs of state for the n-gram found in new_state to the raw p-value, then moves new_state to state
+    float apply_backoffs(float p, LmState& state, LmState& new_state) const;
 };
 
 } // namespace yoklm
@@ -10,6 +10,14 @@
 
 #include "memory_section.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define YOKLM_HAVE_MMAP
+#endif
+
 
 namespace yoklm {
 
@@ -115,5 +123,66 @@ MemorySection load_file(const std::string& filename) {
   return MemorySection(mm);
 }
 
+#ifdef YOKLM_HAVE_MMAP
+namespace {
+
+class MappedMemory : public ManagedMemory {
+  public:
+    MappedMemory(void * ptr, size_t size) : ManagedMemory(nullptr, 0), ptr_(ptr), size_(size) {}
+    ~MappedMemory() override { munmap(ptr_, size_); }
+
+    uint8_t * ptr() const override { return static_cast<uint8_t *>(ptr_); }
+    size_t size() const override { return size_; }
+
+  private:
+    void * ptr_;
+    size_t size_;
+}; // class MappedMemory
+
+} // namespace
+
+MemorySection map_file(const std::string& filename, bool populate) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    throw std::runtime_error("Cannot open file: " + filename);
+
+  struct stat sb;
+  if (fstat(fd, &sb) != 0) {
+    close(fd);
+    throw std::runtime_error("Cannot get size of file: " + filename);
+  }
+  if (uintmax_t(sb.st_size) >= std::numeric_limits<size_t>::max()) {
+    close(fd);
+    throw std::range_error("File size exceeds size_t: " + filename);
+  }
+  const size_t file_length = sb.st_size;
+  if (file_length == 0) {
+    // mmap() doesn't map empty files
+    close(fd);
+    return MemorySection(std::make_shared<ManagedMemory>(0));
+  }
+
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (populate)
+    flags |= MAP_POPULATE;
+#endif
+  void * ptr = mmap(nullptr, file_length, PROT_READ, flags, fd, 0);
+  close(fd);  // the mapping keeps the file
+  if (ptr == MAP_FAILED)
+    throw std::runtime_error("Cannot map file: " + filename);
+
+  // The trie is searched at random positions, so reading ahead of the
+  // accessed pages is useless unless all of them are needed anyway
+  madvise(ptr, file_length, populate ? MADV_WILLNEED : MADV_RANDOM);
+
+  return MemorySection(std::make_shared<MappedMemory>(ptr, file_length));
+}
+#else
+MemorySection map_file(const std::string& filename, bool) {
+  return load_file(filename);
+}
+#endif
+
 
 } // namespace yoklm
@@ -10,6 +10,7 @@
 #include <string>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
@@ -27,11 +28,13 @@ class ManagedMemory {
     ManagedMemory& operator=(const ManagedMemory& mm) = delete;
     virtual ~ManagedMemory() { delete[] ptr_; }
 
-    // TODO: add alignment
+    // The memory is aligned to alignof(std::max_align_t), so the arrays
+    // of a file read into it are aligned if their offsets in the file are.
     ManagedMemory(size_t size) : ptr_(new uint8_t[size]), size_(size) {}
-  private:
+  protected:
     // The caller transfers ownership of *ptr.
     // ptr must have been created with new uint8_t[...] in case of the default destructor.
+    // Subclasses managing the memory themselves pass nullptr and override ptr() and size().
     ManagedMemory(uint8_t * ptr, size_t size) : ptr_(ptr), size_(size) {}
   public:
 
@@ -129,10 +132,8 @@ class MemorySectionBitArray : public MemorySection {
         : MemorySection(ms), stride_(0), bit_field_{}, index_limit_(0) {}
 
     // Inline for efficiency.
-    // Expects index to be inside bound, and not cause segfault on the last element.
     uint64_t operator()(size_t index, const BitField& bf) const {
       size_t bit_index = index * stride_ + bf.offset;
-      // We don't check for the end of uint64_t stick outside the array.  It's mainly for testing anyway.
       if (index >= index_limit_)
         throw std::logic_error("Out of bounds access in MemorySectionBitArray");
       uint64_t data = *reinterpret_cast<const uint64_t *>(&ptr()[bit_index / 8]) >> (bit_index & 7);  // unaligned read
@@ -140,9 +141,14 @@ class MemorySectionBitArray : public MemorySection {
     }
     uint64_t operator[](size_t index) const { return operator()(index, bit_field_); }
 
-    void set_stride(int stride) { stride_ = stride; index_limit_ = size() * 8 / stride; }
+    // The uint64_t read of a record must not stick outside the array, so the
+    // records of the last 8 bytes are out of bounds (kenlm pads bit arrays by 8 bytes)
+    void set_stride(int stride) { stride_ = stride; index_limit_ = size() > 8 ? (size() - 8) * 8 / stride : 0; }
     void set_bit_field(const BitField& bf) { bit_field_ = bf; }
     int stride() const { return stride_; }
+    const BitField& bit_field() const { return bit_field_; }
+    // Indices less than index_limit() are inside the array
+    size_t index_limit() const { return index_limit_; }
 
   private:
     int stride_;  // for operator[] and operator()
@@ -150,9 +156,62 @@ class MemorySectionBitArray : public MemorySection {
     uint32_t index_limit_;
 }; // class MemorySectionBitArray
 
+// Unchecked views of the arrays for the search loops, the caller checks the
+// range of indices once before the loop.
+// Define YOKLM_CHECKED_ACCESS to check every access as the arrays do.
+template <typename T>
+class UncheckedArray {
+  public:
+    explicit UncheckedArray(const MemorySectionArray<T>& array)
+        : array_(array), data_(reinterpret_cast<const T *>(array.ptr())) {}
+
+    const T& operator[](size_t index) const {
+#ifdef YOKLM_CHECKED_ACCESS
+      return array_[index];
+#else
+      return data_[index];
+#endif
+    }
+
+  private:
+    const MemorySectionArray<T>& array_;
+    const T * data_;
+}; // class UncheckedArray
+
+class UncheckedBitArray {
+  public:
+    explicit UncheckedBitArray(const MemorySectionBitArray& array)
+        : array_(array), data_(array.ptr()), stride_(array.stride()), bit_field_(array.bit_field()) {}
+
+    uint64_t operator()(size_t index, const BitField& bf) const {
+#ifdef YOKLM_CHECKED_ACCESS
+      return array_(index, bf);
+#else
+      size_t bit_index = index * stride_ + bf.offset;
+      uint64_t data;
+      std::memcpy(&data, data_ + bit_index / 8, sizeof(data));  // unaligned read
+      return (data >> (bit_index & 7)) & bf.mask;
+#endif
+    }
+    uint64_t operator[](size_t index) const { return operator()(index, bit_field_); }
+
+  private:
+    const MemorySectionBitArray& array_;
+    const uint8_t * data_;
+    size_t stride_;
+    BitField bit_field_;
+}; // class UncheckedBitArray
+
 // Throws an exception if cannot.
 MemorySection load_file(const std::string& filename);
 
+// Maps the file read-only: its pages are read on the first access and
+// shared with other processes mapping the same file. The mapping is
+// page-aligned. With populate=true all the pages are read in advance.
+// Reads the file with load_file() if memory mapping is not supported.
+// Throws an exception if cannot.
+MemorySection map_file(const std::string& filename, bool populate = false);
+
 } // namespace yoklm
 
 
@@ -0,0 +1,103 @@
+/*********************************************************************
+* Copyright (c) 2020 Intel Corporation
+* SPDX-License-Identifier: Apache-2.0
+**********************************************************************/
+
+#include <algorithm>
+
+#include "ngram_cache.hpp"
+
+
+namespace yoklm {
+
+NgramCache::Key::Key(WordIndex word, const LmState& state)
+    : hash(0), length(state.context_words.size() + 1) {
+  if (!is_cacheable())
+    return;
+  words[0] = word;
+  std::copy(state.context_words.begin(), state.context_words.end(), words + 1);
+  // Every word is mixed in with the finalizer of MurmurHash3
+  uint64_t h = length;
+  for (size_t i = 0; i < length; i++) {
+    h ^= words[i] + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+  }
+  // 0 marks the empty entries
+  hash = h ? h : 1;
+}
+
+NgramCache::NgramCache(size_t memory_budget)
+    : num_sets_(memory_budget / sizeof(Entry) / ways),
+      entries_(num_sets_ * ways),
+      stripes_(new Stripe[num_stripes]) {
+  for (Entry& entry : entries_)
+    entry.hash = 0;
+}
+
+bool NgramCache::matches(const Entry& entry, const Key& key) {
+  return entry.hash == key.hash && entry.length == key.length
+      && std::equal(key.words, key.words + key.length, entry.words);
+}
+
+bool NgramCache::find(const Key& key, float& log10_p, LmState& state) {
+  if (num_sets_ == 0 || !key.is_cacheable())
+    return false;
+  const size_t set = set_index(key);
+  Stripe& set_stripe = stripe(set);
+  std::lock_guard<std::mutex> lock(set_stripe.mutex);
+  set_stripe.stats.lookups++;
+  Entry* entries = &entries_[set * ways];
+  for (size_t i = 0; i < ways; i++) {
+    Entry& entry = entries[i];
+    if (!matches(entry, key))
+      continue;
+    entry.last_use = ++set_stripe.clock;
+    set_stripe.stats.hits++;
+    log10_p = entry.log10_p;
+    state.context_words.assign(entry.words, entry.words + entry.num_context_words);
+    state.backoffs.assign(entry.backoffs, entry.backoffs + entry.num_backoffs);
+    return true;
+  }
+  return false;
+}
+
+void NgramCache::insert(const Key& key, float log10_p, const LmState& state) {
+  if (num_sets_ == 0 || !key.is_cacheable() || state.backoffs.size() > max_order
+      || state.context_words.size() > key.length)
+    return;
+  const size_t set = set_index(key);
+  Stripe& set_stripe = stripe(set);
+  std::lock_guard<std::mutex> lock(set_stripe.mutex);
+  Entry* entries = &entries_[set * ways];
+  // An empty or the least recently used entry is replaced, unless another thread has cached the query
+  Entry* victim = entries;
+  for (size_t i = 0; i < ways; i++) {
+    Entry& entry = entries[i];
+    if (matches(entry, key))
+      return;
+    if (victim->hash != 0 && (entry.hash == 0 || entry.last_use < victim->last_use))
+      victim = &entry;
+  }
+  victim->hash = key.hash;
+  victim->last_use = ++set_stripe.clock;
+  std::copy(key.words, key.words + key.length, victim->words);
+  std::copy(state.backoffs.begin(), state.backoffs.end(), victim->backoffs);
+  victim->log10_p = log10_p;
+  victim->length = static_cast<uint8_t>(key.length);
+  victim->num_backoffs = static_cast<uint8_t>(state.backoffs.size());
+  victim->num_context_words = static_cast<uint8_t>(state.context_words.size());
+}
+
+NgramCache::Stats NgramCache::stats() const {
+  Stats total;
+  for (size_t i = 0; i < num_stripes; i++) {
+    std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+    total.hits += stripes_[i].stats.hits;
+    total.lookups += stripes_[i].stats.lookups;
+  }
+  return total;
+}
+
+} // namespace yoklm
@@ -0,0 +1,92 @@
+/*********************************************************************
+* Copyright (c) 2020 Intel Corporation
+* SPDX-License-Identifier: Apache-2.0
+**********************************************************************/
+
+#ifndef YOKLM_NGRAM_CACHE_HPP
+#define YOKLM_NGRAM_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "word_index.hpp"
+#include "language_model.hpp"
+
+
+namespace yoklm {
+
+// Cache of LanguageModel::log10_p_cond() results shared by the decoding threads.
+// The result of a query only depends on the word and the context words of the state, so it's found by them
+// without searching the trie, and the state is advanced to the cached one.
+// The entries are kept in 4-way sets, the least recently used entry of a set is replaced. The sets are guarded
+// by striped locks, so the threads rarely wait for each other.
+class NgramCache {
+  public:
+    // The longest n-gram cached, the queries of higher order models are passed through
+    static const size_t max_order = 6;
+
+    // A query: the new word followed by the context words
+    struct Key {
+      Key(WordIndex word, const LmState& state);
+      bool is_cacheable() const { return length <= max_order; }
+
+      uint64_t hash;
+      size_t length;
+      WordIndex words[max_order];
+    };
+
+    struct Stats {
+      uint64_t hits = 0;
+      uint64_t lookups = 0;
+    };
+
+    // memory_budget is the size of the entries in bytes, 0 disables the cache
+    explicit NgramCache(size_t memory_budget);
+    NgramCache(const NgramCache&) = delete;
+    NgramCache& operator=(const NgramCache&) = delete;
+
+    // Return false if the query isn't cached. Otherwise set log10_p and advance the state like
+    // LanguageModel::log10_p_cond() does
+    bool find(const Key& key, float& log10_p, LmState& state);
+    // Cache the result of the query, state is the state after it
+    void insert(const Key& key, float log10_p, const LmState& state);
+
+    Stats stats() const;
+    size_t capacity() const { return entries_.size(); }
+
+  private:
+    static const size_t ways = 4;
+    static const size_t num_stripes = 64;
+
+    struct Entry {
+      uint64_t hash;
+      uint64_t last_use;
+      WordIndex words[max_order];
+      float backoffs[max_order];
+      float log10_p;
+      uint8_t length;
+      uint8_t num_backoffs;
+      uint8_t num_context_words;
+    };
+
+    struct Stripe {
+      std::mutex mutex;
+      uint64_t clock = 0;
+      Stats stats;
+    };
+
+    static bool matches(const Entry& entry, const Key& key);
+    size_t set_index(const Key& key) const { return key.hash % num_sets_; }
+    Stripe& stripe(size_t set) { return stripes_[set % num_stripes]; }
+
+    size_t num_sets_;
+    std::vector<Entry> entries_;
+    std::unique_ptr<Stripe[]> stripes_;
+};
+
+} // namespace yoklm
+
+
+#endif // YOKLM_NGRAM_CACHE_HPP
@@ -3,6 +3,7 @@
 * SPDX-License-Identifier: Apache-2.0
 **********************************************************************/
 
+#include <algorithm>
 #include <limits>
 #include <cstdint>
 #include <cstring>
@@ -16,15 +17,91 @@ namespace yoklm {
 const uint64_t MURMUR64A_MUL = 0xc6a4a7935bd1e995ULL;
 const uint64_t MURMUR64A_SHR = 47;
 
+// The average number of words in a bucket of the perfect hash
+const size_t WORDS_PER_BUCKET = 4;
+const uint32_t NO_WORD = std::numeric_limits<uint32_t>::max();
+
+namespace {
+
+// The slot of the word displaced by the seed of its bucket.  The word hash is already uniform,
+// so the seed is only mixed in for the slots to differ from seed to seed
+uint64_t displace(WordHash word, uint32_t seed) {
+  uint64_t hash = word ^ ((uint64_t)seed * MURMUR64A_MUL);
+  hash ^= hash >> MURMUR64A_SHR;
+  hash *= MURMUR64A_MUL;
+  hash ^= hash >> MURMUR64A_SHR;
+  return hash;
+}
+
+} // namespace
+
 Vocabulary::Vocabulary() : config_(), bos_(WordIndex(-1)),
     eos_(WordIndex(-1)) {}
 
-void Vocabulary::load(const VocabularyConfig& config) {
+void Vocabulary::load(const VocabularyConfig& config, bool perfect_hash) {
   config_ = config;
+  bucket_seeds_.clear();
+  slot_words_.clear();
+  if (perfect_hash && !build_perfect_hash()) {
+    // find() falls back to the search
+    bucket_seeds_.clear();
+    slot_words_.clear();
+  }
   bos_ = find("<s>");
   eos_ = find("</s>");
 }
 
+bool Vocabulary::build_perfect_hash() {
+  // "-1" because "<unk>" is not present in word_hashes
+  const size_t num_hashes = config_.num_words - 1;
+  if (num_hashes == 0 || num_hashes >= NO_WORD)
+    return false;
+  const UncheckedArray<WordHash> word_hashes(config_.word_hashes);
+
+  const size_t num_buckets = (num_hashes + WORDS_PER_BUCKET - 1) / WORDS_PER_BUCKET;
+  std::vector<std::vector<uint32_t>> buckets(num_buckets);
+  for (size_t i = 0; i < num_hashes; i++)
+    buckets[word_hashes[i] % num_buckets].push_back((uint32_t)i);
+
+  // The largest buckets are placed first, while most of the slots are free
+  std::vector<uint32_t> order(num_buckets);
+  for (size_t b = 0; b < num_buckets; b++)
+    order[b] = (uint32_t)b;
+  std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  bucket_seeds_.assign(num_buckets, 0);
+  slot_words_.assign(num_hashes, NO_WORD);
+  // A single word takes num_hashes/(free slots) seeds on average, so the limit is hit only by
+  // the words whose hashes are equal
+  const uint64_t max_seed = std::min<uint64_t>(64 * (uint64_t)num_hashes + 1024, NO_WORD);
+  std::vector<size_t> slots;
+  for (uint32_t b : order) {
+    const std::vector<uint32_t>& bucket = buckets[b];
+    if (bucket.empty())
+      break;
+    uint32_t seed = 0;
+    for (;; seed++) {
+      if (seed >= max_seed)
+        return false;
+      slots.clear();
+      for (uint32_t word : bucket) {
+        const size_t slot = displace(word_hashes[word], seed) % num_hashes;
+        if (slot_words_[slot] != NO_WORD || std::find(slots.begin(), slots.end(), slot) != slots.end())
+          break;
+        slots.push_back(slot);
+      }
+      if (slots.size() == bucket.size())
+        break;
+    }
+    bucket_seeds_[b] = seed;
+    for (size_t i = 0; i < bucket.size(); i++)
+      slot_words_[slots[i]] = bucket[i];
+  }
+  return true;
+}
+
 // Little-endian order assumed.
 WordHash word_hash(const std::string& word) {
   const size_t size = word.size();
@@ -67,9 +144,17 @@ WordHash word_hash(const std::string& word) {
 }
 
 WordIndex Vocabulary::find(WordHash word) const {
+  if (!slot_words_.empty()) {
+    const uint32_t seed = bucket_seeds_[word % bucket_seeds_.size()];
+    const uint32_t index = slot_words_[displace(word, seed) % slot_words_.size()];
+    // A word absent in vocabulary is displaced to the slot of some other word
+    return config_.word_hashes[index] == word ? index + 1 : unk();
+  }
+
   // WordHash == uint64_t
-  WordIndex index = secant_search<MemorySectionArray<WordHash>, WordIndex, uint64_t>(
-    config_.word_hashes,  // array
+  // The loader checks that word_hashes has (num_words-1) elements
+  WordIndex index = secant_search<UncheckedArray<WordHash>, WordIndex, uint64_t>(
+    UncheckedArray<WordHash>(config_.word_hashes),  // array
     0, config_.num_words-1,  // l, r;  "-1" because "<unk>" is not present in word_hashes
     0, std::numeric_limits<uint64_t>::max(),  // plv, rv
     (WordIndex)(-1),  // not_found
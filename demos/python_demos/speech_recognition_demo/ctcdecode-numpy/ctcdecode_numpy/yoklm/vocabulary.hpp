@@ -6,6 +6,7 @@
 #ifndef YOKLM_VOCABULARY_HPP
 #define YOKLM_VOCABULARY_HPP
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -30,8 +31,10 @@ WordHash word_hash(const std::string& word);
 class Vocabulary {
   public:
     Vocabulary();
-    // Throw in case of an error
-    void load(const VocabularyConfig& config);
+    // Throw in case of an error.
+    // With perfect_hash a minimal perfect hash of word_hashes is built, so find() takes a single probe
+    // instead of searching the sorted word_hashes.  It takes about 4.5 bytes per word.
+    void load(const VocabularyConfig& config, bool perfect_hash = true);
 
     WordIndex find(WordHash word) const;
     WordIndex find(const std::string& word) const { return find(word_hash(word)); }
@@ -49,8 +52,18 @@ class Vocabulary {
     bool iterate_word_strings(Callback callback) const;
 
   private:
+    // Return false if the seeds aren't found, e.g. for repeated hashes
+    bool build_perfect_hash();
+
     VocabularyConfig config_;
     WordIndex bos_, eos_;
+
+    // CHD ("compress, hash and displace") perfect hash: a word goes to a bucket by its hash and the seed
+    // of the bucket displaces the words of the bucket to distinct slots.  slot_words_[slot] is the index in
+    // word_hashes of the word in the slot, find() compares it with the hash for words absent in vocabulary.
+    // Both are empty if there's no perfect hash.
+    std::vector<uint32_t> bucket_seeds_;
+    std::vector<uint32_t> slot_words_;
 };
 
 template <class Callback>
@@ -38,6 +38,9 @@ def build_argparser():
                         help="Beam width for beam search in CTC decoder (default 500)")
     parser.add_argument('-c', '--max-candidates', type=int, default=1, metavar="N",
                         help="Show top N (or less) candidates (default 1)")
+    parser.add_argument('--save-probs', type=str, metavar="FILENAME",
+                        help="Optional. Save the per-frame character probabilities to a .npy file, "
+                             "ctcdecode_numpy_bench replays them to benchmark the beam search")
 
     parser.add_argument('-l', '--cpu_extension', type=str, metavar="FILENAME",
                         help="Optional. Required for CPU custom layers. "
@@ -88,13 +91,17 @@ def main():
         audio_features = stt.extract_mfcc(audio, sampling_rate=sampling_rate)
     print("MFCC time: {} s".format(timer.elapsed))
 
+    # The beam search decodes every chunk of probabilities as soon as the RNN infers it
     with Timer() as timer:
-        character_probs = stt.extract_per_frame_probs(audio_features, wrap_iterator=tqdm)
-    print("RNN time: {} s".format(timer.elapsed))
+        decoder_stream = stt.create_decoder_stream()
+        probs = stt.extract_per_frame_probs(audio_features, wrap_iterator=tqdm, decoder_stream=decoder_stream)
+    print("RNN and streaming beam search time: {} s".format(timer.elapsed))
 
     with Timer() as timer:
-        transcription = stt.decode_probs(character_probs)
-    print("Beam search time: {} s".format(timer.elapsed))
+        transcription = decoder_stream.finalize()
+    print("Beam search finalization time: {} s".format(timer.elapsed))
+    if args.save_probs:
+        np.save(args.save_probs, probs.astype(np.float32))
     print("Overall time: {} s".format(timeit.default_timer() - start_time))
 
     print("\nTranscription and confidence score:")
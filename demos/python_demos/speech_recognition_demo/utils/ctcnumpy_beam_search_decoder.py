@@ -36,8 +36,39 @@ class CtcnumpyBeamSearchDecoder:
     def decode(self, probs):
         output, scores, timesteps, out_seq_len = self.decoder_state.decode(probs[np.newaxis])
         assert out_seq_len.shape[0] == 1
+        return self._beam_results(output[0], scores[0], timesteps[0], out_seq_len[0])
+
+    def create_stream(self):
+        return CtcnumpyBeamSearchDecoderStream(self)
+
+    def _beam_results(self, output, scores, timesteps, out_seq_len):
         beam_results = [
-            dict(conf=scores[0,res_idx], text=self.alphabet.decode(output[0,res_idx,:out_seq_len[0,res_idx]]), ts=list(timesteps[0,res_idx]))
-            for res_idx in range(out_seq_len.shape[1])
+            dict(conf=scores[res_idx], text=self.alphabet.decode(output[res_idx,:out_seq_len[res_idx]]), ts=list(timesteps[res_idx]))
+            for res_idx in range(out_seq_len.shape[0])
         ]
         return beam_results
+
+
+class CtcnumpyBeamSearchDecoderStream:
+    """
+    Decodes a single utterance while its probabilities are extracted, the results are the same as of decode()
+    """
+    def __init__(self, decoder):
+        self.decoder = decoder
+        self.stream = decoder.decoder_state.create_stream(decoder.max_candidates)
+        self.buffers = None
+
+    def feed(self, probs):
+        self.stream.feed(probs)
+
+    def partial_result(self):
+        # The partial results are converted right away, so the output arrays are reused while the utterance grows
+        if self.buffers is None or self.buffers[0].shape[1] < self.stream.num_frames:
+            max_len = self.stream.num_frames if self.buffers is None else 2 * self.buffers[0].shape[1]
+            self.buffers = self.stream.output_buffers(max(max_len, self.stream.num_frames))
+        max_len = self.stream.result_into(*self.buffers)
+        output, scores, timesteps, out_seq_len = self.buffers
+        return self.decoder._beam_results(output[:, :max_len], scores, timesteps[:, :max_len], out_seq_len)
+
+    def finalize(self):
+        return self.decoder._beam_results(*self.stream.finalize())
@@ -164,7 +164,12 @@ class DeepSpeechPipeline:
         features = melspectrum_to_mfcc(melspectrum, self.p['num_mfcc_dct_coefs'])
         return features
 
-    def extract_per_frame_probs(self, mfcc_features, state=None, return_state=False, wrap_iterator=lambda x:x):
+    def extract_per_frame_probs(self, mfcc_features, state=None, return_state=False, wrap_iterator=lambda x:x,
+                                decoder_stream=None):
+        """
+        decoder_stream (CtcnumpyBeamSearchDecoderStream or None), if given, is fed with the probabilities of every chunk
+            as soon as they are inferred
+        """
         assert self.exec_net is not None, "Need to call mds.activate(device) method before mds.stt(...)"
 
         padding = np.zeros((self.p['num_context_frames'] // 2, self.p['num_mfcc_dct_coefs']), dtype=mfcc_features.dtype)
@@ -207,6 +212,8 @@ class DeepSpeechPipeline:
                 'input_node': [chunk],
             })
             probs.append(res['logits'].squeeze(1))  # they are actually probabilities after softmax, not logits
+            if decoder_stream is not None:
+                decoder_stream.feed(probs[-1])
             state_h = res['cudnn_lstm/rnn/multi_rnn_cell/cell_0/cudnn_compatible_lstm_cell/BlockLSTM/TensorIterator.1']
             state_c = res['cudnn_lstm/rnn/multi_rnn_cell/cell_0/cudnn_compatible_lstm_cell/BlockLSTM/TensorIterator.2']
         probs = np.concatenate(probs)
@@ -216,6 +223,13 @@ class DeepSpeechPipeline:
         else:
             return probs, (state_h, state_c)
 
+    def create_decoder_stream(self):
+        """
+        Return a decoder stream of a single utterance for extract_per_frame_probs(), call its finalize() method
+        to get the transcription
+        """
+        return self.decoder.create_stream()
+
     def decode_probs(self, probs):
         """
         Return list of pairs (-log_score, text) in order of decreasing (audio+LM) score
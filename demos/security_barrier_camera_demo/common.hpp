@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <list>
 #include <memory>
@@ -56,7 +57,7 @@ struct HigherPriority {
 class Worker {
 public:
     explicit Worker(unsigned threadNum):
-        threadPool(threadNum), running{false} {}
+        threadPool(threadNum), running{false}, stateChanged{true} {}
     ~Worker() {
         stop();
     }
@@ -69,14 +70,30 @@ public:
     void push(std::shared_ptr<Task> task) {
         tasksMutex.lock();
         tasks.insert(task);
+        stateChanged = true;
+        tasksMutex.unlock();
+        tasksCondVar.notify_one();
+    }
+    // Tells that something the tasks wait for (a free InferRequest, a captured or shown frame) became available, so
+    // the pending tasks are worth checking again
+    void notifyStateChanged() {
+        tasksMutex.lock();
+        stateChanged = true;
         tasksMutex.unlock();
         tasksCondVar.notify_one();
     }
     void threadFunc() {
+        // Some tasks, like Drawer, get ready as time goes by without any notification
+        const std::chrono::milliseconds recheckPeriod{1};
         while (running) {
             std::unique_lock<std::mutex> lk(tasksMutex);
-            while (running && tasks.empty()) {
-                tasksCondVar.wait(lk);
+            // If none of the tasks was ready and nothing has changed since then, wait instead of checking them again
+            while (running && (tasks.empty() || !stateChanged)) {
+                if (tasks.empty()) {
+                    tasksCondVar.wait(lk);
+                } else if (std::cv_status::timeout == tasksCondVar.wait_for(lk, recheckPeriod)) {
+                    break;
+                }
             }
             try {
                 auto it = std::find_if(tasks.begin(), tasks.end(), [](const std::shared_ptr<Task>& task){return task->isReady();});
@@ -85,6 +102,10 @@ public:
                     tasks.erase(it);
                     lk.unlock();
                     task->process();
+                    // The task may have released what the other tasks wait for
+                    notifyStateChanged();
+                } else {
+                    stateChanged = false;
                 }
             } catch (...) {
                 std::lock_guard<std::mutex> lock{excpetionMutex};
@@ -114,6 +135,7 @@ private:
     std::mutex tasksMutex;
     std::vector<std::thread> threadPool;
     std::atomic<bool> running;
+    bool stateChanged;  // guarded by tasksMutex
     std::exception_ptr currentException;
     std::mutex excpetionMutex;
 };
@@ -124,6 +146,12 @@ void tryPush(const std::weak_ptr<Worker>& worker, std::shared_ptr<Task>&& task)
     } catch (const std::bad_weak_ptr&) {}
 }
 
+void tryNotify(const std::weak_ptr<Worker>& worker) {
+    try {
+        std::shared_ptr<Worker>(worker)->notifyStateChanged();
+    } catch (const std::bad_weak_ptr&) {}
+}
+
 template <class C> class ConcurrentContainer {
 public:
     C container;
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include <opencv2/core/core.hpp>
+#include <samples/text_cache.hpp>
 
 class GridMat {
 public:
@@ -123,5 +124,6 @@ void putTextOnImage(cv::Mat& displayImage, std::string str, cv::Point p,
     fillROIColor(displayImage, cv::Rect(cv::Point(p.x, p.y + baseline),
                                         cv::Point(p.x + textSize.width, p.y - textSize.height)),
                  bgcolor, opacity);
-    cv::putText(displayImage, str, p, font, fontScale, color, thickness);
+    static thread_local TextCache textCache;
+    textCache.putText(displayImage, str, p, font, fontScale, color, thickness);
 }
@@ -4,15 +4,17 @@
 
 #pragma once
 
-#include <list>
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <thread>
 #include <vector>
-#include <queue>
 
 #include <opencv2/core/core.hpp>
 
+#include <samples/images_capture.h>
+
 class InputChannel;
 
 class IInputSource {
@@ -31,6 +33,14 @@ private:
     std::mutex sourceLock;
 };
 
+// Frames of a source replicated to several channels share the same buffer, so they must not be modified.
+// Makes the frame's buffer owned by the caller only, copying it if it's shared
+inline void makeWritable(cv::Mat& frame) {
+    if (frame.u && CV_XADD(&frame.u->refcount, 0) > 1) {
+        frame = frame.clone();
+    }
+}
+
 class InputChannel: public std::enable_shared_from_this<InputChannel> {  // note: public inheritance
 public:
     InputChannel(const InputChannel&) = delete;
@@ -40,13 +50,14 @@ public:
         source->addSubscriber(tmp);
         return tmp;
     }
+    // The frame may share its buffer with frames of other channels, call makeWritable() before drawing on it
     bool read(cv::Mat& mat) {
         readQueueMutex.lock();
-        if (readQueue.empty()) {
+        if (0 == readQueueSize) {
             readQueueMutex.unlock();
             source->lock();
             readQueueMutex.lock();
-            if (readQueue.empty()) {
+            if (0 == readQueueSize) {
                 bool res = source->read(mat, shared_from_this());
                 readQueueMutex.unlock();
                 source->unlock();
@@ -55,14 +66,27 @@ public:
                 source->unlock();
             }
         }
-        mat = readQueue.front().clone();
-        readQueue.pop();
+        cv::Mat& front = readQueue[readQueueHead];
+        mat = front;
+        front.release();
+        readQueueHead = (readQueueHead + 1) % readQueue.size();
+        readQueueSize--;
         readQueueMutex.unlock();
         return true;
     }
     void push(const cv::Mat& mat) {
         readQueueMutex.lock();
-        readQueue.push(mat);
+        if (readQueue.size() == readQueueSize) {
+            // The ring is full: unroll it to the beginning of a twice larger one
+            std::vector<cv::Mat> grown(std::max(readQueue.size() * 2, size_t(INITIAL_QUEUE_SIZE)));
+            for (size_t i = 0; i < readQueueSize; ++i) {
+                grown[i] = readQueue[(readQueueHead + i) % readQueue.size()];
+            }
+            readQueue.swap(grown);
+            readQueueHead = 0;
+        }
+        readQueue[(readQueueHead + readQueueSize) % readQueue.size()] = mat;
+        readQueueSize++;
         readQueueMutex.unlock();
     }
     cv::Size getSize() {
@@ -70,27 +94,44 @@ public:
     }
 
 private:
-    explicit InputChannel(const std::shared_ptr<IInputSource>& source): source{source} {}
+    static constexpr size_t INITIAL_QUEUE_SIZE = 4;
+
+    explicit InputChannel(const std::shared_ptr<IInputSource>& source):
+        source{source}, readQueue(INITIAL_QUEUE_SIZE), readQueueHead{0}, readQueueSize{0} {}
     std::shared_ptr<IInputSource> source;
-    std::queue<cv::Mat, std::list<cv::Mat>> readQueue;
+    // Ring of frames read by other channels of the source for this channel
+    std::vector<cv::Mat> readQueue;
+    size_t readQueueHead;
+    size_t readQueueSize;
     std::mutex readQueueMutex;
 };
 
 class VideoCaptureSource: public IInputSource {
 public:
     VideoCaptureSource(const cv::VideoCapture& videoCapture, bool loop): videoCapture{videoCapture}, loop{loop},
-        imSize{static_cast<int>(videoCapture.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(videoCapture.get(cv::CAP_PROP_FRAME_HEIGHT))} {}
+        imSize{static_cast<int>(videoCapture.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(videoCapture.get(cv::CAP_PROP_FRAME_HEIGHT))},
+        framesRing(FRAMES_RING_SIZE), framesRingPos{0} {}
     bool read(cv::Mat& mat, const std::shared_ptr<InputChannel>& caller) override {
-        if (!videoCapture.read(mat)) {
+        mat.release();  // the caller's previous frame may hold a buffer of the ring
+        // Decode to a buffer of the ring which isn't referenced by any frame anymore,
+        // if all of them are in use, a new one is allocated instead of the busy one
+        cv::Mat& frame = framesRing[framesRingPos];
+        framesRingPos = (framesRingPos + 1) % framesRing.size();
+        if (frame.u && CV_XADD(&frame.u->refcount, 0) > 1) {
+            frame = cv::Mat();
+        }
+        if (!videoCapture.read(frame)) {
             if (loop) {
                 videoCapture.set(cv::CAP_PROP_POS_FRAMES, 0);
-                videoCapture.read(mat);
+                videoCapture.read(frame);
             } else {
                 return false;
             }
         }
+        // Every subscriber gets a reference to the same buffer
+        mat = frame;
         if (1 != subscribedInputChannels.size()) {
-            cv::Mat shared = mat.clone();
+            const cv::Mat& shared = frame;
             for (const std::weak_ptr<InputChannel>& weakInputChannel : subscribedInputChannels) {
                 try {
                     std::shared_ptr<InputChannel> sharedInputChannel = std::shared_ptr<InputChannel>(weakInputChannel);
@@ -110,10 +151,50 @@ public:
     }
 
 private:
+    static constexpr size_t FRAMES_RING_SIZE = 8;
+
     std::vector<std::weak_ptr<InputChannel>> subscribedInputChannels;
     cv::VideoCapture videoCapture;
     bool loop;
     cv::Size imSize;
+    std::vector<cv::Mat> framesRing;
+    size_t framesRingPos;
+};
+
+// Hands out frames of a synthetic input (see openImagesCapture()) from a ring generated once, without decoding or
+// copying. Every subscriber gets the same frames like from VideoCaptureSource, the source is endless
+class SyntheticSource: public IInputSource {
+public:
+    explicit SyntheticSource(cv::Size size): framesRing(makeSyntheticFrames(size, FRAMES_RING_SIZE)),
+        framesRingPos{0} {}
+    bool read(cv::Mat& mat, const std::shared_ptr<InputChannel>& caller) override {
+        mat = framesRing[framesRingPos];
+        framesRingPos = (framesRingPos + 1) % framesRing.size();
+        if (1 != subscribedInputChannels.size()) {
+            for (const std::weak_ptr<InputChannel>& weakInputChannel : subscribedInputChannels) {
+                try {
+                    std::shared_ptr<InputChannel> sharedInputChannel = std::shared_ptr<InputChannel>(weakInputChannel);
+                    if (caller != sharedInputChannel) {
+                        sharedInputChannel->push(mat);
+                    }
+                } catch (const std::bad_weak_ptr&) {}
+            }
+        }
+        return true;
+    }
+    void addSubscriber(const std::weak_ptr<InputChannel>& inputChannel) override {
+        subscribedInputChannels.push_back(inputChannel);
+    }
+    cv::Size getSize() override {
+        return framesRing.front().size();
+    }
+
+private:
+    static constexpr size_t FRAMES_RING_SIZE = 8;
+
+    std::vector<std::weak_ptr<InputChannel>> subscribedInputChannels;
+    std::vector<cv::Mat> framesRing;
+    size_t framesRingPos;
 };
 
 class ImageSource: public IInputSource {
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <deque>
 #include <iomanip>
 #include <list>
 #include <map>
@@ -13,14 +14,20 @@
 #include <utility>
 #include <vector>
 #include <set>
+#include <unordered_map>
 
 #include <cldnn/cldnn_config.hpp>
 #include <inference_engine.hpp>
 #include <vpu/hddl_config.hpp>
 #include <monitors/presenter.h>
 #include <samples/args_helper.hpp>
+#include <samples/frame_tracer.hpp>
+#include <samples/model_loader.hpp>
+#include <samples/mpmc_queue.hpp>
 #include <samples/ocv_common.hpp>
+#include <samples/results_writer.hpp>
 #include <samples/slog.hpp>
+#include <samples/thread_budget.hpp>
 
 #include "common.hpp"
 #include "grid_mat.hpp"
@@ -53,6 +60,12 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     if (FLAGS_n_wt == 0) {
         throw std::logic_error("-n_wt can not be zero");
     }
+    if (FLAGS_bs == 0) {
+        throw std::logic_error("-bs can not be zero");
+    }
+    if (FLAGS_bs_d == 0) {
+        throw std::logic_error("-bs_d can not be zero");
+    }
     return true;
 }
 
@@ -66,27 +79,69 @@ struct BboxAndDescr {
     std::string descr;
 };
 
-struct InferRequestsContainer {
+struct InferRequestsContainer {  // free InferRequests are kept in a lock-free queue, so taking and returning them never blocks
     InferRequestsContainer() = default;
     InferRequestsContainer(const InferRequestsContainer&) = delete;
     InferRequestsContainer& operator=(const InferRequestsContainer&) = delete;
 
     void assign(const std::vector<InferRequest>& inferRequests) {
         actualInferRequests = inferRequests;
-        this->inferRequests.container.clear();
+        freeInferRequests.reset(new MpmcQueue<InferRequest*>(std::max<std::size_t>(actualInferRequests.size(), 1)));
 
-        for (auto& ir : this->actualInferRequests) {
-            this->inferRequests.container.push_back(ir);
+        for (auto& ir : actualInferRequests) {
+            freeInferRequests->tryPush(&ir);
         }
     }
 
+    InferRequest* tryPop() {  // returns nullptr if there are no free InferRequests
+        InferRequest* inferRequest;
+        return freeInferRequests->tryPop(inferRequest) ? inferRequest : nullptr;
+    }
+
+    void push(InferRequest& inferRequest) {
+        freeInferRequests->tryPush(&inferRequest);  // the queue can hold all the InferRequests, so it never fails
+    }
+
+    std::size_t freeCount() const {
+        return freeInferRequests->sizeApprox();
+    }
+
     std::vector<InferRequest> getActualInferRequests() {
         return actualInferRequests;
     }
-    ConcurrentContainer<std::vector<std::reference_wrapper<InferRequest>>> inferRequests;
 
 private:
     std::vector<InferRequest> actualInferRequests;
+    std::unique_ptr<MpmcQueue<InferRequest*>> freeInferRequests;
+};
+
+class FramesDedup {  // coalesces the frames in flight sharing an image buffer onto one detection
+public:
+    // returns true if no other frame with the buffer of frame is being detected, otherwise frame waits for its detections
+    bool lead(const VideoFrame::Ptr& frame) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto followersIt = followers.find(frame->frame.data);
+        if (followers.end() == followersIt) {
+            followers.emplace(frame->frame.data, std::vector<VideoFrame::Ptr>{});
+            return true;
+        }
+        followersIt->second.push_back(frame);
+        return false;
+    }
+
+    // returns the frames waiting for the detections of leader, the next frame with the buffer is detected again
+    std::vector<VideoFrame::Ptr> release(const VideoFrame::Ptr& leader) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto followersIt = followers.find(leader->frame.data);
+        std::vector<VideoFrame::Ptr> leaderFollowers = std::move(followersIt->second);
+        followers.erase(followersIt);
+        return leaderFollowers;
+    }
+
+private:
+    std::mutex mutex;
+    // the buffer can't be reused for another image while the leader holds it, so the pointer identifies the image
+    std::unordered_map<const uchar*, std::vector<VideoFrame::Ptr>> followers;
 };
 
 struct Context {  // stores all global data for tasks
@@ -136,6 +191,10 @@ struct Context {  // stores all global data for tasks
     struct {
         Detector detector;
         std::weak_ptr<Worker> inferTasksWorker;
+        std::mutex pendingFramesMutex;
+        std::deque<VideoFrame::Ptr> pendingFrames;  // the frames waiting for a free detector InferRequest to be batched
+        FramesDedup framesDedup;  // used with -dedup_frames
+        std::atomic<uint64_t> dedupedFramesCount;
     } inferTasksContext;
     struct {
         VehicleAttributesClassifier vehicleAttributesClassifier;
@@ -170,6 +229,7 @@ struct Context {  // stores all global data for tasks
     } videoFramesContext;
     std::weak_ptr<Worker> resAggregatorsWorker;
     std::mutex classifiersAggregatorPrintMutex;
+    ResultsWriter* resultsWriter = nullptr;
     uint64_t nireq;
     bool isVideo;
     std::chrono::steady_clock::time_point t0;
@@ -225,6 +285,22 @@ public:
             std::cout << rawDecodedPlate;
         }
         printMutex.unlock();
+        ResultsWriter* resultsWriter = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context.resultsWriter;
+        if (resultsWriter) {
+            // label is BboxAndDescr::ObjectType: objects which weren't classified are written with 0
+            std::vector<ResultsWriter::Record> records;
+            records.reserve(boxesAndDescrs.container.size());
+            for (const BboxAndDescr& bboxAndDescr : boxesAndDescrs.container) {
+                records.emplace_back();
+                ResultsWriter::Record& record = records.back();
+                record.stream = sharedVideoFrame->sourceID;
+                record.frame = sharedVideoFrame->frameId;
+                record.label = static_cast<int>(bboxAndDescr.objectType);
+                record.box = bboxAndDescr.rect;
+                record.text = bboxAndDescr.descr;
+            }
+            resultsWriter->write(records);
+        }
         tryPush(static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context.resAggregatorsWorker,
                 std::make_shared<ResAggregator>(sharedVideoFrame, std::move(boxesAndDescrs)));
     }
@@ -237,33 +313,62 @@ private:
     ConcurrentContainer<std::list<BboxAndDescr>> boxesAndDescrs;
 };
 
+class DetectorBatch {  // returns the detector InferRequest when every frame of the batch has taken its detections
+public:
+    DetectorBatch(Context& context, InferRequest& inferRequest):
+        inferRequest(inferRequest), context(context) {}
+    ~DetectorBatch() {
+        context.detectorsInfers.push(inferRequest);
+    }
+    InferRequest& inferRequest;
+
+private:
+    Context& context;
+};
+
+void startDetectorBatches(Context& context);
+
 class DetectionsProcessor: public Task {  // extracts detections from blob InferRequests and runs classifiers and recognisers
 public:
     DetectionsProcessor(VideoFrame::Ptr sharedVideoFrame, InferRequest* inferRequest):
-        Task{sharedVideoFrame, 1.0}, inferRequest{inferRequest}, requireGettingNumberOfDetections{true} {}
+        Task{sharedVideoFrame, 1.0}, inferRequest{inferRequest}, batchIndex{0}, requireGettingNumberOfDetections{true} {}
+    DetectionsProcessor(VideoFrame::Ptr sharedVideoFrame, const std::shared_ptr<DetectorBatch>& detectorBatch, int batchIndex):
+        Task{sharedVideoFrame, 1.0}, inferRequest{&detectorBatch->inferRequest}, detectorBatch{detectorBatch}, batchIndex{batchIndex},
+        requireGettingNumberOfDetections{true} {}
     DetectionsProcessor(VideoFrame::Ptr sharedVideoFrame, std::shared_ptr<ClassifiersAggregator>&& classifiersAggregator, std::list<cv::Rect>&& vehicleRects,
     std::list<cv::Rect>&& plateRects):
-        Task{sharedVideoFrame, 1.0}, classifiersAggregator{std::move(classifiersAggregator)}, inferRequest{nullptr},
+        Task{sharedVideoFrame, 1.0}, classifiersAggregator{std::move(classifiersAggregator)}, inferRequest{nullptr}, batchIndex{0},
         vehicleRects{std::move(vehicleRects)}, plateRects{std::move(plateRects)}, requireGettingNumberOfDetections{false} {}
+    DetectionsProcessor(VideoFrame::Ptr sharedVideoFrame, const std::list<Detector::Result>& dedupedResults,
+    const std::string& dedupedRawDetections):  // takes the detections of the frame which shares its buffer
+        Task{sharedVideoFrame, 1.0}, inferRequest{nullptr}, batchIndex{0}, requireGettingNumberOfDetections{true},
+        dedupedResults{dedupedResults}, dedupedRawDetections{dedupedRawDetections} {}
     bool isReady() override;
     void process() override;
 
 private:
     std::shared_ptr<ClassifiersAggregator> classifiersAggregator;  // when no one stores this object we will draw
     InferRequest* inferRequest;
+    std::shared_ptr<DetectorBatch> detectorBatch;  // set if inferRequest is shared by the frames of a batch
+    int batchIndex;
     std::list<cv::Rect> vehicleRects;
     std::list<cv::Rect> plateRects;
     std::vector<std::reference_wrapper<InferRequest>> reservedAttributesRequests;
     std::vector<std::reference_wrapper<InferRequest>> reservedLprRequests;
     bool requireGettingNumberOfDetections;
+    std::list<Detector::Result> dedupedResults;  // used if inferRequest is nullptr
+    std::string dedupedRawDetections;
 };
 
 class InferTask: public Task {  // runs detection
 public:
     explicit InferTask(VideoFrame::Ptr sharedVideoFrame):
-        Task{sharedVideoFrame, 5.0} {}
+        Task{sharedVideoFrame, 5.0}, inferRequest{nullptr} {}
     bool isReady() override;
     void process() override;
+
+private:
+    InferRequest* inferRequest;  // reserved by isReady()
 };
 
 class Reader: public Task {
@@ -321,6 +426,8 @@ bool Drawer::isReady() {
 
 void Drawer::process() {
     const int64_t frameId = sharedVideoFrame->frameId;
+    FRAME_TRACE_SCOPE("Render", frameId, sharedVideoFrame->sourceID);
+    FRAME_TRACE_FLOW(frameId, sharedVideoFrame->sourceID);
     Context& context = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context;
     std::map<int64_t, GridMat>& gridMats = context.drawersContext.gridMats;
     context.drawersContext.drawerMutex.lock();
@@ -381,10 +488,13 @@ void Drawer::process() {
 }
 
 void ResAggregator::process() {
+    FRAME_TRACE_SCOPE("Aggregate results", sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
+    FRAME_TRACE_FLOW(sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
     Context& context = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context;
-    context.freeDetectionInfersCount += context.detectorsInfers.inferRequests.lockedSize();
+    context.freeDetectionInfersCount += context.detectorsInfers.freeCount();
     context.frameCounter++;
     if (!FLAGS_no_show) {
+        makeWritable(sharedVideoFrame->frame);
         for (const BboxAndDescr& bboxAndDescr : boxesAndDescrs) {
             switch (bboxAndDescr.objectType) {
                 case BboxAndDescr::ObjectType::NONE: cv::rectangle(sharedVideoFrame->frame, bboxAndDescr.rect, {255, 255, 0},  4);
@@ -416,15 +526,31 @@ void ResAggregator::process() {
 bool DetectionsProcessor::isReady() {
     Context& context = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context;
     if (requireGettingNumberOfDetections) {
+        FRAME_TRACE_SCOPE("Postprocess", sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
+        FRAME_TRACE_FLOW(sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
         classifiersAggregator = std::make_shared<ClassifiersAggregator>(sharedVideoFrame);
         std::list<Detector::Result> results;
-        if (!(FLAGS_r && ((sharedVideoFrame->frameId == 0 && !context.isVideo) || context.isVideo))) {
-            results = context.inferTasksContext.detector.getResults(*inferRequest, sharedVideoFrame->frame.size());
+        if (nullptr == inferRequest) {
+            results = std::move(dedupedResults);
+            if (FLAGS_r && ((sharedVideoFrame->frameId == 0 && !context.isVideo) || context.isVideo)) {
+                classifiersAggregator->rawDetections = std::move(dedupedRawDetections);
+            }
+        } else if (!(FLAGS_r && ((sharedVideoFrame->frameId == 0 && !context.isVideo) || context.isVideo))) {
+            results = context.inferTasksContext.detector.getResults(*inferRequest, sharedVideoFrame->frame.size(), nullptr, batchIndex);
         } else {
             std::ostringstream rawResultsStream;
-            results = context.inferTasksContext.detector.getResults(*inferRequest, sharedVideoFrame->frame.size(), &rawResultsStream);
+            results = context.inferTasksContext.detector.getResults(*inferRequest, sharedVideoFrame->frame.size(), &rawResultsStream,
+                batchIndex);
             classifiersAggregator->rawDetections = rawResultsStream.str();
         }
+        if (FLAGS_dedup_frames && nullptr != inferRequest) {
+            // the frame hasn't been drawn on yet, so it still has the buffer the followers were registered with
+            for (const VideoFrame::Ptr& follower : context.inferTasksContext.framesDedup.release(sharedVideoFrame)) {
+                context.inferTasksContext.dedupedFramesCount++;
+                tryPush(context.detectionsProcessorsContext.detectionsProcessorsWorker,
+                    std::make_shared<DetectionsProcessor>(follower, results, classifiersAggregator->rawDetections));
+            }
+        }
         for (Detector::Result result : results) {
             switch (result.label) {
                 case 1:
@@ -446,65 +572,86 @@ bool DetectionsProcessor::isReady() {
                          break;
             }
         }
-        context.detectorsInfers.inferRequests.lockedPush_back(*inferRequest);
+        if (detectorBatch) {
+            detectorBatch.reset();  // the last frame of the batch returns the InferRequest
+            startDetectorBatches(context);
+        } else if (nullptr != inferRequest) {
+            context.detectorsInfers.push(*inferRequest);
+        }
         requireGettingNumberOfDetections = false;
     }
 
     if ((vehicleRects.empty() || FLAGS_m_va.empty()) && (plateRects.empty() || FLAGS_m_lpr.empty())) {
         return true;
     } else {
-        // isReady() is called under mutexes so it is assured that available InferRequests will not be taken, but new InferRequests can come in
-        // acquire as many InferRequests as it is possible or needed
-        InferRequestsContainer& attributesInfers = context.attributesInfers;
-        attributesInfers.inferRequests.mutex.lock();
-        const std::size_t numberOfAttributesInferRequestsAcquired = std::min(vehicleRects.size(), attributesInfers.inferRequests.container.size());
-        reservedAttributesRequests.assign(attributesInfers.inferRequests.container.end() - numberOfAttributesInferRequestsAcquired,
-                                          attributesInfers.inferRequests.container.end());
-        attributesInfers.inferRequests.container.erase(attributesInfers.inferRequests.container.end() - numberOfAttributesInferRequestsAcquired,
-                                                       attributesInfers.inferRequests.container.end());
-        attributesInfers.inferRequests.mutex.unlock();
-
-        InferRequestsContainer& platesInfers = context.platesInfers;
-        platesInfers.inferRequests.mutex.lock();
-        const std::size_t numberOfLprInferRequestsAcquired = std::min(plateRects.size(), platesInfers.inferRequests.container.size());
-        reservedLprRequests.assign(platesInfers.inferRequests.container.end() - numberOfLprInferRequestsAcquired, platesInfers.inferRequests.container.end());
-        platesInfers.inferRequests.container.erase(platesInfers.inferRequests.container.end() - numberOfLprInferRequestsAcquired,
-                                                   platesInfers.inferRequests.container.end());
-        platesInfers.inferRequests.mutex.unlock();
+        // acquire as many InferRequests as it is possible or needed, process() uses only the acquired ones,
+        // every InferRequest takes a batch of rects
+        const std::size_t attributesBatch = context.detectionsProcessorsContext.vehicleAttributesClassifier.getMaxBatch();
+        reservedAttributesRequests.clear();
+        InferRequest* attributesRequest;
+        while (reservedAttributesRequests.size() * attributesBatch < vehicleRects.size()
+               && nullptr != (attributesRequest = context.attributesInfers.tryPop())) {
+            reservedAttributesRequests.emplace_back(*attributesRequest);
+        }
+        const std::size_t numberOfAttributesInferRequestsAcquired = reservedAttributesRequests.size();
+
+        const std::size_t lprBatch = context.detectionsProcessorsContext.lpr.getMaxBatch();
+        reservedLprRequests.clear();
+        InferRequest* lprRequest;
+        while (reservedLprRequests.size() * lprBatch < plateRects.size() && nullptr != (lprRequest = context.platesInfers.tryPop())) {
+            reservedLprRequests.emplace_back(*lprRequest);
+        }
+        const std::size_t numberOfLprInferRequestsAcquired = reservedLprRequests.size();
         return numberOfAttributesInferRequestsAcquired || numberOfLprInferRequestsAcquired;
     }
 }
 
 void DetectionsProcessor::process() {
+    FRAME_TRACE_SCOPE("Start classifiers", sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
+    FRAME_TRACE_FLOW(sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
     Context& context = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context;
     if (!FLAGS_m_va.empty()) {
+        const std::size_t batchSize = context.detectionsProcessorsContext.vehicleAttributesClassifier.getMaxBatch();
         auto vehicleRectsIt = vehicleRects.begin();
         for (auto attributesRequestIt = reservedAttributesRequests.begin(); attributesRequestIt != reservedAttributesRequests.end();
-                vehicleRectsIt++, attributesRequestIt++) {
-            const cv::Rect vehicleRect = *vehicleRectsIt;
+                attributesRequestIt++) {
             InferRequest& attributesRequest = *attributesRequestIt;
-            context.detectionsProcessorsContext.vehicleAttributesClassifier.setImage(attributesRequest, sharedVideoFrame->frame, vehicleRect);
+            std::vector<cv::Rect> rects;  // the vehicles in the batch of attributesRequest
+            for (; vehicleRectsIt != vehicleRects.end() && rects.size() < batchSize; vehicleRectsIt++) {
+                context.detectionsProcessorsContext.vehicleAttributesClassifier.setImage(attributesRequest, sharedVideoFrame->frame,
+                    *vehicleRectsIt, static_cast<int>(rects.size()));
+                rects.push_back(*vehicleRectsIt);
+            }
 
             attributesRequest.SetCompletionCallback(
                 std::bind(
                     [](std::shared_ptr<ClassifiersAggregator> classifiersAggregator,
                         InferRequest& attributesRequest,
-                        cv::Rect rect,
+                        const std::vector<cv::Rect>& rects,
                         Context& context) {
                             attributesRequest.SetCompletionCallback([]{});  // destroy the stored bind object
-
-                            const std::pair<std::string, std::string>& attributes
-                                = context.detectionsProcessorsContext.vehicleAttributesClassifier.getResults(attributesRequest);
-
-                            if (FLAGS_r && ((classifiersAggregator->sharedVideoFrame->frameId == 0 && !context.isVideo) || context.isVideo)) {
-                                classifiersAggregator->rawAttributes.lockedPush_back("Vehicle Attributes results:" + attributes.first + ';'
-                                                                                      + attributes.second + '\n');
+                            FRAME_TRACE_SCOPE("Attributes callback", classifiersAggregator->sharedVideoFrame->frameId,
+                                classifiersAggregator->sharedVideoFrame->sourceID);
+                            FRAME_TRACE_FLOW(classifiersAggregator->sharedVideoFrame->frameId,
+                                classifiersAggregator->sharedVideoFrame->sourceID);
+
+                            for (std::size_t i = 0; i < rects.size(); i++) {
+                                const std::pair<std::string, std::string>& attributes
+                                    = context.detectionsProcessorsContext.vehicleAttributesClassifier.getResults(attributesRequest,
+                                        static_cast<int>(i));
+
+                                if (FLAGS_r && ((classifiersAggregator->sharedVideoFrame->frameId == 0 && !context.isVideo) || context.isVideo)) {
+                                    classifiersAggregator->rawAttributes.lockedPush_back("Vehicle Attributes results:" + attributes.first + ';'
+                                                                                          + attributes.second + '\n');
+                                }
+                                classifiersAggregator->push(BboxAndDescr{BboxAndDescr::ObjectType::VEHICLE, rects[i],
+                                    attributes.first + ' ' + attributes.second});
                             }
-                            classifiersAggregator->push(BboxAndDescr{BboxAndDescr::ObjectType::VEHICLE, rect, attributes.first + ' ' + attributes.second});
-                            context.attributesInfers.inferRequests.lockedPush_back(attributesRequest);
+                            context.attributesInfers.push(attributesRequest);
+                            tryNotify(context.detectionsProcessorsContext.detectionsProcessorsWorker);
                         }, classifiersAggregator,
                            std::ref(attributesRequest),
-                           vehicleRect,
+                           std::move(rects),
                            std::ref(context)));
 
             attributesRequest.StartAsync();
@@ -518,30 +665,42 @@ void DetectionsProcessor::process() {
     }
 
     if (!FLAGS_m_lpr.empty()) {
+        const std::size_t batchSize = context.detectionsProcessorsContext.lpr.getMaxBatch();
         auto plateRectsIt = plateRects.begin();
-        for (auto lprRequestsIt = reservedLprRequests.begin(); lprRequestsIt != reservedLprRequests.end(); plateRectsIt++, lprRequestsIt++) {
-            const cv::Rect plateRect = *plateRectsIt;
+        for (auto lprRequestsIt = reservedLprRequests.begin(); lprRequestsIt != reservedLprRequests.end(); lprRequestsIt++) {
             InferRequest& lprRequest = *lprRequestsIt;
-            context.detectionsProcessorsContext.lpr.setImage(lprRequest, sharedVideoFrame->frame, plateRect);
+            std::vector<cv::Rect> rects;  // the plates in the batch of lprRequest
+            for (; plateRectsIt != plateRects.end() && rects.size() < batchSize; plateRectsIt++) {
+                context.detectionsProcessorsContext.lpr.setImage(lprRequest, sharedVideoFrame->frame, *plateRectsIt,
+                    static_cast<int>(rects.size()));
+                rects.push_back(*plateRectsIt);
+            }
 
             lprRequest.SetCompletionCallback(
                 std::bind(
                     [](std::shared_ptr<ClassifiersAggregator> classifiersAggregator,
                         InferRequest& lprRequest,
-                        cv::Rect rect,
+                        const std::vector<cv::Rect>& rects,
                         Context& context) {
                             lprRequest.SetCompletionCallback([]{});  // destroy the stored bind object
-
-                            std::string result = context.detectionsProcessorsContext.lpr.getResults(lprRequest);
-
-                            if (FLAGS_r && ((classifiersAggregator->sharedVideoFrame->frameId == 0 && !context.isVideo) || context.isVideo)) {
-                                classifiersAggregator->rawDecodedPlates.lockedPush_back("License Plate Recognition results:" + result + '\n');
+                            FRAME_TRACE_SCOPE("LPR callback", classifiersAggregator->sharedVideoFrame->frameId,
+                                classifiersAggregator->sharedVideoFrame->sourceID);
+                            FRAME_TRACE_FLOW(classifiersAggregator->sharedVideoFrame->frameId,
+                                classifiersAggregator->sharedVideoFrame->sourceID);
+
+                            for (std::size_t i = 0; i < rects.size(); i++) {
+                                std::string result = context.detectionsProcessorsContext.lpr.getResults(lprRequest, static_cast<int>(i));
+
+                                if (FLAGS_r && ((classifiersAggregator->sharedVideoFrame->frameId == 0 && !context.isVideo) || context.isVideo)) {
+                                    classifiersAggregator->rawDecodedPlates.lockedPush_back("License Plate Recognition results:" + result + '\n');
+                                }
+                                classifiersAggregator->push(BboxAndDescr{BboxAndDescr::ObjectType::PLATE, rects[i], std::move(result)});
                             }
-                            classifiersAggregator->push(BboxAndDescr{BboxAndDescr::ObjectType::PLATE, rect, std::move(result)});
-                            context.platesInfers.inferRequests.lockedPush_back(lprRequest);
+                            context.platesInfers.push(lprRequest);
+                            tryNotify(context.detectionsProcessorsContext.detectionsProcessorsWorker);
                         }, classifiersAggregator,
                            std::ref(lprRequest),
-                           plateRect,
+                           std::move(rects),
                            std::ref(context)));
 
             lprRequest.StartAsync();
@@ -559,27 +718,86 @@ void DetectionsProcessor::process() {
     }
 }
 
-bool InferTask::isReady() {
-    InferRequestsContainer& detectorsInfers = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context.detectorsInfers;
-    if (detectorsInfers.inferRequests.container.empty()) {
-        return false;
-    } else {
-        detectorsInfers.inferRequests.mutex.lock();
-        if (detectorsInfers.inferRequests.container.empty()) {
-            detectorsInfers.inferRequests.mutex.unlock();
-            return false;
-        } else {
-            return true;  // process() will unlock the mutex
+void startDetectorBatches(Context& context) {  // runs the pending frames while there are free detector InferRequests
+    const std::size_t batchSize = context.inferTasksContext.detector.getMaxBatch();
+    while (true) {
+        InferRequest* inferRequest;
+        std::vector<VideoFrame::Ptr> frames;
+        {
+            std::lock_guard<std::mutex> lock{context.inferTasksContext.pendingFramesMutex};
+            std::deque<VideoFrame::Ptr>& pendingFrames = context.inferTasksContext.pendingFrames;
+            if (pendingFrames.empty() || nullptr == (inferRequest = context.detectorsInfers.tryPop())) {
+                return;
+            }
+            while (!pendingFrames.empty() && frames.size() < batchSize) {
+                frames.push_back(std::move(pendingFrames.front()));
+                pendingFrames.pop_front();
+            }
         }
+        for (std::size_t i = 0; i < frames.size(); i++) {
+            FRAME_TRACE_SCOPE("Start infer", frames[i]->frameId, frames[i]->sourceID);
+            FRAME_TRACE_FLOW(frames[i]->frameId, frames[i]->sourceID);
+            context.inferTasksContext.detector.setImage(*inferRequest, frames[i]->frame, static_cast<int>(i));
+        }
+
+        inferRequest->SetCompletionCallback(
+            std::bind(
+                [](std::vector<VideoFrame::Ptr> frames,
+                   InferRequest& inferRequest,
+                   Context& context) {
+                        inferRequest.SetCompletionCallback([]{});  // destroy the stored bind object
+                        std::vector<std::shared_ptr<DetectionsProcessor>> detectionsProcessors;
+                        detectionsProcessors.reserve(frames.size());
+                        {
+                            // only DetectionsProcessors own the batch, so one of them starts the next batch
+                            std::shared_ptr<DetectorBatch> detectorBatch = std::make_shared<DetectorBatch>(context, inferRequest);
+                            for (std::size_t i = 0; i < frames.size(); i++) {
+                                FRAME_TRACE_SCOPE("Infer callback", frames[i]->frameId, frames[i]->sourceID);
+                                FRAME_TRACE_FLOW(frames[i]->frameId, frames[i]->sourceID);
+                                detectionsProcessors.push_back(std::make_shared<DetectionsProcessor>(frames[i], detectorBatch,
+                                    static_cast<int>(i)));
+                            }
+                        }
+                        for (std::shared_ptr<DetectionsProcessor>& detectionsProcessor : detectionsProcessors) {
+                            tryPush(context.detectionsProcessorsContext.detectionsProcessorsWorker, std::move(detectionsProcessor));
+                        }
+                    }, std::move(frames),
+                       std::ref(*inferRequest),
+                       std::ref(context)));
+        inferRequest->StartAsync();
+    }
+}
+
+bool InferTask::isReady() {
+    Context& context = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context;
+    if (context.inferTasksContext.detector.getMaxBatch() > 1) {
+        return true;  // process() leaves the frame to startDetectorBatches()
+    }
+    if (nullptr == inferRequest) {
+        inferRequest = context.detectorsInfers.tryPop();
     }
+    return nullptr != inferRequest;  // process() uses the reserved InferRequest
 }
 
 void InferTask::process() {
     Context& context = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context;
-    InferRequestsContainer& detectorsInfers = context.detectorsInfers;
-    std::reference_wrapper<InferRequest> inferRequest = detectorsInfers.inferRequests.container.back();
-    detectorsInfers.inferRequests.container.pop_back();
-    detectorsInfers.inferRequests.mutex.unlock();
+    if (FLAGS_dedup_frames && !context.inferTasksContext.framesDedup.lead(sharedVideoFrame)) {
+        if (nullptr != inferRequest) {
+            context.detectorsInfers.push(*inferRequest);
+        }
+        return;  // the DetectionsProcessor of the leading frame continues with the frame
+    }
+    if (context.inferTasksContext.detector.getMaxBatch() > 1) {
+        {
+            std::lock_guard<std::mutex> lock{context.inferTasksContext.pendingFramesMutex};
+            context.inferTasksContext.pendingFrames.push_back(sharedVideoFrame);
+        }
+        startDetectorBatches(context);
+        return;
+    }
+    FRAME_TRACE_SCOPE("Start infer", sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
+    FRAME_TRACE_FLOW(sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
+    std::reference_wrapper<InferRequest> inferRequest = *this->inferRequest;  // reserved by isReady()
 
     context.inferTasksContext.detector.setImage(inferRequest, sharedVideoFrame->frame);
 
@@ -589,6 +807,8 @@ void InferTask::process() {
                InferRequest& inferRequest,
                Context& context) {
                     inferRequest.SetCompletionCallback([]{});  // destroy the stored bind object
+                    FRAME_TRACE_SCOPE("Infer callback", sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
+                    FRAME_TRACE_FLOW(sharedVideoFrame->frameId, sharedVideoFrame->sourceID);
                     tryPush(context.detectionsProcessorsContext.detectionsProcessorsWorker,
                         std::make_shared<DetectionsProcessor>(sharedVideoFrame, &inferRequest));
                 }, sharedVideoFrame,
@@ -613,7 +833,11 @@ void Reader::process() {
     unsigned sourceID = sharedVideoFrame->sourceID;
     Context& context = static_cast<ReborningVideoFrame*>(sharedVideoFrame.get())->context;
     const std::vector<std::shared_ptr<InputChannel>>& inputChannels = context.readersContext.inputChannels;
-    if (inputChannels[sourceID]->read(sharedVideoFrame->frame)) {
+    FRAME_TRACE_BEGIN("Decode", sharedVideoFrame->frameId, sourceID);
+    FRAME_TRACE_FLOW(sharedVideoFrame->frameId, sourceID);
+    const bool isRead = inputChannels[sourceID]->read(sharedVideoFrame->frame);
+    FRAME_TRACE_END("Decode", sharedVideoFrame->frameId, sourceID);
+    if (isRead) {
         context.readersContext.lastCapturedFrameIds[sourceID]++;
         context.readersContext.lastCapturedFrameIdsMutexes[sourceID].unlock();
         tryPush(context.inferTasksContext.inferTasksWorker, std::make_shared<InferTask>(sharedVideoFrame));
@@ -645,6 +869,7 @@ int main(int argc, char* argv[]) {
         if (files.empty() && 0 == FLAGS_nc) throw std::logic_error("No inputs were found");
         std::vector<std::shared_ptr<VideoCaptureSource>> videoCapturSourcess;
         std::vector<std::shared_ptr<ImageSource>> imageSourcess;
+        std::vector<std::shared_ptr<SyntheticSource>> syntheticSources;
         if (FLAGS_nc) {
             for (size_t i = 0; i < FLAGS_nc; ++i) {
                 cv::VideoCapture videoCapture(i);
@@ -660,6 +885,12 @@ int main(int argc, char* argv[]) {
             }
         }
         for (const std::string& file : files) {
+            cv::Size syntheticSize;
+            double syntheticFps;
+            if (parseSyntheticInput(file, syntheticSize, syntheticFps)) {
+                syntheticSources.push_back(std::make_shared<SyntheticSource>(syntheticSize));
+                continue;
+            }
             cv::Mat frame = cv::imread(file, cv::IMREAD_COLOR);
             if (frame.empty()) {
                 cv::VideoCapture videoCapture(file);
@@ -672,15 +903,19 @@ int main(int argc, char* argv[]) {
                 imageSourcess.push_back(std::make_shared<ImageSource>(frame, true));
             }
         }
-        uint32_t channelsNum = 0 == FLAGS_ni ? videoCapturSourcess.size() + imageSourcess.size() : FLAGS_ni;
+        const size_t sourcesNum = videoCapturSourcess.size() + imageSourcess.size() + syntheticSources.size();
+        uint32_t channelsNum = 0 == FLAGS_ni ? sourcesNum : FLAGS_ni;
         std::vector<std::shared_ptr<IInputSource>> inputSources;
-        inputSources.reserve(videoCapturSourcess.size() + imageSourcess.size());
+        inputSources.reserve(sourcesNum);
         for (const std::shared_ptr<VideoCaptureSource>& videoSource : videoCapturSourcess) {
             inputSources.push_back(videoSource);
         }
         for (const std::shared_ptr<ImageSource>& imageSource : imageSourcess) {
             inputSources.push_back(imageSource);
         }
+        for (const std::shared_ptr<SyntheticSource>& syntheticSource : syntheticSources) {
+            inputSources.push_back(syntheticSource);
+        }
 
         std::vector<std::shared_ptr<InputChannel>> inputChannels;
         inputChannels.reserve(channelsNum);
@@ -728,6 +963,9 @@ int main(int argc, char* argv[]) {
                                 (device_nstreams.count("CPU") > 0 ? std::to_string(device_nstreams.at("CPU")) :
                                                                     CONFIG_VALUE(CPU_THROUGHPUT_AUTO)) }}, "CPU");
                 device_nstreams["CPU"] = std::stoi(ie.GetConfig("CPU", CONFIG_KEY(CPU_THROUGHPUT_STREAMS)).as<std::string>());
+                // The networks are inferred one after another for a frame, so they are counted once
+                ThreadBudget::global().addCpuNetwork({{ CONFIG_KEY(CPU_THREADS_NUM), std::to_string(FLAGS_nthreads) }});
+                ThreadBudget::global().applyToOpenCV();
             }
 
             if ("GPU" == device) {
@@ -767,23 +1005,34 @@ int main(int argc, char* argv[]) {
 
         // -----------------------------------------------------------------------------------------------------
         unsigned nireq = FLAGS_nireq == 0 ? inputChannels.size() : FLAGS_nireq;
+        // The networks are read and loaded concurrently
+        ModelLoader modelLoader;
         slog::info << "Loading detection model to the "<< FLAGS_d << " plugin" << slog::endl;
-        Detector detector(ie, FLAGS_d, FLAGS_m,
-            {static_cast<float>(FLAGS_t), static_cast<float>(FLAGS_t)}, FLAGS_auto_resize, makeTagConfig(FLAGS_d, "Detect"));
+        Detector detector;
+        modelLoader.add([&]() {
+            detector = Detector(ie, FLAGS_d, FLAGS_m,
+                {static_cast<float>(FLAGS_t), static_cast<float>(FLAGS_t)}, FLAGS_auto_resize, makeTagConfig(FLAGS_d, "Detect"), FLAGS_bs_d);
+        });
         VehicleAttributesClassifier vehicleAttributesClassifier;
         std::size_t nclassifiersireq{0};
         Lpr lpr;
         std::size_t nrecognizersireq{0};
         if (!FLAGS_m_va.empty()) {
             slog::info << "Loading Vehicle Attribs model to the "<< FLAGS_d_va << " plugin" << slog::endl;
-            vehicleAttributesClassifier = VehicleAttributesClassifier(ie, FLAGS_d_va, FLAGS_m_va, FLAGS_auto_resize, makeTagConfig(FLAGS_d_va, "Attr"));
+            modelLoader.add([&]() {
+                vehicleAttributesClassifier = VehicleAttributesClassifier(ie, FLAGS_d_va, FLAGS_m_va, FLAGS_auto_resize,
+                    makeTagConfig(FLAGS_d_va, "Attr"), FLAGS_bs);
+            });
             nclassifiersireq = nireq * 3;
         }
         if (!FLAGS_m_lpr.empty()) {
             slog::info << "Loading Licence Plate Recognition (LPR) model to the "<< FLAGS_d_lpr << " plugin" << slog::endl;
-            lpr = Lpr(ie, FLAGS_d_lpr, FLAGS_m_lpr, FLAGS_auto_resize, makeTagConfig(FLAGS_d_lpr, "LPR"));
+            modelLoader.add([&]() {
+                lpr = Lpr(ie, FLAGS_d_lpr, FLAGS_m_lpr, FLAGS_auto_resize, makeTagConfig(FLAGS_d_lpr, "LPR"), FLAGS_bs);
+            });
             nrecognizersireq = nireq * 3;
         }
+        modelLoader.wait();
         bool isVideo = imageSourcess.empty() ? true : false;
         int pause = imageSourcess.empty() ? 1 : 0;
         std::chrono::steady_clock::duration showPeriod = 0 == FLAGS_fps ? std::chrono::steady_clock::duration::zero()
@@ -810,6 +1059,11 @@ int main(int argc, char* argv[]) {
         }
         slog::info << "Display resolution: " << FLAGS_display_resolution << slog::endl;
 
+        std::unique_ptr<ResultsWriter> resultsWriter;
+        if (!FLAGS_dump.empty()) {
+            resultsWriter.reset(new ResultsWriter(FLAGS_dump, ResultsWriter::formatFromFileName(FLAGS_dump)));
+        }
+
         Context context{inputChannels,
                         detector,
                         vehicleAttributesClassifier, lpr,
@@ -823,6 +1077,7 @@ int main(int argc, char* argv[]) {
         // when the context is destroyed and the worker still lives with its ReborningVideoFrames referring to the
         // destroyed context.
         std::shared_ptr<Worker> worker = std::make_shared<Worker>(FLAGS_n_wt - 1);
+        context.resultsWriter = resultsWriter.get();
         context.readersContext.readersWorker = context.inferTasksContext.inferTasksWorker
             = context.detectionsProcessorsContext.detectionsProcessorsWorker = context.drawersContext.drawersWorker
             = context.resAggregatorsWorker = worker;
@@ -863,6 +1118,10 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        if (resultsWriter) {
+            resultsWriter->close();
+        }
+
         uint64_t frameCounter = context.frameCounter;
         if (0 != frameCounter) {
             const float fps = static_cast<float>(frameCounter) / std::chrono::duration_cast<Sec>(t1 - context.t0).count()
@@ -872,6 +1131,9 @@ int main(int argc, char* argv[]) {
             const double detectionsInfersUsage = static_cast<float>(frameCounter * context.nireq - context.freeDetectionInfersCount)
                 / (frameCounter * context.nireq) * 100;
             std::cout << "Detection InferRequests usage: " << detectionsInfersUsage << "%\n";
+            if (FLAGS_dedup_frames) {
+                std::cout << "Frames sharing detections: " << context.inferTasksContext.dedupedFramesCount << '\n';
+            }
         }
 
         std::cout << context.drawersContext.presenter.reportMeans() << '\n';
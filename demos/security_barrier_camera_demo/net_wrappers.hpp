@@ -27,8 +27,8 @@ public:
 
     Detector() = default;
     Detector(InferenceEngine::Core& ie, const std::string& deviceName, const std::string& xmlPath, const std::vector<float>& detectionTresholds,
-            const bool autoResize, const std::map<std::string, std::string> & pluginConfig) :
-        detectionTresholds{detectionTresholds}, ie_{ie} {
+            const bool autoResize, const std::map<std::string, std::string> & pluginConfig, std::size_t maxBatch = 1) :
+        detectionTresholds{detectionTresholds}, maxBatch{maxBatch}, ie_{ie} {
         auto network = ie.ReadNetwork(xmlPath);
         InferenceEngine::InputsDataMap inputInfo(network.getInputsInfo());
         if (inputInfo.size() != 1) {
@@ -36,7 +36,8 @@ public:
         }
         InferenceEngine::InputInfo::Ptr& inputInfoFirst = inputInfo.begin()->second;
         inputInfoFirst->setPrecision(InferenceEngine::Precision::U8);
-        if (autoResize) {
+        // a wrapped frame can't be a part of a batch, so the batched frames are resized by the demo
+        if (autoResize && 1 == maxBatch) {
             inputInfoFirst->getPreProcess().setResizeAlgorithm(InferenceEngine::ResizeAlgorithm::RESIZE_BILINEAR);
             inputInfoFirst->setLayout(InferenceEngine::Layout::NHWC);
         } else {
@@ -64,6 +65,9 @@ public:
         }
         _output->setPrecision(InferenceEngine::Precision::FP32);
 
+        if (maxBatch > 1) {
+            network.setBatchSize(maxBatch);  // the proposals of all the images are in the same output
+        }
         net = ie_.LoadNetwork(network, deviceName, pluginConfig);
     }
 
@@ -71,7 +75,12 @@ public:
         return net.CreateInferRequest();
     }
 
-    void setImage(InferenceEngine::InferRequest& inferRequest, const cv::Mat& img) {
+    std::size_t getMaxBatch() const {
+        return maxBatch;
+    }
+
+    // batchIndex selects the place of the image in the batch of inferRequest
+    void setImage(InferenceEngine::InferRequest& inferRequest, const cv::Mat& img, int batchIndex = 0) {
         InferenceEngine::Blob::Ptr input = inferRequest.GetBlob(detectorInputBlobName);
         if (InferenceEngine::Layout::NHWC == input->getTensorDesc().getLayout()) {  // autoResize is set
             if (!img.isSubmatrix()) {
@@ -82,22 +91,26 @@ public:
                 throw std::logic_error("Sparse matrix are not supported");
             }
         } else {
-            matU8ToBlob<uint8_t>(img, input);
+            matU8ToBlob<uint8_t>(img, input, batchIndex);
         }
     }
 
-    std::list<Result> getResults(InferenceEngine::InferRequest& inferRequest, cv::Size upscale, std::ostream* rawResults = nullptr) {
+    std::list<Result> getResults(InferenceEngine::InferRequest& inferRequest, cv::Size upscale, std::ostream* rawResults = nullptr,
+            int batchIndex = 0) {
         // there is no big difference if InferReq of detector from another device is passed because the processing is the same for the same topology
         std::list<Result> results;
         InferenceEngine::LockedMemory<const void> detectorOutputBlobMapped = InferenceEngine::as<
             InferenceEngine::MemoryBlob>(inferRequest.GetBlob(detectorOutputBlobName))->rmap();
         const float * const detections = detectorOutputBlobMapped.as<float *>();
         // pretty much regular SSD post-processing
-        for (int i = 0; i < maxProposalCount; i++) {
+        for (int i = 0; i < maxProposalCount * static_cast<int>(maxBatch); i++) {
             float image_id = detections[i * objectSize + 0];  // in case of batch
             if (image_id < 0) {  // indicates end of detections
                 break;
             }
+            if (static_cast<int>(image_id) != batchIndex) {
+                continue;
+            }
             auto label = static_cast<decltype(detectionTresholds.size())>(detections[i * objectSize + 1]);
             float confidence = detections[i * objectSize + 2];
             if (label - 1 < detectionTresholds.size() && confidence < detectionTresholds[label - 1]) {
@@ -121,6 +134,7 @@ public:
 
 private:
     std::vector<float> detectionTresholds;
+    std::size_t maxBatch = 1;
     std::string detectorInputBlobName;
     std::string detectorOutputBlobName;
     InferenceEngine::Core ie_;  // The only reason to store a plugin as to assure that it lives at least as long as ExecutableNetwork
@@ -131,7 +145,8 @@ class VehicleAttributesClassifier {
 public:
     VehicleAttributesClassifier() = default;
     VehicleAttributesClassifier(InferenceEngine::Core& ie, const std::string & deviceName,
-        const std::string& xmlPath, const bool autoResize, const std::map<std::string, std::string> & pluginConfig) : ie_(ie) {
+        const std::string& xmlPath, const bool autoResize, const std::map<std::string, std::string> & pluginConfig,
+        std::size_t maxBatch = 1) : maxBatch{maxBatch}, ie_(ie) {
         auto network = ie.ReadNetwork(FLAGS_m_va);
         InferenceEngine::InputsDataMap attributesInputInfo(network.getInputsInfo());
         if (attributesInputInfo.size() != 1) {
@@ -139,7 +154,8 @@ public:
         }
         InferenceEngine::InputInfo::Ptr& attributesInputInfoFirst = attributesInputInfo.begin()->second;
         attributesInputInfoFirst->setPrecision(InferenceEngine::Precision::U8);
-        if (FLAGS_auto_resize) {
+        // ROI blobs can't be batched, so the batched vehicles are resized by the demo
+        if (FLAGS_auto_resize && 1 == maxBatch) {
             attributesInputInfoFirst->getPreProcess().setResizeAlgorithm(InferenceEngine::ResizeAlgorithm::RESIZE_BILINEAR);
             attributesInputInfoFirst->setLayout(InferenceEngine::Layout::NHWC);
         } else {
@@ -158,6 +174,9 @@ public:
         it->second->setPrecision(InferenceEngine::Precision::FP32);
         outputNameForType = (it)->second->getName();  // type is the second output.
 
+        if (maxBatch > 1) {
+            network.setBatchSize(maxBatch);
+        }
         net = ie_.LoadNetwork(network, deviceName, pluginConfig);
     }
 
@@ -165,7 +184,12 @@ public:
         return net.CreateInferRequest();
     }
 
-    void setImage(InferenceEngine::InferRequest& inferRequest, const cv::Mat& img, const cv::Rect vehicleRect) {
+    std::size_t getMaxBatch() const {
+        return maxBatch;
+    }
+
+    // batchIndex selects the place of the vehicle in the batch of inferRequest
+    void setImage(InferenceEngine::InferRequest& inferRequest, const cv::Mat& img, const cv::Rect vehicleRect, int batchIndex = 0) {
         InferenceEngine::Blob::Ptr roiBlob = inferRequest.GetBlob(attributesInputName);
         if (InferenceEngine::Layout::NHWC == roiBlob->getTensorDesc().getLayout()) {  // autoResize is set
             InferenceEngine::ROI cropRoi{0, static_cast<size_t>(vehicleRect.x), static_cast<size_t>(vehicleRect.y), static_cast<size_t>(vehicleRect.width),
@@ -175,10 +199,10 @@ public:
             inferRequest.SetBlob(attributesInputName, roiBlob);
         } else {
             const cv::Mat& vehicleImage = img(vehicleRect);
-            matU8ToBlob<uint8_t>(vehicleImage, roiBlob);
+            matU8ToBlob<uint8_t>(vehicleImage, roiBlob, batchIndex);
         }
     }
-    std::pair<std::string, std::string> getResults(InferenceEngine::InferRequest& inferRequest) {
+    std::pair<std::string, std::string> getResults(InferenceEngine::InferRequest& inferRequest, int batchIndex = 0) {
         static const std::string colors[] = {
             "white", "gray", "yellow", "red", "green", "blue", "black"
         };
@@ -189,11 +213,11 @@ public:
         // 7 possible colors for each vehicle and we should select the one with the maximum probability
         InferenceEngine::LockedMemory<const void> colorsMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(
             inferRequest.GetBlob(outputNameForColor))->rmap();
-        auto colorsValues = colorsMapped.as<float*>();
+        auto colorsValues = colorsMapped.as<float*>() + batchIndex * 7;
         // 4 possible types for each vehicle and we should select the one with the maximum probability
         InferenceEngine::LockedMemory<const void> typesMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(
             inferRequest.GetBlob(outputNameForType))->rmap();
-        auto typesValues = typesMapped.as<float*>();
+        auto typesValues = typesMapped.as<float*>() + batchIndex * 4;
 
         const auto color_id = std::max_element(colorsValues, colorsValues + 7) - colorsValues;
         const auto  type_id = std::max_element(typesValues,  typesValues  + 4) - typesValues;
@@ -201,6 +225,7 @@ public:
     }
 
 private:
+    std::size_t maxBatch = 1;
     std::string attributesInputName;
     std::string outputNameForColor;
     std::string outputNameForType;
@@ -212,9 +237,11 @@ class Lpr {
 public:
     Lpr() = default;
     Lpr(InferenceEngine::Core& ie, const std::string & deviceName, const std::string& xmlPath, const bool autoResize,
-        const std::map<std::string, std::string> &pluginConfig) :
+        const std::map<std::string, std::string> &pluginConfig, std::size_t maxBatch = 1) :
         ie_{ie} {
         auto network = ie.ReadNetwork(FLAGS_m_lpr);
+        // the sequence input of the LPR models converted from Caffe has no batch dimension
+        this->maxBatch = network.getInputsInfo().size() == 2 ? 1 : maxBatch;
 
         /** LPR network should have 2 inputs (and second is just a stub) and one output **/
         // ---------------------------Check inputs ------------------------------------------------------
@@ -224,7 +251,8 @@ public:
         }
         InferenceEngine::InputInfo::Ptr& LprInputInfoFirst = LprInputInfo.begin()->second;
         LprInputInfoFirst->setPrecision(InferenceEngine::Precision::U8);
-        if (FLAGS_auto_resize) {
+        // ROI blobs can't be batched, so the batched plates are resized by the demo
+        if (FLAGS_auto_resize && 1 == this->maxBatch) {
             LprInputInfoFirst->getPreProcess().setResizeAlgorithm(InferenceEngine::ResizeAlgorithm::RESIZE_BILINEAR);
             LprInputInfoFirst->setLayout(InferenceEngine::Layout::NHWC);
         } else {
@@ -261,6 +289,9 @@ public:
             }
         }
 
+        if (this->maxBatch > 1) {
+            network.setBatchSize(this->maxBatch);
+        }
         net = ie_.LoadNetwork(network, deviceName, pluginConfig);
     }
 
@@ -268,7 +299,12 @@ public:
         return net.CreateInferRequest();
     }
 
-    void setImage(InferenceEngine::InferRequest& inferRequest, const cv::Mat& img, const cv::Rect plateRect) {
+    std::size_t getMaxBatch() const {
+        return maxBatch;
+    }
+
+    // batchIndex selects the place of the plate in the batch of inferRequest
+    void setImage(InferenceEngine::InferRequest& inferRequest, const cv::Mat& img, const cv::Rect plateRect, int batchIndex = 0) {
         InferenceEngine::Blob::Ptr roiBlob = inferRequest.GetBlob(LprInputName);
         if (InferenceEngine::Layout::NHWC == roiBlob->getTensorDesc().getLayout()) {  // autoResize is set
             InferenceEngine::ROI cropRoi{0, static_cast<size_t>(plateRect.x), static_cast<size_t>(plateRect.y), static_cast<size_t>(plateRect.width),
@@ -277,8 +313,9 @@ public:
             InferenceEngine::Blob::Ptr roiBlob = make_shared_blob(frameBlob, cropRoi);
             inferRequest.SetBlob(LprInputName, roiBlob);
         } else {
-            const cv::Mat& vehicleImage = img(plateRect);
-            matU8ToBlob<uint8_t>(vehicleImage, roiBlob);
+            // The plate is scaled straight into the blob without cropping
+            const InferenceEngine::SizeVector& blobSize = roiBlob->getTensorDesc().getDims();
+            warpAffineToBlob<uint8_t>(img, resizeTransform(plateRect, cv::Size(blobSize[3], blobSize[2])), roiBlob, batchIndex);
         }
 
         if (LprInputSeqName != "") {
@@ -293,7 +330,7 @@ public:
         }
     }
 
-    std::string getResults(InferenceEngine::InferRequest& inferRequest) {
+    std::string getResults(InferenceEngine::InferRequest& inferRequest, int batchIndex = 0) {
         static const char *const items[] = {
                 "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
                 "<Anhui>", "<Beijing>", "<Chongqing>", "<Fujian>",
@@ -314,7 +351,7 @@ public:
         // up to 88 items per license plate, ended with "-1"
         InferenceEngine::LockedMemory<const void> lprOutputMapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(
             inferRequest.GetBlob(LprOutputName))->rmap();
-        const auto data = lprOutputMapped.as<float*>();
+        const auto data = lprOutputMapped.as<float*>() + batchIndex * maxSequenceSizePerPlate;
         for (int i = 0; i < maxSequenceSizePerPlate; i++) {
             if (data[i] == -1) {
                 break;
@@ -325,6 +362,7 @@ public:
     }
 
 private:
+    std::size_t maxBatch = 1;
     int maxSequenceSizePerPlate;
     std::string LprInputName;
     std::string LprInputSeqName;
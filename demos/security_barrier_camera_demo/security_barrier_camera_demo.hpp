@@ -8,9 +8,11 @@
 #include <vector>
 #include <gflags/gflags.h>
 #include <iostream>
+#include <samples/default_flags.hpp>
 
 static const char help_message[] = "Print a usage message.";
-static const char video_message[] = "Required for video or image files input. Path to video or image files.";
+static const char video_message[] = "Required for video or image files input. Path to video or image files. synthetic:WxH "
+                                    "generates frames of the given size without decoding to measure the pipeline alone.";
 static const char detection_model_message[] = "Required. Path to the Vehicle and License Plate Detection model .xml file.";
 static const char vehicle_attribs_model_message[] = "Optional. Path to the Vehicle Attributes model .xml file.";
 static const char lpr_model_message[] = "Optional. Path to the License Plate Recognition model .xml file.";
@@ -36,6 +38,8 @@ static const char custom_cpu_library_message[] = "Required for CPU custom layers
 static const char no_show_processed_video[] = "Optional. Do not show processed video.";
 static const char input_resizable_message[] = "Optional. Enable resizable input with support of ROI crop and auto resize.";
 static const char ninfer_request_message[] = "Optional. Number of infer requests. 0 sets the number of infer requests equal to the number of inputs.";
+static const char batch_size_message[] = "Optional. Batch size of the Vehicle Attributes and License Plate Recognition infer requests, an infer request classifies up to this number of objects of a frame at once.";
+static const char detector_batch_size_message[] = "Optional. Batch size of the detection infer requests. While all of them are busy, the frames of different channels are waiting to be batched into one infer request.";
 static const char num_cameras[] = "Required for web camera input. Maximum number of processed camera inputs (web cameras).";
 static const char fpga_device_ids_message[] = "Optional. Specify FPGA device IDs (0,1,n).";
 static const char loop_video_output_message[] = "Optional. Enable playing video on a loop.";
@@ -43,6 +47,8 @@ static const char input_queue_size[] = "Optional. Number of allocated frames. It
 static const char ninputs_message[] = "Optional. Specify the number of channels generated from provided inputs (with -i and -nc keys). "
                                       "For example, if only one camera is provided, but -ni is set to 2, the demo will process frames as if they are captured from two cameras. "
                                       "0 sets the number of input channels equal to the number of provided inputs.";
+static const char dedup_frames_message[] = "Optional. Detect once on the frames in flight sharing an image buffer, e.g. the frames of the channels replicated by -ni "
+                                           "or of a looped image, and give the detections to all of them.";
 static const char fps[] = "Optional. Set the playback speed not faster than the specified FPS. 0 removes the upper bound.";
 static const char worker_threads[] = "Optional. Set the number of threads including the main thread a Worker class will use.";
 static const char display_resolution_message[] = "Optional. Specify the maximum output window resolution.";
@@ -67,17 +73,21 @@ DEFINE_string(d_va, "CPU", target_device_message_vehicle_attribs);
 DEFINE_string(d_lpr, "CPU", target_device_message_lpr);
 DEFINE_bool(pc, false, performance_counter_message);
 DEFINE_bool(r, false, raw_output_message);
+DEFINE_DUMP_FLAG
 DEFINE_double(t, 0.5, thresh_output_message);
 DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_bool(auto_resize, false, input_resizable_message);
 DEFINE_uint32(nireq, 0, ninfer_request_message);
+DEFINE_uint32(bs, 1, batch_size_message);
+DEFINE_uint32(bs_d, 1, detector_batch_size_message);
 DEFINE_uint32(nc, 0, num_cameras);
 DEFINE_string(fpga_device_ids, "", fpga_device_ids_message);
 DEFINE_bool(loop_video, false, loop_video_output_message);
 DEFINE_uint32(n_iqs, 3, input_queue_size);
 DEFINE_uint32(ni, 0, ninputs_message);
+DEFINE_bool(dedup_frames, false, dedup_frames_message);
 DEFINE_uint32(fps, 0, fps);
 DEFINE_uint32(n_wt, 1, worker_threads);
 DEFINE_string(display_resolution, "1920x1080", display_resolution_message);
@@ -107,15 +117,19 @@ void showUsage() {
     std::cout << "    -d_lpr \"<device>\"          " << target_device_message_lpr << std::endl;
     std::cout << "    -pc                        " << performance_counter_message << std::endl;
     std::cout << "    -r                         " << raw_output_message << std::endl;
+    std::cout << "    -dump \"<path>\"             " << dump_message << std::endl;
     std::cout << "    -t                         " << thresh_output_message << std::endl;
     std::cout << "    -no_show                   " << no_show_processed_video << std::endl;
     std::cout << "    -auto_resize               " << input_resizable_message << std::endl;
     std::cout << "    -nireq                     " << ninfer_request_message << std::endl;
+    std::cout << "    -bs                        " << batch_size_message << std::endl;
+    std::cout << "    -bs_d                      " << detector_batch_size_message << std::endl;
     std::cout << "    -nc                        " << num_cameras << std::endl;
     std::cout << "    -fpga_device_ids           " << fpga_device_ids_message << std::endl;
     std::cout << "    -loop_video                " << loop_video_output_message << std::endl;
     std::cout << "    -n_iqs                     " << input_queue_size << std::endl;
     std::cout << "    -ni                        " << ninputs_message << std::endl;
+    std::cout << "    -dedup_frames              " << dedup_frames_message << std::endl;
     std::cout << "    -fps                       " << fps << std::endl;
     std::cout << "    -n_wt                      " << worker_threads << std::endl;
     std::cout << "    -display_resolution        " << display_resolution_message << std::endl;
@@ -20,7 +20,9 @@
 * \example segmentation_demo_async/main.cpp
 */
 
+#include <algorithm>
 #include <iostream>
+#include <random>
 #include <vector>
 #include <string>
 
@@ -40,9 +42,11 @@
 #include "models/segmentation_model.h"
 #include "pipelines/config_factory.h"
 #include "pipelines/metadata.h"
+#include "pipelines/staged_runner.h"
 
 static const char help_message[] = "Print a usage message.";
-static const char video_message[] = "Required. Path to a video file (specify \"cam\" to work with camera).";
+static const char video_message[] = "Required. Path to a video file (specify \"cam\" to work with camera). "
+"A comma separated list of inputs is processed by one network, the results of every input are shown in its own window.";
 static const char model_message[] = "Required. Path to an .xml file with a trained model.";
 static const char target_device_message[] = "Optional. Specify the target device to infer on (the list of available devices is shown below). "
 "Default value is CPU. Use \"-d HETERO:<comma-separated_devices_list>\" format to specify HETERO plugin. "
@@ -59,6 +63,10 @@ static const char num_streams_message[] = "Optional. Number of streams to use fo
 "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
 static const char no_show_processed_video[] = "Optional. Do not show processed video.";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
+static const char drop_frames_message[] = "Optional. Drop the oldest frames instead of waiting when inference or "
+"rendering can't keep up with the input. Useful for live cameras.";
+static const char max_frame_age_message[] = "Optional. Discard captured frames which waited for inference longer than "
+"this number of milliseconds, so the latency of live cameras stays bounded. Zero (default) means no limit.";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(i, "", video_message);
@@ -73,6 +81,9 @@ DEFINE_string(nstreams, "", num_streams_message);
 DEFINE_bool(loop, false, loop_message);
 DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_string(u, "", utilization_monitors_message);
+DEFINE_bool(drop_frames, false, drop_frames_message);
+DEFINE_uint32(max_frame_age, 0, max_frame_age_message);
+DEFINE_BENCHMARK_FLAGS
 
 /**
 * \brief This function shows a help message
@@ -96,6 +107,10 @@ static void showUsage() {
     std::cout << "    -loop                     " << loop_message << std::endl;
     std::cout << "    -no_show                  " << no_show_processed_video << std::endl;
     std::cout << "    -u                        " << utilization_monitors_message << std::endl;
+    std::cout << "    -drop_frames              " << drop_frames_message << std::endl;
+    std::cout << "    -max_frame_age \"<integer>\" " << max_frame_age_message << std::endl;
+    std::cout << "    -limit                    " << limit_message << std::endl;
+    std::cout << "    -report_perf              " << report_perf_message << std::endl;
 }
 
 
@@ -117,30 +132,28 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
         throw std::logic_error("Parameter -m is not set");
     }
 
+    if (!FLAGS_report_perf.empty() && FLAGS_report_perf != "json") {
+        throw std::logic_error("Parameter -report_perf supports json only");
+    }
+
     return true;
 }
 
-cv::Mat applyColorMap(cv::Mat input) {
-    // Initializing colors array if needed
-    static cv::Mat colors;
-    static std::mt19937 rng;
-    static std::uniform_int_distribution<int> distr(0, 255);
-
+const std::vector<cv::Vec3b>& getClassColors() {
+    static std::vector<cv::Vec3b> colors;
     if (colors.empty()) {
-        colors = cv::Mat(256, 1, CV_8UC3);
+        std::mt19937 rng;
+        std::uniform_int_distribution<int> distr(0, 255);
+        colors.resize(256);
         std::size_t i = 0;
         for (; i < arraySize(CITYSCAPES_COLORS); ++i) {
-            colors.at<cv::Vec3b>(i, 0) = { CITYSCAPES_COLORS[i].blue(), CITYSCAPES_COLORS[i].green(), CITYSCAPES_COLORS[i].red() };
+            colors[i] = { CITYSCAPES_COLORS[i].blue(), CITYSCAPES_COLORS[i].green(), CITYSCAPES_COLORS[i].red() };
         }
-        for (; i < (std::size_t)colors.cols; ++i) {
-            colors.at<cv::Vec3b>(i, 0) = cv::Vec3b(distr(rng), distr(rng), distr(rng));
+        for (; i < colors.size(); ++i) {
+            colors[i] = cv::Vec3b(distr(rng), distr(rng), distr(rng));
         }
     }
-
-    // Converting class to color
-    cv::Mat out;
-    cv::applyColorMap(input, out, colors);
-    return out;
+    return colors;
 }
 
 cv::Mat renderSegmentationData(const SegmentationResult& result) {
@@ -151,12 +164,37 @@ cv::Mat renderSegmentationData(const SegmentationResult& result) {
     // Input image is stored inside metadata, as we put it there during submission stage
     auto inputImg = result.metaData->asRef<ImageMetaData>().img;
 
-    if (inputImg.empty()) {
-        throw std::invalid_argument("Renderer: image provided in metadata is empty");
+    if (inputImg.empty() || inputImg.type() != CV_8UC3) {
+        throw std::invalid_argument("Renderer: image provided in metadata is empty or isn't BGR");
     }
 
-    // Visualizing result data over source image
-    return inputImg / 2 + applyColorMap(result.mask) / 2;
+    // Visualizing result data over source image: the mask is upsampled with nearest-neighbour interpolation,
+    // colorized and blended in a single pass, so no frame-sized temporaries are created
+    const cv::Mat& mask = result.mask;
+    const cv::Vec3b* colors = getClassColors().data();
+    // Rendering is done by a single thread, so source column of every frame column is computed once per frame size
+    static std::vector<int> maskCols;
+    static int maskColsFor = 0;
+    if (maskCols.size() != static_cast<size_t>(inputImg.cols) || maskColsFor != mask.cols) {
+        maskCols.resize(inputImg.cols);
+        maskColsFor = mask.cols;
+        for (int x = 0; x < inputImg.cols; ++x) {
+            maskCols[x] = std::min(static_cast<int>(static_cast<int64_t>(x) * mask.cols / inputImg.cols), mask.cols - 1);
+        }
+    }
+    cv::parallel_for_(cv::Range(0, inputImg.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; ++y) {
+            const uint8_t* maskRow = mask.ptr<uint8_t>(static_cast<int>(static_cast<int64_t>(y) * mask.rows / inputImg.rows));
+            uint8_t* imgRow = inputImg.ptr<uint8_t>(y);
+            for (int x = 0; x < inputImg.cols; ++x) {
+                const cv::Vec3b& color = colors[maskRow[maskCols[x]]];
+                imgRow[3 * x] = static_cast<uint8_t>((imgRow[3 * x] + color[0] + 1) >> 1);
+                imgRow[3 * x + 1] = static_cast<uint8_t>((imgRow[3 * x + 1] + color[1] + 1) >> 1);
+                imgRow[3 * x + 2] = static_cast<uint8_t>((imgRow[3 * x + 2] + color[2] + 1) >> 1);
+            }
+        }
+    });
+    return inputImg;
 }
 
 int main(int argc, char *argv[]) {
@@ -172,83 +210,73 @@ int main(int argc, char *argv[]) {
 
         //------------------------------- Preparing Input ------------------------------------------------------
         slog::info << "Reading input" << slog::endl;
-        auto cap = openImagesCapture(FLAGS_i, FLAGS_loop);
-        cv::Mat curr_frame;
+        const size_t readLengthLimit = FLAGS_limit > 0 ? FLAGS_limit : std::numeric_limits<size_t>::max();
+        const bool isMultiSource = FLAGS_i.find(',') != std::string::npos;
+        std::unique_ptr<ImagesCapture> cap;
+        if (isMultiSource) {
+            cap = openMultiSourceCapture(FLAGS_i, FLAGS_loop, readLengthLimit);
+        } else {
+            cap = openImagesCapture(FLAGS_i, FLAGS_loop, 0, readLengthLimit);
+        }
 
         //------------------------------ Running Segmentation routines ----------------------------------------------
         InferenceEngine::Core core;
         AsyncPipeline pipeline(std::unique_ptr<SegmentationModel>(new SegmentationModel(FLAGS_m)),
             ConfigFactory::getUserConfig(FLAGS_d,FLAGS_l,FLAGS_c,FLAGS_pc,FLAGS_nireq,FLAGS_nstreams,FLAGS_nthreads),
             core);
+        pipeline.setPerformanceMetrics(&metrics);
         Presenter presenter;
 
-        bool keepRunning = true;
-        int64_t frameNum = -1;
-        std::unique_ptr<ResultBase> result;
-
-        while (keepRunning) {
-            if (pipeline.isReadyToProcess()) {
-                //--- Capturing frame. If previous frame hasn't been inferred yet, reuse it instead of capturing new one
-                auto startTime = std::chrono::steady_clock::now();
-                curr_frame = cap->read();
-                if (curr_frame.empty()) {
-                    if (frameNum == -1) {
-                        throw std::logic_error("Can't read an image from the input");
-                    }
-                    else {
-                        // Input stream is over
-                        break;
-                    }
-                }
-
-                frameNum = pipeline.submitData(ImageInputData(curr_frame),
-                    std::make_shared<ImageMetaData>(curr_frame, startTime));
-            }
-
-            //--- Waiting for free input slot or output data available. Function will return immediately if any of them are available.
-            pipeline.waitForData();
-
-            //--- Checking for results and rendering data if it's ready
-            //--- If you need just plain data without rendering - cast result's underlying pointer to SegmentationResult*
-            //    and use your own processing instead of calling renderSegmentationData().
-            while ((result = pipeline.getResult()) && keepRunning) {
-                cv::Mat outFrame = renderSegmentationData(result->asRef<SegmentationResult>());
-                //--- Showing results and device information
-                presenter.drawGraphs(outFrame);
-                metrics.update(result->metaData->asRef<ImageMetaData>().timeStamp,
-                    outFrame, { 10, 22 }, 0.65);
-                if (!FLAGS_no_show) {
-                    cv::imshow("Segmentation Results", outFrame);
-
-                    //--- Processing keyboard events
-                    auto key = cv::waitKey(1);
-                    if (27 == key || 'q' == key || 'Q' == key) { // Esc
-                        keepRunning = false;
-                    } else {
-                        presenter.handleKey(key);
-                    }
-                }
-            }
+        StagedRunner::Config runnerConfig;
+        if (FLAGS_drop_frames) {
+            runnerConfig.capturePolicy = StagedRunner::DropPolicy::DropOldest;
+            runnerConfig.renderPolicy = StagedRunner::DropPolicy::DropOldest;
         }
-
-        //// ------------ Waiting for completion of data processing and rendering the rest of results ---------
-        pipeline.waitForTotalCompletion();
-        while (result = pipeline.getResult()) {
-            cv::Mat outFrame = renderSegmentationData(result->asRef<SegmentationResult>());
+        runnerConfig.maxFrameAge = std::chrono::milliseconds(FLAGS_max_frame_age);
+        StagedRunner runner(pipeline, runnerConfig);
+        runner.setPerformanceMetrics(&metrics);
+
+        //--- Frames are captured and submitted for inference on background threads, so rendering results here
+        //    doesn't delay submission of the next frames.
+        //--- If you need just plain data without rendering - cast result to SegmentationResult
+        //    and use your own processing instead of calling renderSegmentationData().
+        StagedRunner::RenderFunction render = [&](const ResultBase& result) {
+            auto renderStartTime = std::chrono::steady_clock::now();
+            cv::Mat outFrame = renderSegmentationData(result.asRef<SegmentationResult>());
+            metrics.recordStage(PerformanceMetrics::Stage::Render, renderStartTime);
             //--- Showing results and device information
             presenter.drawGraphs(outFrame);
-            metrics.update(result->metaData->asRef<ImageMetaData>().timeStamp,
+            metrics.update(result.metaData->asRef<ImageMetaData>().timeStamp,
                 outFrame, { 10, 22 }, 0.65);
             if (!FLAGS_no_show) {
-                cv::imshow("Segmentation Results", outFrame);
-                //--- Updating output window
-                cv::waitKey(1);
+                std::string windowName = "Segmentation Results";
+                if (isMultiSource) {
+                    windowName += " " + std::to_string(result.metaData->asRef<ImageMetaData>().sourceId);
+                }
+                cv::imshow(windowName, outFrame);
+
+                //--- Processing keyboard events
+                auto key = cv::waitKey(1);
+                if (27 == key || 'q' == key || 'Q' == key) { // Esc
+                    return false;
+                }
+                presenter.handleKey(key);
             }
+            return true;
+        };
+        runner.run(*cap, render);
+
+        if (runner.getDroppedCapturedCount() || runner.getDroppedResultsCount()) {
+            slog::info << "Dropped frames: " << runner.getDroppedCapturedCount() << " captured, "
+                << runner.getDroppedResultsCount() << " inferred" << slog::endl;
         }
 
         //// --------------------------- Report metrics -------------------------------------------------------
         slog::info << slog::endl << "Metric reports:" << slog::endl;
         metrics.printTotal();
+        if (!FLAGS_report_perf.empty()) {
+            metrics.reportTotal(FLAGS_report_perf);
+        }
 
         slog::info << presenter.reportMeans() << slog::endl;
     }
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include <opencv2/core/core.hpp>
+#include <models/nms.h>
 
 #include "cnn.hpp"
 
@@ -151,6 +152,29 @@ private:
     };
     typedef std::vector<NormalizedBBox> NormalizedBBoxes;
 
+    /**
+    * @brief Location of the action confidences of a candidate bbox
+    */
+    struct CandidateInfo {
+        /** @brief Index of the action confidence blob */
+        int glob_anchor_id;
+        /** @brief Index of the first action confidence in the blob */
+        int action_conf_idx_shift;
+        /** @brief Step between the action confidences in the blob */
+        int action_conf_step;
+    };
+
+    /** @brief Candidates info, it depends on the network only */
+    std::vector<CandidateInfo> candidates_info_;
+    /** @brief Prior boxes of the new network version, they depend on the input size only */
+    NormalizedBBoxes prior_boxes_;
+    /** @brief Soft-NMS, it keeps its buffers between frames */
+    NonMaxSuppression nms_;
+    /** @brief Indices of the confident candidates of the current frame */
+    std::vector<int> confident_candidates_;
+    /** @brief Decoded candidates of the current frame */
+    DetectedActions valid_detections_;
+
      /**
     * @brief Translates the detections from the network outputs
     *
@@ -165,7 +189,7 @@ private:
                                   const cv::Mat& main_conf,
                                   const cv::Mat& priorboxes,
                                   const std::vector<cv::Mat>& add_conf,
-                                  const cv::Size& frame_size) const;
+                                  const cv::Size& frame_size);
 
      /**
     * @brief Translate input buffer to BBox
@@ -204,14 +228,7 @@ private:
     * @brief Carry out Soft Non-Maximum Suppression algorithm under detected actions
     *
     * @param detections Detected actions
-    * @param sigma Scale parameter
-    * @param top_k Number of top-score bboxes
-    * @param min_det_conf Minimum detection confidence
-    * @param out_indices Out indices of valid detections
+    * @return Indices of valid detections
     */
-    void SoftNonMaxSuppression(const DetectedActions& detections,
-                               const float sigma,
-                               const int top_k,
-                               const float min_det_conf,
-                               std::vector<int>* out_indices) const;
+    const std::vector<size_t>& SoftNonMaxSuppression(const DetectedActions& detections);
 };
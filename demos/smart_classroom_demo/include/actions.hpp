@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <map>
 #include <vector>
 
 /**
@@ -47,4 +48,51 @@ struct RangeEvent {
 };
 using RangeEventsTrack = std::vector<RangeEvent>;
 
+/**
+* @brief Turns per-frame actions of tracks into range events while the frames are processed.
+* Neighbouring actions closer than window_size frames are merged, events shorter than min_length
+* frames are dropped, the gaps between the events are split in the middle and the first and the last
+* events are extended to the start and to the end of the session. An event is stored when the next
+* event with a different action is known, so every track keeps a constant state besides its events.
+*/
+class RangeEventsAggregator {
+public:
+    RangeEventsAggregator(int start_frame, int window_size, int min_length, Action default_action);
+
+    /**
+    * @brief Adds action of the track on the frame. Frame indices of a track must increase.
+    * Default actions are ignored.
+    */
+    void AddFrameEvent(int obj_id, const FrameEvent& frame_event);
+
+    /**
+    * @brief Finishes events of all the tracks, the session ends before end_frame.
+    * Tracks without kept events get a single default action event.
+    */
+    void Finalize(int end_frame);
+
+    /** @brief Events of the tracks. The last events of the tracks are added by Finalize() */
+    const std::map<int, RangeEventsTrack>& events() const { return obj_id_to_events_; }
+
+private:
+    struct TrackState {
+        bool has_open = false;
+        RangeEvent open{0, 0, 0};  ///< Event neighbouring actions are merged to
+        bool has_kept = false;
+        RangeEvent kept{0, 0, 0};  ///< The last event longer than min_length, its end isn't interpolated yet
+        bool has_merged = false;
+        RangeEvent merged{0, 0, 0};  ///< The last final event, it's extended by the next event with the same action
+    };
+
+    void CloseOpenEvent(int obj_id, TrackState& state);
+    void AddMergedEvent(int obj_id, TrackState& state, const RangeEvent& event);
+
+    int start_frame_;
+    int window_size_;
+    int min_length_;
+    Action default_action_;
+    std::map<int, TrackState> states_;
+    std::map<int, RangeEventsTrack> obj_id_to_events_;
+};
+
 enum ActionsType { STUDENT, TEACHER, TOP_K };
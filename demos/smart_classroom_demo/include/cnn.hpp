@@ -59,6 +59,11 @@ public:
     */
     void PrintPerformanceCounts(std::string fullDeviceName) const;
 
+    /**
+    * @brief Returns path to model description
+    */
+    const std::string& PathToModel() const { return config_.path_to_model; }
+
 protected:
     /**
    * @brief Run network
@@ -78,6 +83,23 @@ protected:
     void InferBatch(const std::vector<cv::Mat>& frames,
                     const std::function<void(const InferenceEngine::BlobMap&, size_t)>& results_fetcher) const;
 
+    /**
+   * @brief Starts asynchronous inference of the inputs, every batch runs on its own infer request
+   *
+   * @param num_inputs Number of inputs
+   * @param input_filler Callback to write the input to the batch item of the input blob. It is called
+   * from several threads at once for the items of a batch
+   */
+    void StartBatches(size_t num_inputs,
+                      const std::function<void(InferenceEngine::Blob::Ptr&, size_t, size_t)>& input_filler) const;
+
+    /**
+   * @brief Waits for the batches started by StartBatches()
+   *
+   * @param results_fetcher Callback to fetch inference results of every batch in order
+   */
+    void WaitBatches(const std::function<void(const InferenceEngine::BlobMap&, size_t)>& results_fetcher) const;
+
     /** @brief Config */
     Config config_;
     /** @brief Net inputs info */
@@ -86,8 +108,10 @@ protected:
     InferenceEngine::OutputsDataMap outInfo_;
     /** @brief IE network */
     InferenceEngine::ExecutableNetwork executable_network_;
-    /** @brief IE InferRequest */
-    mutable InferenceEngine::InferRequest infer_request_;
+    /** @brief IE InferRequests, the batches of the inputs run on them at once */
+    mutable std::vector<InferenceEngine::InferRequest> infer_requests_;
+    /** @brief Sizes of the started batches, a batch per request */
+    mutable std::vector<size_t> started_batch_sizes_;
     /** @brief Name of the input blob input blob */
     std::string input_blob_name_;
     /** @brief Names of output blobs */
@@ -102,6 +126,22 @@ public:
                  cv::Mat* vector, cv::Size outp_shape = cv::Size()) const;
     void Compute(const std::vector<cv::Mat>& images,
                  std::vector<cv::Mat>* vectors, cv::Size outp_shape = cv::Size()) const;
+
+    /**
+    * @brief Starts computing the vectors of the inputs asynchronously
+    *
+    * @param num_inputs Number of inputs
+    * @param input_filler Callback to write the input with the given index to the batch item of the
+    * U8 NCHW input blob, it is called from several threads at once
+    */
+    void StartCompute(size_t num_inputs,
+                      const std::function<void(InferenceEngine::Blob::Ptr& blob, size_t batch_index,
+                                               size_t input_index)>& input_filler) const;
+
+    /**
+    * @brief Waits for the vectors of the inputs passed to StartCompute()
+    */
+    void WaitCompute(std::vector<cv::Mat>* vectors, cv::Size outp_shape = cv::Size()) const;
 };
 
 class AsyncAlgorithm {
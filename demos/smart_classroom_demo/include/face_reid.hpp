@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -45,15 +46,20 @@ public:
     bool LabelExists(const std::string& label) const;
 
 private:
-    RegistrationStatus RegisterIdentity(const std::string& identity_label,
-                                        const cv::Mat& image,
-                                        int min_size_fr,
-                                        bool crop_gallery,
-                                        detection::FaceDetection& detector,
-                                        const VectorCNN& landmarks_det,
-                                        const VectorCNN& image_reid,
-                                        cv::Mat & embedding);
+    // Registers the images of the gallery as a batch. The embeddings of the failed images stay empty
+    std::vector<RegistrationStatus> RegisterImages(const std::vector<cv::Mat>& images,
+                                                   int min_size_fr,
+                                                   bool crop_gallery,
+                                                   detection::FaceDetection& detector,
+                                                   const VectorCNN& landmarks_det,
+                                                   const VectorCNN& image_reid,
+                                                   std::vector<cv::Mat>* embeddings);
+    // Loads the gallery from the cache unless it is missing or has another tag
+    bool LoadCache(const std::string& path, uint64_t tag);
+    // Throws an exception if cannot write the cache
+    void SaveCache(const std::string& path, uint64_t tag) const;
     std::vector<int> idx_to_id;
+    cv::Mat gallery_embeddings;  // normalized CV_32F embeddings, a row per idx
     double reid_threshold;
     std::vector<GalleryObject> identities;
     bool use_greedy_matcher;
@@ -61,3 +67,7 @@ private:
 
 void AlignFaces(std::vector<cv::Mat>* face_images,
                 std::vector<cv::Mat>* landmarks_vec);
+
+// Aligns the face and writes it resized to the batch item of the U8 NCHW blob
+void AlignFaceToBlob(const cv::Mat& face_image, const cv::Mat& landmarks,
+                     InferenceEngine::Blob::Ptr& blob, size_t batch_index);
@@ -11,26 +11,61 @@
 #include <map>
 #include <string>
 #include <iostream>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <opencv2/opencv.hpp>
 #include <sstream>
 #include <details/ie_exception.hpp>
+#include <samples/mpmc_queue.hpp>
 #include "tracker.hpp"
 
 #include "actions.hpp"
 
+///
+/// \brief Logs per-frame objects (-r) and action detections (-al). Records of
+/// a frame are collected by the calling thread and passed through a lock-free
+/// queue to a writer thread, which formats and writes them in batches. So the
+/// frame loop doesn't wait for formatting and the file system, and only a
+/// bounded number of frame records exist at once.
+///
 class DetectionsLogger {
 private:
+    struct FrameRecord;
+
     bool write_logs_;
     std::ofstream act_stat_log_stream_;
     cv::FileStorage act_det_log_stream_;
+    std::ofstream act_det_bin_stream_;  ///< Used instead of act_det_log_stream_ for .bin files.
     std::ostream& log_stream_;
 
+    std::vector<std::unique_ptr<FrameRecord>> records_;
+    FrameRecord* current_record_;
+    MpmcQueue<FrameRecord*> filled_records_;
+    MpmcQueue<FrameRecord*> free_records_;
+    std::atomic<size_t> pending_records_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::thread writer_thread_;
+
+    void WriterLoop();
+    void WriteRecord(const FrameRecord& record, std::string& text);
+    /// Waits until the writer thread writes all finalized frame records.
+    void Flush();
+
 public:
     explicit DetectionsLogger(std::ostream& stream, bool enabled,
                               const std::string& act_stat_log_file,
                               const std::string& act_det_log_file);
 
     ~DetectionsLogger();
+    DetectionsLogger(const DetectionsLogger&) = delete;
+    DetectionsLogger& operator=(const DetectionsLogger&) = delete;
+
     void CreateNextFrameRecord(const std::string& path, const int frame_idx,
                                const size_t width, const size_t height);
     void AddFaceToFrame(const cv::Rect& rect, const std::string& id, const std::string& action);
@@ -44,7 +79,7 @@ public:
                         const std::map<int, int>& track_id_to_label_faces,
                         const std::vector<std::string>& action_idx_to_label,
                         const std::vector<std::string>& person_id_to_label,
-                        const std::vector<std::map<int, int>>& frame_face_obj_id_to_action_maps);
+                        const std::map<int, RangeEventsTrack>& obj_id_to_events);
     void DumpTracks(const std::map<int, RangeEventsTrack>& obj_id_to_events,
                     const std::vector<std::string>& action_idx_to_label,
                     const std::map<int, int>& track_id_to_label_faces,
@@ -65,8 +65,12 @@ static const char target_actions_num_message[] = "Optional. Number of first K st
 static const char crop_gallery_message[] = "Optional. Crop images during faces gallery creation.";
 static const char face_threshold_registration_output_message[] = "Optional. Probability threshold for face detections during database registration.";
 static const char min_size_fr_reg_output_message[] = "Optional. Minimum input size for faces during database registration.";
-static const char act_det_output_message[] = "Optional. Output file name to save per-person action detections in.";
+static const char act_det_output_message[] = "Optional. Output file name to save per-person action detections in. "
+                                             "Files with .bin extension get compact binary records.";
 static const char tracker_smooth_size_message[] = "Optional. Number of frames to smooth actions.";
+static const char detection_interval_message[] = "Optional. Detect faces and actions on every N-th frame only, the "
+                                                 "tracked objects of the last detected frame are shown and logged for "
+                                                 "the frames in between. Default value is 1 (every frame is detected).";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
 
 DEFINE_bool(h, false, help_message);
@@ -91,6 +95,7 @@ DEFINE_double(t_fd, 0.6, face_threshold_output_message);
 DEFINE_double(t_reid, 0.7, threshold_output_message_face_reid);
 DEFINE_string(fg, "", reid_gallery_path_message);
 DEFINE_string(out_v, "", output_video_message);
+DEFINE_VIDEO_ENCODE_FLAG
 DEFINE_bool(no_show, false, no_show_processed_video);
 DEFINE_int32(inh_fd, 600, input_image_height_output_message);
 DEFINE_int32(inw_fd, 600, input_image_width_output_message);
@@ -108,6 +113,7 @@ DEFINE_double(t_reg_fd, 0.9, face_threshold_registration_output_message);
 DEFINE_int32(min_size_fr, 128, min_size_fr_reg_output_message);
 DEFINE_string(al, "", act_det_output_message);
 DEFINE_int32(ss_t, -1, tracker_smooth_size_message);
+DEFINE_uint32(det_interval, 1, detection_interval_message);
 DEFINE_string(u, "", utilization_monitors_message);
 
 /**
@@ -134,6 +140,7 @@ static void showUsage() {
     std::cout << "    -d_lm '<device>'               " << target_device_message_landmarks_regression << std::endl;
     std::cout << "    -d_reid '<device>'             " << target_device_message_face_reid << std::endl;
     std::cout << "    -out_v  '<path>'               " << output_video_message << std::endl;
+    std::cout << "    -encode '<mode>'               " << encode_message << std::endl;
     std::cout << "    -greedy_reid_matching          " << greedy_reid_matching_message << std::endl;
     std::cout << "    -pc                            " << performance_counter_message << std::endl;
     std::cout << "    -r                             " << raw_output_message << std::endl;
@@ -160,5 +167,6 @@ static void showUsage() {
     std::cout << "    -min_size_fr                   " << min_size_fr_reg_output_message << std::endl;
     std::cout << "    -al                            " << act_det_output_message << std::endl;
     std::cout << "    -ss_t                          " << tracker_smooth_size_message << std::endl;
+    std::cout << "    -det_interval                  " << detection_interval_message << std::endl;
     std::cout << "    -u                             " << utilization_monitors_message << std::endl;
 }
@@ -6,6 +6,9 @@
 
 #include "cnn.hpp"
 
+#include <tracker_core/kuhn_munkres.h>
+#include <tracker_core/tracker_core.h>
+
 #include <memory>
 #include <set>
 #include <string>
@@ -33,34 +36,6 @@ struct TrackedObject {
 
 using TrackedObjects = std::vector<TrackedObject>;
 
-///
-/// \brief The KuhnMunkres class
-///
-/// Solves the assignment problem.
-///
-class KuhnMunkres {
-public:
-    ///
-    /// \brief Initializes the class for assignment problem solving.
-    /// \param[in] greedy If a faster greedy matching algorithm should be used.
-    explicit KuhnMunkres(bool greedy = false);
-
-    ///
-    /// \brief Solves the assignment problem for given dissimilarity matrix.
-    /// It returns a vector that where each element is a column index for
-    /// corresponding row (e.g. result[0] stores optimal column index for very
-    /// first row in the dissimilarity matrix).
-    /// \param dissimilarity_matrix CV_32F dissimilarity matrix.
-    /// \return Optimal column index for each row. -1 means that there is no
-    /// column for row.
-    ///
-    std::vector<size_t> Solve(const cv::Mat &dissimilarity_matrix);
-
-private:
-    class Impl;
-    std::shared_ptr<Impl> impl_;  ///< Class implementation.
-};
-
 ///
 /// \brief The Params struct stores parameters of Tracker.
 ///
@@ -103,72 +78,7 @@ struct TrackerParams {
     TrackerParams();
 };
 
-///
-/// \brief The Track struct describes tracks.
-///
-struct Track {
-    ///
-    /// \brief Track constructor.
-    /// \param objs Detected objects sequence.
-    ///
-    explicit Track(const TrackedObjects &objs) : objects(objs), lost(0), length(1) {
-        CV_Assert(!objs.empty());
-        first_object = objs[0];
-    }
-
-    ///
-    /// \brief empty returns if track does not contain objects.
-    /// \return true if track does not contain objects.
-    ///
-    bool empty() const { return objects.empty(); }
-
-    ///
-    /// \brief size returns number of detected objects in a track.
-    /// \return number of detected objects in a track.
-    ///
-    size_t size() const { return objects.size(); }
-
-    ///
-    /// \brief operator [] return const reference to detected object with
-    ///        specified index.
-    /// \param i Index of object.
-    /// \return const reference to detected object with specified index.
-    ///
-    const TrackedObject &operator[](size_t i) const { return objects[i]; }
-
-    ///
-    /// \brief operator [] return non-const reference to detected object with
-    ///        specified index.
-    /// \param i Index of object.
-    /// \return non-const reference to detected object with specified index.
-    ///
-    TrackedObject &operator[](size_t i) { return objects[i]; }
-
-    ///
-    /// \brief back returns const reference to last object in track.
-    /// \return const reference to last object in track.
-    ///
-    const TrackedObject &back() const {
-        CV_Assert(!empty());
-        return objects.back();
-    }
-
-    ///
-    /// \brief back returns non-const reference to last object in track.
-    /// \return non-const reference to last object in track.
-    ///
-    TrackedObject &back() {
-        CV_Assert(!empty());
-        return objects.back();
-    }
-
-    TrackedObjects objects;  ///< Detected objects;
-    size_t lost;             ///< How many frames ago track has been lost.
-
-    TrackedObject first_object;  ///< First object in track.
-    size_t length;  ///< Length of a track including number of objects that were
-                    /// removed from track in order to avoid memory usage growth.
-};
+using Track = TrackBase<TrackedObject, TrackedObjects>;
 
 ///
 /// \brief Simple Hungarian algorithm-based tracker.
@@ -182,7 +92,7 @@ public:
     ///
     explicit Tracker(const TrackerParams &params = TrackerParams())
         : params_(params),
-          tracks_counter_(0),
+          core_(params.forget_delay, params.max_num_objects_in_track),
           frame_size_() {}
 
     ///
@@ -271,61 +181,36 @@ public:
     void DropForgottenTracks();
 
 private:
-    const std::set<size_t> &active_track_ids() const { return active_track_ids_; }
-
-    float ShapeAffinity(const cv::Rect &trk, const cv::Rect &det);
-    float MotionAffinity(const cv::Rect &trk, const cv::Rect &det);
+    const std::set<size_t> &active_track_ids() const { return core_.active_track_ids(); }
 
     void SolveAssignmentProblem(
             const std::set<size_t> &track_ids, const TrackedObjects &detections,
             std::set<size_t> *unmatched_tracks,
             std::set<size_t> *unmatched_detections,
             std::set<std::tuple<size_t, size_t, float>> *matches);
-    void FilterDetectionsAndStore(const TrackedObjects &detected_objects);
-
-    void ComputeDissimilarityMatrix(const std::set<size_t> &active_track_ids,
-                                    const TrackedObjects &detections,
-                                    cv::Mat *dissimilarity_matrix);
-
-    std::vector<std::pair<size_t, size_t>> GetTrackToDetectionIds(
-            const std::set<std::tuple<size_t, size_t, float>> &matches);
-
-    float Distance(const TrackedObject &obj1, const TrackedObject &obj2);
 
-    void AddNewTrack(const TrackedObject &detection);
+    float Distance(const TrackedObject &obj1, const TrackedObject &obj2) const;
 
     void AddNewTracks(const TrackedObjects &detections);
 
     void AddNewTracks(const TrackedObjects &detections,
                       const std::set<size_t> &ids);
 
-    void AppendToTrack(size_t track_id, const TrackedObject &detection);
-
     bool EraseTrackIfBBoxIsOutOfFrame(size_t track_id);
 
-    bool EraseTrackIfItWasLostTooManyFramesAgo(size_t track_id);
-
     bool UptateLostTrackAndEraseIfItsNeeded(size_t track_id);
 
     void UpdateLostTracks(const std::set<size_t> &track_ids);
 
-    std::unordered_map<size_t, std::vector<cv::Point>> GetActiveTracks();
-
     // Parameters of the pipeline.
     TrackerParams params_;
 
-    // Indexes of active tracks.
-    std::set<size_t> active_track_ids_;
-
-    // All tracks.
-    std::unordered_map<size_t, Track> tracks_;
+    // Tracks and their IDs.
+    TrackerCore<Track> core_;
 
     // Recent detections.
     TrackedObjects detections_;
 
-    // Number of all current tracks.
-    size_t tracks_counter_;
-
     cv::Size frame_size_;
 };
 
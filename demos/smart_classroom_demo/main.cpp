@@ -8,8 +8,10 @@
 #include <monitors/presenter.h>
 #include <samples/args_helper.hpp>
 #include <samples/images_capture.h>
+#include <samples/model_loader.hpp>
 #include <samples/ocv_common.hpp>
 #include <samples/slog.hpp>
+#include <samples/video_writer.h>
 #include <string>
 #include <memory>
 #include <limits>
@@ -39,7 +41,7 @@ private:
     cv::Mat top_persons_;
     const bool enabled_;
     const int num_top_persons_;
-    cv::VideoWriter& writer_;
+    AsyncVideoWriter* writer_;
     float rect_scale_x_;
     float rect_scale_y_;
     static int const max_input_width_ = 1920;
@@ -51,7 +53,7 @@ private:
     static int const margin_size_ = 5;
 
 public:
-    Visualizer(bool enabled, cv::VideoWriter& writer, int num_top_persons) : enabled_(enabled), num_top_persons_(num_top_persons), writer_(writer),
+    Visualizer(bool enabled, AsyncVideoWriter* writer, int num_top_persons) : enabled_(enabled), num_top_persons_(num_top_persons), writer_(writer),
                                                         rect_scale_x_(0), rect_scale_y_(0) {
         if (!enabled_) {
             return;
@@ -76,7 +78,7 @@ public:
     }
 
     void SetFrame(const cv::Mat& frame) {
-        if (!enabled_ && !writer_.isOpened()) {
+        if (!enabled_ && !writer_) {
             return;
         }
 
@@ -96,8 +98,8 @@ public:
             cv::imshow(main_window_name_, frame_);
         }
 
-        if (writer_.isOpened()) {
-            writer_ << frame_;
+        if (writer_) {
+            writer_->write(frame_);
         }
     }
 
@@ -136,7 +138,7 @@ public:
 
     void DrawObject(cv::Rect rect, const std::string& label_to_draw,
                     const cv::Scalar& text_color, const cv::Scalar& bbox_color, bool plot_bg) {
-        if (!enabled_ && !writer_.isOpened()) {
+        if (!enabled_ && !writer_) {
             return;
         }
 
@@ -164,7 +166,7 @@ public:
     }
 
     void DrawFPS(const float fps, const cv::Scalar& color) {
-        if (enabled_ && !writer_.isOpened()) {
+        if (enabled_ && !writer_) {
             cv::putText(frame_,
                         std::to_string(static_cast<int>(fps)) + " fps",
                         cv::Point(10, 50), cv::FONT_HERSHEY_SIMPLEX, 1,
@@ -219,116 +221,14 @@ public:
             }
         }
 
-        if (writer_.isOpened()) {
-            writer_.release();
+        if (writer_) {
+            writer_->close();
         }
     }
 };
 
 const int default_action_index = -1;  // Unknown action class
 
-void ConvertActionMapsToFrameEventTracks(const std::vector<std::map<int, int>>& obj_id_to_action_maps,
-                                         int default_action,
-                                         std::map<int, FrameEventsTrack>* obj_id_to_actions_track) {
-    for (size_t frame_id = 0; frame_id < obj_id_to_action_maps.size(); ++frame_id) {
-        for (const auto& tup : obj_id_to_action_maps[frame_id]) {
-            if (tup.second != default_action) {
-                (*obj_id_to_actions_track)[tup.first].emplace_back(frame_id, tup.second);
-            }
-        }
-    }
-}
-
-void SmoothTracks(const std::map<int, FrameEventsTrack>& obj_id_to_actions_track,
-                  int start_frame, int end_frame, int window_size, int min_length, int default_action,
-                  std::map<int, RangeEventsTrack>* obj_id_to_events) {
-    // Iterate over face tracks
-    for (const auto& tup : obj_id_to_actions_track) {
-        const auto& frame_events = tup.second;
-        if (frame_events.empty()) {
-            continue;
-        }
-
-        RangeEventsTrack range_events;
-
-
-        // Merge neighbouring events and filter short ones
-        range_events.emplace_back(frame_events.front().frame_id,
-                                  frame_events.front().frame_id + 1,
-                                  frame_events.front().action);
-
-        for (size_t frame_id = 1; frame_id < frame_events.size(); ++frame_id) {
-            const auto& last_range_event = range_events.back();
-            const auto& cur_frame_event = frame_events[frame_id];
-
-            if (last_range_event.end_frame_id + window_size - 1 >= cur_frame_event.frame_id &&
-                last_range_event.action == cur_frame_event.action) {
-                range_events.back().end_frame_id = cur_frame_event.frame_id + 1;
-            } else {
-                if (range_events.back().end_frame_id - range_events.back().begin_frame_id < min_length) {
-                    range_events.pop_back();
-                }
-
-                range_events.emplace_back(cur_frame_event.frame_id,
-                                          cur_frame_event.frame_id + 1,
-                                          cur_frame_event.action);
-            }
-        }
-        if (range_events.back().end_frame_id - range_events.back().begin_frame_id < min_length) {
-            range_events.pop_back();
-        }
-
-        // Extrapolate track
-        if (range_events.empty()) {
-            range_events.emplace_back(start_frame, end_frame, default_action);
-        } else {
-            range_events.front().begin_frame_id = start_frame;
-            range_events.back().end_frame_id = end_frame;
-        }
-
-        // Interpolate track
-        for (size_t event_id = 1; event_id < range_events.size(); ++event_id) {
-            auto& last_event = range_events[event_id - 1];
-            auto& cur_event = range_events[event_id];
-
-            int middle_point = static_cast<int>(0.5f * (cur_event.begin_frame_id + last_event.end_frame_id));
-
-            cur_event.begin_frame_id = middle_point;
-            last_event.end_frame_id = middle_point;
-        }
-
-        // Merge consecutive events
-        auto& final_events = (*obj_id_to_events)[tup.first];
-        final_events.push_back(range_events.front());
-        for (size_t event_id = 1; event_id < range_events.size(); ++event_id) {
-            const auto& cur_event = range_events[event_id];
-
-            if (final_events.back().action == cur_event.action) {
-                final_events.back().end_frame_id = cur_event.end_frame_id;
-            } else {
-                final_events.push_back(cur_event);
-            }
-        }
-    }
-}
-
-void ConvertRangeEventsTracksToActionMaps(int num_frames,
-                                          const std::map<int, RangeEventsTrack>& obj_id_to_events,
-                                          std::vector<std::map<int, int>>* obj_id_to_action_maps) {
-    obj_id_to_action_maps->resize(num_frames);
-
-    for (const auto& tup : obj_id_to_events) {
-        const int obj_id = tup.first;
-        const auto& events = tup.second;
-
-        for (const auto& event : events) {
-            for (int frame_id = event.begin_frame_id; frame_id < event.end_frame_id; ++frame_id) {
-                (*obj_id_to_action_maps)[frame_id].emplace(obj_id, event.action);
-            }
-        }
-    }
-}
-
 std::string GetActionTextLabel(const unsigned label, const std::vector<std::string>& actions_map) {
     if (label < actions_map.size()) {
         return actions_map[label];
@@ -424,7 +324,10 @@ public:
     virtual std::string GetLabelByID(int id) const = 0;
     virtual std::vector<std::string> GetIDToLabelMap() const = 0;
 
-    virtual std::vector<int> Recognize(const cv::Mat& frame, const detection::DetectedObjects& faces) = 0;
+    // Starts recognition of the faces, it runs asynchronously until FinishRecognition() is called
+    virtual void StartRecognition(const cv::Mat& frame, const detection::DetectedObjects& faces) = 0;
+    // Returns the IDs of the faces passed to StartRecognition()
+    virtual std::vector<int> FinishRecognition() = 0;
 
     virtual void PrintPerformanceCounts(
         const std::string &landmarks_device, const std::string &reid_device) = 0;
@@ -440,12 +343,19 @@ public:
 
     std::vector<std::string> GetIDToLabelMap() const override { return {}; }
 
-    std::vector<int> Recognize(const cv::Mat&, const detection::DetectedObjects& faces) override {
-        return std::vector<int>(faces.size(), EmbeddingsGallery::unknown_id);
+    void StartRecognition(const cv::Mat&, const detection::DetectedObjects& faces) override {
+        num_faces = faces.size();
+    }
+
+    std::vector<int> FinishRecognition() override {
+        return std::vector<int>(num_faces, EmbeddingsGallery::unknown_id);
     }
 
     void PrintPerformanceCounts(
         const std::string &, const std::string &) override {}
+
+private:
+    size_t num_faces = 0;
 };
 
 class FaceRecognizerDefault : public FaceRecognizer {
@@ -485,18 +395,26 @@ public:
         return face_gallery.GetIDToLabelMap();
     }
 
-    std::vector<int> Recognize(const cv::Mat& frame, const detection::DetectedObjects& faces) override {
+    void StartRecognition(const cv::Mat& frame, const detection::DetectedObjects& faces) override {
         std::vector<cv::Mat> face_rois;
 
         for (const auto& face : faces) {
             face_rois.push_back(frame(face.rect));
         }
 
-        std::vector<cv::Mat> landmarks, embeddings;
+        std::vector<cv::Mat> landmarks;
 
         landmarks_detector.Compute(face_rois, &landmarks, cv::Size(2, 5));
-        AlignFaces(&face_rois, &landmarks);
-        face_reid.Compute(face_rois, &embeddings);
+        // The faces are aligned in parallel right into the reid input blobs
+        face_reid.StartCompute(face_rois.size(),
+            [&face_rois, &landmarks](InferenceEngine::Blob::Ptr& blob, size_t batch_index, size_t face_index) {
+                AlignFaceToBlob(face_rois[face_index], landmarks[face_index], blob, batch_index);
+            });
+    }
+
+    std::vector<int> FinishRecognition() override {
+        std::vector<cv::Mat> embeddings;
+        face_reid.WaitCompute(&embeddings);
         return face_gallery.GetIDsByEmbeddings(embeddings);
     }
 
@@ -614,6 +532,9 @@ int main(int argc, char* argv[]) {
             loadedDevices.insert(device);
         }
 
+        // The networks are read and loaded concurrently
+        ModelLoader modelLoader;
+
         std::unique_ptr<AsyncDetection<DetectedAction>> action_detector;
         if (!ad_model_path.empty()) {
             // Load action detector
@@ -624,7 +545,9 @@ int main(int argc, char* argv[]) {
             action_config.detection_confidence_threshold = static_cast<float>(FLAGS_t_ad);
             action_config.action_confidence_threshold = static_cast<float>(FLAGS_t_ar);
             action_config.num_action_classes = actions_map.size();
-            action_detector.reset(new ActionDetection(action_config));
+            modelLoader.add([&action_detector, action_config]() {
+                action_detector.reset(new ActionDetection(action_config));
+            });
         } else {
             action_detector.reset(new NullDetection<DetectedAction>);
         }
@@ -641,7 +564,9 @@ int main(int argc, char* argv[]) {
             face_config.input_w = FLAGS_inw_fd;
             face_config.increase_scale_x = static_cast<float>(FLAGS_exp_r_fd);
             face_config.increase_scale_y = static_cast<float>(FLAGS_exp_r_fd);
-            face_detector.reset(new detection::FaceDetection(face_config));
+            modelLoader.add([&face_detector, face_config]() {
+                face_detector.reset(new detection::FaceDetection(face_config));
+            });
         } else {
             face_detector.reset(new NullDetection<detection::DetectedObject>);
         }
@@ -675,10 +600,14 @@ int main(int argc, char* argv[]) {
                 landmarks_config.max_batch_size = 1;
             landmarks_config.ie = ie;
 
-            face_recognizer.reset(new FaceRecognizerDefault(
-                landmarks_config, reid_config,
-                face_registration_det_config,
-                FLAGS_fg, FLAGS_t_reid, FLAGS_min_size_fr, FLAGS_crop_gallery, FLAGS_greedy_reid_matching));
+            // The recognizer loads its networks and fills the gallery with them on one thread
+            modelLoader.add([&face_recognizer, landmarks_config, reid_config, face_registration_det_config]() {
+                face_recognizer.reset(new FaceRecognizerDefault(
+                    landmarks_config, reid_config,
+                    face_registration_det_config,
+                    FLAGS_fg, FLAGS_t_reid, FLAGS_min_size_fr, FLAGS_crop_gallery, FLAGS_greedy_reid_matching));
+            });
+            modelLoader.wait();
 
             if (actions_type == TEACHER && !face_recognizer->LabelExists(teacher_id)) {
                 slog::err << "Teacher id does not exist in the gallery!" << slog::endl;
@@ -693,6 +622,7 @@ int main(int argc, char* argv[]) {
 
             face_recognizer.reset(new FaceRecognizerNull);
         }
+        modelLoader.wait();
 
         // Create tracker for reid
         TrackerParams tracker_reid_params;
@@ -734,7 +664,6 @@ int main(int argc, char* argv[]) {
         const cv::Scalar green_color(0, 255, 0);
         const cv::Scalar red_color(0, 0, 255);
         const cv::Scalar white_color(255, 255, 255);
-        std::vector<std::map<int, int>> face_obj_id_to_action_maps;
         std::map<int, int> top_k_obj_ids;
 
         int teacher_track_id = -1;
@@ -745,15 +674,20 @@ int main(int argc, char* argv[]) {
             throw std::runtime_error("Can't read an image from the input");
         }
 
+        const int smooth_window_size = static_cast<int>(cap->fps() * FLAGS_d_ad);
+        const int smooth_min_length = static_cast<int>(cap->fps() * FLAGS_min_ad);
+        RangeEventsAggregator face_events_aggregator(0, smooth_window_size, smooth_min_length, default_action_index);
+
         cv::Size graphSize{static_cast<int>(frame.cols / 4), 60};
         Presenter presenter(FLAGS_u, frame.rows - graphSize.height - 10, graphSize);
 
-        cv::VideoWriter vid_writer;
+        std::unique_ptr<AsyncVideoWriter> vid_writer;
         if (!FLAGS_out_v.empty()) {
-            vid_writer = cv::VideoWriter(FLAGS_out_v, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
-                                         cap->fps(), Visualizer::GetOutputSize(frame.size()));
+            vid_writer.reset(new AsyncVideoWriter(FLAGS_out_v, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                                                  cap->fps(), Visualizer::GetOutputSize(frame.size()),
+                                                  parseVideoEncodeMode(FLAGS_encode)));
         }
-        Visualizer sc_visualizer(!FLAGS_no_show, vid_writer, num_top_persons);
+        Visualizer sc_visualizer(!FLAGS_no_show, vid_writer.get(), num_top_persons);
         DetectionsLogger logger(std::cout, FLAGS_r, FLAGS_ad, FLAGS_al);
 
         std::cout << "To close the application, press 'CTRL+C' here";
@@ -770,6 +704,9 @@ int main(int argc, char* argv[]) {
         }
 
         bool is_monitoring_enabled = false;
+        // The faces and the actions of the last detected frame are kept for the frames which aren't detected
+        const unsigned det_interval = std::max(FLAGS_det_interval, 1u);
+        TrackedObjects tracked_actions, tracked_faces;
 
         bool is_last_frame = false;
         while (!is_last_frame) {
@@ -877,37 +814,50 @@ int main(int argc, char* argv[]) {
                     }
                 }
             } else {
-                face_detector->wait();
-                detection::DetectedObjects faces = face_detector->fetchResults();
+                // The frame is submitted to the detectors one iteration before it's processed
+                const bool is_detected = work_num_frames % det_interval == 0;
+                const bool is_next_detected = (work_num_frames + 1) % det_interval == 0;
 
-                action_detector->wait();
-                DetectedActions actions = action_detector->fetchResults();
+                detection::DetectedObjects faces;
+                DetectedActions actions;
+                if (is_detected) {
+                    face_detector->wait();
+                    faces = face_detector->fetchResults();
 
-                if (!is_last_frame) {
+                    action_detector->wait();
+                    actions = action_detector->fetchResults();
+                }
+
+                if (!is_last_frame && is_next_detected) {
                     face_detector->enqueue(frame);
                     face_detector->submitRequest();
                     action_detector->enqueue(frame);
                     action_detector->submitRequest();
                 }
 
-                auto ids = face_recognizer->Recognize(prev_frame, faces);
+                if (is_detected) {
+                    // The faces are reidentified while the actions are tracked
+                    face_recognizer->StartRecognition(prev_frame, faces);
 
-                TrackedObjects tracked_face_objects;
+                    TrackedObjects tracked_action_objects;
+                    for (const auto& action : actions) {
+                        tracked_action_objects.emplace_back(action.rect, action.detection_conf, action.label);
+                    }
 
-                for (size_t i = 0; i < faces.size(); i++) {
-                    tracked_face_objects.emplace_back(faces[i].rect, faces[i].confidence, ids[i]);
-                }
-                tracker_reid.Process(prev_frame, tracked_face_objects, work_num_frames);
+                    tracker_action.Process(prev_frame, tracked_action_objects, work_num_frames);
+                    tracked_actions = tracker_action.TrackedDetectionsWithLabels();
 
-                const auto tracked_faces = tracker_reid.TrackedDetectionsWithLabels();
+                    auto ids = face_recognizer->FinishRecognition();
 
-                TrackedObjects tracked_action_objects;
-                for (const auto& action : actions) {
-                    tracked_action_objects.emplace_back(action.rect, action.detection_conf, action.label);
-                }
+                    TrackedObjects tracked_face_objects;
+
+                    for (size_t i = 0; i < faces.size(); i++) {
+                        tracked_face_objects.emplace_back(faces[i].rect, faces[i].confidence, ids[i]);
+                    }
+                    tracker_reid.Process(prev_frame, tracked_face_objects, work_num_frames);
 
-                tracker_action.Process(prev_frame, tracked_action_objects, work_num_frames);
-                const auto tracked_actions = tracker_action.TrackedDetectionsWithLabels();
+                    tracked_faces = tracker_reid.TrackedDetectionsWithLabels();
+                }
 
                 auto elapsed = std::chrono::high_resolution_clock::now() - started;
                 auto elapsed_ms =
@@ -957,7 +907,9 @@ int main(int argc, char* argv[]) {
                         logger.AddPersonToFrame(action.rect, action_label, "");
                         logger.AddDetectionToFrame(action, work_num_frames);
                     }
-                    face_obj_id_to_action_maps.push_back(frame_face_obj_id_to_action);
+                    for (const auto& tup : frame_face_obj_id_to_action) {
+                        face_events_aggregator.AddFrameEvent(tup.first, FrameEvent(work_num_frames, tup.second));
+                    }
                 } else if (teacher_track_id >= 0) {
                     auto res_find = std::find_if(tracked_actions.begin(), tracked_actions.end(),
                                 [teacher_track_id](const TrackedObject& o){ return o.object_id == teacher_track_id; });
@@ -989,6 +941,9 @@ int main(int argc, char* argv[]) {
             slog::info << "Mean FPS: " << 1e3f / mean_time_ms << slog::endl;
         }
         slog::info << "Frames processed: " << total_num_frames << slog::endl;
+        if (vid_writer && vid_writer->getDroppedCount() > 0) {
+            slog::info << "Frames dropped by the video writer: " << vid_writer->getDroppedCount() << slog::endl;
+        }
         if (FLAGS_pc) {
             std::map<std::string, std::string>  mapDevices = getMapFullDevicesNames(ie, devices);
             face_detector->wait();
@@ -1010,34 +965,20 @@ int main(int argc, char* argv[]) {
             std::vector<std::string> face_id_to_label_map = face_recognizer->GetIDToLabelMap();
 
             if (!face_id_to_label_map.empty()) {
-                std::map<int, FrameEventsTrack> face_obj_id_to_actions_track;
-                ConvertActionMapsToFrameEventTracks(face_obj_id_to_action_maps, default_action_index,
-                                                    &face_obj_id_to_actions_track);
-
-                const int start_frame = 0;
-                const int end_frame = face_obj_id_to_action_maps.size();
-                const int smooth_window_size = static_cast<int>(cap->fps() * FLAGS_d_ad);
-                const int smooth_min_length = static_cast<int>(cap->fps() * FLAGS_min_ad);
-                std::map<int, RangeEventsTrack> face_obj_id_to_events;
-                SmoothTracks(face_obj_id_to_actions_track, start_frame, end_frame,
-                             smooth_window_size, smooth_min_length, default_action_index,
-                             &face_obj_id_to_events);
+                face_events_aggregator.Finalize(static_cast<int>(work_num_frames));
+                const std::map<int, RangeEventsTrack>& face_obj_id_to_events = face_events_aggregator.events();
 
                 slog::info << "Final ID->events mapping" << slog::endl;
                 logger.DumpTracks(face_obj_id_to_events,
                                   actions_map, face_track_id_to_label,
                                   face_id_to_label_map);
 
-                std::vector<std::map<int, int>> face_obj_id_to_smoothed_action_maps;
-                ConvertRangeEventsTracksToActionMaps(end_frame, face_obj_id_to_events,
-                                                     &face_obj_id_to_smoothed_action_maps);
-
                 slog::info << "Final per-frame ID->action mapping" << slog::endl;
                 logger.DumpDetections(FLAGS_i, frame.size(), work_num_frames,
                                       new_face_tracks,
                                       face_track_id_to_label,
                                       actions_map, face_id_to_label_map,
-                                      face_obj_id_to_smoothed_action_maps);
+                                      face_obj_id_to_events);
             }
         }
 
@@ -9,6 +9,7 @@
 #include <limits>
 #include <numeric>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <models/nms.h>
 
 using namespace InferenceEngine;
 
@@ -18,12 +19,6 @@ using namespace InferenceEngine;
 #define POSITIVE_DETECTION_IDX 1
 #define INVALID_TOP_K_IDX -1
 
-template <typename T>
-bool SortScorePairDescend(const std::pair<float, T>& pair1,
-                          const std::pair<float, T>& pair2) {
-    return pair1.first > pair2.first;
-}
-
 void ActionDetection::submitRequest() {
     if (!enqueued_frames_) return;
     enqueued_frames_ = 0;
@@ -46,7 +41,10 @@ void ActionDetection::enqueue(const cv::Mat &frame) {
 }
 
 ActionDetection::ActionDetection(const ActionDetectorConfig& config)
-        : BaseCnnDetection(config.is_async), config_(config) {
+        : BaseCnnDetection(config.is_async), config_(config),
+          nms_(NonMaxSuppression::Method::SoftGaussian, 0.f, false, config.detection_confidence_threshold,
+               config.keep_top_k > INVALID_TOP_K_IDX ? static_cast<size_t>(config.keep_top_k) : 0,
+               config.nms_sigma) {
     topoName = "action detector";
     auto network = config.ie.ReadNetwork(config.path_to_model);
 
@@ -117,6 +115,31 @@ ActionDetection::ActionDetection(const ActionDetectorConfig& config)
     num_candidates_ = head_shift;
 
     binary_task_ = config_.num_action_classes == 2;
+
+    /** Locate the action confidences and generate the prior boxes of every candidate once **/
+    candidates_info_.reserve(num_candidates_);
+    if (new_network_) {
+        prior_boxes_.reserve(num_candidates_);
+    }
+    for (int head_id = 0; head_id < num_heads; ++head_id) {
+        const int head_num_anchors = head_anchors[head_id];
+        for (int head_p = 0; head_p < head_ranges_[head_id + 1] - head_ranges_[head_id]; ++head_p) {
+            const int anchor_id = head_p % head_num_anchors;
+            const int pos = head_p / head_num_anchors;
+
+            CandidateInfo info;
+            info.glob_anchor_id = glob_anchor_map_[head_id][anchor_id];
+            info.action_conf_idx_shift = new_network_ ? pos : pos * config_.num_action_classes;
+            info.action_conf_step = head_step_sizes_[head_id];
+            candidates_info_.push_back(info);
+
+            if (new_network_) {
+                prior_boxes_.push_back(GeneratePriorBox(pos, config_.new_det_heads[head_id].step,
+                                                        config_.new_det_heads[head_id].anchors[anchor_id],
+                                                        head_blob_sizes_[head_id]));
+            }
+        }
+    }
 }
 
 std::vector<int> ieSizeToVector(const SizeVector& ie_output_dims) {
@@ -226,7 +249,7 @@ cv::Rect ActionDetection::ConvertToRect(
 
 DetectedActions ActionDetection::GetDetections(const cv::Mat& loc, const cv::Mat& main_conf,
         const cv::Mat& priorboxes, const std::vector<cv::Mat>& add_conf,
-        const cv::Size& frame_size) const {
+        const cv::Size& frame_size) {
     /** Prepare input data buffers **/
     const float* loc_data = reinterpret_cast<float*>(loc.data);
     const float* det_conf_data = reinterpret_cast<float*>(main_conf.data);
@@ -238,46 +261,40 @@ DetectedActions ActionDetection::GetDetections(const cv::Mat& loc, const cv::Mat
         action_conf_data[i] = reinterpret_cast<float*>(add_conf[i].data);
     }
 
-    /** Variable to store all detection candidates**/
-    DetectedActions valid_detections;
-
-    /** Iterate over all candidate bboxes**/
+    /** Select the confident candidates, the scan over all of them has no branches **/
+    const float det_threshold = config_.detection_confidence_threshold;
+    confident_candidates_.resize(num_candidates_);
+    int num_confident = 0;
     for (int p = 0; p < num_candidates_; ++p) {
-        /** Parse detection confidence from the SSD Detection output **/
-        const float detection_conf =
-                det_conf_data[p * NUM_DETECTION_CLASSES + POSITIVE_DETECTION_IDX];
-
-        /** Skip low-confidence detections **/
-        if (detection_conf < config_.detection_confidence_threshold) {
-            continue;
-        }
-
-        /** Estimate the action head ID **/
-        int head_id = 0;
-        while (p >= head_ranges_[head_id + 1]) {
-            ++head_id;
-        }
-        const int head_p = p - head_ranges_[head_id];
+        confident_candidates_[num_confident] = p;
+        num_confident += det_conf_data[p * NUM_DETECTION_CLASSES + POSITIVE_DETECTION_IDX] >= det_threshold;
+    }
+    confident_candidates_.resize(num_confident);
+
+    /** Soft-NMS considers only top-k highest scored bboxes, so the rest aren't decoded **/
+    if (config_.keep_top_k > INVALID_TOP_K_IDX && num_confident > config_.keep_top_k) {
+        std::nth_element(confident_candidates_.begin(), confident_candidates_.begin() + config_.keep_top_k,
+                         confident_candidates_.end(), [det_conf_data](int p1, int p2) {
+                             return det_conf_data[p1 * NUM_DETECTION_CLASSES + POSITIVE_DETECTION_IDX] >
+                                    det_conf_data[p2 * NUM_DETECTION_CLASSES + POSITIVE_DETECTION_IDX];
+                         });
+        confident_candidates_.resize(config_.keep_top_k);
+    }
 
-        /** Estimate the action anchor ID **/
-        const int head_num_anchors =
-            new_network_ ? config_.new_anchors[head_id] : config_.old_anchors[head_id];
-        const int anchor_id = head_p % head_num_anchors;
+    /** Decode the selected candidates **/
+    const float scale = new_network_ ? config_.new_action_scale : config_.old_action_scale;
+    valid_detections_.clear();
+    for (int p : confident_candidates_) {
+        const float detection_conf = det_conf_data[p * NUM_DETECTION_CLASSES + POSITIVE_DETECTION_IDX];
 
         /** Estimate the action label **/
-        const int glob_anchor_id = glob_anchor_map_[head_id][anchor_id];
-        const float* anchor_conf_data = action_conf_data[glob_anchor_id];
-        const int action_conf_idx_shift = new_network_
-                                            ? head_p / head_num_anchors
-                                            : head_p / head_num_anchors * config_.num_action_classes;
-        const int action_conf_step = head_step_sizes_[head_id];
-        const float scale = new_network_ ? config_.new_action_scale : config_.old_action_scale;
+        const CandidateInfo& info = candidates_info_[p];
+        const float* anchor_conf_data = action_conf_data[info.glob_anchor_id] + info.action_conf_idx_shift;
         int action_label = -1;
         float action_max_exp_value = 0.f;
         float action_sum_exp_values = 0.f;
         for (size_t c = 0; c < config_.num_action_classes; ++c) {
-            float action_exp_value =
-                std::exp(scale * anchor_conf_data[action_conf_idx_shift + c * action_conf_step]);
+            float action_exp_value = std::exp(scale * anchor_conf_data[c * info.action_conf_step]);
             action_sum_exp_values += action_exp_value;
             if (action_exp_value > action_max_exp_value && ((c > 0 && binary_task_) || !binary_task_)) {
                 action_max_exp_value = action_exp_value;
@@ -299,10 +316,7 @@ DetectedActions ActionDetection::GetDetections(const cv::Mat& loc, const cv::Mat
 
         /** Parse bbox from the SSD Detection output **/
         const auto priorbox = new_network_
-                                ? GeneratePriorBox(head_p / head_num_anchors,
-                                                   config_.new_det_heads[head_id].step,
-                                                   config_.new_det_heads[head_id].anchors[anchor_id],
-                                                   head_blob_sizes_[head_id])
+                                ? prior_boxes_[p]
                                 : ParseBBoxRecord(prior_data + p * SSD_PRIORBOX_RECORD_SIZE, false);
         const auto variance =
                 ParseBBoxRecord(new_network_
@@ -315,83 +329,26 @@ DetectedActions ActionDetection::GetDetections(const cv::Mat& loc, const cv::Mat
         const auto det_rect = ConvertToRect(priorbox, variance, encoded_bbox, frame_size);
 
         /** Store detected action **/
-        valid_detections.emplace_back(det_rect, action_label, detection_conf, action_conf);
+        valid_detections_.emplace_back(det_rect, action_label, detection_conf, action_conf);
     }
 
     /** Merge most overlapped detections **/
-    std::vector<int> out_det_indices;
-    SoftNonMaxSuppression(valid_detections, config_.nms_sigma, config_.keep_top_k,
-                          config_.detection_confidence_threshold,
-                          &out_det_indices);
+    const auto& out_det_indices = SoftNonMaxSuppression(valid_detections_);
 
     DetectedActions detections;
-    for (size_t i = 0; i < out_det_indices.size(); ++i) {
-        detections.emplace_back(valid_detections[out_det_indices[i]]);
+    detections.reserve(out_det_indices.size());
+    for (size_t idx : out_det_indices) {
+        detections.emplace_back(valid_detections_[idx]);
     }
     return detections;
 }
 
-void ActionDetection::SoftNonMaxSuppression(const DetectedActions& detections,
-        const float sigma, const int top_k, const float min_det_conf,
-        std::vector<int>* out_indices) const {
-    /** Store input bbox scores **/
-    std::vector<float> scores(detections.size());
-    for (size_t i = 0; i < detections.size(); ++i) {
-        scores[i] = detections[i].detection_conf;
-    }
-
-    /** Estimate maximum number of algorithm iterations **/
-    size_t max_queue_size = top_k > INVALID_TOP_K_IDX
-                               ? std::min(static_cast<size_t>(top_k), scores.size())
-                               : scores.size();
-
-    /** Select top-k score indices **/
-    std::vector<size_t> score_idx(scores.size());
-    std::iota(score_idx.begin(), score_idx.end(), 0);
-    std::partial_sort(score_idx.begin(), score_idx.begin() + max_queue_size, score_idx.end(),
-        [&scores](size_t i1, size_t i2) {return scores[i1] > scores[i2];});
-
-    /** Extract top-k score values **/
-    std::vector<size_t> valid_score_idx(score_idx.begin(), score_idx.begin() + max_queue_size);
-    std::vector<float> valid_scores(max_queue_size);
-    for (size_t i = 0; i < valid_score_idx.size(); ++i) {
-        valid_scores[i] = scores[valid_score_idx[i]];
-    }
-
+const std::vector<size_t>& ActionDetection::SoftNonMaxSuppression(const DetectedActions& detections) {
     /** Carry out Soft Non-Maximum Suppression algorithm **/
-    out_indices->clear();
-    for (size_t step = 0; step < valid_scores.size(); ++step) {
-        auto best_score_itr = std::max_element(valid_scores.begin(), valid_scores.end());
-        if (*best_score_itr < min_det_conf) {
-            break;
-        }
-
-        /** Add current bbox to output list **/
-        const size_t local_anchor_idx = std::distance(valid_scores.begin(), best_score_itr);
-        const int anchor_idx = valid_score_idx[local_anchor_idx];
-        out_indices->emplace_back(anchor_idx);
-        *best_score_itr = 0.f;
-
-        /** Update valid_scores of the rest bboxes **/
-        for (size_t local_reference_idx = 0; local_reference_idx < valid_scores.size(); ++local_reference_idx) {
-            /** Skip updating step for the low-confidence bbox **/
-            if (valid_scores[local_reference_idx] < min_det_conf) {
-                continue;
-            }
-
-            /** Calculate the Intersection over Union metric between two bboxes**/
-            const size_t reference_idx = valid_score_idx[local_reference_idx];
-            const auto& rect1 = detections[anchor_idx].rect;
-            const auto& rect2 = detections[reference_idx].rect;
-            const auto intersection = rect1 & rect2;
-            float overlap = 0.f;
-            if (intersection.width > 0 && intersection.height > 0) {
-                const int intersection_area = intersection.area();
-                overlap = static_cast<float>(intersection_area) / static_cast<float>(rect1.area() + rect2.area() - intersection_area);
-            }
-
-            /** Scale bbox score using the exponential rule **/
-            valid_scores[local_reference_idx] *= std::exp(-overlap * overlap / sigma);
-        }
+    nms_.clear();
+    nms_.reserve(detections.size());
+    for (const auto& detection : detections) {
+        nms_.add(detection.rect, detection.detection_conf);
     }
+    return nms_.apply();
 }
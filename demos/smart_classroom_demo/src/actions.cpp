@@ -0,0 +1,81 @@
+// Copyright (C) 2018-2020 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "actions.hpp"
+
+RangeEventsAggregator::RangeEventsAggregator(int start_frame, int window_size, int min_length,
+                                             Action default_action)
+    : start_frame_(start_frame), window_size_(window_size), min_length_(min_length),
+      default_action_(default_action) {}
+
+void RangeEventsAggregator::AddFrameEvent(int obj_id, const FrameEvent& frame_event) {
+    if (frame_event.action == default_action_) {
+        return;
+    }
+
+    auto& state = states_[obj_id];
+    if (state.has_open &&
+        state.open.end_frame_id + window_size_ - 1 >= frame_event.frame_id &&
+        state.open.action == frame_event.action) {
+        state.open.end_frame_id = frame_event.frame_id + 1;
+        return;
+    }
+
+    CloseOpenEvent(obj_id, state);
+    state.open = RangeEvent(frame_event.frame_id, frame_event.frame_id + 1, frame_event.action);
+    state.has_open = true;
+}
+
+void RangeEventsAggregator::CloseOpenEvent(int obj_id, TrackState& state) {
+    if (!state.has_open) {
+        return;
+    }
+    state.has_open = false;
+    if (state.open.end_frame_id - state.open.begin_frame_id < min_length_) {
+        return;
+    }
+
+    RangeEvent event = state.open;
+    if (!state.has_kept) {
+        // Extrapolate track
+        event.begin_frame_id = start_frame_;
+    } else {
+        // Interpolate track
+        int middle_point = static_cast<int>(0.5f * (event.begin_frame_id + state.kept.end_frame_id));
+        state.kept.end_frame_id = middle_point;
+        event.begin_frame_id = middle_point;
+        AddMergedEvent(obj_id, state, state.kept);
+    }
+    state.kept = event;
+    state.has_kept = true;
+}
+
+void RangeEventsAggregator::AddMergedEvent(int obj_id, TrackState& state, const RangeEvent& event) {
+    if (state.has_merged && state.merged.action == event.action) {
+        state.merged.end_frame_id = event.end_frame_id;
+        return;
+    }
+    if (state.has_merged) {
+        obj_id_to_events_[obj_id].push_back(state.merged);
+    }
+    state.merged = event;
+    state.has_merged = true;
+}
+
+void RangeEventsAggregator::Finalize(int end_frame) {
+    for (auto& tup : states_) {
+        const int obj_id = tup.first;
+        auto& state = tup.second;
+
+        CloseOpenEvent(obj_id, state);
+        if (state.has_kept) {
+            state.kept.end_frame_id = end_frame;
+            AddMergedEvent(obj_id, state, state.kept);
+            obj_id_to_events_[obj_id].push_back(state.merged);
+        } else {
+            obj_id_to_events_[obj_id].emplace_back(start_frame_, end_frame, default_action_);
+        }
+    }
+    states_.clear();
+}
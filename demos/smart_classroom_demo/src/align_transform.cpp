@@ -48,25 +48,52 @@ cv::Mat GetTransform(cv::Mat* src, cv::Mat* dst) {
     return m;
 }
 
+namespace {
+// Returns the transform from the aligned face of the given size to the face image
+cv::Mat GetAlignmentTransform(const cv::Mat& face_image, cv::Mat landmarks, const cv::Size& aligned_size) {
+    cv::Mat ref_landmarks = cv::Mat(5, 2, CV_32F);
+    for (int i = 0; i < ref_landmarks.rows; i++) {
+        ref_landmarks.at<float>(i, 0) = ref_landmarks_normalized[2 * i] * aligned_size.width;
+        ref_landmarks.at<float>(i, 1) = ref_landmarks_normalized[2 * i + 1] * aligned_size.height;
+        landmarks.at<float>(i, 0) *= face_image.cols;
+        landmarks.at<float>(i, 1) *= face_image.rows;
+    }
+    return GetTransform(&ref_landmarks, &landmarks);
+}
+}  // namespace
+
 void AlignFaces(std::vector<cv::Mat>* face_images,
                 std::vector<cv::Mat>* landmarks_vec) {
     if (landmarks_vec->size() == 0) {
         return;
     }
     CV_Assert(face_images->size() == landmarks_vec->size());
-    cv::Mat ref_landmarks = cv::Mat(5, 2, CV_32F);
 
-    for (size_t j = 0; j < face_images->size(); j++) {
-        for (int i = 0; i < ref_landmarks.rows; i++) {
-            ref_landmarks.at<float>(i, 0) =
-                    ref_landmarks_normalized[2 * i] * face_images->at(j).cols;
-            ref_landmarks.at<float>(i, 1) =
-                    ref_landmarks_normalized[2 * i + 1] * face_images->at(j).rows;
-            landmarks_vec->at(j).at<float>(i, 0) *= face_images->at(j).cols;
-            landmarks_vec->at(j).at<float>(i, 1) *= face_images->at(j).rows;
+    cv::parallel_for_(cv::Range(0, static_cast<int>(face_images->size())), [&](const cv::Range& range) {
+        for (int j = range.start; j < range.end; j++) {
+            cv::Mat& face_image = face_images->at(j);
+            cv::Mat m = GetAlignmentTransform(face_image, landmarks_vec->at(j).clone(), face_image.size());
+            cv::warpAffine(face_image, face_image, m, face_image.size(), cv::WARP_INVERSE_MAP);
         }
-        cv::Mat m = GetTransform(&ref_landmarks, &landmarks_vec->at(j));
-        cv::warpAffine(face_images->at(j), face_images->at(j), m,
-                       face_images->at(j).size(), cv::WARP_INVERSE_MAP);
+    });
+}
+
+void AlignFaceToBlob(const cv::Mat& face_image, const cv::Mat& landmarks,
+                     InferenceEngine::Blob::Ptr& blob, size_t batch_index) {
+    const InferenceEngine::SizeVector dims = blob->getTensorDesc().getDims();
+    CV_Assert(dims.size() == 4 && dims[1] == 3 && face_image.type() == CV_8UC3);
+    const cv::Size blob_size(static_cast<int>(dims[3]), static_cast<int>(dims[2]));
+
+    // The face is aligned and resized to the blob size by a single warp
+    cv::Mat m = GetAlignmentTransform(face_image, landmarks.clone(), blob_size);
+    cv::Mat aligned;
+    cv::warpAffine(face_image, aligned, m, blob_size, cv::WARP_INVERSE_MAP);
+
+    InferenceEngine::LockedMemory<void> blob_mapped = InferenceEngine::as<InferenceEngine::MemoryBlob>(blob)->wmap();
+    uint8_t* data = blob_mapped.as<uint8_t*>() + batch_index * 3 * blob_size.area();
+    cv::Mat planes[3];
+    for (int c = 0; c < 3; c++) {
+        planes[c] = cv::Mat(blob_size, CV_8UC1, data + c * blob_size.area());
     }
+    cv::split(aligned, planes);
 }
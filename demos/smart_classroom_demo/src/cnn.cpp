@@ -4,6 +4,7 @@
 
 #include "cnn.hpp"
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -40,37 +41,65 @@ void CnnDLSDKBase::Load() {
     }
 
     executable_network_ = config_.ie.LoadNetwork(cnnNetwork, config_.deviceName);
-    infer_request_ = executable_network_.CreateInferRequest();
+    infer_requests_.push_back(executable_network_.CreateInferRequest());
 }
 
 void CnnDLSDKBase::InferBatch(
         const std::vector<cv::Mat>& frames,
         const std::function<void(const InferenceEngine::BlobMap&, size_t)>& fetch_results) const {
-    Blob::Ptr input = infer_request_.GetBlob(input_blob_name_);
-    const size_t batch_size = input->getTensorDesc().getDims()[0];
-
-    size_t num_imgs = frames.size();
-    for (size_t batch_i = 0; batch_i < num_imgs; batch_i += batch_size) {
-        const size_t current_batch_size = std::min(batch_size, num_imgs - batch_i);
-        for (size_t b = 0; b < current_batch_size; b++) {
-            matU8ToBlob<uint8_t>(frames[batch_i + b], input, b);
+    StartBatches(frames.size(), [&frames](Blob::Ptr& input, size_t batch_index, size_t frame_index) {
+        matU8ToBlob<uint8_t>(frames[frame_index], input, static_cast<int>(batch_index));
+    });
+    WaitBatches(fetch_results);
+}
+
+void CnnDLSDKBase::StartBatches(
+        size_t num_inputs,
+        const std::function<void(InferenceEngine::Blob::Ptr&, size_t, size_t)>& fill_input) const {
+    CV_Assert(started_batch_sizes_.empty());
+    const size_t batch_size = infer_requests_.front().GetBlob(input_blob_name_)->getTensorDesc().getDims()[0];
+
+    for (size_t batch_i = 0; batch_i < num_inputs; batch_i += batch_size) {
+        const size_t current_batch_size = std::min(batch_size, num_inputs - batch_i);
+        const size_t request_i = started_batch_sizes_.size();
+        if (request_i == infer_requests_.size()) {
+            infer_requests_.push_back(executable_network_.CreateInferRequest());
         }
+        InferRequest& request = infer_requests_[request_i];
+        Blob::Ptr input = request.GetBlob(input_blob_name_);
+        cv::parallel_for_(cv::Range(0, static_cast<int>(current_batch_size)), [&](const cv::Range& range) {
+            for (int b = range.start; b < range.end; b++) {
+                fill_input(input, b, batch_i + b);
+            }
+        });
 
         if (config_.max_batch_size != 1)
-            infer_request_.SetBatch(current_batch_size);
-        infer_request_.Infer();
+            request.SetBatch(current_batch_size);
+        request.StartAsync();
+        started_batch_sizes_.push_back(current_batch_size);
+    }
+}
 
+void CnnDLSDKBase::WaitBatches(
+        const std::function<void(const InferenceEngine::BlobMap&, size_t)>& fetch_results) const {
+    // The batches are waited for even if fetching fails, so the requests can be started again
+    std::vector<size_t> batch_sizes;
+    batch_sizes.swap(started_batch_sizes_);
+    for (size_t request_i = 0; request_i < batch_sizes.size(); request_i++) {
+        infer_requests_[request_i].Wait(IInferRequest::WaitMode::RESULT_READY);
+    }
+    for (size_t request_i = 0; request_i < batch_sizes.size(); request_i++) {
         InferenceEngine::BlobMap blobs;
         for (const auto& name : output_blobs_names_)  {
-            blobs[name] = infer_request_.GetBlob(name);
+            blobs[name] = infer_requests_[request_i].GetBlob(name);
         }
-        fetch_results(blobs, current_batch_size);
+        fetch_results(blobs, batch_sizes[request_i]);
     }
 }
 
 void CnnDLSDKBase::PrintPerformanceCounts(std::string fullDeviceName) const {
     std::cout << "Performance counts for " << config_.path_to_model << std::endl << std::endl;
-    ::printPerformanceCounts(infer_request_, std::cout, fullDeviceName, false);
+    ::printPerformanceCounts(infer_requests_.front(), std::cout, fullDeviceName, false);
 }
 
 void CnnDLSDKBase::Infer(const cv::Mat& frame,
@@ -78,28 +107,10 @@ void CnnDLSDKBase::Infer(const cv::Mat& frame,
     InferBatch({frame}, fetch_results);
 }
 
-VectorCNN::VectorCNN(const Config& config)
-        : CnnDLSDKBase(config) {
-    Load();
-    if (output_blobs_names_.size() != 1) {
-        THROW_IE_EXCEPTION << "Demo supports topologies only with 1 output";
-    }
-}
-
-void VectorCNN::Compute(const cv::Mat& frame,
-                                     cv::Mat* vector, cv::Size outp_shape) const {
-    std::vector<cv::Mat> output;
-    Compute({frame}, &output, outp_shape);
-    *vector = output[0];
-}
-
-void VectorCNN::Compute(const std::vector<cv::Mat>& images, std::vector<cv::Mat>* vectors,
-                                     cv::Size outp_shape) const {
-    if (images.empty()) {
-        return;
-    }
-    vectors->clear();
-    auto results_fetcher = [vectors, outp_shape](const InferenceEngine::BlobMap& outputs, size_t batch_size) {
+namespace {
+std::function<void(const InferenceEngine::BlobMap&, size_t)> VectorsFetcher(std::vector<cv::Mat>* vectors,
+                                                                             cv::Size outp_shape) {
+    return [vectors, outp_shape](const InferenceEngine::BlobMap& outputs, size_t batch_size) {
         for (auto&& item : outputs) {
             InferenceEngine::Blob::Ptr blob = item.second;
             if (blob == nullptr) {
@@ -122,5 +133,40 @@ void VectorCNN::Compute(const std::vector<cv::Mat>& images, std::vector<cv::Mat>
             }
         }
     };
-    InferBatch(images, results_fetcher);
+}
+}  // namespace
+
+VectorCNN::VectorCNN(const Config& config)
+        : CnnDLSDKBase(config) {
+    Load();
+    if (output_blobs_names_.size() != 1) {
+        THROW_IE_EXCEPTION << "Demo supports topologies only with 1 output";
+    }
+}
+
+void VectorCNN::Compute(const cv::Mat& frame,
+                                     cv::Mat* vector, cv::Size outp_shape) const {
+    std::vector<cv::Mat> output;
+    Compute({frame}, &output, outp_shape);
+    *vector = output[0];
+}
+
+void VectorCNN::Compute(const std::vector<cv::Mat>& images, std::vector<cv::Mat>* vectors,
+                                     cv::Size outp_shape) const {
+    if (images.empty()) {
+        return;
+    }
+    vectors->clear();
+    InferBatch(images, VectorsFetcher(vectors, outp_shape));
+}
+
+void VectorCNN::StartCompute(
+        size_t num_inputs,
+        const std::function<void(InferenceEngine::Blob::Ptr&, size_t, size_t)>& input_filler) const {
+    StartBatches(num_inputs, input_filler);
+}
+
+void VectorCNN::WaitCompute(std::vector<cv::Mat>* vectors, cv::Size outp_shape) const {
+    vectors->clear();
+    WaitBatches(VectorsFetcher(vectors, outp_shape));
 }
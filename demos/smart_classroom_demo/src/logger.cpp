@@ -2,11 +2,14 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <algorithm>
 #include <string>
 #include <map>
 #include <set>
 #include <vector>
 #include <fstream>
+#include <cstdint>
+#include <utility>
 
 #include "logger.hpp"
 
@@ -14,6 +17,13 @@ namespace {
 
 const char unknown_label[] = "Unknown";
 
+// Number of frame records, the frame loop waits for the writer thread when all of them are filled
+const size_t max_queued_frames = 64;
+
+// .bin action detections log is this magic followed by records of native endianness:
+// int32 frame_id, float32 det_conf, int32 label, int32 x, y, width, height
+const char act_det_bin_magic[] = "SCRDET01";
+
 std::string GetUnknownOrLabel(const std::vector<std::string>& labels, int idx)  {
     return idx >= 0 ? labels.at(idx) : unknown_label;
 }
@@ -23,62 +33,207 @@ std::string FrameIdxToString(const std::string& path, int frame_idx) {
     ss << std::setw(6) << std::setfill('0') << frame_idx;
     return path.substr(path.rfind("/") + 1) + "@" + ss.str();
 }
+
+const RangeEvent* FindRangeEvent(const std::map<int, RangeEventsTrack>& obj_id_to_events, int obj_id, int frame_idx) {
+    auto events_it = obj_id_to_events.find(obj_id);
+    if (events_it == obj_id_to_events.end()) {
+        return nullptr;
+    }
+    const auto& events = events_it->second;
+    auto event_it = std::upper_bound(events.begin(), events.end(), frame_idx,
+        [](int frame_idx, const RangeEvent& event) { return frame_idx < event.begin_frame_id; });
+    if (event_it == events.begin()) {
+        return nullptr;
+    }
+    --event_it;
+    return frame_idx < event_it->end_frame_id ? &*event_it : nullptr;
+}
+
+bool HasExtension(const std::string& path, const std::string& ext) {
+    return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+template <typename T>
+void WriteBinary(std::ostream& stream, T value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
 }  // anonymous namespace
 
+struct DetectionsLogger::FrameRecord {
+    struct Object {
+        bool is_face;
+        cv::Rect rect;
+        std::string id;
+        std::string action;
+    };
+
+    bool has_header = false;
+    bool is_finalized = false;
+    std::string path;
+    int frame_idx = 0;
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<Object> objects;
+    std::vector<std::pair<int, TrackedObject>> detections;
+
+    bool empty() const {
+        return !has_header && !is_finalized && objects.empty() && detections.empty();
+    }
+
+    void clear() {
+        has_header = false;
+        is_finalized = false;
+        objects.clear();
+        detections.clear();
+    }
+};
+
 DetectionsLogger::DetectionsLogger(std::ostream& stream, bool enabled,
                                    const std::string& act_stat_log_file,
                                    const std::string& act_det_log_file)
-    : log_stream_(stream) {
+    : log_stream_(stream),
+      filled_records_(max_queued_frames),
+      free_records_(max_queued_frames),
+      pending_records_(0),
+      stop_(false) {
     write_logs_ = enabled;
     act_stat_log_stream_.open(act_stat_log_file, std::fstream::out);
 
-    if (!act_det_log_file.empty()) {
+    if (HasExtension(act_det_log_file, ".bin")) {
+        act_det_bin_stream_.open(act_det_log_file, std::ios::binary | std::ios::trunc);
+        act_det_bin_stream_.write(act_det_bin_magic, sizeof(act_det_bin_magic) - 1);
+    } else if (!act_det_log_file.empty()) {
         act_det_log_stream_.open(act_det_log_file, cv::FileStorage::WRITE);
 
         act_det_log_stream_ << "data" << "[";
     }
+
+    for (size_t i = 0; i < max_queued_frames; i++) {
+        records_.emplace_back(new FrameRecord);
+        free_records_.tryPush(records_.back().get());
+    }
+    free_records_.tryPop(current_record_);
+    writer_thread_ = std::thread(&DetectionsLogger::WriterLoop, this);
 }
 
 void DetectionsLogger::CreateNextFrameRecord(const std::string& path, const int frame_idx,
                                              const size_t width, const size_t height) {
-    if (write_logs_)
-        log_stream_ << "Frame_name: " << path << "@" << frame_idx << " width: "
-                    << width << " height: " << height << std::endl;
+    if (write_logs_) {
+        current_record_->has_header = true;
+        current_record_->path = path;
+        current_record_->frame_idx = frame_idx;
+        current_record_->width = width;
+        current_record_->height = height;
+    }
 }
 
 void DetectionsLogger::AddFaceToFrame(const cv::Rect& rect, const std::string& id, const std::string& action) {
     if (write_logs_) {
-        log_stream_ << "Object type: face. Box: " << rect << " id: " << id;
-        if (!action.empty()) {
-            log_stream_ << " action: " << action;
-        }
-        log_stream_ << std::endl;
+        current_record_->objects.push_back({true, rect, id, action});
     }
 }
 
 void DetectionsLogger::AddPersonToFrame(const cv::Rect& rect, const std::string& action, const std::string& id) {
     if (write_logs_) {
-        log_stream_ << "Object type: person. Box: " << rect << " action: " << action;
-        if (!id.empty()) {
-            log_stream_ << " id: " << id;
-        }
-        log_stream_ << std::endl;
+        current_record_->objects.push_back({false, rect, id, action});
     }
 }
 
 void DetectionsLogger::AddDetectionToFrame(const TrackedObject& object, const int frame_idx) {
-    if (act_det_log_stream_.isOpened()) {
-        act_det_log_stream_ << "{" << "frame_id" << frame_idx
-                            << "det_conf" << object.confidence
-                            << "label" << object.label
-                            << "rect" << object.rect << "}";
+    if (act_det_log_stream_.isOpened() || act_det_bin_stream_.is_open()) {
+        current_record_->detections.emplace_back(frame_idx, object);
     }
 }
 
 void DetectionsLogger::FinalizeFrameRecord() {
-    if (write_logs_) {
-        log_stream_ << std::endl;
+    current_record_->is_finalized = write_logs_;
+    if (current_record_->empty()) {
+        return;
     }
+
+    pending_records_++;
+    filled_records_.tryPush(current_record_);  // there are as many cells as records, so it never fails
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.notify_all();
+    cond_var_.wait(lock, [&] { return free_records_.tryPop(current_record_); });
+}
+
+void DetectionsLogger::WriteRecord(const FrameRecord& record, std::string& text) {
+    if (record.has_header) {
+        text += "Frame_name: " + record.path + "@" + std::to_string(record.frame_idx)
+            + " width: " + std::to_string(record.width) + " height: " + std::to_string(record.height) + "\n";
+    }
+    for (const auto& object : record.objects) {
+        std::ostringstream rect;
+        rect << object.rect;
+        if (object.is_face) {
+            text += "Object type: face. Box: " + rect.str() + " id: " + object.id;
+            if (!object.action.empty()) {
+                text += " action: " + object.action;
+            }
+        } else {
+            text += "Object type: person. Box: " + rect.str() + " action: " + object.action;
+            if (!object.id.empty()) {
+                text += " id: " + object.id;
+            }
+        }
+        text += "\n";
+    }
+    if (record.is_finalized) {
+        text += "\n";
+    }
+
+    for (const auto& detection : record.detections) {
+        const TrackedObject& object = detection.second;
+        if (act_det_bin_stream_.is_open()) {
+            WriteBinary<int32_t>(act_det_bin_stream_, detection.first);
+            WriteBinary<float>(act_det_bin_stream_, object.confidence);
+            WriteBinary<int32_t>(act_det_bin_stream_, object.label);
+            WriteBinary<int32_t>(act_det_bin_stream_, object.rect.x);
+            WriteBinary<int32_t>(act_det_bin_stream_, object.rect.y);
+            WriteBinary<int32_t>(act_det_bin_stream_, object.rect.width);
+            WriteBinary<int32_t>(act_det_bin_stream_, object.rect.height);
+        } else {
+            act_det_log_stream_ << "{" << "frame_id" << detection.first
+                                << "det_conf" << object.confidence
+                                << "label" << object.label
+                                << "rect" << object.rect << "}";
+        }
+    }
+}
+
+void DetectionsLogger::WriterLoop() {
+    std::string text;
+    for (;;) {
+        FrameRecord* record;
+        size_t written = 0;
+        text.clear();
+        while (filled_records_.tryPop(record)) {
+            WriteRecord(*record, text);
+            record->clear();
+            free_records_.tryPush(record);
+            written++;
+        }
+        if (!text.empty()) {
+            log_stream_ << text;
+            log_stream_.flush();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (written > 0) {
+            pending_records_ -= written;
+            cond_var_.notify_all();
+        }
+        if (stop_ && pending_records_ == 0) {
+            return;
+        }
+        cond_var_.wait(lock, [&] { return stop_ || filled_records_.sizeApprox() > 0; });
+    }
+}
+
+void DetectionsLogger::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.wait(lock, [&] { return pending_records_ == 0; });
 }
 
 void DetectionsLogger::DumpDetections(const std::string& video_path,
@@ -88,7 +243,7 @@ void DetectionsLogger::DumpDetections(const std::string& video_path,
                                       const std::map<int, int>& track_id_to_label_faces,
                                       const std::vector<std::string>& action_idx_to_label,
                                       const std::vector<std::string>& person_id_to_label,
-                                      const std::vector<std::map<int, int>>& frame_face_obj_id_to_action_maps)  {
+                                      const std::map<int, RangeEventsTrack>& obj_id_to_events)  {
     std::map<int, std::vector<const TrackedObject*>> frame_idx_to_face_track_objs;
 
     for (const auto& tr : face_tracks) {
@@ -109,7 +264,6 @@ void DetectionsLogger::DumpDetections(const std::string& video_path,
 
     for (size_t i = 0; i < num_frames; i++)  {
         CreateNextFrameRecord(video_path, i, frame_size.width, frame_size.height);
-        const auto& frame_face_obj_id_to_action = frame_face_obj_id_to_action_maps.at(i);
         for (auto& kv : face_label_to_action) {
             kv.second = unknown_label;
         }
@@ -117,8 +271,9 @@ void DetectionsLogger::DumpDetections(const std::string& video_path,
         for (const auto& p_obj : frame_idx_to_face_track_objs[i]) {
             const auto& obj = *p_obj;
             std::string action_label = unknown_label;
-            if (frame_face_obj_id_to_action.count(obj.object_id) > 0) {
-                action_label = GetUnknownOrLabel(action_idx_to_label, frame_face_obj_id_to_action.at(obj.object_id));
+            const RangeEvent* event = FindRangeEvent(obj_id_to_events, obj.object_id, static_cast<int>(i));
+            if (event) {
+                action_label = GetUnknownOrLabel(action_idx_to_label, event->action);
             }
             std::string face_label = GetUnknownOrLabel(person_id_to_label, track_id_to_label_faces.at(obj.object_id));
             face_label_to_action[face_label] = action_label;
@@ -139,6 +294,7 @@ void DetectionsLogger::DumpTracks(const std::map<int, RangeEventsTrack>& obj_id_
                                   const std::vector<std::string>& action_idx_to_label,
                                   const std::map<int, int>& track_id_to_label_faces,
                                   const std::vector<std::string>& person_id_to_label) {
+    Flush();
     for (const auto& tup : obj_id_to_events) {
         const int obj_id = tup.first;
         if (track_id_to_label_faces.count(obj_id) > 0) {
@@ -159,6 +315,18 @@ void DetectionsLogger::DumpTracks(const std::map<int, RangeEventsTrack>& obj_id_
 }
 
 DetectionsLogger::~DetectionsLogger() {
+    if (!current_record_->empty()) {
+        // the frame loop has been interrupted before the record was finalized
+        pending_records_++;
+        filled_records_.tryPush(current_record_);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_var_.notify_all();
+    writer_thread_.join();
+
     if (act_det_log_stream_.isOpened()) {
         act_det_log_stream_ << "]";
     }
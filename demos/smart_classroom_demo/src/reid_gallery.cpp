@@ -5,21 +5,39 @@
 #include "face_reid.hpp"
 #include "tracker.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <vector>
 #include <string>
 #include <limits>
 
 #include <opencv2/opencv.hpp>
 
+#include <samples/slog.hpp>
+
 namespace {
-    float ComputeReidDistance(const cv::Mat& descr1, const cv::Mat& descr2) {
-        float xy = static_cast<float>(descr1.dot(descr2));
-        float xx = static_cast<float>(descr1.dot(descr1));
-        float yy = static_cast<float>(descr2.dot(descr2));
-        float norm = sqrt(xx * yy) + 1e-6f;
-        return 1.0f - xy / norm;
+    // Packs the embeddings into CV_32F rows of unit length, so their dot products are the cosine similarities.
+    // A zero embedding stays zero and is dissimilar to any other one
+    cv::Mat NormalizeEmbeddings(const std::vector<const cv::Mat*>& embeddings) {
+        CV_Assert(!embeddings.empty());
+        const int dim = static_cast<int>(embeddings.front()->total());
+        cv::Mat packed(static_cast<int>(embeddings.size()), dim, CV_32F);
+        for (int i = 0; i < packed.rows; i++) {
+            CV_Assert(static_cast<int>(embeddings[i]->total()) == dim);
+            cv::Mat row = packed.row(i);
+            embeddings[i]->reshape(1, 1).convertTo(row, CV_32F);
+            double norm = cv::norm(row);
+            if (norm > 0) {
+                row /= norm;
+            }
+        }
+        return packed;
     }
 
     bool file_exists(const std::string& name) {
@@ -43,40 +61,114 @@ namespace {
         return std::string(".") + separator();
     }
 
+    // FNV-1a hash, it identifies the models and the list a cache is built from
+    class Hash {
+    public:
+        void Add(const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; i++) {
+                value_ = (value_ ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+
+        template <typename T>
+        void AddValue(const T& value) {
+            Add(&value, sizeof(value));
+        }
+
+        void AddFile(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.good())
+                throw std::runtime_error("Cannot read file: " + path);
+            std::vector<char> buffer(1 << 20);
+            while (file) {
+                file.read(buffer.data(), buffer.size());
+                Add(buffer.data(), static_cast<size_t>(file.gcount()));
+            }
+        }
+
+        uint64_t value() const { return value_; }
+
+    private:
+        uint64_t value_ = 14695981039346656037ull;
+    };
+
+    void AddModelFiles(Hash& hash, const std::string& xml_path) {
+        hash.AddFile(xml_path);
+        const std::string bin_path = xml_path.substr(0, xml_path.rfind('.')) + ".bin";
+        if (file_exists(bin_path))
+            hash.AddFile(bin_path);
+    }
+
+    // The cache is the header followed by the normalized embeddings (a row per gallery embedding), the identity
+    // index of every embedding and the null-terminated labels of the identities. The embeddings start at a
+    // multiple of 64 bytes, so a mapping of the file reads them as they are
+    struct CacheHeader {
+        char magic[16];
+        uint32_t version;
+        uint32_t embedding_size;
+        uint64_t tag;
+        uint64_t num_embeddings;
+        uint64_t num_identities;
+        uint64_t labels_size;
+        char reserved[8];
+    };
+    static_assert(sizeof(CacheHeader) == 64, "The embeddings should be aligned");
+
+    const char kCacheMagic[16] = "FacesGallery\n";
+    const uint32_t kCacheVersion = 1;
+
+    // Gallery images are registered by batches of this size
+    const size_t kRegistrationBatchSize = 64;
+
 }  // namespace
 
 const char EmbeddingsGallery::unknown_label[] = "Unknown";
 const int EmbeddingsGallery::unknown_id = TrackedObject::UNKNOWN_LABEL_IDX;
 
-RegistrationStatus EmbeddingsGallery::RegisterIdentity(const std::string& identity_label,
-                                                       const cv::Mat& image,
-                                                       int min_size_fr, bool crop_gallery,
-                                                       detection::FaceDetection& detector,
-                                                       const VectorCNN& landmarks_det,
-                                                       const VectorCNN& image_reid,
-                                                       cv::Mat& embedding) {
-    cv::Mat target = image;
-    if (crop_gallery) {
-      detector.enqueue(image);
-      detector.submitRequest();
-      detector.wait();
-      detection::DetectedObjects faces = detector.fetchResults();
-      if (faces.size() == 0) {
-        return RegistrationStatus::FAILURE_NOT_DETECTED;
-      }
-      cv::Mat face_roi = image(faces[0].rect);
-      target = face_roi;
-    }
-    if ((target.rows < min_size_fr) && (target.cols < min_size_fr)) {
-      return RegistrationStatus::FAILURE_LOW_QUALITY;
-    }
-    cv::Mat landmarks;
-    landmarks_det.Compute(target, &landmarks, cv::Size(2, 5));
-    std::vector<cv::Mat> images = {target};
-    std::vector<cv::Mat> landmarks_vec = {landmarks};
-    AlignFaces(&images, &landmarks_vec);
-    image_reid.Compute(images[0], &embedding);
-    return RegistrationStatus::SUCCESS;
+std::vector<RegistrationStatus> EmbeddingsGallery::RegisterImages(const std::vector<cv::Mat>& images,
+                                                                   int min_size_fr, bool crop_gallery,
+                                                                   detection::FaceDetection& detector,
+                                                                   const VectorCNN& landmarks_det,
+                                                                   const VectorCNN& image_reid,
+                                                                   std::vector<cv::Mat>* embeddings) {
+    std::vector<RegistrationStatus> statuses(images.size(), RegistrationStatus::SUCCESS);
+    std::vector<cv::Mat> targets;
+    std::vector<size_t> target_images;
+    for (size_t i = 0; i < images.size(); i++) {
+        cv::Mat target = images[i];
+        if (crop_gallery) {
+          detector.enqueue(images[i]);
+          detector.submitRequest();
+          detector.wait();
+          detection::DetectedObjects faces = detector.fetchResults();
+          if (faces.size() == 0) {
+            statuses[i] = RegistrationStatus::FAILURE_NOT_DETECTED;
+            continue;
+          }
+          target = images[i](faces[0].rect);
+        }
+        if ((target.rows < min_size_fr) && (target.cols < min_size_fr)) {
+          statuses[i] = RegistrationStatus::FAILURE_LOW_QUALITY;
+          continue;
+        }
+        targets.push_back(target);
+        target_images.push_back(i);
+    }
+
+    embeddings->assign(images.size(), cv::Mat());
+    if (targets.empty()) {
+        return statuses;
+    }
+    // The faces of the batch go through the networks together
+    std::vector<cv::Mat> landmarks_vec, target_embeddings;
+    landmarks_det.Compute(targets, &landmarks_vec, cv::Size(2, 5));
+    AlignFaces(&targets, &landmarks_vec);
+    image_reid.Compute(targets, &target_embeddings);
+    for (size_t k = 0; k < target_images.size(); k++) {
+        (*embeddings)[target_images[k]] = target_embeddings[k];
+    }
+    return statuses;
 }
 
 EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
@@ -91,22 +183,38 @@ EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
         return;
     }
 
-    detection::FaceDetection detector(detector_config);
+    // The cache is valid while the list, the models and the registration parameters stay the same
+    Hash hash;
+    hash.AddFile(ids_list);
+    AddModelFiles(hash, landmarks_det.PathToModel());
+    AddModelFiles(hash, image_reid.PathToModel());
+    hash.AddValue(min_size_fr);
+    hash.AddValue(crop_gallery);
+    if (crop_gallery) {
+        AddModelFiles(hash, detector_config.path_to_model);
+        hash.AddValue(detector_config.confidence_threshold);
+        hash.AddValue(detector_config.increase_scale_x);
+        hash.AddValue(detector_config.increase_scale_y);
+        hash.AddValue(detector_config.input_h);
+        hash.AddValue(detector_config.input_w);
+    }
+    const std::string cache_path = ids_list + ".cache";
+    if (LoadCache(cache_path, hash.value())) {
+        return;
+    }
 
+    struct GalleryImage {
+        size_t label_idx;
+        std::string path;
+    };
+    std::vector<std::string> labels;
+    std::vector<GalleryImage> gallery_images;
     cv::FileStorage fs(ids_list, cv::FileStorage::Mode::READ);
     cv::FileNode fn = fs.root();
-    int id = 0;
     for (cv::FileNodeIterator fit = fn.begin(); fit != fn.end(); ++fit) {
         cv::FileNode item = *fit;
-        std::string label = item.name();
-        std::vector<cv::Mat> embeddings;
-
-        // Please, note that the case when there are more than one image in gallery
-        // for a person might not work properly with the current implementation
-        // of the demo.
-        // Remove this assert by your own risk.
-        CV_Assert(item.size() == 1);
-
+        labels.push_back(item.name());
+        // Every image of a person adds an embedding, a face matches the person by the most similar one
         for (size_t i = 0; i < item.size(); i++) {
             std::string path;
             if (file_exists(item[i].string())) {
@@ -114,44 +222,218 @@ EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
             } else {
                 path = folder_name(ids_list) + separator() + item[i].string();
             }
+            gallery_images.push_back(GalleryImage{labels.size() - 1, path});
+        }
+    }
 
-            cv::Mat image = cv::imread(path);
+    detection::FaceDetection detector(detector_config);
+
+    std::vector<std::vector<cv::Mat>> label_embeddings(labels.size());
+    std::vector<cv::Mat> images, embeddings;
+    for (size_t begin = 0; begin < gallery_images.size(); begin += kRegistrationBatchSize) {
+        const size_t end = std::min(begin + kRegistrationBatchSize, gallery_images.size());
+        images.clear();
+        for (size_t i = begin; i < end; i++) {
+            cv::Mat image = cv::imread(gallery_images[i].path);
             CV_Assert(!image.empty());
-            cv::Mat emb;
-            RegistrationStatus status = RegisterIdentity(label, image, min_size_fr, crop_gallery,  detector, landmarks_det, image_reid, emb);
-            if (status == RegistrationStatus::SUCCESS) {
-                embeddings.push_back(emb);
-                idx_to_id.push_back(id);
-                identities.emplace_back(embeddings, label, id);
-                ++id;
+            images.push_back(image);
+        }
+        std::vector<RegistrationStatus> statuses = RegisterImages(images, min_size_fr, crop_gallery, detector,
+                                                                  landmarks_det, image_reid, &embeddings);
+        for (size_t i = begin; i < end; i++) {
+            if (statuses[i - begin] == RegistrationStatus::SUCCESS) {
+                label_embeddings[gallery_images[i].label_idx].push_back(embeddings[i - begin]);
             }
         }
     }
+
+    int id = 0;
+    for (size_t i = 0; i < labels.size(); i++) {
+        if (!label_embeddings[i].empty()) {
+            idx_to_id.insert(idx_to_id.end(), label_embeddings[i].size(), id);
+            identities.emplace_back(label_embeddings[i], labels[i], id);
+            ++id;
+        }
+    }
+
+    std::vector<const cv::Mat*> gallery;
+    for (const auto& identity : identities) {
+        for (const auto& reference_emb : identity.embeddings) {
+            gallery.push_back(&reference_emb);
+        }
+    }
+    if (!gallery.empty()) {
+        gallery_embeddings = NormalizeEmbeddings(gallery);
+    }
+
+    try {
+        SaveCache(cache_path, hash.value());
+    } catch (const std::exception& e) {
+        slog::warn << e.what() << slog::endl;
+    }
+}
+
+bool EmbeddingsGallery::LoadCache(const std::string& path, uint64_t tag) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.good())
+        return false;
+    const uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    CacheHeader header;
+    if (file_size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, kCacheMagic, sizeof(header.magic)) != 0) {
+        slog::warn << "Not a faces gallery cache, it is rebuilt: " << path << slog::endl;
+        return false;
+    }
+    if (header.version != kCacheVersion || header.tag != tag) {
+        slog::info << "Faces gallery cache is outdated, it is rebuilt: " << path << slog::endl;
+        return false;
+    }
+    const uint64_t embeddings_size = header.num_embeddings * header.embedding_size * sizeof(float);
+    if (header.num_embeddings > std::numeric_limits<int>::max() ||
+            header.embedding_size > std::numeric_limits<int>::max() ||
+            file_size != sizeof(header) + embeddings_size + header.num_embeddings * sizeof(int32_t) +
+                         header.labels_size) {
+        slog::warn << "Broken faces gallery cache, it is rebuilt: " << path << slog::endl;
+        return false;
+    }
+
+    cv::Mat embeddings(static_cast<int>(header.num_embeddings), static_cast<int>(header.embedding_size), CV_32F);
+    std::vector<int32_t> identity_idx(header.num_embeddings);
+    std::vector<char> labels(header.labels_size);
+    file.read(reinterpret_cast<char*>(embeddings.data), embeddings_size);
+    file.read(reinterpret_cast<char*>(identity_idx.data()), identity_idx.size() * sizeof(int32_t));
+    file.read(labels.data(), labels.size());
+    if (!file || (!labels.empty() && labels.back() != '\0')) {
+        slog::warn << "Broken faces gallery cache, it is rebuilt: " << path << slog::endl;
+        return false;
+    }
+
+    std::vector<GalleryObject> cached_identities;
+    for (size_t pos = 0; pos < labels.size(); pos += std::strlen(&labels[pos]) + 1) {
+        const int id = static_cast<int>(cached_identities.size());
+        cached_identities.emplace_back(std::vector<cv::Mat>(), std::string(&labels[pos]), id);
+    }
+    std::vector<int> cached_idx_to_id;
+    for (size_t k = 0; k < identity_idx.size(); k++) {
+        // Embeddings of an identity go one after another
+        if (identity_idx[k] < 0 || static_cast<size_t>(identity_idx[k]) >= cached_identities.size() ||
+                (k > 0 && identity_idx[k] < identity_idx[k - 1])) {
+            slog::warn << "Broken faces gallery cache, it is rebuilt: " << path << slog::endl;
+            return false;
+        }
+        cached_identities[identity_idx[k]].embeddings.push_back(embeddings.row(static_cast<int>(k)));
+        cached_idx_to_id.push_back(identity_idx[k]);
+    }
+    if (cached_identities.size() != header.num_identities) {
+        slog::warn << "Broken faces gallery cache, it is rebuilt: " << path << slog::endl;
+        return false;
+    }
+
+    identities.swap(cached_identities);
+    idx_to_id.swap(cached_idx_to_id);
+    gallery_embeddings = embeddings;
+    slog::info << "Faces gallery is loaded from the cache: " << path << slog::endl;
+    return true;
+}
+
+void EmbeddingsGallery::SaveCache(const std::string& path, uint64_t tag) const {
+    std::string labels;
+    for (const auto& identity : identities) {
+        labels += identity.label;
+        labels += '\0';
+    }
+    std::vector<int32_t> identity_idx(idx_to_id.begin(), idx_to_id.end());
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kCacheMagic, sizeof(header.magic));
+    header.version = kCacheVersion;
+    header.embedding_size = static_cast<uint32_t>(gallery_embeddings.cols);
+    header.tag = tag;
+    header.num_embeddings = idx_to_id.size();
+    header.num_identities = identities.size();
+    header.labels_size = labels.size();
+
+    // Write to a temporary file and rename it, so that a broken file is never left
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!gallery_embeddings.empty()) {
+            file.write(reinterpret_cast<const char*>(gallery_embeddings.data),
+                       gallery_embeddings.total() * sizeof(float));
+        }
+        file.write(reinterpret_cast<const char*>(identity_idx.data()), identity_idx.size() * sizeof(int32_t));
+        file.write(labels.data(), labels.size());
+        if (!file.good()) {
+            std::remove(temp_path.c_str());
+            throw std::runtime_error("Cannot write faces gallery cache: " + path);
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("Cannot write faces gallery cache: " + path);
+    }
 }
 
 std::vector<int> EmbeddingsGallery::GetIDsByEmbeddings(const std::vector<cv::Mat>& embeddings) const {
     if (embeddings.empty() || idx_to_id.empty())
         return std::vector<int>(embeddings.size(), unknown_id);
 
-    cv::Mat distances(static_cast<int>(embeddings.size()), static_cast<int>(idx_to_id.size()), CV_32F);
+    std::vector<const cv::Mat*> queries;
+    for (const auto& embedding : embeddings) {
+        queries.push_back(&embedding);
+    }
+    cv::Mat embedding_similarities;
+    cv::gemm(NormalizeEmbeddings(queries), gallery_embeddings, 1.0, cv::noArray(), 0.0, embedding_similarities,
+             cv::GEMM_2_T);
+    // A face is as similar to an identity as to its most similar embedding
+    cv::Mat similarities = embedding_similarities;
+    if (identities.size() != idx_to_id.size()) {
+        similarities.create(embedding_similarities.rows, static_cast<int>(identities.size()), CV_32F);
+        similarities.setTo(-std::numeric_limits<float>::infinity());
+        for (int i = 0; i < similarities.rows; i++) {
+            const float* row = embedding_similarities.ptr<float>(i);
+            float* identity_row = similarities.ptr<float>(i);
+            for (size_t k = 0; k < idx_to_id.size(); k++) {
+                identity_row[idx_to_id[k]] = std::max(identity_row[idx_to_id[k]], row[k]);
+            }
+        }
+    }
+
+    // With n faces, every face is matched to one of its n most similar identities: the other n - 1 faces
+    // can't take all of them, and the free one is at least as good. So only these columns go to the matcher
+    const int num_candidates = std::min(similarities.rows, similarities.cols);
+    std::vector<int> candidates;
+    std::vector<int> order(similarities.cols);
+    for (int i = 0; i < similarities.rows; i++) {
+        const float* row = similarities.ptr<float>(i);
+        std::iota(order.begin(), order.end(), 0);
+        std::nth_element(order.begin(), order.begin() + (num_candidates - 1), order.end(),
+                         [row](int a, int b) { return row[a] > row[b]; });
+        candidates.insert(candidates.end(), order.begin(), order.begin() + num_candidates);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
 
+    cv::Mat distances(similarities.rows, static_cast<int>(candidates.size()), CV_32F);
     for (int i = 0; i < distances.rows; i++) {
-        int k = 0;
-        for (size_t j = 0; j < identities.size(); j++) {
-            for (const auto& reference_emb : identities[j].embeddings) {
-                distances.at<float>(i, k) = ComputeReidDistance(embeddings[i], reference_emb);
-                k++;
-            }
+        for (int k = 0; k < distances.cols; k++) {
+            distances.at<float>(i, k) = 1.0f - similarities.at<float>(i, candidates[k]);
         }
     }
     KuhnMunkres matcher(use_greedy_matcher);
     auto matched_idx = matcher.Solve(distances);
     std::vector<int> output_ids;
     for (auto col_idx : matched_idx) {
-        if (distances.at<float>(output_ids.size(), col_idx) > reid_threshold)
+        if (col_idx >= candidates.size() ||
+            distances.at<float>(static_cast<int>(output_ids.size()), static_cast<int>(col_idx)) > reid_threshold)
             output_ids.push_back(unknown_id);
         else
-            output_ids.push_back(idx_to_id[col_idx]);
+            output_ids.push_back(identities[candidates[col_idx]].id);
     }
     return output_ids;
 }
@@ -8,20 +8,30 @@
  * @example super_resolution_demo/main.cpp
  */
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <memory>
 
 #include <inference_engine.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 
 #include <samples/slog.hpp>
 #include <samples/args_helper.hpp>
 #include <samples/ocv_common.hpp>
 
+#include <pipelines/config_factory.h>
+#include <pipelines/reshaped_networks_cache.h>
+
 #include "super_resolution_demo.h"
 
 using namespace InferenceEngine;
 
+// Networks loaded for this many input sizes are kept in reshape mode
+const size_t RESHAPED_NETWORKS_CAPACITY = 4;
+
 bool ParseAndCheckCommandLine(int argc, char *argv[]) {
     // ---------------------------Parsing and validation of input args--------------------------------------
     slog::info << "Parsing input parameters" << slog::endl;
@@ -41,9 +51,234 @@ bool ParseAndCheckCommandLine(int argc, char *argv[]) {
         throw std::logic_error("Parameter -m is not set");
     }
 
+    if (FLAGS_tile && FLAGS_reshape) {
+        throw std::logic_error("Parameters -tile and -reshape can't be used together");
+    }
+
     return true;
 }
 
+/**
+* @brief Converts pixels [begin, end) of planar FP32 network output in range [0, 1] to interleaved U8 image pixels,
+*        saturating values out of the range. Binarized pixels are 255 if their value is greater than 0.5 and 0 otherwise.
+*/
+void convertOutputPixels(const float* planes, size_t planeSize, int numChannels, bool binarize,
+                         size_t begin, size_t end, uint8_t* image) {
+    size_t i = begin;
+#if CV_SIMD
+    const size_t lanes = cv::v_uint8::nlanes;
+    const size_t floatLanes = cv::v_float32::nlanes;
+    const cv::v_float32 scale = cv::vx_setall_f32(255.f);
+    const cv::v_float32 half = cv::vx_setall_f32(0.5f);
+    const cv::v_float32 zero = cv::vx_setzero_f32();
+    // Every channel of lanes pixels is converted to one U8 vector by saturating packs
+    auto convertChannel = [&](const float* plane) {
+        cv::v_int32 quarters[4];
+        for (size_t q = 0; q < 4; q++) {
+            cv::v_float32 values = cv::vx_load(plane + q * floatLanes);
+            values = binarize ? cv::v_select(values > half, scale, zero) : values * scale;
+            quarters[q] = cv::v_round(values);
+        }
+        return cv::v_pack_u(cv::v_pack(quarters[0], quarters[1]), cv::v_pack(quarters[2], quarters[3]));
+    };
+    if (numChannels == 3) {
+        for (; i + lanes <= end; i += lanes) {
+            cv::v_store_interleave(image + i * 3, convertChannel(planes + i),
+                convertChannel(planes + planeSize + i), convertChannel(planes + 2 * planeSize + i));
+        }
+    } else if (numChannels == 1) {
+        for (; i + lanes <= end; i += lanes) {
+            cv::v_store(image + i, convertChannel(planes + i));
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        for (int c = 0; c < numChannels; c++) {
+            float value = planes[c * planeSize + i];
+            value = binarize ? (value > 0.5f ? 255.f : 0.f) : value * 255.f;
+            image[i * numChannels + c] = cv::saturate_cast<uint8_t>(value);
+        }
+    }
+}
+
+/**
+* @brief Returns offsets of tiles covering the image along one dimension. Adjacent tiles share at least overlap
+*        pixels, the last tile is aligned to the end of the image.
+*/
+std::vector<int> getTileOffsets(int imageSize, int tileSize, int overlap) {
+    std::vector<int> offsets{0};
+    const int step = std::max(tileSize - overlap, 1);
+    while (offsets.back() + tileSize < imageSize) {
+        offsets.push_back(std::min(offsets.back() + step, imageSize - tileSize));
+    }
+    return offsets;
+}
+
+/**
+* @brief Returns weights of the upscaled tile pixels. They fall linearly to the tile edges over the margin,
+*        so overlapping tiles are cross-faded instead of leaving visible seams.
+*/
+cv::Mat getFeatherMask(cv::Size tileSize, int margin) {
+    auto ramp = [margin](int pos, int size) {
+        if (margin == 0) {
+            return 1.f;
+        }
+        float distance = std::min(pos + 0.5f, size - pos - 0.5f);
+        return std::min(distance / margin, 1.f);
+    };
+    cv::Mat mask(tileSize, CV_32FC1);
+    for (int y = 0; y < tileSize.height; y++) {
+        float* maskRow = mask.ptr<float>(y);
+        for (int x = 0; x < tileSize.width; x++) {
+            maskRow[x] = ramp(x, tileSize.width) * ramp(y, tileSize.height);
+        }
+    }
+    return mask;
+}
+
+/**
+* @brief Upscales the image of any size with the network of a fixed input size. The image is split into overlapping
+*        tiles which are inferred by all requests in parallel. Weighted outputs are accumulated right into the
+*        result buffer as soon as the tile is completed, so memory doesn't depend on the number of tiles.
+*/
+cv::Mat superResolveTiled(const cv::Mat& image, std::vector<InferRequest>& requests,
+                          const std::string& lrInputBlobName, const std::string& bicInputBlobName,
+                          const std::string& outputName, int overlap) {
+    const SizeVector lrDims = requests[0].GetBlob(lrInputBlobName)->getTensorDesc().getDims();
+    const SizeVector outDims = requests[0].GetBlob(outputName)->getTensorDesc().getDims();
+    const cv::Size tileSize(static_cast<int>(lrDims[3]), static_cast<int>(lrDims[2]));
+    const cv::Size outTileSize(static_cast<int>(outDims[3]), static_cast<int>(outDims[2]));
+    const int numChannels = static_cast<int>(outDims[1]);
+    const int scaleX = outTileSize.width / tileSize.width;
+    const int scaleY = outTileSize.height / tileSize.height;
+    if (scaleX * tileSize.width != outTileSize.width || scaleY * tileSize.height != outTileSize.height) {
+        throw std::logic_error("Tiled mode requires the network to upscale its input by an integer factor");
+    }
+
+    // Images smaller than a tile are padded, padding is cut off the result
+    cv::Mat paddedImage = image;
+    if (image.cols < tileSize.width || image.rows < tileSize.height) {
+        cv::copyMakeBorder(image, paddedImage, 0, std::max(tileSize.height - image.rows, 0),
+                           0, std::max(tileSize.width - image.cols, 0), cv::BORDER_REPLICATE);
+    }
+
+    std::vector<cv::Point> tiles;
+    for (int y : getTileOffsets(paddedImage.rows, tileSize.height, overlap)) {
+        for (int x : getTileOffsets(paddedImage.cols, tileSize.width, overlap)) {
+            tiles.emplace_back(x, y);
+        }
+    }
+    slog::info << "Image " << image.cols << "x" << image.rows << " is split into " << tiles.size() << " tiles" << slog::endl;
+
+    const cv::Mat featherMask = getFeatherMask(outTileSize, overlap * std::min(scaleX, scaleY));
+    cv::Mat accumulated(paddedImage.rows * scaleY, paddedImage.cols * scaleX, CV_32FC(numChannels), cv::Scalar::all(0));
+    cv::Mat weights(accumulated.size(), CV_32FC1, cv::Scalar(0));
+
+    std::mutex mtx;
+    std::condition_variable condVar;
+    std::deque<size_t> completedRequests;
+    std::vector<size_t> idleRequests;
+    std::vector<cv::Point> requestTiles(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        idleRequests.push_back(i);
+        requests[i].SetCompletionCallback([&, i] {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                completedRequests.push_back(i);
+            }
+            condVar.notify_one();
+        });
+    }
+
+    size_t nextTile = 0;
+    size_t completedTiles = 0;
+    try {
+        while (completedTiles < tiles.size()) {
+            while (nextTile < tiles.size() && !idleRequests.empty()) {
+                size_t requestId = idleRequests.back();
+                idleRequests.pop_back();
+                const cv::Mat tile = paddedImage(cv::Rect(tiles[nextTile], tileSize));
+                Blob::Ptr lrInputBlob = requests[requestId].GetBlob(lrInputBlobName);
+                matU8ToBlob<float_t>(tile, lrInputBlob);
+                if (!bicInputBlobName.empty()) {
+                    Blob::Ptr bicInputBlob = requests[requestId].GetBlob(bicInputBlobName);
+                    const SizeVector& bicDims = bicInputBlob->getTensorDesc().getDims();
+                    cv::Mat resized;
+                    cv::resize(tile, resized, cv::Size(bicDims[3], bicDims[2]), 0, 0, cv::INTER_CUBIC);
+                    matU8ToBlob<float_t>(resized, bicInputBlob);
+                }
+                requestTiles[requestId] = tiles[nextTile];
+                requests[requestId].StartAsync();
+                nextTile++;
+            }
+
+            size_t requestId;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                condVar.wait(lock, [&] { return !completedRequests.empty(); });
+                requestId = completedRequests.front();
+                completedRequests.pop_front();
+            }
+            // Throws if inference has failed
+            requests[requestId].Wait(IInferRequest::WaitMode::RESULT_READY);
+
+            LockedMemory<const void> outputMapped = as<MemoryBlob>(requests[requestId].GetBlob(outputName))->rmap();
+            const float* outputData = outputMapped.as<const float*>();
+            const size_t planeSize = static_cast<size_t>(outTileSize.area());
+            const cv::Point outOffset(requestTiles[requestId].x * scaleX, requestTiles[requestId].y * scaleY);
+            cv::parallel_for_(cv::Range(0, outTileSize.height), [&](const cv::Range& range) {
+                for (int y = range.start; y < range.end; y++) {
+                    const float* maskRow = featherMask.ptr<float>(y);
+                    float* accumulatedRow = accumulated.ptr<float>(outOffset.y + y) + outOffset.x * numChannels;
+                    float* weightsRow = weights.ptr<float>(outOffset.y + y) + outOffset.x;
+                    for (int c = 0; c < numChannels; c++) {
+                        const float* planeRow = outputData + c * planeSize + static_cast<size_t>(y) * outTileSize.width;
+                        for (int x = 0; x < outTileSize.width; x++) {
+                            accumulatedRow[x * numChannels + c] += planeRow[x] * maskRow[x];
+                        }
+                    }
+                    for (int x = 0; x < outTileSize.width; x++) {
+                        weightsRow[x] += maskRow[x];
+                    }
+                }
+            });
+            idleRequests.push_back(requestId);
+            completedTiles++;
+        }
+    }
+    catch (...) {
+        // Callbacks of requests in flight reference local variables, so they have to be completed before leaving
+        for (auto& request : requests) {
+            try {
+                request.Wait(IInferRequest::WaitMode::RESULT_READY);
+            }
+            catch (...) {}
+        }
+        throw;
+    }
+
+    // Normalizing blended pixels by the sum of their weights
+    cv::Mat resultImg(image.rows * scaleY, image.cols * scaleX, CV_8UC(numChannels));
+    cv::parallel_for_(cv::Range(0, resultImg.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* accumulatedRow = accumulated.ptr<float>(y);
+            const float* weightsRow = weights.ptr<float>(y);
+            uint8_t* resultRow = resultImg.ptr<uint8_t>(y);
+            for (int x = 0; x < resultImg.cols; x++) {
+                for (int c = 0; c < numChannels; c++) {
+                    float value = accumulatedRow[x * numChannels + c] / weightsRow[x];
+                    if (numChannels == 1) {
+                        // Post-processing for text-image-super-resolution models
+                        value = value > 0.5f ? 1.f : 0.f;
+                    }
+                    resultRow[x * numChannels + c] = cv::saturate_cast<uint8_t>(value * 255);
+                }
+            }
+        }
+    });
+    return resultImg;
+}
+
 int main(int argc, char *argv[]) {
     try {
         slog::info << "InferenceEngine: " << printable(*GetInferenceEngineVersion()) << slog::endl;
@@ -136,7 +371,7 @@ int main(int argc, char *argv[]) {
                 slog::warn << "Number of channels of the image " << i << " is not equal to " << c << ". Skip it\n";
                 continue;
             }
-            if (w != img.cols || h != img.rows) {
+            if (!FLAGS_tile && !FLAGS_reshape && (w != img.cols || h != img.rows)) {
                 slog::warn << "Size of the image " << i << " is not equal to " << w << "x" << h << ". Resize it\n";
                 cv::resize(img, img, {w, h});
             }
@@ -146,12 +381,18 @@ int main(int argc, char *argv[]) {
 
         if (inputImages.empty()) throw std::logic_error("Valid input images were not found!");
 
-        /** Setting batch size using image count **/
-        inputShapes[lrInputBlobName][0] = inputImages.size();
-        if (!bicInputBlobName.empty()) {
-            inputShapes[bicInputBlobName][0] = inputImages.size();
+        /** Setting batch size using image count. Tiles and reshaped networks take one image per request **/
+        if (!FLAGS_tile && !FLAGS_reshape) {
+            inputShapes[lrInputBlobName][0] = inputImages.size();
+            if (!bicInputBlobName.empty()) {
+                inputShapes[bicInputBlobName][0] = inputImages.size();
+            }
+            network.reshape(inputShapes);
+        } else if (network.getBatchSize() != 1) {
+            throw std::logic_error("Tiled and reshape modes require the network with batch size 1");
+        } else if (FLAGS_tile && FLAGS_tile_overlap >= std::min(lrShape[2], lrShape[3])) {
+            throw std::logic_error("Tile overlap must be less than the network input size");
         }
-        network.reshape(inputShapes);
         slog::info << "Batch size is " << std::to_string(network.getBatchSize()) << slog::endl;
 
         // ------------------------------ Prepare output blobs -------------------------------------------------
@@ -175,6 +416,107 @@ int main(int argc, char *argv[]) {
 
         // --------------------------- 4. Loading model to the device ------------------------------------------
         slog::info << "Loading model to the device" << slog::endl;
+        if (FLAGS_reshape) {
+            // Every input keeps its ratio to the low resolution input, e.g. the bicubic one is larger
+            const ICNNNetwork::InputShapes originalShapes = network.getInputShapes();
+            auto getShapes = [originalShapes, lrShape](const cv::Size& size) {
+                ICNNNetwork::InputShapes shapes = originalShapes;
+                for (auto& shape : shapes) {
+                    shape.second[2] = size.height * shape.second[2] / lrShape[2];
+                    shape.second[3] = size.width * shape.second[3] / lrShape[3];
+                }
+                return shapes;
+            };
+            ReshapedNetworksCache networks(ie, network, getShapes, FLAGS_d, {},
+                RESHAPED_NETWORKS_CAPACITY, static_cast<int>(FLAGS_reshape_step));
+            networks.prefetch(networks.getCanonicalSize(inputImages[0].size()));
+
+            slog::info << "Start inference" << slog::endl;
+            for (size_t i = 0; i < inputImages.size(); ++i) {
+                const cv::Mat& img = inputImages[i];
+                const cv::Size canonicalSize = networks.getCanonicalSize(img.size());
+                // Network for the next image is loaded while this one is inferred
+                if (i + 1 < inputImages.size()) {
+                    networks.prefetch(networks.getCanonicalSize(inputImages[i + 1].size()));
+                }
+                std::shared_ptr<ExecutableNetwork> executableNetwork = networks.get(canonicalSize);
+                InferRequest inferRequest = executableNetwork->CreateInferRequest();
+
+                cv::Mat paddedImg;
+                cv::copyMakeBorder(img, paddedImg, 0, canonicalSize.height - img.rows,
+                                   0, canonicalSize.width - img.cols, cv::BORDER_REPLICATE);
+                Blob::Ptr lrInputBlob = inferRequest.GetBlob(lrInputBlobName);
+                matU8ToBlob<float_t>(paddedImg, lrInputBlob);
+                if (!bicInputBlobName.empty()) {
+                    Blob::Ptr bicInputBlob = inferRequest.GetBlob(bicInputBlobName);
+                    const SizeVector& bicDims = bicInputBlob->getTensorDesc().getDims();
+                    cv::Mat resized;
+                    cv::resize(paddedImg, resized, cv::Size(bicDims[3], bicDims[2]), 0, 0, cv::INTER_CUBIC);
+                    matU8ToBlob<float_t>(resized, bicInputBlob);
+                }
+                inferRequest.Infer();
+
+                const Blob::Ptr outputBlob = inferRequest.GetBlob(firstOutputName);
+                LockedMemory<const void> outputBlobMapped = as<MemoryBlob>(outputBlob)->rmap();
+                const float* outputData = outputBlobMapped.as<const float*>();
+                const SizeVector& outDims = outputBlob->getTensorDesc().getDims();
+                const int numChannels = static_cast<int>(outDims[1]);
+                const int outHeight = static_cast<int>(outDims[2]);
+                const int outWidth = static_cast<int>(outDims[3]);
+                cv::Mat paddedResult(outHeight, outWidth, CV_8UC(numChannels));
+                cv::parallel_for_(cv::Range(0, outHeight), [&](const cv::Range& range) {
+                    convertOutputPixels(outputData, static_cast<size_t>(outWidth) * outHeight, numChannels,
+                        numChannels == 1, static_cast<size_t>(range.start) * outWidth,
+                        static_cast<size_t>(range.end) * outWidth, paddedResult.data);
+                });
+                // Padding is cut off
+                cv::Mat resultImg = paddedResult(cv::Rect(0, 0, img.cols * outWidth / canonicalSize.width,
+                                                          img.rows * outHeight / canonicalSize.height));
+
+                if (FLAGS_show) {
+                    cv::imshow("result", resultImg);
+                    cv::waitKey();
+                }
+
+                std::string outImgName = std::string("sr_" + std::to_string(i + 1) + ".png");
+                cv::imwrite(outImgName, resultImg);
+            }
+            slog::info << "Execution successful" << slog::endl;
+            return 0;
+        }
+        if (FLAGS_tile) {
+            // Tiles are independent, so they are inferred by several requests in parallel, each in its own stream
+            CnnConfig cnnConfig = ConfigFactory::getUserConfig(FLAGS_d, FLAGS_l, FLAGS_c, false,
+                FLAGS_nireq, FLAGS_nstreams, 0);
+            ExecutableNetwork executableNetwork = ie.LoadNetwork(network, FLAGS_d, cnnConfig.execNetworkConfig);
+
+            std::vector<InferRequest> inferRequests;
+            for (uint32_t i = 0; i < std::max(FLAGS_nireq, 1u); ++i) {
+                inferRequests.push_back(executableNetwork.CreateInferRequest());
+            }
+
+            std::cout << "To close the application, press 'CTRL+C' here";
+            if (FLAGS_show) {
+                std::cout << " or switch to the output window and press any key";
+            }
+            std::cout << std::endl;
+
+            slog::info << "Start inference" << slog::endl;
+            for (size_t i = 0; i < inputImages.size(); ++i) {
+                cv::Mat resultImg = superResolveTiled(inputImages[i], inferRequests, lrInputBlobName,
+                    bicInputBlobName, firstOutputName, static_cast<int>(FLAGS_tile_overlap));
+
+                if (FLAGS_show) {
+                    cv::imshow("result", resultImg);
+                    cv::waitKey();
+                }
+
+                std::string outImgName = std::string("sr_" + std::to_string(i + 1) + ".png");
+                cv::imwrite(outImgName, resultImg);
+            }
+            slog::info << "Execution successful" << slog::endl;
+            return 0;
+        }
         ExecutableNetwork executableNetwork = ie.LoadNetwork(network, FLAGS_d);
         // -----------------------------------------------------------------------------------------------------
 
@@ -217,7 +559,7 @@ int main(int argc, char *argv[]) {
         // --------------------------- 8. Process output -------------------------------------------------------
         const Blob::Ptr outputBlob = inferRequest.GetBlob(firstOutputName);
         LockedMemory<const void> outputBlobMapped = as<MemoryBlob>(outputBlob)->rmap();
-        const auto outputData = outputBlobMapped.as<float*>();
+        const auto outputData = outputBlobMapped.as<const float*>();
 
         size_t numOfImages = outputBlob->getTensorDesc().getDims()[0];
         size_t numOfChannels = outputBlob->getTensorDesc().getDims()[1];
@@ -227,33 +569,34 @@ int main(int argc, char *argv[]) {
 
         slog::info << "Output size [N,C,H,W]: " << numOfImages << ", " << numOfChannels << ", " << h << ", " << w << slog::endl;
 
+        // Images are converted right into the buffers being encoded. Rows of all images are converted in parallel,
+        // so a single large image is processed by all threads as well
+        std::vector<cv::Mat> resultImages;
         for (size_t i = 0; i < numOfImages; ++i) {
-            std::vector<cv::Mat> imgPlanes;
-            if (numOfChannels == 3) {
-                imgPlanes = std::vector<cv::Mat>{
-                      cv::Mat(h, w, CV_32FC1, &(outputData[i * nunOfPixels * numOfChannels])),
-                      cv::Mat(h, w, CV_32FC1, &(outputData[i * nunOfPixels * numOfChannels + nunOfPixels])),
-                      cv::Mat(h, w, CV_32FC1, &(outputData[i * nunOfPixels * numOfChannels + nunOfPixels * 2]))};
-            } else {
-                imgPlanes = std::vector<cv::Mat>{cv::Mat(h, w, CV_32FC1, &(outputData[i * nunOfPixels * numOfChannels]))};
-
-                // Post-processing for text-image-super-resolution models
-                cv::threshold(imgPlanes[0], imgPlanes[0], 0.5f, 1.0f, cv::THRESH_BINARY);
-            };
-
-            for (auto & img : imgPlanes)
-                img.convertTo(img, CV_8UC1, 255);
-
-            cv::Mat resultImg;
-            cv::merge(imgPlanes, resultImg);
+            resultImages.emplace_back(h, w, CV_8UC(numOfChannels));
+        }
+        // Post-processing for text-image-super-resolution models
+        const bool binarize = numOfChannels == 1;
+        cv::parallel_for_(cv::Range(0, static_cast<int>(numOfImages * h)), [&](const cv::Range& range) {
+            for (int row = range.start; row < range.end; row++) {
+                const size_t i = row / h;
+                const size_t y = row % h;
+                convertOutputPixels(outputData + i * nunOfPixels * numOfChannels, nunOfPixels,
+                    static_cast<int>(numOfChannels), binarize, y * w, (y + 1) * w, resultImages[i].data);
+            }
+        });
+        cv::parallel_for_(cv::Range(0, static_cast<int>(numOfImages)), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                std::string outImgName = std::string("sr_" + std::to_string(i + 1) + ".png");
+                cv::imwrite(outImgName, resultImages[i]);
+            }
+        });
 
-            if (FLAGS_show) {
+        if (FLAGS_show) {
+            for (const cv::Mat& resultImg : resultImages) {
                 cv::imshow("result", resultImg);
                 cv::waitKey();
             }
-
-            std::string outImgName = std::string("sr_" + std::to_string(i + 1) + ".png");
-            cv::imwrite(outImgName, resultImg);
         }
         // -----------------------------------------------------------------------------------------------------
     }
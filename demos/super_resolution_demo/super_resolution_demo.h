@@ -20,6 +20,21 @@ static const char custom_cpu_library_message[] = "Required for CPU custom layers
 static const char custom_cldnn_message[] = "Required for GPU custom kernels."
                                             "Absolute path to the xml file with the kernels descriptions.";
 static const char show_processed_images[] = "Optional. Show processed images. Default value is false.";
+static const char tile_message[] = "Optional. Upscale images of any size at their original resolution: "
+                                   "split them into overlapping tiles of the network input size "
+                                   "and stitch upscaled tiles together. By default images are resized to the network input size.";
+static const char tile_overlap_message[] = "Optional. Number of pixels adjacent tiles share in tiled mode. "
+                                           "Seams are blended over this margin. Default value is 16.";
+static const char reshape_message[] = "Optional. Upscale images of any size at their original resolution: reshape "
+                                      "the network to the size of every image. Sizes are rounded up to multiples of "
+                                      "-reshape_step, images are padded, and networks for several sizes are kept loaded.";
+static const char reshape_step_message[] = "Optional. Image sizes are rounded up to multiples of this value in reshape "
+                                           "mode, so close sizes share a network. Default value is 32.";
+static const char num_inf_req_message[] = "Optional. Number of infer requests processing tiles in parallel "
+                                          "in tiled mode. Default value is 4.";
+static const char num_streams_message[] = "Optional. Number of streams to use for inference on the CPU or/and GPU in "
+                                          "throughput mode (for HETERO and MULTI device cases use format "
+                                          "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
 
 
 DEFINE_bool(h, false, help_message);
@@ -29,6 +44,12 @@ DEFINE_string(d, "CPU", target_device_message);
 DEFINE_string(l, "", custom_cpu_library_message);
 DEFINE_string(c, "", custom_cldnn_message);
 DEFINE_bool(show, false, show_processed_images);
+DEFINE_bool(tile, false, tile_message);
+DEFINE_uint32(tile_overlap, 16, tile_overlap_message);
+DEFINE_bool(reshape, false, reshape_message);
+DEFINE_uint32(reshape_step, 32, reshape_step_message);
+DEFINE_uint32(nireq, 4, num_inf_req_message);
+DEFINE_string(nstreams, "", num_streams_message);
 
 /**
 * @brief This function show a help message
@@ -43,4 +64,10 @@ static void showUsage() {
     std::cout << "    -m \"<path>\"             " << model_message << std::endl;
     std::cout << "    -d \"<device>\"           " << target_device_message << std::endl;
     std::cout << "    -show                   " << show_processed_images << std::endl;
+    std::cout << "    -tile                   " << tile_message << std::endl;
+    std::cout << "    -tile_overlap           " << tile_overlap_message << std::endl;
+    std::cout << "    -reshape                " << reshape_message << std::endl;
+    std::cout << "    -reshape_step           " << reshape_step_message << std::endl;
+    std::cout << "    -nireq \"<integer>\"      " << num_inf_req_message << std::endl;
+    std::cout << "    -nstreams               " << num_streams_message << std::endl;
 }
@@ -29,13 +29,16 @@ class Demo:
         return {device: [arg for key in self.device_keys for arg in [key, device]] for device in device_list}
 
 class NativeDemo(Demo):
-    def __init__(self, subdirectory, device_keys, test_cases):
+    def __init__(self, subdirectory, device_keys, test_cases, supports_perf_report=False):
         self.subdirectory = subdirectory
 
         self.device_keys = device_keys
 
         self.test_cases = test_cases
 
+        # the demo accepts -loop, -limit, -report_perf and -nireq used by the benchmark mode
+        self.supports_perf_report = supports_perf_report
+
         self._name = subdirectory.replace('/', '_')
 
     @property
@@ -56,6 +59,8 @@ class PythonDemo(Demo):
 
         self.test_cases = test_cases
 
+        self.supports_perf_report = False
+
         self._name = subdirectory.replace('/', '_')
 
     @property
@@ -121,7 +126,7 @@ NATIVE_DEMOS = [
             **MONITORS,
             '-i': DataPatternArg('human-pose-estimation')}),
         TestCase(options={'-m': ModelArg('human-pose-estimation-0001')}),
-    )),
+    ), supports_perf_report=True),
 
     NativeDemo(subdirectory='classification_demo',
             device_keys=['-d'],
@@ -220,8 +225,16 @@ NATIVE_DEMOS = [
                 single_option_cases('-m',
                     ModelArg('yolo-v3-tf'),
                     ModelArg('yolo-v3-tiny-tf'))),
+            *combine_cases(
+                TestCase(options={'-at': 'ssd', '-m': ModelArg('person-detection-retail-0013')}),
+                [
+                    TestCase(options={'-tiles': '2x2'}),
+                    TestCase(options={'-zero_copy': None}),
+                    TestCase(options={'-motion_gate': '10'}),
+                ]),
         ],
-        )
+        ),
+        supports_perf_report=True,
     ),
 
     NativeDemo('pedestrian_tracker_demo', device_keys=['-d_det', '-d_reid'], test_cases=combine_cases(
@@ -229,14 +242,24 @@ NATIVE_DEMOS = [
             **MONITORS,
             '-i': DataPatternArg('person-detection-retail')}),
         [
-            TestCase(options={'-m_det': ModelArg('person-detection-retail-0002')}),
-            TestCase(options={'-m_det': ModelArg('person-detection-retail-0013')}),
+            *combine_cases(
+                [
+                    TestCase(options={'-m_det': ModelArg('person-detection-retail-0002')}),
+                    TestCase(options={'-m_det': ModelArg('person-detection-retail-0013')}),
+                ],
+                single_option_cases('-m_reid',
+                    ModelArg('person-reidentification-retail-0277'),
+                    ModelArg('person-reidentification-retail-0286'),
+                    ModelArg('person-reidentification-retail-0287'),
+                    ModelArg('person-reidentification-retail-0288'))),
+            *combine_cases(
+                TestCase(options={'-m_det': ModelArg('person-detection-retail-0013'),
+                    '-m_reid': ModelArg('person-reidentification-retail-0277')}),
+                [
+                    TestCase(options={'-extra_i': DataPatternArg('person-detection-retail')}),
+                    TestCase(options={'-det_interval': '3'}),
+                ]),
         ],
-        single_option_cases('-m_reid',
-            ModelArg('person-reidentification-retail-0277'),
-            ModelArg('person-reidentification-retail-0286'),
-            ModelArg('person-reidentification-retail-0287'),
-            ModelArg('person-reidentification-retail-0288')),
     )),
 
     NativeDemo(subdirectory='security_barrier_camera_demo',
@@ -246,11 +269,23 @@ NATIVE_DEMOS = [
             **MONITORS,
             '-i': DataDirectoryArg('vehicle-license-plate-detection-barrier')}),
         TestCase(options={'-m': ModelArg('vehicle-license-plate-detection-barrier-0106')}),
-        single_option_cases('-m_lpr',
-            None,
-            ModelArg('license-plate-recognition-barrier-0001'),
-            ModelArg('license-plate-recognition-barrier-0007')),
-        single_option_cases('-m_va', None, ModelArg('vehicle-attributes-recognition-barrier-0039')),
+        [
+            *combine_cases(
+                single_option_cases('-m_lpr',
+                    None,
+                    ModelArg('license-plate-recognition-barrier-0001'),
+                    ModelArg('license-plate-recognition-barrier-0007')),
+                single_option_cases('-m_va', None, ModelArg('vehicle-attributes-recognition-barrier-0039'))),
+            *combine_cases(
+                TestCase(options={
+                    '-m_lpr': ModelArg('license-plate-recognition-barrier-0001'),
+                    '-m_va': ModelArg('vehicle-attributes-recognition-barrier-0039'),
+                }),
+                [
+                    TestCase(options={'-bs': '4'}),
+                    TestCase(options={'-bs_d': '2'}),
+                ]),
+        ],
     )),
 
     NativeDemo(subdirectory='segmentation_demo', device_keys=['-d'], test_cases=combine_cases(
@@ -281,7 +316,7 @@ NATIVE_DEMOS = [
                     ModelArg('semantic-segmentation-adas-0001'),
                     ModelArg('deeplabv3'))),
         ],
-    )),
+    ), supports_perf_report=True),
 
     NativeDemo(subdirectory='smart_classroom_demo',
             device_keys=['-d_act', '-d_fd', '-d_lm', '-d_reid'],
@@ -310,6 +345,7 @@ NATIVE_DEMOS = [
                 ],
             ),
             TestCase(options={'-m_act': ModelArg('person-detection-raisinghand-recognition-0001'), '-a_top': '5'}),
+            TestCase(options={'-m_act': ModelArg('person-detection-action-recognition-0005'), '-det_interval': '3'}),
         ],
     )),
 
@@ -63,6 +63,14 @@ def parse_args():
         help='list of devices to test')
     parser.add_argument('--report-file', type=Path,
         help='path to report file')
+    parser.add_argument('--benchmark', action='store_true',
+        help='measure throughput of the demos supporting -report_perf instead of testing all demos')
+    parser.add_argument('--benchmark-frames', type=int, default=300, metavar='N',
+        help='number of frames each benchmark run processes')
+    parser.add_argument('--benchmark-nireqs', default='1,2,4', metavar='N[,N...]',
+        help='numbers of infer requests to benchmark every test case with')
+    parser.add_argument('--benchmark-report', type=Path, metavar='FILE',
+        help='path to benchmark report file, JSON if the extension is .json, CSV otherwise')
     return parser.parse_args()
 
 def collect_result(demo_name, device, pipeline, execution_time, report_file):
@@ -74,6 +82,50 @@ def collect_result(demo_name, device, pipeline, execution_time, report_file):
             testwriter.writerow(["DemoName", "Device", "ModelsInPipeline", "ExecutionTime"])
         testwriter.writerow([demo_name, device, " ".join(sorted(pipeline)), execution_time])
 
+# options of test cases replaced or dropped by the benchmark mode, the monitors would skew the measurements
+BENCHMARK_DROPPED_OPTIONS = {'-no_show', '--no_show', '-nireq', '-loop', '-limit', '-report_perf', '-u'}
+
+BENCHMARK_STAGES = ['decode', 'capture_wait', 'preprocess', 'queue_wait', 'infer', 'postprocess', 'render',
+    'end_to_end']
+
+def benchmark_args(case_options, nireq, frames):
+    return [('-no_show', None), ('-loop', None), ('-limit', str(frames)), ('-report_perf', 'json'),
+        ('-nireq', str(nireq)),
+        *((key, value) for key, value in sorted(case_options.items()) if key not in BENCHMARK_DROPPED_OPTIONS)]
+
+def parse_perf_report(output):
+    for line in output.splitlines():
+        if line.startswith('{"perf_report"'):
+            return json.loads(line)['perf_report']
+    return None
+
+def make_benchmark_row(demo_name, device, nireq, pipeline, report):
+    row = collections.OrderedDict([
+        ('demo', demo_name),
+        ('device', device),
+        ('nireq', nireq),
+        ('models', ' '.join(sorted(pipeline))),
+        ('frames', report['frames']),
+        ('fps', report['fps']),
+        ('latency_ms', report['latency_ms']),
+    ])
+    for stage in BENCHMARK_STAGES:
+        stage_stats = report['stages'].get(stage, {})
+        row[stage + '_mean_ms'] = stage_stats.get('mean_ms', '')
+        row[stage + '_p99_ms'] = stage_stats.get('p99_ms', '')
+    return row
+
+def write_benchmark_report(rows, report_file):
+    if report_file.suffix == '.json':
+        report_file.write_text(json.dumps(rows, indent=2))
+        return
+    with report_file.open('w', newline='') as csvfile:
+        writer = csv.writer(csvfile)
+        if rows:
+            writer.writerow(rows[0].keys())
+        for row in rows:
+            writer.writerow(row.values())
+
 @contextlib.contextmanager
 def temp_dir_as_path():
     with tempfile.TemporaryDirectory() as temp_dir:
@@ -148,6 +200,11 @@ def main():
     else:
         demos_to_test = DEMOS
 
+    if args.benchmark:
+        demos_to_test = [demo for demo in demos_to_test if demo.supports_perf_report]
+        benchmark_nireqs = [int(nireq) for nireq in args.benchmark_nireqs.split(',')]
+        benchmark_rows = []
+
     with temp_dir_as_path() as global_temp_dir:
         dl_dir = prepare_models(auto_tools_dir, args.downloader_cache_dir, args.mo, global_temp_dir, demos_to_test)
 
@@ -207,6 +264,35 @@ def main():
                         num_failures += 1
                         continue
 
+                    if args.benchmark:
+                        for (device, dev_arg), nireq in itertools.product(device_args.items(), benchmark_nireqs):
+                            bench_args = [demo_arg
+                                for key, value in benchmark_args(test_case.options, nireq, args.benchmark_frames)
+                                for demo_arg in option_to_args(key, value)]
+                            print('Benchmark case #{}/{}/nireq {}:'.format(test_case_index, device, nireq),
+                                ' '.join(shlex.quote(str(arg)) for arg in dev_arg + bench_args))
+                            print(flush=True)
+                            try:
+                                output = subprocess.check_output(fixed_args + dev_arg + bench_args,
+                                    stderr=subprocess.STDOUT, universal_newlines=True, encoding='utf-8')
+                            except subprocess.CalledProcessError as e:
+                                print(e.output)
+                                print('Exit code:', e.returncode)
+                                num_failures += 1
+                                continue
+
+                            report = parse_perf_report(output)
+                            if report is None:
+                                print(output)
+                                print('No performance report in the output')
+                                num_failures += 1
+                                continue
+                            print('FPS: {:.1f}, latency: {:.1f} ms'.format(report['fps'], report['latency_ms']))
+                            print()
+                            benchmark_rows.append(make_benchmark_row(
+                                demo.full_name, device, nireq, case_model_names, report))
+                        continue
+
                     for device, dev_arg in device_args.items():
                         print('Test case #{}/{}:'.format(test_case_index, device),
                             ' '.join(shlex.quote(str(arg)) for arg in dev_arg + case_args))
@@ -227,6 +313,9 @@ def main():
 
             print()
 
+    if args.benchmark and args.benchmark_report:
+        write_benchmark_report(benchmark_rows, args.benchmark_report)
+
     print("Failures: {}".format(num_failures))
 
     sys.exit(0 if num_failures == 0 else 1)
@@ -46,6 +46,14 @@ static const char input_data_type_message[] = "Required. Input data type: \"imag
                                               "\"webcam\" (for a webcamera device). By default, it is \"image\".";
 static const char utilization_monitors_message[] = "Optional. List of monitors to show initially.";
 static const char decoder_bandwidth_message[] = "Optional. Bandwidth for CTC beam search decoder. Default value is 0, in this case CTC greedy decoder will be used.";
+static const char num_inf_req_message[] = "Optional. Number of infer requests of every model.";
+static const char num_streams_message[] = "Optional. Number of streams to use for inference on the CPU or/and GPU in "
+                                          "throughput mode (for HETERO and MULTI device cases use format "
+                                          "<device1>:<nstreams1>,<device2>:<nstreams2> or just <nstreams>)";
+static const char num_threads_message[] = "Optional. Number of threads.";
+static const char postprocess_threads_message[] = "Optional. Number of threads postprocessing inference results of every model "
+                                                  "in parallel with inference. 0 postprocesses them in the main thread.";
+static const char text_recognition_batch_size_message[] = "Optional. Batch size for the Text Recognition model. The detected boxes are recognized in batches of this size. Default value is 1.";
 
 DEFINE_bool(h, false, help_message);
 DEFINE_string(m_td, "", text_detection_model_message);
@@ -66,6 +74,11 @@ DEFINE_bool(no_show, false, no_show_message);
 DEFINE_bool(r, false, raw_output_message);
 DEFINE_string(u, "", utilization_monitors_message);
 DEFINE_uint32(b, 0, decoder_bandwidth_message);
+DEFINE_uint32(bs_tr, 1, text_recognition_batch_size_message);
+DEFINE_uint32(nireq, 2, num_inf_req_message);
+DEFINE_string(nstreams, "", num_streams_message);
+DEFINE_uint32(nthreads, 0, num_threads_message);
+DEFINE_uint32(postprocess_threads, 1, postprocess_threads_message);
 
 /**
 * @brief This function shows a help message
@@ -96,4 +109,9 @@ static void showUsage() {
     std::cout << "    -r                           " << raw_output_message << std::endl;
     std::cout << "    -u                           " << utilization_monitors_message << std::endl;
     std::cout << "    -b                           " << decoder_bandwidth_message << std::endl;
+    std::cout << "    -bs_tr                       " << text_recognition_batch_size_message << std::endl;
+    std::cout << "    -nireq \"<integer>\"           " << num_inf_req_message << std::endl;
+    std::cout << "    -nstreams                    " << num_streams_message << std::endl;
+    std::cout << "    -nthreads \"<integer>\"        " << num_threads_message << std::endl;
+    std::cout << "    -postprocess_threads \"<integer>\" " << postprocess_threads_message << std::endl;
 }